@@ -32,12 +32,12 @@
 #endif
 
 
-AttrIndexBuilder_c::AttrIndexBuilder_c ( const CSphSchema & tSchema )
+AttrIndexBuilder_c::AttrIndexBuilder_c ( const ISphSchema & tSchema )
 {
 	Init ( tSchema );
 }
 
-void AttrIndexBuilder_c::Init ( const CSphSchema& tSchema )
+void AttrIndexBuilder_c::Init ( const ISphSchema & tSchema )
 {
 	m_uStride = tSchema.GetRowSize();
 	for ( int i = 0; i < tSchema.GetAttrsCount(); ++i )
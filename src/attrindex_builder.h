@@ -15,7 +15,7 @@
 #include "sphinxstd.h"
 #include "sphinxdefs.h"
 
-class CSphSchema;
+class ISphSchema;
 struct CSphAttrLocator;
 
 // FIXME!!! for over INT_MAX attributes
@@ -23,10 +23,10 @@ struct CSphAttrLocator;
 class AttrIndexBuilder_c : ISphNoncopyable
 {
 public:
-	explicit	AttrIndexBuilder_c ( const CSphSchema & tSchema );
+	explicit	AttrIndexBuilder_c ( const ISphSchema & tSchema );
 				AttrIndexBuilder_c() = default;
 
-	void		Init ( const CSphSchema & tSchema );
+	void		Init ( const ISphSchema & tSchema );
 	void		Collect ( const CSphRowitem * pRow );
 	void		FinishCollect();
 	const CSphTightVector<CSphRowitem> & GetCollected() const;
@@ -83,8 +83,11 @@ public:
 	bool			Write ( bool bRemoveUnsuccessful = true );
 	bool			WriteAndFsync();
 	bool			Fsync ( int iFD = -1 );
+	void			SetSynced ( int64_t iFilePos );	///< data up to iFilePos of the current file was synced by someone else
 
 	int64_t			GetFilePos() const noexcept			{ return m_iLastFilePos; }
+	int64_t			GetTotalWritten() const noexcept	{ return m_iTotalWritten; }
+	int64_t			GetFileGen() const noexcept			{ return m_iFileGen; }
 
 	bool			OpenFile ( const CSphString & sFile, CSphString & sError );
 	void			CloseFile();
@@ -113,6 +116,8 @@ private:
 	CSphString		m_sError;
 
 	int64_t			m_iLastFilePos = 0;
+	int64_t			m_iTotalWritten = 0;	///< bytes written through this writer across all files; never rewinds
+	int64_t			m_iFileGen = 0;			///< bumped on every opened file, so that a sync of the previous one is not mistaken for it
 	std::atomic<int64_t> m_iLastFsyncPos { 0 };
 	int				m_iLastTransactionStartPos = 0;
 };
@@ -155,6 +160,16 @@ enum class BinlogFileState_e
 using BinlogMutex_t = Threads::Coro::Mutex_c;
 using ScopedBinlogMutex_t = Threads::ScopedCoroMutex_t;
 
+/// state of group commit: which part of the written stream is already durable, and whether somebody syncs right now
+struct GroupSync_t
+{
+	int64_t	m_iSynced = 0;		///< total written bytes covered by completed fsync
+	int64_t	m_iFailed = 0;		///< total written bytes covered by failed fsync
+	int64_t	m_iFailedGen = -1;	///< log file generation where fsync failed; later fsyncs of that file don't make anything durable
+	int64_t	m_iSyncedTxns = 0;	///< committed txns covered by completed (or failed) fsync
+	bool	m_bRunning = false;	///< fsync is in progress (performed by the group leader)
+};
+
 class SingleBinlog_c final : public ISphRefcountedMT
 {
 	Binlog_c * m_pOwner;
@@ -164,6 +179,8 @@ class SingleBinlog_c final : public ISphRefcountedMT
 	mutable Threads::Coro::RWLock_c m_tLogFilesAccess;
 	CSphVector<BinlogFileDesc_t> m_dLogFiles GUARDED_BY ( m_tLogFilesAccess ); // active log files
 	Threads::Coro::Waitable_T<int> m_tFlushRunning { 0 };
+	Threads::Coro::Waitable_T<GroupSync_t> m_tGroupSync;
+	int64_t m_iCommittedTxns GUARDED_BY ( m_tWriteAccess ) = 0;
 
 	~SingleBinlog_c () final;
 public:
@@ -193,6 +210,8 @@ private:
 	void DoCacheWrite () EXCLUDES ( m_tLogFilesAccess ) REQUIRES ( m_tWriteAccess );
 	void CheckDoRestart () REQUIRES ( m_tWriteAccess );
 	bool CheckDoFlush () REQUIRES ( m_tWriteAccess );
+	bool WaitGroupSync ( int64_t iWritten, CSphString & sError ) EXCLUDES ( m_tWriteAccess );
+	void SyncBeforeRestart () REQUIRES ( m_tWriteAccess );
 	void SaveMeta () EXCLUDES ( m_tLogFilesAccess ) ;
 	void FixNofFiles ( int iFiles ) const;
 };
@@ -215,6 +234,8 @@ public:
 	bool	IsActive () const { return !m_bDisabled; }
 	bool 	MockDisabled ( bool bNewVal );
 	void	CheckAndSetPath ( CSphString sBinlogPath );
+	void	ReleaseLock ();
+	bool	RetakeLock ( CSphString & sError );
 
 	bool	IsFlushingEnabled() const;
 	void	DoFlush (); // invoked by task binlog flush, every BINLOG_AUTO_FLUSH (1 sec)
@@ -223,11 +244,19 @@ public:
 	inline CSphString GetLogPath() const noexcept { return m_sLogPath; }
 	int64_t LastTidFor ( const CSphString & sIndex ) const noexcept EXCLUDES ( m_tHashAccess );
 
+	FsyncStats_t GetFsyncStats() const noexcept;
+
 private:
 	std::atomic<int64_t>	m_iLastFlushed {0};
 	int64_t					m_iFlushPeriod = BINLOG_AUTO_FLUSH;
 
 	FlushAction_e			m_eFlushFlavour = FlushAction_e::ACTION_NONE;
+	bool					m_bGroupCommit = false;	// with ACTION_FSYNC, concurrent commits share one fsync; searchd.binlog_group_commit
+
+	std::atomic<int64_t>	m_iFsyncs {0};
+	std::atomic<int64_t>	m_iFsyncTxns {0};
+	std::atomic<int64_t>	m_iFsyncTimeUs {0};
+	std::atomic<int64_t>	m_iFsyncMaxTimeUs {0};
 
 	mutable Threads::Coro::RWLock_c m_tHashAccess;
 	SmallStringHash_T<SingleBinlogPtr> m_hBinlogs GUARDED_BY ( m_tHashAccess );
@@ -289,6 +318,8 @@ private:
 
 	int NextBinlogExt();
 	void FixNofFiles ( int iFiles );
+	void AccountFsync ( int64_t iTxns, int64_t iTimeUs ) noexcept;
+	bool IsGroupCommit() const noexcept { return m_bGroupCommit && m_eFlushFlavour==FlushAction_e::ACTION_FSYNC; }
 };
 
 std::unique_ptr<Binlog_c>		g_pRtBinlog;
@@ -387,6 +418,7 @@ bool BinlogWriter_c::Write ( bool bRemoveUnsuccessful )
 	}
 
 	m_iLastFilePos += m_dBuf.GetLength ();
+	m_iTotalWritten += m_dBuf.GetLength ();
 	m_iLastTransactionStartPos = 0;
 	m_dBuf.Resize(0);
 	return true;
@@ -415,23 +447,38 @@ int fsync ( int iFD )
 }
 #endif
 
+static FnFsync g_fnMockFsync;
+
+static bool BinlogFsync ( int iFD )
+{
+	if ( g_fnMockFsync )
+		return g_fnMockFsync ( iFD );
+
+	return fsync ( iFD )==0;
+}
+
 
 bool BinlogWriter_c::Fsync (int iFD)
 {
 	if ( iFD==-1 )
 		iFD = m_tFile.GetFD ();
 
-	if ( fsync ( iFD )!=0 )
+	if ( !BinlogFsync ( iFD ) )
 	{
 		m_sError.SetSprintf ( "failed to sync %s: %s", m_tFile.GetFilename (), strerrorm ( errno ) );
 		return false;
 	}
 
-	if ( m_iLastFsyncPos<m_iLastFilePos )
-		m_iLastFsyncPos.store ( m_iLastFilePos, std::memory_order_relaxed );
+	SetSynced ( m_iLastFilePos );
 	return true;
 }
 
+void BinlogWriter_c::SetSynced ( int64_t iFilePos )
+{
+	if ( m_iLastFsyncPos<iFilePos )
+		m_iLastFsyncPos.store ( iFilePos, std::memory_order_relaxed );
+}
+
 bool BinlogWriter_c::WriteAndFsync()
 {
 	if ( HasUnwrittenData() && !Write() )
@@ -447,6 +494,7 @@ bool BinlogWriter_c::WriteAndFsync()
 bool BinlogWriter_c::OpenFile ( const CSphString & sFile, CSphString & sError )
 {
 	m_iLastFilePos = 0;
+	++m_iFileGen;
 	return m_tFile.Open ( sFile, SPH_O_NEW, sError )>=0;
 }
 
@@ -612,33 +660,178 @@ void SingleBinlog_c::CollectBinlogFiles ( CSphVector<int> & tOutput ) const noex
 bool SingleBinlog_c::BinlogCommit ( int64_t * pTID, const char * szIndexName, FnWriteCommit fnSaver, CSphString & sError )
 {
 	MEMORY ( MEM_BINLOG );
-	ScopedBinlogMutex_t tLock ( m_tWriteAccess );
+	bool bGroupCommit = m_pOwner->IsGroupCommit();
+	int64_t iWritten = 0;
+	{
+		ScopedBinlogMutex_t tLock ( m_tWriteAccess );
 
-	int64_t iTID = ++( *pTID );
-	const int uIndex = GetWriteIndexID ( szIndexName, iTID );
+		// don't append to a file with failed fsync; the txn wouldn't become durable there
+		CheckDoRestart ();
 
-	{
-		BinlogTransactionGuard_c tGuard ( m_tWriter, m_pOwner->m_eFlushFlavour==FlushAction_e::ACTION_NONE );
+		int64_t iTID = ++( *pTID );
+		const int uIndex = GetWriteIndexID ( szIndexName, iTID );
 
-		// header
-		m_tWriter.PutByte ( Blop_e::ADD_TXN );
-		m_tWriter.ZipOffset ( uIndex );
-		m_tWriter.ZipOffset ( iTID );
-		TransactionSizeGuard_c tPutSize ( m_tWriter );
+		{
+			BinlogTransactionGuard_c tGuard ( m_tWriter, m_pOwner->m_eFlushFlavour==FlushAction_e::ACTION_NONE );
+
+			// header
+			m_tWriter.PutByte ( Blop_e::ADD_TXN );
+			m_tWriter.ZipOffset ( uIndex );
+			m_tWriter.ZipOffset ( iTID );
+			TransactionSizeGuard_c tPutSize ( m_tWriter );
+
+			// save txn data
+			fnSaver ( m_tWriter );
+		}
 
-		// save txn data
-		fnSaver ( m_tWriter );
+		// finalize
+		if ( !CheckDoFlush () )
+		{
+			sError.SetSprintf ( "unable to write to binlog: %s", m_tWriter.GetError ().cstr () );
+			return false;
+		}
+
+		++m_iCommittedTxns;
+		iWritten = m_tWriter.GetTotalWritten();
+		CheckDoRestart ();
 	}
 
-	// finalize
-	if ( !CheckDoFlush () )
+	// with group commit the txn is written, but not yet synced; wait until some fsync covers it
+	if ( bGroupCommit )
+		return WaitGroupSync ( iWritten, sError );
+
+	return true;
+}
+
+
+// after a failed fsync the kernel may have dropped dirty pages of the file, so whatever was written to it up to iUpTo
+// is not durable, even if a later fsync of the same file succeeds. Such a file is rotated by the next commit
+static void MarkSyncFailed ( GroupSync_t & tSync, int64_t iUpTo, int64_t iTxns, int64_t iFileGen )
+{
+	tSync.m_iFailed = Max ( tSync.m_iFailed, iUpTo );
+	tSync.m_iFailedGen = iFileGen;
+	tSync.m_iSyncedTxns = Max ( tSync.m_iSyncedTxns, iTxns );
+}
+
+
+// group commit: the first committer which finds no fsync running becomes the leader and syncs everything written so far.
+// Others commits arriving meanwhile wait, and are covered by the next leader's fsync together.
+bool SingleBinlog_c::WaitGroupSync ( int64_t iWritten, CSphString & sError ) NO_THREAD_SAFETY_ANALYSIS
+{
+	while ( true )
 	{
-		sError.SetSprintf ( "unable to write to binlog: %s", m_tWriter.GetError ().cstr () );
-		return false;
+		bool bDone = false;
+		bool bFailed = false;
+		bool bLeader = false;
+		m_tGroupSync.ModifyValue ( [iWritten, &bDone, &bFailed, &bLeader] ( GroupSync_t & tSync ) {
+			if ( tSync.m_iFailed>=iWritten )
+				bFailed = true;
+			else if ( tSync.m_iSynced>=iWritten )
+				bDone = true;
+			else if ( !tSync.m_bRunning )
+				bLeader = tSync.m_bRunning = true;
+		} );
+
+		if ( bDone )
+			return true;
+
+		if ( bFailed )
+		{
+			sError = "unable to sync binlog (group commit)";
+			return false;
+		}
+
+		if ( !bLeader )
+		{
+			m_tGroupSync.Wait ( [iWritten] ( const GroupSync_t & tSync ) { return !tSync.m_bRunning || tSync.m_iSynced>=iWritten || tSync.m_iFailed>=iWritten; } );
+			continue;
+		}
+
+		// we're the leader. Catch everything written so far, and sync it out of the write lock
+		int iFD;
+		int64_t iUpTo;
+		int64_t iFilePos;
+		int64_t iFileGen;
+		int64_t iTxns;
+		{
+			ScopedBinlogMutex_t tLock ( m_tWriteAccess );
+			iFD = m_tWriter.GetFD();
+			iUpTo = m_tWriter.GetTotalWritten();
+			iFilePos = m_tWriter.GetFilePos();
+			iFileGen = m_tWriter.GetFileGen();
+			iTxns = m_iCommittedTxns;
+			if ( iFD!=-1 ) // keep the fd opened, even if restart happens meanwhile
+				m_tFlushRunning.ModifyValue ( [] ( int & iVal ) { ++iVal; } );
+		}
+
+		// fd==-1 means that log was abandoned (all its tables are flushed), and so nothing to sync
+		bool bOk = true;
+		int64_t tmStart = sphMicroTimer();
+		if ( iFD!=-1 )
+		{
+			bOk = BinlogFsync ( iFD );
+			if ( !bOk )
+				sphWarning ( "binlog: group commit failed to sync: %d (%s)", errno, strerrorm ( errno ) );
+			m_tFlushRunning.ModifyValueAndNotifyAll ( [] ( int & iVal ) { --iVal; } );
+		}
+		int64_t tmSync = sphMicroTimer() - tmStart;
+
+		// as Fsync() does, so that periodic flush doesn't sync it again. Unless the log was rotated meanwhile,
+		// then the old file was synced on restart, and the position belongs to another one
+		if ( bOk && iFD!=-1 )
+		{
+			ScopedBinlogMutex_t tLock ( m_tWriteAccess );
+			if ( m_tWriter.GetFileGen()==iFileGen )
+				m_tWriter.SetSynced ( iFilePos );
+		}
+
+		// stats are accounted before followers wake up, so that a returned commit is always counted as synced
+		auto * pOwner = m_pOwner;
+		bool bAccount = bOk && iFD!=-1;
+		m_tGroupSync.ModifyValueAndNotifyAll ( [pOwner, bOk, bAccount, iUpTo, iTxns, iFileGen, tmSync] ( GroupSync_t & tSync ) {
+			tSync.m_bRunning = false;
+			if ( !bOk || tSync.m_iFailedGen==iFileGen )
+			{
+				MarkSyncFailed ( tSync, iUpTo, iTxns, iFileGen );
+				return;
+			}
+			tSync.m_iSynced = Max ( tSync.m_iSynced, iUpTo );
+			if ( bAccount )
+				pOwner->AccountFsync ( Max ( iTxns - tSync.m_iSyncedTxns, 0 ), tmSync );
+			tSync.m_iSyncedTxns = Max ( tSync.m_iSyncedTxns, iTxns );
+		} );
 	}
+}
 
-	CheckDoRestart ();
-	return true;
+
+// group commit: binlog file is about to be rotated, and the next leader will sync only the new one.
+// So, finish the old one right here and mark everything written so far as durable.
+void SingleBinlog_c::SyncBeforeRestart ()
+{
+	if ( !m_pOwner->IsGroupCommit() )
+		return;
+
+	int64_t tmStart = sphMicroTimer();
+	bool bOk = m_tWriter.WriteAndFsync();
+	int64_t tmSync = sphMicroTimer() - tmStart;
+
+	int64_t iUpTo = m_tWriter.GetTotalWritten();
+	int64_t iTxns = m_iCommittedTxns;
+	int64_t iFileGen = m_tWriter.GetFileGen();
+	auto * pOwner = m_pOwner;
+	m_tGroupSync.ModifyValueAndNotifyAll ( [pOwner, bOk, iUpTo, iTxns, iFileGen, tmSync] ( GroupSync_t & tSync ) {
+		if ( !bOk || tSync.m_iFailedGen==iFileGen )
+		{
+			MarkSyncFailed ( tSync, iUpTo, iTxns, iFileGen );
+			return;
+		}
+		tSync.m_iSynced = Max ( tSync.m_iSynced, iUpTo );
+		pOwner->AccountFsync ( Max ( iTxns - tSync.m_iSyncedTxns, 0 ), tmSync );
+		tSync.m_iSyncedTxns = Max ( tSync.m_iSyncedTxns, iTxns );
+	} );
+
+	if ( !bOk )
+		sphWarning ( "binlog: %s", m_tWriter.GetError().cstr() );
 }
 
 
@@ -909,8 +1102,9 @@ void SingleBinlog_c::DoCacheWrite ()
 
 void SingleBinlog_c::CheckDoRestart ()
 {
-	// restart on exceed file size limit
-	if ( !m_pOwner->m_iRestartSize || m_tWriter.GetFilePos ()<=m_pOwner->m_iRestartSize )
+	// restart on exceed file size limit, or if group fsync of the file failed
+	bool bSyncFailed = m_pOwner->IsGroupCommit() && m_tWriter.IsOpen() && m_tGroupSync.GetValue().m_iFailedGen==m_tWriter.GetFileGen();
+	if ( !bSyncFailed && ( !m_pOwner->m_iRestartSize || m_tWriter.GetFilePos ()<=m_pOwner->m_iRestartSize ) )
 		return;
 
 	MEMORY ( MEM_BINLOG );
@@ -919,6 +1113,7 @@ void SingleBinlog_c::CheckDoRestart ()
 	assert ( !m_dLogFiles.IsEmpty () ); }
 #endif
 	DoCacheWrite ();
+	SyncBeforeRestart ();
 
 	auto sName = m_tWriter.GetFilename();
 	int iFD = m_tWriter.LeakFD();
@@ -948,8 +1143,15 @@ bool SingleBinlog_c::CheckDoFlush ()
 		break;
 
 	case FlushAction_e::ACTION_FSYNC:
-		if ( !m_tWriter.WriteAndFsync () )
-			return false;
+		if ( m_pOwner->m_bGroupCommit ) // sync will be performed by the group leader out of the lock
+			return m_tWriter.Write ();
+		else
+		{
+			int64_t tmStart = sphMicroTimer();
+			if ( !m_tWriter.WriteAndFsync () )
+				return false;
+			m_pOwner->AccountFsync ( 1, sphMicroTimer() - tmStart );
+		}
 		break;
 
 	default:
@@ -1142,6 +1344,29 @@ int Binlog_c::NextBinlogExt ()
 }
 
 
+void Binlog_c::AccountFsync ( int64_t iTxns, int64_t iTimeUs ) noexcept
+{
+	m_iFsyncs.fetch_add ( 1, std::memory_order_relaxed );
+	m_iFsyncTxns.fetch_add ( iTxns, std::memory_order_relaxed );
+	m_iFsyncTimeUs.fetch_add ( iTimeUs, std::memory_order_relaxed );
+
+	auto iMax = m_iFsyncMaxTimeUs.load ( std::memory_order_relaxed );
+	while ( iMax<iTimeUs && !m_iFsyncMaxTimeUs.compare_exchange_weak ( iMax, iTimeUs, std::memory_order_relaxed ) );
+}
+
+
+FsyncStats_t Binlog_c::GetFsyncStats() const noexcept
+{
+	FsyncStats_t tStats;
+	tStats.m_bGroupCommit = IsGroupCommit();
+	tStats.m_iFsyncs = m_iFsyncs.load ( std::memory_order_relaxed );
+	tStats.m_iTxns = m_iFsyncTxns.load ( std::memory_order_relaxed );
+	tStats.m_iTimeUs = m_iFsyncTimeUs.load ( std::memory_order_relaxed );
+	tStats.m_iMaxTimeUs = m_iFsyncMaxTimeUs.load ( std::memory_order_relaxed );
+	return tStats;
+}
+
+
 void Binlog_c::FixNofFiles ( int iFiles )
 {
 	m_iNumFiles.fetch_sub ( iFiles );
@@ -1180,6 +1405,10 @@ void Binlog_c::Configure ( const CSphConfigSection & hSearchd, DWORD uReplayFlag
 		default:	sphDie ( "unknown binlog flush mode %d (must be 0, 1, 2, or 3)\n", iMode );
 	}
 
+	m_bGroupCommit = hSearchd.GetBool ( "binlog_group_commit", false );
+	if ( m_bGroupCommit && m_eFlushFlavour!=FlushAction_e::ACTION_FSYNC )
+		sphWarning ( "binlog_group_commit has effect only with binlog_flush=1; ignored" );
+
 	m_iRestartSize = hSearchd.GetSize ( "binlog_max_log_size", m_iRestartSize );
 	m_uReplayFlags = uReplayFlags;
 	m_iBinlogFileDigits = hSearchd.GetInt ( "binlog_filename_digits", 4 );
@@ -1382,6 +1611,20 @@ void Binlog_c::UnlockBinlog ()
 	RawFileUnLock ( SphSprintf ( "%s/binlog.lock", m_sLogPath.cstr () ), m_iLockFD );
 }
 
+void Binlog_c::ReleaseLock ()
+{
+	if ( !m_bDisabled )
+		UnlockBinlog ();
+}
+
+bool Binlog_c::RetakeLock ( CSphString & sError )
+{
+	if ( m_bDisabled || m_iLockFD>=0 )
+		return true;
+
+	return RawFileLock ( SphSprintf ( "%s/binlog.lock", m_sLogPath.cstr () ), m_iLockFD, sError );
+}
+
 
 bool Binlog_c::IsBinlogWritable () const noexcept
 {
@@ -1991,6 +2234,19 @@ void Binlog::NotifyIndexFlush ( int64_t iTID, const char * szIndexName, Shutdown
 	g_pRtBinlog->NotifyIndexFlush ( iTID, szIndexName, eShutdown, eAction );
 }
 
+void Binlog::ReleaseLock()
+{
+	if ( g_pRtBinlog )
+		g_pRtBinlog->ReleaseLock();
+}
+
+bool Binlog::RetakeLock ( CSphString & sError )
+{
+	if ( !g_pRtBinlog )
+		return true;
+	return g_pRtBinlog->RetakeLock ( sError );
+}
+
 CSphString Binlog::GetPath()
 {
 	if ( g_pRtBinlog )
@@ -2005,6 +2261,18 @@ int64_t Binlog::LastTidFor ( const CSphString & sIndex )
 	return g_pRtBinlog->LastTidFor ( sIndex );
 }
 
+FsyncStats_t Binlog::GetFsyncStats()
+{
+	if ( !g_pRtBinlog )
+		return {};
+	return g_pRtBinlog->GetFsyncStats();
+}
+
+FnFsync Binlog::MockFsync ( FnFsync fnFsync )
+{
+	return std::exchange ( g_fnMockFsync, std::move ( fnFsync ) );
+}
+
 
 bool Binlog::IsFlushEnabled ()
 {
@@ -36,6 +36,17 @@ namespace Binlog {
 	};
 
 	using FnWriteCommit = std::function<void (Writer_i&)>;
+	using FnFsync = std::function<bool ( int iFD )>;
+
+	/// counters of binlog fsyncs made for binlog_flush=1 (shown in 'show status')
+	struct FsyncStats_t
+	{
+		bool	m_bGroupCommit = false;
+		int64_t	m_iFsyncs = 0;		///< how many fsyncs were performed
+		int64_t	m_iTxns = 0;		///< how many txns were made durable by them
+		int64_t	m_iTimeUs = 0;		///< total time spent in fsync
+		int64_t	m_iMaxTimeUs = 0;	///< the longest fsync
+	};
 
 	template < typename T >
 	static void SaveVector ( Writer_i & tWriter, const VecTraits_T<T> &tVector )
@@ -78,5 +89,14 @@ namespace Binlog {
 
 	CSphString GetPath();
 
+	/// hot restart: let another instance lock the binlog path while it loads, and take the lock back if it didn't take over
+	void ReleaseLock();
+	bool RetakeLock ( CSphString & sError );
+
 	int64_t LastTidFor ( const CSphString & sIndex );
+
+	FsyncStats_t GetFsyncStats();
+
+	/// replace fsync() of binlog files (for tests); returns the previous one. Empty restores the real fsync
+	FnFsync MockFsync ( FnFsync fnFsync );
 }
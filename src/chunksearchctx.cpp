@@ -49,6 +49,7 @@ void DiskChunkSearcherCtx_t::MergeChild ( DiskChunkSearcherCtx_t tChild ) const
 
 	m_tMeta.m_bTotalMatchesApprox |= tChildRes.m_bTotalMatchesApprox;
 	m_tMeta.m_tIteratorStats.Merge ( tChildRes.m_tIteratorStats );
+	m_tMeta.m_tIOStats.Add ( tChildRes.m_tIOStats );
 }
 
 
@@ -423,14 +423,62 @@ public:
 	float		Eval ( const CSphMatch & tMatch ) const override		{ return (float)FetchValue(tMatch); }
 	int			IntEval ( const CSphMatch & tMatch ) const override		{ return (int)FetchValue(tMatch); }
 	int64_t		Int64Eval ( const CSphMatch & tMatch ) const override	{ return FetchValue(tMatch); }
+	void		EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const override;
+	void		IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const override;
+	void		Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const override	{ FetchValues ( dMatches, pOut ); }
 	uint64_t	GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final;
 	ISphExpr *	Clone() const override									{ return new Expr_GetColumnarInt_c ( m_sName, m_bStored ); }
 
 protected:
 	inline SphAttr_t FetchValue ( const CSphMatch & tMatch ) const		{  return m_pIterator->Get ( tMatch.m_tRowID ); }
+	void		FetchValues ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const;
 };
 
 
+void Expr_GetColumnarInt_c::FetchValues ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const
+{
+	assert ( dMatches.GetLength()<=MAX_EXPR_BATCH );
+	int iNumValues = dMatches.GetLength();
+	uint32_t dRowIDs[MAX_EXPR_BATCH];
+	bool bSorted = true;
+	for ( int i = 0; i < iNumValues; i++ )
+	{
+		dRowIDs[i] = dMatches[i]->m_tRowID;
+		bSorted &= !i || dRowIDs[i]>dRowIDs[i-1];
+	}
+
+	// block fetch only works for ascending rowids (as in fullscan); matches in the sorter come in arbitrary order
+	if ( !bSorted )
+	{
+		for ( int i = 0; i < iNumValues; i++ )
+			pOut[i] = m_pIterator->Get ( dRowIDs[i] );
+		return;
+	}
+
+	util::Span_T<uint32_t> dRowIDSpan ( dRowIDs, iNumValues );
+	util::Span_T<int64_t> dValues ( pOut, iNumValues );
+	m_pIterator->Fetch ( dRowIDSpan, dValues );
+}
+
+
+void Expr_GetColumnarInt_c::EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const
+{
+	int64_t dValues[MAX_EXPR_BATCH];
+	FetchValues ( dMatches, dValues );
+	for ( int i = 0, iLen = dMatches.GetLength(); i < iLen; i++ )
+		pOut[i] = (float)dValues[i];
+}
+
+
+void Expr_GetColumnarInt_c::IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const
+{
+	int64_t dValues[MAX_EXPR_BATCH];
+	FetchValues ( dMatches, dValues );
+	for ( int i = 0, iLen = dMatches.GetLength(); i < iLen; i++ )
+		pOut[i] = (int)dValues[i];
+}
+
+
 uint64_t Expr_GetColumnarInt_c::GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable )
 {
 	EXPR_CLASS_NAME("Expr_GetColumnarInt_c");
@@ -447,9 +495,21 @@ public:
 	float	Eval ( const CSphMatch & tMatch ) const final		{ return sphDW2F ( (DWORD)FetchValue(tMatch) ); }
 	int		IntEval ( const CSphMatch & tMatch ) const final	{ return (int)sphDW2F ( (DWORD)FetchValue(tMatch) ); }
 	int64_t	Int64Eval ( const CSphMatch & tMatch ) const final	{ return (int64_t)sphDW2F ( (DWORD)FetchValue(tMatch) ); }
+	void	EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final;
+	void	IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const final				{ ISphExpr::IntEvalBatch ( dMatches, pOut ); }
+	void	Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const final		{ ISphExpr::Int64EvalBatch ( dMatches, pOut ); }
 	ISphExpr *	Clone() const final								{ return new Expr_GetColumnarFloat_c ( m_sName, m_bStored ); }
 };
 
+
+void Expr_GetColumnarFloat_c::EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const
+{
+	int64_t dValues[MAX_EXPR_BATCH];
+	FetchValues ( dMatches, dValues );
+	for ( int i = 0, iLen = dMatches.GetLength(); i < iLen; i++ )
+		pOut[i] = sphDW2F ( (DWORD)dValues[i] );
+}
+
 /////////////////////////////////////////////////////////////////////
 
 class Expr_GetColumnarString_c : public Expr_GetColumnar_Traits_c
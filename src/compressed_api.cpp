@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "compressed_api.h"
+#include "docstore.h"
+
+Compression_e	g_eAgentCompression = Compression_e::NONE;
+int				g_iAgentCompressionThreshold = 4096;
+
+static constexpr int API_HEADER_SIZE = 8;		// command/status word, version word, body length
+static constexpr int FRAME_HEADER_SIZE = 5;		// codec byte, uncompressed length
+static constexpr int ZSTD_NET_LEVEL = 3;		// the frame goes to the network right away, so favour speed
+
+static const Compressor_i * GetCompressor ( Compression_e eCodec )
+{
+	// compressors keep their contexts between calls, so every thread has its own
+	static thread_local std::unique_ptr<Compressor_i> pLZ4 = CreateCompressor ( Compression_e::LZ4, 0 );
+	static thread_local std::unique_ptr<Compressor_i> pZstd = CreateCompressor ( Compression_e::ZSTD, ZSTD_NET_LEVEL );
+
+	switch ( eCodec )
+	{
+	case Compression_e::LZ4:	return pLZ4.get();
+	case Compression_e::ZSTD:	return pZstd.get();
+	default:					return nullptr;
+	}
+}
+
+
+bool ParseAgentCompression ( const char * szCodec, Compression_e & eCodec )
+{
+	if ( !strcmp ( szCodec, "none" ) )
+		eCodec = Compression_e::NONE;
+	else if ( !strcmp ( szCodec, "lz4" ) )
+		eCodec = Compression_e::LZ4;
+	else if ( !strcmp ( szCodec, "zstd" ) )
+		eCodec = Compression_e::ZSTD;
+	else
+		return false;
+
+	return true;
+}
+
+
+WORD ApiCompressionOffer()
+{
+	constexpr WORD LZ4_BIT = 1 << (int)Compression_e::LZ4;
+	constexpr WORD ZSTD_BIT = 1 << (int)Compression_e::ZSTD;
+
+	switch ( g_eAgentCompression )
+	{
+	case Compression_e::ZSTD:	return GetCompressor ( Compression_e::ZSTD ) ? ( ZSTD_BIT | LZ4_BIT ) : LZ4_BIT;
+	case Compression_e::LZ4:	return LZ4_BIT;
+	default:					return 0;
+	}
+}
+
+
+Compression_e ApiCompressionAccept ( WORD uOffer )
+{
+	for ( auto eCodec : { Compression_e::ZSTD, Compression_e::LZ4 } )
+		if ( ( uOffer & ( 1 << (int)eCodec ) ) && GetCompressor ( eCodec ) )
+			return eCodec;
+
+	return Compression_e::NONE;
+}
+
+
+bool ApiCompressPacket ( ISphOutputBuffer & tOut, int iStart, bool bReply, Compression_e eCodec, bool bAlwaysFrame, ApiCompressionStats_t & tStats )
+{
+	// only a single complete packet may be wrapped; if anything was flushed or appended, leave it alone
+	int iBody = tOut.GetSentCount() - iStart - API_HEADER_SIZE;
+	if ( iStart<0 || iBody<0 )
+		return false;
+
+	const BYTE * pHeader = tOut.m_dBuf.Begin() + iStart;
+	if ( (int)ntohl ( sphUnalignedRead ( *(const DWORD *)( pHeader+4 ) ) )!=iBody )
+		return false;
+
+	int64_t tmStart = sphMicroTimer();
+	VecTraits_T<BYTE> dBody ( const_cast<BYTE *>( pHeader+API_HEADER_SIZE ), iBody );
+	CSphVector<BYTE> dPayload;
+	const Compressor_i * pCompressor = GetCompressor ( eCodec );
+	if ( iBody<g_iAgentCompressionThreshold || !pCompressor || !pCompressor->Compress ( dBody, dPayload ) )
+	{
+		if ( !bAlwaysFrame )
+			return false;
+
+		eCodec = Compression_e::NONE;
+		dPayload.Append ( dBody );
+	}
+
+	// the flag goes to the version word of a reply, and to the command word of a request
+	int iFlagWord = iStart + ( bReply ? 2 : 0 );
+	WORD uFlagged = ntohs ( sphUnalignedRead ( *(const WORD *)( tOut.m_dBuf.Begin()+iFlagWord ) ) ) | API_COMPRESSED_FRAME;
+	tOut.WriteT<WORD> ( iFlagWord, htons ( uFlagged ) );
+	tOut.WriteInt ( iStart+4, FRAME_HEADER_SIZE + dPayload.GetLength() );
+
+	tOut.Rewind ( iStart+API_HEADER_SIZE );
+	tOut.SendByte ( (BYTE)eCodec );
+	tOut.SendDword ( (DWORD)iBody );
+	tOut.SendBytes ( dPayload );
+
+	tStats.m_iRawBytes += iBody;
+	tStats.m_iWireBytes += FRAME_HEADER_SIZE + dPayload.GetLength();
+	tStats.m_iTimeUS += sphMicroTimer() - tmStart;
+	return true;
+}
+
+
+bool ApiDecompressFrame ( ByteBlob_t tFrame, int iMaxSize, CSphFixedVector<BYTE> & dRaw, Compression_e & eCodec, CSphString & sError, ApiCompressionStats_t & tStats )
+{
+	if ( tFrame.second<FRAME_HEADER_SIZE )
+	{
+		sError.SetSprintf ( "compressed frame is too short (%d bytes)", tFrame.second );
+		return false;
+	}
+
+	int64_t tmStart = sphMicroTimer();
+	eCodec = (Compression_e)tFrame.first[0];
+	DWORD uRawSize = ntohl ( sphUnalignedRead ( *(const DWORD *)( tFrame.first+1 ) ) );
+	if ( uRawSize>(DWORD)iMaxSize )
+	{
+		sError.SetSprintf ( "uncompressed frame size %u exceeds limit %d", uRawSize, iMaxSize );
+		return false;
+	}
+
+	VecTraits_T<BYTE> dPayload ( const_cast<BYTE *>( tFrame.first+FRAME_HEADER_SIZE ), tFrame.second-FRAME_HEADER_SIZE );
+	dRaw.Reset ( uRawSize );
+	if ( eCodec==Compression_e::NONE )
+	{
+		if ( dPayload.GetLength()!=(int64_t)uRawSize )
+		{
+			sError.SetSprintf ( "frame size mismatch (expected %u, got %d)", uRawSize, (int)dPayload.GetLength() );
+			return false;
+		}
+
+		memcpy ( dRaw.Begin(), dPayload.Begin(), uRawSize );
+	} else
+	{
+		const Compressor_i * pCompressor = GetCompressor ( eCodec );
+		if ( !pCompressor )
+		{
+			sError.SetSprintf ( "unsupported frame codec %d", (int)eCodec );
+			return false;
+		}
+
+		if ( !pCompressor->Decompress ( dPayload, dRaw ) )
+		{
+			sError.SetSprintf ( "failed to decompress %s frame", CompressionToStr ( eCodec ).cstr() );
+			return false;
+		}
+	}
+
+	tStats.m_iRawBytes += uRawSize;
+	tStats.m_iWireBytes += tFrame.second;
+	tStats.m_iTimeUS += sphMicroTimer() - tmStart;
+	return true;
+}
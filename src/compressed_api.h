@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#pragma once
+
+#include "searchdaemon.h"
+
+// Compressed frames of the binary API between master and agents.
+//
+// Master offers codecs as a bitmask (1<<Compression_e) in the version word of SEARCHD_COMMAND_PERSIST, which older
+// agents ignore. An agent which accepted the offer flags every further reply with API_COMPRESSED_FRAME in the version
+// word; while a host answers with such replies, the master compresses its requests to it the same way, with the
+// flag in the command word. A reply without the flag, or a broken frame, stops that. The body of a flagged packet is: BYTE codec, DWORD uncompressed length, payload (as is,
+// if codec is NONE, i.e. the packet was below the threshold or didn't compress).
+
+constexpr WORD API_COMPRESSED_FRAME = 0x8000;
+
+extern Compression_e	g_eAgentCompression;			///< codec the master offers to agents; NONE disables compression
+extern int				g_iAgentCompressionThreshold;	///< packets with shorter body are sent as is
+
+struct ApiCompressionStats_t
+{
+	int64_t m_iRawBytes = 0;	///< uncompressed body bytes
+	int64_t m_iWireBytes = 0;	///< framed body bytes actually sent or received
+	int64_t m_iTimeUS = 0;		///< spent compressing or decompressing
+};
+
+bool ParseAgentCompression ( const char * szCodec, Compression_e & eCodec );
+
+/// master: codecs to offer (for the version word of the persist command); 0 if compression is off
+WORD ApiCompressionOffer();
+
+/// agent: codec to use with a master which made the offer; NONE if nothing suitable
+Compression_e ApiCompressionAccept ( WORD uOffer );
+
+/// wrap the single API packet which starts at iStart of tOut into compressed frame.
+/// Short or incompressible packets are wrapped with codec NONE if bAlwaysFrame, or left untouched (return false)
+bool ApiCompressPacket ( ISphOutputBuffer & tOut, int iStart, bool bReply, Compression_e eCodec, bool bAlwaysFrame, ApiCompressionStats_t & tStats );
+
+/// unwrap body of the flagged packet into dRaw. Codec of the frame is returned in eCodec
+bool ApiDecompressFrame ( ByteBlob_t tFrame, int iMaxSize, CSphFixedVector<BYTE> & dRaw, Compression_e & eCodec, CSphString & sError, ApiCompressionStats_t & tStats );
@@ -38,7 +38,9 @@ enum
 	QFLAG_JSON_QUERY			= 1UL << 11,
 	QFLAG_NOT_ONLY_ALLOWED		= 1UL << 12,
 	QFLAG_LOCAL_DF_SET			= 1UL << 13,
-	QFLAG_SIMPLIFY_SET			= 1UL << 14
+	QFLAG_SIMPLIFY_SET			= 1UL << 14,
+	QFLAG_TOP_K_PRUNING			= 1UL << 15,
+	QFLAG_DISTINCT_SKETCH		= 1UL << 16
 };
 
 void operator<< ( ISphOutputBuffer & tOut, const CSphNamedInt & tValue )
@@ -53,7 +55,64 @@ void operator>> ( InputBuffer_c & dIn, CSphNamedInt & tValue )
 	tValue.second = dIn.GetInt ();
 }
 
-void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer & tOut, const CSphQuery & q, int iWeight ) const
+// with top-k pruning of a plain 'order by weight desc' query, the agent needs no more than offset+limit matches:
+// the merged top-k comes from the top-k of each agent anyway, and a small queue fills up (and raises the agent's
+// pruning floor) much earlier than a max_matches one
+static int TopKAgentLimit ( const CSphQuery & q )
+{
+	if ( !q.m_bTopKPruning || q.m_bHasOuter || q.m_bFacet || q.m_bFacetHead || !q.m_sGroupBy.IsEmpty() || !q.m_sGroupDistinct.IsEmpty() || !q.m_sJoinIdx.IsEmpty() )
+		return 0;
+
+	if ( q.m_dItems.any_of ( [] ( const CSphQueryItem & tItem ) { return tItem.m_eAggrFunc!=SPH_AGGR_NONE; } ) )
+		return 0;
+
+	if ( q.m_eSort==SPH_SORT_EXTENDED )
+	{
+		StrVec_t dKeys = sphSplit ( q.m_sSortBy.cstr(), " \t," );
+		if ( !dKeys.IsEmpty() && dKeys[0].IsEmpty() )
+			dKeys.Remove(0);
+
+		if ( dKeys.GetLength()<2 || strcasecmp ( dKeys[1].cstr(), "desc" ) )
+			return 0;
+
+		const char * szKey = dKeys[0].cstr();
+		if ( strcasecmp ( szKey, "@weight" ) && strcasecmp ( szKey, "@relevance" ) && strcasecmp ( szKey, "@rank" ) && strcasecmp ( szKey, "weight()" ) )
+			return 0;
+	} else if ( q.m_eSort!=SPH_SORT_RELEVANCE )
+		return 0;
+
+	return Min ( q.m_iOffset + q.m_iLimit, q.m_iMaxMatches );
+}
+
+
+TopKFloors_c::TopKFloors_c ( const VecTraits_T<CSphQuery> & dQueries )
+	: m_dLimits ( dQueries.GetLength() )
+	, m_dFloors ( dQueries.GetLength() )
+{
+	ARRAY_FOREACH ( i, dQueries )
+	{
+		m_dLimits[i] = TopKAgentLimit ( dQueries[i] );
+		m_dFloors[i].store ( dQueries[i].m_iTopKFloor, std::memory_order_relaxed ); // this daemon might be an agent itself
+	}
+}
+
+// the agent sent its top-k sorted by weight desc; with k matches, no doc below the last one can get into the merged top-k
+// (as long as the agents hold different docs, as shards do)
+void TopKFloors_c::Update ( int iQuery, const VecTraits_T<CSphMatch> & dMatches )
+{
+	int iLimit = m_dLimits[iQuery];
+	if ( !iLimit || dMatches.GetLength()<iLimit )
+		return;
+
+	int64_t iWeight = dMatches[iLimit-1].m_iWeight;
+	auto & tFloor = m_dFloors[iQuery];
+	int64_t iFloor = tFloor.load ( std::memory_order_relaxed );
+	while ( iFloor<iWeight && !tFloor.compare_exchange_weak ( iFloor, iWeight, std::memory_order_relaxed ) )
+		;
+}
+
+
+void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer & tOut, const CSphQuery & q, int iWeight, int iTopKLimit, int64_t iTopKFloor ) const
 {
 	bool bAgentWeight = ( iWeight!=-1 );
 	// starting with command version 1.27, flags go first
@@ -71,6 +130,8 @@ void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer
 	uFlags |= QFLAG_NOT_ONLY_ALLOWED * q.m_bNotOnlyAllowed;
 	uFlags |= QFLAG_LOCAL_DF_SET * q.m_bLocalDF.has_value();
 	uFlags |= QFLAG_SIMPLIFY_SET * q.m_bSimplify.has_value();
+	uFlags |= QFLAG_TOP_K_PRUNING * q.m_bTopKPruning;
+	uFlags |= QFLAG_DISTINCT_SKETCH * q.m_bDistinctSketch;
 
 	if ( q.m_eQueryType==QUERY_JSON )
 		uFlags |= QFLAG_JSON_QUERY;
@@ -79,7 +140,9 @@ void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer
 
 	// The Search Legacy
 	tOut.SendInt ( 0 ); // offset is 0
-	if ( !q.m_bHasOuter )
+	if ( iTopKLimit )
+		tOut.SendInt ( iTopKLimit );
+	else if ( !q.m_bHasOuter )
 	{
 		if ( m_iDivideLimits==1 )
 			tOut.SendInt ( q.m_iMaxMatches ); // OPTIMIZE? normally, agent limit is max_matches, even if master limit is less
@@ -165,7 +228,9 @@ void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer
 	}
 	tOut.SendInt ( q.m_eGroupFunc );
 	tOut.SendString ( q.m_sGroupBy.cstr() );
-	if ( m_iDivideLimits==1 )
+	if ( iTopKLimit )
+		tOut.SendInt ( iTopKLimit );
+	else if ( m_iDivideLimits==1 )
 		tOut.SendInt ( q.m_iMaxMatches );
 	else
 		tOut.SendInt ( 1+(q.m_iMaxMatches/m_iDivideLimits) ); // Reduce the max_matches also.
@@ -319,6 +384,7 @@ void SearchRequestBuilder_c::SendQuery ( const char * sIndexes, ISphOutputBuffer
 	}
 
 	tOut.SendString ( q.m_sExpandBlended.cstr() );
+	tOut.SendUint64 ( iTopKFloor );
 }
 
 
@@ -328,8 +394,14 @@ void SearchRequestBuilder_c::BuildRequest ( const AgentConn_t & tAgent, ISphOutp
 
 	tOut.SendInt ( VER_COMMAND_SEARCH_MASTER );
 	tOut.SendInt ( m_dQueries.GetLength() );
-	for ( auto& dQuery : m_dQueries )
-		SendQuery ( tAgent.m_tDesc.m_sIndexes.cstr (), tOut, dQuery, tAgent.m_iWeight );
+	ARRAY_FOREACH ( i, m_dQueries )
+	{
+		// the request is built when the agent gets connected, so it takes the floor of the agents that replied so far
+		bool bTopK = m_pTopKFloors && m_iDivideLimits==1;
+		int iTopKLimit = bTopK ? m_pTopKFloors->GetAgentLimit(i) : 0;
+		int64_t iTopKFloor = iTopKLimit ? m_pTopKFloors->GetFloor(i) : 0;
+		SendQuery ( tAgent.m_tDesc.m_sIndexes.cstr (), tOut, m_dQueries[i], tAgent.m_iWeight, iTopKLimit, iTopKFloor );
+	}
 }
 
 
@@ -495,8 +567,9 @@ bool SearchReplyParser_c::ParseReply ( MemInputBuffer_c & tReq, AgentConn_t & tA
 	auto &dResults = pResult->m_dResults;
 
 	dResults.Resize ( iResults );
-	for ( auto & tRes : dResults )
+	ARRAY_FOREACH ( iRes, dResults )
 	{
+		auto & tRes = dResults[iRes];
 		tRes.m_iSuccesses = 0;
 		OneResultset_t tChunk;
 		tChunk.m_iTag = tAgent.m_iStoreTag;
@@ -583,6 +656,9 @@ bool SearchReplyParser_c::ParseReply ( MemInputBuffer_c & tReq, AgentConn_t & tA
 			tRes.AddStat ( sWord, iDocs, iHits );
 		}
 
+		if ( m_pTopKFloors && eStatus!=SEARCHD_RETRY )
+			m_pTopKFloors->Update ( iRes, tChunk.m_dMatches );
+
 		// mark this result as ok
 		auto& tNewChunk = tRes.m_dResults.Add ();
 		::Swap ( tNewChunk, tChunk );
@@ -938,6 +1014,8 @@ bool ParseSearchQuery ( InputBuffer_c & tReq, ISphOutputBuffer & tOut, CSphQuery
 		tQuery.m_bFacetHead = !!( uFlags & QFLAG_FACET_HEAD );
 		tQuery.m_eQueryType = (uFlags & QFLAG_JSON_QUERY) ? QUERY_JSON : QUERY_API;
 		tQuery.m_bNotOnlyAllowed = !!( uFlags & QFLAG_NOT_ONLY_ALLOWED );
+		tQuery.m_bTopKPruning = !!( uFlags & QFLAG_TOP_K_PRUNING );
+		tQuery.m_bDistinctSketch = !!( uFlags & QFLAG_DISTINCT_SKETCH );
 
 		if ( uMasterVer>0 || uVer==0x11E )
 			tQuery.m_bNormalizedTFIDF = !!( uFlags & QFLAG_NORMALIZED_TF );
@@ -1195,6 +1273,9 @@ bool ParseSearchQuery ( InputBuffer_c & tReq, ISphOutputBuffer & tOut, CSphQuery
 	if ( uMasterVer>=27 )
 		tQuery.m_sExpandBlended = tReq.GetString();
 
+	if ( uMasterVer>=30 )
+		tQuery.m_iTopKFloor = (int64_t)tReq.GetUint64();
+
 	/////////////////////
 	// additional checks
 	/////////////////////
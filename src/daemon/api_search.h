@@ -14,32 +14,52 @@
 
 #include "searchdha.h"
 
+/// top-k pruning of a distributed query: agents are asked for offset+limit matches only, and the k-th weight
+/// of every agent that already replied is a floor for the agents queried after it (slow connects, retries, mirrors)
+class TopKFloors_c
+{
+public:
+	NONCOPYMOVABLE ( TopKFloors_c );
+	explicit TopKFloors_c ( const VecTraits_T<CSphQuery> & dQueries );
+
+	int		GetAgentLimit ( int iQuery ) const	{ return m_dLimits[iQuery]; }
+	int64_t	GetFloor ( int iQuery ) const		{ return m_dFloors[iQuery].load ( std::memory_order_relaxed ); }
+	void	Update ( int iQuery, const VecTraits_T<CSphMatch> & dMatches );
+
+private:
+	CSphFixedVector<int>					m_dLimits;
+	CSphFixedVector<std::atomic<int64_t>>	m_dFloors;
+};
+
+
 class SearchRequestBuilder_c final : public RequestBuilder_i
 {
 	const VecTraits_T<CSphQuery> & m_dQueries;
 	const int m_iDivideLimits;
+	const TopKFloors_c * m_pTopKFloors;
 
 public:
 	NONCOPYMOVABLE ( SearchRequestBuilder_c );
-	SearchRequestBuilder_c ( const VecTraits_T<CSphQuery> & dQueries, int iDivideLimits )
-		: m_dQueries ( dQueries ), m_iDivideLimits ( iDivideLimits )
+	SearchRequestBuilder_c ( const VecTraits_T<CSphQuery> & dQueries, int iDivideLimits, const TopKFloors_c * pTopKFloors = nullptr )
+		: m_dQueries ( dQueries ), m_iDivideLimits ( iDivideLimits ), m_pTopKFloors ( pTopKFloors )
 	{}
 
 	void BuildRequest ( const AgentConn_t & tAgent, ISphOutputBuffer & tOut ) const;
 
 private:
-	void SendQuery ( const char * sIndexes, ISphOutputBuffer & tOut, const CSphQuery & q, int iWeight ) const;
+	void SendQuery ( const char * sIndexes, ISphOutputBuffer & tOut, const CSphQuery & q, int iWeight, int iTopKLimit, int64_t iTopKFloor ) const;
 };
 
 
 class SearchReplyParser_c final : public ReplyParser_i
 {
 	int m_iResults;
+	TopKFloors_c * m_pTopKFloors;
 
 public:
 	NONCOPYMOVABLE ( SearchReplyParser_c );
-	explicit SearchReplyParser_c ( int iResults )
-		: m_iResults ( iResults )
+	explicit SearchReplyParser_c ( int iResults, TopKFloors_c * pTopKFloors = nullptr )
+		: m_iResults ( iResults ), m_pTopKFloors ( pTopKFloors )
 	{}
 
 	bool ParseReply ( MemInputBuffer_c & tReq, AgentConn_t & tAgent ) const;
@@ -0,0 +1,558 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org
+//
+
+#include "hot_restart.h"
+
+#include "searchdaemon.h"
+#include "fileutils.h"
+#include "net_action_accept.h"
+#include "sphinxrt.h"
+#include "binlog.h"
+
+#if _WIN32
+
+namespace hotrestart
+{
+
+bool Prepare ( const CSphString &, CSphString & sError )
+{
+	sError = "hot restart is not supported on Windows";
+	return false;
+}
+
+bool TakeOver ( CSphString & sError )
+{
+	sError = "hot restart is not supported on Windows";
+	return false;
+}
+
+int PopInherited ( const ListenerDesc_t & ) { return -1; }
+void CloseUnused() {}
+bool LockPidFile ( int &, const CSphString &, CSphString & sError )
+{
+	sError = "hot restart is not supported on Windows";
+	return false;
+}
+bool SendListeners ( int, const VecTraits_T<int> & ) { return false; }
+bool ReceiveListeners ( int, CSphString & sError )
+{
+	sError = "hot restart is not supported on Windows";
+	return false;
+}
+void StartService ( const CSphString &, const VecTraits_T<Listener_t> &, bool ) {}
+void StopService() {}
+bool HandedOver() { return false; }
+
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+static constexpr DWORD	TAKEOVER_MAGIC = 0x54535248;	// 'HRST'
+static constexpr DWORD	TAKEOVER_READY = 0x59445248;	// 'HRDY'
+static constexpr int	MAX_HANDED_FDS = 250;			// SCM_MAX_FD on linux is 253
+static constexpr int	IO_TIMEOUT_MS = 10000;
+static constexpr int	FREEZE_TIMEOUT_MS = 600000;		// RT tables flush their RAM chunks before they are released
+
+static CSphVector<int>	g_dInherited;
+static int				g_iTakeoverSock = -1;
+
+static CSphString		g_sServicePath;
+static int				g_iServiceSock = -1;
+static CSphVector<int>	g_dHandedSocks;
+static bool				g_bLockPlain = true;
+static CSphVector<cServedIndexRefPtr_c> g_dReleased;
+static std::atomic<bool> g_bServiceStop { false };
+static std::atomic<bool> g_bHandedOver { false };
+
+
+static CSphString TakeoverPath ( const CSphString & sPidFile )
+{
+	CSphString sPath;
+	sPath.SetSprintf ( "%s.takeover", sPidFile.cstr() );
+	return sPath;
+}
+
+
+static bool MakeAddress ( const CSphString & sPath, sockaddr_un & tAddr, CSphString & sError )
+{
+	if ( (size_t)sPath.Length()+1 > sizeof ( tAddr.sun_path ) )
+	{
+		sError.SetSprintf ( "takeover socket path '%s' is too long", sPath.cstr() );
+		return false;
+	}
+
+	memset ( &tAddr, 0, sizeof ( tAddr ) );
+	tAddr.sun_family = AF_UNIX;
+	memcpy ( tAddr.sun_path, sPath.cstr(), sPath.Length()+1 );
+	return true;
+}
+
+
+static bool WaitSocket ( int iSock, short iEvents, int iTimeoutMs )
+{
+	pollfd tPoll { iSock, iEvents, 0 };
+	int iRes;
+	do
+		iRes = ::poll ( &tPoll, 1, iTimeoutMs );
+	while ( iRes<0 && errno==EINTR );
+	return iRes>0;
+}
+
+
+static bool SendDword ( int iSock, DWORD uValue )
+{
+	return ::send ( iSock, &uValue, sizeof ( uValue ), MSG_NOSIGNAL )==sizeof ( uValue );
+}
+
+
+static bool ReceiveDword ( int iSock, DWORD uExpected, int iTimeoutMs )
+{
+	DWORD uValue = 0;
+	return WaitSocket ( iSock, POLLIN, iTimeoutMs ) && ::recv ( iSock, &uValue, sizeof ( uValue ), 0 )==sizeof ( uValue ) && uValue==uExpected;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// new instance side
+
+bool hotrestart::Prepare ( const CSphString & sPidFile, CSphString & sError )
+{
+	assert ( g_iTakeoverSock<0 );
+
+	sockaddr_un tAddr;
+	CSphString sPath = TakeoverPath ( sPidFile );
+	if ( !MakeAddress ( sPath, tAddr, sError ) )
+		return false;
+
+	int iSock = socket ( AF_UNIX, SOCK_STREAM, 0 );
+	if ( iSock<0 )
+	{
+		sError.SetSprintf ( "socket() failed: %s", strerrorm(errno) );
+		return false;
+	}
+
+	AT_SCOPE_EXIT ( [&iSock] { SafeCloseSocket ( iSock ); } );
+
+	if ( ::connect ( iSock, (const sockaddr *)&tAddr, sizeof ( tAddr ) )<0 )
+	{
+		sError.SetSprintf ( "no running instance answered at '%s': %s", sPath.cstr(), strerrorm(errno) );
+		return false;
+	}
+
+	if ( !SendDword ( iSock, TAKEOVER_MAGIC ) )
+	{
+		sError.SetSprintf ( "send() to '%s' failed: %s", sPath.cstr(), strerrorm(errno) );
+		return false;
+	}
+
+	if ( !ReceiveDword ( iSock, TAKEOVER_MAGIC, FREEZE_TIMEOUT_MS ) )
+	{
+		sError.SetSprintf ( "running instance at '%s' did not release its tables", sPath.cstr() );
+		return false;
+	}
+
+	// the connection is kept until the takeover; if we quit before that, the running instance sees it closed and goes on
+	std::swap ( g_iTakeoverSock, iSock );
+	return true;
+}
+
+
+bool hotrestart::TakeOver ( CSphString & sError )
+{
+	assert ( g_iTakeoverSock>=0 );
+	AT_SCOPE_EXIT ( [] { SafeCloseSocket ( g_iTakeoverSock ); } );
+
+	if ( !SendDword ( g_iTakeoverSock, TAKEOVER_READY ) )
+	{
+		sError.SetSprintf ( "send() failed: %s", strerrorm(errno) );
+		return false;
+	}
+
+	return ReceiveListeners ( g_iTakeoverSock, sError );
+}
+
+
+bool hotrestart::ReceiveListeners ( int iSock, CSphString & sError )
+{
+	assert ( g_dInherited.IsEmpty() );
+	if ( !WaitSocket ( iSock, POLLIN, IO_TIMEOUT_MS ) )
+	{
+		sError.SetSprintf ( "running instance did not hand the sockets over in %d ms", IO_TIMEOUT_MS );
+		return false;
+	}
+
+	DWORD uCount = 0;
+	iovec tIov { &uCount, sizeof ( uCount ) };
+	alignas ( cmsghdr ) char dControl [ CMSG_SPACE ( sizeof(int)*MAX_HANDED_FDS ) ];
+
+	msghdr tMsg {};
+	tMsg.msg_iov = &tIov;
+	tMsg.msg_iovlen = 1;
+	tMsg.msg_control = dControl;
+	tMsg.msg_controllen = sizeof ( dControl );
+
+	auto iRead = ::recvmsg ( iSock, &tMsg, 0 );
+	if ( iRead!=sizeof ( uCount ) )
+	{
+		sError.SetSprintf ( "recvmsg() failed: %s", iRead<0 ? strerrorm(errno) : "short read" );
+		return false;
+	}
+
+	for ( cmsghdr * pCmsg = CMSG_FIRSTHDR ( &tMsg ); pCmsg; pCmsg = CMSG_NXTHDR ( &tMsg, pCmsg ) )
+	{
+		if ( pCmsg->cmsg_level!=SOL_SOCKET || pCmsg->cmsg_type!=SCM_RIGHTS )
+			continue;
+
+		int iFds = int ( ( pCmsg->cmsg_len - CMSG_LEN(0) ) / sizeof(int) );
+		const auto * pFds = (const int *)CMSG_DATA ( pCmsg );
+		for ( int i = 0; i < iFds; ++i )
+			g_dInherited.Add ( pFds[i] );
+	}
+
+	if ( (DWORD)g_dInherited.GetLength()!=uCount || ( tMsg.msg_flags & MSG_CTRUNC ) )
+	{
+		sError.SetSprintf ( "expected %u sockets, got %d", uCount, g_dInherited.GetLength() );
+		CloseUnused();
+		return false;
+	}
+
+	return true;
+}
+
+
+int hotrestart::PopInherited ( const ListenerDesc_t & tDesc )
+{
+	ARRAY_FOREACH ( i, g_dInherited )
+	{
+		sockaddr_storage tAddr;
+		socklen_t iLen = sizeof ( tAddr );
+		if ( ::getsockname ( g_dInherited[i], (sockaddr *)&tAddr, &iLen )<0 )
+			continue;
+
+		bool bMatch = false;
+		if ( !tDesc.m_sUnix.IsEmpty() )
+			bMatch = tAddr.ss_family==AF_UNIX && tDesc.m_sUnix==( (const sockaddr_un &)tAddr ).sun_path;
+		else if ( tAddr.ss_family==AF_INET )
+		{
+			const auto & tInet = (const sockaddr_in &)tAddr;
+			bMatch = tInet.sin_addr.s_addr==tDesc.m_uIP && ntohs ( tInet.sin_port )==tDesc.m_iPort;
+		}
+
+		if ( !bMatch )
+			continue;
+
+		int iSock = g_dInherited[i];
+		g_dInherited.RemoveFast(i);
+		return iSock;
+	}
+
+	return -1;
+}
+
+
+void hotrestart::CloseUnused()
+{
+	for ( int & iSock : g_dInherited )
+		SafeCloseSocket ( iSock );
+
+	g_dInherited.Reset();
+}
+
+
+bool hotrestart::LockPidFile ( int & iPidFD, const CSphString & sPidFile, CSphString & sError )
+{
+	const int MAX_TRIES = 10;
+	for ( int iTry = 0; iTry<MAX_TRIES; ++iTry )
+	{
+		if ( !sphLockEx ( iPidFD, true ) )
+		{
+			sError.SetSprintf ( "failed to lock pid file '%s': %s", sPidFile.cstr(), strerrorm(errno) );
+			return false;
+		}
+
+		struct stat tLocked, tOnDisk;
+		if ( ::fstat ( iPidFD, &tLocked )==0 && ::stat ( sPidFile.cstr(), &tOnDisk )==0 && tLocked.st_dev==tOnDisk.st_dev && tLocked.st_ino==tOnDisk.st_ino )
+			return true;
+
+		// the previous owner removed the file on its way out; the one we hold is not reachable by path anymore
+		::close ( iPidFD );
+		iPidFD = ::open ( sPidFile.cstr(), O_CREAT | O_WRONLY, S_IREAD | S_IWRITE );
+		if ( iPidFD<0 )
+		{
+			sError.SetSprintf ( "failed to create pid file '%s': %s", sPidFile.cstr(), strerrorm(errno) );
+			return false;
+		}
+	}
+
+	sError.SetSprintf ( "pid file '%s' keeps being replaced", sPidFile.cstr() );
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// running instance side
+
+static bool IsTakeoverRequest ( int iClient )
+{
+	if ( !ReceiveDword ( iClient, TAKEOVER_MAGIC, IO_TIMEOUT_MS ) )
+		return false;
+
+#ifdef SO_PEERCRED
+	ucred tCred {};
+	socklen_t iLen = sizeof ( tCred );
+	if ( ::getsockopt ( iClient, SOL_SOCKET, SO_PEERCRED, &tCred, &iLen )<0 || tCred.uid!=geteuid() )
+	{
+		sphWarning ( "hot restart: takeover request from another user (uid=%d), ignored", (int)tCred.uid );
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+
+bool hotrestart::SendListeners ( int iSock, const VecTraits_T<int> & dSocks )
+{
+	assert ( dSocks.GetLength()<=MAX_HANDED_FDS );
+	auto uCount = (DWORD)dSocks.GetLength();
+	iovec tIov { &uCount, sizeof ( uCount ) };
+	alignas ( cmsghdr ) char dControl [ CMSG_SPACE ( sizeof(int)*MAX_HANDED_FDS ) ];
+
+	msghdr tMsg {};
+	tMsg.msg_iov = &tIov;
+	tMsg.msg_iovlen = 1;
+	if ( uCount )
+	{
+		tMsg.msg_control = dControl;
+		tMsg.msg_controllen = CMSG_SPACE ( sizeof(int)*uCount );
+
+		cmsghdr * pCmsg = CMSG_FIRSTHDR ( &tMsg );
+		pCmsg->cmsg_level = SOL_SOCKET;
+		pCmsg->cmsg_type = SCM_RIGHTS;
+		pCmsg->cmsg_len = CMSG_LEN ( sizeof(int)*uCount );
+		memcpy ( CMSG_DATA ( pCmsg ), dSocks.Begin(), sizeof(int)*uCount );
+	}
+
+	if ( ::sendmsg ( iSock, &tMsg, MSG_NOSIGNAL )!=sizeof ( uCount ) )
+	{
+		sphWarning ( "hot restart: sendmsg() failed: %s", strerrorm(errno) );
+		return false;
+	}
+
+	return true;
+}
+
+
+// same as FREEZE: RT writes go on to RAM and binlog only, so the new instance loads files that stay as they are,
+// and picks the rest up with binlog replay after the takeover
+static void ReleaseTables()
+{
+	Threads::CallCoroutine ( [] {
+		StrVec_t dFiles;
+		ServedSnap_t hLocal = g_pLocalIndexes->GetHash();
+		for ( const auto & tIt : *hLocal )
+		{
+			const cServedIndexRefPtr_c & pServed = tIt.second;
+			if ( ServedDesc_t::IsMutable ( pServed ) )
+			{
+				// non-locked instance, as FREEZE takes it, to avoid deadlock with update
+				auto * pRt = static_cast<RtIndex_i *> ( UnlockedHazardIdxFromServed ( *pServed ) );
+				pRt->LockFileState ( dFiles );
+				pRt->ReleaseTableLock();
+			} else if ( g_bLockPlain && pServed && pServed->m_eType==IndexType_e::PLAIN )
+				RWIdx_c ( pServed )->Unlock();
+			else
+				continue;
+
+			g_dReleased.Add ( pServed );
+		}
+
+		Binlog::ReleaseLock();
+	});
+}
+
+
+static void RetakeTables()
+{
+	Threads::CallCoroutine ( [] {
+		CSphString sError;
+		for ( const auto & pServed : g_dReleased )
+		{
+			if ( ServedDesc_t::IsMutable ( pServed ) )
+			{
+				RIdx_T<RtIndex_i *> pRt { pServed };
+				if ( !pRt->RetakeTableLock ( sError ) )
+					sphWarning ( "hot restart: table '%s': %s", pRt->GetName(), sError.cstr() );
+				pRt->EnableSave();
+			} else
+			{
+				RWIdx_c pIdx { pServed };
+				if ( !pIdx->Lock() )
+					sphWarning ( "hot restart: table '%s': lock: %s", pIdx->GetName(), pIdx->GetLastError().cstr() );
+			}
+		}
+
+		if ( !Binlog::RetakeLock ( sError ) )
+			sphWarning ( "hot restart: binlog: %s", sError.cstr() );
+	});
+
+	g_dReleased.Reset();
+}
+
+
+static bool IsServiceStopped()
+{
+	return g_bServiceStop.load ( std::memory_order_relaxed ) || sphInterrupted();
+}
+
+
+// the new instance is loading the tables meanwhile; that may take long, so there's no timeout, only its disconnect
+static bool WaitReady ( int iClient )
+{
+	while ( !IsServiceStopped() )
+		if ( WaitSocket ( iClient, POLLIN, 500 ) )
+			return ReceiveDword ( iClient, TAKEOVER_READY, 0 );
+
+	return false;
+}
+
+
+static void ServiceLoop()
+{
+	while ( !IsServiceStopped() )
+	{
+		if ( !WaitSocket ( g_iServiceSock, POLLIN, 500 ) )
+			continue;
+
+		int iClient = ::accept ( g_iServiceSock, nullptr, nullptr );
+		if ( iClient<0 )
+			continue;
+
+		if ( !IsTakeoverRequest ( iClient ) )
+		{
+			SafeCloseSocket ( iClient );
+			continue;
+		}
+
+		// keep accepting and serving while the new instance loads the tables
+		sphInfo ( "hot restart: takeover requested, releasing tables to the new instance" );
+		ReleaseTables();
+		bool bReady = SendDword ( iClient, TAKEOVER_MAGIC ) && WaitReady ( iClient );
+
+		// stop accepting before the sockets leave, so that nothing is taken from the backlog by us after that
+		bool bHanded = false;
+		if ( bReady )
+		{
+			PauseAccept ( true );
+			bHanded = hotrestart::SendListeners ( iClient, g_dHandedSocks );
+			if ( !bHanded )
+				PauseAccept ( false );
+		}
+		SafeCloseSocket ( iClient );
+
+		if ( !bHanded )
+		{
+			// on shutdown the tables stay released; what they didn't save is in the binlog
+			if ( IsServiceStopped() )
+			{
+				g_dReleased.Reset();
+				break;
+			}
+
+			sphWarning ( "hot restart: new instance quit before taking over, tables are taken back" );
+			RetakeTables();
+			continue;
+		}
+
+		// the new instance owns the sockets (and the pid file) now; the kernel keeps queueing connections on them while we stop.
+		// tables stay frozen, so the shutdown saves nothing the new instance has loaded; it replays our binlog instead
+		g_dReleased.Reset();
+		g_bHandedOver.store ( true, std::memory_order_relaxed );
+		sphInfo ( "hot restart: %d listening socket(s) handed over, shutting down", g_dHandedSocks.GetLength() );
+		sphInterruptNow();
+		break;
+	}
+}
+
+
+void hotrestart::StartService ( const CSphString & sPidFile, const VecTraits_T<Listener_t> & dListeners, bool bLockPlain )
+{
+	if ( sPidFile.IsEmpty() )
+		return;
+
+	g_bLockPlain = bLockPlain;
+
+	for ( const auto & tListener : dListeners )
+		if ( tListener.m_iSock>=0 && g_dHandedSocks.GetLength()<MAX_HANDED_FDS )
+			g_dHandedSocks.Add ( tListener.m_iSock );
+
+	CSphString sError;
+	sockaddr_un tAddr;
+	g_sServicePath = TakeoverPath ( sPidFile );
+	if ( !MakeAddress ( g_sServicePath, tAddr, sError ) )
+	{
+		sphWarning ( "hot restart: %s; disabled", sError.cstr() );
+		return;
+	}
+
+	g_iServiceSock = socket ( AF_UNIX, SOCK_STREAM, 0 );
+	if ( g_iServiceSock<0 )
+	{
+		sphWarning ( "hot restart: socket() failed: %s; disabled", strerrorm(errno) );
+		return;
+	}
+
+	::unlink ( g_sServicePath.cstr() );
+	int iMask = umask ( 077 );
+	bool bBound = ::bind ( g_iServiceSock, (const sockaddr *)&tAddr, sizeof ( tAddr ) )==0;
+	umask ( iMask );
+
+	if ( !bBound || ::listen ( g_iServiceSock, 1 )<0 )
+	{
+		sphWarning ( "hot restart: failed to listen on '%s': %s; disabled", g_sServicePath.cstr(), strerrorm(errno) );
+		SafeCloseSocket ( g_iServiceSock );
+		return;
+	}
+
+	SphThread_t tThd;
+	if ( !Threads::Create ( &tThd, ServiceLoop, true, "takeover" ) )
+	{
+		sphWarning ( "hot restart: failed to start service thread; disabled" );
+		StopService();
+	}
+}
+
+
+void hotrestart::StopService()
+{
+	g_bServiceStop.store ( true, std::memory_order_relaxed );
+	if ( g_iServiceSock<0 )
+		return;
+
+	// the thread polls with a short timeout and doesn't touch the socket after the stop flag is set
+	::shutdown ( g_iServiceSock, SHUT_RDWR );
+	::unlink ( g_sServicePath.cstr() );
+}
+
+
+bool hotrestart::HandedOver()
+{
+	return g_bHandedOver.load ( std::memory_order_relaxed );
+}
+
+#endif // _WIN32
@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org
+//
+
+#pragma once
+
+#include "std/string.h"
+#include "std/vectraits.h"
+
+struct ListenerDesc_t;
+struct Listener_t;
+
+// hot restart: a new searchd started with --hot-restart takes the listening sockets over from the running one
+// (through a unix socket next to the pid file), and the running one shuts down gracefully right after.
+// The running one keeps serving while the new one loads the tables: it freezes them (as FREEZE does) and lets
+// their locks go, and hands the sockets over only once the new one reports it is ready. Clients that connect
+// after that wait in the listen backlog only for the shutdown and the binlog replay.
+namespace hotrestart
+{
+
+/// new instance, before loading the tables: have the running one release them; false (with sError) if no running instance answered
+bool Prepare ( const CSphString & sPidFile, CSphString & sError );
+
+/// new instance, after loading the tables: report readiness and take the listening sockets over
+bool TakeOver ( CSphString & sError );
+
+/// new instance: inherited socket bound to the same address as tDesc, or -1
+int PopInherited ( const ListenerDesc_t & tDesc );
+
+/// new instance: close inherited sockets that no configured listener took
+void CloseUnused();
+
+/// new instance: wait until the running one releases the pid file, and lock it; if the file we opened was removed
+/// from disk meanwhile, lock a new one at the same path instead (iPidFD is replaced then)
+bool LockPidFile ( int & iPidFD, const CSphString & sPidFile, CSphString & sError );
+
+/// running instance: start answering takeover requests; bLockPlain is whether plain tables are locked (with .spl)
+void StartService ( const CSphString & sPidFile, const VecTraits_T<Listener_t> & dListeners, bool bLockPlain );
+void StopService();
+
+/// running instance: listeners are handed over, and so is the pid file, which must not be removed on shutdown
+bool HandedOver();
+
+/// both halves of the handover over a connected unix socket; declared here to make available for testing
+bool SendListeners ( int iSock, const VecTraits_T<int> & dSocks );
+bool ReceiveListeners ( int iSock, CSphString & sError );	///< received sockets are then taken by PopInherited
+
+} // namespace hotrestart
@@ -394,6 +394,12 @@ static void FormatOption ( const CSphQuery & tQuery, StringBuilder_c & tBuf, con
 		tBuf.Appendf ( "morphology=none" );
 	if ( tQuery.m_iExpansionLimit != DEFAULT_QUERY_EXPANSION_LIMIT )
 		tBuf.Appendf ( "expansion_limit=%d", tQuery.m_iExpansionLimit );
+
+	if ( tQuery.m_bStream )
+		tBuf << "stream=1";
+
+	if ( tQuery.m_bTopKPruning )
+		tBuf << "top_k_pruning=1";
 }
 
 
@@ -1025,6 +1025,7 @@ void SearchHandler_c::RunLocalSearches()
 	std::atomic iTotalSuccesses { 0 };
 	Coro::ExecuteN ( dCtx.Concurrency ( iNumLocals ), [&]
 	{
+		ScopedSearchWorker_c tBusy;
 		auto pSource = pDispatcher->MakeSource();
 		int iJob = -1; // make it consumed
 
@@ -1103,6 +1104,12 @@ void SearchHandler_c::RunLocalSearches()
 				// do the query
 				CSphMultiQueryArgs tMultiArgs ( iIndexWeight );
 				tMultiArgs.m_uPackedFactorFlags = tQueueRes.m_uPackedFactorFlags;
+
+				// the floor that came from the master applies to every local index of this agent
+				std::atomic<int64_t> iTopKFloor { m_dNQueries.First().m_iTopKFloor };
+				if ( iQueries==1 && iTopKFloor.load ( std::memory_order_relaxed )>0 )
+					tMultiArgs.m_pTopKFloor = &iTopKFloor;
+
 				if ( m_bGotLocalDF )
 				{
 					tMultiArgs.m_bLocalDF = true;
@@ -1818,6 +1825,7 @@ bool SearchHandler_c::BuildIndexList ( int & iDivideLimits, VecRefPtrsAgentConn_
 				pConn->SetMultiAgent ( pAgent );
 				pConn->m_iStoreTag = iOrderTag++;
 				pConn->m_iWeight = iWeight;
+				pConn->m_bHedge = true;
 				pConn->m_iMyConnectTimeoutMs = pDist->GetAgentConnectTimeoutMs();
 				pConn->m_iMyQueryTimeoutMs = ( tQuery.m_iAgentQueryTimeoutMs!=DEFAULT_QUERY_TIMEOUT ? tQuery.m_iAgentQueryTimeoutMs : pDist->GetAgentQueryTimeoutMs() );
 				dRemotes.Add ( pConn );
@@ -2036,15 +2044,23 @@ void SearchHandler_c::RunSubset ( int iStart, int iEnd )
 	// main query loop (with multiple retries for distributed)
 	///////////////////////////////////////////////////////////
 
+	// groups' distinct values come from the agents (and local tables) as HLL sketches, which master merges;
+	// merging bare per-agent counts would count the values seen by several agents more than once
+	if ( !dRemotes.IsEmpty() )
+		for ( auto & tQuery : m_dNQueries )
+			tQuery.m_bDistinctSketch |= !tQuery.m_sGroupDistinct.IsEmpty();
+
 	// connect to remote agents and query them, if required
 	std::unique_ptr<SearchRequestBuilder_c> tReqBuilder;
 	CSphRefcountedPtr<RemoteAgentsObserver_i> tReporter { nullptr };
 	std::unique_ptr<ReplyParser_i> tParser;
+	std::unique_ptr<TopKFloors_c> pTopKFloors;
 	if ( !dRemotes.IsEmpty() )
 	{
 		SwitchProfile(m_pProfile, SPH_QSTATE_DIST_CONNECT);
-		tReqBuilder = std::make_unique<SearchRequestBuilder_c> ( m_dNQueries, iDivideLimits );
-		tParser = std::make_unique<SearchReplyParser_c> ( iQueries );
+		pTopKFloors = std::make_unique<TopKFloors_c> ( m_dNQueries );
+		tReqBuilder = std::make_unique<SearchRequestBuilder_c> ( m_dNQueries, iDivideLimits, pTopKFloors.get() );
+		tParser = std::make_unique<SearchReplyParser_c> ( iQueries, pTopKFloors.get() );
 		tReporter = GetObserver();
 
 		// run remote queries. tReporter will tell us when they're finished.
@@ -66,6 +66,7 @@ public:
 	DWORD		GetDword() final;
 	SphOffset_t	GetOffset() final;
 	DWORD		UnzipInt () final;
+	int			UnzipInts ( DWORD * pOut, int iMax ) final;
 	uint64_t	UnzipOffset () final;
 
 	void Reset () final
@@ -156,6 +157,19 @@ DWORD ThinMMapReader_c::UnzipInt()
 }
 
 
+int ThinMMapReader_c::UnzipInts ( DWORD * pOut, int iMax )
+{
+	assert ( iMax>0 );
+	int iDecoded = UnzipIntsBE ( m_pPointer, m_pBase+m_iSize, pOut, iMax );
+	if ( iDecoded )
+		return iDecoded;
+
+	// broken tail; let the range-checking path deal with it
+	pOut[0] = UnzipInt();
+	return 1;
+}
+
+
 uint64_t ThinMMapReader_c::UnzipOffset()
 {
 	return UnzipValueBE<uint64_t> ( [this]() mutable { return GetByte(); } );
@@ -176,8 +190,10 @@ public:
 	DWORD		GetDword () final		{ return FileReader_c::GetDword(); }
 	SphOffset_t	GetOffset() final		{ return FileReader_c::GetOffset(); }
 	DWORD		UnzipInt() final		{ return FileReader_c::UnzipInt(); }
+	int			UnzipInts ( DWORD * pOut, int iMax ) final { return FileReader_c::UnzipInts ( pOut, iMax ); }
 	uint64_t	UnzipOffset() final		{ return FileReader_c::UnzipOffset(); }
 	void		Reset() final			{ FileReader_c::Reset(); }
+	void		Prefetch ( SphOffset_t iPos, int iSizeHint ) final;
 
 protected:
 	explicit DirectFileReader_c ( BYTE * pBuf, int iSize, const char * szFileName )
@@ -186,18 +202,34 @@ protected:
 	{}
 
 	~DirectFileReader_c() final {}
+
+private:
+	int			m_iPrefetchUnhinted = 0;	///< 0 means prefetch is disabled
 };
 
+
+void DirectFileReader_c::Prefetch ( SphOffset_t iPos, int iSizeHint )
+{
+	if ( !m_iPrefetchUnhinted )
+		return;
+
+	// same amount as the first UpdateCache() after SeekTo ( iPos, iSizeHint ) is going to read
+	int iBufSize = GetBufferSize()>0 ? GetBufferSize() : DEFAULT_READ_BUFFER;
+	int iLen = iSizeHint>0 ? iSizeHint : m_iPrefetchUnhinted;
+	sphPrefetch ( GetFD(), iPos, Min ( iLen, iBufSize ) );
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 // producer of readers which access by Seek + Read
 class DirectFactory_c final : public DataReaderFactory_c
 {
 public:
-	DirectFactory_c ( const CSphString & sFile, CSphString & sError, ESphQueryState eState, int iReadBuffer, int iReadUnhinted )
+	DirectFactory_c ( const CSphString & sFile, CSphString & sError, ESphQueryState eState, int iReadBuffer, int iReadUnhinted, bool bPrefetch )
 		: m_eWorkState ( eState )
 		, m_iReadBuffer ( iReadBuffer )
 		, m_iReadUnhinted ( iReadUnhinted )
+		, m_bPrefetch ( bPrefetch )
 	{
 		SetValid ( m_dReader.Open ( sFile, sError ) );
 	}
@@ -233,6 +265,9 @@ public:
 		auto pFileReader = new DirectFileReader_c ( pBuf, iSize, m_dReader.GetFilename().cstr() );
 		pFileReader->SetFile ( m_dReader.GetFD(), m_dReader.GetFilename().cstr() );
 		pFileReader->SetBuffers ( m_iReadBuffer, m_iReadUnhinted );
+		if ( m_bPrefetch )
+			pFileReader->m_iPrefetchUnhinted = m_iReadUnhinted;
+
 		if ( m_iPos )
 			pFileReader->SeekTo ( m_iPos, READ_NO_SIZE_HINT );
 
@@ -255,6 +290,7 @@ private:
 	SphOffset_t		m_iPos = 0;
 	int				m_iReadBuffer = 0;
 	int				m_iReadUnhinted = 0;
+	bool			m_bPrefetch = false;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -321,7 +357,7 @@ DataReaderFactory_c * NewProxyReader ( const CSphString & sFile, CSphString & sE
 	CSphRefcountedPtr<DataReaderFactory_c> pReader;
 
 	if ( eAccess==FileAccess_e::FILE )
-		pReader = new DirectFactory_c ( sFile, sError, eState, iReadBuffer, GetUnhintedBuffer() );
+		pReader = new DirectFactory_c ( sFile, sError, eState, iReadBuffer, GetUnhintedBuffer(), GetReadPrefetch() );
 	else
 		pReader = new MMapFactory_c ( sFile, sError, eAccess );
 
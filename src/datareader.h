@@ -28,10 +28,14 @@ public:
 	virtual DWORD		GetDword() = 0;
 	virtual SphOffset_t	GetOffset() = 0;
 	virtual DWORD		UnzipInt() = 0;
+	virtual int			UnzipInts ( DWORD * pOut, int iMax ) = 0;	///< bulk UnzipInt(); stops right after a zero value, returns number of values (at least 1)
 	virtual uint64_t	UnzipOffset() = 0;
 	virtual RowID_t		UnzipRowid() = 0;
 	virtual SphWordID_t	UnzipWordid() = 0;
 	virtual void		Reset () = 0;
+
+	// hint that the data at iPos will be read soon (iSizeHint as in SeekTo); no-op unless the reader does async prefetch
+	virtual void		Prefetch ( SphOffset_t iPos, int iSizeHint ) {}
 };
 
 
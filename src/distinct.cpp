@@ -26,6 +26,7 @@ UniqHLLTraits_c::Container_t::Container_t ( const Container_t & tRhs )
 	: m_pArray ( tRhs.m_pArray )
 	, m_eType ( tRhs.m_eType )
 	, m_iHashIdx ( tRhs.m_iHashIdx )
+	, m_iCounted ( tRhs.m_iCounted )
 {}
 
 
@@ -34,10 +35,12 @@ UniqHLLTraits_c::Container_t & UniqHLLTraits_c::Container_t::operator = ( Contai
 	m_pArray = std::move ( tRhs.m_pArray );
 	m_eType = std::move ( tRhs.m_eType );
 	m_iHashIdx = std::move ( tRhs.m_iHashIdx );
+	m_iCounted = std::move ( tRhs.m_iCounted );
 
 	tRhs.m_pArray = nullptr;
 	tRhs.m_eType = ContainterType_e::ARRAY;
 	tRhs.m_iHashIdx = 0;
+	tRhs.m_iCounted = 0;
 
 	return *this;
 }
@@ -56,10 +59,10 @@ int UniqHLLTraits_c::Container_t::Estimate() const
 {
 	switch ( m_eType )
 	{
-	case ContainterType_e::ARRAY:				return m_pArray->GetLength();	
-	case ContainterType_e::HASH:				return m_pHash->GetLength();
-	case ContainterType_e::HLL_DENSE_PACKED:	return int( m_pHLLDensePacked->Estimate() );
-	case ContainterType_e::HLL_DENSE_NONPACKED:	return int( m_pHLLDenseNonPacked->Estimate() );
+	case ContainterType_e::ARRAY:				return m_iCounted + ( m_pArray ? m_pArray->GetLength() : 0 );
+	case ContainterType_e::HASH:				return m_iCounted + m_pHash->GetLength();
+	case ContainterType_e::HLL_DENSE_PACKED:	return m_iCounted + int( m_pHLLDensePacked->Estimate() );
+	case ContainterType_e::HLL_DENSE_NONPACKED:	return m_iCounted + int( m_pHLLDenseNonPacked->Estimate() );
 	default:
 		assert ( 0 && "Unknown container type" );
 		return 0;
@@ -77,6 +80,8 @@ void UniqHLLTraits_c::Container_t::Reset()
 	case ContainterType_e::HLL_DENSE_NONPACKED:	SafeDelete ( m_pHLLDenseNonPacked ); break;
 	default: assert ( 0 && "Unknown container type" ); break;
 	}
+
+	m_iCounted = 0;
 }
 
 
@@ -243,6 +248,26 @@ void UniqHLLTraits_c::ConvertToHLLDenseNonPacked ( Container_t & tContainer )
 }
 
 
+void UniqHLLTraits_c::ConvertToHLL ( Container_t & tContainer )
+{
+	if ( tContainer.m_eType==ContainterType_e::ARRAY )
+	{
+		if ( !tContainer.m_pArray )
+			tContainer.m_pArray = AllocateArray();
+
+		ConvertToHash(tContainer);
+	}
+
+	if ( tContainer.m_eType!=ContainterType_e::HASH )
+		return;
+
+	if ( m_iAccuracy > NON_PACKED_HLL_THRESH )
+		ConvertToHLLDensePacked(tContainer);
+	else
+		ConvertToHLLDenseNonPacked(tContainer);
+}
+
+
 void UniqHLLTraits_c::MoveToLargerHash ( Container_t & tContainer )
 {
 	int & iIdx = tContainer.m_iHashIdx;
@@ -315,13 +340,17 @@ UniqHLLTraits_c::Container_t & UniqHLL_c::Get ( SphGroupKey_t tGroup )
 template <typename T>
 void CopyContainerTo ( SphGroupKey_t tGroup, const UniqHLLTraits_c::Container_t & tFrom, T & tRhs )
 {
-	if ( tFrom.IsEmpty() )
+	if ( tFrom.IsEmpty() && !tFrom.m_iCounted )
 		return;
 
 	UniqHLLTraits_c::Container_t & tTo = tRhs.Get ( tGroup );
-	if ( tTo.IsEmpty() )
+	if ( tTo.m_eType==UniqHLLTraits_c::ContainterType_e::ARRAY && !tTo.m_pArray )
 		tTo.m_pArray = tRhs.AllocateArray();
 
+	tTo.m_iCounted += tFrom.m_iCounted;
+	if ( tFrom.IsEmpty() )
+		return;
+
 	if ( tFrom.m_eType==UniqHLLTraits_c::ContainterType_e::ARRAY )
 	{
 		for ( auto i : *tFrom.m_pArray )
@@ -336,28 +365,248 @@ void CopyContainerTo ( SphGroupKey_t tGroup, const UniqHLLTraits_c::Container_t
 
 	} else
 	{
-		if ( tTo.m_eType==UniqHLLTraits_c::ContainterType_e::ARRAY )
-			tRhs.ConvertToHash ( tTo );
+		// both sides have the same accuracy, so the same kind of HLL; registers of an already converted one must be merged too
+		tRhs.ConvertToHLL ( tTo );
+		assert ( tTo.m_eType==tFrom.m_eType );
 
-		if ( tTo.m_eType==UniqHLLTraits_c::ContainterType_e::HASH )
-		{
-			assert ( tRhs.m_iAccuracy==tRhs.m_iAccuracy );
+		if ( tTo.m_eType==UniqHLLTraits_c::ContainterType_e::HLL_DENSE_PACKED )
+			tTo.m_pHLLDensePacked->Merge ( *tFrom.m_pHLLDensePacked );
+		else
+			tTo.m_pHLLDenseNonPacked->Merge ( *tFrom.m_pHLLDenseNonPacked );
+	}
+}
 
-			if ( tRhs.m_iAccuracy > UniqHLLTraits_c::NON_PACKED_HLL_THRESH )
-			{
-				tRhs.ConvertToHLLDensePacked ( tTo );
-				tTo.m_pHLLDensePacked->Merge ( *tFrom.m_pHLLDensePacked );
-			}
-			else
+/////////////////////////////////////////////////////////////////////
+
+enum class SketchType_e : BYTE
+{
+	VALUES,		// DWORD count, then the values
+	SPARSE,		// DWORD count, then ( register<<6 | rank ) of non-empty registers
+	DENSE		// all the registers, 6 bits each
+};
+
+static const int SKETCH_HEADER_SIZE = 2;	// type, accuracy
+static const int REGISTER_BITS = 6;
+static const int MAX_SKETCH_ACCURACY = 18;
+
+struct UniqHLLTraits_c::Sketch_t
+{
+	SketchType_e	m_eType = SketchType_e::VALUES;
+	int				m_iAccuracy = 0;
+	int				m_iCount = 0;
+	const BYTE *	m_pData = nullptr;
+};
+
+
+static BYTE * AddSketchHeader ( CSphVector<BYTE> & dSketch, SketchType_e eType, int iAccuracy, int iPayload )
+{
+	BYTE * pData = dSketch.AddN ( SKETCH_HEADER_SIZE + iPayload );
+	pData[0] = (BYTE)eType;
+	pData[1] = (BYTE)iAccuracy;
+	return pData + SKETCH_HEADER_SIZE;
+}
+
+
+static int GetDenseSketchSize ( int iAccuracy )
+{
+	return ( ( 1 << iAccuracy )*REGISTER_BITS + 7 ) / 8;
+}
+
+
+template <typename HLL>
+static void SaveRegisters ( const HLL & tHLL, CSphVector<BYTE> & dSketch )
+{
+	int iRegisters = tHLL.GetNumRegisters();
+	int iUsed = 0;
+	for ( int i = 0; i < iRegisters; i++ )
+		iUsed += !!tHLL.GetRegister(i);
+
+	int iDenseSize = GetDenseSketchSize ( tHLL.GetAccuracy() );
+	if ( int( sizeof(DWORD) + iUsed*sizeof(DWORD) ) < iDenseSize )
+	{
+		BYTE * pData = AddSketchHeader ( dSketch, SketchType_e::SPARSE, tHLL.GetAccuracy(), sizeof(DWORD) + iUsed*sizeof(DWORD) );
+		sphUnalignedWrite ( pData, (DWORD)iUsed );
+		pData += sizeof(DWORD);
+
+		for ( int i = 0; i < iRegisters; i++ )
+			if ( tHLL.GetRegister(i) )
 			{
-				tRhs.ConvertToHLLDenseNonPacked ( tTo );
-				tTo.m_pHLLDenseNonPacked->Merge ( *tFrom.m_pHLLDenseNonPacked );
+				sphUnalignedWrite ( pData, DWORD ( ( i << REGISTER_BITS ) | tHLL.GetRegister(i) ) );
+				pData += sizeof(DWORD);
 			}
+
+		return;
+	}
+
+	BYTE * pData = AddSketchHeader ( dSketch, SketchType_e::DENSE, tHLL.GetAccuracy(), iDenseSize );
+	memset ( pData, 0, iDenseSize );
+	for ( int i = 0; i < iRegisters; i++ )
+	{
+		int iBit = i*REGISTER_BITS;
+		int iShift = iBit & 7;
+		BYTE uValue = tHLL.GetRegister(i);
+		pData[iBit>>3] |= BYTE ( uValue << iShift );
+		if ( iShift + REGISTER_BITS > 8 )
+			pData[(iBit>>3) + 1] |= BYTE ( uValue >> ( 8-iShift ) );
+	}
+}
+
+
+// sketch registers may be more accurate than ours; they are folded then.
+// The dropped low bits of the register index are the leading bits of the hash part that gives the rank
+template <typename HLL>
+static FORCE_INLINE void MergeRegister ( HLL & tHLL, int iAccuracy, int iRegister, int iRank )
+{
+	if ( !iRank || iRank > 64-iAccuracy+1 )
+		return;
+
+	int iFold = iAccuracy - tHLL.GetAccuracy();
+	if ( iFold )
+	{
+		int iDropped = iRegister & ( ( 1 << iFold ) - 1 );
+		iRegister >>= iFold;
+		iRank = iDropped ? iFold - sphLog2(iDropped) + 1 : iRank + iFold;
+	}
+
+	tHLL.UpdateRegister ( iRegister, (uint8_t)iRank );
+}
+
+
+template <typename HLL>
+static void MergeRegisters ( HLL & tHLL, SketchType_e eType, int iAccuracy, int iCount, const BYTE * pData )
+{
+	if ( eType==SketchType_e::SPARSE )
+	{
+		int iRegisters = 1 << iAccuracy;
+		for ( int i = 0; i < iCount; i++, pData += sizeof(DWORD) )
+		{
+			DWORD uPacked = sphUnalignedRead ( *(const DWORD*)pData );
+			int iRegister = int ( uPacked >> REGISTER_BITS );
+			if ( iRegister < iRegisters )
+				MergeRegister ( tHLL, iAccuracy, iRegister, int ( uPacked & ( ( 1 << REGISTER_BITS ) - 1 ) ) );
 		}
+
+		return;
+	}
+
+	for ( int i = 0; i < iCount; i++ )
+	{
+		int iBit = i*REGISTER_BITS;
+		int iShift = iBit & 7;
+		int iRank = pData[iBit>>3] >> iShift;
+		if ( iShift + REGISTER_BITS > 8 )
+			iRank |= pData[(iBit>>3) + 1] << ( 8-iShift );
+
+		MergeRegister ( tHLL, iAccuracy, i, iRank & ( ( 1 << REGISTER_BITS ) - 1 ) );
+	}
+}
+
+
+void UniqHLLTraits_c::SaveContainer ( const Container_t & tContainer, CSphVector<BYTE> & dSketch ) const
+{
+	dSketch.Resize(0);
+
+	auto SaveValues = [&dSketch, this] ( int iCount )
+	{
+		BYTE * pData = AddSketchHeader ( dSketch, SketchType_e::VALUES, m_iAccuracy, sizeof(DWORD) + iCount*sizeof(SphAttr_t) );
+		sphUnalignedWrite ( pData, (DWORD)iCount );
+		return (SphAttr_t *)( pData + sizeof(DWORD) );
+	};
+
+	switch ( tContainer.m_eType )
+	{
+	case ContainterType_e::ARRAY:
+	{
+		int iCount = tContainer.m_pArray ? tContainer.m_pArray->GetLength() : 0;
+		SphAttr_t * pValues = SaveValues ( iCount );
+		for ( int i = 0; i < iCount; i++ )
+			sphUnalignedWrite ( pValues++, (*tContainer.m_pArray)[i] );
+	}
+	break;
+
+	case ContainterType_e::HASH:
+	{
+		SphAttr_t * pValues = SaveValues ( tContainer.m_pHash->GetLength() );
+		int64_t i = 0;
+		SphAttr_t * pRes;
+		while ( ( pRes = tContainer.m_pHash->Iterate(i) ) != nullptr )
+			sphUnalignedWrite ( pValues++, *pRes );
+	}
+	break;
+
+	case ContainterType_e::HLL_DENSE_PACKED:	SaveRegisters ( *tContainer.m_pHLLDensePacked, dSketch ); break;
+	case ContainterType_e::HLL_DENSE_NONPACKED:	SaveRegisters ( *tContainer.m_pHLLDenseNonPacked, dSketch ); break;
+	default: assert ( 0 && "Unknown container type" ); break;
 	}
 }
 
 
+bool UniqHLLTraits_c::ParseSketch ( ByteBlob_t tSketch, Sketch_t & tParsed ) const
+{
+	if ( !tSketch.first || tSketch.second<SKETCH_HEADER_SIZE )
+		return false;
+
+	tParsed.m_eType = (SketchType_e)tSketch.first[0];
+	tParsed.m_iAccuracy = tSketch.first[1];
+	tParsed.m_pData = tSketch.first + SKETCH_HEADER_SIZE;
+	int iPayload = tSketch.second - SKETCH_HEADER_SIZE;
+
+	if ( tParsed.m_eType==SketchType_e::DENSE )
+	{
+		// registers can only be folded to a less accurate HLL, not vice versa
+		if ( tParsed.m_iAccuracy<m_iAccuracy || tParsed.m_iAccuracy>MAX_SKETCH_ACCURACY )
+			return false;
+
+		tParsed.m_iCount = 1 << tParsed.m_iAccuracy;
+		return iPayload==GetDenseSketchSize ( tParsed.m_iAccuracy );
+	}
+
+	if ( iPayload<(int)sizeof(DWORD) )
+		return false;
+
+	tParsed.m_iCount = (int)sphUnalignedRead ( *(const DWORD*)tParsed.m_pData );
+	tParsed.m_pData += sizeof(DWORD);
+	iPayload -= sizeof(DWORD);
+
+	switch ( tParsed.m_eType )
+	{
+	case SketchType_e::VALUES:
+		return tParsed.m_iCount>=0 && (int64_t)tParsed.m_iCount*sizeof(SphAttr_t)==(uint64_t)iPayload;
+
+	case SketchType_e::SPARSE:
+		if ( tParsed.m_iAccuracy<m_iAccuracy || tParsed.m_iAccuracy>MAX_SKETCH_ACCURACY )
+			return false;
+
+		return tParsed.m_iCount>=0 && (int64_t)tParsed.m_iCount*sizeof(DWORD)==(uint64_t)iPayload;
+
+	default:
+		return false;
+	}
+}
+
+
+void UniqHLLTraits_c::MergeContainer ( Container_t & tContainer, const Sketch_t & tSketch )
+{
+	if ( tContainer.m_eType==ContainterType_e::ARRAY && !tContainer.m_pArray )
+		tContainer.m_pArray = AllocateArray();
+
+	if ( tSketch.m_eType==SketchType_e::VALUES )
+	{
+		auto pValues = (const SphAttr_t *)tSketch.m_pData;
+		for ( int i = 0; i < tSketch.m_iCount; i++ )
+			AddToContainer ( tContainer, sphUnalignedRead ( pValues[i] ) );
+
+		return;
+	}
+
+	ConvertToHLL ( tContainer );
+	if ( tContainer.m_eType==ContainterType_e::HLL_DENSE_PACKED )
+		MergeRegisters ( *tContainer.m_pHLLDensePacked, tSketch.m_eType, tSketch.m_iAccuracy, tSketch.m_iCount, tSketch.m_pData );
+	else
+		MergeRegisters ( *tContainer.m_pHLLDenseNonPacked, tSketch.m_eType, tSketch.m_iAccuracy, tSketch.m_iCount, tSketch.m_pData );
+}
+
+
 /////////////////////////////////////////////////////////////////////
 UniqHLL_c &	UniqHLL_c::operator = ( UniqHLL_c && tRhs )
 {
@@ -389,6 +638,43 @@ int UniqHLL_c::CountNext ( SphGroupKey_t & tOutGroup )
 }
 
 
+void UniqHLL_c::SaveSketch ( SphGroupKey_t tGroup, CSphVector<BYTE> & dSketch ) const
+{
+	const Container_t * pContainer = m_hGroups.Find ( tGroup );
+	if ( pContainer )
+		SaveContainer ( *pContainer, dSketch );
+	else
+		dSketch.Resize(0);
+}
+
+
+bool UniqHLL_c::MergeSketch ( SphGroupKey_t tGroup, ByteBlob_t tSketch )
+{
+	Sketch_t tParsed;
+	if ( !ParseSketch ( tSketch, tParsed ) )
+		return false;
+
+	// an empty group would end the counting (zero count means 'no more groups' there)
+	if ( tParsed.m_iCount )
+		MergeContainer ( Get ( tGroup ), tParsed );
+
+	return true;
+}
+
+
+void UniqHLL_c::AddCount ( SphGroupKey_t tGroup, int iCount )
+{
+	if ( !iCount )
+		return;
+
+	Container_t & tContainer = Get ( tGroup );
+	if ( tContainer.m_eType==ContainterType_e::ARRAY && !tContainer.m_pArray )
+		tContainer.m_pArray = AllocateArray();
+
+	tContainer.m_iCounted += iCount;
+}
+
+
 void UniqHLL_c::Compact ( VecTraits_T<SphGroupKey_t> & dRemoveGroups )
 {
 	for ( auto i : dRemoveGroups )
@@ -441,6 +727,17 @@ void UniqHLLSingle_c::CopyTo ( UniqHLLSingle_c & tRhs ) const
 }
 
 
+bool UniqHLLSingle_c::MergeSketch ( SphGroupKey_t, ByteBlob_t tSketch )
+{
+	Sketch_t tParsed;
+	if ( !ParseSketch ( tSketch, tParsed ) )
+		return false;
+
+	MergeContainer ( m_tContainer, tParsed );
+	return true;
+}
+
+
 void UniqHLLSingle_c::Reset()
 {
 	m_tContainer.Reset();
@@ -388,6 +388,7 @@ protected:
 
 		ContainterType_e	m_eType = ContainterType_e::ARRAY;
 		int					m_iHashIdx = 0;
+		int					m_iCounted = 0;		///< added up counts of the rows that came without a sketch
 
 							Container_t() = default;
 							Container_t ( const Container_t & tRhs );
@@ -442,6 +443,14 @@ protected:
 	void			ConvertToHash ( Container_t & tContainer );
 	void			ConvertToHLLDensePacked ( Container_t & tContainer );
 	void			ConvertToHLLDenseNonPacked ( Container_t & tContainer );
+	void			ConvertToHLL ( Container_t & tContainer );
+
+	// sketches carry the distinct values of a group from agents to master: either the values themselves
+	// (while the group is still exact), or the HLL registers (sparse or dense, whichever is shorter)
+	struct Sketch_t;
+	void			SaveContainer ( const Container_t & tContainer, CSphVector<BYTE> & dSketch ) const;
+	bool			ParseSketch ( ByteBlob_t tSketch, Sketch_t & tParsed ) const;	///< false if malformed, or registers are less accurate than ours
+	void			MergeContainer ( Container_t & tContainer, const Sketch_t & tSketch );
 
 private:
 	CSphVector<SmallArray_c *>			m_dUnusedArray;
@@ -477,6 +486,9 @@ public:
 	void			Reset();
 	void			CopyTo ( UniqHLL_c & tRhs ) const;
 	Container_t &	Get ( SphGroupKey_t tGroup );
+	void			SaveSketch ( SphGroupKey_t tGroup, CSphVector<BYTE> & dSketch ) const;
+	bool			MergeSketch ( SphGroupKey_t tGroup, ByteBlob_t tSketch );
+	void			AddCount ( SphGroupKey_t tGroup, int iCount );
 
 private:
 	OpenHashTable_T<SphGroupKey_t, Container_t> m_hGroups;
@@ -514,6 +526,9 @@ public:
 	void		CopyTo ( UniqHLLSingle_c & tRhs ) const;
 	void		Reset();
 	Container_t & Get ( SphGroupKey_t tGroup ) { return m_tContainer; }
+	void		SaveSketch ( SphGroupKey_t, CSphVector<BYTE> & dSketch ) const { SaveContainer ( m_tContainer, dSketch ); }
+	bool		MergeSketch ( SphGroupKey_t tGroup, ByteBlob_t tSketch );
+	void		AddCount ( SphGroupKey_t, int iCount ) { m_tContainer.m_iCounted += iCount; }
 
 private:
 	Container_t	m_tContainer;
@@ -859,6 +859,48 @@ void LookupReader_c::SetData ( const BYTE * pData )
 
 //////////////////////////////////////////////////////////////////////////
 
+void DocidLookupFilter_c::Build ( const BYTE * pLookupData )
+{
+	LookupReader_c tReader ( pLookupData );
+	if ( tReader.IsEmpty() )
+		return;
+
+	DWORD nDocs = *(const DWORD*)pLookupData;
+	m_dBlocks.Reset ( Max ( ( (int64_t)nDocs*BITS_PER_DOC+63 )/64, (int64_t)1 ) );
+	m_dBlocks.ZeroVec();
+
+	LookupReaderIterator_c tLookup ( pLookupData );
+	DocID_t tDocID;
+	while ( tLookup.ReadDocID ( tDocID ) )
+	{
+		uint64_t uHash = Hash ( tDocID );
+		m_dBlocks[GetBlock(uHash)] |= GetMask ( uHash );
+	}
+}
+
+
+VecTraits_T<DocID_t> ClipKillList ( const VecTraits_T<DocID_t> & dKlist, const LookupReader_c & tLookup, const DocidLookupFilter_c * pFilter )
+{
+	if ( tLookup.IsEmpty() || dKlist.IsEmpty() )
+		return {};
+
+	auto uMin = (uint64_t)tLookup.GetMinDocID();
+	auto uMax = (uint64_t)tLookup.GetMaxDocID();
+	if ( (uint64_t)dKlist.Last()<uMin || (uint64_t)dKlist.First()>uMax )
+		return {};
+
+	DocID_t * pStart = std::lower_bound ( dKlist.Begin(), dKlist.End(), uMin, [] ( DocID_t a, uint64_t b ) { return (uint64_t)a<b; } );
+	DocID_t * pEnd = std::upper_bound ( pStart, dKlist.End(), uMax, [] ( uint64_t a, DocID_t b ) { return a<(uint64_t)b; } );
+
+	VecTraits_T<DocID_t> dClipped ( pStart, pEnd-pStart );
+	if ( pFilter && !dClipped.any_of ( [pFilter] ( DocID_t tDocID ) { return pFilter->MayContain(tDocID); } ) )
+		return {};
+
+	return dClipped;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 LookupReaderIterator_c::LookupReaderIterator_c ( const BYTE * pData )
 {
 	SetData(pData);
@@ -53,6 +53,46 @@ private:
 };
 
 
+/// first checkpoint in [pStart,pEnd] with base docid >= uDocID, or pEnd if there's none
+/// docids are usually spread evenly, so a few interpolation probes narrow the range before falling back to bisection
+inline const DocidLookupCheckpoint_t * FindFirstCheckpointGE ( const DocidLookupCheckpoint_t * pStart, const DocidLookupCheckpoint_t * pEnd, uint64_t uDocID )
+{
+	if ( (uint64_t)pStart->m_tBaseDocID>=uDocID )
+		return pStart;
+
+	if ( (uint64_t)pEnd->m_tBaseDocID<uDocID )
+		return pEnd;
+
+	// invariant: pLo->m_tBaseDocID < uDocID <= pHi->m_tBaseDocID
+	const DocidLookupCheckpoint_t * pLo = pStart;
+	const DocidLookupCheckpoint_t * pHi = pEnd;
+	const int MAX_INTERPOLATION_PROBES = 3;
+	for ( int iProbe = 0; iProbe<MAX_INTERPOLATION_PROBES && pHi-pLo>1; ++iProbe )
+	{
+		auto uLo = (uint64_t)pLo->m_tBaseDocID;
+		auto uHi = (uint64_t)pHi->m_tBaseDocID;
+		auto iSpan = int64_t ( pHi-pLo );
+		auto iOff = int64_t ( double ( uDocID-uLo ) / double ( uHi-uLo ) * iSpan );
+		const DocidLookupCheckpoint_t * pMid = pLo + Max ( Min ( iOff, iSpan-1 ), (int64_t)1 );
+		if ( (uint64_t)pMid->m_tBaseDocID<uDocID )
+			pLo = pMid;
+		else
+			pHi = pMid;
+	}
+
+	while ( pHi-pLo>1 )
+	{
+		const DocidLookupCheckpoint_t * pMid = pLo + ( pHi-pLo )/2;
+		if ( (uint64_t)pMid->m_tBaseDocID<uDocID )
+			pLo = pMid;
+		else
+			pHi = pMid;
+	}
+
+	return pHi;
+}
+
+
 class LookupReader_c
 {
 public:
@@ -62,6 +102,10 @@ public:
 
 	void	SetData ( const BYTE * pData );
 
+	inline bool		IsEmpty() const			{ return !m_pCheckpoints || !m_nCheckpoints; }
+	inline DocID_t	GetMinDocID() const		{ return m_pCheckpoints->m_tBaseDocID; }
+	inline DocID_t	GetMaxDocID() const		{ return m_tMaxDocID; }
+
 	inline RowID_t Find ( DocID_t tDocID ) const
 	{
 		if ( !m_pCheckpoints || (uint64_t)tDocID<(uint64_t)m_pCheckpoints->m_tBaseDocID || (uint64_t)tDocID>(uint64_t)m_tMaxDocID )
@@ -113,7 +157,7 @@ protected:
 			return nullptr;
 
 		const DocidLookupCheckpoint_t * pEnd = m_pCheckpoints+m_nCheckpoints-1;
-		const DocidLookupCheckpoint_t * pFound = sphBinarySearchFirst ( pStart, pEnd, []( const DocidLookupCheckpoint_t & i ){ return (uint64_t)i.m_tBaseDocID; }, (uint64_t)tDocID );
+		const DocidLookupCheckpoint_t * pFound = FindFirstCheckpointGE ( pStart, pEnd, (uint64_t)tDocID );
 		assert ( pFound );
 
 		if ( (uint64_t)pFound->m_tBaseDocID>(uint64_t)tDocID )
@@ -242,6 +286,54 @@ private:
 };
 
 
+/// blocked bloom filter over the docids of a lookup, lets point lookups and kill lists skip the chunks that surely don't have the docid
+/// it is built in memory from the lookup itself (~10 bits per doc), the lookup file format stays the same
+class DocidLookupFilter_c
+{
+public:
+	void		Build ( const BYTE * pLookupData );
+	bool		IsEmpty() const { return m_dBlocks.IsEmpty(); }
+	int64_t		GetLengthBytes() const { return m_dBlocks.GetLengthBytes64(); }
+
+	inline bool MayContain ( DocID_t tDocID ) const
+	{
+		uint64_t uHash = Hash ( tDocID );
+		uint64_t uMask = GetMask ( uHash );
+		return ( m_dBlocks[GetBlock(uHash)] & uMask )==uMask;
+	}
+
+private:
+	static constexpr int BITS_PER_DOC = 10;
+
+	CSphFixedVector<uint64_t>	m_dBlocks {0};
+
+	static inline uint64_t Hash ( DocID_t tDocID )
+	{
+		// splitmix64 finalizer
+		auto uHash = (uint64_t)tDocID;
+		uHash = ( uHash ^ ( uHash>>30 ) ) * 0xbf58476d1ce4e5b9ULL;
+		uHash = ( uHash ^ ( uHash>>27 ) ) * 0x94d049bb133111ebULL;
+		return uHash ^ ( uHash>>31 );
+	}
+
+	// 4 bits inside one 64-bit block, picked by the low 24 bits of the hash
+	static inline uint64_t GetMask ( uint64_t uHash )
+	{
+		return ( 1ULL << ( uHash & 63 ) ) | ( 1ULL << ( ( uHash>>6 ) & 63 ) ) | ( 1ULL << ( ( uHash>>12 ) & 63 ) ) | ( 1ULL << ( ( uHash>>18 ) & 63 ) );
+	}
+
+	// block is picked by the high 32 bits of the hash
+	inline int64_t GetBlock ( uint64_t uHash ) const
+	{
+		return int64_t ( ( ( uHash>>32 ) * (uint64_t)m_dBlocks.GetLength() ) >> 32 );
+	}
+};
+
+
+/// narrow a sorted kill list to the part that might be in the lookup (by its docid range, and by the filter, if any)
+/// empty result means that none of the docids can be there, so there's no need to walk the lookup at all
+VecTraits_T<DocID_t> ClipKillList ( const VecTraits_T<DocID_t> & dKlist, const LookupReader_c & tLookup, const DocidLookupFilter_c * pFilter );
+
 RowIteratorsWithEstimates_t CreateLookupIterator ( CSphVector<SecondaryIndexInfo_t> & dSIInfo, const CSphVector<CSphFilterSettings> & dFilters, const BYTE * pDocidLookup, uint32_t uTotalDocs );
 bool	WriteDocidLookup ( const CSphString & sFilename, const VecTraits_T<DocidRowidPair_t> & dLookup, CSphString & sError );
 
@@ -20,6 +20,12 @@
 #include "lz4/lz4hc.h"
 #include "sphinxint.h"
 
+#if WITH_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#include "sphinxutils.h"
+#endif
+
 
 enum BlockFlags_e : BYTE
 {
@@ -46,7 +52,8 @@ enum FieldFlags_e : BYTE
 	FIELD_FLAG_EMPTY		= 1 << 1
 };
 
-static const int STORAGE_VERSION = 1;
+static const int STORAGE_VERSION = 2;		// v.2 adds zstd dictionary after the block header
+static const int STORAGE_VERSION_NO_DICT = 1;	// docstores without a dictionary are still written as v.1, so that older binaries can read them
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -57,6 +64,7 @@ static BYTE Compression2Byte ( Compression_e eComp )
 	case Compression_e::NONE:	return 0;
 	case Compression_e::LZ4:	return 1;
 	case Compression_e::LZ4HC:	return 2;
+	case Compression_e::ZSTD:	return 3;
 	default:
 		assert ( 0 && "Unknown compression type" );
 		return 0;
@@ -71,6 +79,7 @@ static Compression_e Byte2Compression ( BYTE uComp )
 	case 0:		return Compression_e::NONE;
 	case 1:		return Compression_e::LZ4;
 	case 2:		return Compression_e::LZ4HC;
+	case 3:		return Compression_e::ZSTD;
 	default:
 		assert ( 0 && "Unknown compression type" );
 		return Compression_e::NONE;
@@ -100,16 +109,6 @@ static void PackData ( CSphVector<BYTE> & dDst, const BYTE * pData, DWORD uSize,
 
 
 //////////////////////////////////////////////////////////////////////////
-class Compressor_i
-{
-public:
-	virtual			~Compressor_i(){}
-
-	virtual bool	Compress ( const VecTraits_T<BYTE> & dUncompressed, CSphVector<BYTE> & dCompressed ) const = 0;
-	virtual bool	Decompress ( const VecTraits_T<BYTE> & dCompressed, VecTraits_T<BYTE> & dDecompressed ) const = 0;
-};
-
-
 class Compressor_None_c : public Compressor_i
 {
 public:
@@ -184,16 +183,222 @@ int	Compressor_LZ4HC_c::DoCompression ( const VecTraits_T<BYTE> & dUncompressed,
 }
 
 
+#if WITH_ZSTD
+
+#if DL_ZSTD
+
+static decltype ( &ZSTD_createCCtx ) sph_ZSTD_createCCtx = nullptr;
+static decltype ( &ZSTD_freeCCtx ) sph_ZSTD_freeCCtx = nullptr;
+static decltype ( &ZSTD_createDCtx ) sph_ZSTD_createDCtx = nullptr;
+static decltype ( &ZSTD_freeDCtx ) sph_ZSTD_freeDCtx = nullptr;
+static decltype ( &ZSTD_compressBound ) sph_ZSTD_compressBound = nullptr;
+static decltype ( &ZSTD_compressCCtx ) sph_ZSTD_compressCCtx = nullptr;
+static decltype ( &ZSTD_decompressDCtx ) sph_ZSTD_decompressDCtx = nullptr;
+static decltype ( &ZSTD_isError ) sph_ZSTD_isError = nullptr;
+static decltype ( &ZSTD_createCDict ) sph_ZSTD_createCDict = nullptr;
+static decltype ( &ZSTD_freeCDict ) sph_ZSTD_freeCDict = nullptr;
+static decltype ( &ZSTD_createDDict ) sph_ZSTD_createDDict = nullptr;
+static decltype ( &ZSTD_freeDDict ) sph_ZSTD_freeDDict = nullptr;
+static decltype ( &ZSTD_compress_usingCDict ) sph_ZSTD_compress_usingCDict = nullptr;
+static decltype ( &ZSTD_decompress_usingDDict ) sph_ZSTD_decompress_usingDDict = nullptr;
+static decltype ( &ZDICT_trainFromBuffer ) sph_ZDICT_trainFromBuffer = nullptr;
+static decltype ( &ZDICT_isError ) sph_ZDICT_isError = nullptr;
+
+static bool InitDynamicZstd()
+{
+	const char * sFuncs[] = { "ZSTD_createCCtx", "ZSTD_freeCCtx", "ZSTD_createDCtx", "ZSTD_freeDCtx", "ZSTD_compressBound", "ZSTD_compressCCtx",
+		"ZSTD_decompressDCtx", "ZSTD_isError", "ZSTD_createCDict", "ZSTD_freeCDict", "ZSTD_createDDict", "ZSTD_freeDDict",
+		"ZSTD_compress_usingCDict", "ZSTD_decompress_usingDDict", "ZDICT_trainFromBuffer", "ZDICT_isError" };
+	void ** pFuncs[] = { (void**)&sph_ZSTD_createCCtx, (void**)&sph_ZSTD_freeCCtx, (void**)&sph_ZSTD_createDCtx, (void**)&sph_ZSTD_freeDCtx,
+		(void**)&sph_ZSTD_compressBound, (void**)&sph_ZSTD_compressCCtx, (void**)&sph_ZSTD_decompressDCtx, (void**)&sph_ZSTD_isError,
+		(void**)&sph_ZSTD_createCDict, (void**)&sph_ZSTD_freeCDict, (void**)&sph_ZSTD_createDDict, (void**)&sph_ZSTD_freeDDict,
+		(void**)&sph_ZSTD_compress_usingCDict, (void**)&sph_ZSTD_decompress_usingDDict, (void**)&sph_ZDICT_trainFromBuffer, (void**)&sph_ZDICT_isError };
+
+	static CSphDynamicLibrary dLib ( ZSTD_LIB );
+	static bool bLoaded = dLib.LoadSymbols ( sFuncs, pFuncs, sizeof ( pFuncs ) / sizeof ( void** ) );
+	return bLoaded;
+}
+
+#else
+
+#define sph_ZSTD_createCCtx ZSTD_createCCtx
+#define sph_ZSTD_freeCCtx ZSTD_freeCCtx
+#define sph_ZSTD_createDCtx ZSTD_createDCtx
+#define sph_ZSTD_freeDCtx ZSTD_freeDCtx
+#define sph_ZSTD_compressBound ZSTD_compressBound
+#define sph_ZSTD_compressCCtx ZSTD_compressCCtx
+#define sph_ZSTD_decompressDCtx ZSTD_decompressDCtx
+#define sph_ZSTD_isError ZSTD_isError
+#define sph_ZSTD_createCDict ZSTD_createCDict
+#define sph_ZSTD_freeCDict ZSTD_freeCDict
+#define sph_ZSTD_createDDict ZSTD_createDDict
+#define sph_ZSTD_freeDDict ZSTD_freeDDict
+#define sph_ZSTD_compress_usingCDict ZSTD_compress_usingCDict
+#define sph_ZSTD_decompress_usingDDict ZSTD_decompress_usingDDict
+#define sph_ZDICT_trainFromBuffer ZDICT_trainFromBuffer
+#define sph_ZDICT_isError ZDICT_isError
+#define InitDynamicZstd() ( true )
+
+#endif
+
+class Compressor_Zstd_c : public Compressor_i
+{
+public:
+	explicit		Compressor_Zstd_c ( int iCompressionLevel ) : m_iCompressionLevel ( iCompressionLevel ) {}
+					~Compressor_Zstd_c() override;
+
+	bool			Compress ( const VecTraits_T<BYTE> & dUncompressed, CSphVector<BYTE> & dCompressed ) const final;
+	bool			Decompress ( const VecTraits_T<BYTE> & dCompressed, VecTraits_T<BYTE> & dDecompressed ) const final;
+
+	bool			UsesDictionary() const final { return true; }
+	bool			TrainDictionary ( const VecTraits_T<BYTE> & dSamples, const VecTraits_T<size_t> & dSampleSizes, CSphVector<BYTE> & dDict ) const final;
+	bool			SetDictionary ( const VecTraits_T<BYTE> & dDict, bool bCompress ) final;
+
+private:
+	int				m_iCompressionLevel = DEFAULT_COMPRESSION_LEVEL;
+	ZSTD_CDict *	m_pCDict = nullptr;
+	ZSTD_DDict *	m_pDDict = nullptr;		// immutable once loaded, so it is shared by all reader threads
+
+	static ZSTD_CCtx * GetThreadCCtx();
+	static ZSTD_DCtx * GetThreadDCtx();
+};
+
+
+Compressor_Zstd_c::~Compressor_Zstd_c()
+{
+	if ( m_pCDict )
+		sph_ZSTD_freeCDict ( m_pCDict );
+
+	if ( m_pDDict )
+		sph_ZSTD_freeDDict ( m_pDDict );
+}
+
+
+// contexts only hold scratch state, so one per thread serves every compressor (builders, api codecs) without locking
+ZSTD_CCtx * Compressor_Zstd_c::GetThreadCCtx()
+{
+	struct CCtxFree_t { void operator() ( ZSTD_CCtx * pCtx ) const { sph_ZSTD_freeCCtx ( pCtx ); } };
+	static thread_local std::unique_ptr<ZSTD_CCtx, CCtxFree_t> pCCtx { sph_ZSTD_createCCtx() };
+	return pCCtx.get();
+}
+
+
+ZSTD_DCtx * Compressor_Zstd_c::GetThreadDCtx()
+{
+	struct DCtxFree_t { void operator() ( ZSTD_DCtx * pCtx ) const { sph_ZSTD_freeDCtx ( pCtx ); } };
+	static thread_local std::unique_ptr<ZSTD_DCtx, DCtxFree_t> pDCtx { sph_ZSTD_createDCtx() };
+	return pDCtx.get();
+}
+
+
+bool Compressor_Zstd_c::Compress ( const VecTraits_T<BYTE> & dUncompressed, CSphVector<BYTE> & dCompressed ) const
+{
+	// with a dictionary even short data compresses well
+	const int MIN_COMPRESSIBLE_SIZE = 16;
+	if ( dUncompressed.GetLength() < MIN_COMPRESSIBLE_SIZE )
+		return false;
+
+	ZSTD_CCtx * pCCtx = GetThreadCCtx();
+	if ( !pCCtx )
+		return false;
+
+	dCompressed.Resize ( (int)sph_ZSTD_compressBound ( dUncompressed.GetLength() ) );
+	size_t uCompressedSize;
+	if ( m_pCDict )
+		uCompressedSize = sph_ZSTD_compress_usingCDict ( pCCtx, dCompressed.Begin(), dCompressed.GetLength(), dUncompressed.Begin(), dUncompressed.GetLength(), m_pCDict );
+	else
+		uCompressedSize = sph_ZSTD_compressCCtx ( pCCtx, dCompressed.Begin(), dCompressed.GetLength(), dUncompressed.Begin(), dUncompressed.GetLength(), m_iCompressionLevel );
+
+	const float WORST_COMPRESSION_RATIO = 0.95f;
+	if ( sph_ZSTD_isError ( uCompressedSize ) || float(uCompressedSize)/dUncompressed.GetLength() > WORST_COMPRESSION_RATIO )
+		return false;
+
+	dCompressed.Resize ( (int)uCompressedSize );
+	return true;
+}
+
+
+bool Compressor_Zstd_c::Decompress ( const VecTraits_T<BYTE> & dCompressed, VecTraits_T<BYTE> & dDecompressed ) const
+{
+	ZSTD_DCtx * pDCtx = GetThreadDCtx();
+	if ( !pDCtx )
+		return false;
+
+	size_t uRes;
+	if ( m_pDDict )
+		uRes = sph_ZSTD_decompress_usingDDict ( pDCtx, dDecompressed.Begin(), dDecompressed.GetLength(), dCompressed.Begin(), dCompressed.GetLength(), m_pDDict );
+	else
+		uRes = sph_ZSTD_decompressDCtx ( pDCtx, dDecompressed.Begin(), dDecompressed.GetLength(), dCompressed.Begin(), dCompressed.GetLength() );
+
+	return !sph_ZSTD_isError ( uRes ) && uRes==(size_t)dDecompressed.GetLength();
+}
+
+
+bool Compressor_Zstd_c::TrainDictionary ( const VecTraits_T<BYTE> & dSamples, const VecTraits_T<size_t> & dSampleSizes, CSphVector<BYTE> & dDict ) const
+{
+	const int MAX_DICT_SIZE = 65536;
+	dDict.Resize ( Min ( MAX_DICT_SIZE, dSamples.GetLength() ) );
+	size_t uDictSize = sph_ZDICT_trainFromBuffer ( dDict.Begin(), dDict.GetLength(), dSamples.Begin(), dSampleSizes.Begin(), dSampleSizes.GetLength() );
+	if ( sph_ZDICT_isError ( uDictSize ) )
+	{
+		// not enough (or too uniform) samples; go on without a dictionary
+		dDict.Resize(0);
+		return false;
+	}
+
+	dDict.Resize ( (int)uDictSize );
+	return true;
+}
+
+
+bool Compressor_Zstd_c::SetDictionary ( const VecTraits_T<BYTE> & dDict, bool bCompress )
+{
+	if ( dDict.IsEmpty() )
+		return true;
+
+	if ( bCompress )
+	{
+		m_pCDict = sph_ZSTD_createCDict ( dDict.Begin(), dDict.GetLength(), m_iCompressionLevel );
+		if ( !m_pCDict )
+			return false;
+	}
+
+	m_pDDict = sph_ZSTD_createDDict ( dDict.Begin(), dDict.GetLength() );
+	return !!m_pDDict;
+}
+
+#endif // WITH_ZSTD
+
+
 std::unique_ptr<Compressor_i> CreateCompressor ( Compression_e eComp, int iCompressionLevel )
 {
 	switch (  eComp )
 	{
 		case Compression_e::LZ4:	return std::make_unique<Compressor_LZ4_c>();
 		case Compression_e::LZ4HC:	return std::make_unique<Compressor_LZ4HC_c> ( iCompressionLevel );
+#if WITH_ZSTD
+		case Compression_e::ZSTD:	return InitDynamicZstd() ? std::make_unique<Compressor_Zstd_c> ( iCompressionLevel ) : nullptr;
+#else
+		case Compression_e::ZSTD:	return nullptr;
+#endif
 		default:					return std::make_unique<Compressor_None_c>();
 	}
 }
 
+
+static bool LoadCompressorDictionary ( CSphReader & tReader, Compressor_i & tCompressor )
+{
+	if ( !tCompressor.UsesDictionary() )
+		return true;
+
+	CSphFixedVector<BYTE> dDict ( tReader.UnzipInt() );
+	tReader.GetBytes ( dDict.Begin(), dDict.GetLength() );
+	if ( tReader.GetErrorFlag() )
+		return false;
+
+	return tCompressor.SetDictionary ( dDict, false );
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 static CSphString BuildCompoundName ( const CSphString & sName, DocstoreDataType_e eType )
@@ -603,7 +808,10 @@ bool Docstore_c::Init ( CSphString & sError )
 
 	m_pCompressor = CreateCompressor ( m_eCompression, m_iCompressionLevel );
 	if ( !m_pCompressor )
+	{
+		sError.SetSprintf ( "Unable to load docstore: %s uses %s compression, which is not available", m_sFilename.cstr(), CompressionToStr(m_eCompression).cstr() );
 		return false;
+	}
 
 	m_tFields.Load(tReader);
 
@@ -635,6 +843,13 @@ bool Docstore_c::Init ( CSphString & sError )
 
 	m_dBlocks.Last().m_uSize = tHeaderOffset-m_dBlocks.Last().m_tOffset;
 
+	// the dictionary is loaded once here and reused by all reads (cached blocks are stored already decompressed)
+	if ( uStorageVersion>=2 && !LoadCompressorDictionary ( tReader, *m_pCompressor ) )
+	{
+		sError.SetSprintf ( "Unable to load docstore compression dictionary from %s", m_sFilename.cstr() );
+		return false;
+	}
+
 	if ( tReader.GetErrorFlag() )
 		return false;
 
@@ -1004,6 +1219,12 @@ private:
 		CSphVector<CSphVector<BYTE>>	m_dFields;
 	};
 
+	struct PendingBlock_t
+	{
+		CSphVector<StoredDoc_t>	m_dDocs;
+		DWORD					m_uStoredLen = 0;
+	};
+
 	CSphString				m_sFilename;
 	CSphVector<StoredDoc_t>	m_dStoredDocs;
 	CSphVector<BYTE>		m_dHeader;
@@ -1023,9 +1244,17 @@ private:
 	CSphVector<SortedField_t>		m_dFieldSort;
 	CSphVector<CSphVector<BYTE>>	m_dCompressedBuffers;
 
+	// compressors with a shared dictionary need samples first, so blocks are held back until the dictionary is trained
+	bool							m_bCollectSamples = false;
+	CSphVector<PendingBlock_t>		m_dPendingBlocks;
+	DWORD							m_uPendingLen = 0;
+	CSphVector<BYTE>				m_dDict;
+
 	void	WriteInitialHeader();
 	void	WriteTrailingHeader();
 	void	WriteBlock();
+	void	FlushBlock();
+	void	TrainDictionary();
 	void	WriteSmallBlockHeader ( SphOffset_t tBlockOffset );
 	void	WriteBigBlockHeader ( SphOffset_t tBlockOffset, SphOffset_t tHeaderSize );
 	void	WriteSmallBlock();
@@ -1046,8 +1275,12 @@ bool DocstoreBuilder_c::Init ( CSphString & sError )
 {
 	m_pCompressor = CreateCompressor ( m_eCompression, m_iCompressionLevel );
 	if ( !m_pCompressor )
+	{
+		sError.SetSprintf ( "%s compression is not available", CompressionToStr(m_eCompression).cstr() );
 		return false;
+	}
 
+	m_bCollectSamples = m_pCompressor->UsesDictionary();
 	m_tWriter.SetBufferSize(m_iBufferSize);
 	return m_tWriter.OpenFile ( m_sFilename, sError );
 }
@@ -1086,13 +1319,52 @@ void DocstoreBuilder_c::AddDoc ( RowID_t tRowID, const Doc_t & tDoc )
 void DocstoreBuilder_c::Finalize()
 {
 	WriteBlock();
+	if ( m_bCollectSamples )
+		TrainDictionary();
+
 	WriteTrailingHeader();
 }
 
 
+void DocstoreBuilder_c::TrainDictionary()
+{
+	assert ( m_bCollectSamples );
+
+	// every stored field is a separate sample
+	CSphVector<BYTE> dSamples;
+	CSphVector<size_t> dSampleSizes;
+	dSamples.Reserve(m_uPendingLen);
+	for ( const auto & tBlock : m_dPendingBlocks )
+		for ( const auto & tDoc : tBlock.m_dDocs )
+			for ( const auto & dField : tDoc.m_dFields )
+				if ( dField.GetLength() )
+				{
+					dSamples.Append(dField);
+					dSampleSizes.Add ( dField.GetLength() );
+				}
+
+	if ( m_pCompressor->TrainDictionary ( dSamples, dSampleSizes, m_dDict ) )
+		m_pCompressor->SetDictionary ( m_dDict, true );
+
+	m_bCollectSamples = false;
+
+	CSphVector<PendingBlock_t> dPending;
+	dPending.SwapData(m_dPendingBlocks);
+	m_uPendingLen = 0;
+
+	for ( auto & tBlock : dPending )
+	{
+		m_dStoredDocs.SwapData ( tBlock.m_dDocs );
+		m_uStoredLen = tBlock.m_uStoredLen;
+		FlushBlock();
+	}
+}
+
+
 void DocstoreBuilder_c::WriteInitialHeader()
 {
-	m_tWriter.PutDword ( STORAGE_VERSION );
+	// bumped to v.2 on finalize, when the dictionary is written
+	m_tWriter.PutDword ( STORAGE_VERSION_NO_DICT );
 	m_tWriter.PutDword ( m_uBlockSize );
 	m_tWriter.PutByte ( Compression2Byte(m_eCompression) );
 	m_tFields.Save(m_tWriter);
@@ -1114,11 +1386,26 @@ void DocstoreBuilder_c::WriteTrailingHeader()
 	// write header
 	m_tWriter.PutBytes ( m_dHeader.Begin(), m_dHeader.GetLength() );
 
+	// no dictionary (other compressors, or too few samples to train one) means no need for v.2
+	bool bDict = m_pCompressor->UsesDictionary() && !m_dDict.IsEmpty();
+	if ( bDict )
+	{
+		m_tWriter.ZipInt ( m_dDict.GetLength() );
+		m_tWriter.PutBytes ( m_dDict.Begin(), m_dDict.GetLength() );
+	}
+
 	// rewind to the beginning, store num_blocks, offset to header
 	m_tWriter.Flush();	// flush is necessary, see similar code in BlobRowBuilder_File_c::Done
 	m_tWriter.SeekTo(m_tHeaderOffset); 
 	m_tWriter.PutDword(m_iNumBlocks);
 	m_tWriter.PutOffset(tHeaderPos);
+
+	if ( bDict )
+	{
+		m_tWriter.SeekTo(0);
+		m_tWriter.PutDword ( STORAGE_VERSION );
+	}
+
 	m_tWriter.CloseFile();
 }
 
@@ -1302,6 +1589,27 @@ void DocstoreBuilder_c::WriteBlock()
 	if ( !m_dStoredDocs.GetLength() )
 		return;
 
+	if ( m_bCollectSamples )
+	{
+		PendingBlock_t & tPending = m_dPendingBlocks.Add();
+		tPending.m_dDocs.SwapData(m_dStoredDocs);
+		tPending.m_uStoredLen = m_uStoredLen;
+		m_uPendingLen += m_uStoredLen;
+		m_uStoredLen = 0;
+
+		const DWORD DICT_SAMPLE_SIZE = 4*1024*1024;
+		if ( m_uPendingLen>=DICT_SAMPLE_SIZE )
+			TrainDictionary();
+
+		return;
+	}
+
+	FlushBlock();
+}
+
+
+void DocstoreBuilder_c::FlushBlock()
+{
 	bool bBigBlock = m_dStoredDocs.GetLength()==1 && m_uStoredLen>=m_uBlockSize;
 
 	if ( bBigBlock )
@@ -1630,7 +1938,7 @@ bool DocstoreChecker_c::Check()
 
 	m_tReader.GetDword();	// block size
 	BYTE uCompression = m_tReader.GetByte();
-	if ( uCompression > 2 )
+	if ( uCompression > 3 )
 		return m_tReporter.Fail ( "Unknown docstore compression %u in %s", uCompression, m_szFilename );
 
 	Compression_e eCompression = Byte2Compression(uCompression);
@@ -1712,6 +2020,9 @@ bool DocstoreChecker_c::Check()
 	if ( dBlocks.GetLength() )
 		dBlocks.Last().m_uSize = tHeaderOffset-dBlocks.Last().m_tOffset;
 
+	if ( uStorageVersion>=2 && !LoadCompressorDictionary ( m_tReader, *m_pCompressor ) )
+		return m_tReporter.Fail ( "Unable to load docstore compression dictionary in %s", m_szFilename );
+
 	for ( auto & i : dBlocks )
 	{
 		if ( i.m_tOffset+i.m_uSize > m_tReader.GetFilesize() )
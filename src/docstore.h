@@ -117,6 +117,27 @@ private:
 };
 
 
+// block compressor; also used for compressed frames of the binary API between master and agents
+class Compressor_i
+{
+public:
+	virtual			~Compressor_i(){}
+
+	/// false if the data is too short or doesn't compress well enough; then it should be stored as is
+	virtual bool	Compress ( const VecTraits_T<BYTE> & dUncompressed, CSphVector<BYTE> & dCompressed ) const = 0;
+	virtual bool	Decompress ( const VecTraits_T<BYTE> & dCompressed, VecTraits_T<BYTE> & dDecompressed ) const = 0;
+
+	// shared dictionary support; only compressors which return true from UsesDictionary() care
+	// readers only decompress, so they pass bCompress=false and skip building the compression dictionary
+	virtual bool	UsesDictionary() const { return false; }
+	virtual bool	TrainDictionary ( const VecTraits_T<BYTE> & dSamples, const VecTraits_T<size_t> & dSampleSizes, CSphVector<BYTE> & dDict ) const { return false; }
+	virtual bool	SetDictionary ( const VecTraits_T<BYTE> & dDict, bool bCompress ) { return true; }
+};
+
+/// nullptr if the codec is not available (zstd library not loaded)
+std::unique_ptr<Compressor_i>		CreateCompressor ( Compression_e eComp, int iCompressionLevel );
+
+
 std::unique_ptr<Docstore_i>			CreateDocstore ( int64_t iIndexId, const CSphString & sFilename, CSphString & sError );
 std::unique_ptr<DocstoreBuilder_i>	CreateDocstoreBuilder ( const CSphString & sFilename, const DocstoreSettings_t & tSettings, int iBufferSize, CSphString & sError );
 std::unique_ptr<DocstoreRT_i>		CreateDocstoreRT();
@@ -0,0 +1,288 @@
+//
+// Copyright (c) 2017-2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include "exprsimd.h"
+#include "std/sys.h"
+
+#include <cmath>
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+	#include <immintrin.h>
+	#define EXPR_SIMD 1
+#else
+	#define EXPR_SIMD 0
+#endif
+
+#if EXPR_SIMD
+
+// AVX2 kernels are built into the same binary and only called when the CPU reports AVX2
+#if defined( __GNUC__ ) || defined( __clang__ )
+	#define TARGET_AVX2 __attribute__ ( ( target ( "avx2" ) ) )
+#else
+	#define TARGET_AVX2
+#endif
+
+// scalar EQ/NE compare fabs(a-b) against 1e-6 in doubles; this is the largest float that compares the same way
+static float GetEqEps()
+{
+	float fEps = (float)1e-6;
+	if ( (double)fEps>1e-6 )
+		fEps = std::nextafter ( fEps, 0.0f );
+
+	return fEps;
+}
+
+static const float g_fEqEps = GetEqEps();
+
+// the loops leave 'i' at the first unprocessed value, and return it
+#define BINARY_LOOP(_width,_load,_store,_expr) \
+	for ( ; i+_width<=iLen; i+=_width ) \
+	{ \
+		auto a = _load ( pA+i ); \
+		auto b = _load ( pB+i ); \
+		_store ( pA+i, _expr ); \
+	} \
+	return i;
+
+#define UNARY_LOOP(_width,_load,_store,_expr) \
+	for ( ; i+_width<=iLen; i+=_width ) \
+	{ \
+		auto a = _load ( pA+i ); \
+		_store ( pA+i, _expr ); \
+	} \
+	return i;
+
+#define LOAD128(_ptr)			_mm_loadu_si128 ( (const __m128i *)( _ptr ) )
+#define STORE128(_ptr,_val)		_mm_storeu_si128 ( (__m128i *)( _ptr ), _val )
+#define LOAD256(_ptr)			_mm256_loadu_si256 ( (const __m256i *)( _ptr ) )
+#define STORE256(_ptr,_val)		_mm256_storeu_si256 ( (__m256i *)( _ptr ), _val )
+
+//////////////////////////////////////////////////////////////////////////
+// SSE2
+
+static int ApplySSE2 ( ExprSimdOp_e eOp, float * pA, const float * pB, int iLen )
+{
+	const __m128 tZero = _mm_setzero_ps();
+	const __m128 tOne = _mm_set1_ps ( 1.0f );
+	const __m128 tSign = _mm_set1_ps ( -0.0f );
+	const __m128 tEps = _mm_set1_ps ( g_fEqEps );
+
+	int i = 0;
+	switch ( eOp )
+	{
+	case ExprSimdOp_e::ADD:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps ( a, b ) );
+	case ExprSimdOp_e::SUB:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_sub_ps ( a, b ) );
+	case ExprSimdOp_e::MUL:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps ( a, b ) );
+	case ExprSimdOp_e::DIV:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_div_ps ( a, b ), _mm_cmpneq_ps ( b, tZero ) ) );
+	case ExprSimdOp_e::MIN:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_min_ps ( a, b ) );	// a<b ? a : b
+	case ExprSimdOp_e::MAX:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_max_ps ( b, a ) );	// b>a ? b : a
+	case ExprSimdOp_e::LT:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_cmplt_ps ( a, b ), tOne ) );
+	case ExprSimdOp_e::GT:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_cmpgt_ps ( a, b ), tOne ) );
+	case ExprSimdOp_e::LTE:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_cmple_ps ( a, b ), tOne ) );
+	case ExprSimdOp_e::GTE:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_cmpge_ps ( a, b ), tOne ) );
+	case ExprSimdOp_e::EQ:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_cmple_ps ( _mm_andnot_ps ( tSign, _mm_sub_ps ( a, b ) ), tEps ), tOne ) );
+	case ExprSimdOp_e::NE:	BINARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_cmpgt_ps ( _mm_andnot_ps ( tSign, _mm_sub_ps ( a, b ) ), tEps ), tOne ) );
+	case ExprSimdOp_e::NEG:	UNARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_xor_ps ( a, tSign ) );
+	case ExprSimdOp_e::ABS:	UNARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_andnot_ps ( tSign, a ) );
+	case ExprSimdOp_e::SQRT:UNARY_LOOP ( 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps ( _mm_sqrt_ps ( a ), _mm_cmpgt_ps ( a, tZero ) ) );
+	default:				return 0;
+	}
+}
+
+// SSE2 has no 32-bit low multiply, so multiply even and odd lanes into 64 bits and take the low halves
+static inline __m128i MulLo32SSE2 ( __m128i a, __m128i b )
+{
+	__m128i tEven = _mm_mul_epu32 ( a, b );
+	__m128i tOdd = _mm_mul_epu32 ( _mm_srli_si128 ( a, 4 ), _mm_srli_si128 ( b, 4 ) );
+	return _mm_unpacklo_epi32 ( _mm_shuffle_epi32 ( tEven, _MM_SHUFFLE ( 0, 0, 2, 0 ) ), _mm_shuffle_epi32 ( tOdd, _MM_SHUFFLE ( 0, 0, 2, 0 ) ) );
+}
+
+// picks a where the mask is set, b elsewhere
+static inline __m128i Select128 ( __m128i tMask, __m128i a, __m128i b )
+{
+	return _mm_or_si128 ( _mm_and_si128 ( tMask, a ), _mm_andnot_si128 ( tMask, b ) );
+}
+
+static inline __m128i Abs32SSE2 ( __m128i a )
+{
+	__m128i tSign = _mm_srai_epi32 ( a, 31 );
+	return _mm_sub_epi32 ( _mm_xor_si128 ( a, tSign ), tSign );
+}
+
+static int ApplySSE2 ( ExprSimdOp_e eOp, int * pA, const int * pB, int iLen )
+{
+	const __m128i tZero = _mm_setzero_si128();
+	const __m128i tOne = _mm_set1_epi32 ( 1 );
+
+	int i = 0;
+	switch ( eOp )
+	{
+	case ExprSimdOp_e::ADD:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_add_epi32 ( a, b ) );
+	case ExprSimdOp_e::SUB:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_sub_epi32 ( a, b ) );
+	case ExprSimdOp_e::MUL:	BINARY_LOOP ( 4, LOAD128, STORE128, MulLo32SSE2 ( a, b ) );
+	case ExprSimdOp_e::MIN:	BINARY_LOOP ( 4, LOAD128, STORE128, Select128 ( _mm_cmplt_epi32 ( a, b ), a, b ) );
+	case ExprSimdOp_e::MAX:	BINARY_LOOP ( 4, LOAD128, STORE128, Select128 ( _mm_cmplt_epi32 ( a, b ), b, a ) );
+	case ExprSimdOp_e::LT:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_and_si128 ( _mm_cmplt_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::GT:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_and_si128 ( _mm_cmpgt_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::LTE:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_andnot_si128 ( _mm_cmpgt_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::GTE:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_andnot_si128 ( _mm_cmplt_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::EQ:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_and_si128 ( _mm_cmpeq_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::NE:	BINARY_LOOP ( 4, LOAD128, STORE128, _mm_andnot_si128 ( _mm_cmpeq_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::NEG:	UNARY_LOOP ( 4, LOAD128, STORE128, _mm_sub_epi32 ( tZero, a ) );
+	case ExprSimdOp_e::ABS:	UNARY_LOOP ( 4, LOAD128, STORE128, Abs32SSE2 ( a ) );
+	default:				return 0;
+	}
+}
+
+// SSE2 has no 64-bit compares or multiplies; those are left to AVX2 or the scalar loop
+static int ApplySSE2 ( ExprSimdOp_e eOp, int64_t * pA, const int64_t * pB, int iLen )
+{
+	const __m128i tZero = _mm_setzero_si128();
+
+	int i = 0;
+	switch ( eOp )
+	{
+	case ExprSimdOp_e::ADD:	BINARY_LOOP ( 2, LOAD128, STORE128, _mm_add_epi64 ( a, b ) );
+	case ExprSimdOp_e::SUB:	BINARY_LOOP ( 2, LOAD128, STORE128, _mm_sub_epi64 ( a, b ) );
+	case ExprSimdOp_e::NEG:	UNARY_LOOP ( 2, LOAD128, STORE128, _mm_sub_epi64 ( tZero, a ) );
+	default:				return 0;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AVX2
+
+TARGET_AVX2 static int ApplyAVX2 ( ExprSimdOp_e eOp, float * pA, const float * pB, int iLen )
+{
+	const __m256 tZero = _mm256_setzero_ps();
+	const __m256 tOne = _mm256_set1_ps ( 1.0f );
+	const __m256 tSign = _mm256_set1_ps ( -0.0f );
+	const __m256 tEps = _mm256_set1_ps ( g_fEqEps );
+
+	int i = 0;
+	switch ( eOp )
+	{
+	case ExprSimdOp_e::ADD:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps ( a, b ) );
+	case ExprSimdOp_e::SUB:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sub_ps ( a, b ) );
+	case ExprSimdOp_e::MUL:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps ( a, b ) );
+	case ExprSimdOp_e::DIV:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_div_ps ( a, b ), _mm256_cmp_ps ( b, tZero, _CMP_NEQ_UQ ) ) );
+	case ExprSimdOp_e::MIN:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_min_ps ( a, b ) );
+	case ExprSimdOp_e::MAX:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_max_ps ( b, a ) );
+	case ExprSimdOp_e::LT:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_cmp_ps ( a, b, _CMP_LT_OQ ), tOne ) );
+	case ExprSimdOp_e::GT:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_cmp_ps ( a, b, _CMP_GT_OQ ), tOne ) );
+	case ExprSimdOp_e::LTE:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_cmp_ps ( a, b, _CMP_LE_OQ ), tOne ) );
+	case ExprSimdOp_e::GTE:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_cmp_ps ( a, b, _CMP_GE_OQ ), tOne ) );
+	case ExprSimdOp_e::EQ:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_cmp_ps ( _mm256_andnot_ps ( tSign, _mm256_sub_ps ( a, b ) ), tEps, _CMP_LE_OQ ), tOne ) );
+	case ExprSimdOp_e::NE:	BINARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_cmp_ps ( _mm256_andnot_ps ( tSign, _mm256_sub_ps ( a, b ) ), tEps, _CMP_GT_OQ ), tOne ) );
+	case ExprSimdOp_e::NEG:	UNARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_xor_ps ( a, tSign ) );
+	case ExprSimdOp_e::ABS:	UNARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_andnot_ps ( tSign, a ) );
+	case ExprSimdOp_e::SQRT:UNARY_LOOP ( 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps ( _mm256_sqrt_ps ( a ), _mm256_cmp_ps ( a, tZero, _CMP_GT_OQ ) ) );
+	default:				return 0;
+	}
+}
+
+TARGET_AVX2 static int ApplyAVX2 ( ExprSimdOp_e eOp, int * pA, const int * pB, int iLen )
+{
+	const __m256i tZero = _mm256_setzero_si256();
+	const __m256i tOne = _mm256_set1_epi32 ( 1 );
+
+	int i = 0;
+	switch ( eOp )
+	{
+	case ExprSimdOp_e::ADD:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_add_epi32 ( a, b ) );
+	case ExprSimdOp_e::SUB:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_sub_epi32 ( a, b ) );
+	case ExprSimdOp_e::MUL:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_mullo_epi32 ( a, b ) );
+	case ExprSimdOp_e::MIN:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_min_epi32 ( a, b ) );
+	case ExprSimdOp_e::MAX:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_max_epi32 ( a, b ) );
+	case ExprSimdOp_e::LT:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_and_si256 ( _mm256_cmpgt_epi32 ( b, a ), tOne ) );
+	case ExprSimdOp_e::GT:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_and_si256 ( _mm256_cmpgt_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::LTE:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_andnot_si256 ( _mm256_cmpgt_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::GTE:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_andnot_si256 ( _mm256_cmpgt_epi32 ( b, a ), tOne ) );
+	case ExprSimdOp_e::EQ:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_and_si256 ( _mm256_cmpeq_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::NE:	BINARY_LOOP ( 8, LOAD256, STORE256, _mm256_andnot_si256 ( _mm256_cmpeq_epi32 ( a, b ), tOne ) );
+	case ExprSimdOp_e::NEG:	UNARY_LOOP ( 8, LOAD256, STORE256, _mm256_sub_epi32 ( tZero, a ) );
+	case ExprSimdOp_e::ABS:	UNARY_LOOP ( 8, LOAD256, STORE256, _mm256_abs_epi32 ( a ) );
+	default:				return 0;
+	}
+}
+
+TARGET_AVX2 static inline __m256i Abs64AVX2 ( __m256i a )
+{
+	__m256i tSign = _mm256_cmpgt_epi64 ( _mm256_setzero_si256(), a );
+	return _mm256_sub_epi64 ( _mm256_xor_si256 ( a, tSign ), tSign );
+}
+
+TARGET_AVX2 static int ApplyAVX2 ( ExprSimdOp_e eOp, int64_t * pA, const int64_t * pB, int iLen )
+{
+	const __m256i tZero = _mm256_setzero_si256();
+	const __m256i tOne = _mm256_set1_epi64x ( 1 );
+
+	int i = 0;
+	switch ( eOp )
+	{
+	case ExprSimdOp_e::ADD:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_add_epi64 ( a, b ) );
+	case ExprSimdOp_e::SUB:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_sub_epi64 ( a, b ) );
+	case ExprSimdOp_e::MIN:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_blendv_epi8 ( b, a, _mm256_cmpgt_epi64 ( b, a ) ) );
+	case ExprSimdOp_e::MAX:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_blendv_epi8 ( a, b, _mm256_cmpgt_epi64 ( b, a ) ) );
+	case ExprSimdOp_e::LT:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_and_si256 ( _mm256_cmpgt_epi64 ( b, a ), tOne ) );
+	case ExprSimdOp_e::GT:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_and_si256 ( _mm256_cmpgt_epi64 ( a, b ), tOne ) );
+	case ExprSimdOp_e::LTE:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_andnot_si256 ( _mm256_cmpgt_epi64 ( a, b ), tOne ) );
+	case ExprSimdOp_e::GTE:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_andnot_si256 ( _mm256_cmpgt_epi64 ( b, a ), tOne ) );
+	case ExprSimdOp_e::EQ:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_and_si256 ( _mm256_cmpeq_epi64 ( a, b ), tOne ) );
+	case ExprSimdOp_e::NE:	BINARY_LOOP ( 4, LOAD256, STORE256, _mm256_andnot_si256 ( _mm256_cmpeq_epi64 ( a, b ), tOne ) );
+	case ExprSimdOp_e::NEG:	UNARY_LOOP ( 4, LOAD256, STORE256, _mm256_sub_epi64 ( tZero, a ) );
+	case ExprSimdOp_e::ABS:	UNARY_LOOP ( 4, LOAD256, STORE256, Abs64AVX2 ( a ) );
+	default:				return 0;
+	}
+}
+
+#undef BINARY_LOOP
+#undef UNARY_LOOP
+#undef LOAD128
+#undef STORE128
+#undef LOAD256
+#undef STORE256
+
+// AVX2 takes the full 256-bit lanes, then SSE2 takes what's left of 128-bit ones
+template<typename T>
+static int ApplySIMD ( ExprSimdOp_e eOp, T * pA, const T * pB, int iLen )
+{
+	static const bool bAVX2 = IsAVX2Supported();
+	int iDone = bAVX2 ? ApplyAVX2 ( eOp, pA, pB, iLen ) : 0;
+	return iDone + ApplySSE2 ( eOp, pA+iDone, pB ? pB+iDone : nullptr, iLen-iDone );
+}
+
+#else
+
+template<typename T>
+static int ApplySIMD ( ExprSimdOp_e, T *, const T *, int )
+{
+	return 0;
+}
+
+#endif // EXPR_SIMD
+
+
+int ExprSimdApply ( ExprSimdOp_e eOp, float * pA, const float * pB, int iLen )
+{
+	return ApplySIMD ( eOp, pA, pB, iLen );
+}
+
+
+int ExprSimdApply ( ExprSimdOp_e eOp, int * pA, const int * pB, int iLen )
+{
+	return ApplySIMD ( eOp, pA, pB, iLen );
+}
+
+
+int ExprSimdApply ( ExprSimdOp_e eOp, int64_t * pA, const int64_t * pB, int iLen )
+{
+	return ApplySIMD ( eOp, pA, pB, iLen );
+}
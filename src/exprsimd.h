@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2017-2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#pragma once
+
+#include <cstdint>
+
+/// element-wise ops that batched expression nodes apply over the columns of their evaluated args
+enum class ExprSimdOp_e
+{
+	NONE,		///< no native path, the node applies its op in a scalar loop
+	ADD,
+	SUB,
+	MUL,
+	DIV,		///< b!=0 ? a/b : 0
+	MIN,
+	MAX,
+	LT,			///< comparisons yield 1 or 0 of the arg type
+	GT,
+	LTE,
+	GTE,
+	EQ,			///< floats are equal if they differ by 1e-6 or less
+	NE,
+	NEG,		///< unary ops ignore the second arg
+	ABS,
+	SQRT		///< a>0 ? sqrt(a) : 0
+};
+
+/// applies eOp in place (pA[i] = pA[i] op pB[i]) over the leading values of a column using SSE2, or AVX2 when the CPU has it
+/// returns how many leading values were processed; the caller applies its scalar op to the rest
+/// ops and types that have no native path (and all of them on non-x86 builds) return 0
+int ExprSimdApply ( ExprSimdOp_e eOp, float * pA, const float * pB, int iLen );
+int ExprSimdApply ( ExprSimdOp_e eOp, int * pA, const int * pB, int iLen );
+int ExprSimdApply ( ExprSimdOp_e eOp, int64_t * pA, const int64_t * pB, int iLen );
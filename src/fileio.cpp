@@ -489,6 +489,22 @@ uint64_t CSphReader::UnzipOffset()
 }
 #endif
 
+int CSphReader::UnzipInts ( DWORD * pOut, int iMax )
+{
+	assert ( iMax>0 );
+	const BYTE * pStart = m_pBuff + m_iBuffPos;
+	const BYTE * p = pStart;
+	int iDecoded = UnzipIntsBE ( p, m_pBuff + m_iBuffUsed, pOut, iMax );
+	m_iBuffPos += int ( p-pStart );
+	if ( iDecoded )
+		return iDecoded;
+
+	// buffer is empty, or the value crosses its end
+	pOut[0] = UnzipInt();
+	return 1;
+}
+
+
 CSphReader & CSphReader::operator = ( const CSphReader & rhs )
 {
 	SetFile ( rhs.m_iFD, rhs.m_sFilename.cstr() );
@@ -1116,3 +1132,19 @@ int sphPread ( int iFD, void * pBuf, int iBytes, SphOffset_t iOffset )
 
 #endif // HAVE_PREAD
 #endif // _WIN32
+
+
+void sphPrefetch ( int iFD, SphOffset_t iOffset, int iBytes )
+{
+	if ( iFD<0 || iBytes<=0 )
+		return;
+
+#if defined(POSIX_FADV_WILLNEED)
+	// initiates readahead of the range and returns, so the reads of several ranges overlap
+	::posix_fadvise ( iFD, iOffset, iBytes, POSIX_FADV_WILLNEED );
+
+	CSphIOStats * pIOStats = GetIOStats();
+	if ( pIOStats )
+		pIOStats->m_iPrefetchOps++;
+#endif
+}
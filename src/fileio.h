@@ -86,6 +86,7 @@ public:
 	bool		Tag ( const char * sTag );
 
 	DWORD		UnzipInt ();
+	int			UnzipInts ( DWORD * pOut, int iMax );	///< decode up to iMax values, stop right after a zero; returns number of values
 	uint64_t	UnzipOffset ();
 
 	bool					GetErrorFlag () const		{ return m_bError; }
@@ -270,6 +271,9 @@ bool SeekAndWarn ( int iFD, SphOffset_t iPos, const char * szWarnPrefix );
 // atomic seek+read wrapper
 int sphPread ( int iFD, void * pBuf, int iBytes, SphOffset_t iOffset );
 
+// ask the OS to start reading the range in background; doesn't wait for the data (no-op where not supported)
+void sphPrefetch ( int iFD, SphOffset_t iOffset, int iBytes );
+
 /// set throttling options
 void sphSetThrottling ( int iMaxIOps, int iMaxIOSize );
 
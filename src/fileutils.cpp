@@ -61,6 +61,7 @@ void CSphIOStats::Add ( const CSphIOStats & b )
 	m_iWriteTime += b.m_iWriteTime;
 	m_iWriteOps += b.m_iWriteOps;
 	m_iWriteBytes += b.m_iWriteBytes;
+	m_iPrefetchOps += b.m_iPrefetchOps;
 }
 
 void SafeClose ( int& iFD )
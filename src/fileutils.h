@@ -54,6 +54,7 @@ public:
 	int64_t		m_iWriteTime = 0;
 	DWORD		m_iWriteOps = 0;
 	int64_t		m_iWriteBytes = 0;
+	DWORD		m_iPrefetchOps = 0;		///< readahead hints issued (they don't read anything themselves)
 
 				~CSphIOStats();
 
@@ -193,7 +193,8 @@ void FrontendSchemaBuilder_c::AddAttrs()
 			// when you perform 'select a from index order by b', the 'b' is not displayed, but need for sorting,
 			// so extra-schema in the case will contain 'b').
 			// bMagic condition added for @groupbystr in the agent mode
-			if ( !bAdded && m_bAgent && ( m_hExtraColumns[tCol.m_sName] || !m_bHaveLocals || bMagic ) )
+			// distinct sketches are sent to the master, but never shown to the clients
+			if ( !bAdded && m_bAgent && ( m_hExtraColumns[tCol.m_sName] || !m_bHaveLocals || bMagic || tCol.m_sName==GetDistinctSketchAttrName() ) )
 			{
 				CSphColumnInfo & t = m_dFrontend.Add();
 				t.m_iIndex = iCol;
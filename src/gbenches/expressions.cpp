@@ -68,6 +68,9 @@ public:
 		tMatch.m_iWeight = 456;
 		tMatch.m_pStatic = pRow;
 		tExprArgs.m_pAttrType = &uType;
+
+		for ( int i = 0; i < MAX_EXPR_BATCH; i++ )
+			dMatches[i] = &tMatch;
 	}
 
 	void TearDown ( const ::benchmark::State& state ) override
@@ -79,6 +82,9 @@ public:
 	CSphSchema tSchema;
 	CSphRowitem* pRow = nullptr;
 	CSphMatch tMatch;
+	const CSphMatch* dMatches[MAX_EXPR_BATCH];
+	float dFloats[MAX_EXPR_BATCH];
+	int dInts[MAX_EXPR_BATCH];
 	ESphAttr uType;
 	CSphString sError;
 	ExprParseArgs_t tExprArgs;
@@ -125,7 +131,68 @@ BENCHMARK_DEFINE_F ( BM_expressions, natives )
 	st.SetLabel ( dBench[NBENCH].m_sExpr );
 }
 
+// same expressions over a block of matches; per-match calls vs one batch call
+BENCHMARK_DEFINE_F ( BM_expressions, floats_loop )
+( benchmark::State& st )
+{
+	ISphExprRefPtr_c pExpr ( sphExprParse ( dBench[NBENCH].m_sExpr, tSchema, sError, tExprArgs ) );
+	for ( auto _ : st )
+	{
+		for ( int i = 0; i < MAX_EXPR_BATCH; i++ )
+			dFloats[i] = pExpr->Eval ( *dMatches[i] );
+		benchmark::DoNotOptimize ( dFloats );
+	}
+	st.SetItemsProcessed ( st.iterations() * MAX_EXPR_BATCH );
+	st.SetLabel ( dBench[NBENCH].m_sExpr );
+}
+
+BENCHMARK_DEFINE_F ( BM_expressions, floats_batch )
+( benchmark::State& st )
+{
+	ISphExprRefPtr_c pExpr ( sphExprParse ( dBench[NBENCH].m_sExpr, tSchema, sError, tExprArgs ) );
+	VecTraits_T<const CSphMatch*> dBatch ( dMatches, MAX_EXPR_BATCH );
+	for ( auto _ : st )
+	{
+		pExpr->EvalBatch ( dBatch, dFloats );
+		benchmark::DoNotOptimize ( dFloats );
+	}
+	st.SetItemsProcessed ( st.iterations() * MAX_EXPR_BATCH );
+	st.SetLabel ( dBench[NBENCH].m_sExpr );
+}
+
+BENCHMARK_DEFINE_F ( BM_expressions, ints_loop )
+( benchmark::State& st )
+{
+	ISphExprRefPtr_c pExpr ( sphExprParse ( dBench[NBENCH].m_sExpr, tSchema, sError, tExprArgs ) );
+	for ( auto _ : st )
+	{
+		for ( int i = 0; i < MAX_EXPR_BATCH; i++ )
+			dInts[i] = pExpr->IntEval ( *dMatches[i] );
+		benchmark::DoNotOptimize ( dInts );
+	}
+	st.SetItemsProcessed ( st.iterations() * MAX_EXPR_BATCH );
+	st.SetLabel ( dBench[NBENCH].m_sExpr );
+}
+
+BENCHMARK_DEFINE_F ( BM_expressions, ints_batch )
+( benchmark::State& st )
+{
+	ISphExprRefPtr_c pExpr ( sphExprParse ( dBench[NBENCH].m_sExpr, tSchema, sError, tExprArgs ) );
+	VecTraits_T<const CSphMatch*> dBatch ( dMatches, MAX_EXPR_BATCH );
+	for ( auto _ : st )
+	{
+		pExpr->IntEvalBatch ( dBatch, dInts );
+		benchmark::DoNotOptimize ( dInts );
+	}
+	st.SetItemsProcessed ( st.iterations() * MAX_EXPR_BATCH );
+	st.SetLabel ( dBench[NBENCH].m_sExpr );
+}
+
 BENCHMARK_REGISTER_F ( BM_expressions, floats )->DenseRange ( 0, 2, 1 );
 BENCHMARK_REGISTER_F ( BM_expressions, ints )->Arg ( 0 ); // the only integer here
 //BENCHMARK_REGISTER_F ( BM_expressions, floats )->DenseRange ( 0, 2, 1 );
 BENCHMARK_REGISTER_F ( BM_expressions, natives )->DenseRange ( 0, 2, 1 );
+BENCHMARK_REGISTER_F ( BM_expressions, floats_loop )->DenseRange ( 0, 2, 1 );
+BENCHMARK_REGISTER_F ( BM_expressions, floats_batch )->DenseRange ( 0, 2, 1 );
+BENCHMARK_REGISTER_F ( BM_expressions, ints_loop )->Arg ( 0 );
+BENCHMARK_REGISTER_F ( BM_expressions, ints_batch )->Arg ( 0 );
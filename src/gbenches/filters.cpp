@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2017-2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org
+//
+
+#include <benchmark/benchmark.h>
+
+#include "sphinxfilter.h"
+#include "match.h"
+
+// full-scan like workload: 3 attr filters (range, range, IN) over plain rows, ~10% of rows pass
+class FilterRows_c : public benchmark::Fixture
+{
+public:
+	static const int NUM_ROWS = 65536;
+
+	void SetUp ( const ::benchmark::State & ) override
+	{
+		m_tSchema.AddAttr ( CSphColumnInfo ( "gid", SPH_ATTR_INTEGER ), false );
+		m_tSchema.AddAttr ( CSphColumnInfo ( "price", SPH_ATTR_INTEGER ), false );
+		m_tSchema.AddAttr ( CSphColumnInfo ( "ts", SPH_ATTR_BIGINT ), false );
+
+		m_iStride = m_tSchema.GetRowSize();
+		m_dRows.Reset ( NUM_ROWS*m_iStride );
+		m_dRows.ZeroVec();
+
+		srand ( 0 );
+		for ( int i = 0; i < NUM_ROWS; ++i )
+		{
+			CSphRowitem * pRow = m_dRows.Begin() + i*m_iStride;
+			sphSetRowAttr ( pRow, m_tSchema.GetAttr("gid")->m_tLocator, rand() % 100 ); // NOLINT
+			sphSetRowAttr ( pRow, m_tSchema.GetAttr("price")->m_tLocator, rand() % 1000 ); // NOLINT
+			sphSetRowAttr ( pRow, m_tSchema.GetAttr("ts")->m_tLocator, 1700000000LL + rand() % 86400 ); // NOLINT
+		}
+
+		CreateFilterContext_t tCtx;
+		tCtx.m_pMatchSchema = &m_tSchema;
+		CSphString sError, sWarning;
+
+		CSphFilterSettings tGid;
+		tGid.m_sAttrName = "gid";
+		tGid.m_eType = SPH_FILTER_VALUES;
+		tGid.SetExternalValues ( { m_dGids, sizeof ( m_dGids ) / sizeof ( m_dGids[0] ) } );
+
+		CSphFilterSettings tPrice;
+		tPrice.m_sAttrName = "price";
+		tPrice.m_eType = SPH_FILTER_RANGE;
+		tPrice.m_iMinValue = 100;
+		tPrice.m_iMaxValue = 899;
+
+		CSphFilterSettings tTs;
+		tTs.m_sAttrName = "ts";
+		tTs.m_eType = SPH_FILTER_RANGE;
+		tTs.m_iMinValue = 1700000000LL;
+		tTs.m_iMaxValue = 1700000000LL + 43200;
+
+		m_pFilter = sphJoinFilters ( sphCreateFilter ( tPrice, tCtx, sError, sWarning ), sphJoinFilters ( sphCreateFilter ( tTs, tCtx, sError, sWarning ), sphCreateFilter ( tGid, tCtx, sError, sWarning ) ) );
+		m_pFilter = m_pFilter->Optimize();
+	}
+
+	void TearDown ( const ::benchmark::State & ) override
+	{
+		m_pFilter.reset();
+	}
+
+protected:
+	CSphSchema						m_tSchema;
+	CSphFixedVector<CSphRowitem>	m_dRows {0};
+	int								m_iStride = 0;
+	std::unique_ptr<ISphFilter>		m_pFilter;
+	SphAttr_t						m_dGids[25] = { 0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60, 64, 68, 72, 76, 80, 84, 88, 92, 96 };
+};
+
+
+BENCHMARK_F ( FilterRows_c, PerMatch ) ( benchmark::State & st )
+{
+	CSphMatch tMatch;
+	for ( auto _ : st )
+	{
+		int iPassed = 0;
+		for ( int i = 0; i < NUM_ROWS; ++i )
+		{
+			tMatch.m_pStatic = m_dRows.Begin() + i*m_iStride;
+			iPassed += m_pFilter->Eval ( tMatch ) ? 1 : 0;
+		}
+
+		benchmark::DoNotOptimize ( iPassed );
+	}
+
+	tMatch.m_pStatic = nullptr;
+	st.SetItemsProcessed ( st.iterations()*NUM_ROWS );
+}
+
+
+BENCHMARK_F ( FilterRows_c, Block ) ( benchmark::State & st )
+{
+	const CSphRowitem * dRows[FILTER_BLOCK_ROWS];
+	uint64_t dMask[FILTER_MASK_WORDS];
+	for ( auto _ : st )
+	{
+		int iPassed = 0;
+		for ( int iStart = 0; iStart < NUM_ROWS; iStart += FILTER_BLOCK_ROWS )
+		{
+			for ( int i = 0; i < FILTER_BLOCK_ROWS; ++i )
+				dRows[i] = m_dRows.Begin() + ( iStart+i )*m_iStride;
+
+			m_pFilter->EvalRows ( dRows, FILTER_BLOCK_ROWS, dMask );
+			for ( auto uWord : dMask )
+				iPassed += sphBitCount ( uWord );
+		}
+
+		benchmark::DoNotOptimize ( iPassed );
+	}
+
+	st.SetItemsProcessed ( st.iterations()*NUM_ROWS );
+}
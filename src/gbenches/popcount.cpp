@@ -653,6 +653,28 @@ BENCHMARK_DEFINE_F ( zipunzip, unzipbe32_fastest )
 }
 
 
+// block decoding, as used for hitlists
+BENCHMARK_DEFINE_F ( zipunzip, unzipbe32bulk )
+( benchmark::State& st )
+{
+	int64_t iBytes = 0;
+	auto NRUNS = st.range ( 1 );
+	DWORD dBlock[128];
+	for ( auto _ : st )
+	{
+		const BYTE* pBuf = dBufBE.begin();
+		for ( int64_t i = 0; i < NRUNS; )
+		{
+			i += UnzipIntsBE ( pBuf, dBufBE.end(), dBlock, (int)Min ( NRUNS-i, (int64_t)128 ) );
+			benchmark::DoNotOptimize ( dBlock );
+		}
+		iBytes += pBuf - dBufBE.begin();
+	}
+	st.SetItemsProcessed ( st.iterations() * NRUNS );
+	st.SetBytesProcessed ( iBytes );
+}
+
+
 BENCHMARK_DEFINE_F ( zipunzip, unzipbe32ref )
 ( benchmark::State& st )
 {
@@ -771,6 +793,7 @@ BENCHMARK_DEFINE_F ( zipunzip, unziple32opt )
 }
 
 BENCHMARK_REGISTER_F ( zipunzip, unzipbe32_fastest )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 5, 1 ), benchmark::CreateRange ( MINRANGE, MAXRANGE, STEPRANGE ) } );
+BENCHMARK_REGISTER_F ( zipunzip, unzipbe32bulk )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 5, 1 ), benchmark::CreateRange ( MINRANGE, MAXRANGE, STEPRANGE ) } );
 BENCHMARK_REGISTER_F ( zipunzip, unzipbe32ref )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 5, 1 ), benchmark::CreateRange ( MINRANGE, MAXRANGE, STEPRANGE ) } );
 BENCHMARK_REGISTER_F ( zipunzip, unziple32_fastest )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 5, 1 ), benchmark::CreateRange ( MINRANGE, MAXRANGE, STEPRANGE ) } );
 BENCHMARK_REGISTER_F ( zipunzip, unziple32ref )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 5, 1 ), benchmark::CreateRange ( MINRANGE, MAXRANGE, STEPRANGE ) } );
@@ -830,9 +853,30 @@ BENCHMARK_DEFINE_F ( realunzip, unzipbe32macroGetByte )
 	st.SetBytesProcessed ( iBytes );
 }
 
+BENCHMARK_DEFINE_F ( realunzip, unzipbe32bulk )
+( benchmark::State& st )
+{
+	int64_t iBytes = 0;
+	auto NRUNS = st.range ( 0 );
+	DWORD dBlock[128];
+	for ( auto _ : st )
+	{
+		const BYTE* pBuf = dBufBE.begin();
+		for ( int64_t i = 0; i < NRUNS * iProfile; )
+		{
+			i += UnzipIntsBE ( pBuf, dBufBE.end(), dBlock, (int)Min ( NRUNS * iProfile - i, (int64_t)128 ) );
+			benchmark::DoNotOptimize ( dBlock );
+		}
+		iBytes += pBuf - dBufBE.begin();
+	}
+	st.SetItemsProcessed ( st.iterations() * NRUNS );
+	st.SetBytesProcessed ( iBytes );
+}
+
 BENCHMARK_REGISTER_F ( realunzip, unzipbe32GetByte )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 4, 1 ) } );
 BENCHMARK_REGISTER_F ( realunzip, unzipbe32refGetByte )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 4, 1 ) } );
 BENCHMARK_REGISTER_F ( realunzip, unzipbe32macroGetByte )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 4, 1 ) } );
+BENCHMARK_REGISTER_F ( realunzip, unzipbe32bulk )->ArgsProduct ( { benchmark::CreateDenseRange ( 1, 4, 1 ) } );
 
 BENCHMARK_DEFINE_F ( zipunzip, unzipbe64_fastest )
 ( benchmark::State& st )
@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2017-2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org
+//
+
+#include "threadutils.h"
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <thread>
+
+// compare shared-queue thread pool with work-stealing one
+
+class ThreadPoolBench: public benchmark::Fixture
+{
+public:
+	void SetUp ( const ::benchmark::State& state )
+	{
+		Threads::Init();
+	}
+
+	void TearDown ( const ::benchmark::State& state )
+	{
+		if ( m_pPool )
+			m_pPool->StopAll();
+		m_pPool = nullptr;
+	}
+
+	void MakePool ( bool bStealing, int iThreads )
+	{
+		if ( bStealing )
+			m_pPool = Threads::MakeStealingThreadPool ( iThreads, "bench" );
+		else
+			m_pPool = Threads::MakeThreadPool ( iThreads, "bench" );
+	}
+
+	static void WaitFor ( const std::atomic<int> & iCounter, int iValue )
+	{
+		while ( iCounter.load ( std::memory_order_acquire )<iValue )
+			std::this_thread::yield();
+	}
+
+	// one task spawns many short ones (like pseudo-sharding does)
+	void FanOut ( benchmark::State& st )
+	{
+		const int JOBS = 10000;
+		for ( auto _ : st )
+		{
+			std::atomic<int> iDone { 0 };
+			m_pPool->Schedule ( [this, &iDone] {
+				for ( int i = 0; i<JOBS; ++i )
+					m_pPool->Schedule ( [&iDone] {
+						volatile int iRes = 0;
+						for ( int j = 0; j<100; ++j )
+							iRes += j;
+						iDone.fetch_add ( 1, std::memory_order_release );
+					}, false );
+			}, false );
+			WaitFor ( iDone, JOBS );
+		}
+		st.SetItemsProcessed ( st.iterations()*JOBS );
+	}
+
+	// chains of continuations (like resumed coroutines)
+	void Continuations ( benchmark::State& st )
+	{
+		const int CHAINS = 64;
+		const int LENGTH = 200;
+		for ( auto _ : st )
+		{
+			std::atomic<int> iDone { 0 };
+			for ( int i = 0; i<CHAINS; ++i )
+				m_pPool->Schedule ( [this, &iDone] { Step ( LENGTH, iDone ); }, false );
+			WaitFor ( iDone, CHAINS );
+		}
+		st.SetItemsProcessed ( st.iterations()*CHAINS*LENGTH );
+	}
+
+	void Step ( int iLeft, std::atomic<int> & iDone )
+	{
+		if ( !iLeft )
+		{
+			iDone.fetch_add ( 1, std::memory_order_release );
+			return;
+		}
+
+		m_pPool->ScheduleContinuation ( [this, iLeft, &iDone] { Step ( iLeft-1, iDone ); } );
+	}
+
+	Threads::WorkerSharedPtr_t m_pPool;
+};
+
+BENCHMARK_DEFINE_F ( ThreadPoolBench, fanout_shared )
+( benchmark::State& st )
+{
+	MakePool ( false, (int)st.range(0) );
+	FanOut(st);
+}
+
+BENCHMARK_DEFINE_F ( ThreadPoolBench, fanout_stealing )
+( benchmark::State& st )
+{
+	MakePool ( true, (int)st.range(0) );
+	FanOut(st);
+}
+
+BENCHMARK_DEFINE_F ( ThreadPoolBench, continuations_shared )
+( benchmark::State& st )
+{
+	MakePool ( false, (int)st.range(0) );
+	Continuations(st);
+}
+
+BENCHMARK_DEFINE_F ( ThreadPoolBench, continuations_stealing )
+( benchmark::State& st )
+{
+	MakePool ( true, (int)st.range(0) );
+	Continuations(st);
+}
+
+BENCHMARK_REGISTER_F ( ThreadPoolBench, fanout_shared )->RangeMultiplier ( 2 )->Range ( 1, 32 )->UseRealTime();
+BENCHMARK_REGISTER_F ( ThreadPoolBench, fanout_stealing )->RangeMultiplier ( 2 )->Range ( 1, 32 )->UseRealTime();
+BENCHMARK_REGISTER_F ( ThreadPoolBench, continuations_shared )->RangeMultiplier ( 2 )->Range ( 1, 32 )->UseRealTime();
+BENCHMARK_REGISTER_F ( ThreadPoolBench, continuations_stealing )->RangeMultiplier ( 2 )->Range ( 1, 32 )->UseRealTime();
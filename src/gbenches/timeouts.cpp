@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org
+//
+
+#include "timeout_queue.h"
+
+#include <benchmark/benchmark.h>
+#include <random>
+
+// compare bin heap with timing wheel on netloop-like load:
+// many idle keep-alive sockets, each I/O moves the socket's deadline forward, and the loop checks the root
+
+static constexpr int64_t KEEPALIVE_US = 60000000;
+static constexpr int IO_PER_CHECK = 16;
+
+template<typename QUEUE>
+static void RescheduleTimeouts ( benchmark::State & st )
+{
+	const auto iTimers = (int)st.range(0);
+	CSphFixedVector<EnqueuedTimeout_t> dTimers ( iTimers );
+	QUEUE tQueue;
+
+	std::mt19937 tRand ( 42 );
+	int64_t iNow = 1000000;
+	for ( auto & tTimer : dTimers )
+	{
+		tTimer.m_iTimeoutTimeUS = iNow + KEEPALIVE_US + tRand() % KEEPALIVE_US;
+		tQueue.Change ( &tTimer );
+	}
+
+	int64_t iOps = 0;
+	for ( auto _ : st )
+	{
+		for ( int i = 0; i < IO_PER_CHECK; ++i )
+		{
+			iNow += 10;
+			auto & tTimer = dTimers[tRand() % iTimers];
+			tTimer.m_iTimeoutTimeUS = iNow + KEEPALIVE_US;
+			tQueue.Change ( &tTimer );
+		}
+
+		benchmark::DoNotOptimize ( tQueue.Root() );
+		iOps += IO_PER_CHECK;
+	}
+
+	st.SetItemsProcessed ( iOps );
+}
+
+BENCHMARK_TEMPLATE ( RescheduleTimeouts, TimeoutQueue_c )->Arg ( 10000 )->Arg ( 100000 )->Arg ( 1000000 );
+BENCHMARK_TEMPLATE ( RescheduleTimeouts, TimeoutWheel_c )->Arg ( 10000 )->Arg ( 100000 )->Arg ( 1000000 );
+
+
+// add and expire: every timer is added once and popped when due
+template<typename QUEUE>
+static void ExpireTimeouts ( benchmark::State & st )
+{
+	const auto iTimers = (int)st.range(0);
+	CSphFixedVector<EnqueuedTimeout_t> dTimers ( iTimers );
+	std::mt19937 tRand ( 42 );
+
+	for ( auto _ : st )
+	{
+		QUEUE tQueue;
+		for ( auto & tTimer : dTimers )
+		{
+			tTimer.m_iTimeoutIdx = -1;
+			tTimer.m_iTimeoutTimeUS = 1 + tRand() % KEEPALIVE_US;
+			tQueue.Change ( &tTimer );
+		}
+
+		while ( !tQueue.IsEmpty() )
+		{
+			benchmark::DoNotOptimize ( tQueue.Root() );
+			tQueue.Pop();
+		}
+	}
+
+	st.SetItemsProcessed ( st.iterations()*iTimers );
+}
+
+BENCHMARK_TEMPLATE ( ExpireTimeouts, TimeoutQueue_c )->Arg ( 10000 )->Arg ( 100000 )->Arg ( 1000000 );
+BENCHMARK_TEMPLATE ( ExpireTimeouts, TimeoutWheel_c )->Arg ( 10000 )->Arg ( 100000 )->Arg ( 1000000 );
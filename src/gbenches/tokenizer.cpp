@@ -139,3 +139,46 @@ BENCHMARK_F ( BM_tokenizer, synonyms )
 	st.SetBytesProcessed ( iAllBytes );
 	st.SetItemsProcessed ( iTokens );
 }
+
+//////////////////////////////////////////////////////////////////////////
+// ascii fast path vs generic per-codepoint path
+
+static CSphString GenerateText ( bool bAscii, int iWords )
+{
+	static const char* dAscii[] = { "The", "quick", "brown", "FOX", "jumps", "over", "the", "lazy", "dog", "Indexing", "throughput", "2024" };
+	static const char* dUtf8[] = { "Съешь", "же", "ещё", "этих", "мягких", "французских", "булок", "да", "выпей", "чаю", "über", "straße" };
+
+	StringBuilder_c sText ( " " );
+	for ( int i = 0; i < iWords; ++i )
+		sText << ( bAscii ? dAscii[i % 12] : dUtf8[i % 12] );
+	return CSphString ( sText );
+}
+
+static void BM_TokenizeText ( benchmark::State& st, bool bAscii, bool bBlend )
+{
+	CSphString sText = GenerateText ( bAscii, 100000 );
+	CSphString sError;
+	TokenizerRefPtr_c pTokenizer = Tokenizer::Detail::CreateUTF8Tokenizer();
+	pTokenizer->SetCaseFolding ( "0..9, A..Z->a..z, _, a..z, U+410..U+42F->U+430..U+44F, U+430..U+44F, U+401->U+451, U+451, U+DC->U+FC, U+FC, U+DF", sError );
+	if ( bBlend )
+		pTokenizer->SetBlendChars ( "-, +", sError );
+
+	auto iBytes = sText.Length();
+	int64_t iTokens = 0;
+	for ( auto _ : st )
+	{
+		pTokenizer->SetBuffer ( (const BYTE*)sText.cstr(), iBytes );
+		while ( pTokenizer->GetToken() )
+			++iTokens;
+	}
+	st.SetBytesProcessed ( st.iterations() * iBytes );
+	st.SetItemsProcessed ( iTokens );
+}
+
+static void BM_tokenize_ascii ( benchmark::State& st ) { BM_TokenizeText ( st, true, false ); }
+static void BM_tokenize_ascii_blend ( benchmark::State& st ) { BM_TokenizeText ( st, true, true ); }
+static void BM_tokenize_utf8 ( benchmark::State& st ) { BM_TokenizeText ( st, false, false ); }
+
+BENCHMARK ( BM_tokenize_ascii );
+BENCHMARK ( BM_tokenize_ascii_blend );
+BENCHMARK ( BM_tokenize_utf8 );
@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include <gtest/gtest.h>
+
+#include "docidlookup.h"
+#include "fileutils.h"
+
+static const char * LOOKUP_TMP = "__docidlookup_test.spt";
+
+class DocidLookup : public ::testing::Test
+{
+protected:
+	void TearDown() override
+	{
+		m_tLookup.Reset();
+		unlink ( LOOKUP_TMP );
+	}
+
+	void Build ( const VecTraits_T<DocID_t> & dDocids )
+	{
+		CSphVector<DocidRowidPair_t> dPairs;
+		ARRAY_FOREACH ( i, dDocids )
+			dPairs.Add ( { dDocids[i], (RowID_t)i } );
+		dPairs.Sort ( CmpDocidLookup_fn() );
+
+		CSphString sError;
+		ASSERT_TRUE ( WriteDocidLookup ( LOOKUP_TMP, dPairs, sError ) ) << sError.cstr();
+		ASSERT_TRUE ( m_tLookup.Setup ( LOOKUP_TMP, sError ) ) << sError.cstr();
+		m_tReader.SetData ( m_tLookup.GetReadPtr() );
+		m_tFilter.Build ( m_tLookup.GetReadPtr() );
+	}
+
+	// ids are clustered at very different scales, with docids which are negative when signed
+	static CSphVector<DocID_t> SkewedDocids()
+	{
+		CSphVector<DocID_t> dDocids;
+		for ( DocID_t i = 1; i<=5000; ++i )
+			dDocids.Add(i);
+		for ( DocID_t i = 0; i<5000; ++i )
+			dDocids.Add ( INT64_C(1000000000000) + i*7 );
+		for ( int i = 0; i<40; ++i )
+			dDocids.Add ( DocID_t ( UINT64_C(1)<<i ) * INT64_C(3000000) );
+		for ( DocID_t i = 0; i<300; ++i )
+			dDocids.Add ( (DocID_t)( UINT64_C(0xF000000000000000) + i*1000 ) );
+
+		dDocids.Uniq();
+		return dDocids;
+	}
+
+	CSphMappedBuffer<BYTE>	m_tLookup;
+	LookupReader_c			m_tReader;
+	DocidLookupFilter_c		m_tFilter;
+};
+
+
+// reference: first checkpoint with base >= docid, or the last one
+static const DocidLookupCheckpoint_t * LinearFirstGE ( const VecTraits_T<DocidLookupCheckpoint_t> & dCheckpoints, uint64_t uDocID )
+{
+	for ( const auto & tCheckpoint : dCheckpoints )
+		if ( (uint64_t)tCheckpoint.m_tBaseDocID>=uDocID )
+			return &tCheckpoint;
+
+	return &dCheckpoints.Last();
+}
+
+static void CheckFirstGE ( const VecTraits_T<DocidLookupCheckpoint_t> & dCheckpoints )
+{
+	CSphVector<uint64_t> dProbes;
+	dProbes.Add(0);
+	dProbes.Add(UINT64_MAX);
+	for ( const auto & tCheckpoint : dCheckpoints )
+	{
+		auto uBase = (uint64_t)tCheckpoint.m_tBaseDocID;
+		dProbes.Add ( uBase-1 );
+		dProbes.Add ( uBase );
+		dProbes.Add ( uBase+1 );
+	}
+
+	for ( uint64_t uDocID : dProbes )
+	{
+		auto * pExpected = LinearFirstGE ( dCheckpoints, uDocID );
+		auto * pFound = FindFirstCheckpointGE ( dCheckpoints.Begin(), &dCheckpoints.Last(), uDocID );
+		ASSERT_EQ ( pFound-dCheckpoints.Begin(), pExpected-dCheckpoints.Begin() ) << "docid " << uDocID;
+	}
+}
+
+TEST ( DocidLookupCheckpoints, first_ge_uniform )
+{
+	CSphVector<DocidLookupCheckpoint_t> dCheckpoints;
+	for ( int i = 0; i<1000; ++i )
+		dCheckpoints.Add().m_tBaseDocID = 1 + i*64;
+
+	CheckFirstGE ( dCheckpoints );
+}
+
+TEST ( DocidLookupCheckpoints, first_ge_exponential )
+{
+	// interpolation badly overshoots here on every probe
+	CSphVector<DocidLookupCheckpoint_t> dCheckpoints;
+	for ( int i = 0; i<63; ++i )
+		dCheckpoints.Add().m_tBaseDocID = DocID_t ( UINT64_C(1)<<i );
+
+	CheckFirstGE ( dCheckpoints );
+}
+
+TEST ( DocidLookupCheckpoints, first_ge_outliers )
+{
+	// dense run and a few huge docids, including ones negative when signed
+	CSphVector<DocidLookupCheckpoint_t> dCheckpoints;
+	for ( int i = 0; i<500; ++i )
+		dCheckpoints.Add().m_tBaseDocID = 100 + i;
+	dCheckpoints.Add().m_tBaseDocID = INT64_MAX;
+	dCheckpoints.Add().m_tBaseDocID = (DocID_t)UINT64_C(0x8000000000000000);
+	dCheckpoints.Add().m_tBaseDocID = -2;
+
+	CheckFirstGE ( dCheckpoints );
+}
+
+TEST ( DocidLookupCheckpoints, first_ge_tiny )
+{
+	CSphVector<DocidLookupCheckpoint_t> dCheckpoints;
+	dCheckpoints.Add().m_tBaseDocID = 10;
+	CheckFirstGE ( dCheckpoints );
+
+	dCheckpoints.Add().m_tBaseDocID = 11;
+	CheckFirstGE ( dCheckpoints );
+
+	dCheckpoints.Add().m_tBaseDocID = 1000000;
+	CheckFirstGE ( dCheckpoints );
+}
+
+
+TEST_F ( DocidLookup, find_skewed )
+{
+	auto dDocids = SkewedDocids();
+	Build ( dDocids );
+
+	// rowid is the position in the source list
+	ARRAY_FOREACH ( i, dDocids )
+		ASSERT_EQ ( m_tReader.Find ( dDocids[i] ), (RowID_t)i ) << "docid " << (uint64_t)dDocids[i];
+
+	ASSERT_EQ ( m_tReader.Find(0), INVALID_ROWID );
+	ASSERT_EQ ( m_tReader.Find(5001), INVALID_ROWID );
+	ASSERT_EQ ( m_tReader.Find ( INT64_C(1000000000001) ), INVALID_ROWID );
+	ASSERT_EQ ( m_tReader.Find(-1), INVALID_ROWID );
+}
+
+TEST_F ( DocidLookup, filter_no_false_negatives )
+{
+	auto dDocids = SkewedDocids();
+	for ( DocID_t i = 0; i<100000; ++i )
+		dDocids.Add ( DocID_t ( ( i*UINT64_C(0x9E3779B97F4A7C15) ) >> 1 ) );
+	dDocids.Uniq();
+	Build ( dDocids );
+
+	ASSERT_FALSE ( m_tFilter.IsEmpty() );
+	for ( DocID_t tDocID : dDocids )
+		ASSERT_TRUE ( m_tFilter.MayContain(tDocID) ) << "docid " << (uint64_t)tDocID;
+
+	// and it still rejects most of the absent docids (~1% false positives are expected at 10 bits per doc)
+	int iFalsePositives = 0;
+	const int ABSENT = 100000;
+	for ( int i = 0; i<ABSENT; ++i )
+	{
+		DocID_t tAbsent = INT64_C(2000000000000) + i;
+		ASSERT_EQ ( m_tReader.Find(tAbsent), INVALID_ROWID );
+		iFalsePositives += m_tFilter.MayContain(tAbsent) ? 1 : 0;
+	}
+
+	ASSERT_LT ( iFalsePositives, ABSENT/20 );
+}
+
+
+TEST_F ( DocidLookup, clip_kill_list_boundaries )
+{
+	CSphVector<DocID_t> dDocids;
+	for ( DocID_t i = 100; i<200; i+=2 )
+		dDocids.Add(i);
+	Build ( dDocids );
+
+	auto Clip = [this] ( std::initializer_list<DocID_t> dKill, bool bFilter ) -> CSphVector<DocID_t>
+	{
+		CSphVector<DocID_t> dKlist;
+		for ( DocID_t tDocID : dKill )
+			dKlist.Add(tDocID);
+
+		CSphVector<DocID_t> dRes;
+		for ( DocID_t tDocID : ClipKillList ( dKlist, m_tReader, bFilter ? &m_tFilter : nullptr ) )
+			dRes.Add(tDocID);
+		return dRes;
+	};
+
+	for ( bool bFilter : { false, true } )
+	{
+		ASSERT_TRUE ( Clip ( {}, bFilter ).IsEmpty() );
+		ASSERT_TRUE ( Clip ( { 1, 50, 99 }, bFilter ).IsEmpty() );
+		ASSERT_TRUE ( Clip ( { 199, 500 }, bFilter ).IsEmpty() );
+
+		// min and max docids themselves are kept
+		auto dMin = Clip ( { 99, 100 }, bFilter );
+		ASSERT_EQ ( dMin.GetLength(), 1 );
+		ASSERT_EQ ( dMin[0], 100 );
+
+		auto dMax = Clip ( { 198, 199 }, bFilter );
+		ASSERT_EQ ( dMax.GetLength(), 1 );
+		ASSERT_EQ ( dMax[0], 198 );
+
+		auto dBoth = Clip ( { 1, 99, 100, 150, 198, 199, 1000 }, bFilter );
+		ASSERT_EQ ( dBoth.GetLength(), 3 );
+		ASSERT_EQ ( dBoth[0], 100 );
+		ASSERT_EQ ( dBoth[1], 150 );
+		ASSERT_EQ ( dBoth[2], 198 );
+	}
+
+	// in range, but absent; the filter may drop such list entirely, otherwise it is clipped by range only
+	auto dAbsent = Clip ( { 99, 101, 103, 201 }, true );
+	if ( !dAbsent.IsEmpty() )
+	{
+		ASSERT_EQ ( dAbsent.GetLength(), 2 );
+		ASSERT_EQ ( dAbsent[0], 101 );
+		ASSERT_EQ ( dAbsent[1], 103 );
+	}
+
+	// nothing to clip against
+	CSphVector<DocID_t> dKlist;
+	dKlist.Add(100);
+	ASSERT_TRUE ( ClipKillList ( dKlist, LookupReader_c(), nullptr ).IsEmpty() );
+}
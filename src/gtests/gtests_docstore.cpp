@@ -0,0 +1,250 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include <gtest/gtest.h>
+
+#include "docstore.h"
+#include "threadutils.h"
+
+#include <atomic>
+
+static const char * DOCSTORE_TMP = "__docstore_test.spds";
+
+class docstore : public ::testing::Test
+{
+protected:
+	void TearDown() override
+	{
+		unlink ( DOCSTORE_TMP );
+	}
+
+	// semi-repetitive docs, so that a dictionary trained on them pays off
+	static CSphString MakeText ( int iDoc )
+	{
+		CSphString sText;
+		sText.SetSprintf ( "user %d visited /catalog/item/%d from Mozilla/5.0 (X11; Linux x86_64) session %d, referer https://example.com/search?q=%d",
+			iDoc % 97, iDoc*7919 % 100003, iDoc, iDoc % 13 );
+		return sText;
+	}
+
+	static CSphString MakeTitle ( int iDoc )
+	{
+		CSphString sTitle;
+		sTitle.SetSprintf ( "item %d", iDoc );
+		return sTitle;
+	}
+
+	static bool Build ( Compression_e eCompression, int iDocs, CSphString & sError )
+	{
+		DocstoreSettings_t tSettings;
+		tSettings.m_eCompression = eCompression;
+		tSettings.m_uBlockSize = 4096;
+
+		auto pBuilder = CreateDocstoreBuilder ( DOCSTORE_TMP, tSettings, 65536, sError );
+		if ( !pBuilder )
+			return false;
+
+		pBuilder->AddField ( "title", DOCSTORE_TEXT );
+		pBuilder->AddField ( "body", DOCSTORE_TEXT );
+
+		for ( int i = 0; i<iDocs; ++i )
+		{
+			CSphString sTitle = MakeTitle(i);
+			CSphString sText = MakeText(i);
+
+			DocstoreBuilder_i::Doc_t tDoc;
+			tDoc.m_dFields.Add ( VecTraits_T<BYTE> ( (BYTE*)const_cast<char*>( sTitle.cstr() ), sTitle.Length() ) );
+			tDoc.m_dFields.Add ( VecTraits_T<BYTE> ( (BYTE*)const_cast<char*>( sText.cstr() ), sText.Length() ) );
+			pBuilder->AddDoc ( i, tDoc );
+		}
+
+		pBuilder->Finalize();
+		return true;
+	}
+
+	// v.1 layout is v.2 without the dictionary, which readers of v.1 never look for
+	static void PatchVersion ( DWORD uVersion )
+	{
+		FILE * fp = fopen ( DOCSTORE_TMP, "r+b" );
+		ASSERT_TRUE ( fp );
+		ASSERT_EQ ( fwrite ( &uVersion, sizeof(uVersion), 1, fp ), 1u );
+		fclose(fp);
+	}
+
+	static DWORD ReadVersion()
+	{
+		DWORD uVersion = 0;
+		FILE * fp = fopen ( DOCSTORE_TMP, "rb" );
+		if ( !fp )
+			return 0;
+
+		if ( fread ( &uVersion, sizeof(uVersion), 1, fp )!=1 )
+			uVersion = 0;
+
+		fclose(fp);
+		return uVersion;
+	}
+
+	static void CheckDocs ( int iDocs )
+	{
+		CSphString sError;
+		auto pDocstore = CreateDocstore ( 1, DOCSTORE_TMP, sError );
+		ASSERT_TRUE ( pDocstore ) << sError.cstr();
+
+		int iTitle = pDocstore->GetFieldId ( "title", DOCSTORE_TEXT );
+		int iBody = pDocstore->GetFieldId ( "body", DOCSTORE_TEXT );
+		ASSERT_EQ ( iTitle, 0 );
+		ASSERT_EQ ( iBody, 1 );
+
+		DocstoreSession_c tSession;
+		pDocstore->CreateReader ( tSession.GetUID() );
+
+		for ( int i = 0; i<iDocs; ++i )
+		{
+			DocstoreDoc_t tDoc = pDocstore->GetDoc ( i, nullptr, tSession.GetUID(), false );
+			ASSERT_EQ ( tDoc.m_dFields.GetLength(), 2 );
+
+			CSphString sTitle = MakeTitle(i);
+			CSphString sText = MakeText(i);
+			ASSERT_EQ ( tDoc.m_dFields[iTitle].GetLength(), sTitle.Length() ) << "doc " << i;
+			ASSERT_EQ ( tDoc.m_dFields[iBody].GetLength(), sText.Length() ) << "doc " << i;
+			ASSERT_EQ ( memcmp ( tDoc.m_dFields[iTitle].Begin(), sTitle.cstr(), sTitle.Length() ), 0 ) << "doc " << i;
+			ASSERT_EQ ( memcmp ( tDoc.m_dFields[iBody].Begin(), sText.cstr(), sText.Length() ), 0 ) << "doc " << i;
+		}
+	}
+
+	static bool ZstdAvailable()
+	{
+		return !!CreateCompressor ( Compression_e::ZSTD, DEFAULT_COMPRESSION_LEVEL );
+	}
+};
+
+
+// without a dictionary the docstore stays v.1, so that older binaries can still read it
+TEST_F ( docstore, v1_without_dictionary )
+{
+	CSphString sError;
+	ASSERT_TRUE ( Build ( Compression_e::LZ4, 3000, sError ) ) << sError.cstr();
+	ASSERT_EQ ( ReadVersion(), 1u );
+	CheckDocs(3000);
+
+	ASSERT_TRUE ( Build ( Compression_e::NONE, 100, sError ) ) << sError.cstr();
+	ASSERT_EQ ( ReadVersion(), 1u );
+	CheckDocs(100);
+}
+
+
+TEST_F ( docstore, v2_with_dictionary )
+{
+	if ( !ZstdAvailable() )
+		GTEST_SKIP() << "zstd is not available";
+
+	CSphString sError;
+	ASSERT_TRUE ( Build ( Compression_e::ZSTD, 3000, sError ) ) << sError.cstr();
+	ASSERT_EQ ( ReadVersion(), 2u );
+	CheckDocs(3000);
+}
+
+
+TEST_F ( docstore, v1_zstd_too_few_samples )
+{
+	if ( !ZstdAvailable() )
+		GTEST_SKIP() << "zstd is not available";
+
+	// not enough samples to train; stored without a dictionary
+	CSphString sError;
+	ASSERT_TRUE ( Build ( Compression_e::ZSTD, 3, sError ) ) << sError.cstr();
+	ASSERT_EQ ( ReadVersion(), 1u );
+	CheckDocs(3);
+}
+
+
+// v.2 docstores were written without a dictionary too, when the compressor doesn't use one
+TEST_F ( docstore, v2_without_dictionary_still_loads )
+{
+	CSphString sError;
+	ASSERT_TRUE ( Build ( Compression_e::LZ4, 3000, sError ) ) << sError.cstr();
+	PatchVersion(2);
+	CheckDocs(3000);
+}
+
+
+TEST_F ( docstore, newer_version_rejected )
+{
+	CSphString sError;
+	ASSERT_TRUE ( Build ( Compression_e::LZ4, 10, sError ) ) << sError.cstr();
+	PatchVersion(100);
+	ASSERT_FALSE ( CreateDocstore ( 1, DOCSTORE_TMP, sError ) );
+	ASSERT_FALSE ( sError.IsEmpty() );
+}
+
+
+TEST_F ( docstore, zstd_dictionary_concurrent_compress )
+{
+	auto pCompressor = CreateCompressor ( Compression_e::ZSTD, DEFAULT_COMPRESSION_LEVEL );
+	if ( !pCompressor )
+		GTEST_SKIP() << "zstd is not available";
+
+	CSphVector<BYTE> dSamples;
+	CSphVector<size_t> dSampleSizes;
+	for ( int i = 0; i<3000; ++i )
+	{
+		CSphString sText = MakeText(i);
+		dSamples.Append ( VecTraits_T<BYTE> ( (BYTE*)const_cast<char*>( sText.cstr() ), sText.Length() ) );
+		dSampleSizes.Add ( sText.Length() );
+	}
+
+	CSphVector<BYTE> dDict;
+	ASSERT_TRUE ( pCompressor->TrainDictionary ( dSamples, dSampleSizes, dDict ) );
+	ASSERT_TRUE ( pCompressor->SetDictionary ( dDict, true ) );
+
+	// one compressor shared by several threads, each with its own compression context
+	const int THREADS = 4;
+	std::atomic<int> iFailed {0};
+	CSphVector<SphThread_t> dThreads;
+	dThreads.Resize(THREADS);
+	for ( int iThread = 0; iThread<THREADS; ++iThread )
+		ASSERT_TRUE ( Threads::Create ( &dThreads[iThread], [&, iThread]
+		{
+			CSphVector<BYTE> dCompressed;
+			for ( int i = iThread; i<3000; i += THREADS )
+			{
+				CSphString sText = MakeText(i);
+				VecTraits_T<BYTE> dText ( (BYTE*)const_cast<char*>( sText.cstr() ), sText.Length() );
+				if ( !pCompressor->Compress ( dText, dCompressed ) )
+				{
+					iFailed.fetch_add(1);
+					continue;
+				}
+
+				CSphFixedVector<BYTE> dDecompressed ( dText.GetLength() );
+				if ( !pCompressor->Decompress ( dCompressed, dDecompressed ) || memcmp ( dDecompressed.Begin(), dText.Begin(), dText.GetLength() ) )
+					iFailed.fetch_add(1);
+			}
+		}));
+
+	for ( auto & tThread : dThreads )
+		ASSERT_TRUE ( Threads::Join ( &tThread ) );
+
+	ASSERT_EQ ( iFailed.load(), 0 );
+
+	// reader side loads the dictionary for decompression only
+	auto pReader = CreateCompressor ( Compression_e::ZSTD, DEFAULT_COMPRESSION_LEVEL );
+	ASSERT_TRUE ( pReader->SetDictionary ( dDict, false ) );
+
+	CSphString sText = MakeText(0);
+	VecTraits_T<BYTE> dText ( (BYTE*)const_cast<char*>( sText.cstr() ), sText.Length() );
+	CSphVector<BYTE> dCompressed;
+	ASSERT_TRUE ( pCompressor->Compress ( dText, dCompressed ) );
+
+	CSphFixedVector<BYTE> dDecompressed ( dText.GetLength() );
+	ASSERT_TRUE ( pReader->Decompress ( dCompressed, dDecompressed ) );
+	ASSERT_EQ ( memcmp ( dDecompressed.Begin(), dText.Begin(), dText.GetLength() ), 0 );
+}
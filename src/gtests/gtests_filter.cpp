@@ -14,6 +14,7 @@
 
 #include "sphinxfilter.h"
 #include "conversion.h"
+#include "secondaryindex.h"
 
 class filter_block_level : public ::testing::Test
 {
@@ -585,3 +586,227 @@ TEST_F ( filter_block_level, and )
 	*dMax.Begin() = 30;
 	ASSERT_TRUE ( tFilter->EvalBlock ( dMin.Begin(), dMax.Begin() ) );
 }
+
+class filter_rows : public ::testing::Test
+{
+protected:
+	static const int NUM_ROWS = 300; // last block is a partial one
+
+	void SetUp() override
+	{
+		m_tSchema.AddAttr ( CSphColumnInfo ( "gid", SPH_ATTR_INTEGER ), false );
+		m_tSchema.AddAttr ( CSphColumnInfo ( "big", SPH_ATTR_BIGINT ), false );
+		m_tCtx.m_pMatchSchema = &m_tSchema;
+
+		m_iStride = m_tSchema.GetRowSize();
+		m_dRows.Reset ( NUM_ROWS*m_iStride );
+		m_dRows.ZeroVec();
+
+		const CSphAttrLocator & tGid = m_tSchema.GetAttr("gid")->m_tLocator;
+		const CSphAttrLocator & tBig = m_tSchema.GetAttr("big")->m_tLocator;
+		srand ( 0 );
+		for ( int i = 0; i < NUM_ROWS; ++i )
+		{
+			sphSetRowAttr ( GetRow(i), tGid, rand() % 50 ); // NOLINT
+			sphSetRowAttr ( GetRow(i), tBig, ( SphAttr_t ( rand() % 50 ) - 25 ) << 32 ); // NOLINT
+		}
+	}
+
+	CSphRowitem * GetRow ( int iRow ) { return m_dRows.Begin() + iRow*m_iStride; }
+
+	std::unique_ptr<ISphFilter> CreateFilter ( ESphFilter eType, const char * szAttr, SphAttr_t iMin, SphAttr_t iMax, bool bExclude=false )
+	{
+		CSphString sError, sWarning;
+		CSphFilterSettings tOpt;
+		tOpt.m_sAttrName = szAttr;
+		tOpt.m_eType = eType;
+		tOpt.m_iMinValue = iMin;
+		tOpt.m_iMaxValue = iMax;
+		tOpt.m_bExclude = bExclude;
+		return sphCreateFilter ( tOpt, m_tCtx, sError, sWarning );
+	}
+
+	std::unique_ptr<ISphFilter> CreateValuesFilter ( const char * szAttr, const VecTraits_T<SphAttr_t> & dValues )
+	{
+		CSphString sError, sWarning;
+		CSphFilterSettings tOpt;
+		tOpt.m_sAttrName = szAttr;
+		tOpt.m_eType = SPH_FILTER_VALUES;
+		tOpt.SetExternalValues ( dValues );
+		return sphCreateFilter ( tOpt, m_tCtx, sError, sWarning );
+	}
+
+	std::unique_ptr<ISphFilter> CreateFloatFilter ( const char * szAttr, float fMin, float fMax )
+	{
+		CSphString sError, sWarning;
+		CSphFilterSettings tOpt;
+		tOpt.m_sAttrName = szAttr;
+		tOpt.m_eType = SPH_FILTER_FLOATRANGE;
+		tOpt.m_fMinValue = fMin;
+		tOpt.m_fMaxValue = fMax;
+		return sphCreateFilter ( tOpt, m_tCtx, sError, sWarning );
+	}
+
+	// the rows picked by EvalRows() must be exactly the rows that pass Eval()
+	void CheckRows ( const ISphFilter & tFilter )
+	{
+		ASSERT_TRUE ( tFilter.CanEvalRows() );
+
+		CSphMatch tMatch;
+		const CSphRowitem * dRows[FILTER_BLOCK_ROWS];
+		uint64_t dMask[FILTER_MASK_WORDS];
+		for ( int iStart = 0; iStart < NUM_ROWS; iStart += FILTER_BLOCK_ROWS )
+		{
+			int iRows = Min ( NUM_ROWS-iStart, FILTER_BLOCK_ROWS );
+			for ( int i = 0; i < iRows; ++i )
+				dRows[i] = GetRow ( iStart+i );
+
+			tFilter.EvalRows ( dRows, iRows, dMask );
+			for ( int i = 0; i < FILTER_BLOCK_ROWS; ++i )
+			{
+				bool bPassed = !!( dMask[i/64] & ( 1ULL << ( i%64 ) ) );
+				if ( i>=iRows )
+				{
+					ASSERT_FALSE ( bPassed ) << "row " << iStart+i;
+					continue;
+				}
+
+				tMatch.m_pStatic = dRows[i];
+				ASSERT_EQ ( tFilter.Eval ( tMatch ), bPassed ) << "row " << iStart+i;
+			}
+		}
+
+		tMatch.m_pStatic = nullptr;
+	}
+
+	CSphSchema					m_tSchema;
+	CreateFilterContext_t		m_tCtx;
+	CSphFixedVector<CSphRowitem> m_dRows {0};
+	int							m_iStride = 0;
+};
+
+
+TEST_F ( filter_rows, range )
+{
+	CheckRows ( *CreateFilter ( SPH_FILTER_RANGE, "gid", 10, 40 ) );
+	CheckRows ( *CreateFilter ( SPH_FILTER_RANGE, "gid", 10, 40, true ) );
+	CheckRows ( *CreateFilter ( SPH_FILTER_RANGE, "big", -( 5LL << 32 ), 7LL << 32 ) );
+	CheckRows ( *CreateFilter ( SPH_FILTER_RANGE, "gid", 60, 70 ) );
+}
+
+
+TEST_F ( filter_rows, values )
+{
+	SphAttr_t dSingle[] = { 17 };
+	CheckRows ( *CreateValuesFilter ( "gid", { dSingle, 1 } ) );
+
+	SphAttr_t dShort[] = { 1, 10, 40 };
+	CheckRows ( *CreateValuesFilter ( "gid", { dShort, sizeof ( dShort ) / sizeof ( dShort[0] ) } ) );
+
+	CSphVector<SphAttr_t> dLong;
+	for ( int i = 0; i < 20; ++i )
+		dLong.Add ( ( SphAttr_t ( i*2 ) - 20 ) << 32 );
+	CheckRows ( *CreateValuesFilter ( "big", dLong ) );
+}
+
+
+TEST_F ( filter_rows, combined )
+{
+	SphAttr_t dValues[] = { 3, 5, 7, 11, 13 };
+	CheckRows ( *sphJoinFilters ( CreateFilter ( SPH_FILTER_RANGE, "gid", 0, 20 ), CreateFilter ( SPH_FILTER_RANGE, "big", 0, 20LL << 32 ) ) );
+	CheckRows ( *sphJoinFilters ( CreateFilter ( SPH_FILTER_RANGE, "gid", 0, 20 ), sphJoinFilters ( CreateFilter ( SPH_FILTER_RANGE, "big", 0, 20LL << 32 ), CreateValuesFilter ( "gid", { dValues, sizeof ( dValues ) / sizeof ( dValues[0] ) } ) ) ) );
+	CheckRows ( *sphJoinFilters ( CreateFilter ( SPH_FILTER_RANGE, "gid", 0, 20 ), sphJoinFilters ( CreateFilter ( SPH_FILTER_RANGE, "big", 0, 20LL << 32 ), sphJoinFilters ( CreateValuesFilter ( "gid", { dValues, sizeof ( dValues ) / sizeof ( dValues[0] ) } ), CreateFilter ( SPH_FILTER_RANGE, "gid", 5, 5, true ) ) ) ) );
+
+	// a filter over a dynamic attr keeps the whole tree on per-match evaluation
+	CSphSchema tDynamic;
+	tDynamic.AddAttr ( CSphColumnInfo ( "gid", SPH_ATTR_INTEGER ), true );
+	m_tCtx.m_pMatchSchema = &tDynamic;
+	auto pDynamic = CreateFilter ( SPH_FILTER_RANGE, "gid", 0, 20 );
+	m_tCtx.m_pMatchSchema = &m_tSchema;
+	ASSERT_FALSE ( sphJoinFilters ( CreateFilter ( SPH_FILTER_RANGE, "gid", 0, 20 ), std::move ( pDynamic ) )->CanEvalRows() );
+}
+
+
+TEST_F ( filter_rows, expressions )
+{
+	// expressions over plain row attrs are evaluated with batch calls
+	CheckRows ( *CreateFilter ( SPH_FILTER_RANGE, "gid*3-max(gid,20)", 10, 60 ) );
+	CheckRows ( *CreateFilter ( SPH_FILTER_RANGE, "big+gid", -( 3LL << 32 ), 9LL << 32 ) );
+	CheckRows ( *CreateFloatFilter ( "sqrt(gid)*1.5", 2.0f, 8.0f ) );
+	CheckRows ( *CreateFilter ( SPH_FILTER_EXPRESSION, "gid>=10 and big<0", 0, 0 ) );
+	CheckRows ( *CreateFilter ( SPH_FILTER_EXPRESSION, "abs(gid-25)<=7", 0, 0 ) );
+
+	SphAttr_t dValues[] = { 0, 4, 8, 12 };
+	CheckRows ( *CreateValuesFilter ( "gid%16", { dValues, sizeof ( dValues ) / sizeof ( dValues[0] ) } ) );
+	CheckRows ( *sphJoinFilters ( CreateFilter ( SPH_FILTER_RANGE, "gid", 0, 30 ), CreateFilter ( SPH_FILTER_RANGE, "gid+big", 0, 100LL << 32 ) ) );
+
+	// expressions that read dynamic attrs stay on per-match evaluation
+	CSphSchema tDynamic;
+	tDynamic.AddAttr ( CSphColumnInfo ( "gid", SPH_ATTR_INTEGER ), true );
+	m_tCtx.m_pMatchSchema = &tDynamic;
+	auto pDynamic = CreateFilter ( SPH_FILTER_RANGE, "gid*2", 0, 20 );
+	m_tCtx.m_pMatchSchema = &m_tSchema;
+	ASSERT_TRUE ( pDynamic );
+	ASSERT_FALSE ( pDynamic->CanEvalRows() );
+}
+
+
+TEST ( filter_bitmap_key, full_compare )
+{
+	CSphFilterSettings tFilter;
+	tFilter.m_sAttrName = "gid";
+	tFilter.m_eType = SPH_FILTER_VALUES;
+	for ( SphAttr_t tValue : { 1, 5, 9 } )
+		tFilter.m_dValues.Add ( tValue );
+
+	SIBitmapKey_t tKey ( tFilter, SPH_COLLATION_DEFAULT, 0, 100 );
+	SIBitmapKey_t tSame ( tFilter, SPH_COLLATION_DEFAULT, 0, 100 );
+	ASSERT_EQ ( tKey.m_uHash, tSame.m_uHash );
+	ASSERT_TRUE ( tKey==tSame );
+
+	// external values are copied into the key, same values give the same key
+	CSphFilterSettings tExt;
+	tExt.m_sAttrName = "gid";
+	tExt.m_eType = SPH_FILTER_VALUES;
+	SphAttr_t dExt[] = { 1, 5, 9 };
+	tExt.SetExternalValues ( { dExt, 3 } );
+	ASSERT_TRUE ( tKey==SIBitmapKey_t ( tExt, SPH_COLLATION_DEFAULT, 0, 100 ) );
+
+	ASSERT_FALSE ( tKey==SIBitmapKey_t ( tFilter, SPH_COLLATION_DEFAULT, 0, 99 ) );
+	ASSERT_FALSE ( tKey==SIBitmapKey_t ( tFilter, SPH_COLLATION_BINARY, 0, 100 ) );
+
+	CSphFilterSettings tOther = tFilter;
+	tOther.m_dValues.Last() = 10;
+	ASSERT_FALSE ( tKey==SIBitmapKey_t ( tOther, SPH_COLLATION_DEFAULT, 0, 100 ) );
+
+	tOther = tFilter;
+	tOther.m_sAttrName = "big";
+	ASSERT_FALSE ( tKey==SIBitmapKey_t ( tOther, SPH_COLLATION_DEFAULT, 0, 100 ) );
+
+	tOther = tFilter;
+	tOther.m_bExclude = true;
+	ASSERT_FALSE ( tKey==SIBitmapKey_t ( tOther, SPH_COLLATION_DEFAULT, 0, 100 ) );
+
+	CSphFilterSettings tStr;
+	tStr.m_sAttrName = "s";
+	tStr.m_eType = SPH_FILTER_STRING_LIST;
+	tStr.m_dStrings.Add ( "a" );
+	tStr.m_dStrings.Add ( "b" );
+	CSphFilterSettings tStr2 = tStr;
+	tStr2.m_dStrings.Last() = "c";
+	ASSERT_TRUE ( SIBitmapKey_t ( tStr, SPH_COLLATION_DEFAULT, 0, 100 )==SIBitmapKey_t ( tStr, SPH_COLLATION_DEFAULT, 0, 100 ) );
+	ASSERT_FALSE ( SIBitmapKey_t ( tStr, SPH_COLLATION_DEFAULT, 0, 100 )==SIBitmapKey_t ( tStr2, SPH_COLLATION_DEFAULT, 0, 100 ) );
+
+	// float ranges compare the float halves of the min/max unions only
+	CSphFilterSettings tFloat;
+	tFloat.m_sAttrName = "f";
+	tFloat.m_eType = SPH_FILTER_FLOATRANGE;
+	tFloat.m_iMinValue = 0;
+	tFloat.m_iMaxValue = 0;
+	tFloat.m_fMinValue = 1.5f;
+	tFloat.m_fMaxValue = 2.5f;
+	CSphFilterSettings tFloat2 = tFloat;
+	tFloat2.m_fMaxValue = 3.5f;
+	ASSERT_TRUE ( SIBitmapKey_t ( tFloat, SPH_COLLATION_DEFAULT, 0, 100 )==SIBitmapKey_t ( tFloat, SPH_COLLATION_DEFAULT, 0, 100 ) );
+	ASSERT_FALSE ( SIBitmapKey_t ( tFloat, SPH_COLLATION_DEFAULT, 0, 100 )==SIBitmapKey_t ( tFloat2, SPH_COLLATION_DEFAULT, 0, 100 ) );
+}
@@ -21,6 +21,10 @@
 #include "conversion.h"
 #include "digest_sha1.h"
 #include "std/openhash.h"
+#include "std/roaring.h"
+#include "timeout_queue.h"
+#include "distinct.h"
+#include "indexformat.h"
 
 // Miscelaneous short functional tests: TDigest, SpanSearch,
 // stringbuilder, CJson, TaggedHash, Log2
@@ -342,6 +346,224 @@ TEST_F ( TZip, BE32 )
 	}
 }
 
+TEST_F ( TZip, BE32bulk )
+{
+	const BYTE* pBuf = dBufBE.begin();
+	DWORD dBlock[128];
+	int iRef = 0;
+	while ( iRef<dValues32.GetLength() )
+	{
+		int iDecoded = UnzipIntsBE ( pBuf, dBufBE.end(), dBlock, 128 );
+		ASSERT_GT ( iDecoded, 0 );
+		for ( int i = 0; i<iDecoded; ++i )
+			ASSERT_EQ ( dValues32[iRef++], dBlock[i] );
+	}
+	ASSERT_EQ ( pBuf, dBufBE.end() );
+}
+
+// long runs of 1-byte values (vector path), zero terminator and a value cut by the end of buffer
+TEST ( functions, UnzipIntsBE_stops )
+{
+	CSphVector<DWORD> dValues;
+	for ( int i = 0; i<40; ++i )
+		dValues.Add ( i%2 ? 1+i : 300*i+1 );
+	for ( int i = 0; i<40; ++i )
+		dValues.Add ( 1+i%127 );
+	dValues.Add ( 0 );
+	dValues.Add ( 5 );
+	dValues.Add ( 100000 );
+
+	CSphVector<BYTE> dBuf;
+	for ( auto uValue : dValues )
+		ZipValueBE ( [&dBuf] ( BYTE b ) mutable { dBuf.Add ( b ); }, uValue );
+
+	DWORD dBlock[128];
+	const BYTE* pBuf = dBuf.begin();
+	int iDecoded = UnzipIntsBE ( pBuf, dBuf.end(), dBlock, 128 );
+	ASSERT_EQ ( iDecoded, 81 );
+	for ( int i = 0; i<iDecoded; ++i )
+		ASSERT_EQ ( dValues[i], dBlock[i] );
+
+	// max count is respected
+	pBuf = dBuf.begin();
+	ASSERT_EQ ( UnzipIntsBE ( pBuf, dBuf.end(), dBlock, 50 ), 50 );
+	ASSERT_EQ ( dValues[49], dBlock[49] );
+
+	// incomplete value at the end is left in the buffer
+	pBuf = dBuf.begin() + dBuf.GetLength() - 4;
+	ASSERT_EQ ( UnzipIntsBE ( pBuf, dBuf.end()-1, dBlock, 128 ), 1 );
+	ASSERT_EQ ( 5u, dBlock[0] );
+	ASSERT_EQ ( pBuf, dBuf.end()-3 );
+}
+
+// every bit width, and the max value of each width
+TEST ( functions, DoclistBlockPack )
+{
+	DWORD dDeltas[DOCLIST_BLOCK_DOCS];
+	DWORD dUnpacked[DOCLIST_BLOCK_DOCS];
+	BYTE dPacked[DOCLIST_BLOCK_DOCS*sizeof(DWORD)];
+	sphSrand ( 0 );
+	for ( int iBits = 0; iBits<=32; ++iBits )
+	{
+		DWORD uMask = iBits==32 ? 0xFFFFFFFFUL : ( 1UL<<iBits )-1;
+		for ( auto & uDelta : dDeltas )
+			uDelta = sphRand() & uMask;
+		dDeltas[DOCLIST_BLOCK_DOCS/2] = uMask;
+
+		ASSERT_EQ ( DoclistBlockBits ( dDeltas ), iBits );
+		DoclistBlockPack ( dDeltas, iBits, dPacked );
+		memset ( dUnpacked, 0xAB, sizeof(dUnpacked) );
+		DoclistBlockUnpack ( dPacked, iBits, dUnpacked );
+		for ( int i = 0; i<DOCLIST_BLOCK_DOCS; ++i )
+			ASSERT_EQ ( dDeltas[i], dUnpacked[i] ) << "bits " << iBits << ", delta " << i;
+	}
+}
+
+// two full blocks and a tail, as doclist_format=block lays them out
+TEST ( functions, DoclistWriter )
+{
+	const CSphString sTmpDoclist = "__doclist.tmp";
+	const int DOCS = 2*DOCLIST_BLOCK_DOCS + 44;
+	CSphString sError;
+	{
+		CSphWriter tWriter;
+		ASSERT_TRUE ( tWriter.OpenFile ( sTmpDoclist, sError ) );
+		DoclistWriter_c tDoclist ( tWriter, DoclistFormat_e::BLOCK );
+		for ( int i = 0; i<DOCS; ++i )
+		{
+			tDoclist.BeginEntry ( 1+i%7 );
+			tDoclist.ZipInt ( i );
+			tDoclist.ZipOffset ( 1000*i );
+			tDoclist.EndEntry();
+		}
+		tDoclist.EndList();
+		tWriter.CloseFile();
+	}
+
+	CSphAutoreader tReader;
+	ASSERT_TRUE ( tReader.Open ( sTmpDoclist, sError ) );
+	DWORD dDeltas[DOCLIST_BLOCK_DOCS];
+	BYTE dPacked[DOCLIST_BLOCK_DOCS*sizeof(DWORD)];
+	int iDoc = 0;
+	for ( int iBlock = 0; iBlock<2; ++iBlock )
+	{
+		int iBits = tReader.GetByte();
+		ASSERT_EQ ( iBits, 3 );
+		tReader.GetBytes ( dPacked, iBits*16 );
+		DoclistBlockUnpack ( dPacked, iBits, dDeltas );
+		for ( int i = 0; i<DOCLIST_BLOCK_DOCS; ++i, ++iDoc )
+		{
+			ASSERT_EQ ( dDeltas[i], DWORD ( 1+iDoc%7 ) );
+			ASSERT_EQ ( tReader.UnzipInt(), DWORD ( iDoc ) );
+			ASSERT_EQ ( tReader.UnzipOffset(), uint64_t ( 1000*iDoc ) );
+		}
+	}
+
+	ASSERT_EQ ( tReader.GetByte(), DOCLIST_TAIL_BLOCK );
+	for ( ; iDoc<DOCS; ++iDoc )
+	{
+		ASSERT_EQ ( tReader.UnzipInt(), DWORD ( 1+iDoc%7 ) );
+		ASSERT_EQ ( tReader.UnzipInt(), DWORD ( iDoc ) );
+		ASSERT_EQ ( tReader.UnzipOffset(), uint64_t ( 1000*iDoc ) );
+	}
+	ASSERT_EQ ( tReader.UnzipInt(), 0u );
+	ASSERT_EQ ( tReader.GetPos(), tReader.GetFilesize() );
+
+	tReader.Close();
+	unlink ( sTmpDoclist.cstr() );
+}
+
+// sparse and dense containers, unordered adds, intersection and resumable fetch
+TEST ( functions, roaring_bitmap )
+{
+	RoaringBitmap_c tOdd;
+	RoaringBitmap_c tSparse;
+	for ( DWORD i = 0; i<200000; i+=2 )
+		tOdd.Add ( 200000-i-1 ); // descending, so every add goes into the middle
+	for ( DWORD i = 0; i<300000; i+=1000 )
+		tSparse.Add ( i+1 );
+	tSparse.Add ( 70001 );
+
+	ASSERT_EQ ( tOdd.GetCount(), 100000 );
+	ASSERT_EQ ( tSparse.GetCount(), 300 );
+	ASSERT_TRUE ( tOdd.Contains ( 131071 ) );
+	ASSERT_FALSE ( tOdd.Contains ( 131072 ) );
+
+	RoaringBitmap_c tBoth ( tOdd );
+	tBoth.And ( tSparse );
+	ASSERT_EQ ( tBoth.GetCount(), 200 );
+	ASSERT_EQ ( tOdd.GetCount(), 100000 );
+
+	DWORD dOut[64];
+	int64_t iFrom = 150000;
+	ASSERT_EQ ( tBoth.Fetch ( iFrom, dOut, 64 ), 50 );
+	ASSERT_EQ ( dOut[0], 150001u );
+	ASSERT_EQ ( dOut[49], 199001u );
+	ASSERT_EQ ( tBoth.Fetch ( iFrom, dOut, 64 ), 0 );
+
+	iFrom = 0;
+	int64_t iTotal = 0;
+	DWORD uLast = 0;
+	for ( int iFetched; ( iFetched = tOdd.Fetch ( iFrom, dOut, 64 ) )>0; iTotal += iFetched )
+	{
+		ASSERT_TRUE ( !iTotal || dOut[0]==uLast+2 );
+		uLast = dOut[iFetched-1];
+	}
+	ASSERT_EQ ( iTotal, 100000 );
+	ASSERT_EQ ( uLast, 199999u );
+}
+
+TEST ( functions, timeout_wheel )
+{
+	// same ops on the wheel and on the heap; roots must always have the same time
+	const int TIMERS = 1000;
+	CSphFixedVector<EnqueuedTimeout_t> dWheelTimers ( TIMERS ), dHeapTimers ( TIMERS );
+	TimeoutWheel_c tWheel;
+	TimeoutQueue_c tHeap;
+	int64_t iNow = 1000000;
+
+	for ( int i = 0; i<100000; ++i )
+	{
+		int iTimer = sphRand() % TIMERS;
+		switch ( sphRand() % 4 )
+		{
+		case 0:
+		case 1:
+		{
+			// mostly near, sometimes beyond the wheel span, sometimes already expired
+			int64_t iSpan = ( sphRand() % 8 ) ? sphRand() % 5000000 : int64_t ( sphRand() ) << 16;
+			dWheelTimers[iTimer].m_iTimeoutTimeUS = dHeapTimers[iTimer].m_iTimeoutTimeUS = Max ( iNow + iSpan - 3000, 1 );
+			tWheel.Change ( &dWheelTimers[iTimer] );
+			tHeap.Change ( &dHeapTimers[iTimer] );
+			break;
+		}
+
+		case 2:
+			tWheel.Remove ( &dWheelTimers[iTimer] );
+			tHeap.Remove ( &dHeapTimers[iTimer] );
+			ASSERT_EQ ( dWheelTimers[iTimer].m_iTimeoutIdx, -1 );
+			break;
+
+		default:
+		{
+			auto * pWheelRoot = tWheel.Root();
+			auto * pHeapRoot = tHeap.Root();
+			ASSERT_EQ ( !pWheelRoot, !pHeapRoot );
+			if ( !pWheelRoot )
+				break;
+
+			ASSERT_EQ ( pWheelRoot->m_iTimeoutTimeUS, pHeapRoot->m_iTimeoutTimeUS );
+			iNow = Max ( iNow, pWheelRoot->m_iTimeoutTimeUS );
+			tHeap.Remove ( &dHeapTimers[pWheelRoot-dWheelTimers.Begin()] );
+			tWheel.Pop();
+			break;
+		}
+		}
+
+		ASSERT_EQ ( tWheel.IsEmpty(), tHeap.IsEmpty() );
+	}
+}
+
 TEST_F ( TZip, BE64 )
 {
 	const BYTE* pBuf = dBufBE64.begin();
@@ -2295,3 +2517,121 @@ TEST ( functions, openhash_iterations )
 	ASSERT_TRUE (I->second==nullptr);
 	ASSERT_EQ(I, hHash.end());
 }
+
+static void AddDistinctValues ( UniqHLLSingle_c & tUniq, SphAttr_t iFrom, SphAttr_t iTo )
+{
+	for ( SphAttr_t i = iFrom; i<iTo; ++i )
+		tUniq.Add ( { 0, i, 1 } );
+}
+
+static void MergeDistinctSketch ( UniqHLLSingle_c & tDst, const UniqHLLSingle_c & tSrc )
+{
+	CSphVector<BYTE> dSketch;
+	tSrc.SaveSketch ( 0, dSketch );
+	ASSERT_TRUE ( tDst.MergeSketch ( 0, { dSketch.Begin(), dSketch.GetLength() } ) );
+}
+
+// sketches of overlapping subsets merge into the same estimate as the union counted at once
+TEST ( functions, distinct_sketch_merge )
+{
+	for ( int iAgentAccuracy : { 14, 16, 18 } )
+	{
+		UniqHLLSingle_c tAgent1, tAgent2, tSmall, tMaster, tAll;
+		for ( auto * pUniq : { &tAgent1, &tAgent2, &tSmall } )
+			pUniq->SetAccuracy ( iAgentAccuracy );
+		for ( auto * pUniq : { &tMaster, &tAll } )
+			pUniq->SetAccuracy ( 14 );
+
+		AddDistinctValues ( tAgent1, 0, 100000 );
+		AddDistinctValues ( tAgent2, 50000, 150000 );
+		AddDistinctValues ( tSmall, 149990, 150010 );
+		AddDistinctValues ( tAll, 0, 150010 );
+
+		MergeDistinctSketch ( tMaster, tSmall );
+		ASSERT_EQ ( tMaster.CountDistinct(), 20 );
+
+		MergeDistinctSketch ( tMaster, tAgent1 );
+		MergeDistinctSketch ( tMaster, tAgent2 );
+		ASSERT_EQ ( tMaster.CountDistinct(), tAll.CountDistinct() );
+	}
+
+	// registers can't be made more accurate
+	UniqHLLSingle_c tCoarse, tFine;
+	tCoarse.SetAccuracy ( 14 );
+	tFine.SetAccuracy ( 16 );
+	AddDistinctValues ( tCoarse, 0, 100000 );
+
+	CSphVector<BYTE> dSketch;
+	tCoarse.SaveSketch ( 0, dSketch );
+	ASSERT_FALSE ( tFine.MergeSketch ( 0, { dSketch.Begin(), dSketch.GetLength() } ) );
+	ASSERT_FALSE ( tFine.MergeSketch ( 0, { dSketch.Begin(), 1 } ) );
+}
+
+// groups from agents without sketches only have their counts, which are added up on top of the merged sketches
+TEST ( functions, distinct_sketchless_counts )
+{
+	UniqHLLSingle_c tAgent;
+	AddDistinctValues ( tAgent, 0, 10 );
+
+	UniqHLL_c tMaster, tCopy;
+	CSphVector<BYTE> dSketch;
+	tAgent.SaveSketch ( 0, dSketch );
+	ASSERT_TRUE ( tMaster.MergeSketch ( 1, { dSketch.Begin(), dSketch.GetLength() } ) );
+	tMaster.AddCount ( 1, 5 );
+	tMaster.AddCount ( 2, 7 );
+	tMaster.AddCount ( 2, 3 );
+	tMaster.CopyTo ( tCopy );
+
+	for ( auto * pUniq : { &tMaster, &tCopy } )
+	{
+		CSphVector<int> dCounts { 3 };
+		SphGroupKey_t uGroup;
+		for ( int iCount = pUniq->CountStart ( uGroup ); iCount; iCount = pUniq->CountNext ( uGroup ) )
+			dCounts[(int)uGroup] = iCount;
+
+		ASSERT_EQ ( dCounts[1], 15 );
+		ASSERT_EQ ( dCounts[2], 10 );
+	}
+}
+
+
+static void CheckHitBlockSort ( int iThreads, int iHits, int iWords=1000 )
+{
+	CSphVector<CSphWordHit> dHits;
+	sphSrand ( 0 );
+	for ( int i=0; i<iHits; ++i )
+		dHits.Add ( { RowID_t ( i/3 ), SphWordID_t ( sphRand() % iWords ), HITMAN::Create ( i%2, i%3+1 ) } );
+
+	// hits are unique, so any correct sort gives exactly the sequential order
+	CSphVector<CSphWordHit> dSequential ( dHits );
+	HitBlockSorter_c ( 1 ).Sort ( dSequential.Begin(), iHits );
+
+	HitBlockSorter_c tParallel ( iThreads );
+	tParallel.Sort ( dHits.Begin(), iHits );
+	ASSERT_EQ ( dHits.GetLength(), dSequential.GetLength() );
+	ARRAY_FOREACH ( i, dHits )
+		ASSERT_EQ ( dHits[i], dSequential[i] ) << "threads " << iThreads << ", hits " << iHits << ", at " << i;
+
+	// same sorter again, its worker threads are reused between blocks
+	for ( auto & tHit : dHits )
+		tHit.m_uWordID = sphRand() % iWords;
+	dSequential = dHits;
+	HitBlockSorter_c ( 1 ).Sort ( dSequential.Begin(), iHits );
+	tParallel.Sort ( dHits.Begin(), iHits );
+	ARRAY_FOREACH ( i, dHits )
+		ASSERT_EQ ( dHits[i], dSequential[i] ) << "threads " << iThreads << ", hits " << iHits << ", second block at " << i;
+}
+
+
+TEST ( functions, HitBlockSorter )
+{
+	const int MIN_HITS = HitBlockSorter_c::MIN_PARALLEL_HITS;
+	CheckHitBlockSort ( 2, MIN_HITS*2-1 ); // too small for runs, sorts sequentially
+	CheckHitBlockSort ( 2, MIN_HITS*2 );
+	CheckHitBlockSort ( 3, MIN_HITS*3+7 ); // odd number of runs, uneven split passes
+	CheckHitBlockSort ( 4, MIN_HITS*4+1 );
+	CheckHitBlockSort ( 5, MIN_HITS*5+13 );
+	CheckHitBlockSort ( 16, MIN_HITS*3 ); // fewer runs than threads
+	CheckHitBlockSort ( 4, MIN_HITS*4, 1 ); // single word, runs split by rowid
+	CheckHitBlockSort ( 8, MIN_HITS*8, 3 ); // more runs than words, some splitters are the same word
+}
@@ -0,0 +1,293 @@
+//
+// Copyright (c) 2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org/
+//
+
+#include <gtest/gtest.h>
+
+#include "sphinxqcache.h"
+#include "hazard_pointer.h"
+#include "threadutils.h"
+
+#include <atomic>
+
+// query cache is a global singleton; every test starts from an empty cache with huge limits and no thresholds
+class qcache : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		m_tSaved = QcacheGetStatus();
+		QcacheSetup ( INT64_C(1)<<30, 0, 60 );
+		QcacheClearAll();
+	}
+
+	void TearDown() override
+	{
+		QcacheClearAll();
+		hazard::Shutdown();
+		QcacheSetup ( m_tSaved.m_iMaxBytes, m_tSaved.m_iThreshMs, m_tSaved.m_iTtlS );
+	}
+
+	static CSphQuery MakeQuery()
+	{
+		CSphQuery q;
+		q.m_sQuery = "hello world";
+		return q;
+	}
+
+	QcacheEntryRefPtr_t AddEntry ( int64_t iIndexId ) const
+	{
+		QcacheEntryRefPtr_t pEntry { new QcacheEntry_c };
+		pEntry->m_iIndexId = iIndexId;
+		pEntry->Append ( 1, 10 );
+		pEntry->Append ( 5, 20 );
+		QcacheAdd ( m_tQuery, pEntry, m_tSchema );
+		return pEntry;
+	}
+
+	QcacheEntryRefPtr_t FindEntry ( int64_t iIndexId ) const
+	{
+		return QcacheEntryRefPtr_t { QcacheFind ( iIndexId, m_tQuery, m_tSchema ) };
+	}
+
+	bool IsCached ( const QcacheEntryRefPtr_t & pEntry ) const
+	{
+		return FindEntry ( pEntry->m_iIndexId ).Ptr()==pEntry.Ptr();
+	}
+
+	// index ids which keys fall into the same shard; detected by the per-shard counters
+	CSphVector<int64_t> GetSameShardIds ( int iCount ) const
+	{
+		CSphVector<int64_t> dIds;
+		int iShard = -1;
+		for ( int64_t iId = 1; dIds.GetLength()<iCount && iId<100000; ++iId )
+		{
+			AddEntry(iId);
+			QcacheStatus_t tStatus = QcacheGetStatus();
+			QcacheClearAll();
+
+			int iFound = -1;
+			for ( int i = 0; i<QCACHE_SHARDS; ++i )
+				if ( tStatus.m_dShards[i].m_iCachedQueries )
+					iFound = i;
+
+			if ( iShard<0 )
+				iShard = iFound;
+
+			if ( iFound==iShard )
+				dIds.Add(iId);
+		}
+
+		return dIds;
+	}
+
+	QcacheStatus_t	m_tSaved;
+	CSphQuery		m_tQuery { MakeQuery() };
+	CSphSchema		m_tSchema;
+};
+
+
+TEST_F ( qcache, rehash_keeps_entries )
+{
+	const int NUM_ENTRIES = 3000; // several rehashes in every shard
+	CSphVector<QcacheEntryRefPtr_t> dEntries;
+	for ( int i = 0; i<NUM_ENTRIES; ++i )
+		dEntries.Add ( AddEntry ( i+1 ) );
+
+	QcacheStatus_t tStatus = QcacheGetStatus();
+	ASSERT_EQ ( tStatus.m_iCachedQueries, NUM_ENTRIES );
+	ASSERT_EQ ( tStatus.m_iUsedBytes, NUM_ENTRIES*dEntries[0]->GetSize() );
+	ASSERT_EQ ( tStatus.m_iEvictions, 0 );
+
+	for ( const auto & pEntry : dEntries )
+		ASSERT_TRUE ( IsCached(pEntry) ) << "index id " << pEntry->m_iIndexId;
+
+	ASSERT_FALSE ( FindEntry ( NUM_ENTRIES+1 ) );
+}
+
+
+TEST_F ( qcache, entries_reclaimed )
+{
+	CSphVector<QcacheEntryRefPtr_t> dEntries;
+	for ( int i = 0; i<200; ++i )
+		dEntries.Add ( AddEntry ( i+1 ) );
+
+	for ( const auto & pEntry : dEntries )
+		ASSERT_EQ ( pEntry->GetRefcount(), 2 ) << "ours and the cache one";
+
+	// a reader still holds one of the entries
+	QcacheEntryRefPtr_t pHeld = FindEntry(7);
+	ASSERT_EQ ( pHeld.Ptr(), dEntries[6].Ptr() );
+
+	QcacheClearByIndexId(3);
+	ASSERT_FALSE ( FindEntry(3) );
+
+	QcacheClearAll();
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, 0 );
+	ASSERT_EQ ( QcacheGetStatus().m_iUsedBytes, 0 );
+
+	// deleted entries are retired, not released, until no lookup can see them
+	hazard::Shutdown();
+	ARRAY_FOREACH ( i, dEntries )
+		ASSERT_EQ ( dEntries[i]->GetRefcount(), i==6 ? 2 : 1 ) << "index id " << dEntries[i]->m_iIndexId;
+
+	pHeld = nullptr;
+	ASSERT_EQ ( dEntries[6]->GetRefcount(), 1 );
+}
+
+
+TEST_F ( qcache, clock_second_chance )
+{
+	CSphVector<int64_t> dIds = GetSameShardIds(4);
+	ASSERT_EQ ( dIds.GetLength(), 4 );
+
+	CSphVector<QcacheEntryRefPtr_t> dEntries;
+	for ( auto iId : dIds )
+		dEntries.Add ( AddEntry(iId) );
+
+	// hits mark the 1st and the 3rd entries as recent
+	ASSERT_TRUE ( IsCached ( dEntries[0] ) );
+	ASSERT_TRUE ( IsCached ( dEntries[2] ) );
+
+	// shrink to two entries; the clock has to skip the recent ones and take the others
+	QcacheSetup ( 2*dEntries[0]->GetSize(), 0, 60 );
+
+	QcacheStatus_t tStatus = QcacheGetStatus();
+	ASSERT_EQ ( tStatus.m_iEvictions, 2 );
+	ASSERT_EQ ( tStatus.m_iCachedQueries, 2 );
+	ASSERT_TRUE ( IsCached ( dEntries[0] ) );
+	ASSERT_FALSE ( IsCached ( dEntries[1] ) );
+	ASSERT_TRUE ( IsCached ( dEntries[2] ) );
+	ASSERT_FALSE ( IsCached ( dEntries[3] ) );
+
+	// both survivors were hit again just above; the sweep clears both marks and takes one of them on the second turn
+	QcacheSetup ( dEntries[0]->GetSize(), 0, 60 );
+	ASSERT_EQ ( QcacheGetStatus().m_iEvictions, 3 );
+	ASSERT_EQ ( QcacheGetStatus().m_iCachedQueries, 1 );
+}
+
+
+TEST_F ( qcache, expired_evicted_first )
+{
+	CSphVector<int64_t> dIds = GetSameShardIds(4);
+	ASSERT_EQ ( dIds.GetLength(), 4 );
+
+	CSphVector<QcacheEntryRefPtr_t> dEntries;
+	for ( auto iId : dIds )
+		dEntries.Add ( AddEntry(iId) );
+
+	// all are recent, but the 2nd one is past its ttl
+	for ( const auto & pEntry : dEntries )
+		ASSERT_TRUE ( IsCached(pEntry) );
+	dEntries[1]->m_tmStarted -= INT64_C(120)*1000000;
+
+	QcacheSetup ( 3*dEntries[0]->GetSize(), 0, 60 );
+
+	ASSERT_EQ ( QcacheGetStatus().m_iEvictions, 1 );
+	ASSERT_TRUE ( IsCached ( dEntries[0] ) );
+	ASSERT_FALSE ( IsCached ( dEntries[1] ) );
+	ASSERT_TRUE ( IsCached ( dEntries[2] ) );
+	ASSERT_TRUE ( IsCached ( dEntries[3] ) );
+}
+
+
+TEST_F ( qcache, concurrent_add_find_evict )
+{
+	const int WRITERS = 4;
+	const int READERS = 4;
+	const int PER_WRITER = 2000;
+	const int64_t ID_SPAN = 1000000;
+
+	CSphVector<QcacheEntryRefPtr_t> dEntries[WRITERS];
+	std::atomic<int> dAdded[WRITERS];
+	for ( auto & iAdded : dAdded )
+		iAdded = 0;
+
+	std::atomic<int> iWritersDone {0};
+	std::atomic<int64_t> iBadHits {0};
+	std::atomic<int64_t> iHits {0};
+	int64_t iEntrySize = AddEntry(0)->GetSize();
+	QcacheClearAll();
+
+	CSphVector<SphThread_t> dThreads;
+	dThreads.Resize ( WRITERS+READERS+1 );
+	int iThread = 0;
+
+	for ( int iWriter = 0; iWriter<WRITERS; ++iWriter )
+		ASSERT_TRUE ( Threads::Create ( &dThreads[iThread++], [&, iWriter]
+		{
+			dEntries[iWriter].Reserve ( PER_WRITER );
+			for ( int i = 0; i<PER_WRITER; ++i )
+			{
+				dEntries[iWriter].Add ( AddEntry ( iWriter*ID_SPAN+i ) );
+				dAdded[iWriter].store ( i+1, std::memory_order_release );
+			}
+			iWritersDone.fetch_add(1);
+		}));
+
+	for ( int iReader = 0; iReader<READERS; ++iReader )
+		ASSERT_TRUE ( Threads::Create ( &dThreads[iThread++], [&, iReader]
+		{
+			DWORD uRand = 12345 + iReader;
+			while ( iWritersDone.load()<WRITERS )
+			{
+				uRand = uRand*1103515245 + 12345;
+				int iWriter = ( uRand>>16 ) % WRITERS;
+				int iAdded = dAdded[iWriter].load ( std::memory_order_acquire );
+				if ( !iAdded )
+					continue;
+
+				uRand = uRand*1103515245 + 12345;
+				int64_t iId = iWriter*ID_SPAN + ( uRand>>8 ) % iAdded;
+				QcacheEntryRefPtr_t pFound = FindEntry(iId);
+				if ( !pFound )
+					continue;
+
+				iHits.fetch_add(1);
+				if ( pFound->m_iIndexId!=iId )
+					iBadHits.fetch_add(1);
+			}
+		}));
+
+	// evictor shrinks and grows the cache, and drops single indexes
+	ASSERT_TRUE ( Threads::Create ( &dThreads[iThread++], [&]
+	{
+		for ( int64_t iStep = 0; iWritersDone.load()<WRITERS; ++iStep )
+		{
+			QcacheSetup ( 100*iEntrySize, 0, 60 );
+			QcacheSetup ( INT64_C(1)<<30, 0, 60 );
+			QcacheClearByIndexId ( ( iStep % WRITERS )*ID_SPAN + iStep % PER_WRITER );
+		}
+	}));
+
+	for ( auto & tThread : dThreads )
+		ASSERT_TRUE ( Threads::Join ( &tThread ) );
+
+	ASSERT_EQ ( iBadHits.load(), 0 );
+
+	// shard counters agree with what is actually findable
+	QcacheStatus_t tStatus = QcacheGetStatus();
+	ASSERT_EQ ( tStatus.m_iUsedBytes, tStatus.m_iCachedQueries*iEntrySize );
+
+	int iCached = 0;
+	for ( const auto & dWriterEntries : dEntries )
+	{
+		ASSERT_EQ ( dWriterEntries.GetLength(), PER_WRITER );
+		for ( const auto & pEntry : dWriterEntries )
+			iCached += IsCached(pEntry) ? 1 : 0;
+	}
+	ASSERT_EQ ( iCached, tStatus.m_iCachedQueries );
+
+	// everything evicted or cleared concurrently is eventually released
+	QcacheClearAll();
+	hazard::Shutdown();
+	for ( const auto & dWriterEntries : dEntries )
+		for ( const auto & pEntry : dWriterEntries )
+			ASSERT_EQ ( pEntry->GetRefcount(), 1 ) << "index id " << pEntry->m_iIndexId;
+}
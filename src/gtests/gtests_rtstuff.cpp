@@ -21,6 +21,8 @@
 #include "accumulator.h"
 #include "sphinxudf.h"
 #include "sphinxquery/xqparser.h"
+#include "sphinxjson.h"
+#include "indexfiles.h"
 
 #include <gmock/gmock.h>
 
@@ -241,6 +243,41 @@ protected:
 	CSphDictSettings tDictSettings;
 };
 
+using Matches_t = CSphVector<std::pair<int64_t,int>>;
+
+// runs one query into a fresh sorter; collects ( id, weight ) of every match in the sorter order
+static void RunQuery ( const CSphIndex * pIndex, const CSphQuery & tQuery, const CSphMultiQueryArgs & tArgs, Matches_t & dMatches, AggrResult_t & tResult, int64_t * pTotal = nullptr )
+{
+	SphQueueSettings_t tQueueSettings ( pIndex->GetMatchSchema() );
+	SphQueueRes_t tRes;
+	CSphQueryResult tQueryResult;
+	tQueryResult.m_pMeta = &tResult;
+
+	std::unique_ptr<ISphMatchSorter> pSorter { sphCreateQueue ( tQueueSettings, tQuery, tResult.m_sError, tRes ) };
+	ASSERT_TRUE ( pSorter ) << tResult.m_sError.cstr();
+	ISphMatchSorter * pRawSorter = pSorter.get();
+	ASSERT_TRUE ( pIndex->MultiQuery ( tQueryResult, tQuery, { &pRawSorter, 1 }, tArgs ) ) << tResult.m_sError.cstr();
+	if ( pTotal )
+		*pTotal = pSorter->GetTotalCount();
+
+	const CSphAttrLocator & tId = pSorter->GetSchema()->GetAttr("id")->m_tLocator;
+	auto & tOneRes = tResult.m_dResults.Add();
+	tOneRes.FillFromSorter ( pSorter.get() );
+
+	dMatches.Resize(0);
+	for ( const auto & tMatch : tOneRes.m_dMatches )
+		dMatches.Add ( { tMatch.GetAttr(tId), tMatch.m_iWeight } );
+}
+
+// every doc has 'dog' with a varying tf; 'cat' and 'bird' make some of them much better than the rest
+static void TopKDocText ( int n, CSphString & sTitle, CSphString & sContent )
+{
+	sTitle.SetSprintf ( "%s title%d", ( n%3 ) ? "mouse" : "cat dog bird", n );
+	sContent.SetSprintf ( "content%d%s", n, ( n%7 ) ? "" : " bird" );
+	for ( int j = 0; j<=n%5; ++j )
+		sContent.SetSprintf ( "%s dog", sContent.cstr() );
+}
+
 /*
  * It was instantiated several times, but that wasn't work, since on every instantiation couple of attributes was inserted into schema, having idex's schema the same.
  */
@@ -540,6 +577,131 @@ TEST_F ( RT, RankerFactors )
 }
 
 
+TEST_F ( RT, TopKPruning )
+{
+	using namespace testing;
+	Threads::CallCoroutine ( [&] {
+
+	const int iDocs = 400;
+	StrVec_t dTexts;
+	CSphString sTitle, sContent;
+	for ( int i=0; i<iDocs; ++i )
+	{
+		TopKDocText ( i, sTitle, sContent );
+		dTexts.Add ( sTitle );
+		dTexts.Add ( sContent );
+	}
+
+	CSphVector<const char *> dFields;
+	for ( const auto & sText : dTexts )
+		dFields.Add ( sText.cstr() );
+
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSrcSchema.AddAttr ( tCol, true );
+
+	auto pDict = sphCreateDictionaryCRC ( tDictSettings, NULL, pTok, "rt", false, 32, nullptr, sError );
+
+	auto pSrc = new MockTestDoc_c ( tSrcSchema, (BYTE **)dFields.Begin(), iDocs, 2 );
+
+	EXPECT_CALL ( *pSrc, Connect ( _ ) ).WillOnce ( Return ( true ) );
+	EXPECT_CALL ( *pSrc, GetFieldLengths () ).WillRepeatedly ( Return ( pSrc->m_dFieldLengths.Begin () ) );
+	EXPECT_CALL ( *pSrc, Disconnect () );
+
+	pSrc->SetTokenizer ( pTok );
+	pSrc->SetDict ( pDict );
+
+	pSrc->Setup ( CSphSourceSettings(), nullptr );
+	ASSERT_TRUE ( pSrc->Connect ( sError ) );
+	ASSERT_TRUE ( pSrc->IterateStart ( sError ) );
+
+	ASSERT_TRUE ( pSrc->UpdateSchema ( &tSrcSchema, sError ) );
+
+	CSphSchema tSchema; // source schema must be all dynamic attrs; but index ones must be static
+	for ( int i=0; i<tSrcSchema.GetFieldsCount(); i++ )
+		tSchema.AddField ( tSrcSchema.GetField(i) );
+
+	for ( int i=0; i<tSrcSchema.GetAttrsCount(); i++ )
+		tSchema.AddAttr ( tSrcSchema.GetAttr(i), false );
+
+	auto pIndex = sphCreateIndexRT ( "testrt", RT_INDEX_FILE_NAME, tSchema, 32 * 1024 * 1024, false );
+
+	pIndex->SetTokenizer ( pTok ); // index will own this pair from now on
+	pIndex->SetDictionary ( sphCreateDictionaryCRC ( tDictSettings, nullptr, pTok, "rt", false, 32, nullptr, sError ) );
+	pIndex->PostSetup ();
+	StrVec_t dWarnings;
+	ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+
+	CSphString sFilter;
+	InsertDocData_c tDoc ( pIndex->GetMatchSchema() );
+	int iDynamic = pIndex->GetMatchSchema().GetRowSize();
+
+	RtAccum_t tAcc;
+	bool bEOF = false;
+	while (true)
+	{
+		ASSERT_TRUE ( pSrc->IterateDocument ( bEOF, sError ) );
+		if ( bEOF )
+			break;
+
+		tDoc.m_dFields = pSrc->GetFields();
+		tDoc.m_tDoc.Combine ( pSrc->m_tDocInfo, iDynamic );
+		pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, &tAcc );
+	}
+	pIndex->Commit ( nullptr, &tAcc );
+	pSrc->Disconnect ();
+
+	auto pParser = sphCreatePlainQueryParser();
+
+	// pruned and exhaustive runs must agree on the top-k, but only the exhaustive one counts everything
+	for ( auto eRanker : { SPH_RANK_BM25, SPH_RANK_PROXIMITY_BM25 } )
+	{
+		Matches_t dExpected;
+		int64_t iExpectedTotal = 0;
+		for ( bool bPruning : { false, true } )
+		{
+			CSphQuery tQuery;
+			tQuery.m_sQuery = "cat | dog | bird";
+			tQuery.m_pQueryParser = pParser.get();
+			tQuery.m_eRanker = eRanker;
+			tQuery.m_eSort = SPH_SORT_EXTENDED;
+			tQuery.m_sSortBy = "@weight desc";
+			tQuery.m_iMaxMatches = 10;
+			tQuery.m_bTopKPruning = bPruning;
+
+			AggrResult_t tResult;
+			CSphMultiQueryArgs tArgs ( 1 );
+			Matches_t dMatches;
+			int64_t iTotal = 0;
+			ASSERT_NO_FATAL_FAILURE ( RunQuery ( pIndex.get(), tQuery, tArgs, dMatches, tResult, &iTotal ) );
+			ASSERT_EQ ( dMatches.GetLength(), 10 );
+
+			if ( !bPruning )
+			{
+				dExpected.SwapData ( dMatches );
+				iExpectedTotal = iTotal;
+				ASSERT_EQ ( iTotal, iDocs );
+				ASSERT_FALSE ( tResult.m_bTotalMatchesApprox );
+				continue;
+			}
+
+			ARRAY_FOREACH ( i, dExpected )
+			{
+				ASSERT_EQ ( dMatches[i].first, dExpected[i].first ) << "ranker " << eRanker << ", match " << i;
+				ASSERT_EQ ( dMatches[i].second, dExpected[i].second ) << "ranker " << eRanker << ", match " << i;
+			}
+
+			ASSERT_LT ( iTotal, iExpectedTotal );
+			ASSERT_TRUE ( tResult.m_bTotalMatchesApprox );
+		}
+	}
+
+	SafeDelete ( pSrc );
+	pTok = nullptr; // owned and deleted by index
+	});
+}
+
+
 TEST_F ( RT, SendVsMerge )
 {
 	using namespace testing;
@@ -656,3 +818,787 @@ TEST_F ( RT, SendVsMerge )
 	pTok = nullptr; // owned and deleted by index
 	});
 }
+
+
+// rt table with several disk chunks and a RAM segment: doc n goes to disk chunk (n-1)/RT_CHUNK_DOCS, the last ones stay in RAM
+static const int RT_CHUNKS = 4;
+static const int RT_CHUNK_DOCS = 500;
+static const int RT_RAM_DOCS = 100;
+static const int RT_DOCS = RT_CHUNKS*RT_CHUNK_DOCS + RT_RAM_DOCS;
+
+class RtChunked : public RT
+{
+protected:
+	void TearDown() override
+	{
+		RT::TearDown();
+		DeleteChunks();
+	}
+
+	static void DeleteChunks()
+	{
+		CSphString sName;
+		for ( int iChunk = 0; iChunk<RT_CHUNKS; ++iChunk )
+			for ( const auto & tExt : sphGetExts() )
+			{
+				sName.SetSprintf ( "%s.%d%s", RT_INDEX_FILE_NAME, iChunk, tExt.m_szExt );
+				unlink ( sName.cstr() );
+			}
+	}
+
+	// every table gets its own clone of the tokenizer, so a test may create several of them
+	void CreateIndex ( const CSphSchema & tSchema, std::unique_ptr<RtIndex_i> & pIndex )
+	{
+		pIndex = sphCreateIndexRT ( "testrt", RT_INDEX_FILE_NAME, tSchema, 32 * 1024 * 1024, false );
+		TokenizerRefPtr_c pIndexTok = pTok->Clone ( SPH_CLONE_INDEX );
+		pIndex->SetTokenizer ( pIndexTok );
+		pIndex->SetDictionary ( sphCreateDictionaryCRC ( tDictSettings, nullptr, pIndexTok, "rt", false, 32, nullptr, sError ) );
+		pIndex->PostSetup ();
+		StrVec_t dWarnings;
+		ASSERT_TRUE ( pIndex->Prealloc ( false, nullptr, dWarnings ) );
+	}
+
+	// inserts docs 1..RT_DOCS; fnDoc fills the fields and attributes of doc n
+	void Fill ( RtIndex_i * pIndex, const std::function<void ( int, InsertDocData_c & )> & fnDoc )
+	{
+		InsertDocData_c tDoc ( pIndex->GetMatchSchema() );
+		CSphString sFilter;
+		RtAccum_t tAcc;
+
+		for ( int n = 1; n<=RT_DOCS; ++n )
+		{
+			fnDoc ( n, tDoc );
+			tDoc.SetID(n);
+			ASSERT_TRUE ( pIndex->AddDocument ( tDoc, false, sFilter, sError, sWarning, &tAcc ) ) << sError.cstr();
+
+			if ( n<=RT_CHUNKS*RT_CHUNK_DOCS && n%RT_CHUNK_DOCS==0 )
+			{
+				ASSERT_TRUE ( pIndex->Commit ( nullptr, &tAcc ) );
+				ASSERT_TRUE ( pIndex->ForceDiskChunk() );
+			}
+		}
+		ASSERT_TRUE ( pIndex->Commit ( nullptr, &tAcc ) );
+	}
+
+	static void SetFields ( InsertDocData_c & tDoc, const CSphString & sTitle, const CSphString & sContent )
+	{
+		tDoc.m_dFields[0] = VecTraits_T<const char> ( sTitle.cstr(), sTitle.Length() );
+		tDoc.m_dFields[1] = VecTraits_T<const char> ( sContent.cstr(), sContent.Length() );
+	}
+
+	static CSphSchema FieldsSchema()
+	{
+		CSphSchema tSchema;
+		tSchema.AddField ( "title" );
+		tSchema.AddField ( "content" );
+		tSchema.AddAttr ( CSphColumnInfo ( "id", SPH_ATTR_BIGINT ), false );
+		return tSchema;
+	}
+};
+
+
+// chunk-level and block-level min/max pruning must never change what a query finds
+class RtMinMaxPruning : public RtChunked
+{
+protected:
+	void TearDown() override
+	{
+		SetMinMaxPruning ( true );
+		RtChunked::TearDown();
+	}
+
+	static int64_t IntAttr ( int n )		{ return n*10; }
+	static int64_t BigintAttr ( int n )		{ return n*INT64_C(1000000007); }
+	static float FloatAttr ( int n )		{ return n*0.5f; }
+	static bool HasMva ( int n, int64_t iValue ) { return n%7==iValue || 100+n%11==iValue; }
+	static bool HasJson ( int n )			{ return n%5!=0; }
+	static bool HasBird ( int n )			{ return n%4==0; }
+
+	static CSphFilterSettings Range ( const char * szAttr, int64_t iMin, int64_t iMax, bool bEqual=true )
+	{
+		CSphFilterSettings tFilter;
+		tFilter.m_sAttrName = szAttr;
+		tFilter.m_eType = SPH_FILTER_RANGE;
+		tFilter.m_iMinValue = iMin;
+		tFilter.m_iMaxValue = iMax;
+		tFilter.m_bHasEqualMin = tFilter.m_bHasEqualMax = bEqual;
+		return tFilter;
+	}
+
+	static CSphFilterSettings Values ( const char * szAttr, std::initializer_list<int64_t> dValues )
+	{
+		CSphFilterSettings tFilter;
+		tFilter.m_sAttrName = szAttr;
+		tFilter.m_eType = SPH_FILTER_VALUES;
+		for ( auto iValue : dValues )
+			tFilter.m_dValues.Add ( iValue );
+		tFilter.m_dValues.Uniq();
+		return tFilter;
+	}
+};
+
+
+TEST_F ( RtMinMaxPruning, same_results )
+{
+	Threads::CallCoroutine ( [&] {
+
+	CSphSchema tSchema = FieldsSchema();
+	tSchema.AddAttr ( CSphColumnInfo ( "i", SPH_ATTR_INTEGER ), false );
+	tSchema.AddAttr ( CSphColumnInfo ( "b", SPH_ATTR_BIGINT ), false );
+	tSchema.AddAttr ( CSphColumnInfo ( "f", SPH_ATTR_FLOAT ), false );
+	tSchema.AddAttr ( CSphColumnInfo ( "m", SPH_ATTR_UINT32SET ), false );
+	tSchema.AddAttr ( CSphColumnInfo ( "j", SPH_ATTR_JSON ), false );
+
+	// blob locator goes right after docid, as the daemon does it
+	tSchema.InsertAttr ( 1, CSphColumnInfo ( sphGetBlobLocatorName(), SPH_ATTR_BIGINT ), false );
+	tSchema.AddAttr ( CSphColumnInfo ( "$_tmp", SPH_ATTR_BIGINT ), false );
+	tSchema.RemoveAttr ( "$_tmp", false );
+
+	std::unique_ptr<RtIndex_i> pIndex;
+	ASSERT_NO_FATAL_FAILURE ( CreateIndex ( tSchema, pIndex ) );
+
+	const ISphSchema & tMatchSchema = pIndex->GetMatchSchema();
+	CSphString sTitle, sContent, sJson;
+	CSphVector<BYTE> dJson, dPacked;
+
+	ASSERT_NO_FATAL_FAILURE ( Fill ( pIndex.get(), [&] ( int n, InsertDocData_c & tDoc )
+	{
+		sTitle.SetSprintf ( "common t%d", n );
+		sContent.SetSprintf ( "%sc%d", HasBird(n) ? "bird " : "", n );
+		SetFields ( tDoc, sTitle, sContent );
+
+		tDoc.m_tDoc.SetAttr ( tMatchSchema.GetAttr("i")->m_tLocator, IntAttr(n) );
+		tDoc.m_tDoc.SetAttr ( tMatchSchema.GetAttr("b")->m_tLocator, BigintAttr(n) );
+		tDoc.m_tDoc.SetAttrFloat ( tMatchSchema.GetAttr("f")->m_tLocator, FloatAttr(n) );
+
+		tDoc.ResetMVAs();
+		tDoc.AddMVALength(2);
+		tDoc.AddMVAValue ( n%7 );
+		tDoc.AddMVAValue ( 100+n%11 );
+
+		tDoc.m_dStrings.Resize(0);
+		if ( HasJson(n) )
+		{
+			sJson.SetSprintf ( "{\"x\":%d, \"tag\":%d}", n, n%3 );
+			dJson.Resize(0);
+			ASSERT_TRUE ( sphJsonParse ( dJson, (char *)sJson.cstr(), false, false, true, sError ) ) << sError.cstr();
+			dPacked.Resize ( sphCalcPackedLength ( dJson.GetLength() ) );
+			sphPackPtrAttr ( dPacked.Begin(), dJson );
+			tDoc.m_dStrings.Add ( (const char *)dPacked.Begin() );
+		} else
+			tDoc.m_dStrings.Add ( nullptr );
+	} ) );
+
+	auto pParser = sphCreatePlainQueryParser();
+
+	auto fnSearch = [&] ( const char * szQuery, const CSphVector<CSphFilterSettings> & dFilters, CSphVector<int64_t> & dIds, IteratorStats_t & tStats )
+	{
+		CSphQuery tQuery;
+		tQuery.m_sQuery = szQuery;
+		tQuery.m_pQueryParser = pParser.get();
+		tQuery.m_dFilters = dFilters;
+		tQuery.m_eSort = SPH_SORT_EXTENDED;
+		tQuery.m_sSortBy = "id asc";
+		tQuery.m_iMaxMatches = RT_DOCS;
+
+		AggrResult_t tResult;
+		CSphMultiQueryArgs tArgs ( 1 );
+		Matches_t dMatches;
+		ASSERT_NO_FATAL_FAILURE ( RunQuery ( pIndex.get(), tQuery, tArgs, dMatches, tResult ) );
+
+		dIds.Resize(0);
+		for ( const auto & tMatch : dMatches )
+			dIds.Add ( tMatch.first );
+		dIds.Sort();
+		tStats = tResult.m_tIteratorStats;
+	};
+
+	struct Case_t
+	{
+		const char *						m_szName;
+		CSphVector<CSphFilterSettings>		m_dFilters;
+		std::function<bool(int)>			m_fnMatch;
+	};
+
+	CSphVector<Case_t> dCases;
+	auto fnAdd = [&dCases] ( const char * szName, std::function<bool(int)> fnMatch, std::initializer_list<CSphFilterSettings> dFilters )
+	{
+		auto & tCase = dCases.Add();
+		tCase.m_szName = szName;
+		tCase.m_fnMatch = std::move ( fnMatch );
+		for ( const auto & tFilter : dFilters )
+			tCase.m_dFilters.Add ( tFilter );
+	};
+	// exact chunk boundaries: the 2nd chunk holds docs 501..1000
+	fnAdd ( "int range on chunk bounds", [] ( int n ) { return n>=501 && n<=1000; }, { Range ( "i", IntAttr(501), IntAttr(1000) ) } );
+	fnAdd ( "int range off by one", [] ( int n ) { return n>=500 && n<=1001; }, { Range ( "i", IntAttr(500), IntAttr(1001) ) } );
+	fnAdd ( "int range, exclusive bounds", [] ( int n ) { return n>=501 && n<=1000; }, { Range ( "i", IntAttr(500), IntAttr(1001), false ) } );
+	fnAdd ( "int range inside a chunk", [] ( int n ) { return n>=700 && n<=899; }, { Range ( "i", IntAttr(700), IntAttr(899) ) } );
+	fnAdd ( "int range above all", [] ( int ) { return false; }, { Range ( "i", IntAttr(RT_DOCS+1), IntAttr(RT_DOCS*2) ) } );
+	fnAdd ( "int range below all", [] ( int ) { return false; }, { Range ( "i", 0, IntAttr(1)-1 ) } );
+	fnAdd ( "int values at bounds", [] ( int n ) { return n==1 || n==500 || n==501 || n==2000 || n==RT_DOCS; },
+		{ Values ( "i", { IntAttr(1)-1, IntAttr(1), IntAttr(500), IntAttr(501), IntAttr(2000), IntAttr(RT_DOCS), IntAttr(RT_DOCS)+1 } ) } );
+	fnAdd ( "int values nowhere", [] ( int ) { return false; }, { Values ( "i", { 5, 15, IntAttr(RT_DOCS)+10 } ) } );
+	fnAdd ( "bigint range", [] ( int n ) { return n>=1000 && n<=1500; }, { Range ( "b", BigintAttr(1000), BigintAttr(1500) ) } );
+
+	CSphFilterSettings tFloat;
+	tFloat.m_sAttrName = "f";
+	tFloat.m_eType = SPH_FILTER_FLOATRANGE;
+	tFloat.m_fMinValue = FloatAttr(1001);
+	tFloat.m_fMaxValue = FloatAttr(1500);
+	fnAdd ( "float range on chunk bounds", [] ( int n ) { return n>=1001 && n<=1500; }, { tFloat } );
+
+	auto tExclude = Range ( "i", IntAttr(501), IntAttr(1000) );
+	tExclude.m_bExclude = true;
+	fnAdd ( "int range excluded", [] ( int n ) { return n<501 || n>1000; }, { tExclude } );
+	fnAdd ( "two ranges on different chunks", [] ( int ) { return false; }, { Range ( "i", IntAttr(1), IntAttr(500) ), Range ( "b", BigintAttr(501), BigintAttr(1000) ) } );
+
+	auto tMva = Values ( "m", { 3 } );
+	tMva.m_eMvaFunc = SPH_MVAFUNC_ANY;
+	fnAdd ( "mva", [] ( int n ) { return HasMva ( n, 3 ); }, { tMva } );
+
+	auto tMvaBig = Values ( "m", { 105 } );
+	tMvaBig.m_eMvaFunc = SPH_MVAFUNC_ANY;
+	fnAdd ( "mva and int range", [] ( int n ) { return HasMva ( n, 105 ) && n>=1001 && n<=1500; }, { tMvaBig, Range ( "i", IntAttr(1001), IntAttr(1500) ) } );
+
+	fnAdd ( "json range", [] ( int n ) { return HasJson(n) && n>=1000 && n<=1600; }, { Range ( "j.x", 1000, 1600 ) } );
+	fnAdd ( "json and int range", [] ( int n ) { return HasJson(n) && n>=1501 && n<=1550; }, { Range ( "j.x", 1, 1550 ), Range ( "i", IntAttr(1501), IntAttr(2000) ) } );
+
+	CSphFilterSettings tNull;
+	tNull.m_sAttrName = "j.x";
+	tNull.m_eType = SPH_FILTER_NULL;
+	tNull.m_bIsNull = true;
+	fnAdd ( "json is null", [] ( int n ) { return !HasJson(n); }, { tNull } );
+	fnAdd ( "json is null and int range", [] ( int n ) { return !HasJson(n) && n>=2001; }, { tNull, Range ( "i", IntAttr(2001), IntAttr(RT_DOCS) ) } );
+
+	tNull.m_bIsNull = false;
+	fnAdd ( "json is not null and int range", [] ( int n ) { return HasJson(n) && n<=10; }, { tNull, Range ( "i", 0, IntAttr(10) ) } );
+
+	for ( const auto & tCase : dCases )
+		for ( const char * szQuery : { "", "common", "bird" } )
+		{
+			CSphVector<int64_t> dExpected;
+			for ( int n = 1; n<=RT_DOCS; ++n )
+				if ( tCase.m_fnMatch(n) && ( strcmp ( szQuery, "bird" ) || HasBird(n) ) )
+					dExpected.Add(n);
+
+			CSphVector<int64_t> dPruned, dUnpruned;
+			IteratorStats_t tPruned, tUnpruned;
+
+			SetMinMaxPruning ( false );
+			fnSearch ( szQuery, tCase.m_dFilters, dUnpruned, tUnpruned );
+			SetMinMaxPruning ( true );
+			fnSearch ( szQuery, tCase.m_dFilters, dPruned, tPruned );
+
+			ASSERT_EQ ( dUnpruned.GetLength(), dExpected.GetLength() ) << tCase.m_szName << ", query '" << szQuery << "'";
+			ASSERT_EQ ( dPruned.GetLength(), dExpected.GetLength() ) << tCase.m_szName << ", query '" << szQuery << "'";
+			ARRAY_FOREACH ( i, dExpected )
+			{
+				ASSERT_EQ ( dUnpruned[i], dExpected[i] ) << tCase.m_szName << ", query '" << szQuery << "'";
+				ASSERT_EQ ( dPruned[i], dExpected[i] ) << tCase.m_szName << ", query '" << szQuery << "'";
+			}
+		}
+
+	// and pruning actually happened where it could: all the disk chunks but one and the only RAM segment
+	CSphVector<int64_t> dIds;
+	IteratorStats_t tStats;
+	fnSearch ( "", dCases[0].m_dFilters, dIds, tStats );
+	ASSERT_EQ ( tStats.m_iPrunedChunks, RT_CHUNKS );
+
+	fnSearch ( "common", dCases[0].m_dFilters, dIds, tStats );
+	ASSERT_EQ ( tStats.m_iPrunedChunks, RT_CHUNKS );
+
+	// docs which are only in RAM
+	CSphVector<CSphFilterSettings> dRamOnly;
+	dRamOnly.Add ( Range ( "i", IntAttr ( RT_CHUNKS*RT_CHUNK_DOCS+1 ), IntAttr(RT_DOCS) ) );
+	fnSearch ( "common", dRamOnly, dIds, tStats );
+	ASSERT_EQ ( dIds.GetLength(), RT_RAM_DOCS );
+	ASSERT_EQ ( tStats.m_iPrunedChunks, RT_CHUNKS );
+
+	fnSearch ( "common", dCases[3].m_dFilters, dIds, tStats );
+	ASSERT_GT ( tStats.m_iPrunedBlocks, 0 );
+
+	SetMinMaxPruning ( false );
+	fnSearch ( "common", dCases[3].m_dFilters, dIds, tStats );
+	ASSERT_EQ ( tStats.m_iPrunedBlocks, 0 );
+	ASSERT_EQ ( tStats.m_iPrunedChunks, 0 );
+	});
+}
+
+
+// top-k pruning floor is shared by the disk chunks of an rt index and by the pseudo-shards of each chunk;
+// a shared floor must never push out a doc which belongs to the top-k
+class RtTopKPruning : public RtChunked
+{
+protected:
+	void SetUp() override
+	{
+		RtChunked::SetUp();
+		m_iSavedThresh = GetPseudoShardingThresh();
+		SetPseudoShardingThresh(0); // chunks are small, but still have to be split
+	}
+
+	void TearDown() override
+	{
+		SetPseudoShardingThresh ( m_iSavedThresh );
+		RtChunked::TearDown();
+	}
+
+	int m_iSavedThresh = 0;
+};
+
+
+TEST_F ( RtTopKPruning, chunks_and_shards )
+{
+	Threads::CallCoroutine ( [&] {
+
+	std::unique_ptr<RtIndex_i> pIndex;
+	ASSERT_NO_FATAL_FAILURE ( CreateIndex ( FieldsSchema(), pIndex ) );
+
+	// every doc has 'dog', so all of them match; the best ones are spread over all the chunks
+	CSphString sTitle, sContent;
+	ASSERT_NO_FATAL_FAILURE ( Fill ( pIndex.get(), [&] ( int n, InsertDocData_c & tDoc )
+	{
+		TopKDocText ( n, sTitle, sContent );
+		SetFields ( tDoc, sTitle, sContent );
+	} ) );
+
+	auto pParser = sphCreatePlainQueryParser();
+
+	const int TOP_K = 10;
+	auto fnSearch = [&] ( ESphRankMode eRanker, int iThreads, int iMaxMatches, bool bPruning, int64_t iFloor, Matches_t & dMatches, int64_t & iTotal )
+	{
+		CSphQuery tQuery;
+		tQuery.m_sQuery = "cat | dog | bird";
+		tQuery.m_pQueryParser = pParser.get();
+		tQuery.m_eRanker = eRanker;
+		tQuery.m_eSort = SPH_SORT_EXTENDED;
+		tQuery.m_sSortBy = "@weight desc";
+		tQuery.m_iMaxMatches = iMaxMatches;
+		tQuery.m_iConcurrency = iThreads; // no cap on threads for full-text
+		tQuery.m_bTopKPruning = bPruning;
+
+		// a floor known in advance, as an agent gets it from the master
+		std::atomic<int64_t> iTopKFloor { iFloor };
+		AggrResult_t tResult;
+		CSphMultiQueryArgs tArgs ( 1 );
+		tArgs.m_iThreads = iThreads;
+		if ( iFloor )
+			tArgs.m_pTopKFloor = &iTopKFloor;
+
+		ASSERT_NO_FATAL_FAILURE ( RunQuery ( pIndex.get(), tQuery, tArgs, dMatches, tResult, &iTotal ) );
+	};
+
+	for ( auto eRanker : { SPH_RANK_BM25, SPH_RANK_PROXIMITY_BM25 } )
+		for ( int iThreads : { 1, 16 } )
+		{
+			// weights depend on how the chunks are split, so the reference is exhaustive with the same split
+			Matches_t dAll;
+			int64_t iTotal = 0;
+			fnSearch ( eRanker, iThreads, RT_DOCS, false, 0, dAll, iTotal );
+			ASSERT_EQ ( dAll.GetLength(), RT_DOCS );
+			ASSERT_EQ ( iTotal, RT_DOCS );
+
+			CSphVector<int> dWeights { RT_DOCS+1 };
+			dWeights.Fill(-1);
+			for ( const auto & tMatch : dAll )
+				dWeights[tMatch.first] = tMatch.second;
+
+			struct Run_t
+			{
+				bool	m_bPruning;
+				int		m_iMaxMatches;
+				int64_t	m_iFloor;
+			};
+
+			// off and on with default max_matches; then on as agents get it, with a queue of just offset+limit,
+			// and finally with the k-th weight another agent has already reported
+			for ( const Run_t & tRun : { Run_t { false, DEFAULT_MAX_MATCHES, 0 }, Run_t { true, DEFAULT_MAX_MATCHES, 0 }, Run_t { true, TOP_K, 0 }, Run_t { true, TOP_K, dAll[TOP_K-1].second } } )
+			{
+				Matches_t dTop;
+				fnSearch ( eRanker, iThreads, tRun.m_iMaxMatches, tRun.m_bPruning, tRun.m_iFloor, dTop, iTotal );
+				ASSERT_GE ( dTop.GetLength(), TOP_K );
+
+				// ties may come in any order, but their weight has to be the true one
+				CSphVector<int64_t> dIds;
+				for ( int i = 0; i<TOP_K; ++i )
+				{
+					auto tWhere = ::testing::Message() << "ranker " << eRanker << ", threads " << iThreads << ", pruning " << tRun.m_bPruning << ", max_matches " << tRun.m_iMaxMatches << ", floor " << tRun.m_iFloor << ", match " << i;
+					ASSERT_EQ ( dTop[i].second, dAll[i].second ) << tWhere;
+					ASSERT_EQ ( dTop[i].second, dWeights[dTop[i].first] ) << tWhere;
+					dIds.Add ( dTop[i].first );
+				}
+				dIds.Uniq();
+				ASSERT_EQ ( dIds.GetLength(), TOP_K );
+
+				if ( tRun.m_bPruning && tRun.m_iMaxMatches==TOP_K && ( iThreads==1 || tRun.m_iFloor ) )
+					ASSERT_LT ( iTotal, RT_DOCS ) << "ranker " << eRanker << ", threads " << iThreads << ", floor " << tRun.m_iFloor;
+			}
+		}
+	});
+}
+
+
+TEST_F ( RtTopKPruning, doclist_blocks )
+{
+	Threads::CallCoroutine ( [&] {
+
+	std::unique_ptr<RtIndex_i> pIndex;
+	ASSERT_NO_FATAL_FAILURE ( CreateIndex ( FieldsSchema(), pIndex ) );
+
+	// every 4th doc has 'dog'; it is frequent only at the start of every chunk, so the skiplist blocks after that
+	// (32 docs each) can't beat the top-k of the first one and are skipped as a whole
+	CSphString sTitle, sContent;
+	ASSERT_NO_FATAL_FAILURE ( Fill ( pIndex.get(), [&] ( int n, InsertDocData_c & tDoc )
+	{
+		sTitle.SetSprintf ( "title%d", n );
+		sContent.SetSprintf ( "content%d", n );
+		if ( n%4==0 )
+			for ( int j = 0; j < ( ( n%RT_CHUNK_DOCS )<100 ? 8 : 1 ); ++j )
+				sContent.SetSprintf ( "%s dog", sContent.cstr() );
+
+		SetFields ( tDoc, sTitle, sContent );
+	} ) );
+
+	auto pParser = sphCreatePlainQueryParser();
+
+	const int TOP_K = 10;
+	auto fnSearch = [&] ( const char * szQuery, ESphRankMode eRanker, int iMaxMatches, bool bPruning, Matches_t & dMatches, int64_t & iPrunedBlocks )
+	{
+		CSphQuery tQuery;
+		tQuery.m_sQuery = szQuery;
+		tQuery.m_pQueryParser = pParser.get();
+		tQuery.m_eRanker = eRanker;
+		tQuery.m_eSort = SPH_SORT_EXTENDED;
+		tQuery.m_sSortBy = "@weight desc";
+		tQuery.m_iMaxMatches = iMaxMatches;
+		tQuery.m_bTopKPruning = bPruning;
+
+		AggrResult_t tResult;
+		CSphMultiQueryArgs tArgs ( 1 );
+		ASSERT_NO_FATAL_FAILURE ( RunQuery ( pIndex.get(), tQuery, tArgs, dMatches, tResult ) );
+		iPrunedBlocks = tResult.m_tIteratorStats.m_iPrunedDoclistBlocks;
+	};
+
+	// single term gets the block bound of its own; with another term, that one's bound gets added to every block
+	for ( const char * szQuery : { "dog", "dog | content7" } )
+		for ( auto eRanker : { SPH_RANK_BM25, SPH_RANK_PROXIMITY_BM25 } )
+		{
+			auto tWhere = ::testing::Message() << "query '" << szQuery << "', ranker " << eRanker;
+
+			Matches_t dAll, dTop;
+			int64_t iPrunedBlocks = 0;
+			fnSearch ( szQuery, eRanker, RT_DOCS, false, dAll, iPrunedBlocks );
+			ASSERT_EQ ( iPrunedBlocks, 0 ) << tWhere;
+			ASSERT_GE ( dAll.GetLength(), TOP_K ) << tWhere;
+
+			fnSearch ( szQuery, eRanker, TOP_K, true, dTop, iPrunedBlocks );
+			ASSERT_EQ ( dTop.GetLength(), TOP_K ) << tWhere;
+			for ( int i = 0; i<TOP_K; ++i )
+				ASSERT_EQ ( dTop[i].second, dAll[i].second ) << tWhere << ", match " << i;
+
+			if ( !strcmp ( szQuery, "dog" ) )
+				ASSERT_GT ( iPrunedBlocks, 0 ) << tWhere;
+		}
+	});
+}
+
+
+// readahead is only a hint to the OS; doclists and hitlists decoded from the disk chunks must stay the same
+class RtReadPrefetch : public RtChunked
+{
+protected:
+	void SetUp() override
+	{
+		RtChunked::SetUp();
+		sphInitIOStats(); // to count the readahead hints
+	}
+
+	void TearDown() override
+	{
+		sphDoneIOStats();
+		SetReadPrefetch ( false );
+		RtChunked::TearDown();
+	}
+};
+
+
+TEST_F ( RtReadPrefetch, same_docs_and_hits )
+{
+	Threads::CallCoroutine ( [&] {
+
+	auto pParser = sphCreatePlainQueryParser();
+
+	// chunk readers take the setting when they are created, so the table is built anew for every run
+	auto fnBuildAndSearch = [&] ( bool bPrefetch, CSphVector<Matches_t> & dResults, int64_t & iPrefetchOps )
+	{
+		DeleteIndexFiles ( RT_INDEX_FILE_NAME );
+		DeleteChunks();
+		SetReadPrefetch ( bPrefetch );
+
+		std::unique_ptr<RtIndex_i> pIndex;
+		ASSERT_NO_FATAL_FAILURE ( CreateIndex ( FieldsSchema(), pIndex ) );
+
+		// 'dog' is everywhere and long enough to have skiplists; rare 'bird' makes it jump over them
+		CSphString sTitle, sContent;
+		ASSERT_NO_FATAL_FAILURE ( Fill ( pIndex.get(), [&] ( int n, InsertDocData_c & tDoc )
+		{
+			sTitle.SetSprintf ( "%s title%d", ( n%3 ) ? "mouse dog" : "cat dog", n );
+			sContent.SetSprintf ( "content%d%s", n, ( n%97 ) ? "" : " bird" );
+			for ( int j = 0; j<=n%5; ++j )
+				sContent.SetSprintf ( "%s %s", sContent.cstr(), ( j%2 ) ? "cat" : "dog" );
+			SetFields ( tDoc, sTitle, sContent );
+		} ) );
+
+		dResults.Resize(0);
+		iPrefetchOps = 0;
+
+		// rankers with positions read the hitlists, not only the doclists
+		for ( const char * szQuery : { "dog", "cat dog", "\"cat dog\"", "dog bird", "mouse | bird" } )
+			for ( auto eRanker : { SPH_RANK_PROXIMITY_BM25, SPH_RANK_SPH04 } )
+			{
+				CSphQuery tQuery;
+				tQuery.m_sQuery = szQuery;
+				tQuery.m_pQueryParser = pParser.get();
+				tQuery.m_eRanker = eRanker;
+				tQuery.m_eSort = SPH_SORT_EXTENDED;
+				tQuery.m_sSortBy = "id asc";
+				tQuery.m_iMaxMatches = RT_DOCS;
+
+				AggrResult_t tResult;
+				CSphMultiQueryArgs tArgs ( 1 );
+				ASSERT_NO_FATAL_FAILURE ( RunQuery ( pIndex.get(), tQuery, tArgs, dResults.Add(), tResult ) );
+				iPrefetchOps += tResult.m_tIOStats.m_iPrefetchOps;
+			}
+	};
+
+	CSphVector<Matches_t> dPlain, dPrefetched;
+	int64_t iPlainOps = 0, iPrefetchedOps = 0;
+	fnBuildAndSearch ( false, dPlain, iPlainOps );
+	fnBuildAndSearch ( true, dPrefetched, iPrefetchedOps );
+
+	// the same results must not come from the hints silently turned off
+	ASSERT_EQ ( iPlainOps, 0 );
+#if defined(POSIX_FADV_WILLNEED)
+	ASSERT_GT ( iPrefetchedOps, 0 );
+#endif
+
+	ASSERT_EQ ( dPlain.GetLength(), dPrefetched.GetLength() );
+	ARRAY_FOREACH ( i, dPlain )
+	{
+		ASSERT_FALSE ( dPlain[i].IsEmpty() ) << "query " << i;
+		ASSERT_EQ ( dPlain[i].GetLength(), dPrefetched[i].GetLength() ) << "query " << i;
+		ARRAY_FOREACH ( j, dPlain[i] )
+		{
+			ASSERT_EQ ( dPlain[i][j].first, dPrefetched[i][j].first ) << "query " << i << ", match " << j;
+			ASSERT_EQ ( dPlain[i][j].second, dPrefetched[i][j].second ) << "query " << i << ", match " << j;
+		}
+	}
+	});
+}
+
+class RtTieredMerge : public ::testing::Test
+{
+protected:
+	CSphVector<ConstRtSegmentRefPtf_t> Segments ( std::initializer_list<DWORD> dRows ) const
+	{
+		CSphVector<ConstRtSegmentRefPtf_t> dSegments;
+		for ( DWORD uRows : dRows )
+			dSegments.Add ( ConstRtSegmentRefPtf_t { new RtSegment_t ( uRows, m_tSchema ) } );
+		return dSegments;
+	}
+
+	CSphSchema m_tSchema;
+};
+
+// tier is log2(rows)>>2, i.e. segments up to 16x apart
+TEST_F ( RtTieredMerge, lowest_tier_pair )
+{
+	std::pair<int, int> tPair { -1, -1 };
+	auto dSegments = Segments ( { 1000, 30, 100000, 1100, 20 } );
+	ASSERT_TRUE ( FindTieredPair ( tPair, dSegments ) );
+	ASSERT_EQ ( tPair.first, 4 );
+	ASSERT_EQ ( tPair.second, 1 );
+}
+
+TEST_F ( RtTieredMerge, smallest_two_of_tier )
+{
+	std::pair<int, int> tPair { -1, -1 };
+	auto dSegments = Segments ( { 300, 6000, 200, 5000, 250 } );
+	ASSERT_TRUE ( FindTieredPair ( tPair, dSegments ) );
+	ASSERT_EQ ( tPair.first, 2 );
+	ASSERT_EQ ( tPair.second, 4 );
+}
+
+TEST_F ( RtTieredMerge, small_never_merged_into_big )
+{
+	std::pair<int, int> tPair { -1, -1 };
+	auto dSegments = Segments ( { 1000, 5, 100000 } );
+	ASSERT_FALSE ( FindTieredPair ( tPair, dSegments ) );
+	ASSERT_EQ ( tPair.first, -1 );
+}
+
+TEST_F ( RtTieredMerge, tier_boundaries )
+{
+	std::pair<int, int> tPair;
+	ASSERT_FALSE ( FindTieredPair ( tPair, Segments ( { 7, 8 } ) ) );		// 3 and 4 bits
+	ASSERT_TRUE ( FindTieredPair ( tPair, Segments ( { 8, 127 } ) ) );	// 4 and 7 bits
+	ASSERT_FALSE ( FindTieredPair ( tPair, Segments ( { 127, 128 } ) ) );	// 7 and 8 bits
+	ASSERT_FALSE ( FindTieredPair ( tPair, Segments ( { 1 } ) ) );
+}
+
+TEST ( RtTieredMergeLoad, counts_search_workers_only )
+{
+	int iBefore = GetBusySearchWorkers();
+	{
+		ScopedSearchWorker_c tWorker;
+		ASSERT_EQ ( GetBusySearchWorkers(), iBefore+1 );
+		{
+			ScopedSearchWorker_c tNested ( false );
+			ASSERT_EQ ( GetBusySearchWorkers(), iBefore+1 );
+		}
+		ScopedSearchWorker_c tAnother;
+		ASSERT_EQ ( GetBusySearchWorkers(), iBefore+2 );
+	}
+	ASSERT_EQ ( GetBusySearchWorkers(), iBefore );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// binlog group commit: concurrent commits share fsyncs, and none returns before it is synced
+
+class BinlogGroupCommit : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		RemoveBinlogFiles();
+		sphRTInit ( "." );
+
+		CSphConfigSection hSearchd;
+		hSearchd.AddEntry ( "binlog_flush", "1" );
+		hSearchd.AddEntry ( "binlog_group_commit", "1" );
+		Binlog::Configure ( hSearchd, 0 );
+
+		SmallStringHash_T<CSphIndex *> hIndexes;
+		Binlog::Replay ( hIndexes );
+
+		// slow fsync gives other committers a chance to queue behind the leader
+		Binlog::MockFsync ( [this] ( int ) {
+			Threads::Coro::SleepMsec ( 20 );
+			if ( m_iFailFsyncs.fetch_sub ( 1, std::memory_order_relaxed )>0 )
+				return false;
+			m_iFsyncs.fetch_add ( 1, std::memory_order_relaxed );
+			return true;
+		});
+	}
+
+	void TearDown() override
+	{
+		Binlog::MockFsync ( nullptr );
+		Binlog::Deinit();
+		RemoveBinlogFiles();
+	}
+
+	static void RemoveBinlogFiles()
+	{
+		for ( const char * szFile : { "binlog.meta", "binlog.lock", "binlog.0000", "binlog.0001", "binlog.0002" } )
+			unlink ( szFile );
+	}
+
+	bool Commit ( int64_t & iCommitted, CSphString & sError )
+	{
+		return Binlog::Commit ( &m_iTID, "gc", sError, [&iCommitted, this] ( Writer_i & tWriter ) {
+			iCommitted = m_iTID; // saver runs under the binlog lock, right after the tid is assigned
+			tWriter.PutByte ( Binlog::COMMIT );
+			tWriter.ZipOffset ( 0 );
+		});
+	}
+
+	int64_t m_iTID = 0;
+	std::atomic<int> m_iFsyncs { 0 };
+	std::atomic<int> m_iFailFsyncs { 0 };	///< that many next fsyncs fail
+};
+
+
+TEST_F ( BinlogGroupCommit, concurrent_commits_share_fsync )
+{
+	const int COMMITTERS = 8;
+	const int COMMITS = 10;
+	std::atomic<int> iNotDurable { 0 };
+	std::atomic<int> iFailed { 0 };
+
+	Threads::CallCoroutine ( [&] {
+		auto dWaiter = Threads::DefferedContinuator();
+		for ( int i = 0; i<COMMITTERS; ++i )
+			Threads::Coro::Co ( [&] {
+				for ( int j = 0; j<COMMITS; ++j )
+				{
+					int64_t iCommitted = 0;
+					CSphString sError;
+					if ( !Commit ( iCommitted, sError ) )
+					{
+						iFailed.fetch_add ( 1, std::memory_order_relaxed );
+						continue;
+					}
+
+					// single table, so the tid is also the ordinal of the txn in the log
+					if ( Binlog::GetFsyncStats().m_iTxns<iCommitted )
+						iNotDurable.fetch_add ( 1, std::memory_order_relaxed );
+				}
+			}, dWaiter );
+		Threads::WaitForDeffered ( std::move ( dWaiter ) );
+	});
+
+	ASSERT_EQ ( iFailed.load(), 0 );
+	ASSERT_EQ ( iNotDurable.load(), 0 );
+	ASSERT_EQ ( m_iTID, COMMITTERS*COMMITS );
+
+	auto tStats = Binlog::GetFsyncStats();
+	ASSERT_TRUE ( tStats.m_bGroupCommit );
+	ASSERT_EQ ( tStats.m_iTxns, COMMITTERS*COMMITS );
+	ASSERT_EQ ( tStats.m_iFsyncs, m_iFsyncs.load() );
+	ASSERT_LT ( tStats.m_iFsyncs, COMMITTERS*COMMITS );
+
+	// the group leader marked its position as synced, so flush finds nothing to sync again
+	Threads::CallCoroutine ( [] { Binlog::Flush(); } );
+	ASSERT_EQ ( m_iFsyncs.load(), tStats.m_iFsyncs );
+}
+
+
+TEST_F ( BinlogGroupCommit, failed_fsync_fails_commit )
+{
+	const int COMMITTERS = 3;
+	std::atomic<int> iOk { 0 };
+	std::atomic<int> iFailed { 0 };
+
+	// the 1st fsync fails; the commits queued behind it are synced by the next leader, and that succeeds.
+	// But they are in the same file, which may have lost its pages, so none of them is durable
+	m_iFailFsyncs = 1;
+	Threads::CallCoroutine ( [&] {
+		auto dWaiter = Threads::DefferedContinuator();
+		for ( int i = 0; i<COMMITTERS; ++i )
+			Threads::Coro::Co ( [&] {
+				int64_t iCommitted = 0;
+				CSphString sError;
+				if ( Commit ( iCommitted, sError ) )
+					iOk.fetch_add ( 1, std::memory_order_relaxed );
+				else
+					iFailed.fetch_add ( 1, std::memory_order_relaxed );
+			}, dWaiter );
+		Threads::WaitForDeffered ( std::move ( dWaiter ) );
+	});
+
+	ASSERT_EQ ( iOk.load(), 0 );
+	ASSERT_EQ ( iFailed.load(), COMMITTERS );
+	ASSERT_EQ ( Binlog::GetFsyncStats().m_iTxns, 0 );
+	ASSERT_GE ( m_iFsyncs.load(), 1 ) << "a later fsync succeeded";
+
+	// the next commit goes to a new file, and is durable again
+	Threads::CallCoroutine ( [&] {
+		int64_t iCommitted = 0;
+		CSphString sError;
+		ASSERT_TRUE ( Commit ( iCommitted, sError ) ) << sError.cstr();
+		ASSERT_EQ ( iCommitted, COMMITTERS+1 );
+		ASSERT_EQ ( Binlog::GetFsyncStats().m_iTxns, 1 );
+	});
+}
@@ -16,6 +16,8 @@
 #include "searchdaemon.h"
 #include "searchdha.h"
 #include "searchdreplication.h"
+#include "compressed_api.h"
+#include "binlog.h"
 
 
 // QueryStatElement_t uses default ctr with inline initializer;
@@ -33,6 +35,39 @@ TEST ( functions, QueryStatElement_t_ctr )
 	ASSERT_EQ ( tElem.m_dData[TYPE_99], 0 );
 }
 
+// all binlog fsync times are seconds, as query_wall and others
+TEST ( functions, binlog_fsync_status )
+{
+	Binlog::FsyncStats_t tStats;
+	tStats.m_bGroupCommit = true;
+	tStats.m_iFsyncs = 3;
+	tStats.m_iTxns = 10;
+	tStats.m_iTimeUs = 1234567;
+	tStats.m_iMaxTimeUs = 987654;
+
+	VectorLike dStatus;
+	BinlogFsyncStatus ( dStatus, tStats );
+
+	SmallStringHash_T<CSphString> hStatus;
+	for ( int i = 0; i+1<dStatus.GetLength(); i += 2 )
+		hStatus.Add ( dStatus[i+1], dStatus[i] );
+
+	ASSERT_STREQ ( hStatus["binlog_group_commit"].cstr(), "ON" );
+	ASSERT_STREQ ( hStatus["binlog_fsyncs"].cstr(), "3" );
+	ASSERT_STREQ ( hStatus["binlog_fsync_txns"].cstr(), "10" );
+	ASSERT_STREQ ( hStatus["binlog_avg_fsync_batch"].cstr(), "3.33" );
+	ASSERT_STREQ ( hStatus["binlog_fsync_time"].cstr(), "1.234" );
+	ASSERT_STREQ ( hStatus["binlog_avg_fsync_time"].cstr(), "0.411" );
+	ASSERT_STREQ ( hStatus["binlog_max_fsync_time"].cstr(), "0.987" );
+
+	// nothing synced yet
+	VectorLike dEmpty;
+	BinlogFsyncStatus ( dEmpty, Binlog::FsyncStats_t() );
+	ASSERT_EQ ( dEmpty.GetLength(), 14 );
+	ASSERT_STREQ ( dEmpty[1].cstr(), "OFF" );
+	ASSERT_STREQ ( dEmpty[13].cstr(), "0.000" );
+}
+
 class tstlogger
 {
 	// test helper log - logs into sLogBuff.
@@ -217,7 +252,7 @@ protected:
 		tstlogger::setup ();
 	}
 
-	AgentOptions_t tAgentOptions { false, false, HA_RANDOM, 3, 0 };
+	AgentOptions_t tAgentOptions { false, false, HA_RANDOM, 3, 0, 0 };
 	const char * szIndexName = "tstidx";
 
 	MultiAgentDescRefPtr_c ParserTestSimple ( const char * sInExpr, bool bExpectedResult )
@@ -869,3 +904,506 @@ TEST ( PersistentConnectionsPool, functionality )
 	iSock = dPool.RentConnection();
 	EXPECT_EQ ( iSock, -2 );
 }
+
+TEST ( HostDashboard, p95_latency )
+{
+	HostDashboardRefPtr_t pDash { new HostDashboard_t };
+
+	// not enough answers yet
+	for ( int i = 1; i<=16; ++i )
+		pDash->AddLatency ( i*1000 );
+	EXPECT_EQ ( pDash->GetP95LatencyUS(), 0 );
+
+	for ( int i = 17; i<=96; ++i )
+		pDash->AddLatency ( i*1000 );
+	EXPECT_EQ ( pDash->GetP95LatencyUS(), 92000 );
+
+	// window slides: only the latest answers count
+	for ( int i = 0; i<256; ++i )
+		pDash->AddLatency ( 5000 );
+	EXPECT_EQ ( pDash->GetP95LatencyUS(), 5000 );
+}
+
+TEST ( ApiCompression, reply_roundtrip )
+{
+	ISphOutputBuffer tOut;
+	{
+		auto tReply = APIAnswer ( tOut, VER_COMMAND_SEARCH );
+		for ( int i = 0; i<1000; ++i )
+			tOut.SendString ( "the same string over and over" );
+	}
+	int iBody = tOut.GetSentCount() - 8;
+
+	ApiCompressionStats_t tStats;
+	ASSERT_TRUE ( ApiCompressPacket ( tOut, 0, true, Compression_e::LZ4, true, tStats ) );
+	EXPECT_EQ ( tStats.m_iRawBytes, iBody );
+	EXPECT_LT ( tOut.GetSentCount(), iBody/4 );
+
+	MemInputBuffer_c tIn ( (const BYTE *)tOut.GetBufPtr(), tOut.GetSentCount() );
+	EXPECT_EQ ( tIn.GetWord(), SEARCHD_OK );
+	EXPECT_EQ ( tIn.GetWord(), WORD ( VER_COMMAND_SEARCH | API_COMPRESSED_FRAME ) );
+	int iFrame = tIn.GetInt();
+	ASSERT_EQ ( iFrame, tOut.GetSentCount() - 8 );
+
+	CSphFixedVector<BYTE> dRaw { 0 };
+	Compression_e eCodec;
+	CSphString sError;
+	ASSERT_TRUE ( ApiDecompressFrame ( { (const BYTE *)tOut.GetBufPtr() + 8, iFrame }, g_iMaxPacketSize, dRaw, eCodec, sError, tStats ) ) << sError.cstr();
+	EXPECT_EQ ( eCodec, Compression_e::LZ4 );
+	ASSERT_EQ ( dRaw.GetLength(), iBody );
+
+	MemInputBuffer_c tRaw ( dRaw );
+	EXPECT_STREQ ( tRaw.GetString().cstr(), "the same string over and over" );
+
+	// too big to unpack
+	EXPECT_FALSE ( ApiDecompressFrame ( { (const BYTE *)tOut.GetBufPtr() + 8, iFrame }, iBody-1, dRaw, eCodec, sError, tStats ) );
+}
+
+TEST ( ApiCompression, short_request )
+{
+	ISphOutputBuffer tOut;
+	{
+		auto tHdr = APIHeader ( tOut, SEARCHD_COMMAND_SEARCH, VER_COMMAND_SEARCH );
+		tOut.SendInt ( 42 );
+	}
+
+	// requests below the threshold stay as is
+	ApiCompressionStats_t tStats;
+	EXPECT_FALSE ( ApiCompressPacket ( tOut, 0, false, Compression_e::LZ4, false, tStats ) );
+	EXPECT_EQ ( tOut.GetSentCount(), 12 );
+
+	// but may be wrapped without compression
+	ASSERT_TRUE ( ApiCompressPacket ( tOut, 0, false, Compression_e::LZ4, true, tStats ) );
+	MemInputBuffer_c tIn ( (const BYTE *)tOut.GetBufPtr(), tOut.GetSentCount() );
+	EXPECT_EQ ( tIn.GetWord(), WORD ( SEARCHD_COMMAND_SEARCH | API_COMPRESSED_FRAME ) );
+	EXPECT_EQ ( tIn.GetWord(), VER_COMMAND_SEARCH );
+	EXPECT_EQ ( tIn.GetInt(), 9 );
+
+	CSphFixedVector<BYTE> dRaw { 0 };
+	Compression_e eCodec;
+	CSphString sError;
+	ASSERT_TRUE ( ApiDecompressFrame ( { (const BYTE *)tOut.GetBufPtr() + 8, 9 }, g_iMaxPacketSize, dRaw, eCodec, sError, tStats ) ) << sError.cstr();
+	EXPECT_EQ ( eCodec, Compression_e::NONE );
+	MemInputBuffer_c tRaw ( dRaw );
+	EXPECT_EQ ( tRaw.GetInt(), 42 );
+
+	// and a packet which is not alone in the buffer is left untouched
+	tOut.SendInt ( 0 );
+	EXPECT_FALSE ( ApiCompressPacket ( tOut, 0, false, Compression_e::LZ4, true, tStats ) );
+}
+
+TEST ( ApiCompression, negotiation )
+{
+	EXPECT_EQ ( ApiCompressionAccept ( 0 ), Compression_e::NONE );
+	EXPECT_EQ ( ApiCompressionAccept ( 1 << (int)Compression_e::LZ4 ), Compression_e::LZ4 );
+	EXPECT_EQ ( ApiCompressionAccept ( 1 << (int)Compression_e::LZ4HC ), Compression_e::NONE );
+}
+
+#if !_WIN32
+#include "daemon/hot_restart.h"
+#include "coroutine.h"
+#include "threadutils.h"
+#include "fileutils.h"
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int ListenLoopback ( int & iPort )
+{
+	int iSock = socket ( AF_INET, SOCK_STREAM, 0 );
+	sockaddr_in tAddr {};
+	tAddr.sin_family = AF_INET;
+	tAddr.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+	socklen_t iLen = sizeof ( tAddr );
+	if ( iSock<0 || bind ( iSock, (sockaddr *)&tAddr, sizeof ( tAddr ) )<0 || listen ( iSock, 8 )<0 || getsockname ( iSock, (sockaddr *)&tAddr, &iLen )<0 )
+		return -1;
+
+	iPort = ntohs ( tAddr.sin_port );
+	return iSock;
+}
+
+static int ListenUnix ( const CSphString & sPath )
+{
+	int iSock = socket ( AF_UNIX, SOCK_STREAM, 0 );
+	sockaddr_un tAddr {};
+	tAddr.sun_family = AF_UNIX;
+	strncpy ( tAddr.sun_path, sPath.cstr(), sizeof ( tAddr.sun_path )-1 );
+	unlink ( sPath.cstr() );
+	if ( iSock<0 || bind ( iSock, (sockaddr *)&tAddr, sizeof ( tAddr ) )<0 || listen ( iSock, 8 )<0 )
+		return -1;
+
+	return iSock;
+}
+
+// listeners go through SCM_RIGHTS and are matched back to the configured ones by address
+TEST ( HotRestart, handover_and_match )
+{
+	int iPortA = 0, iPortB = 0;
+	int iSockA = ListenLoopback ( iPortA );
+	int iSockB = ListenLoopback ( iPortB );
+	CSphString sUnix = SphSprintf ( "/tmp/gmanticoretest_hotrestart_%d.sock", (int)getpid() );
+	int iSockU = ListenUnix ( sUnix );
+	ASSERT_GE ( iSockA, 0 );
+	ASSERT_GE ( iSockB, 0 );
+	ASSERT_GE ( iSockU, 0 );
+
+	int dPair[2];
+	ASSERT_EQ ( socketpair ( AF_UNIX, SOCK_STREAM, 0, dPair ), 0 );
+
+	int dSocks[] = { iSockA, iSockB, iSockU };
+	ASSERT_TRUE ( hotrestart::SendListeners ( dPair[0], VecTraits_T<int> ( dSocks, 3 ) ) );
+
+	CSphString sError;
+	ASSERT_TRUE ( hotrestart::ReceiveListeners ( dPair[1], sError ) ) << sError.cstr();
+
+	// same port on another address, and an unknown unix path
+	ASSERT_EQ ( hotrestart::PopInherited ( ParseListener ( SphSprintf ( "127.0.0.2:%d", iPortB ).cstr() ) ), -1 );
+	ASSERT_EQ ( hotrestart::PopInherited ( ParseListener ( "/tmp/gmanticoretest_hotrestart_none.sock" ) ), -1 );
+
+	ListenerDesc_t tDescB = ParseListener ( SphSprintf ( "127.0.0.1:%d:mysql41", iPortB ).cstr() );
+	int iGotB = hotrestart::PopInherited ( tDescB );
+	ASSERT_GE ( iGotB, 0 );
+	ASSERT_NE ( iGotB, iSockB );
+	ASSERT_EQ ( hotrestart::PopInherited ( tDescB ), -1 ) << "taken only once";
+
+	// received socket is the same listener: a client that connected to the original one is accepted through it
+	int iClient = socket ( AF_INET, SOCK_STREAM, 0 );
+	sockaddr_in tAddr {};
+	tAddr.sin_family = AF_INET;
+	tAddr.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+	tAddr.sin_port = htons ( iPortB );
+	ASSERT_EQ ( connect ( iClient, (sockaddr *)&tAddr, sizeof ( tAddr ) ), 0 );
+	int iAccepted = accept ( iGotB, nullptr, nullptr );
+	ASSERT_GE ( iAccepted, 0 );
+
+	int iGotU = hotrestart::PopInherited ( ParseListener ( sUnix.cstr() ) );
+	ASSERT_GE ( iGotU, 0 );
+	ASSERT_NE ( iGotU, iSockU );
+
+	// copy of the 1st listener was not claimed
+	hotrestart::CloseUnused();
+
+	for ( int iSock : { iAccepted, iClient, iGotB, iGotU, iSockA, iSockB, iSockU, dPair[0], dPair[1] } )
+		close ( iSock );
+	unlink ( sUnix.cstr() );
+}
+
+TEST ( HotRestart, handover_nothing )
+{
+	int dPair[2];
+	ASSERT_EQ ( socketpair ( AF_UNIX, SOCK_STREAM, 0, dPair ), 0 );
+	ASSERT_TRUE ( hotrestart::SendListeners ( dPair[0], VecTraits_T<int>() ) );
+
+	CSphString sError;
+	ASSERT_TRUE ( hotrestart::ReceiveListeners ( dPair[1], sError ) ) << sError.cstr();
+	ASSERT_EQ ( hotrestart::PopInherited ( ParseListener ( "9312" ) ), -1 );
+
+	// the peer is gone before sending anything
+	close ( dPair[0] );
+	ASSERT_FALSE ( hotrestart::ReceiveListeners ( dPair[1], sError ) );
+	close ( dPair[1] );
+}
+// the running instance removes its pid file on the way out; the new one still ends up with the file on disk, holding its pid
+TEST ( HotRestart, pid_file_after_takeover )
+{
+	CSphString sPidFile = SphSprintf ( "/tmp/gmanticoretest_hotrestart_%d.pid", (int)getpid() );
+	unlink ( sPidFile.cstr() );
+
+	int dLocked[2], dOpened[2];
+	ASSERT_EQ ( pipe ( dLocked ), 0 );
+	ASSERT_EQ ( pipe ( dOpened ), 0 );
+
+	pid_t iOld = fork();
+	ASSERT_GE ( iOld, 0 );
+	if ( !iOld )
+	{
+		CSphString sError;
+		int iFD = ::open ( sPidFile.cstr(), O_CREAT | O_WRONLY, S_IREAD | S_IWRITE );
+		if ( iFD<0 || !sphLockEx ( iFD, false ) || !WritePidFile ( iFD, sPidFile, sError ) )
+			_exit(1);
+
+		char c = 0;
+		if ( write ( dLocked[1], &c, 1 )!=1 || read ( dOpened[0], &c, 1 )!=1 )
+			_exit(1);
+
+		unlink ( sPidFile.cstr() );
+		close ( iFD );
+		_exit(0);
+	}
+
+	// the new instance opens the pid file before the old one stops, and waits for the lock
+	char c = 0;
+	ASSERT_EQ ( read ( dLocked[0], &c, 1 ), 1 );
+	int iFD = ::open ( sPidFile.cstr(), O_CREAT | O_WRONLY, S_IREAD | S_IWRITE );
+	ASSERT_GE ( iFD, 0 );
+	ASSERT_EQ ( write ( dOpened[1], &c, 1 ), 1 );
+
+	CSphString sError;
+	ASSERT_TRUE ( hotrestart::LockPidFile ( iFD, sPidFile, sError ) ) << sError.cstr();
+	ASSERT_TRUE ( WritePidFile ( iFD, sPidFile, sError ) ) << sError.cstr();
+
+	int iStatus = -1;
+	ASSERT_EQ ( waitpid ( iOld, &iStatus, 0 ), iOld );
+	ASSERT_TRUE ( WIFEXITED ( iStatus ) && WEXITSTATUS ( iStatus )==0 );
+
+	struct stat tLocked, tOnDisk;
+	ASSERT_EQ ( fstat ( iFD, &tLocked ), 0 );
+	ASSERT_EQ ( stat ( sPidFile.cstr(), &tOnDisk ), 0 ) << "pid file is gone";
+	ASSERT_EQ ( tLocked.st_ino, tOnDisk.st_ino );
+
+	char sPid[32] = { 0 };
+	int iIn = ::open ( sPidFile.cstr(), O_RDONLY );
+	ASSERT_GE ( iIn, 0 );
+	ASSERT_GT ( read ( iIn, sPid, sizeof ( sPid )-1 ), 0 );
+	ASSERT_EQ ( atoi ( sPid ), (int)getpid() );
+
+	for ( int iSock : { iIn, iFD, dLocked[0], dLocked[1], dOpened[0], dOpened[1] } )
+		close ( iSock );
+	unlink ( sPidFile.cstr() );
+}
+
+// the running instance acks the request once its tables are released, and hands the sockets over only after the new one is ready
+TEST ( HotRestart, sockets_only_after_ready )
+{
+	CSphString sPidFile = SphSprintf ( "/tmp/gmanticoretest_hotrestart_ready_%d.pid", (int)getpid() );
+	CSphString sService = SphSprintf ( "%s.takeover", sPidFile.cstr() );
+	int iPort = 0;
+	int iListener = ListenLoopback ( iPort );
+	int iService = ListenUnix ( sService );
+	ASSERT_GE ( iListener, 0 );
+	ASSERT_GE ( iService, 0 );
+
+	int dLoaded[2];
+	ASSERT_EQ ( pipe ( dLoaded ), 0 );
+
+	pid_t iOld = fork();
+	ASSERT_GE ( iOld, 0 );
+	if ( !iOld )
+	{
+		int iClient = accept ( iService, nullptr, nullptr );
+		DWORD uMsg = 0;
+		if ( iClient<0 || read ( iClient, &uMsg, sizeof ( uMsg ) )!=sizeof ( uMsg ) || uMsg!=0x54535248 )
+			_exit(1);
+
+		if ( write ( iClient, &uMsg, sizeof ( uMsg ) )!=sizeof ( uMsg ) )
+			_exit(1);
+
+		// nothing comes while the new instance loads
+		char c = 0;
+		pollfd tPoll { iClient, POLLIN, 0 };
+		if ( poll ( &tPoll, 1, 100 )!=0 || write ( dLoaded[1], &c, 1 )!=1 )
+			_exit(2);
+
+		if ( read ( iClient, &uMsg, sizeof ( uMsg ) )!=sizeof ( uMsg ) || uMsg!=0x59445248 )
+			_exit(3);
+
+		_exit ( hotrestart::SendListeners ( iClient, VecTraits_T<int> ( &iListener, 1 ) ) ? 0 : 4 );
+	}
+
+	CSphString sError;
+	ASSERT_TRUE ( hotrestart::Prepare ( sPidFile, sError ) ) << sError.cstr();
+
+	char c = 0;
+	ASSERT_EQ ( read ( dLoaded[0], &c, 1 ), 1 );
+	ASSERT_TRUE ( hotrestart::TakeOver ( sError ) ) << sError.cstr();
+
+	int iGot = hotrestart::PopInherited ( ParseListener ( SphSprintf ( "127.0.0.1:%d", iPort ).cstr() ) );
+	ASSERT_GE ( iGot, 0 );
+
+	int iStatus = -1;
+	ASSERT_EQ ( waitpid ( iOld, &iStatus, 0 ), iOld );
+	ASSERT_TRUE ( WIFEXITED ( iStatus ) && WEXITSTATUS ( iStatus )==0 ) << WEXITSTATUS ( iStatus );
+
+	for ( int iSock : { iGot, iListener, iService, dLoaded[0], dLoaded[1] } )
+		close ( iSock );
+	unlink ( sService.cstr() );
+}
+
+// two loopback mirrors of one agent; n-th connection to any of them is answered after n-th delay (-1 = never), n is the payload
+class AgentHedge : public ::testing::Test
+{
+	class Builder_c : public RequestBuilder_i
+	{
+	public:
+		void BuildRequest ( const AgentConn_t &, ISphOutputBuffer & tOut ) const final
+		{
+			auto tHdr = APIHeader ( tOut, SEARCHD_COMMAND_PING, VER_COMMAND_PING );
+			tOut.SendInt ( 0 );
+		}
+	};
+
+	class Parser_c : public ReplyParser_i
+	{
+	public:
+		mutable int m_iAnswer = -1;
+
+		bool ParseReply ( MemInputBuffer_c & tReq, AgentConn_t & ) const final
+		{
+			m_iAnswer = tReq.GetInt();
+			return !tReq.GetError();
+		}
+	};
+
+protected:
+	void TearDown () override
+	{
+		m_bStop = true;
+		for ( int i = 0; i<m_iThreads; ++i )
+			Threads::Join ( &m_dThreads[i] );
+		for ( int iSock : m_dListen )
+			if ( iSock>=0 )
+				close ( iSock );
+	}
+
+	void Start ( int iHedgeRate, std::initializer_list<int> dDelaysMs )
+	{
+		for ( int iDelay : dDelaysMs )
+			m_dDelaysMs.Add ( iDelay );
+
+		int dPorts[2];
+		for ( int i = 0; i<2; ++i )
+		{
+			m_dListen[i] = ListenLoopback ( dPorts[i] );
+			ASSERT_GE ( m_dListen[i], 0 );
+			ASSERT_TRUE ( Threads::Create ( &m_dThreads[i], [this, i] { Serve ( m_dListen[i] ); } ) );
+			++m_iThreads;
+		}
+
+		CSphString sError;
+		CSphString sAgent = SphSprintf ( "127.0.0.1:%d:idx|127.0.0.1:%d:idx", dPorts[0], dPorts[1] );
+		m_pAgent = ConfigureMultiAgent ( sAgent.cstr(), "tstidx", AgentOptions_t { false, false, HA_ROUNDROBIN, 0, 0, iHedgeRate }, sError );
+		ASSERT_TRUE ( m_pAgent ) << sError.cstr();
+		ASSERT_TRUE ( m_pAgent->CanHedge() || !iHedgeRate );
+
+		// mirrors usually answer in 20ms
+		for ( int i = 0; i<2; ++i )
+			for ( int j = 0; j<32; ++j )
+				(*m_pAgent)[i].m_pDash->AddLatency ( 20000 );
+		ASSERT_EQ ( (*m_pAgent)[0].m_pDash->GetP95LatencyUS(), 20000 );
+	}
+
+	// succeeded agents; iAnswer is the turn of the connection which answered
+	int Query ( int & iAnswer )
+	{
+		Builder_c tBuilder;
+		Parser_c tParser;
+		int iSucceeded = 0;
+		Threads::CallCoroutine ( [&] {
+			VecRefPtrsAgentConn_t dRemotes;
+			auto * pConn = new AgentConn_t;
+			pConn->SetMultiAgent ( m_pAgent );
+			pConn->m_bHedge = true;
+			dRemotes.Add ( pConn );
+			iSucceeded = PerformRemoteTasks ( dRemotes, &tBuilder, &tParser );
+		} );
+		iAnswer = tParser.m_iAnswer;
+		return iSucceeded;
+	}
+
+	int64_t Hedged ( int iMirror ) const { return (*m_pAgent)[iMirror].m_pDash->m_iHedged.load(); }
+	int64_t HedgeWins ( int iMirror ) const { return (*m_pAgent)[iMirror].m_pDash->m_iHedgeWins.load(); }
+	int Connections () const { return m_iTurn.load(); }
+
+	MultiAgentDescRefPtr_c m_pAgent;
+
+private:
+	void Serve ( int iListen )
+	{
+		while ( !m_bStop )
+		{
+			pollfd tPoll { iListen, POLLIN, 0 };
+			if ( poll ( &tPoll, 1, 10 )<=0 )
+				continue;
+
+			int iSock = accept ( iListen, nullptr, nullptr );
+			if ( iSock<0 )
+				continue;
+
+			timeval tTimeout { 5, 0 };
+			setsockopt ( iSock, SOL_SOCKET, SO_RCVTIMEO, &tTimeout, sizeof ( tTimeout ) );
+
+			int iTurn = m_iTurn.fetch_add ( 1 );
+			int iDelayMs = iTurn<m_dDelaysMs.GetLength() ? m_dDelaysMs[iTurn] : -1;
+			BYTE dBuf[4096];
+			if ( iDelayMs>=0 && recv ( iSock, dBuf, sizeof ( dBuf ), 0 )>0 )
+			{
+				usleep ( iDelayMs*1000 );
+				DWORD dReply[] = { htonl ( SPHINX_SEARCHD_PROTO ), htonl ( SEARCHD_OK<<16 ), htonl ( sizeof ( int ) ), htonl ( iTurn ) };
+				send ( iSock, dReply, sizeof ( dReply ), 0 );
+			}
+
+			// the agent drops the connection when done with it
+			while ( recv ( iSock, dBuf, sizeof ( dBuf ), 0 )>0 )
+				;
+			close ( iSock );
+		}
+	}
+
+	int m_dListen[2] { -1, -1 };
+	SphThread_t m_dThreads[2];
+	int m_iThreads = 0;
+	CSphVector<int> m_dDelaysMs;
+	std::atomic<int> m_iTurn { 0 };
+	std::atomic<bool> m_bStop { false };
+};
+
+// primary never answers; the copy sent to another mirror does, and its reply is committed in place of the primary's
+TEST_F ( AgentHedge, hedge_wins )
+{
+	Start ( 100, { -1, 0 } );
+
+	int iAnswer = -1;
+	ASSERT_EQ ( Query ( iAnswer ), 1 );
+	EXPECT_EQ ( iAnswer, 1 );
+
+	EXPECT_EQ ( Hedged(0)+Hedged(1), 1 );
+	EXPECT_EQ ( HedgeWins(0)+HedgeWins(1), 1 );
+	EXPECT_EQ ( Hedged(0), HedgeWins(1) ) << "hedged from one mirror, won by another";
+}
+
+// primary is slow, but answers first; the copy is cancelled
+TEST_F ( AgentHedge, primary_wins )
+{
+	Start ( 100, { 100, -1 } );
+
+	int iAnswer = -1;
+	ASSERT_EQ ( Query ( iAnswer ), 1 );
+	EXPECT_EQ ( iAnswer, 0 );
+
+	EXPECT_EQ ( Hedged(0)+Hedged(1), 1 );
+	EXPECT_EQ ( HedgeWins(0)+HedgeWins(1), 0 );
+}
+
+// at 50% every query earns half of a hedge; the first slow one is not hedged, the second is
+TEST_F ( AgentHedge, budget )
+{
+	Start ( 50, { 100, 100, -1 } );
+
+	int iAnswer = -1;
+	ASSERT_EQ ( Query ( iAnswer ), 1 );
+	EXPECT_EQ ( iAnswer, 0 );
+	EXPECT_EQ ( Hedged(0)+Hedged(1), 0 );
+
+	ASSERT_EQ ( Query ( iAnswer ), 1 );
+	EXPECT_EQ ( iAnswer, 1 );
+	EXPECT_EQ ( Hedged(0)+Hedged(1), 1 );
+	EXPECT_EQ ( HedgeWins(0)+HedgeWins(1), 0 );
+}
+
+// no hedging configured
+TEST_F ( AgentHedge, disabled )
+{
+	Start ( 0, { 100, 0 } );
+
+	int iAnswer = -1;
+	ASSERT_EQ ( Query ( iAnswer ), 1 );
+	EXPECT_EQ ( iAnswer, 0 );
+	EXPECT_EQ ( Hedged(0)+Hedged(1), 0 );
+	EXPECT_EQ ( Connections(), 1 );
+}
+#endif
@@ -17,6 +17,7 @@
 #include "sphinxutils.h"
 #include "dict/stem/sphinxstem.h"
 #include "stripper/html_stripper.h"
+#include "querycontext.h"
 #include <cmath>
 
 
@@ -519,6 +520,122 @@ TEST ( Text, expression_parser_many )
 }
 
 
+// batch evaluation must give exactly what per-match evaluation gives, for every result type
+TEST ( Text, expression_batch_eval )
+{
+	CSphColumnInfo tCol;
+	CSphSchema tSchema;
+	tCol.m_sName = "id";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSchema.AddAttr ( tCol, false );
+
+	tCol.m_sName = "aaa";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSchema.AddAttr ( tCol, false );
+
+	tCol.m_sName = "bbb";
+	tCol.m_eAttrType = SPH_ATTR_INTEGER;
+	tSchema.AddAttr ( tCol, false );
+
+	tCol.m_sName = "ccc";
+	tCol.m_eAttrType = SPH_ATTR_FLOAT;
+	tSchema.AddAttr ( tCol, false );
+
+	tCol.m_sName = "ddd";
+	tCol.m_eAttrType = SPH_ATTR_BIGINT;
+	tSchema.AddAttr ( tCol, false );
+
+	// a few full batches and a partial one
+	const int NUM_MATCHES = MAX_EXPR_BATCH*2 + 17;
+	int iRowSize = tSchema.GetRowSize();
+	CSphFixedVector<CSphRowitem> dRows ( NUM_MATCHES*iRowSize );
+	CSphFixedVector<CSphMatch> dMatches ( NUM_MATCHES );
+	CSphVector<CSphMatch *> dMatchPtrs;
+	ARRAY_FOREACH ( i, dMatches )
+	{
+		CSphRowitem * pRow = dRows.Begin() + i*iRowSize;
+		sphSetRowAttr ( pRow, tSchema.GetAttr("id")->m_tLocator, i+1 );
+		sphSetRowAttr ( pRow, tSchema.GetAttr("aaa")->m_tLocator, i*7 );
+		sphSetRowAttr ( pRow, tSchema.GetAttr("bbb")->m_tLocator, i%13 + 1 );
+		sphSetRowAttr ( pRow, tSchema.GetAttr("ccc")->m_tLocator, sphF2DW ( i*0.25f - 3.0f ) );
+		sphSetRowAttr ( pRow, tSchema.GetAttr("ddd")->m_tLocator, i*INT64_C(3000000007) - INT64_C(100000000000) );
+
+		dMatches[i].Reset(2);
+		dMatches[i].m_tRowID = i;
+		dMatches[i].m_iWeight = i%5 + 1;
+		dMatches[i].m_pStatic = pRow;
+		dMatchPtrs.Add ( &dMatches[i] );
+	}
+
+	// result goes to the single 64-bit dynamic rowitem
+	ContextCalcItem_t tCalc;
+	tCalc.m_tLoc.m_iBitOffset = 0;
+	tCalc.m_tLoc.m_iBitCount = 64;
+
+	const char * dExprs[] =
+	{
+		"aaa+bbb*2", "aaa-bbb", "aaa*bbb", "ddd+aaa", "ddd-aaa*bbb", "aaa/bbb", "ccc*2.5-bbb",
+		"aaa+bbb*ccc-1", "-ddd", "abs(ccc)+abs(aaa)", "min(aaa,bbb)+max(ccc,1)", "sqrt(bbb)+ln(bbb)",
+		"log2(bbb)*log10(bbb)", "sin(ccc)+cos(ccc)+exp(bbb/10)", "aaa<bbb*20", "ccc>=0", "ddd=ddd",
+		"if(aaa>100,aaa,ccc)", "@weight*bbb", "id", "ddd", "ccc", "3.5", "42"
+	};
+
+	for ( const char * szExpr : dExprs )
+	{
+		CSphString sError;
+		ESphAttr eAttrType;
+		ExprParseArgs_t tExprArgs;
+		tExprArgs.m_pAttrType = &eAttrType;
+		ISphExprRefPtr_c pExpr ( sphExprParse ( szExpr, tSchema, sError, tExprArgs ) );
+		ASSERT_TRUE ( pExpr.Ptr() ) << "parsing " << szExpr << ":" << sError.cstr();
+		tCalc.m_pExpr = pExpr;
+
+		// any tree evaluates in floats, int ones also in wider ints
+		CSphVector<ESphAttr> dTypes;
+		if ( eAttrType==SPH_ATTR_INTEGER || eAttrType==SPH_ATTR_BOOL )
+			dTypes.Add ( SPH_ATTR_INTEGER );
+		if ( eAttrType==SPH_ATTR_INTEGER || eAttrType==SPH_ATTR_BOOL || eAttrType==SPH_ATTR_BIGINT )
+			dTypes.Add ( SPH_ATTR_BIGINT );
+		dTypes.Add ( SPH_ATTR_FLOAT );
+		dTypes.Add ( SPH_ATTR_DOUBLE );
+
+		for ( auto eType : dTypes )
+		{
+			tCalc.m_eType = eType;
+
+			CSphVector<SphAttr_t> dExpected;
+			for ( auto * pMatch : dMatchPtrs )
+			{
+				pMatch->SetAttr ( tCalc.m_tLoc, 0 );
+				CalcContextItem ( *pMatch, tCalc );
+				dExpected.Add ( pMatch->GetAttr ( tCalc.m_tLoc ) );
+				pMatch->SetAttr ( tCalc.m_tLoc, 0 );
+			}
+
+			CalcContextItemBatch ( dMatchPtrs, tCalc );
+			ARRAY_FOREACH ( i, dMatchPtrs )
+				ASSERT_EQ ( dMatchPtrs[i]->GetAttr ( tCalc.m_tLoc ), dExpected[i] ) << szExpr << ", type " << (int)eType << ", match " << i;
+		}
+
+		// and a batch shorter than one chunk, starting in the middle
+		tCalc.m_eType = SPH_ATTR_FLOAT;
+		VecTraits_T<CSphMatch *> dTail ( dMatchPtrs.Begin()+5, 3 );
+		for ( auto * pMatch : dMatchPtrs )
+			pMatch->SetAttr ( tCalc.m_tLoc, 0 );
+
+		CalcContextItemBatch ( dTail, tCalc );
+		ARRAY_FOREACH ( i, dMatchPtrs )
+		{
+			if ( i<5 || i>=8 )
+				ASSERT_EQ ( dMatchPtrs[i]->GetAttr ( tCalc.m_tLoc ), 0 ) << szExpr << ", match " << i;
+			else
+				ASSERT_EQ ( dMatchPtrs[i]->GetAttrFloat ( tCalc.m_tLoc ), pExpr->Eval ( *dMatchPtrs[i] ) ) << szExpr << ", match " << i;
+		}
+
+		tCalc.m_pExpr = nullptr;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 TEST ( Text, ArabicStemmer )
@@ -46,6 +46,34 @@ TEST ( ThreadPool, Counter100 )
 	ASSERT_EQ ( v, 100 );
 }
 
+TEST ( ThreadPool, Counter100Stealing )
+{
+	auto pPool = Threads::MakeStealingThreadPool ( 4, "tp" );
+	auto & tPool = *pPool;
+	std::atomic<int> v {0};
+	for ( int i=0; i<100; ++i)
+		tPool.Schedule ([&] { ++v; }, false);
+	tPool.StopAll ();
+	ASSERT_EQ ( v, 100 );
+}
+
+// tasks posted from inside the pool go to local queues and must be either executed there or stolen
+TEST ( ThreadPool, NestedStealing )
+{
+	auto pPool = Threads::MakeStealingThreadPool ( 4, "tp" );
+	auto & tPool = *pPool;
+	std::atomic<int> v {0};
+	for ( int i=0; i<100; ++i)
+		tPool.Schedule ( [&] {
+			++v;
+			for ( int j = 0; j<10; ++j )
+				tPool.Schedule ( [&] { ++v; }, j&1 );
+			tPool.ScheduleContinuation ( [&] { ++v; } );
+		}, false );
+	tPool.StopAll ();
+	ASSERT_EQ ( v, 1200 );
+}
+
 void Counter100c()
 {
 	using namespace Threads;
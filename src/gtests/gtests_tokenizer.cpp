@@ -159,6 +159,20 @@ TEST_F ( TokenizerGtest, noascii_case )
 	ASSERT_FALSE ( pTokenizer->GetToken () );
 }
 
+// ascii runs are folded in bulk; they must mix with the generic path and respect the table
+TEST_F ( TokenizerGtest, ascii_runs )
+{
+	pTokenizer = Tokenizer::Detail::CreateUTF8Tokenizer ();
+	ASSERT_TRUE ( pTokenizer->SetCaseFolding ( "0..9, A..W->a..w, a..w, X->U+445, x->U+445, y, z, U+E9", sError ) );
+	char sTest[] = "HelloWorldLongerThanSixteenChars \xC3\xA9t\xC3\xA9" "ABCxyz one!two Y";
+	pTokenizer->SetBuffer ( ( BYTE * ) sTest, (int) strlen ( sTest ) );
+	ASSERT_STREQ ( ( const char * ) pTokenizer->GetToken (), "helloworldlongerthansixteenchars" );
+	ASSERT_STREQ ( ( const char * ) pTokenizer->GetToken (), "\xC3\xA9t\xC3\xA9" "abc\xD1\x85" "yz" );
+	ASSERT_STREQ ( ( const char * ) pTokenizer->GetToken (), "one" );
+	ASSERT_STREQ ( ( const char * ) pTokenizer->GetToken (), "two" );
+	ASSERT_FALSE ( pTokenizer->GetToken () );
+}
+
 TEST_F ( TokenizerGtest, utf8_ngrams )
 {
 	pTokenizer = Tokenizer::Detail::CreateUTF8NgramTokenizer ();
@@ -12,6 +12,10 @@
 
 #include <gtest/gtest.h>
 #include "replication/wsrep_cxx.h"
+#include "replication/send_files.h"
+#include "indexfiles.h"
+
+#include <utime.h>
 
 constexpr Wsrep::UUID_t dZeroUUID { 0 };
 
@@ -70,4 +74,162 @@ TEST ( Wsrep, Gtid2Str_Str2Gtid )
 	EXPECT_TRUE ( Empty == Str2Gtid ( "" ) );
 	EXPECT_TRUE ( Empty == Str2Gtid ( "BlaBla" ) );
 	EXPECT_TRUE ( Empty == Str2Gtid ( "01234567-89Ab-CdEf-FeDc-Ba9876543210:aa" ) );
-}
\ No newline at end of file
+}
+
+// digests of disk chunk files cached in .spsha
+class SyncDigests : public ::testing::Test
+{
+protected:
+	static constexpr const char * CHUNK = "__spsha_test.0";
+
+	void SetUp() override
+	{
+		WriteFile ( ".spd", 10000 );
+		WriteFile ( ".spi", 5000 );
+		WriteFile ( ".sph", 300 ); // header is not digested
+		SetMTime ( ".spd", time ( nullptr ) - 3600 );
+		SetMTime ( ".spi", time ( nullptr ) - 3600 );
+		SetMTime ( ".sph", time ( nullptr ) - 3600 );
+	}
+
+	void TearDown() override
+	{
+		for ( const char * szExt : { ".spd", ".spi", ".sph" } )
+			unlink ( Name ( szExt ).cstr() );
+		unlink ( Name ( sphGetExt ( SPH_EXT_SPSHA ) ).cstr() );
+	}
+
+	static CSphString Name ( const char * szExt )
+	{
+		return SphSprintf ( "%s%s", CHUNK, szExt );
+	}
+
+	static void WriteFile ( const char * szExt, int iSize, BYTE uFill = 'a' )
+	{
+		FILE * fp = fopen ( Name ( szExt ).cstr(), "wb" );
+		ASSERT_TRUE ( fp );
+		CSphVector<BYTE> dData;
+		dData.Resize ( iSize );
+		dData.Fill ( uFill );
+		ASSERT_EQ ( fwrite ( dData.Begin(), 1, iSize, fp ), (size_t)iSize );
+		fclose ( fp );
+	}
+
+	static void SetMTime ( const char * szExt, time_t tMTime )
+	{
+		utimbuf tTimes { tMTime, tMTime };
+		ASSERT_EQ ( utime ( Name ( szExt ).cstr(), &tTimes ), 0 );
+	}
+
+	static std::unique_ptr<SyncSrc_t> MakeSrc()
+	{
+		StrVec_t dFiles;
+		dFiles.Add ( Name ( ".spd" ) );
+		dFiles.Add ( Name ( ".spi" ) );
+		dFiles.Add ( Name ( ".sph" ) );
+		auto pSrc = std::make_unique<SyncSrc_t> ( std::move ( dFiles ) );
+		EXPECT_TRUE ( pSrc->InitSyncSrc().has_value() );
+		return pSrc;
+	}
+
+	// fake digests, as if the files were hashed
+	static void FillDigests ( SyncSrc_t & tSrc )
+	{
+		ARRAY_FOREACH ( iFile, tSrc.m_dIndexFiles )
+		{
+			tSrc.GetFileHash ( iFile ).fill ( BYTE ( iFile+1 ) );
+			for ( int iChunk = 0; iChunk<tSrc.m_dChunks[iFile].GetChunksCount(); ++iChunk )
+				tSrc.GetChunkHash ( iFile, iChunk ).fill ( BYTE ( ( iFile+1 )*16 + iChunk ) );
+			tSrc.m_dHashTimes[iFile] = 10*( iFile+1 );
+		}
+	}
+
+	static void SaveDigests()
+	{
+		auto pSrc = MakeSrc();
+		FillDigests ( *pSrc );
+		pSrc->SaveCachedDigests ( CSphBitvec ( pSrc->m_dIndexFiles.GetLength() ) );
+	}
+
+	static void CheckCached ( const SyncSrc_t & tSrc, int iFile )
+	{
+		HASH20_t tExpected;
+		tExpected.fill ( BYTE ( iFile+1 ) );
+		ASSERT_EQ ( tSrc.GetFileHash ( iFile ), tExpected );
+		for ( int iChunk = 0; iChunk<tSrc.m_dChunks[iFile].GetChunksCount(); ++iChunk )
+		{
+			tExpected.fill ( BYTE ( ( iFile+1 )*16 + iChunk ) );
+			ASSERT_EQ ( tSrc.GetChunkHash ( iFile, iChunk ), tExpected ) << "chunk " << iChunk;
+		}
+		ASSERT_EQ ( tSrc.m_dHashTimes[iFile], 10*( iFile+1 ) );
+	}
+};
+
+TEST_F ( SyncDigests, round_trip )
+{
+	SaveDigests();
+	ASSERT_TRUE ( sphIsReadable ( Name ( sphGetExt ( SPH_EXT_SPSHA ) ) ) );
+
+	auto pSrc = MakeSrc();
+	CSphBitvec dCached ( pSrc->m_dIndexFiles.GetLength() );
+	ASSERT_EQ ( pSrc->LoadCachedDigests ( dCached ), 10000+5000 );
+	ASSERT_TRUE ( dCached.BitGet ( 0 ) );
+	ASSERT_TRUE ( dCached.BitGet ( 1 ) );
+	ASSERT_FALSE ( dCached.BitGet ( 2 ) );
+	CheckCached ( *pSrc, 0 );
+	CheckCached ( *pSrc, 1 );
+}
+
+TEST_F ( SyncDigests, size_change_invalidates )
+{
+	SaveDigests();
+	WriteFile ( ".spd", 12000 );
+	SetMTime ( ".spd", time ( nullptr ) - 3600 );
+
+	auto pSrc = MakeSrc();
+	CSphBitvec dCached ( pSrc->m_dIndexFiles.GetLength() );
+	ASSERT_EQ ( pSrc->LoadCachedDigests ( dCached ), 5000 );
+	ASSERT_FALSE ( dCached.BitGet ( 0 ) );
+	ASSERT_TRUE ( dCached.BitGet ( 1 ) );
+	CheckCached ( *pSrc, 1 );
+}
+
+TEST_F ( SyncDigests, mtime_change_invalidates )
+{
+	SaveDigests();
+	WriteFile ( ".spi", 5000, 'b' ); // same size, another content
+	SetMTime ( ".spi", time ( nullptr ) - 1800 );
+
+	auto pSrc = MakeSrc();
+	CSphBitvec dCached ( pSrc->m_dIndexFiles.GetLength() );
+	ASSERT_EQ ( pSrc->LoadCachedDigests ( dCached ), 10000 );
+	ASSERT_TRUE ( dCached.BitGet ( 0 ) );
+	ASSERT_FALSE ( dCached.BitGet ( 1 ) );
+	CheckCached ( *pSrc, 0 );
+}
+
+TEST_F ( SyncDigests, recent_files_not_cached )
+{
+	// files modified just now might change once more within the same mtime
+	SetMTime ( ".spd", time ( nullptr ) );
+	SaveDigests();
+
+	auto pSrc = MakeSrc();
+	CSphBitvec dCached ( pSrc->m_dIndexFiles.GetLength() );
+	ASSERT_EQ ( pSrc->LoadCachedDigests ( dCached ), 5000 );
+	ASSERT_FALSE ( dCached.BitGet ( 0 ) );
+	ASSERT_TRUE ( dCached.BitGet ( 1 ) );
+}
+
+TEST_F ( SyncDigests, broken_cache_ignored )
+{
+	FILE * fp = fopen ( Name ( sphGetExt ( SPH_EXT_SPSHA ) ).cstr(), "wb" );
+	ASSERT_TRUE ( fp );
+	fputs ( "garbage", fp );
+	fclose ( fp );
+
+	auto pSrc = MakeSrc();
+	CSphBitvec dCached ( pSrc->m_dIndexFiles.GetLength() );
+	ASSERT_EQ ( pSrc->LoadCachedDigests ( dCached ), 0 );
+	ASSERT_EQ ( dCached.BitCount(), 0u );
+}
@@ -197,6 +197,12 @@ public:
 			m_tStorage.Update ( i, tRhs.m_tStorage.Get(i) );
 	}
 
+	// raw register access, for (de)serializing sketches
+	int		GetAccuracy() const { return m_iP; }
+	int		GetNumRegisters() const { return m_iM; }
+	FORCE_INLINE uint8_t GetRegister ( int iRegister ) const { return m_tStorage.Get(iRegister); }
+	FORCE_INLINE void UpdateRegister ( int iRegister, uint8_t uValue ) { m_tStorage.Update ( iRegister, uValue ); }
+
 private:
 	static const int MIN_P = 14;
 
@@ -54,6 +54,7 @@ static const DWORD PQ_META_VERSION = 7;					///< current version
 
 static bool g_bLargeDocid = false;
 static CSphString g_sOutDir;
+static CSphString g_sDoclistFormat;
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -158,6 +159,7 @@ struct IndexSettings_t : public CSphSourceSettings
 	int				m_iEmbeddedLimit = 0;
 	int64_t			m_tBlobUpdateSpace = 0;
 	int				m_iSkiplistBlockSize = 0;
+	DoclistFormat_e	m_eDoclistFormat = DoclistFormat_e::PLAIN;	///< doclist format of the converted table (legacy tables are all plain)
 
 	ESphBigram				m_eBigramIndex = SPH_BIGRAM_NONE;
 	CSphString				m_sBigramWords;
@@ -330,6 +332,52 @@ static void LoadIndexSettings ( IndexSettings_t & tSettings, CSphReader & tReade
 }
 
 
+/// new defaults for the converted table settings, with the command line overrides
+static bool SetupDefaultSettings ( CSphIndexSettings & tDefaultSettings, const CSphString & sIndex, CSphString & sWarning, CSphString & sError )
+{
+	CSphConfigSection hIndex;
+	if ( !g_sDoclistFormat.IsEmpty() )
+		hIndex.AddEntry ( "doclist_format", g_sDoclistFormat.cstr() );
+
+	return tDefaultSettings.Setup ( hIndex, sIndex.cstr(), sWarning, sError );
+}
+
+
+/// write settings in the order the current LoadIndexSettings() reads them at INDEX_FORMAT_VERSION
+static void SaveIndexSettings ( CSphWriter & tWriter, const IndexSettings_t & tSettings, ESphHitFormat eHitFormat )
+{
+	tWriter.PutDword ( tSettings.RawMinPrefixLen() );
+	tWriter.PutDword ( tSettings.m_iMinInfixLen );
+	tWriter.PutDword ( tSettings.m_iMaxSubstringLen );
+	tWriter.PutByte ( tSettings.m_bHtmlStrip ? 1 : 0 );
+	tWriter.PutString ( tSettings.m_sHtmlIndexAttrs.cstr () );
+	tWriter.PutString ( tSettings.m_sHtmlRemoveElements.cstr () );
+	tWriter.PutByte ( tSettings.m_bIndexExactWords ? 1 : 0 );
+	tWriter.PutDword ( tSettings.m_eHitless );
+	tWriter.PutDword ( eHitFormat );
+	tWriter.PutByte ( tSettings.m_bIndexSP ? 1 : 0 );
+	tWriter.PutString ( tSettings.m_sZones );
+	tWriter.PutDword ( tSettings.m_iBoundaryStep );
+	tWriter.PutDword ( tSettings.m_iStopwordStep );
+	tWriter.PutDword ( tSettings.m_iOvershortStep );
+	tWriter.PutDword ( tSettings.m_iEmbeddedLimit );
+	tWriter.PutByte ( tSettings.m_eBigramIndex );
+	tWriter.PutByte ( (BYTE)BigramDelimiter_e::DEFAULT ); // v.69+
+	tWriter.PutString ( tSettings.m_sBigramWords );
+	tWriter.PutByte ( tSettings.m_bIndexFieldLens );
+	tWriter.PutByte ( tSettings.m_ePreprocessor==Preprocessor_e::ICU ? 1 : 0 );
+	tWriter.PutString("");	// was: rlp context
+	tWriter.PutString ( tSettings.m_sIndexTokenFilter );
+	tWriter.PutOffset ( tSettings.m_tBlobUpdateSpace );
+	tWriter.PutDword ( tSettings.m_iSkiplistBlockSize );
+	tWriter.PutString ( "" ); // tSettings.m_sHitlessFiles, v.60+
+	tWriter.PutDword ( (DWORD)AttrEngine_e::DEFAULT ); // v.63+
+	tWriter.PutDword ( (DWORD)JiebaMode_e::DEFAULT ); // v.67+
+	tWriter.PutByte ( 1 ); // jieba HMM
+	tWriter.PutByte ( (BYTE)tSettings.m_eDoclistFormat ); // v.71+
+}
+
+
 static bool LoadTokenizerSettings ( CSphReader & tReader, CSphTokenizerSettings & tSettings, CSphEmbeddedFiles & tEmbeddedFiles, DWORD uVersion, CSphString & sWarning )
 {
 	tSettings.m_iType = tReader.GetByte ();
@@ -1139,6 +1187,8 @@ bool ConverterPlain_t::ConvertDoclist ( Index_t & tIndex, CSphString & sError )
 	m_hDoclist.Reset ( tIndex.m_iDocinfo );
 
 	DWORD uSkiplistBlock = tIndex.m_tSettings.m_iSkiplistBlockSize;
+	const bool bBlockDoclist = tIndex.m_tSettings.m_eDoclistFormat==DoclistFormat_e::BLOCK;
+	DoclistWriter_c tDoclistWriter ( tWriterDocs, tIndex.m_tSettings.m_eDoclistFormat );
 
 	while ( uDoclistEnd!=tDoclist.GetPos() )
 	{
@@ -1158,7 +1208,7 @@ bool ConverterPlain_t::ConvertDoclist ( Index_t & tIndex, CSphString & sError )
 			uDelta = tDoclist.UnzipOffset();
 			if ( !uDelta )
 			{
-				tWriterDocs.ZipOffset ( 0 );
+				tDoclistWriter.EndList();
 				break;
 			}
 
@@ -1173,9 +1223,10 @@ bool ConverterPlain_t::ConvertDoclist ( Index_t & tIndex, CSphString & sError )
 					t.m_tBaseRowIDPlus1 = tSkiplistRowID+1;
 					t.m_iOffset = tWriterDocs.GetPos();
 					t.m_iBaseHitlistPos = uLastHitpos;
+					t.m_uMaxHits = t.m_uFields = 0;
 				}
 
-				tWriterDocs.ZipOffset ( *pRow - tLastRowID );
+				tDoclistWriter.BeginEntry ( *pRow - tLastRowID );
 
 				tLastRowID = *pRow;
 				tSkiplistRowID = *pRow;
@@ -1188,21 +1239,30 @@ bool ConverterPlain_t::ConvertDoclist ( Index_t & tIndex, CSphString & sError )
 				const DWORD uFirst = tDoclist.UnzipInt();
 				if ( pRow )
 				{
-					 tWriterDocs.ZipInt ( uMatchHits );
-					 tWriterDocs.ZipInt ( uFirst );
+					 tDoclistWriter.ZipInt ( uMatchHits );
+					 tDoclistWriter.ZipInt ( uFirst );
 				}
+				DWORD uFields = uFirst;
 				if ( uMatchHits==1 )
 				{
 					const DWORD uField = tDoclist.UnzipInt();
 					if ( pRow )
-						tWriterDocs.ZipInt ( uField );
+						tDoclistWriter.ZipInt ( uField );
+					uFields = ( uField>>1 )<32 ? ( 1UL << ( uField>>1 ) ) : 0;
 				} else
 				{
 					const SphOffset_t uHitPosDelta = tDoclist.UnzipOffset();
 					assert ( uHitPosDelta>=0 );
 					uLastHitpos += uHitPosDelta;
 					if ( pRow )
-						tWriterDocs.ZipOffset ( uHitPosDelta );
+						tDoclistWriter.ZipOffset ( uHitPosDelta );
+				}
+
+				if ( pRow )
+				{
+					dSkiplist.Last().m_uMaxHits = Max ( dSkiplist.Last().m_uMaxHits, uMatchHits );
+					dSkiplist.Last().m_uFields |= uFields;
+					tDoclistWriter.EndEntry();
 				}
 			} else
 			{
@@ -1212,24 +1272,21 @@ bool ConverterPlain_t::ConvertDoclist ( Index_t & tIndex, CSphString & sError )
 				uLastHitpos += uHitPosDelta;
 				if ( pRow )
 				{
-					tWriterDocs.ZipOffset ( uHitPosDelta );
-					tWriterDocs.ZipInt ( uMatchHits );
+					tDoclistWriter.ZipOffset ( uHitPosDelta );
+					tDoclistWriter.ZipInt ( uMatchHits );
+					tDoclistWriter.EndEntry();
+
+					// old plain format has no field mask
+					dSkiplist.Last().m_uMaxHits = Max ( dSkiplist.Last().m_uMaxHits, uMatchHits );
+					dSkiplist.Last().m_uFields = 0xFFFFFFFFUL;
 				}
 			}
 		}
 
 		// write skiplist
 		SphOffset_t uSkip = (int)tWriterSkips.GetPos();
-		for ( int i=1; i<dSkiplist.GetLength(); i++ )
-		{
-			const SkiplistEntry_t & tPrev = dSkiplist[i-1];
-			const SkiplistEntry_t & tCur = dSkiplist[i];
-			assert ( tCur.m_tBaseRowIDPlus1 - tPrev.m_tBaseRowIDPlus1>=uSkiplistBlock );
-			assert ( tCur.m_iOffset - tPrev.m_iOffset>=4*uSkiplistBlock );
-			tWriterSkips.ZipInt ( tCur.m_tBaseRowIDPlus1 - tPrev.m_tBaseRowIDPlus1 - uSkiplistBlock );
-			tWriterSkips.ZipOffset ( tCur.m_iOffset - tPrev.m_iOffset - 4*uSkiplistBlock );
-			tWriterSkips.ZipOffset ( tCur.m_iBaseHitlistPos - tPrev.m_iBaseHitlistPos );
-		}
+		if ( iDocs>(int)uSkiplistBlock )
+			ZipSkiplist ( tWriterSkips, dSkiplist, iDocs, (int)uSkiplistBlock, bBlockDoclist );
 
 		DoclistOffsets_t tOffsets;
 		tOffsets.m_uDoclist = uNewDoclist;
@@ -1505,30 +1562,7 @@ void ConverterPlain_t::SaveHeader ( const Index_t & tIndex, DWORD uKillListSize
 	tWriter.PutOffset ( tIndex.m_iTotalBytes );
 
 	// index settings
-	tWriter.PutDword ( tIndex.m_tSettings.RawMinPrefixLen() );
-	tWriter.PutDword ( tIndex.m_tSettings.m_iMinInfixLen );
-	tWriter.PutDword ( tIndex.m_tSettings.m_iMaxSubstringLen );
-	tWriter.PutByte ( tIndex.m_tSettings.m_bHtmlStrip ? 1 : 0 );
-	tWriter.PutString ( tIndex.m_tSettings.m_sHtmlIndexAttrs.cstr () );
-	tWriter.PutString ( tIndex.m_tSettings.m_sHtmlRemoveElements.cstr () );
-	tWriter.PutByte ( tIndex.m_tSettings.m_bIndexExactWords ? 1 : 0 );
-	tWriter.PutDword ( tIndex.m_tSettings.m_eHitless );
-	tWriter.PutDword ( SPH_HIT_FORMAT_INLINE );
-	tWriter.PutByte ( tIndex.m_tSettings.m_bIndexSP ? 1 : 0 );
-	tWriter.PutString ( tIndex.m_tSettings.m_sZones );
-	tWriter.PutDword ( tIndex.m_tSettings.m_iBoundaryStep );
-	tWriter.PutDword ( tIndex.m_tSettings.m_iStopwordStep );
-	tWriter.PutDword ( tIndex.m_tSettings.m_iOvershortStep );
-	tWriter.PutDword ( tIndex.m_tSettings.m_iEmbeddedLimit );
-	tWriter.PutByte ( tIndex.m_tSettings.m_eBigramIndex );
-	tWriter.PutString ( tIndex.m_tSettings.m_sBigramWords );
-	tWriter.PutByte ( tIndex.m_tSettings.m_bIndexFieldLens );
-	tWriter.PutByte ( tIndex.m_tSettings.m_ePreprocessor==Preprocessor_e::ICU ? 1 : 0 );
-	tWriter.PutString("");	// was: rlp context
-	tWriter.PutString ( tIndex.m_tSettings.m_sIndexTokenFilter );
-	tWriter.PutOffset ( tIndex.m_tSettings.m_tBlobUpdateSpace );
-	tWriter.PutDword ( tIndex.m_tSettings.m_iSkiplistBlockSize );
-	tWriter.PutString ( "" ); // tSettings.m_sHitlessFiles
+	SaveIndexSettings ( tWriter, tIndex.m_tSettings, SPH_HIT_FORMAT_INLINE );
 
 	// tokenizer
 	SaveTokenizerSettings ( tWriter, tIndex.m_pTokenizer, tIndex.m_tSettings.m_iEmbeddedLimit );
@@ -1583,10 +1617,9 @@ static void CopyAndUpdateSchema ( const Index_t & tIndex, CSphSchema & tSchema )
 bool ConverterPlain_t::Init ( Index_t & tIndex, CSphString & sError )
 {
 	// merge index settings with new defaults
-	CSphConfigSection hIndex;
 	CSphIndexSettings tDefaultSettings;
 	CSphString sWarning;
-	if ( !tDefaultSettings.Setup ( hIndex, tIndex.m_sName.cstr(), sWarning, sError ) )
+	if ( !SetupDefaultSettings ( tDefaultSettings, tIndex.m_sName, sWarning, sError ) )
 		return false;
 
 	if ( !sWarning.IsEmpty() )
@@ -1594,6 +1627,7 @@ bool ConverterPlain_t::Init ( Index_t & tIndex, CSphString & sError )
 
 	tIndex.m_tSettings.m_tBlobUpdateSpace = tDefaultSettings.m_tBlobUpdateSpace;
 	tIndex.m_tSettings.m_iSkiplistBlockSize = tDefaultSettings.m_iSkiplistBlockSize;
+	tIndex.m_tSettings.m_eDoclistFormat = tDefaultSettings.m_eDoclistFormat;
 
 	// old schema to new schema
 	CopyAndUpdateSchema ( tIndex, m_tSchema );
@@ -1995,11 +2029,14 @@ static bool SaveRtIndex ( Index_t & tIndex, CSphString & sWarning, CSphString &
 		CopyAndUpdateSchema ( tIndex, tIndex.m_tSchema );
 
 	// merge index settings with new defaults
-	CSphConfigSection hIndex;
 	CSphIndexSettings tDefaultSettings;
-	if ( !tDefaultSettings.Setup ( hIndex, tIndex.m_sName.cstr(), sWarning, sError ) )
+	if ( !SetupDefaultSettings ( tDefaultSettings, tIndex.m_sName, sWarning, sError ) )
 		return false;
 
+	tIndex.m_tSettings.m_tBlobUpdateSpace = tDefaultSettings.m_tBlobUpdateSpace;
+	tIndex.m_tSettings.m_iSkiplistBlockSize = tDefaultSettings.m_iSkiplistBlockSize;
+	tIndex.m_tSettings.m_eDoclistFormat = tDefaultSettings.m_eDoclistFormat;
+
 	// write new meta
 	CSphString sMetaNew;
 	sMetaNew.SetSprintf ( "%s.new.meta", tIndex.m_sPathOut.cstr() );
@@ -2018,30 +2055,7 @@ static bool SaveRtIndex ( Index_t & tIndex, CSphString & sWarning, CSphString &
 	WriteSchema ( wrMeta, tIndex.m_tSchema );
 
 	// index settings
-	wrMeta.PutDword ( tIndex.m_tSettings.RawMinPrefixLen() );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iMinInfixLen );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iMaxSubstringLen );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bHtmlStrip ? 1 : 0 );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sHtmlIndexAttrs.cstr () );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sHtmlRemoveElements.cstr () );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bIndexExactWords ? 1 : 0 );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_eHitless );
-	wrMeta.PutDword ( SPH_HIT_FORMAT_INLINE );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bIndexSP ? 1 : 0 );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sZones );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iBoundaryStep );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iStopwordStep );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iOvershortStep );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iEmbeddedLimit );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_eBigramIndex );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sBigramWords );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bIndexFieldLens );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_ePreprocessor==Preprocessor_e::ICU ? 1 : 0 );
-	wrMeta.PutString (""); // was: RLP context
-	wrMeta.PutString ( tIndex.m_tSettings.m_sIndexTokenFilter );
-	wrMeta.PutOffset ( tDefaultSettings.m_tBlobUpdateSpace );
-	wrMeta.PutDword ( tDefaultSettings.m_iSkiplistBlockSize );
-	wrMeta.PutString ( "" ); // tSettings.m_sHitlessFiles
+	SaveIndexSettings ( wrMeta, tIndex.m_tSettings, SPH_HIT_FORMAT_INLINE );
 
 	// tokenizer
 	SaveTokenizerSettings ( wrMeta, tIndex.m_pTokenizer, tIndex.m_tSettings.m_iEmbeddedLimit );
@@ -2249,9 +2263,8 @@ static bool SavePqIndex ( Index_t & tIndex, CSphString & sWarning, CSphString &
 		return false;
 
 	// merge index settings with new defaults
-	CSphConfigSection hIndex;
 	CSphIndexSettings tDefaultSettings;
-	if ( !tDefaultSettings.Setup ( hIndex, tIndex.m_sName.cstr(), sWarning, sError ) )
+	if ( !SetupDefaultSettings ( tDefaultSettings, tIndex.m_sName, sWarning, sError ) )
 		return false;
 
 	// write new meta
@@ -2268,29 +2281,7 @@ static bool SavePqIndex ( Index_t & tIndex, CSphString & sWarning, CSphString &
 	WriteSchema ( wrMeta, tIndex.m_tSchema );
 
 	// index settings
-	wrMeta.PutDword ( tIndex.m_tSettings.RawMinPrefixLen() );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iMinInfixLen );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iMaxSubstringLen );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bHtmlStrip ? 1 : 0 );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sHtmlIndexAttrs.cstr () );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sHtmlRemoveElements.cstr () );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bIndexExactWords ? 1 : 0 );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_eHitless );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_eHitFormat );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bIndexSP );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sZones );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iBoundaryStep );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iStopwordStep );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iOvershortStep );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iEmbeddedLimit );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_eBigramIndex );
-	wrMeta.PutString ( tIndex.m_tSettings.m_sBigramWords );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_bIndexFieldLens );
-	wrMeta.PutByte ( tIndex.m_tSettings.m_ePreprocessor==Preprocessor_e::ICU ? 1 : 0 );
-	wrMeta.PutString("");	// was: RLP context
-	wrMeta.PutString ( tIndex.m_tSettings.m_sIndexTokenFilter );
-	wrMeta.PutOffset ( tIndex.m_tSettings.m_tBlobUpdateSpace );
-	wrMeta.PutDword ( tIndex.m_tSettings.m_iSkiplistBlockSize );
+	SaveIndexSettings ( wrMeta, tIndex.m_tSettings, tIndex.m_tSettings.m_eHitFormat );
 
 	SaveTokenizerSettings ( wrMeta, tIndex.m_pTokenizer, tIndex.m_tSettings.m_iEmbeddedLimit );
 	SaveDictionarySettings ( wrMeta, tIndex.m_pDict, false, tIndex.m_tSettings.m_iEmbeddedLimit );
@@ -2467,6 +2458,7 @@ static void ShowHelp ()
 		"--output-dir <dir>\t\toutput directory for converted files\n"
 		"--all\t\t\t\tconvert all tables in config file\n"
 		"--killlist-target <targets>\tsets the tables that the kill-list will be applied to\n"
+		"--doclist-format <plain|block>\tdoclist format of the converted tables (default is plain)\n"
 	);
 }
 
@@ -2551,6 +2543,16 @@ int main ( int argc, char ** argv )
 			bKlistTargetCLI = true;
 			sKlistTarget = argv[i];
 
+		} else if ( strcmp ( argv[i], "--doclist-format" )==0 )
+		{
+			if ( ++i>=argc )
+				sphDie ( "doclist format requires an argument" );
+
+			if ( strcmp ( argv[i], "plain" )!=0 && strcmp ( argv[i], "block" )!=0 )
+				sphDie ( "unknown doclist format '%s' (must be plain or block)", argv[i] );
+
+			legacy::g_sDoclistFormat = argv[i];
+
 		} else
 		{
 			sphDie ( "unknown switch: %s", argv[i] );
@@ -413,6 +413,7 @@ private:
 
 	void	CheckDictionary();
 	void	CheckDocs ( cbWordidFn&& cbfndoc = nullptr );
+	bool	CheckBlockMax ( const SkiplistEntry_t & tExpected, int iEntry, SphWordID_t uWordid, const char * sWord );
 	void	CheckAttributes();
 	void	CheckKillList() const;
 	void	CheckBlockIndex();
@@ -1121,7 +1122,7 @@ void DiskIndexChecker_c::Impl_c::CheckDocs( cbWordidFn&& fnCbWordid )
 		}
 
 		// create and manually setup doclist reader
-		DiskIndexQwordTraits_c * pQword = sphCreateDiskIndexQword ( tIndexSettings.m_eHitFormat==SPH_HIT_FORMAT_INLINE );
+		DiskIndexQwordTraits_c * pQword = sphCreateDiskIndexQword ( tIndexSettings.m_eHitFormat==SPH_HIT_FORMAT_INLINE, tIndexSettings.m_eDoclistFormat==DoclistFormat_e::BLOCK );
 
 		pQword->m_tDoc.Reset ( m_tSchema.GetDynamicSize() );
 		pQword->m_tDoc.m_tRowID = INVALID_ROWID;
@@ -1151,6 +1152,7 @@ void DiskIndexChecker_c::Impl_c::CheckDocs( cbWordidFn&& fnCbWordid )
 				tBlock.m_tBaseRowIDPlus1 = pQword->m_tDoc.m_tRowID+1;
 				tBlock.m_iOffset = pQword->m_rdDoclist->GetPos();
 				tBlock.m_iBaseHitlistPos = pQword->m_uHitPosition;
+				tBlock.m_uMaxHits = tBlock.m_uFields = 0;
 			}
 
 			// FIXME? this can fail on a broken entry (eg fieldid over 256)
@@ -1165,6 +1167,10 @@ void DiskIndexChecker_c::Impl_c::CheckDocs( cbWordidFn&& fnCbWordid )
 			++iDoclistDocs;
 			iDoclistHits += pQword->m_uMatchHits;
 
+			// block-max, as the indexer computes it
+			dDoclistSkips.Last().m_uMaxHits = Max ( dDoclistSkips.Last().m_uMaxHits, pQword->m_uMatchHits );
+			dDoclistSkips.Last().m_uFields |= pQword->m_dQwordFields.GetMask32();
+
 			// check position in case of regular (not-inline) hit
 			if (!( pQword->m_iHitlistPos>>63 ))
 			{
@@ -1255,13 +1261,19 @@ void DiskIndexChecker_c::Impl_c::CheckDocs( cbWordidFn&& fnCbWordid )
 			if ( ( iDoclistDocs & ( tIndexSettings.m_iSkiplistBlockSize-1 ) )==0 )
 				dDoclistSkips.Pop();
 
+			FoldSkiplistTail ( dDoclistSkips, iDoclistDocs, tIndexSettings.m_iSkiplistBlockSize );
+			const bool bBlockMax = m_uVersion>=70;
+
 			SkiplistEntry_t t;
 			t.m_tBaseRowIDPlus1 = 0;
 			t.m_iOffset = iDoclistOffset;
 			t.m_iBaseHitlistPos = 0;
 
 			// hint is: dDoclistSkips * ZIPPED( sizeof(int64_t) * 3 ) == dDoclistSkips * 8
-			m_tSkipsReader.SeekTo ( iSkipsOffset, dDoclistSkips.GetLength ()*8 );
+			m_tSkipsReader.SeekTo ( iSkipsOffset, dDoclistSkips.GetLength ()*( bBlockMax ? 10 : 8 ) );
+			if ( bBlockMax && !CheckBlockMax ( dDoclistSkips[0], 0, uWordid, sWord ) )
+				break;
+
 			int i = 0;
 			while ( ++i<dDoclistSkips.GetLength() )
 			{
@@ -1279,7 +1291,7 @@ void DiskIndexChecker_c::Impl_c::CheckDocs( cbWordidFn&& fnCbWordid )
 				}
 
 				t.m_tBaseRowIDPlus1 += tIndexSettings.m_iSkiplistBlockSize + tRowIDDelta;
-				t.m_iOffset += 4*tIndexSettings.m_iSkiplistBlockSize + uOff;
+				t.m_iOffset += SkiplistMinBlockBytes ( tIndexSettings.m_iSkiplistBlockSize, tIndexSettings.m_eDoclistFormat==DoclistFormat_e::BLOCK ) + uOff;
 				t.m_iBaseHitlistPos += uPosDelta;
 				if ( t.m_tBaseRowIDPlus1!=r.m_tBaseRowIDPlus1 || t.m_iOffset!=r.m_iOffset || t.m_iBaseHitlistPos!=r.m_iBaseHitlistPos )
 				{
@@ -1289,6 +1301,9 @@ void DiskIndexChecker_c::Impl_c::CheckDocs( cbWordidFn&& fnCbWordid )
 						t.m_tBaseRowIDPlus1, UINT64 ( t.m_iOffset ), UINT64 ( t.m_iBaseHitlistPos ) );
 					break;
 				}
+
+				if ( bBlockMax && !CheckBlockMax ( r, i, uWordid, sWord ) )
+					break;
 			}
 			break;
 		}
@@ -1306,6 +1321,29 @@ void DiskIndexChecker_c::Impl_c::CheckDocs( cbWordidFn&& fnCbWordid )
 }
 
 
+bool DiskIndexChecker_c::Impl_c::CheckBlockMax ( const SkiplistEntry_t & tExpected, int iEntry, SphWordID_t uWordid, const char * sWord )
+{
+	DWORD uMaxHits = m_tSkipsReader.UnzipInt();
+	DWORD uFields = m_tSkipsReader.UnzipInt();
+
+	if ( m_tSkipsReader.GetErrorFlag () )
+	{
+		m_tReporter.Fail ( "skiplist block-max reading error (wordid=" UINT64_FMT "(%s), entry=%d, error='%s')", UINT64 ( uWordid ), sWord, iEntry, m_tSkipsReader.GetErrorMessage ().cstr () );
+		m_tSkipsReader.ResetError();
+		return false;
+	}
+
+	if ( uMaxHits!=tExpected.m_uMaxHits || uFields!=tExpected.m_uFields )
+	{
+		m_tReporter.Fail ( "skiplist entry %d block-max mismatch (wordid=" UINT64_FMT "(%s), exp={%u, 0x%x}, got={%u, 0x%x})",
+			iEntry, UINT64 ( uWordid ), sWord, tExpected.m_uMaxHits, tExpected.m_uFields, uMaxHits, uFields );
+		return false;
+	}
+
+	return true;
+}
+
+
 void DiskIndexChecker_c::Impl_c::CheckAttributes()
 {
 	if ( !m_tSchema.HasNonColumnarAttrs() )
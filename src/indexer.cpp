@@ -2016,6 +2016,7 @@ int main ( int argc, char ** argv )
 		sphSetThrottling ( hIndexer.GetInt ( "max_iops", 0 ), hIndexer.GetSize ( "max_iosize", 0 ) );
 
 		sphAotSetCacheSize ( hIndexer.GetSize ( "lemmatizer_cache", 262144 ) );
+		SetIndexerSortThreads ( hIndexer.GetInt ( "sort_threads", 1 ) );
 	}
 
 	sphConfigureCommon ( hConf );
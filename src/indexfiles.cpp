@@ -37,7 +37,8 @@ static IndexFileExt_t g_dIndexFilesExts[SPH_EXT_TOTAL] =
 	{ SPH_EXT_SETTINGS,	".settings", 1,	true,	false,	"table runtime settings" },
 	{ SPH_EXT_SPIDX,	".spidx",	62,	true,	true,	"secondary index" },
 	{ SPH_EXT_SPJIDX,	".spjidx",	66,	true,	true,	"secondary index for json attributes" },
-	{ SPH_EXT_SPKNN,	".spknn",	65,	true,	true,	"knn index" }
+	{ SPH_EXT_SPKNN,	".spknn",	65,	true,	true,	"knn index" },
+	{ SPH_EXT_SPSHA,	".spsha",	1,	true,	true,	"cached sha1 of chunk files for replication" }
 };
 
 
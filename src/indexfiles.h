@@ -38,6 +38,7 @@ enum ESphExt : BYTE
 	SPH_EXT_SPIDX,
 	SPH_EXT_SPJIDX,
 	SPH_EXT_SPKNN,
+	SPH_EXT_SPSHA,
 
 	SPH_EXT_TOTAL
 };
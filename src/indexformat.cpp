@@ -11,6 +11,11 @@
 //
 
 #include "indexformat.h"
+#include "fileio.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+	#include <emmintrin.h>
+#endif
 
 #if WITH_RE2
 #include <string>
@@ -66,6 +71,200 @@ void DiskIndexQwordTraits_c::ResetDecoderState ()
 	m_uHitState = 0;
 	m_tDoc.m_tRowID = INVALID_ROWID;
 	m_iHitPos = EMPTY_HIT;
+	m_iHitDelta = m_iHitDeltas = 0;
+	ResetDoclistBlock();
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+int DoclistBlockBits ( const DWORD * pDeltas )
+{
+	DWORD uOr = 0;
+	for ( int i = 0; i<DOCLIST_BLOCK_DOCS; ++i )
+		uOr |= pDeltas[i];
+
+	return sphLog2 ( uOr );
+}
+
+// lane l holds deltas l, l+4, l+8, ...; lane words are interleaved, so every 16 bytes carry one word of each lane
+// a delta either fits the rest of the current lane word, or is split between it and the next one
+
+void DoclistBlockPack ( const DWORD * pDeltas, int iBits, BYTE * pOut )
+{
+	assert ( iBits>=0 && iBits<=32 );
+	const int LANES = 4;
+	DWORD dWords[DOCLIST_BLOCK_DOCS];
+	memset ( dWords, 0, iBits*LANES*sizeof(DWORD) );
+
+	for ( int iLane = 0; iLane<LANES; ++iLane )
+	{
+		int iWord = 0;
+		int iShift = 0;
+		for ( int i = iLane; i<DOCLIST_BLOCK_DOCS; i += LANES )
+		{
+			DWORD uDelta = pDeltas[i];
+			dWords[iWord*LANES+iLane] |= uDelta << iShift;
+			iShift += iBits;
+			if ( iShift<32 )
+				continue;
+
+			iShift -= 32;
+			++iWord;
+			if ( iShift )
+				dWords[iWord*LANES+iLane] |= uDelta >> ( iBits-iShift );
+		}
+	}
+
+	memcpy ( pOut, dWords, iBits*LANES*sizeof(DWORD) );
+}
+
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+void DoclistBlockUnpack ( const BYTE * pIn, int iBits, DWORD * pDeltas )
+{
+	assert ( iBits>=0 && iBits<=32 );
+	if ( !iBits )
+	{
+		memset ( pDeltas, 0, DOCLIST_BLOCK_DOCS*sizeof(DWORD) );
+		return;
+	}
+
+	const __m128i tMask = _mm_set1_epi32 ( iBits==32 ? -1 : (int)( ( 1U<<iBits )-1 ) );
+	auto pWords = (const __m128i *)pIn;
+	__m128i tWord = _mm_loadu_si128 ( pWords );
+	int iWord = 0;
+	int iShift = 0;
+	for ( int i = 0; i<DOCLIST_BLOCK_DOCS; i += 4 )
+	{
+		__m128i tDeltas = _mm_srl_epi32 ( tWord, _mm_cvtsi32_si128 ( iShift ) );
+		iShift += iBits;
+		if ( iShift>=32 )
+		{
+			iShift -= 32;
+			if ( ++iWord<iBits )
+			{
+				tWord = _mm_loadu_si128 ( pWords+iWord );
+				if ( iShift )
+					tDeltas = _mm_or_si128 ( tDeltas, _mm_sll_epi32 ( tWord, _mm_cvtsi32_si128 ( iBits-iShift ) ) );
+			}
+		}
+
+		_mm_storeu_si128 ( (__m128i *)( pDeltas+i ), _mm_and_si128 ( tDeltas, tMask ) );
+	}
+}
+#else
+void DoclistBlockUnpack ( const BYTE * pIn, int iBits, DWORD * pDeltas )
+{
+	assert ( iBits>=0 && iBits<=32 );
+	const int LANES = 4;
+	DWORD dWords[DOCLIST_BLOCK_DOCS];
+	memcpy ( dWords, pIn, iBits*LANES*sizeof(DWORD) );
+	const DWORD uMask = iBits==32 ? 0xFFFFFFFFUL : ( 1UL<<iBits )-1;
+
+	for ( int iLane = 0; iLane<LANES; ++iLane )
+	{
+		int iWord = 0;
+		int iShift = 0;
+		for ( int i = iLane; i<DOCLIST_BLOCK_DOCS; i += LANES )
+		{
+			DWORD uDelta = iBits ? dWords[iWord*LANES+iLane] >> iShift : 0;
+			iShift += iBits;
+			if ( iShift>=32 )
+			{
+				iShift -= 32;
+				++iWord;
+				if ( iShift )
+					uDelta |= dWords[iWord*LANES+iLane] << ( iBits-iShift );
+			}
+
+			pDeltas[i] = uDelta & uMask;
+		}
+	}
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+
+DoclistWriter_c::DoclistWriter_c ( CSphWriter & tWriter, DoclistFormat_e eFormat )
+	: m_tWriter ( tWriter )
+	, m_bBlock ( eFormat==DoclistFormat_e::BLOCK )
+{}
+
+
+void DoclistWriter_c::BeginEntry ( RowID_t uRowidDelta )
+{
+	assert ( uRowidDelta );
+	if ( m_bBlock )
+		m_dDeltas[m_iEntries] = uRowidDelta;
+	else
+		m_tWriter.ZipInt ( uRowidDelta );
+}
+
+
+void DoclistWriter_c::ZipInt ( DWORD uValue )
+{
+	if ( m_bBlock )
+		m_tEntries.ZipInt ( uValue );
+	else
+		m_tWriter.ZipInt ( uValue );
+}
+
+
+void DoclistWriter_c::ZipOffset ( uint64_t uValue )
+{
+	if ( m_bBlock )
+		m_tEntries.ZipOffset ( uValue );
+	else
+		m_tWriter.ZipOffset ( uValue );
+}
+
+
+void DoclistWriter_c::EndEntry()
+{
+	if ( !m_bBlock )
+		return;
+
+	m_dEntryEnds[m_iEntries++] = m_dEntries.GetLength();
+	if ( m_iEntries==DOCLIST_BLOCK_DOCS )
+		FlushBlock();
+}
+
+
+void DoclistWriter_c::FlushBlock()
+{
+	assert ( m_iEntries==DOCLIST_BLOCK_DOCS );
+	BYTE dPacked[DOCLIST_BLOCK_DOCS*sizeof(DWORD)];
+	int iBits = DoclistBlockBits ( m_dDeltas );
+	DoclistBlockPack ( m_dDeltas, iBits, dPacked );
+
+	m_tWriter.PutByte ( (BYTE)iBits );
+	m_tWriter.PutBytes ( dPacked, iBits*16 );
+	m_tWriter.PutBytes ( m_dEntries.Begin(), m_dEntries.GetLength() );
+
+	m_iEntries = 0;
+	m_dEntries.Resize ( 0 );
+}
+
+
+void DoclistWriter_c::EndList()
+{
+	if ( m_bBlock )
+	{
+		m_tWriter.PutByte ( DOCLIST_TAIL_BLOCK );
+		int iStart = 0;
+		for ( int i = 0; i<m_iEntries; ++i )
+		{
+			m_tWriter.ZipInt ( m_dDeltas[i] );
+			m_tWriter.PutBytes ( m_dEntries.Begin()+iStart, m_dEntryEnds[i]-iStart );
+			iStart = m_dEntryEnds[i];
+		}
+
+		m_iEntries = 0;
+		m_dEntries.Resize ( 0 );
+	}
+
+	// end-of-doclist marker
+	m_tWriter.ZipInt ( 0 );
 }
 
 //////////////////////////////////////////////////////////////////////////
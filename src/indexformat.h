@@ -19,6 +19,7 @@
 #include "indexing_sources/source_stats.h"
 #include "dict/dict_entry.h"
 #include "dict/infix/infix_builder.h"
+#include "memio.h"
 
 const int	DOCLIST_HINT_THRESH = 256;
 const DWORD HITLESS_DOC_MASK = 0x7FFFFFFF;
@@ -26,6 +27,49 @@ const DWORD	HITLESS_DOC_FLAG = 0x80000000;
 
 #define UnzipWordidBE UnzipOffsetBE
 
+// doclist_format=block
+// a full block starts with the bit width of its rowid deltas, then come the deltas bit-packed
+// (4 interleaved dword lanes, so that SSE2 unpacks 4 deltas at a time), then the rest of its entries
+// the last, incomplete block starts with DOCLIST_TAIL_BLOCK, and its entries are plain ones
+const BYTE	DOCLIST_TAIL_BLOCK = 0xFF;
+
+/// bits needed for the largest of DOCLIST_BLOCK_DOCS deltas
+int		DoclistBlockBits ( const DWORD * pDeltas );
+
+/// bit-pack DOCLIST_BLOCK_DOCS deltas; writes iBits*16 bytes
+void	DoclistBlockPack ( const DWORD * pDeltas, int iBits, BYTE * pOut );
+
+/// unpack DOCLIST_BLOCK_DOCS deltas; reads iBits*16 bytes
+void	DoclistBlockUnpack ( const BYTE * pIn, int iBits, DWORD * pDeltas );
+
+class CSphWriter;
+
+/// writes doclist entries in the table's doclist format
+/// with doclist_format=block, entries are buffered until the block is full
+class DoclistWriter_c
+{
+public:
+			DoclistWriter_c ( CSphWriter & tWriter, DoclistFormat_e eFormat );
+
+	void	BeginEntry ( RowID_t uRowidDelta );
+	void	ZipInt ( DWORD uValue );
+	void	ZipOffset ( uint64_t uValue );
+	void	EndEntry();
+	void	EndList();		///< writes the rest of the doclist and the end-of-doclist marker
+
+private:
+	CSphWriter &		m_tWriter;
+	bool				m_bBlock = false;
+	DWORD				m_dDeltas[DOCLIST_BLOCK_DOCS];
+	int					m_dEntryEnds[DOCLIST_BLOCK_DOCS];	///< where each buffered entry ends in m_dEntries
+	int					m_iEntries = 0;
+	CSphVector<BYTE>	m_dEntries;
+	MemoryWriter2_c		m_tEntries { m_dEntries };
+
+	void	FlushBlock();
+};
+
+
 class DiskIndexQwordSetup_c;
 
 /// query word from the searcher's point of view
@@ -41,6 +85,7 @@ public:
 
 	FileBlockReaderPtr_c	m_rdDoclist;	///< my doclist accessor
 	FileBlockReaderPtr_c	m_rdHitlist;	///< my hitlist accessor
+	bool			m_bBlockDoclist = false;	///< doclist_format=block
 
 
 					DiskIndexQwordTraits_c ( bool bUseMini, bool bExcluded );
@@ -48,6 +93,7 @@ public:
 	void			SetDocReader ( DataReaderFactory_c * pReader );
 	void			SetHitReader ( DataReaderFactory_c * pReader );
 	void			ResetDecoderState();
+	void			ResetDoclistBlock()		{ m_iRowDelta = m_iRowDeltas = 0; m_bDoclistTail = false; }	///< call on every doclist seek
 	virtual bool	Setup ( const DiskIndexQwordSetup_c * pSetup ) = 0;
 
 protected:
@@ -55,6 +101,20 @@ protected:
 	DWORD			m_uHitState = 0;
 	Hitpos_t		m_iHitPos {EMPTY_HIT};	///< current hit postition, from hitlist
 
+	// hitlist deltas are decoded a block at a time, which is much cheaper than a virtual call per hit
+	static const int HIT_BLOCK_LEN = 128;
+	DWORD			m_dHitDeltas[HIT_BLOCK_LEN];
+	int				m_iHitDelta = 0;		///< next delta to return
+	int				m_iHitDeltas = 0;		///< decoded deltas in the block
+
+	// doclist_format=block decoder state; it is reset on every doclist seek
+	DWORD			m_dRowDeltas[DOCLIST_BLOCK_DOCS];
+	int				m_iRowDelta = 0;		///< next delta to return
+	int				m_iRowDeltas = 0;		///< unpacked deltas in the block
+	bool			m_bDoclistTail = false;	///< reading the plain entries of the last block
+
+	inline RowID_t	UnzipBlockRowid();
+
 	static const int MINIBUFFER_LEN = 1024;
 	BYTE			m_dHitlistBuf[MINIBUFFER_LEN];
 	BYTE			m_dDoclistBuf[MINIBUFFER_LEN];
@@ -69,6 +129,42 @@ protected:
 };
 
 
+RowID_t DiskIndexQwordTraits_c::UnzipBlockRowid()
+{
+	if ( m_iRowDelta<m_iRowDeltas )
+		return m_dRowDeltas[m_iRowDelta++];
+
+	if ( !m_bDoclistTail )
+	{
+		BYTE uBits = m_rdDoclist->GetByte();
+		if ( uBits<=32 )
+		{
+			BYTE dPacked[DOCLIST_BLOCK_DOCS*sizeof(DWORD)];
+			m_rdDoclist->GetBytes ( dPacked, uBits*16 );
+			DoclistBlockUnpack ( dPacked, uBits, m_dRowDeltas );
+			m_iRowDeltas = DOCLIST_BLOCK_DOCS;
+			m_iRowDelta = 1;
+			return m_dRowDeltas[0];
+		}
+
+		// broken block header reads as the end of doclist
+		if ( uBits!=DOCLIST_TAIL_BLOCK )
+			return 0;
+
+		m_bDoclistTail = true;
+		m_iRowDelta = m_iRowDeltas = 0;
+	}
+
+	RowID_t uDelta = m_rdDoclist->UnzipRowid();
+
+	// merges read the next doclist right after this one, and it starts with a block again
+	if ( !uDelta )
+		m_bDoclistTail = false;
+
+	return uDelta;
+}
+
+
 struct CSphWordlistCheckpoint
 {
 	union
@@ -105,6 +105,9 @@ CSphString CompressionToStr ( Compression_e eComp )
 	case Compression_e::LZ4HC:
 		return "lz4hc";
 
+	case Compression_e::ZSTD:
+		return "zstd";
+
 	case Compression_e::NONE:
 	default:
 		return "none";
@@ -924,14 +927,23 @@ bool CSphIndexSettings::ParseDocstoreSettings ( const CSphConfigSection & hIndex
 		m_eCompression = Compression_e::LZ4;
 	else if ( sCompression=="lz4hc" )
 		m_eCompression = Compression_e::LZ4HC;
+	else if ( sCompression=="zstd" )
+	{
+#if WITH_ZSTD
+		m_eCompression = Compression_e::ZSTD;
+#else
+		sError = "zstd compression specified in 'docstore_compression', but it is not supported by this build";
+		return false;
+#endif
+	}
 	else
 	{
 		sError.SetSprintf ( "unknown compression specified in 'docstore_compression': '%s'\n", sCompression.cstr() );
 		return false;
 	}
 
-	if ( hIndex.Exists("docstore_compression_level") && m_eCompression!=Compression_e::LZ4HC )
-		sWarning.SetSprintf ( "docstore_compression_level works only with LZ4HC compression" );
+	if ( hIndex.Exists("docstore_compression_level") && m_eCompression!=Compression_e::LZ4HC && m_eCompression!=Compression_e::ZSTD )
+		sWarning.SetSprintf ( "docstore_compression_level works only with LZ4HC and ZSTD compression" );
 
 	return true;
 }
@@ -1117,6 +1129,23 @@ bool CSphIndexSettings::Setup ( const CSphConfigSection & hIndex, const char * s
 			sWarning.SetSprintf ( "unknown hit_format=%s, defaulting to inline", hIndex["hit_format"].cstr() );
 	}
 
+	// doclist format; packed blocks are also the skiplist blocks, so that skips land on block starts
+	m_eDoclistFormat = DoclistFormat_e::PLAIN;
+	if ( hIndex("doclist_format") )
+	{
+		CSphString s = hIndex["doclist_format"].strval();
+		s.ToLower();
+		if ( s=="block" )
+		{
+			m_eDoclistFormat = DoclistFormat_e::BLOCK;
+			m_iSkiplistBlockSize = DOCLIST_BLOCK_DOCS;
+		} else if ( s!="plain" )
+		{
+			sError.SetSprintf ( "unknown doclist_format=%s (must be plain or block)", s.cstr() );
+			return false;
+		}
+	}
+
 	// hit-less indices
 	if ( hIndex("hitless_words") )
 	{
@@ -1242,6 +1271,7 @@ void CSphIndexSettings::Format ( SettingsFormatter_c & tOut, FilenameBuilder_i *
 	tOut.Add ( "index_token_filter",	m_sIndexTokenFilter,	!m_sIndexTokenFilter.IsEmpty() );
 	tOut.Add ( "attr_update_reserve",	m_tBlobUpdateSpace,		m_tBlobUpdateSpace!=DEFAULT_ATTR_UPDATE_RESERVE );
 	tOut.Add ( "binlog",				0,						!m_bBinlog );
+	tOut.Add ( "doclist_format",		"block",				m_eDoclistFormat==DoclistFormat_e::BLOCK );
 
 	if ( m_eHitless==SPH_HITLESS_ALL )
 	{
@@ -3175,6 +3205,7 @@ void LoadIndexSettingsJson ( bson::Bson_c tNode, CSphIndexSettings & tSettings )
 	tSettings.m_sIndexTokenFilter = String ( tNode.ChildByName ( "index_token_filter" ) );
 	tSettings.m_tBlobUpdateSpace = Int ( tNode.ChildByName ( "blob_update_space" ) );
 	tSettings.m_iSkiplistBlockSize = (int)Int ( tNode.ChildByName ( "skiplist_block_size" ), 32 );
+	tSettings.m_eDoclistFormat = (DoclistFormat_e)Int ( tNode.ChildByName ( "doclist_format" ), (DWORD)DoclistFormat_e::PLAIN );
 	tSettings.m_sHitlessFiles = String ( tNode.ChildByName ( "hitless_files" ) );
 	tSettings.m_eEngine = (AttrEngine_e)Int ( tNode.ChildByName ( "engine" ), (DWORD)AttrEngine_e::DEFAULT );
 	tSettings.m_eDefaultEngine = (AttrEngine_e)Int ( tNode.ChildByName ( "engine_default" ), (DWORD)AttrEngine_e::ROWWISE );
@@ -3239,6 +3270,9 @@ void LoadIndexSettings ( CSphIndexSettings & tSettings, CSphReader & tReader, DW
 		tSettings.m_eJiebaMode = (JiebaMode_e)tReader.GetDword();
 		tSettings.m_bJiebaHMM = !!tReader.GetByte();
 	}
+
+	if ( uVersion>=71 )
+		tSettings.m_eDoclistFormat = (DoclistFormat_e)tReader.GetByte();
 }
 
 
@@ -3272,6 +3306,7 @@ void SaveIndexSettings ( Writer_i & tWriter, const CSphIndexSettings & tSettings
 	tWriter.PutDword ( (DWORD)tSettings.m_eEngine );
 	tWriter.PutDword ( (DWORD)tSettings.m_eJiebaMode );
 	tWriter.PutByte ( tSettings.m_bJiebaHMM ? 1 : 0 );
+	tWriter.PutByte ( (BYTE)tSettings.m_eDoclistFormat );
 	tWriter.PutString ( tSettings.m_sJiebaUserDictPath );
 }
 
@@ -3302,6 +3337,7 @@ void operator << ( JsonEscapedBuilder & tOut, const CSphIndexSettings & tSetting
 	tOut.NamedStringNonEmpty ( "index_token_filter", tSettings.m_sIndexTokenFilter );
 	tOut.NamedValNonDefault ( "blob_update_space", tSettings.m_tBlobUpdateSpace );
 	tOut.NamedValNonDefault ( "skiplist_block_size", tSettings.m_iSkiplistBlockSize, 32 );
+	tOut.NamedValNonDefault ( "doclist_format", (DWORD)tSettings.m_eDoclistFormat, (DWORD)DoclistFormat_e::PLAIN );
 	tOut.NamedStringNonEmpty ( "hitless_files", tSettings.m_sHitlessFiles );
 	tOut.NamedValNonDefault ( "engine", (DWORD)tSettings.m_eEngine, (DWORD)AttrEngine_e::DEFAULT );
 	tOut.NamedValNonDefault ( "engine_default", (DWORD)tSettings.m_eDefaultEngine, (DWORD)AttrEngine_e::ROWWISE );
@@ -202,7 +202,8 @@ enum class Compression_e
 {
 	NONE,
 	LZ4,
-	LZ4HC
+	LZ4HC,
+	ZSTD
 };
 
 
@@ -237,6 +238,15 @@ enum ESphHitFormat
 };
 
 
+enum class DoclistFormat_e : BYTE
+{
+	PLAIN = 0,	///< every doclist entry starts with a varint rowid delta
+	BLOCK = 1	///< rowid deltas of every full block of entries are bit-packed in front of the block
+};
+
+const int DOCLIST_BLOCK_DOCS = 128;	///< entries per block with doclist_format=block (also the skiplist block size)
+
+
 enum ESphBigram : BYTE
 {
 	SPH_BIGRAM_NONE			= 0,	///< no bigrams
@@ -284,6 +294,7 @@ public:
 	int				m_iEmbeddedLimit = 0;
 	SphOffset_t		m_tBlobUpdateSpace {0};
 	int				m_iSkiplistBlockSize {32};
+	DoclistFormat_e	m_eDoclistFormat = DoclistFormat_e::PLAIN;
 
 	KillListTargets_c m_tKlistTargets;	///< list of indexes to apply killlist to
 
@@ -18,9 +18,11 @@
 #include "sphinxjson.h"
 #include "querycontext.h"
 #include "docstore.h"
+#include "coroutine.h"
 
 static int64_t g_iJoinCacheSize = 20971520;
 static int g_iJoinBatchSize = 1000;
+static int64_t g_iJoinHashThreshold = 100000;
 
 void SetJoinCacheSize ( int64_t iSize )
 {
@@ -46,6 +48,18 @@ int	GetJoinBatchSize()
 }
 
 
+void SetJoinHashThreshold ( int64_t iThreshold )
+{
+	g_iJoinHashThreshold = iThreshold;
+}
+
+
+int64_t GetJoinHashThreshold()
+{
+	return g_iJoinHashThreshold;
+}
+
+
 bool ExprHasLeftTableAttrs ( const CSphString & sAttr, const ISphSchema & tLeftSchema )
 {
 	const char * szAttr = sAttr.cstr();
@@ -615,6 +629,32 @@ public:
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// right side of a hash join. It is built once, by whichever clone of the sorter gets the first match,
+// and then shared read-only by all the clones. The right query may yield while building, so the lock is a coro one:
+// clones waiting for it yield too, instead of blocking worker threads the builder needs to resume on
+struct HashJoinTable_t
+{
+	Threads::Coro::Mutex_c			m_tLock;
+	bool							m_bBuilt = false;
+	CSphString						m_sError;
+	std::unique_ptr<ISphSchema>		m_pSchema;		// schema of the right sorter the matches came from
+	CSphSwapVector<CSphMatch>		m_dMatches;
+	OpenHashTable_T<uint64_t, IntVec_t> m_hMatches;
+
+	~HashJoinTable_t()
+	{
+		if ( !m_pSchema )
+			return;
+
+		for ( auto & i : m_dMatches )
+		{
+			m_pSchema->FreeDataPtrs(i);
+			i.ResetDynamic();
+		}
+	}
+};
+
+
 class JoinSorter_c : public HybridTransformJoinRefresh_i
 {
 public:
@@ -653,6 +693,7 @@ public:
 	bool		IsPrecalc() const override											{ return false; }
 	bool		IsJoin() const override												{ return true; }
 	bool		FinalizeJoin ( CSphString & sError, CSphString & sWarning ) override;
+	void		AddDesc ( CSphVector<IteratorDesc_t> & dDesc ) const override;
 
 	bool		GetErrorFlag() const												{ return m_bErrorFlag; }
 	const CSphString & GetErrorMessage() const										{ return m_sErrorMessage; }
@@ -748,6 +789,11 @@ private:
 	IntVec_t						m_dIntFilters;
 	IntVec_t						m_dStrFilters;
 
+	// hash join: the whole (filtered) right side is fetched once and matched in memory
+	bool							m_bHashJoin = false;
+	bool							m_bHashJoinReady = false;
+	std::shared_ptr<HashJoinTable_t> m_pHashJoin;
+
 	struct BatchedMatches_t
 	{
 		CSphMatch				m_tMatch;
@@ -759,7 +805,7 @@ private:
 	CSphFixedVector<BatchedMatches_t> m_dBatchedMatches;
 
 	bool		SetupJoinQuery ( int iDynamicSize, CSphString & sError );
-	bool		SetupJoinSorter ( CSphString & sError );
+	bool		SetupJoinSorter ( const CSphQuery & tJoinQuery, CSphString & sError );
 	void		SetupJoinAttrRemap();
 	void		SetupDependentAttrCalc ( const IntVec_t & dJoinedAttrs );
 	void		SetupSorterSchema();
@@ -771,6 +817,8 @@ private:
 	bool		SetupOnFilters ( CSphString & sError );
 	bool		SetupOnValueFilters ( CSphString & sError );
 	void		SetupRightStandaloneLocators();
+	bool		ChooseHashJoin() const;
+	int64_t		EstimateRightRows() const;
 	void		AddToAttrRemap ( const CSphString & sFrom, const CSphString & sTo );
 	void		AddToJoinSelectList ( const CSphString & sExpr );
 	void		AddToJoinSelectList ( const CSphString & sExpr, const CSphString & sAlias );
@@ -790,7 +838,7 @@ private:
 	void		AddBatchedFilterItemsToJoinSelectList();
 
 	void		SetupJoinSelectList();
-	void		IncreaseJoinedMaxMatches ( int iTotalCount );
+	void		IncreaseJoinedMaxMatches ( CSphQuery & tJoinQuery, int iTotalCount );
 
 	void		RepackJsonFieldAsStr ( const CSphMatch & tSrcMatch, const CSphAttrLocator & tLocSrc, const CSphAttrLocator & tLocDst );
 	void		ProduceCacheSizeWarning ( CSphString & sWarning );
@@ -808,8 +856,12 @@ private:
 
 	template <typename MATCHES> void CleanupRightMatches ( MATCHES & dMatches );
 	template <typename PUSH> void PushBatch ( PUSH && fnPush );
-	bool		RunJoinedQuery ( int & iTotalCount );
-	bool		RunJoinedQueryAndAdjustMaxMatches();
+	bool		RunJoinedQuery ( const CSphQuery & tJoinQuery, int & iTotalCount );
+	bool		RunJoinedQueryAndAdjustMaxMatches ( CSphQuery & tJoinQuery );
+	bool		AcquireHashJoin();
+	void		BuildHashJoin ( HashJoinTable_t & tTable );
+	template <typename PUSH> FORCE_INLINE bool PushHashJoined ( const CSphMatch & tEntry, uint64_t uJoinOnFilterHash, PUSH && fnPush );
+	FORCE_INLINE void CopyMatchHeader ( const CSphMatch & tEntry );
 
 	template <typename PUSH, typename MATCHES>
 	FORCE_INLINE bool AddToCacheAndPush ( const CSphMatch & tEntry, uint64_t uJoinOnFilterHash, PUSH && fnPush, MATCHES & dMatches, const BYTE * pBlobPool, columnar::Columnar_i *	pColumnar, bool bAddToCache );
@@ -847,7 +899,10 @@ JoinSorter_c::JoinSorter_c ( const CSphIndex * pIndex, const CSphIndex * pJoined
 	m_bFinalCalcOnly = !pIndex->IsRT() && !bJoinedGroupSort && !bHaveAggregates && !dRightFilters.GetLength() && !NeedPostJoinFilterEvaluation ( m_tQuery, tSorterSchema ) && !pSorter->IsPrecalc() && !bDisableByImplicitGrouping;
 	m_bErrorFlag = !SetupJoinQuery ( m_pSorter->GetSchema()->GetDynamicSize(), m_sErrorMessage );
 	if ( m_bFinalCalcOnly || !m_iBatchSize )
+	{
 		m_bCanBatch = false;
+		m_bHashJoin = false;
+	}
 }
 
 
@@ -978,6 +1033,8 @@ bool JoinSorter_c::SetupJoinQuery ( int iDynamicSize, CSphString & sError )
 	m_tMixedFilter = FilterEval_c();
 	m_bNeedToSetupRemap = true;
 	m_bSorterSchemaHasDataPtrs = false;
+	m_bHashJoinReady = false;
+	m_pHashJoin.reset();
 
 	m_pJoinQueryParser = std::unique_ptr<QueryParser_i>( m_tQuery.m_pQueryParser->Clone() );
 
@@ -997,8 +1054,12 @@ bool JoinSorter_c::SetupJoinQuery ( int iDynamicSize, CSphString & sError )
 	if ( !SetupOnFilters(sError) )		return false;
 	if ( !SetupOnValueFilters(sError) )	return false;
 
+	m_bHashJoin = ChooseHashJoin();
+	if ( m_bHashJoin )
+		m_pHashJoin = std::make_shared<HashJoinTable_t>();
+
 	AddBatchedFilterItemsToJoinSelectList();
-	if ( !SetupJoinSorter(sError) )		return false;
+	if ( !SetupJoinSorter ( m_tJoinQuery, sError ) )	return false;
 
 	SetupNullMask();
 	SetupAggregates();
@@ -1018,14 +1079,14 @@ bool JoinSorter_c::RefreshAfterHybridTransform ( CSphString & sError )
 }
 
 
-bool JoinSorter_c::SetupJoinSorter ( CSphString & sError )
+bool JoinSorter_c::SetupJoinSorter ( const CSphQuery & tJoinQuery, CSphString & sError )
 {
 	SphQueueSettings_t tQueueSettings ( m_pJoinedIndex->GetMatchSchema() );
 	tQueueSettings.m_bComputeItems = true;
-	tQueueSettings.m_iMaxMatches = m_tJoinQuery.m_iMaxMatches;
+	tQueueSettings.m_iMaxMatches = tJoinQuery.m_iMaxMatches;
 
 	SphQueueRes_t tRes;
-	m_pRightSorter = std::unique_ptr<ISphMatchSorter> ( sphCreateQueue ( tQueueSettings, m_tJoinQuery, sError, tRes ) );
+	m_pRightSorter = std::unique_ptr<ISphMatchSorter> ( sphCreateQueue ( tQueueSettings, tJoinQuery, sError, tRes ) );
 	if ( !m_pRightSorter )
 		return false;
 
@@ -1335,7 +1396,7 @@ static int GetIndexWeight ( const CSphQuery & tQuery, const CSphString & sIdxNam
 }
 
 
-bool JoinSorter_c::RunJoinedQuery ( int & iTotalCount )
+bool JoinSorter_c::RunJoinedQuery ( const CSphQuery & tJoinQuery, int & iTotalCount )
 {
 	CSphQueryResultMeta tMeta;
 	CSphQueryResult tQueryResult;
@@ -1345,11 +1406,11 @@ bool JoinSorter_c::RunJoinedQuery ( int & iTotalCount )
 	// FIXME!!!! make a SetSchema that does not take ownership of the schema
 	m_pRightSorter->SetSchema ( m_pRightSorterRsetSchema->CloneMe(), true );
 
-	CSphMultiQueryArgs tArgs ( GetIndexWeight ( m_tJoinQuery, m_tQuery.m_sJoinIdx ) );
+	CSphMultiQueryArgs tArgs ( GetIndexWeight ( tJoinQuery, m_tQuery.m_sJoinIdx ) );
 	tArgs.m_bUseSICache = true;
 
 	ISphMatchSorter * pSorter = m_pRightSorter.get();
-	if ( !m_pJoinedIndex->MultiQuery ( tQueryResult, m_tJoinQuery, { &pSorter, 1 }, tArgs ) )
+	if ( !m_pJoinedIndex->MultiQuery ( tQueryResult, tJoinQuery, { &pSorter, 1 }, tArgs ) )
 	{
 		m_bErrorFlag = true;
 		m_sErrorMessage.SetSprintf ( "joined table %s: %s", GetJoinedIndexName().cstr(), tMeta.m_sError.cstr() );
@@ -1389,21 +1450,21 @@ void JoinSorter_c::CleanupRightMatches ( MATCHES & dMatches )
 }
 
 
-bool JoinSorter_c::RunJoinedQueryAndAdjustMaxMatches()
+bool JoinSorter_c::RunJoinedQueryAndAdjustMaxMatches ( CSphQuery & tJoinQuery )
 {
 	while ( true )
 	{
 		int iTotalCount = 0;
-		if ( !RunJoinedQuery(iTotalCount) )
+		if ( !RunJoinedQuery ( tJoinQuery, iTotalCount ) )
 			return false;
 
-		bool bNeedToIncrease = m_dMatches.GetLength()==m_tJoinQuery.m_iMaxMatches && iTotalCount>m_tJoinQuery.m_iMaxMatches;
+		bool bNeedToIncrease = m_dMatches.GetLength()==tJoinQuery.m_iMaxMatches && iTotalCount>tJoinQuery.m_iMaxMatches;
 		if ( !bNeedToIncrease )
 			break;
 
 		CleanupRightMatches(m_dMatches);
-		IncreaseJoinedMaxMatches(iTotalCount);
-		if ( !SetupJoinSorter(m_sErrorMessage) )
+		IncreaseJoinedMaxMatches ( tJoinQuery, iTotalCount );
+		if ( !SetupJoinSorter ( tJoinQuery, m_sErrorMessage ) )
 		{
 			m_bErrorFlag = true;
 			return false;
@@ -1413,18 +1474,8 @@ bool JoinSorter_c::RunJoinedQueryAndAdjustMaxMatches()
 	return true;
 }
 
-template <typename PUSH, typename MATCHES>
-bool JoinSorter_c::AddToCacheAndPush ( const CSphMatch & tEntry, uint64_t uJoinOnFilterHash, PUSH && fnPush, MATCHES & dMatches, const BYTE * pBlobPool, columnar::Columnar_i *	pColumnar, bool bAddToCache )
+void JoinSorter_c::CopyMatchHeader ( const CSphMatch & tEntry )
 {
-	ISphMatchSorter * pSorter = m_pRightSorter.get();
-
-	bool bInCache = !bAddToCache;
-	if ( bAddToCache )
-	{
-		m_tCache.SetSchema ( pSorter->GetSchema() );
-		bInCache = m_tCache.Add ( uJoinOnFilterHash, dMatches );
-	}
-
 	if constexpr ( !offsetof ( CSphMatch, m_pDynamic ) )
 	{
 		auto * pShiftedm_tMatch = reinterpret_cast<BYTE *> (&m_tMatch) + sizeof (CSphMatch::m_pDynamic);
@@ -1436,6 +1487,21 @@ bool JoinSorter_c::AddToCacheAndPush ( const CSphMatch & tEntry, uint64_t uJoinO
 		memcpy ( &m_tMatch, &tEntry, sizeof ( CSphMatch ) ); // warn about UB since CSphMatch is not trivially copyable
 		m_tMatch.m_pDynamic = pDynamic;
 	}
+}
+
+template <typename PUSH, typename MATCHES>
+bool JoinSorter_c::AddToCacheAndPush ( const CSphMatch & tEntry, uint64_t uJoinOnFilterHash, PUSH && fnPush, MATCHES & dMatches, const BYTE * pBlobPool, columnar::Columnar_i *	pColumnar, bool bAddToCache )
+{
+	ISphMatchSorter * pSorter = m_pRightSorter.get();
+
+	bool bInCache = !bAddToCache;
+	if ( bAddToCache )
+	{
+		m_tCache.SetSchema ( pSorter->GetSchema() );
+		bInCache = m_tCache.Add ( uJoinOnFilterHash, dMatches );
+	}
+
+	CopyMatchHeader(tEntry);
 
 	bool bAnythingPushed = PushJoinedMatches ( tEntry, dMatches, fnPush, pBlobPool, pColumnar );
 
@@ -1571,7 +1637,7 @@ bool JoinSorter_c::RunBatch ( PUSH && fnPush )
 		return true;
 
 	SetupJoinFiltersBatch();
-	if ( !RunJoinedQueryAndAdjustMaxMatches() )
+	if ( !RunJoinedQueryAndAdjustMaxMatches(m_tJoinQuery) )
 		return false;
 
 	PushBatch(fnPush);
@@ -1580,6 +1646,125 @@ bool JoinSorter_c::RunBatch ( PUSH && fnPush )
 	return true;
 }
 
+
+int64_t JoinSorter_c::EstimateRightRows() const
+{
+	int64_t iRows = m_pJoinedIndex->GetCount();
+	if ( iRows<0 )
+		return -1;
+
+	// filters are ANDed, so each of them gives an upper bound on the build side size
+	CSphString sModifiedAttr;
+	ARRAY_FOREACH ( i, m_tJoinQuery.m_dFilters )
+	{
+		if ( m_dFilterRemap.any_of ( [i]( const FilterRemap_t & tRemap ){ return tRemap.m_iFilterId==i; } ) )
+			continue;
+
+		int64_t iCount = m_pJoinedIndex->GetCountFilter ( m_tJoinQuery.m_dFilters[i], sModifiedAttr );
+		if ( iCount>=0 )
+			iRows = Min ( iRows, iCount );
+	}
+
+	return iRows;
+}
+
+
+bool JoinSorter_c::ChooseHashJoin() const
+{
+	if ( !m_bCanBatch || !g_iJoinHashThreshold || m_dFilterRemap.IsEmpty() )
+		return false;
+
+	// JOIN ON filters are ANDed to the filter tree, we can't strip them from it
+	if ( !m_tJoinQuery.m_dFilterTree.IsEmpty() )
+		return false;
+
+	int64_t iRightRows = EstimateRightRows();
+	if ( iRightRows<0 || iRightRows>g_iJoinHashThreshold )
+		return false;
+
+	// batched lookups never fetch more than the left side produces
+	int64_t iLeftRows = m_pIndex->GetCount();
+	return iLeftRows<0 || iRightRows<=iLeftRows;
+}
+
+
+void JoinSorter_c::BuildHashJoin ( HashJoinTable_t & tTable )
+{
+	// run the right query once without JOIN ON filters; the join query itself stays as is for the other paths
+	CSphQuery tHashQuery = m_tJoinQuery;
+	tHashQuery.m_dFilters.Resize(0);
+	ARRAY_FOREACH ( i, m_tJoinQuery.m_dFilters )
+		if ( !m_dFilterRemap.any_of ( [i]( const FilterRemap_t & tRemap ){ return tRemap.m_iFilterId==i; } ) )
+			tHashQuery.m_dFilters.Add ( m_tJoinQuery.m_dFilters[i] );
+
+	tHashQuery.m_iMaxMatches = Max ( tHashQuery.m_iMaxMatches, (int)Min ( EstimateRightRows(), INT_MAX ) );
+	tHashQuery.m_iLimit = tHashQuery.m_iMaxMatches;
+
+	tTable.m_bBuilt = true;
+	if ( !SetupJoinSorter ( tHashQuery, m_sErrorMessage ) || !RunJoinedQueryAndAdjustMaxMatches(tHashQuery) )
+	{
+		tTable.m_sError = m_sErrorMessage;
+		return;
+	}
+
+	tTable.m_pSchema = std::unique_ptr<ISphSchema> ( m_pRightSorter->GetSchema()->CloneMe() );
+	tTable.m_dMatches.SwapData(m_dMatches);
+	tTable.m_hMatches.Reset ( Max ( tTable.m_dMatches.GetLength(), 256 ) );
+	ARRAY_FOREACH ( i, tTable.m_dMatches )
+		tTable.m_hMatches.Acquire ( CalcRightFilterHash ( tTable.m_dMatches[i] ) ).Add(i);
+}
+
+
+bool JoinSorter_c::AcquireHashJoin()
+{
+	assert ( m_pHashJoin );
+	HashJoinTable_t & tTable = *m_pHashJoin;
+	{
+		Threads::Coro::ScopedMutex_t tLock { tTable.m_tLock };
+		if ( !tTable.m_bBuilt )
+			BuildHashJoin(tTable);
+	}
+
+	if ( !tTable.m_sError.IsEmpty() )
+	{
+		m_bErrorFlag = true;
+		m_sErrorMessage = tTable.m_sError;
+		return false;
+	}
+
+	// clones that didn't run the right query take the standalone schema from the one that did
+	if ( m_bNeedToSetupRemap )
+	{
+		m_pRightSorter->SetSchema ( tTable.m_pSchema->CloneMe(), true );
+		SetupJoinAttrRemap();
+	}
+
+	m_bHashJoinReady = true;
+	return true;
+}
+
+template <typename PUSH>
+bool JoinSorter_c::PushHashJoined ( const CSphMatch & tEntry, uint64_t uJoinOnFilterHash, PUSH && fnPush )
+{
+	m_dMatchPtrs.Resize(0);
+	HashJoinTable_t & tTable = *m_pHashJoin;
+	IntVec_t * pRightMatchIds = tTable.m_hMatches.Find(uJoinOnFilterHash);
+	if ( pRightMatchIds )
+		for ( auto iRightMatchId : *pRightMatchIds )
+			m_dMatchPtrs.Add ( &tTable.m_dMatches[iRightMatchId] );
+
+	CopyMatchHeader(tEntry);
+
+	// right matches are shared between all left matches, so we don't hand them over to the cache
+	MatchPtrVec_c dMatchesToPush(m_dMatchPtrs);
+	bool bAnythingPushed = PushJoinedMatches ( tEntry, dMatchesToPush, fnPush, m_pBlobPool, m_pColumnar );
+
+	if ( !dMatchesToPush.GetLength() && m_tQuery.m_eJoinType==JoinType_e::LEFT )
+		bAnythingPushed = PushLeftMatch ( tEntry, fnPush, m_pBlobPool, m_pColumnar );
+
+	return bAnythingPushed;
+}
+
 template <typename PUSH>
 bool JoinSorter_c::Push_T ( const CSphMatch & tEntry, PUSH && fnPush, bool bGrouped )
 {
@@ -1590,6 +1775,14 @@ bool JoinSorter_c::Push_T ( const CSphMatch & tEntry, PUSH && fnPush, bool bGrou
 		return false;
 
 	uint64_t uJoinOnFilterHash = SetupJoinFilters(tEntry);
+	if ( m_bHashJoin )
+	{
+		if ( !m_bHashJoinReady && !AcquireHashJoin() )
+			return false;
+
+		return PushHashJoined ( tEntry, uJoinOnFilterHash, fnPush );
+	}
+
 	if ( m_tCache.Fetch ( uJoinOnFilterHash, m_dMatches ) )
 		return AddToCacheAndPush ( tEntry, uJoinOnFilterHash, fnPush, m_dMatches, m_pBlobPool, m_pColumnar, false );
 
@@ -1602,7 +1795,7 @@ bool JoinSorter_c::Push_T ( const CSphMatch & tEntry, PUSH && fnPush, bool bGrou
 		return false; // always return false so that cutoff/implicit cutoff won't work
 	}
 
-	if ( !RunJoinedQueryAndAdjustMaxMatches() )
+	if ( !RunJoinedQueryAndAdjustMaxMatches(m_tJoinQuery) )
 		return false;
 
 	return AddToCacheAndPush ( tEntry, uJoinOnFilterHash, fnPush, m_dMatches, m_pBlobPool, m_pColumnar, true );
@@ -1623,6 +1816,12 @@ int64_t	JoinSorter_c::GetTotalCount() const
 }
 
 
+void JoinSorter_c::AddDesc ( CSphVector<IteratorDesc_t> & dDesc ) const
+{
+	dDesc.Add ( { GetJoinedIndexName(), m_bHashJoin ? "HashJoin" : ( m_bCanBatch ? "BatchedJoin" : "LookupJoin" ) } );
+}
+
+
 void JoinSorter_c::ProduceCacheSizeWarning ( CSphString & sWarning )
 {
 	if ( m_tCache.IsFull() )
@@ -1641,7 +1840,13 @@ void JoinSorter_c::PopulateStoredFields()
 ISphMatchSorter * JoinSorter_c::Clone() const
 {
 	ISphMatchSorter * pSourceSorter = m_pOriginalSorter ? m_pOriginalSorter.get() : m_pSorter.get();
-	return new JoinSorter_c ( m_pIndex, m_pJoinedIndex, m_dQueries, m_dJoinQueryOptions, m_sRightIndexSchemaName, std::shared_ptr<ISphMatchSorter>( pSourceSorter->Clone() ), !m_bFinalCalcOnly, m_iBatchSize );
+	auto * pClone = new JoinSorter_c ( m_pIndex, m_pJoinedIndex, m_dQueries, m_dJoinQueryOptions, m_sRightIndexSchemaName, std::shared_ptr<ISphMatchSorter>( pSourceSorter->Clone() ), !m_bFinalCalcOnly, m_iBatchSize );
+
+	// clones join against the same right side, so they share its hash table too
+	if ( pClone->m_bHashJoin && m_bHashJoin )
+		pClone->m_pHashJoin = m_pHashJoin;
+
+	return pClone;
 }
 
 
@@ -2259,14 +2464,14 @@ void JoinSorter_c::SetupJoinSelectList()
 }
 
 
-void JoinSorter_c::IncreaseJoinedMaxMatches ( int iTotalCount )
+void JoinSorter_c::IncreaseJoinedMaxMatches ( CSphQuery & tJoinQuery, int iTotalCount )
 {
-	int64_t iNewLimit = sph::DefaultRelimit::Relimit ( m_tJoinQuery.m_iMaxMatches, iTotalCount );
+	int64_t iNewLimit = sph::DefaultRelimit::Relimit ( tJoinQuery.m_iMaxMatches, iTotalCount );
 	if ( iNewLimit > INT_MAX )
 		return;
 
-	m_tJoinQuery.m_iMaxMatches = (int)iNewLimit;
-	m_tJoinQuery.m_iLimit = m_tJoinQuery.m_iMaxMatches;
+	tJoinQuery.m_iMaxMatches = (int)iNewLimit;
+	tJoinQuery.m_iLimit = tJoinQuery.m_iMaxMatches;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2310,6 +2515,7 @@ public:
 	bool		IsPrecalc() const override											{ return m_dJoinSorters[0]->IsPrecalc(); }
 	bool		IsJoin() const override												{ return true; }
 	bool		FinalizeJoin ( CSphString & sError, CSphString & sWarning ) override;
+	void		AddDesc ( CSphVector<IteratorDesc_t> & dDesc ) const override;
 
 	bool		GetErrorFlag() const;
 	const CSphString & GetErrorMessage() const;
@@ -2504,6 +2710,13 @@ bool JoinSorterN_c::FinalizeJoin ( CSphString & sError, CSphString & sWarning )
 }
 
 
+void JoinSorterN_c::AddDesc ( CSphVector<IteratorDesc_t> & dDesc ) const
+{
+	for ( auto & i : m_dJoinSorters )
+		i->AddDesc(dDesc);
+}
+
+
 bool JoinSorterN_c::GetErrorFlag() const
 {
 	bool bErrorFlag = false;
@@ -16,6 +16,8 @@ void				SetJoinCacheSize ( int64_t iSize );
 int64_t				GetJoinCacheSize();
 void				SetJoinBatchSize ( int iSize );
 int					GetJoinBatchSize();
+void				SetJoinHashThreshold ( int64_t iThreshold );
+int64_t				GetJoinHashThreshold();
 
 CSphVector<std::pair<int,bool>> FetchJoinRightTableFilters ( const CSphVector<CSphFilterSettings> & dFilters, const ISphSchema & tSchema, const char * szJoinedIndex );
 bool				NeedPostJoinFilterEvaluation ( const CSphQuery & tQuery, const ISphSchema & tSchema );
@@ -32,6 +32,7 @@ using sph_sa_family_t = sa_family_t;
 #endif
 
 int g_iThrottleAccept = 0;
+static std::atomic<bool> g_bAcceptPaused { false };
 extern volatile bool g_bMaintenance;
 
 
@@ -208,9 +209,15 @@ void IterateTasks ( TaskIteratorFn&& fnHandler )
 }
 
 
+void PauseAccept ( bool bPause )
+{
+	g_bAcceptPaused.store ( bPause, std::memory_order_release );
+}
+
+
 void NetActionAccept_c::Impl_c::ProcessAccept ()
 {
-	if ( sphInterrupted () )
+	if ( sphInterrupted () || g_bAcceptPaused.load ( std::memory_order_acquire ) )
 		return;
 
 	// handle all incoming requests at once but not too much
@@ -229,6 +236,10 @@ void NetActionAccept_c::Impl_c::ProcessAccept ()
 			return;
 		}
 
+		// listeners are being handed over to another process
+		if ( g_bAcceptPaused.load ( std::memory_order_acquire ) )
+			return;
+
 		// accept
 		int iClientSock = accept ( m_tListener.m_iSock, (struct sockaddr *)&saStorage, &uLength );
 
@@ -23,6 +23,9 @@ struct ListenTaskInfo_t : public TaskInfo_t
 	DWORD	m_uTick = 0;
 };
 
+/// stop (or resume) taking clients from all the listeners; clients that connect meanwhile wait in the listen backlog
+void PauseAccept ( bool bPause );
+
 class NetActionAccept_c final : public ISphNetAction
 {
 	class Impl_c;
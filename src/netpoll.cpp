@@ -22,7 +22,7 @@
 
 class TimeoutEvents_c
 {
-	TimeoutQueue_c	m_dTimeouts;
+	TimeoutWheel_c	m_dTimeouts;
 
 public:
 	constexpr static int64_t TIME_INFINITE = -1;
@@ -228,7 +228,7 @@ struct PollTraits_t
 					   | ( ( uIOChange & NetPollEvent_t::SET_ONESHOT ) ? EPOLLONESHOT : 0 )
 					   | ( ( uIOChange & NetPollEvent_t::SET_READ ) ? EPOLLIN : 0 )
 					   | ( ( uIOChange & NetPollEvent_t::SET_WRITE ) ? EPOLLOUT : 0 );
-			sphLogDebugv ( "%p epoll %d setup, ev=0x%u, op=%s, sock=%d", pData, iPoll, tEv.events, epoll_action_name ( iOp ), iSock );
+			sphLogDebugv ( "%p epoll %d setup, ev=0x%x, op=%s, sock=%d", pData, iPoll, tEv.events, epoll_action_name ( iOp ), iSock );
 		} else
 			sphLogDebugv ( "%p epoll %d setup, op=%s, sock=%d", pData, iPoll, epoll_action_name ( iOp ), iSock );
 
@@ -11,6 +11,7 @@
 //
 
 #include "netreceive_api.h"
+#include "compressed_api.h"
 
 extern int g_iClientTimeoutS; // from searchd.cpp
 extern volatile bool g_bMaintenance;
@@ -72,6 +73,8 @@ void ApiServe ( std::unique_ptr<AsyncNetBuffer_c> pBuf )
 	}
 
 	int iPconnIdleS = 0;
+	auto eReplyCodec = Compression_e::NONE; // set when master offered compression
+	ApiCompressionStats_t tCompressStats;
 
 	// main loop for one or more commands (if persist)
 	do
@@ -132,7 +135,9 @@ void ApiServe ( std::unique_ptr<AsyncNetBuffer_c> pBuf )
 
 		iPconnIdleS = 0;
 
-		auto eCommand = (SearchdCommand_e)  tIn.GetWord ();
+		auto uCommand = tIn.GetWord ();
+		bool bCompressed = ( uCommand & API_COMPRESSED_FRAME )!=0;
+		auto eCommand = (SearchdCommand_e) ( uCommand & ~API_COMPRESSED_FRAME );
 		auto uVer = tIn.GetWord ();
 		auto iReplySize = tIn.GetInt ();
 		sphLogDebugv ( "read command %d, version %d, reply size %d", eCommand, uVer, iReplySize );
@@ -167,8 +172,29 @@ void ApiServe ( std::unique_ptr<AsyncNetBuffer_c> pBuf )
 			break;
 		}
 
+		// compressed request - go on with decompressed copy of the body
+		CSphFixedVector<BYTE> dRawRequest { 0 };
+		std::optional<MemInputBuffer_c> tRawIn;
+		if ( bCompressed )
+		{
+			const BYTE * pFrame = nullptr;
+			Compression_e eCodec;
+			CSphString sError;
+			int iMaxRaw = bCheckLen ? tIn.GetMaxPacketSize() : INT_MAX;
+			if ( !tIn.GetBytesZerocopy ( &pFrame, iReplySize ) || !ApiDecompressFrame ( { pFrame, iReplySize }, iMaxRaw, dRawRequest, eCodec, sError, tCompressStats ) )
+			{
+				sphWarning ( "ill-formed compressed client request (client=%s(%d)): %s", sClientIP, iCID, sError.scstr() );
+				SendErrorReply ( tOut, "invalid compressed request: %s", sError.scstr() );
+				tOut.Flush(); // no need to check return code since we anyway break
+				break;
+			}
+			tRawIn.emplace ( dRawRequest );
+			iReplySize = (int)dRawRequest.GetLength();
+		}
+		InputBuffer_c & tCmdIn = bCompressed ? *tRawIn : tIn;
+
 		auto& tCrashQuery = GlobalCrashQueryGetRef();
-		tCrashQuery.m_dQuery = { tIn.GetBufferPtr (), iReplySize };
+		tCrashQuery.m_dQuery = { tCmdIn.GetBufferPtr (), iReplySize };
 		tCrashQuery.m_eType = QUERY_API;
 		tCrashQuery.m_uCMD = eCommand;
 		tCrashQuery.m_uVer = uVer;
@@ -176,7 +202,10 @@ void ApiServe ( std::unique_ptr<AsyncNetBuffer_c> pBuf )
 		// special process for 'ping' as immediate answer (before 'maxed out' check)
 		if ( eCommand == SEARCHD_COMMAND_PING )
 		{
-			HandleCommandPing ( tOut, uVer, tIn );
+			auto iReplyStart = tOut.GetSentCount();
+			HandleCommandPing ( tOut, uVer, tCmdIn );
+			if ( eReplyCodec!=Compression_e::NONE )
+				ApiCompressPacket ( tOut, iReplyStart, true, eReplyCodec, true, tCompressStats );
 			tOut.Flush(); // no need to check return code since we anyway break
 			break;
 		}
@@ -193,14 +222,21 @@ void ApiServe ( std::unique_ptr<AsyncNetBuffer_c> pBuf )
 			break;
 		}
 
-		// persist is special command - no version, no answer expected, modifies persistent state - so process it here
+		// persist is special command - no answer expected, modifies persistent state - so process it here
+		// its version word carries codecs the master offers for compressed replies
 		if ( eCommand == SEARCHD_COMMAND_PERSIST )
 		{
-			auto bPersist = ( tIn.GetInt()!=0 );
+			auto bPersist = ( tCmdIn.GetInt()!=0 );
 			sphLogDebugv ( "conn %s(%d): pconn is now %s", tSess.szClientName (), tSess.GetConnID(), bPersist ? "on" : "off" );
 			tSess.SetPersistent ( bPersist );
+			if ( uVer )
+				eReplyCodec = ApiCompressionAccept ( uVer );
 		}
-		ExecuteApiCommand ( eCommand, uVer, iReplySize, tIn, tOut );
+
+		auto iReplyStart = tOut.GetSentCount();
+		ExecuteApiCommand ( eCommand, uVer, iReplySize, tCmdIn, tOut );
+		if ( eReplyCodec!=Compression_e::NONE )
+			ApiCompressPacket ( tOut, iReplyStart, true, eReplyCodec, true, tCompressStats );
 
 		if ( !tOut.Flush () )
 			break;
@@ -212,6 +248,9 @@ void ApiServe ( std::unique_ptr<AsyncNetBuffer_c> pBuf )
 
 	} while ( tSess.GetPersistent());
 
+	if ( tCompressStats.m_iRawBytes )
+		sphLogDebugv ( "conn %s(%d): compressed frames " INT64_FMT " -> " INT64_FMT " bytes in " INT64_FMT " us", sClientIP, iCID,
+				tCompressStats.m_iRawBytes, tCompressStats.m_iWireBytes, tCompressStats.m_iTimeUS );
 	sphLogDebugv ( "conn %s(%d): exiting", sClientIP, iCID );
 }
 
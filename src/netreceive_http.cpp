@@ -273,7 +273,7 @@ void HttpServe ( std::unique_ptr<AsyncNetBuffer_c> pBuf )
 		}
 
 //		tracer.Instant ( [&tIn](StringBuilder_c& sOut) {sOut<< ",\"args\":{\"step\":"<<tIn.HasBytes()<<"}";} );
-		bOk = tParser.ProcessClientHttp ( tIn, dResult );
+		bOk = tParser.ProcessClientHttp ( tIn, tOut, dResult );
 
 		if ( !SendReply ( tOut, dResult ) )
 			break;
@@ -34,6 +34,66 @@ static ESphEvalStage GetEarliestStage ( ESphEvalStage eStage, const CSphColumnIn
 
 ///////////////////////////////////////////////////////////////////////////////
 
+template<typename T, typename EVAL, typename STORE>
+static void CalcContextItemBatch_T ( const VecTraits_T<CSphMatch *> & dMatches, EVAL && fnEval, STORE && fnStore )
+{
+	T dValues[MAX_EXPR_BATCH];
+	for ( int iStart = 0; iStart < dMatches.GetLength(); iStart += MAX_EXPR_BATCH )
+	{
+		int iLen = Min ( MAX_EXPR_BATCH, dMatches.GetLength()-iStart );
+		VecTraits_T<const CSphMatch *> dChunk ( (const CSphMatch **)dMatches.Begin()+iStart, iLen );
+		fnEval ( dChunk, dValues );
+		for ( int i = 0; i < iLen; i++ )
+			fnStore ( *dMatches[iStart+i], dValues[i] );
+	}
+}
+
+
+void CalcContextItemBatch ( const VecTraits_T<CSphMatch *> & dMatches, const ContextCalcItem_t & tCalc )
+{
+	const ISphExpr * pExpr = tCalc.m_pExpr;
+	const CSphAttrLocator & tLoc = tCalc.m_tLoc;
+
+	switch ( tCalc.m_eType )
+	{
+	case SPH_ATTR_BOOL:
+	case SPH_ATTR_INTEGER:
+	case SPH_ATTR_TIMESTAMP:
+		CalcContextItemBatch_T<int> ( dMatches,
+			[pExpr]( const VecTraits_T<const CSphMatch *> & dChunk, int * pOut ){ pExpr->IntEvalBatch ( dChunk, pOut ); },
+			[&tLoc]( CSphMatch & tMatch, int iValue ){ tMatch.SetAttr ( tLoc, iValue ); } );
+		break;
+
+	case SPH_ATTR_BIGINT:
+	case SPH_ATTR_UINT64:
+	case SPH_ATTR_JSON_FIELD:
+		CalcContextItemBatch_T<int64_t> ( dMatches,
+			[pExpr]( const VecTraits_T<const CSphMatch *> & dChunk, int64_t * pOut ){ pExpr->Int64EvalBatch ( dChunk, pOut ); },
+			[&tLoc]( CSphMatch & tMatch, int64_t iValue ){ tMatch.SetAttr ( tLoc, iValue ); } );
+		break;
+
+	case SPH_ATTR_FLOAT:
+		CalcContextItemBatch_T<float> ( dMatches,
+			[pExpr]( const VecTraits_T<const CSphMatch *> & dChunk, float * pOut ){ pExpr->EvalBatch ( dChunk, pOut ); },
+			[&tLoc]( CSphMatch & tMatch, float fValue ){ tMatch.SetAttrFloat ( tLoc, fValue ); } );
+		break;
+
+	default:
+		for ( auto * pMatch : dMatches )
+			CalcContextItem ( *pMatch, tCalc );
+		break;
+	}
+}
+
+
+void CSphQueryContext::CalcSortBatch ( const VecTraits_T<CSphMatch *> & dMatches ) const
+{
+	// same as CalcSort() for every match; items go in order, as later ones may read the earlier ones
+	for ( const auto & tItem : m_dCalcSort )
+		CalcContextItemBatch ( dMatches, tItem );
+}
+
+
 CSphQueryContext::CSphQueryContext ( const CSphQuery & tQuery )
 	: m_tQuery ( tQuery )
 {
@@ -72,6 +72,9 @@ FORCE_INLINE void CalcContextItems ( CSphMatch & tMatch, const VecTraits_T<Conte
 		CalcContextItem ( tMatch, i );
 }
 
+/// same as CalcContextItem, but for a set of matches; numeric items are evaluated via batch expression calls
+void CalcContextItemBatch ( const VecTraits_T<CSphMatch *> & dMatches, const ContextCalcItem_t & tCalc );
+
 
 FORCE_INLINE void FreeDataPtrAttrs ( CSphMatch & tMatch, const CSphVector<ContextCalcItem_t> & dItems, const IntVec_t & dItemIndexes )
 {
@@ -129,6 +132,7 @@ public:
 	const SmallStringHash_T<int64_t> * m_pLocalDocs = nullptr;
 	int64_t							m_iTotalDocs = 0;
 	int64_t							m_iIndexTotalDocs = 0;
+	const RowIdBoundaries_t *		m_pRowIdBoundaries = nullptr;	///< full-text matching is limited to these rowids (if set)
 
 	explicit CSphQueryContext ( const CSphQuery & tQuery );
 			~CSphQueryContext () { 	ResetFilters(); }
@@ -141,6 +145,8 @@ public:
 	void	CalcSort ( CSphMatch & tMatch )	const									{ CalcContextItems ( tMatch, m_dCalcSort ); }
 	void	CalcFinal ( CSphMatch & tMatch ) const									{ CalcContextItems ( tMatch, m_dCalcFinal ); }
 	void	CalcItem ( CSphMatch & tMatch, const ContextCalcItem_t & tCalc ) const	{ CalcContextItem ( tMatch, tCalc ); }
+	void	CalcItemBatch ( const VecTraits_T<CSphMatch *> & dMatches, const ContextCalcItem_t & tCalc ) const { CalcContextItemBatch ( dMatches, tCalc ); }
+	void	CalcSortBatch ( const VecTraits_T<CSphMatch *> & dMatches ) const;
 
 	void	FreeDataFilter ( CSphMatch & tMatch ) const;
 	void	FreeDataSort ( CSphMatch & tMatch ) const;
@@ -31,6 +31,7 @@
 
 static const char g_sIntAttrPrefix[] = "@int_attr_";
 static const char g_sIntJsonPrefix[] = "@groupbystr_";
+static const char g_sDistinctSketch[] = "@distinct_sketch";
 
 
 bool HasImplicitGrouping ( const CSphQuery & tQuery )
@@ -124,6 +125,12 @@ const char * GetInternalJsonPrefix()
 }
 
 
+const char * GetDistinctSketchAttrName()
+{
+	return g_sDistinctSketch;
+}
+
+
 bool IsSortStringInternal ( const CSphString & sColumnName )
 {
 	assert ( sColumnName.cstr ());
@@ -204,6 +211,7 @@ void CSphGroupSorterSettings::FixupLocators ( const ISphSchema * pOldSchema, con
 	sphFixupLocator ( m_tLocCount, pOldSchema, pNewSchema );
 	sphFixupLocator ( m_tLocDistinct, pOldSchema, pNewSchema );
 	sphFixupLocator ( m_tLocGroupbyStr, pOldSchema, pNewSchema );
+	sphFixupLocator ( m_tLocDistinctSketch, pOldSchema, pNewSchema );
 
 	if ( m_pDistinctFetcher )
 		m_pDistinctFetcher->FixupLocators ( pOldSchema, pNewSchema );
@@ -1590,6 +1598,15 @@ bool QueueCreator_c::MaybeAddGroupbyMagic ( bool bGotDistinct )
 			CSphColumnInfo tDistinct ( "@distinct", SPH_ATTR_INTEGER );
 			tDistinct.m_eStage = SPH_EVAL_SORTER;
 			AddColumn ( tDistinct );
+
+			// master merges the distinct values of the groups from the agents as HLL sketches, not as a bare count
+			int iThresh = m_tQuery.m_bExplicitDistinctThresh ? m_tQuery.m_iDistinctThresh : GetDistinctThreshDefault();
+			if ( m_tQuery.m_bDistinctSketch && iThresh )
+			{
+				CSphColumnInfo tSketch ( g_sDistinctSketch, SPH_ATTR_STRINGPTR );
+				tSketch.m_eStage = SPH_EVAL_SORTER;
+				AddColumn ( tSketch );
+			}
 		}
 
 		// add @groupbystr last in case we need to skip it on sending (like @int_attr_*)
@@ -1617,6 +1634,13 @@ bool QueueCreator_c::MaybeAddGroupbyMagic ( bool bGotDistinct )
 			LOC_CHECK ( iDistinct>=0, "missing @distinct" );
 			m_tGroupSorterSettings.m_tLocDistinct = m_pSorterSchema->GetAttr ( iDistinct ).m_tLocator;
 			LOC_CHECK ( m_tGroupSorterSettings.m_tLocDistinct.m_bDynamic, "@distinct must be dynamic" );
+
+			int iSketch = m_pSorterSchema->GetAttrIndex ( g_sDistinctSketch );
+			if ( iSketch>=0 )
+			{
+				m_tGroupSorterSettings.m_tLocDistinctSketch = m_pSorterSchema->GetAttr ( iSketch ).m_tLocator;
+				m_tGroupSorterSettings.m_bEmitDistinctSketch = !m_tSettings.m_bGrouped || m_tQuery.m_bAgent;
+			}
 		}
 		else
 			LOC_CHECK ( iDistinct<=0, "unexpected @distinct" );
@@ -22,6 +22,7 @@ struct CSphGroupSorterSettings
 	CSphAttrLocator		m_tLocCount;		///< locator for @count
 	CSphAttrLocator		m_tLocDistinct;		///< locator for @distinct
 	CSphAttrLocator		m_tLocGroupbyStr;	///< locator for @groupbystr
+	CSphAttrLocator		m_tLocDistinctSketch;	///< locator for serialized HLL of the group's distinct values (distributed count distinct)
 
 	bool				m_bDistinct = false;///< whether we need distinct
 	CSphRefcountedPtr<CSphGrouper>		m_pGrouper;///< group key calculator
@@ -32,6 +33,7 @@ struct CSphGroupSorterSettings
 	int					m_iMaxMatches = 0;
 	bool				m_bGrouped = false;	///< are we going to push already grouped matches to it?
 	int					m_iDistinctAccuracy = 16;	///< HyperLogLog accuracy. 0 means "don't use HLL"
+	bool				m_bEmitDistinctSketch = false;	///< whether to fill m_tLocDistinctSketch on finalize (false for the final merge on master)
 
 	void FixupLocators ( const ISphSchema * pOldSchema, const ISphSchema * pNewSchema );
 	void SetupDistinctAccuracy ( int iThresh );
@@ -59,6 +61,7 @@ bool			IsGroupbyMagic ( const CSphString & s );
 ESphAttr		DetermineNullMaskType ( int iNumAttrs );
 const char *	GetInternalAttrPrefix();
 const char *	GetInternalJsonPrefix();
+const char *	GetDistinctSketchAttrName();
 bool			IsSortStringInternal ( const CSphString & sColumnName );
 bool			IsSortJsonInternal ( const CSphString & sColumnName );
 CSphString		SortJsonInternalSet ( const CSphString & sColumnName );
@@ -82,66 +82,129 @@ static bool ActivateIndexOnRemotes ( const CSphString& sCluster, const CSphStrin
 	return true;
 }
 
-bool SyncSrc_t::CalculateFilesSignatures ( SstProgress_i & tProgress )
+// progress of the donor is not thread-safe, so parallel hashing reports it under the lock in large enough portions
+static constexpr int64_t HASH_PROGRESS_STEP = 16 * 1024 * 1024;
+static constexpr int MAX_HASH_THREADS = 4;
+
+static bool HashFile ( SyncSrc_t & tSrc, int iFile, CSphFixedVector<BYTE> & dReadBuf, const std::function<void ( int64_t )> & fnProgress, CSphString & sError )
 {
-	int64_t tmStart = sphMicroTimer();
-	TLS_MSG_STRING ( sError );
-	tProgress.StageBegin ( SstStage_e::CALC_SHA1 );
+	int64_t tmStartFile = sphMicroTimer();
 
-	auto iMaxChunkBytes = InitSyncSrc();
-	if ( !iMaxChunkBytes.has_value() )
+	const CSphString& sFile = tSrc.m_dIndexFiles[iFile];
+	const FileChunks_t& tChunk = tSrc.m_dChunks[iFile];
+
+	CSphAutofile tIndexFile;
+	if ( tIndexFile.Open ( sFile, SPH_O_READ, sError ) < 0 )
 		return false;
 
 	SHA1_c tHashFile;
 	SHA1_c tHashChunk;
-	const int iFiles = m_dIndexFiles.GetLength();
-
-	CSphFixedVector<BYTE> dReadBuf { iMaxChunkBytes.value() };
+	tHashFile.Init();
 
-	for ( int iFile = 0; iFile < iFiles; ++iFile )
+	int iChunk = 0;
+	int64_t iReadTotal = 0;
+	int64_t iUnreported = 0;
+	while ( iReadTotal < tChunk.m_iFileSize )
 	{
-		int64_t tmStartFile = sphMicroTimer();
-
-		const CSphString& sFile = m_dIndexFiles[iFile];
-		const FileChunks_t& tChunk = m_dChunks[iFile];
+		int64_t iLeftTotal = tChunk.m_iFileSize - iReadTotal;
+		int64_t iLeft = Min ( iLeftTotal, tChunk.m_iChunkBytes );
+		iReadTotal += iLeft;
 
-		CSphAutofile tIndexFile;
-		if ( tIndexFile.Open ( sFile, SPH_O_READ, sError ) < 0 )
+		if ( !tIndexFile.Read ( dReadBuf.Begin(), iLeft, sError ) )
 			return false;
 
-		tHashFile.Init();
+		// update whole file hash
+		tHashFile.Update ( dReadBuf.Begin(), iLeft );
 
-		int iChunk = 0;
-		int64_t iReadTotal = 0;
-		while ( iReadTotal < tChunk.m_iFileSize )
+		// update and flush chunk hash
+		tHashChunk.Init();
+		tHashChunk.Update ( dReadBuf.Begin(), iLeft );
+		tHashChunk.Final ( tSrc.GetChunkHash ( iFile, iChunk ) );
+		++iChunk;
+
+		iUnreported += iLeft;
+		if ( iUnreported>=HASH_PROGRESS_STEP )
 		{
-			int64_t iLeftTotal = tChunk.m_iFileSize - iReadTotal;
-			int64_t iLeft = Min ( iLeftTotal, tChunk.m_iChunkBytes );
-			iReadTotal += iLeft;
+			fnProgress ( iUnreported );
+			iUnreported = 0;
+		}
+	}
+
+	tIndexFile.Close();
+	tHashFile.Final ( tSrc.GetFileHash ( iFile ) );
+	fnProgress ( iUnreported );
+
+	tSrc.m_dHashTimes[iFile] = ( sphMicroTimer() - tmStartFile ) / 1000;
+	return true;
+}
 
-			if ( !tIndexFile.Read ( dReadBuf.Begin(), iLeft, sError ) )
-				return false;
+bool SyncSrc_t::CalculateFilesSignatures ( SstProgress_i & tProgress )
+{
+	TLS_MSG_STRING ( sError );
+	tProgress.StageBegin ( SstStage_e::CALC_SHA1 );
 
-			// update whole file hash
-			tHashFile.Update ( dReadBuf.Begin(), iLeft );
+	auto iMaxChunkBytes = InitSyncSrc();
+	if ( !iMaxChunkBytes.has_value() )
+		return false;
 
-			// update and flush chunk hash
-			tHashChunk.Init();
-			tHashChunk.Update ( dReadBuf.Begin(), iLeft );
-			tHashChunk.Final ( GetChunkHash ( iFile, iChunk ) );
-			++iChunk;
+	const int iFiles = m_dIndexFiles.GetLength();
+	CSphBitvec dCached ( iFiles );
+	tProgress.AddComplete ( LoadCachedDigests ( dCached ) );
 
-			tProgress.AddComplete ( iLeft );
-		}
+	CSphVector<int> dToHash;
+	for ( int iFile = 0; iFile < iFiles; ++iFile )
+		if ( !dCached.BitGet ( iFile ) )
+			dToHash.Add ( iFile );
+
+	sphLogDebugRpl ( "sha1 of %d files taken from cache, %d files to hash", iFiles - dToHash.GetLength(), dToHash.GetLength() );
+
+	// files are independent, so they are hashed in parallel; workers must not touch TLS, so error goes under the lock
+	Threads::Coro::Mutex_c tLock;
+	std::atomic<int> iNextFile { 0 };
+	std::atomic<bool> bFailed { false };
+	auto fnProgress = [&tLock, &tProgress] ( int64_t iBytes )
+	{
+		Threads::Coro::ScopedMutex_t tGuard { tLock };
+		tProgress.AddComplete ( iBytes );
+	};
+
+	// hashing runs in the same pool as queries, so it takes only a few of its threads, and searches keep going during SST
+	const int iHashThreads = Min ( Max ( Threads::NThreads() / 4, 1 ), MAX_HASH_THREADS );
+	if ( !dToHash.IsEmpty() )
+		Threads::Coro::ExecuteN ( Min ( iHashThreads, dToHash.GetLength() ), [&]
+		{
+			CSphFixedVector<BYTE> dReadBuf { iMaxChunkBytes.value() };
+			CSphString sFileError;
+			while ( !bFailed.load ( std::memory_order_relaxed ) )
+			{
+				int iJob = iNextFile.fetch_add ( 1, std::memory_order_relaxed );
+				if ( iJob>=dToHash.GetLength() )
+					return;
+
+				if ( !HashFile ( *this, dToHash[iJob], dReadBuf, fnProgress, sFileError ) )
+				{
+					Threads::Coro::ScopedMutex_t tGuard { tLock };
+					sError = sFileError;
+					bFailed.store ( true, std::memory_order_relaxed );
+					return;
+				}
+			}
+		} );
+
+	if ( bFailed.load ( std::memory_order_relaxed ) )
+		return false;
 
-		tIndexFile.Close();
-		tHashFile.Final ( GetFileHash ( iFile ) );
+	SaveCachedDigests ( dCached );
 
-		int64_t tmDeltaFile = ( sphMicroTimer() - tmStartFile ) / 1000;
-		m_tmTimeoutFile = Max ( tmDeltaFile, m_tmTimeoutFile );
+	// joiner verifies files sequentially, so timeouts are based on time of sequential hashing, not on the wall time
+	int64_t tmHashAll = 0;
+	for ( int64_t tmFile : m_dHashTimes )
+	{
+		tmHashAll += tmFile;
+		m_tmTimeoutFile = Max ( tmFile, m_tmTimeoutFile );
 	}
 
-	m_tmTimeout = Min ( ( sphMicroTimer() - tmStart ) / 1000, 300000 ); // long operation timeout but at least 5 minutes
+	m_tmTimeout = Min ( tmHashAll, 300000 ); // long operation timeout but at least 5 minutes
 	return true;
 }
 
@@ -13,8 +13,11 @@
 #include "send_files.h"
 
 #include "searchdha.h"
+#include "indexfiles.h"
+#include "fileutils.h"
 
 #include <optional>
+#include <sys/stat.h>
 
 // count of chunks for file size
 int FileChunks_t::GetChunksCount () const noexcept
@@ -64,6 +67,22 @@ HASH20_t& SyncSrc_t::GetChunkHash ( int iFile, int iChunk ) const noexcept
 // rsync uses sqrt ( iSize ) but that make too small buffers
 constexpr int iBlockMin = 2048;
 
+// modification time in microseconds, or 0 if unknown (that never matches a cached digest)
+static int64_t GetFileMTime ( int iFD )
+{
+	struct_stat tStat;
+	if ( fstat ( iFD, &tStat )<0 )
+		return 0;
+
+#if defined(__linux__)
+	return (int64_t)tStat.st_mtim.tv_sec * 1000000 + tStat.st_mtim.tv_nsec / 1000;
+#elif defined(__APPLE__)
+	return (int64_t)tStat.st_mtimespec.tv_sec * 1000000 + tStat.st_mtimespec.tv_nsec / 1000;
+#else
+	return (int64_t)tStat.st_mtime * 1000000;
+#endif
+}
+
 std::optional<int> SyncSrc_t::InitSyncSrc ()
 {
 	TLS_MSG_STRING ( sError );
@@ -71,6 +90,9 @@ std::optional<int> SyncSrc_t::InitSyncSrc ()
 	const int iFiles = m_dIndexFiles.GetLength();
 	m_dBaseNames.Reset ( iFiles );
 	m_dChunks.Reset ( iFiles );
+	m_dMTimes.Reset ( iFiles );
+	m_dHashTimes.Reset ( iFiles );
+	m_dHashTimes.Fill ( 0 );
 
 	int iMaxChunkBytes = 0;
 	m_iBufferSize = (int64_t)g_iMaxPacketSize * 3 / 4;
@@ -85,6 +107,7 @@ std::optional<int> SyncSrc_t::InitSyncSrc ()
 
 		m_dBaseNames[i] = GetBaseName ( sFile );
 		int64_t iFileSize = tIndexFile.GetSize();
+		m_dMTimes[i] = GetFileMTime ( tIndexFile.GetFD() );
 
 		// int iChunkBytes = int ( iFileSize / iBlockMin ); // FIXME!!! sqrt ( iFileSize )
 		// no need too small chunks
@@ -108,6 +131,158 @@ std::optional<int> SyncSrc_t::InitSyncSrc ()
 	return iMaxChunkBytes;
 }
 
+// digests of immutable disk chunk files are cached in the .spsha file of the chunk, so that the donor of the next SST
+// reads and hashes only files which changed since. The file goes away (or is renamed) together with its chunk,
+// and an entry is reused only while size and mtime of the file are the same as when it was hashed.
+static constexpr DWORD DIGESTS_MAGIC = 0x41485053; // 'SPHA'
+static constexpr DWORD DIGESTS_VERSION = 1;
+static constexpr int DIGESTS_RACY_SEC = 2; // files modified this recently might change once more within the same mtime
+
+static const ESphExt g_dDigestedExts[] = { SPH_EXT_SPI, SPH_EXT_SPD, SPH_EXT_SPP, SPH_EXT_SPE, SPH_EXT_SPT, SPH_EXT_SPDS, SPH_EXT_SPC, SPH_EXT_SPIDX, SPH_EXT_SPJIDX, SPH_EXT_SPKNN };
+
+// group files which digests might be cached by base name of their disk chunk
+static SmallStringHash_T<CSphVector<int>> GroupByDiskChunk ( const StrVec_t & dFiles )
+{
+	SmallStringHash_T<CSphVector<int>> hChunks;
+	ARRAY_FOREACH ( iFile, dFiles )
+	{
+		const CSphString & sFile = dFiles[iFile];
+		for ( ESphExt eExt : g_dDigestedExts )
+		{
+			if ( !sFile.Ends ( sphGetExt ( eExt ) ) )
+				continue;
+
+			CSphString sBase = sFile.SubString ( 0, sFile.Length() - (int)strlen ( sphGetExt ( eExt ) ) );
+			hChunks.AddUnique ( sBase ).Add ( iFile );
+			break;
+		}
+	}
+
+	return hChunks;
+}
+
+
+int64_t SyncSrc_t::LoadCachedDigests ( CSphBitvec & dCached )
+{
+	int64_t iCachedBytes = 0;
+	CSphFixedVector<HASH20_t> dHashes { 0 };
+	CSphString sError;
+
+	for ( const auto & tChunk : GroupByDiskChunk ( m_dIndexFiles ) )
+	{
+		CSphString sDigests = SphSprintf ( "%s%s", tChunk.first.cstr(), sphGetExt ( SPH_EXT_SPSHA ) );
+		if ( !sphIsReadable ( sDigests ) )
+			continue;
+
+		CSphAutoreader tReader;
+		if ( !tReader.Open ( sDigests, sError ) || tReader.GetDword()!=DIGESTS_MAGIC || tReader.GetDword()!=DIGESTS_VERSION )
+			continue;
+
+		int iEntries = (int)tReader.GetDword();
+		for ( int iEntry = 0; iEntry<iEntries && !tReader.GetErrorFlag(); ++iEntry )
+		{
+			CSphString sExt = tReader.GetString();
+			int64_t iFileSize = tReader.GetOffset();
+			int64_t iMTime = tReader.GetOffset();
+			int64_t tmHash = tReader.GetOffset();
+			int iChunkBytes = (int)tReader.GetDword();
+			int iHashes = (int)tReader.GetDword();
+			if ( iHashes<0 || iHashes>=INT_MAX / HASH20_SIZE )
+				break;
+
+			int64_t iFound = tChunk.second.GetFirst ( [&] ( int iFile ) { return !strcmp ( m_dIndexFiles[iFile].cstr() + tChunk.first.Length(), sExt.cstr() ); } );
+			int iFile = iFound<0 ? -1 : tChunk.second[iFound];
+			if ( iFile<0 || dCached.BitGet ( iFile ) || m_dChunks[iFile].m_iFileSize!=iFileSize || m_dMTimes[iFile]!=iMTime
+				|| m_dChunks[iFile].m_iChunkBytes!=iChunkBytes || m_dChunks[iFile].GetChunksCount()!=iHashes )
+			{
+				tReader.SkipBytes ( ( iHashes+1 ) * HASH20_SIZE );
+				continue;
+			}
+
+			// file hash goes first, then hashes of its chunks
+			dHashes.Reset ( iHashes+1 );
+			tReader.GetBytes ( dHashes.Begin(), dHashes.GetLengthBytes64() );
+			if ( tReader.GetErrorFlag() )
+				break;
+
+			GetFileHash ( iFile ) = dHashes[0];
+			for ( int iChunk = 0; iChunk<iHashes; ++iChunk )
+				GetChunkHash ( iFile, iChunk ) = dHashes[iChunk+1];
+
+			m_dHashTimes[iFile] = tmHash;
+			dCached.BitSet ( iFile );
+			iCachedBytes += iFileSize;
+		}
+	}
+
+	return iCachedBytes;
+}
+
+
+void SyncSrc_t::SaveCachedDigests ( const CSphBitvec & dCached ) const
+{
+	int64_t tmStable = ( (int64_t)time ( nullptr ) - DIGESTS_RACY_SEC ) * 1000000;
+	CSphString sError;
+
+	for ( const auto & tChunk : GroupByDiskChunk ( m_dIndexFiles ) )
+	{
+		// nothing new to store if every file of the chunk came from its cache
+		if ( tChunk.second.all_of ( [&dCached] ( int iFile ) { return dCached.BitGet ( iFile ); } ) )
+			continue;
+
+		CSphVector<int> dStable;
+		for ( int iFile : tChunk.second )
+			if ( m_dMTimes[iFile] && m_dMTimes[iFile]<tmStable )
+				dStable.Add ( iFile );
+
+		if ( dStable.IsEmpty() )
+			continue;
+
+		CSphString sDigests = SphSprintf ( "%s%s", tChunk.first.cstr(), sphGetExt ( SPH_EXT_SPSHA ) );
+		CSphString sTmp = SphSprintf ( "%s.tmp", sDigests.cstr() );
+
+		CSphWriter tWriter;
+		if ( !tWriter.OpenFile ( sTmp, sError ) )
+		{
+			sphLogDebugRpl ( "failed to cache file digests: %s", sError.cstr() );
+			continue;
+		}
+
+		tWriter.PutDword ( DIGESTS_MAGIC );
+		tWriter.PutDword ( DIGESTS_VERSION );
+		tWriter.PutDword ( dStable.GetLength() );
+		for ( int iFile : dStable )
+		{
+			const FileChunks_t & tChunks = m_dChunks[iFile];
+			tWriter.PutString ( m_dIndexFiles[iFile].cstr() + tChunk.first.Length() );
+			tWriter.PutOffset ( tChunks.m_iFileSize );
+			tWriter.PutOffset ( m_dMTimes[iFile] );
+			tWriter.PutOffset ( m_dHashTimes[iFile] );
+			tWriter.PutDword ( tChunks.m_iChunkBytes );
+			tWriter.PutDword ( tChunks.GetChunksCount() );
+			tWriter.PutBytes ( &GetFileHash ( iFile ), HASH20_SIZE );
+			if ( tChunks.GetChunksCount() )
+				tWriter.PutBytes ( &GetChunkHash ( iFile, 0 ), (int64_t)tChunks.GetChunksCount() * HASH20_SIZE );
+		}
+
+		tWriter.CloseFile();
+		if ( tWriter.IsError() )
+		{
+			::unlink ( sTmp.cstr() );
+			continue;
+		}
+
+#if _WIN32
+		::unlink ( sDigests.cstr() );
+#endif
+		if ( sph::rename ( sTmp.cstr(), sDigests.cstr() ) )
+		{
+			sphLogDebugRpl ( "failed to rename %s to %s: %s", sTmp.cstr(), sDigests.cstr(), strerrorm ( errno ) );
+			::unlink ( sTmp.cstr() );
+		}
+	}
+}
+
 bool VerifyFileHash ( int iFile, const CSphString& sName, const SyncSrc_t& tSrc, CSphBitvec& tDst, CSphVector<BYTE>& dBuf, CSphString& sError )
 {
 	const FileChunks_t& tChunk = tSrc.m_dChunks[iFile];
@@ -59,6 +59,12 @@ struct SyncSrc_t
 
 	int64_t m_iBufferSize = 0;
 
+	// modification time (in microseconds) of every index file, to check cached digests against
+	CSphFixedVector<int64_t> m_dMTimes { 0 };
+
+	// milliseconds it took to hash every index file; taken from the digests cache for cached files
+	CSphFixedVector<int64_t> m_dHashTimes { 0 };
+
 public:
 	SyncSrc_t() = default;
 	explicit SyncSrc_t ( StrVec_t&& dIndexFiles );
@@ -67,8 +73,10 @@ public:
 	bool CalculateFilesSignatures ( SstProgress_i & tProgress );
 	uint64_t CalculateNeededBytes ( const CSphBitvec & dNeededChunks ) const;
 
-private:
+	// steps of CalculateFilesSignatures; declared here to make available for testing
 	std::optional<int> InitSyncSrc ();
+	int64_t LoadCachedDigests ( CSphBitvec & dCached );
+	void SaveCachedDigests ( const CSphBitvec & dCached ) const;
 };
 
 bool VerifyFileHash ( int iFile, const CSphString& sName, const SyncSrc_t& tSrc, CSphBitvec& tDst, CSphVector<BYTE>& dBuf, CSphString& sError );
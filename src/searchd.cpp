@@ -55,6 +55,7 @@
 #include "std/tdigest.h"
 #include "std/tdigest_runtime.h"
 #include "daemon/notifier.h"
+#include "daemon/hot_restart.h"
 
 // services
 #include "taskping.h"
@@ -66,6 +67,7 @@
 #include "taskflushmutable.h"
 #include "taskpreread.h"
 #include "searchdbuddy.h"
+#include "compressed_api.h"
 #include "detail/indexlink.h"
 #include "detail/expmeter.h"
 
@@ -485,6 +487,9 @@ void Shutdown () REQUIRES ( MainThread ) NO_THREAD_SAFETY_ANALYSIS
 	ShutdownKNN();
 	sd::extend30s();
 
+	SHUTINFO << "Stop hot restart service ...";
+	hotrestart::StopService();
+
 	SHUTINFO << "Shutdown listeners ...";
 	for ( auto& dListener : g_dListeners )
 		if ( dListener.m_iSock>=0 )
@@ -494,16 +499,17 @@ void Shutdown () REQUIRES ( MainThread ) NO_THREAD_SAFETY_ANALYSIS
 	ClosePersistentSockets();
 	sd::extend30s();
 
+	// remove pid file, if we owned it and didn't hand it over to a new instance; while it is still locked,
+	// so that whoever waits for the lock gets it only when the file is already gone
+	if ( g_bPidIsMine && !hotrestart::HandedOver() && !g_sPidFile.IsEmpty() )
+		::unlink ( g_sPidFile.cstr() );
+
 	// close pid
 	SHUTINFO << "Release (close) pid file ...";
 	if ( g_iPidFD!=-1 )
 		::close ( g_iPidFD );
 	g_iPidFD = -1;
 
-	// remove pid file, if we owned it
-	if ( g_bPidIsMine && !g_sPidFile.IsEmpty() )
-		::unlink ( g_sPidFile.cstr() );
-
 	SHUTINFO << "Shutdown hazard pointers ...";
 	hazard::Shutdown ();
 	sd::extend30s();
@@ -715,17 +721,24 @@ bool AddGlobalListener ( const ListenerDesc_t& tDesc ) REQUIRES ( MainThread )
 
 	Listener_t tListener;
 	tListener.m_eProto = tDesc.m_eProto;
-	tListener.m_bTcp = true;
+	tListener.m_bTcp = tDesc.m_sUnix.IsEmpty();
 	tListener.m_bVIP = tDesc.m_bVIP;
 	tListener.m_bReadOnly = tDesc.m_bReadOnly;
 
-#if !_WIN32
-	if ( !tDesc.m_sUnix.IsEmpty () )
+	// socket taken over from the previous instance on hot restart
+	tListener.m_iSock = hotrestart::PopInherited ( tDesc );
+	if ( tListener.m_iSock>=0 )
 	{
+		if ( tListener.m_bTcp )
+			sphInfo ( "listening on port=%d for %s (taken over)", tDesc.m_iPort, RelaxedProtoName ( tDesc.m_eProto ) );
+		else
+			sphInfo ( "listening on UNIX socket %s (taken over)", tDesc.m_sUnix.cstr() );
+	}
+#if !_WIN32
+	else if ( !tListener.m_bTcp )
 		tListener.m_iSock = sphCreateUnixSocket ( tDesc.m_sUnix.cstr () );
-		tListener.m_bTcp = false;
-	} else
 #endif
+	else
 		tListener.m_iSock = sphCreateInetSocket ( tDesc );
 
 	g_dListeners.Add ( tListener );
@@ -975,6 +988,7 @@ DistributedIndex_t * DistributedIndex_t::Clone() const
 	pDist->m_dAgents = m_dAgents;
 	pDist->m_dLocal = m_dLocal;
 	pDist->m_iAgentRetryCount = m_iAgentRetryCount;
+	pDist->m_iHedgeRate = m_iHedgeRate;
 	pDist->m_bDivideRemoteRanges = m_bDivideRemoteRanges;
 	pDist->m_eHaStrategy = m_eHaStrategy;
 	pDist->m_sCluster = m_sCluster;
@@ -2837,13 +2851,25 @@ void BuildStatus ( VectorLike & dStatus )
 		dStatus.MatchTuplet ( "avg_query_readtime", OFF );
 	}
 
-	const QcacheStatus_t & s = QcacheGetStatus();
+	QcacheStatus_t s = QcacheGetStatus();
 	dStatus.MatchTupletf ( "qcache_max_bytes", "%l", s.m_iMaxBytes );
 	dStatus.MatchTupletf ( "qcache_thresh_msec", "%d", s.m_iThreshMs );
 	dStatus.MatchTupletf ( "qcache_ttl_sec", "%d", s.m_iTtlS );
 	dStatus.MatchTupletf ( "qcache_cached_queries", "%d", s.m_iCachedQueries );
 	dStatus.MatchTupletf ( "qcache_used_bytes", "%l", s.m_iUsedBytes );
 	dStatus.MatchTupletf ( "qcache_hits", "%l", s.m_iHits );
+	dStatus.MatchTupletf ( "qcache_misses", "%l", s.m_iMisses );
+	dStatus.MatchTupletf ( "qcache_evictions", "%l", s.m_iEvictions );
+	for ( int i = 0; i < QCACHE_SHARDS; ++i )
+	{
+		const auto & tShard = s.m_dShards[i];
+		CSphString sKey;
+		sKey.SetSprintf ( "qcache_shard_%d", i );
+		dStatus.MatchTupletf ( sKey.cstr(), "queries=%d bytes=%l hits=%l misses=%l evictions=%l", tShard.m_iCachedQueries, tShard.m_iUsedBytes, tShard.m_iHits, tShard.m_iMisses, tShard.m_iEvictions );
+	}
+
+	if ( Binlog::IsActive() )
+		BinlogFsyncStatus ( dStatus, Binlog::GetFsyncStats() );
 
 	// clusters
 	ReplicateClustersStatus ( dStatus );
@@ -2906,6 +2932,24 @@ void BuildOneAgentStatus ( VectorLike & dStatus, HostDashboardRefPtr_t pDash, co
 			dStatus.Addf ( "%.3F", pDash->m_uPingTripUS );
 		if ( dStatus.MatchAddf ( "%s_errorsarow", sPrefix ) )
 			dStatus.Addf ( "%l", pDash->m_iErrorsARow );
+		if ( dStatus.MatchAddf ( "%s_p95msec", sPrefix ) )
+			dStatus.Addf ( "%.3D", pDash->GetP95LatencyUS() );
+		if ( dStatus.MatchAddf ( "%s_hedged", sPrefix ) )
+			dStatus.Addf ( "%l", pDash->m_iHedged.load ( std::memory_order_relaxed ) );
+		if ( dStatus.MatchAddf ( "%s_hedge_wins", sPrefix ) )
+			dStatus.Addf ( "%l", pDash->m_iHedgeWins.load ( std::memory_order_relaxed ) );
+		int64_t iFramedRaw = pDash->m_iFramedRawBytes.load ( std::memory_order_relaxed );
+		int64_t iFramedWire = pDash->m_iFramedWireBytes.load ( std::memory_order_relaxed );
+		if ( dStatus.MatchAddf ( "%s_compression", sPrefix ) )
+			dStatus.Add ( CompressionToStr ( pDash->m_eApiCodec.load ( std::memory_order_relaxed ) ) );
+		if ( dStatus.MatchAddf ( "%s_compressed_raw_bytes", sPrefix ) )
+			dStatus.Addf ( "%l", iFramedRaw );
+		if ( dStatus.MatchAddf ( "%s_compressed_wire_bytes", sPrefix ) )
+			dStatus.Addf ( "%l", iFramedWire );
+		if ( dStatus.MatchAddf ( "%s_compression_ratio", sPrefix ) )
+			dStatus.Addf ( "%0.2f", iFramedWire ? double ( iFramedRaw ) / iFramedWire : 1.0 );
+		if ( dStatus.MatchAddf ( "%s_compression_msec", sPrefix ) )
+			dStatus.Addf ( "%.3D", pDash->m_iFramedTimeUS.load ( std::memory_order_relaxed ) );
 	}
 	int iPeriods = 1;
 
@@ -3088,6 +3132,15 @@ void BuildMeta ( VectorLike & dStatus, const CSphQueryResultMeta & tMeta )
 
 	if ( !sIterators.IsEmpty() )
 		dStatus.MatchTuplet ( "index", sIterators.cstr() );
+
+	if ( tMeta.m_tIteratorStats.m_iPrunedChunks )
+		dStatus.MatchTupletf ( "chunks_pruned", "%l", tMeta.m_tIteratorStats.m_iPrunedChunks );
+
+	if ( tMeta.m_tIteratorStats.m_iPrunedBlocks )
+		dStatus.MatchTupletf ( "blocks_pruned", "%l", tMeta.m_tIteratorStats.m_iPrunedBlocks );
+
+	if ( tMeta.m_tIteratorStats.m_iPrunedDoclistBlocks )
+		dStatus.MatchTupletf ( "doclist_blocks_pruned", "%l", tMeta.m_tIteratorStats.m_iPrunedDoclistBlocks );
 }
 
 
@@ -8105,6 +8158,52 @@ static void SendMysqlMatch ( const CSphMatch & tMatch, const CSphBitvec & tAttrs
 }
 
 // returns N of matches in resultset
+static void SendMysqlSelectHeader ( RowBuffer_i & dRows, const AggrResult_t & tRes, const CSphBitvec & tAttrsToSend, bool bMoreResultsFollow, bool bAddQueryColumn )
+{
+	dRows.HeadBegin ();
+	for ( int i=0; i<tRes.m_tSchema.GetAttrsCount(); ++i )
+	{
+		if ( !tAttrsToSend.BitGet(i) )
+			continue;
+
+		const CSphColumnInfo & tCol = tRes.m_tSchema.GetAttr(i);
+		dRows.HeadColumnRaw ( tCol.m_sName.cstr(), tCol.m_eAttrType );
+	}
+
+	if ( bAddQueryColumn )
+		dRows.HeadColumn ( "query" );
+
+	// EOF packet is sent explicitly due to non-default params.
+	auto iWarns = tRes.m_sWarning.IsEmpty() ? 0 : 1;
+	dRows.HeadEnd ( bMoreResultsFollow, iWarns );
+}
+
+// returns false if the client is gone
+static bool SendMysqlSelectRows ( RowBuffer_i & dRows, const AggrResult_t & tRes, const CSphBitvec & tAttrsToSend, bool bAddQueryColumn, const CSphString * pQueryColumn )
+{
+	// FIXME!!! replace that vector relocations by SqlRowBuffer
+
+	const CSphColumnInfo * pNullBitmaskAttr = tRes.m_tSchema.GetAttr ( GetNullMaskAttrName() );
+
+	assert ( tRes.m_bSingle );
+	auto dMatches = tRes.m_dResults.First ().m_dMatches.Slice ( tRes.m_iOffset, tRes.m_iCount );
+	for ( const auto & tMatch : dMatches )
+	{
+		SendMysqlMatch ( tMatch, tAttrsToSend, tRes.m_tSchema, dRows, pNullBitmaskAttr );
+
+		if ( bAddQueryColumn )
+		{
+			assert ( pQueryColumn );
+			dRows.PutString ( *pQueryColumn );
+		}
+
+		if ( !dRows.Commit() )
+			return false;
+	}
+
+	return true;
+}
+
 uint64_t SendMysqlSelectResult ( RowBuffer_i & dRows, const AggrResult_t & tRes, bool bMoreResultsFollow, bool bAddQueryColumn, const CSphString * pQueryColumn, QueryProfile_c * pProfile )
 {
 	CSphScopedProfile tProf ( pProfile, SPH_QSTATE_NET_WRITE );
@@ -8135,52 +8234,293 @@ uint64_t SendMysqlSelectResult ( RowBuffer_i & dRows, const AggrResult_t & tRes,
 	assert ( bReturnZeroCount || tRes.m_tSchema.GetAttrsCount() );
 	sphGetAttrsToSend ( tRes.m_tSchema, false, true, tAttrsToSend );
 
-	dRows.HeadBegin ();
-	for ( int i=0; i<tRes.m_tSchema.GetAttrsCount(); ++i )
-	{
-		if ( !tAttrsToSend.BitGet(i) )
-			continue;
+	SendMysqlSelectHeader ( dRows, tRes, tAttrsToSend, bMoreResultsFollow, bAddQueryColumn );
 
-		const CSphColumnInfo & tCol = tRes.m_tSchema.GetAttr(i);
-		dRows.HeadColumnRaw ( tCol.m_sName.cstr(), tCol.m_eAttrType );
-	}
+	uint64_t uMatches = tRes.m_dResults.First ().m_dMatches.GetLength();
+	if ( !SendMysqlSelectRows ( dRows, tRes, tAttrsToSend, bAddQueryColumn, pQueryColumn ) )
+		return uMatches;
 
-	if ( bAddQueryColumn )
-		dRows.HeadColumn ( "query" );
+	if ( bReturnZeroCount )
+		ReturnZeroCount ( tRes.m_tSchema, tAttrsToSend, tRes.m_dZeroCount, dRows );
 
-	// EOF packet is sent explicitly due to non-default params.
+	CSphString sMeta = BuildMetaOneline ( tRes );
+
+	// eof packet
 	auto iWarns = tRes.m_sWarning.IsEmpty() ? 0 : 1;
-	dRows.HeadEnd ( bMoreResultsFollow, iWarns );
+	dRows.Eof ( bMoreResultsFollow, iWarns, sMeta.cstr() );
+	return uMatches;
+}
 
-	// FIXME!!! replace that vector relocations by SqlRowBuffer
 
-	const CSphColumnInfo * pNullBitmaskAttr = tRes.m_tSchema.GetAttr ( GetNullMaskAttrName() );
+/////////////////////////////////////////////////////////////////////////////
+// STREAMED SELECT
+/////////////////////////////////////////////////////////////////////////////
 
-	assert ( tRes.m_bSingle );
-	auto dMatches = tRes.m_dResults.First ().m_dMatches.Slice ( tRes.m_iOffset, tRes.m_iCount );
-	uint64_t uMatches = tRes.m_dResults.First ().m_dMatches.GetLength();
-	for ( const auto & tMatch : dMatches )
+// export-style select (OPTION stream=1) is run as a series of id-ordered batches. The first one is a regular select,
+// which also fetches the max matching id in the same scan (multi-query); every next one only looks at a closed window
+// of ids right after the last one seen. With both bounds set, the docid lookup walk starts at the left edge of the
+// window and stops right past its right edge, so a batch reads about as many lookup entries as it returns, not the
+// whole remaining lookup. The window is sized from the id density of the previous batch. RT RAM segments have no
+// lookup and are scanned per batch, but they are capped by rt_mem_limit.
+// Rows are sent as soon as their batch is found, so the memory stays bounded by the batch size, and a slow
+// client throttles the whole thing via the blocking socket flush.
+// Full-text batches would re-match the whole query every time, so MATCH() is rejected.
+static const int STREAM_BATCH_SIZE = 10000;
+
+// id window of the next batch, that is (m_tLast, m_tLast+m_uSpan] clamped to the max id
+struct StreamWindow_t
+{
+	DocID_t		m_tLast = 0;	///< everything up to this id is already sent
+	DocID_t		m_tMax = 0;		///< max matching id when the stream started
+	uint64_t	m_uSpan = 1;
+
+	bool IsDone() const
 	{
-		SendMysqlMatch ( tMatch, tAttrsToSend, tRes.m_tSchema, dRows, pNullBitmaskAttr );
+		return m_tLast>=m_tMax;
+	}
 
-		if ( bAddQueryColumn )
+	DocID_t GetTo() const
+	{
+		// ids are signed, but the distance between two of them might not fit into int64
+		uint64_t uLeft = uint64_t(m_tMax) - uint64_t(m_tLast);
+		return m_uSpan>=uLeft ? m_tMax : DocID_t ( uint64_t(m_tLast) + m_uSpan );
+	}
+
+	void Advance ( DocID_t tTo, int iCount, int iBatchSize, DocID_t tLastSent )
+	{
+		if ( iCount>=iBatchSize )
 		{
-			assert ( pQueryColumn );
-			dRows.PutString ( *pQueryColumn );
+			// window had more than a batch; next one starts after the last sent id and is as wide as this batch was
+			m_uSpan = Max ( uint64_t(tLastSent) - uint64_t(m_tLast), (uint64_t)1 );
+			m_tLast = tLastSent;
+			return;
 		}
 
-		if ( !dRows.Commit() )
-			return uMatches;
+		m_tLast = tTo;
+		if ( iCount<iBatchSize/2 )
+			m_uSpan = m_uSpan>UINT64_MAX/2 ? UINT64_MAX : m_uSpan*2;
 	}
+};
 
-	if ( bReturnZeroCount )
-		ReturnZeroCount ( tRes.m_tSchema, tAttrsToSend, tRes.m_dZeroCount, dRows );
+static bool IsStreamOrder ( const CSphString & sOrderBy )
+{
+	CSphString sOrder = sOrderBy;
+	sOrder.ToLower();
+	sOrder.Trim();
 
-	CSphString sMeta = BuildMetaOneline ( tRes );
+	// order by clause as written; it is empty if there was no ORDER BY at all
+	return sOrder.IsEmpty() || sOrder=="id asc" || sOrder=="id";
+}
 
-	// eof packet
-	dRows.Eof ( bMoreResultsFollow, iWarns, sMeta.cstr() );
-	return uMatches;
+static bool CheckStreamQuery ( const SqlStmt_t & tStmt, CSphString & sError )
+{
+	const CSphQuery & tQuery = tStmt.m_tQuery;
+	if ( !tQuery.m_sGroupBy.IsEmpty() || tQuery.m_bFacet )
+		sError = "stream is not supported with GROUP BY or FACET";
+	else if ( tQuery.m_bHasOuter )
+		sError = "stream is not supported with subselects";
+	else if ( !tQuery.m_sJoinIdx.IsEmpty() )
+		sError = "stream is not supported with JOIN";
+	else if ( tQuery.HasKnn() )
+		sError = "stream is not supported with KNN search";
+	else if ( tStmt.m_pTableFunc )
+		sError = "stream is not supported with table functions";
+	else if ( !tQuery.m_sQuery.IsEmpty() )
+		sError = "stream is not supported with full-text MATCH()";
+	else if ( !IsStreamOrder ( tQuery.m_sOrderBy ) )
+		sError = "stream requires ORDER BY id ASC or no ORDER BY";
+	else if ( !tQuery.m_dItems.any_of ( [] ( const CSphQueryItem & tItem ) { return tItem.m_sExpr=="*" || ( tItem.m_sExpr==sphGetDocidName() && tItem.m_sAlias==sphGetDocidName() ); } ) )
+		sError = "stream requires 'id' in the select list";
+
+	return sError.IsEmpty();
+}
+
+static void AddStreamIdFilter ( CSphQuery & tQuery, DocID_t tFrom, DocID_t tTo )
+{
+	int iFilterId = tQuery.m_dFilters.GetLength();
+	CSphFilterSettings & tFilter = tQuery.m_dFilters.Add();
+	tFilter.m_eType = SPH_FILTER_RANGE;
+	tFilter.m_sAttrName = sphGetDocidName();
+	tFilter.m_iMinValue = tFrom;
+	tFilter.m_bHasEqualMin = false;
+	tFilter.m_iMaxValue = tTo;
+	tFilter.m_bHasEqualMax = true;
+
+	// window is meant to be walked via the docid lookup, unless the query says otherwise
+	if ( !tQuery.m_dIndexHints.any_of ( [] ( const IndexHint_t & tHint ) { return tHint.m_sIndex==sphGetDocidName(); } ) )
+		tQuery.m_dIndexHints.Add ( { sphGetDocidName(), SecondaryIndexType_e::LOOKUP, true } );
+
+	if ( tQuery.m_dFilterTree.IsEmpty() )
+		return;
+
+	int iRootNodeId = tQuery.m_dFilterTree.GetLength()-1;
+	FilterTreeItem_t & tItem = tQuery.m_dFilterTree.Add();
+	tItem.m_iFilterItem = iFilterId;
+
+	int iFilterNodeId = tQuery.m_dFilterTree.GetLength()-1;
+	FilterTreeItem_t & tAnd = tQuery.m_dFilterTree.Add();
+	tAnd.m_iLeft = iRootNodeId;
+	tAnd.m_iRight = iFilterNodeId;
+}
+
+// cut the part of LIMIT offset,count window which falls into the batch
+static void ApplyStreamWindow ( AggrResult_t & tRes, int64_t & iToSkip, int64_t & iToSend )
+{
+	auto iSkip = (int)Min ( iToSkip, (int64_t)tRes.m_iCount );
+	tRes.m_iOffset += iSkip;
+	tRes.m_iCount = (int)Min ( (int64_t)( tRes.m_iCount - iSkip ), iToSend );
+	iToSkip -= iSkip;
+	iToSend -= tRes.m_iCount;
+}
+
+static DocID_t GetStreamId ( const AggrResult_t & tRes, const CSphColumnInfo & tId, bool bLast )
+{
+	const auto & dMatches = tRes.m_dResults.First().m_dMatches;
+	return (DocID_t)( bLast ? dMatches.Last() : dMatches.First() ).GetAttr ( tId.m_tLocator );
+}
+
+// returns meta of the whole stream, for SHOW META
+static CSphQueryResultMeta StreamMysqlSelect ( RowBuffer_i & tOut, SqlStmt_t & tStmt, QueryProfile_c * pProfile, bool bFederatedUser, const CSphString * pFederatedQuery )
+{
+	CSphQueryResultMeta tMeta;
+	CSphString sError;
+	if ( !CheckStreamQuery ( tStmt, sError ) )
+	{
+		tMeta.m_sError = sError;
+		tOut.Error ( sError.cstr() );
+		return tMeta;
+	}
+
+	const CSphQuery & tStmtQuery = tStmt.m_tQuery;
+	int iBatchSize = tStmtQuery.m_bExplicitMaxMatches ? tStmtQuery.m_iMaxMatches : STREAM_BATCH_SIZE;
+
+	// without LIMIT clause the whole result set is streamed, not the default 20 rows
+	int64_t iToSkip = tStmtQuery.m_iOffset;
+	int64_t iToSend = tStmtQuery.m_bExplicitLimit && tStmtQuery.m_iLimit>=0 ? tStmtQuery.m_iLimit : INT64_MAX;
+
+	CSphQuery tBase = tStmtQuery;
+	tBase.m_eSort = SPH_SORT_EXTENDED;
+	tBase.m_sSortBy = tBase.m_sOrderBy = "id asc";
+	tBase.m_iOffset = 0;
+	tBase.m_iLimit = tBase.m_iMaxMatches = iBatchSize;
+	tBase.m_bExplicitMaxMatches = true;
+	tBase.m_iCutoff = -1;
+
+	// LIMIT window which fits into one batch is just a regular id-ordered select
+	bool bSingleBatch = iToSend<=iBatchSize-iToSkip;
+	if ( bSingleBatch )
+	{
+		tBase.m_iOffset = (int)iToSkip;
+		tBase.m_iLimit = (int)iToSend;
+	}
+
+	CSphBitvec tAttrsToSend;
+	StreamWindow_t tWindow;
+	int iSent = 0;
+	for ( int iBatch = 0; ; ++iBatch )
+	{
+		CSphQuery tQuery = tBase;
+		DocID_t tTo = 0;
+		if ( iBatch )
+		{
+			tTo = tWindow.GetTo();
+			AddStreamIdFilter ( tQuery, tWindow.m_tLast, tTo );
+		}
+
+		// first batch also fetches the max id, where the stream stops; same filters, so it's the same scan
+		bool bFetchMax = !iBatch && !bSingleBatch;
+		SearchHandler_c tHandler ( bFetchMax ? 2 : 1, sphCreatePlainQueryParser(), QUERY_SQL, true );
+		tHandler.SetQuery ( 0, tQuery, nullptr );
+		tHandler.SetJoinQueryOptions ( 0, tStmt.m_tJoinQueryOptions );
+		if ( bFetchMax )
+		{
+			CSphQuery tMaxQuery = tQuery;
+			tMaxQuery.m_sSortBy = tMaxQuery.m_sOrderBy = "id desc";
+			tMaxQuery.m_iLimit = tMaxQuery.m_iMaxMatches = 1;
+			tHandler.SetQuery ( 1, tMaxQuery, nullptr );
+			tHandler.SetJoinQueryOptions ( 1, tStmt.m_tJoinQueryOptions );
+		}
+
+		tHandler.m_pStmt = &tStmt;
+		if ( pProfile )
+			tHandler.SetProfile ( pProfile );
+		if ( bFederatedUser )
+			tHandler.SetFederatedUser();
+
+		if ( !HandleMysqlSelect ( tOut, tHandler ) )
+			return tHandler.m_dAggrResults.First();
+
+		AggrResult_t & tRes = tHandler.m_dAggrResults.First();
+		if ( !session::GetBuddy() )
+			gStats().AddDeltaDetailed ( SearchdStats_t::eSearch, tRes.GetLength(), tRes.GetQueryTimeUs() );
+
+		int iCount = tRes.m_iSuccesses ? tRes.GetLength() : 0;
+
+		// short first batch is just a regular result set
+		if ( !iBatch && ( bSingleBatch || iCount<iBatchSize ) )
+		{
+			if ( !bSingleBatch && tRes.m_iSuccesses )
+				ApplyStreamWindow ( tRes, iToSkip, iToSend );
+
+			SendMysqlSelectResult ( tOut, tRes, false, bFederatedUser, pFederatedQuery, pProfile );
+			return tRes;
+		}
+
+		if ( !tRes.m_iSuccesses )
+		{
+			// rows are already sent; the error packet terminates the result set
+			tOut.Error ( tRes.m_sError.IsEmpty() ? "stream: no results from the search" : tRes.m_sError.cstr() );
+			return tRes;
+		}
+
+		// select list is checked up front, so the id is there
+		const CSphColumnInfo * pId = tRes.m_tSchema.GetAttr ( sphGetDocidName() );
+		assert ( pId );
+
+		CSphScopedProfile tProf ( pProfile, SPH_QSTATE_NET_WRITE );
+		if ( !iBatch )
+		{
+			const AggrResult_t & tMaxRes = tHandler.m_dAggrResults[1];
+			const CSphColumnInfo * pMaxId = tMaxRes.m_tSchema.GetAttr ( sphGetDocidName() );
+			if ( !tMaxRes.m_iSuccesses || !tMaxRes.GetLength() || !pMaxId )
+			{
+				tOut.Error ( tMaxRes.m_sError.IsEmpty() ? "stream: failed to fetch max id" : tMaxRes.m_sError.cstr() );
+				return tMaxRes;
+			}
+
+			// first full batch tells the id density to start with
+			tWindow.m_tMax = GetStreamId ( tMaxRes, *pMaxId, false );
+			tWindow.m_tLast = GetStreamId ( tRes, *pId, true );
+			tWindow.m_uSpan = Max ( uint64_t ( tWindow.m_tLast ) - uint64_t ( GetStreamId ( tRes, *pId, false ) ), (uint64_t)1 );
+
+			tMeta = tRes;
+			sphGetAttrsToSend ( tRes.m_tSchema, false, true, tAttrsToSend );
+			SendMysqlSelectHeader ( tOut, tRes, tAttrsToSend, false, bFederatedUser );
+		} else
+		{
+			tMeta.AddQueryTimeUs ( tRes.GetQueryTimeUs() );
+			tMeta.m_iCpuTime += tRes.m_iCpuTime;
+			tMeta.m_iAgentCpuTime += tRes.m_iAgentCpuTime;
+
+			tWindow.Advance ( tTo, iCount, iBatchSize, iCount ? GetStreamId ( tRes, *pId, true ) : tTo );
+		}
+
+		ApplyStreamWindow ( tRes, iToSkip, iToSend );
+		if ( !SendMysqlSelectRows ( tOut, tRes, tAttrsToSend, bFederatedUser, pFederatedQuery ) || !tOut.FlushRows() )
+			return tMeta; // client is gone
+
+		iSent += tRes.m_iCount;
+		if ( !iToSend || tWindow.IsDone() )
+			break;
+	}
+
+	tMeta.m_iMatches = iSent;
+	tMeta.m_iTotalMatches = iSent;
+	tMeta.m_bTotalMatchesApprox = false;
+
+	CSphString sMeta = BuildMetaOneline ( tMeta );
+	tOut.Eof ( false, tMeta.m_sWarning.IsEmpty() ? 0 : 1, sMeta.cstr() );
+	return tMeta;
 }
 
 
@@ -8875,21 +9215,21 @@ static bool HandleSetGlobal ( CSphString & sError, const CSphString & sName, int
 
 	if ( sName == "qcache_max_bytes" )
 	{
-		const QcacheStatus_t& s = QcacheGetStatus();
+		QcacheStatus_t s = QcacheGetStatus();
 		QcacheSetup ( iSetValue, s.m_iThreshMs, s.m_iTtlS );
 		return true;
 	}
 
 	if ( sName == "qcache_thresh_msec" )
 	{
-		const QcacheStatus_t& s = QcacheGetStatus();
+		QcacheStatus_t s = QcacheGetStatus();
 		QcacheSetup ( s.m_iMaxBytes, (int)iSetValue, s.m_iTtlS );
 		return true;
 	}
 
 	if ( sName == "qcache_ttl_sec" )
 	{
-		const QcacheStatus_t& s = QcacheGetStatus();
+		QcacheStatus_t s = QcacheGetStatus();
 		QcacheSetup ( s.m_iMaxBytes, s.m_iThreshMs, (int)iSetValue );
 		return true;
 	}
@@ -9087,6 +9427,12 @@ static bool HandleSetGlobal ( CSphString & sError, const CSphString & sName, int
 		return true;
 	}
 
+	if ( sName == "minmax_pruning" )
+	{
+		SetMinMaxPruning ( !!iSetValue );
+		return true;
+	}
+
 	if ( sName == "secondary_indexes" )
 	{
 		SetSecondaryIndexDefault ( iSetValue != 0 ? SIDefault_e::ENABLED : SIDefault_e::DISABLED );
@@ -9885,6 +10231,7 @@ void HandleMysqlShowVariables ( RowBuffer_i & dRows, const SqlStmt_t & tStmt )
 		dTable.MatchTupletFn ( "last_insert_id" , [&pVars]  { return GetLastInsertId ( pVars ); } );
 	}
 	dTable.MatchTuplet ( "pseudo_sharding", GetPseudoSharding() ? "1" : "0" );
+	dTable.MatchTuplet ( "minmax_pruning", GetMinMaxPruning() ? "1" : "0" );
 
 	switch ( GetSecondaryIndexDefault() )
 	{
@@ -10088,6 +10435,10 @@ static void AddDiskIndexStatus ( VectorLike & dStatus, const CSphIndex * pIndex,
 		dStatus.MatchTupletf ( "ram_bytes_retired", "%l", tStatus.m_iRamRetired );
 		dStatus.MatchTupletf ( "optimizing", "%l", tStatus.m_iOptimizesCount );
 		dStatus.MatchTupletf ( "locked", "%d", tStatus.m_iLockCount );
+		dStatus.MatchTupletf ( "ram_segment_merges", "%l", tStatus.m_iRamSegmentMerges );
+		dStatus.MatchTupletf ( "ram_segment_merge_time", "%0.3F", tStatus.m_iRamSegmentMergeTimeUs / 1000 );
+		dStatus.MatchTupletf ( "ram_segment_merges_deferred", "%l", tStatus.m_iRamSegmentMergesDeferred );
+		dStatus.MatchTupletf ( "ram_write_amplification", "%0.2F", int64_t ( tStatus.m_fRamWriteAmplification * 100 ) );
 	}
 	if ( bPq )
 	{
@@ -11648,10 +11999,18 @@ bool ClientSession_c::Execute ( Str_t sQuery, RowBuffer_i & tOut )
 			}
 
 			StatCountCommand ( SEARCHD_COMMAND_SEARCH );
-			SearchHandler_c tHandler ( 1, sphCreatePlainQueryParser(), QUERY_SQL, true );
 			// no log for search queries from the buddy in the info verbosity
 			if ( session::IsQueryLogDisabled() )
 				dStmt.Begin()->m_tQuery.m_uDebugFlags |= QUERY_DEBUG_NO_LOG;
+
+			if ( dStmt.Begin()->m_tQuery.m_bStream )
+			{
+				m_tLastMeta = StreamMysqlSelect ( tOut, *dStmt.Begin(), ( tSess.IsProfile() ? &m_tProfile : nullptr ), m_bFederatedUser, &m_sFederatedQuery );
+				m_sError = m_tLastMeta.m_sError;
+				return true;
+			}
+
+			SearchHandler_c tHandler ( 1, sphCreatePlainQueryParser(), QUERY_SQL, true );
 			tHandler.SetQuery ( 0, dStmt.Begin()->m_tQuery, std::move ( dStmt.Begin()->m_pTableFunc ) );
 			tHandler.SetJoinQueryOptions ( 0, dStmt.Begin()->m_tJoinQueryOptions );
 			tHandler.m_pStmt = pStmt;
@@ -13142,6 +13501,14 @@ bool ConfigureDistributedIndex ( std::function<bool(const CSphString&)>&& fnChec
 	if ( !tIdx.m_iAgentRetryCount )
 		tIdx.m_iAgentRetryCount = g_iAgentRetryCount;
 
+	if ( hIndex ( "agent_hedge_rate" ) )
+	{
+		int iRate = hIndex["agent_hedge_rate"].intval ();
+		if ( iRate<0 || iRate>100 )
+			sphWarning ( "table '%s': agent_hedge_rate must be within 0..100, ignored", szIndexName );
+		else
+			tIdx.m_iHedgeRate = iRate;
+	}
 
 	// add remote agents
 	struct { const char* sSect; bool bBlh; bool bPrs; } dAgentVariants[] =
@@ -13155,7 +13522,7 @@ bool ConfigureDistributedIndex ( std::function<bool(const CSphString&)>&& fnChec
 	{
 		for ( CSphVariant * pAgentCnf = hIndex ( tAg.sSect ); pAgentCnf; pAgentCnf = pAgentCnf->m_pNext )
 		{
-			AgentOptions_t tAgentOptions { tAg.bBlh, tAg.bPrs, tIdx.m_eHaStrategy, tIdx.m_iAgentRetryCount, 0 };
+			AgentOptions_t tAgentOptions { tAg.bBlh, tAg.bPrs, tIdx.m_eHaStrategy, tIdx.m_iAgentRetryCount, 0, tIdx.m_iHedgeRate };
 			auto pAgent = ConfigureMultiAgent ( pAgentCnf->cstr(), szIndexName, tAgentOptions, sError, pWarnings );
 			if ( !pAgent )
 				return false;
@@ -13795,6 +14162,8 @@ void ShowHelp ()
 		"\t\t\t(default is manticore.conf)\n"
 		"--stop\t\t\tsend SIGTERM to currently running searchd\n"
 		"--stopwait\t\tsend SIGTERM and wait until actual exit\n"
+		"--hot-restart\t\ttake listening sockets over from the running searchd\n"
+		"\t\t\tand make it stop, without refusing connections\n"
 		"--status\t\tget ant print status variables\n"
 		"\t\t\t(PID is taken from pid_file specified in config file)\n"
 		"--iostats\t\tlog per-query io stats\n"
@@ -14253,6 +14622,7 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bNeedPIDFile, bool bTestM
 	g_iMaxConnection = hSearchd.GetInt ( "max_connections", g_iMaxConnection );
 	auto iThreads = hSearchd.GetInt ( "threads", GetNumLogicalCPUs() );
 	SetMaxChildrenThreads ( iThreads );
+	SetWorkStealing ( hSearchd.GetBool ( "work_stealing", false ) );
 	int iDefaultParallelMerges = Max ( 1, Min ( 2, iThreads / 2 ) );
 	g_iParallelChunkMerges = Max ( 1, hSearchd.GetInt ( "parallel_chunk_merges", iDefaultParallelMerges ) );
 	g_iMergeChunksPerJob = Max ( 2, hSearchd.GetInt ( "merge_chunks_per_job", 2 ) );
@@ -14275,6 +14645,7 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bNeedPIDFile, bool bTestM
 
 	// initialize buffering settings
 	SetUnhintedBuffer ( hSearchd.GetSize( "read_unhinted", DEFAULT_READ_UNHINTED ) );
+	SetReadPrefetch ( hSearchd.GetBool ( "read_prefetch", false ) );
 	int iReadBuffer = hSearchd.GetSize ( "read_buffer", DEFAULT_READ_BUFFER );
 	FileAccessSettings_t & tDefaultFA = MutableIndexSettings_c::GetDefaults().m_tFileAccess;
 	tDefaultFA.m_iReadBufferDocList = hSearchd.GetSize ( "read_buffer_docs", iReadBuffer );
@@ -14335,6 +14706,14 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bNeedPIDFile, bool bTestM
 	g_iMaxBatchQueries = hSearchd.GetInt ( "max_batch_queries", g_iMaxBatchQueries );
 	g_iDistThreads = hSearchd.GetInt ( "max_threads_per_query", g_iDistThreads );
 	sphSetThrottling ( hSearchd.GetInt ( "rt_merge_iops", 0 ), hSearchd.GetSize ( "rt_merge_maxiosize", 0 ) );
+	if ( hSearchd.Exists ( "rt_merge_policy" ) )
+	{
+		RtMergePolicy_e eMergePolicy;
+		if ( ParseRtMergePolicy ( hSearchd["rt_merge_policy"].strval(), eMergePolicy ) )
+			SetRtMergePolicy ( eMergePolicy );
+		else
+			sphWarning ( "unknown rt_merge_policy '%s', progression will be used", hSearchd["rt_merge_policy"].cstr() );
+	}
 	g_iPingIntervalUs = hSearchd.GetUsTime64Ms ( "ha_ping_interval", 1000000 );
 	g_uHAPeriodKarmaS = hSearchd.GetSTimeS ( "ha_period_karma", 60 );
 	g_iQueryLogMinMs = hSearchd.GetMsTimeMs ( "query_log_min_msec", g_iQueryLogMinMs );
@@ -14347,6 +14726,9 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bNeedPIDFile, bool bTestM
 	g_iAgentRetryCount = hSearchd.GetInt ( "agent_retry_count", g_iAgentRetryCount );
 	if ( g_iAgentRetryCount > DAEMON_MAX_RETRY_COUNT )
 		sphWarning ( "agent_retry_count %d exceeded max recommended %d", g_iAgentRetryCount, DAEMON_MAX_RETRY_COUNT );
+	if ( hSearchd("agent_compression") && !ParseAgentCompression ( hSearchd["agent_compression"].cstr(), g_eAgentCompression ) )
+		sphWarning ( "unknown agent_compression '%s', compression disabled", hSearchd["agent_compression"].cstr() );
+	g_iAgentCompressionThreshold = hSearchd.GetSize ( "agent_compression_threshold", g_iAgentCompressionThreshold );
 
 	g_iReplConnectTimeoutMs = hSearchd.GetMsTimeMs ( "replication_connect_timeout", g_iReplConnectTimeoutMs );
 	g_iReplQueryTimeoutMs = hSearchd.GetMsTimeMs ( "replication_query_timeout", g_iReplQueryTimeoutMs );
@@ -14484,6 +14866,7 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bNeedPIDFile, bool bTestM
 	MutableIndexSettings_c::GetDefaults().m_iOptimizeCutoffKNN = hSearchd.GetInt ( "optimize_cutoff", AutoOptimizeCutoffKNN() );
 
 	SetPseudoSharding ( hSearchd.GetInt ( "pseudo_sharding", 1 )!=0 );
+	SetMinMaxPruning ( hSearchd.GetInt ( "minmax_pruning", 1 )!=0 );
 	SetOptionSI ( hSearchd, bTestMode );
 	SetSIBlockCacheSize ( hSearchd.GetSize64 ( "secondary_index_block_cache", GetSIBlockCacheSize() ) );
 
@@ -14504,6 +14887,7 @@ void ConfigureSearchd ( const CSphConfig & hConf, bool bNeedPIDFile, bool bTestM
 
 	ConfigureMerge(hSearchd);
 	SetJoinBatchSize ( hSearchd.GetInt ( "join_batch_size", GetJoinBatchSize() ) );
+	SetJoinHashThreshold ( hSearchd.GetSize64 ( "join_hash_threshold", GetJoinHashThreshold() ) );
 	SetRtFlushDiskPeriod ( hSearchd.GetSTimeS ( "diskchunk_flush_write_timeout", bTestMode ? -1 : 1 ), hSearchd.GetSTimeS ( "diskchunk_flush_search_timeout", 30 ) );
 
 	int iExpansionPhraseLimit = hSearchd.GetInt ( "expansion_phrase_limit", 1024 );
@@ -14982,6 +15366,57 @@ static void CheckSSL()
 }
 
 
+static CSphVector<ListenerDesc_t> CreateListeners ( const CSphConfigSection & hSearchd, bool bOptListen, const CSphString & sOptListen, bool bOptPort, int iOptPort ) REQUIRES ( MainThread )
+{
+	CSphVector<ListenerDesc_t> dListenerDescs;
+
+	// command line arguments override config (but only in --console)
+	if ( bOptListen )
+	{
+		auto tDesc = ParseListener ( sOptListen.cstr() );
+		dListenerDescs.Add ( tDesc );
+		AddGlobalListener ( tDesc );
+	} else if ( bOptPort )
+	{
+		AddGlobalListener ( MakeAnyListener ( iOptPort ) );
+	} else
+	{
+		// listen directives in configuration file
+		for ( CSphVariant * v = hSearchd("listen"); v; v = v->m_pNext )
+		{
+			auto tDesc = ParseListener ( v->cstr () );
+			dListenerDescs.Add ( tDesc );
+			AddGlobalListener ( tDesc );
+		}
+
+		// default is to listen on our two ports
+		if ( g_dListeners.IsEmpty() )
+		{
+			AddGlobalListener ( MakeLocalhostListener ( SPHINXAPI_PORT, Proto_e::SPHINX ) );
+			AddGlobalListener ( MakeLocalhostListener ( SPHINXQL_PORT, Proto_e::MYSQL41 ) );
+		}
+	}
+
+	// listeners removed from the config while restarting
+	hotrestart::CloseUnused();
+
+	CSphString sError;
+	if ( !ValidateListenerRanges ( dListenerDescs, sError ) )
+		sphFatal ( "%s", sError.cstr() );
+
+	CSphString sSslCert ( hSearchd.GetStr ( "ssl_cert" ) );
+	CSphString sSslKey ( hSearchd.GetStr ( "ssl_key" ) );
+	CSphString sSslCa ( hSearchd.GetStr ( "ssl_ca" ) );
+	FixPathAbsolute ( sSslCert );
+	FixPathAbsolute ( sSslKey );
+	FixPathAbsolute ( sSslCa );
+	SetServerSSLKeys ( sSslCert, sSslKey, sSslCa );
+	CheckSSL();
+
+	return dListenerDescs;
+}
+
+
 static void CacheCPUInfo()
 {
 	// these funcs do caching inside
@@ -15084,6 +15519,7 @@ int WINAPI ServiceMain ( int argc, char **argv ) EXCLUDES (MainThread)
 	bool			bForcePseudoSharding = false;
 	const char*		szCmdConfigFile = nullptr;
 	bool			bMeasureStack = false;
+	bool			bOptHotRestart = false;
 
 	DWORD			uReplayFlags = 0;
 
@@ -15113,6 +15549,7 @@ int WINAPI ServiceMain ( int argc, char **argv ) EXCLUDES (MainThread)
 		OPT1 ( "--stop" )			bOptStop = true;
 		OPT1 ( "--stopwait" )		{ bOptStop = true; bOptStopWait = true; }
 		OPT1 ( "--status" )			bOptStatus = true;
+		OPT1 ( "--hot-restart" )	bOptHotRestart = true;
 		OPT1 ( "--pidfile" )		bNeedPIDFile = true;
 		OPT1 ( "--iostats" )		SetIOStats();
 		OPT1 ( "--cpustats" )		SetCPUStats();
@@ -15340,10 +15777,24 @@ int WINAPI ServiceMain ( int argc, char **argv ) EXCLUDES (MainThread)
 		if ( g_iPidFD<0 )
 			sphFatal ( "failed to create pid file '%s': %s", g_sPidFile.scstr(), strerrorm(errno) );
 	}
-	if ( bHasPIDFile && !sphLockEx ( g_iPidFD, false ) )
+	// the running instance keeps serving (and holding the pid file) while we load the tables it released
+	bool bHotRestart = false;
+	if ( bOptHotRestart && bVisualLoad )
+	{
+		if ( !bHasPIDFile )
+			sphFatal ( "--hot-restart requires pid_file" );
+
+		bHotRestart = hotrestart::Prepare ( g_sPidFile, sError );
+		if ( bHotRestart )
+			sphInfo ( "hot restart: running instance released its tables, loading them while it serves" );
+		else
+			sphWarning ( "hot restart: %s; starting normally", sError.cstr() );
+	}
+
+	if ( !bHotRestart && bHasPIDFile && !sphLockEx ( g_iPidFD, false ) )
 		sphFatal ( "failed to lock pid file '%s': %s (searchd already running?)", g_sPidFile.scstr(), strerrorm(errno) );
 
-	g_bPidIsMine = true;
+	g_bPidIsMine = !bHotRestart;
 
 	// Actions on resurrection
 	if ( bWatched && !bVisualLoad )
@@ -15430,46 +15881,10 @@ int WINAPI ServiceMain ( int argc, char **argv ) EXCLUDES (MainThread)
 	////////////////////
 	// network startup
 	////////////////////
+	// on hot restart the addresses are still served by the running instance; its sockets come after the tables are loaded
 	CSphVector<ListenerDesc_t> dListenerDescs;
-
-	// command line arguments override config (but only in --console)
-	if ( bOptListen )
-	{
-		auto tDesc = ParseListener ( sOptListen.cstr() );
-		dListenerDescs.Add ( tDesc );
-		AddGlobalListener ( tDesc );
-	} else if ( bOptPort )
-	{
-		AddGlobalListener ( MakeAnyListener ( iOptPort ) );
-	} else
-	{
-		// listen directives in configuration file
-		for ( CSphVariant * v = hSearchd("listen"); v; v = v->m_pNext )
-		{
-			auto tDesc = ParseListener ( v->cstr () );
-			dListenerDescs.Add ( tDesc );
-			AddGlobalListener ( tDesc );
-		}
-
-		// default is to listen on our two ports
-		if ( g_dListeners.IsEmpty() )
-		{
-			AddGlobalListener ( MakeLocalhostListener ( SPHINXAPI_PORT, Proto_e::SPHINX ) );
-			AddGlobalListener ( MakeLocalhostListener ( SPHINXQL_PORT, Proto_e::MYSQL41 ) );
-		}
-	}
-
-	if ( !ValidateListenerRanges ( dListenerDescs, sError ) )
-		sphFatal ( "%s", sError.cstr() );
-
-	CSphString sSslCert ( hSearchd.GetStr ( "ssl_cert" ) );
-	CSphString sSslKey ( hSearchd.GetStr ( "ssl_key" ) );
-	CSphString sSslCa ( hSearchd.GetStr ( "ssl_ca" ) );
-	FixPathAbsolute ( sSslCert );
-	FixPathAbsolute ( sSslKey );
-	FixPathAbsolute ( sSslCa );
-	SetServerSSLKeys ( sSslCert, sSslKey, sSslCa );
-	CheckSSL();
+	if ( !bHotRestart )
+		dListenerDescs = CreateListeners ( hSearchd, bOptListen, sOptListen, bOptPort, iOptPort );
 
 	// set up ping service (if necessary) before loading indexes
 	// (since loading ha-mirrors of distributed already assumes ping is usable).
@@ -15507,6 +15922,21 @@ int WINAPI ServiceMain ( int argc, char **argv ) EXCLUDES (MainThread)
 		ConfigureAndPreloadOnStartup ( hConf, dExactIndexes );
 	} );
 
+	// tables are loaded; only now the running instance stops accepting and hands its sockets over.
+	// it releases the pid file once it has stopped
+	if ( bHotRestart )
+	{
+		if ( !hotrestart::TakeOver ( sError ) )
+			sphFatal ( "hot restart: %s", sError.cstr() );
+
+		sphInfo ( "hot restart: took listening sockets over, waiting for the running instance to stop" );
+		if ( !hotrestart::LockPidFile ( g_iPidFD, g_sPidFile, sError ) )
+			sphFatal ( "%s", sError.cstr() );
+
+		g_bPidIsMine = true;
+		dListenerDescs = CreateListeners ( hSearchd, bOptListen, sOptListen, bOptPort, iOptPort );
+	}
+
 	///////////
 	// startup
 	///////////
@@ -15581,18 +16011,8 @@ int WINAPI ServiceMain ( int argc, char **argv ) EXCLUDES (MainThread)
 			sphFatal ( "failed to re-lock pid file '%s': %s", g_sPidFile.scstr(), strerrorm(errno) );
 #endif
 
-		char sPid[16];
-		snprintf ( sPid, sizeof(sPid), "%d\n", (int)getpid() );
-		auto iPidLen = (int) strlen(sPid);
-
-		sphSeek ( g_iPidFD, 0, SEEK_SET );
-		if ( !sphWrite ( g_iPidFD, sPid, iPidLen ) )
-			sphFatal ( "failed to write to pid file '%s' (errno=%d, msg=%s)", g_sPidFile.scstr(),
-				errno, strerrorm(errno) );
-
-		if ( ::ftruncate ( g_iPidFD, iPidLen ) )
-			sphFatal ( "failed to truncate pid file '%s' (errno=%d, msg=%s)", g_sPidFile.scstr(),
-				errno, strerrorm(errno) );
+		if ( !WritePidFile ( g_iPidFD, g_sPidFile, sError ) )
+			sphFatal ( "%s", sError.cstr() );
 	}
 
 #if _WIN32
@@ -15722,6 +16142,9 @@ int WINAPI ServiceMain ( int argc, char **argv ) EXCLUDES (MainThread)
 		g_pTickPoolThread->Schedule ( [pNetLoop] { ScopedRole_c thPoll ( NetPoollingThread ); pNetLoop->LoopNetPoll (); }, false );
 	}
 
+	// from now on a new instance may take our listeners over
+	hotrestart::StartService ( g_sPidFile, g_dListeners, !g_bOptNoLock );
+
 	// until no threads started, schedule stopping of alone threads to very bottom
 	WipeGlobalSchedulerOnShutdownAndFork();
 	Detached::MakeAloneIteratorAvailable ();
@@ -16,6 +16,7 @@
 #include "sphinxstd.h"
 #include "searchdaemon.h"
 #include "coroutine.h"
+#include "binlog.h"
 
 #if _WIN32
 	#define USE_PSI_INTERFACE 1
@@ -248,6 +249,43 @@ void VectorLike::FillTail ( int iHas )
 }
 
 
+// times are in seconds, as the *_wall ones ('%0.3F' prints value/1000)
+void BinlogFsyncStatus ( VectorLike & dStatus, const Binlog::FsyncStats_t & tStats )
+{
+	auto iFsyncsDiv = Max ( tStats.m_iFsyncs, 1 );
+	dStatus.MatchTuplet ( "binlog_group_commit", tStats.m_bGroupCommit ? "ON" : "OFF" );
+	dStatus.MatchTupletf ( "binlog_fsyncs", "%l", tStats.m_iFsyncs );
+	dStatus.MatchTupletf ( "binlog_fsync_txns", "%l", tStats.m_iTxns );
+	dStatus.MatchTupletf ( "binlog_avg_fsync_batch", "%0.2F", tStats.m_iTxns * 100 / iFsyncsDiv );
+	dStatus.MatchTupletf ( "binlog_fsync_time", "%0.3F", tStats.m_iTimeUs / 1000 );
+	dStatus.MatchTupletf ( "binlog_avg_fsync_time", "%0.3F", tStats.m_iTimeUs / ( iFsyncsDiv * 1000 ) );
+	dStatus.MatchTupletf ( "binlog_max_fsync_time", "%0.3F", tStats.m_iMaxTimeUs / 1000 );
+}
+
+
+bool WritePidFile ( int iPidFD, const CSphString & sPidFile, CSphString & sError )
+{
+	char sPid[16];
+	snprintf ( sPid, sizeof(sPid), "%d\n", (int)getpid() );
+	auto iPidLen = (int) strlen(sPid);
+
+	sphSeek ( iPidFD, 0, SEEK_SET );
+	if ( !sphWrite ( iPidFD, sPid, iPidLen ) )
+	{
+		sError.SetSprintf ( "failed to write to pid file '%s' (errno=%d, msg=%s)", sPidFile.scstr(), errno, strerrorm(errno) );
+		return false;
+	}
+
+	if ( ::ftruncate ( iPidFD, iPidLen ) )
+	{
+		sError.SetSprintf ( "failed to truncate pid file '%s' (errno=%d, msg=%s)", sPidFile.scstr(), errno, strerrorm(errno) );
+		return false;
+	}
+
+	return true;
+}
+
+
 const char* GetIndexTypeName ( IndexType_e eType )
 {
 	switch ( eType )
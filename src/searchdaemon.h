@@ -135,7 +135,7 @@ const char* szCommand ( int );
 /// master-agent API SEARCH command protocol extensions version
 enum
 {
-	VER_COMMAND_SEARCH_MASTER = 29
+	VER_COMMAND_SEARCH_MASTER = 30
 };
 
 
@@ -236,6 +236,14 @@ public:
 	void MatchTupletFn ( const char * sKey, GeneratorS_fn && fnValuePrinter );
 };
 
+namespace Binlog { struct FsyncStats_t; }
+
+/// binlog fsync counters of 'show status'
+void BinlogFsyncStatus ( VectorLike & dStatus, const Binlog::FsyncStats_t & tStats );
+
+/// write our pid into the (locked) pid file, replacing whatever was there
+bool WritePidFile ( int iPidFD, const CSphString & sPidFile, CSphString & sError );
+
 const char* GetIndexTypeName ( IndexType_e eType );
 IndexType_e TypeOfIndexConfig ( const CSphString & sType );
 
@@ -1564,6 +1572,9 @@ public:
 
 	virtual bool SomethingWasSent() { return false; }
 
+	// sends rows committed so far, if the protocol allows a result set to go in parts (streamed select)
+	virtual bool FlushRows() { return true; }
+
 	// common implementations
 	void PutArray ( const StringBuilder_c & dData, bool bSendEmpty=true )
 	{
@@ -275,6 +275,7 @@ bool IndexDescDistr_t::Parse ( const bson::Bson_c& tBson, CSphString& sWarning )
 	m_iAgentConnectTimeout = Int ( tBson.ChildByName( "agent_connect_timeout" ));
 	m_iAgentQueryTimeout = Int ( tBson.ChildByName ( "agent_query_timeout" ) );
 	m_iAgentRetryCount = Int ( tBson.ChildByName ( "agent_retry_count" ) );
+	m_iHedgeRate = Int ( tBson.ChildByName ( "agent_hedge_rate" ) );
 	m_bDivideRemoteRanges = Bool ( tBson.ChildByName ( "divide_remote_ranges" ) );
 	m_sHaStrategy = String ( tBson.ChildByName ( "ha_strategy" ), {} );
 	return true;
@@ -308,6 +309,7 @@ void IndexDescDistr_t::Save ( JsonEscapedBuilder& tOut ) const
 	tOut.NamedValNonDefault ( "agent_connect_timeout", m_iAgentConnectTimeout, 0 );
 	tOut.NamedValNonDefault ( "agent_query_timeout", m_iAgentQueryTimeout, 0 );
 	tOut.NamedValNonDefault ( "agent_retry_count", m_iAgentRetryCount, 0 );
+	tOut.NamedValNonDefault ( "agent_hedge_rate", m_iHedgeRate, 0 );
 	tOut.NamedVal ( "divide_remote_ranges", m_bDivideRemoteRanges );
 	tOut.NamedStringNonDefault ( "ha_strategy", m_sHaStrategy, {} );
 }
@@ -337,6 +339,8 @@ void IndexDescDistr_t::Save ( CSphConfigSection & hIndex ) const
 		hIndex.AddEntry ( "agent_query_timeout",	sTmp.SetSprintf ( "%d", m_iAgentQueryTimeout ).cstr() );
 	if ( m_iAgentRetryCount > 0 )
 		hIndex.AddEntry ( "agent_retry_count",		sTmp.SetSprintf ( "%d", m_iAgentRetryCount ).cstr() );
+	if ( m_iHedgeRate > 0 )
+		hIndex.AddEntry ( "agent_hedge_rate",		sTmp.SetSprintf ( "%d", m_iHedgeRate ).cstr() );
 
 	hIndex.AddEntry ( "divide_remote_ranges",	m_bDivideRemoteRanges ? "1" : "0" );
 
@@ -1302,6 +1306,9 @@ CSphString BuildCreateTableDistr ( const CSphString & sName, const DistributedIn
 	if ( tDistr.m_iAgentRetryCount!=pDefault->m_iAgentRetryCount )
 		sRes << sOpt.SetSprintf ( "agent_retry_count='%d'", tDistr.m_iAgentRetryCount );
 
+	if ( tDistr.m_iHedgeRate!=pDefault->m_iHedgeRate )
+		sRes << sOpt.SetSprintf ( "agent_hedge_rate='%d'", tDistr.m_iHedgeRate );
+
 	if ( tDistr.m_bDivideRemoteRanges!=pDefault->m_bDivideRemoteRanges )
 		sRes << sOpt.SetSprintf ( "divide_remote_ranges='%d'", tDistr.m_bDivideRemoteRanges ? 1 : 0 );
 
@@ -1712,6 +1719,7 @@ IndexDescDistr_t GetDistributedDesc ( const DistributedIndex_t & tDist )
 	tIndex.m_iAgentConnectTimeout	= tDist.GetAgentConnectTimeoutMs ( true );
 	tIndex.m_iAgentQueryTimeout		= tDist.GetAgentQueryTimeoutMs ( true );
 	tIndex.m_iAgentRetryCount		= tDist.m_iAgentRetryCount;
+	tIndex.m_iHedgeRate				= tDist.m_iHedgeRate;
 	tIndex.m_bDivideRemoteRanges	= tDist.m_bDivideRemoteRanges;
 	tIndex.m_sHaStrategy			= HAStrategyToStr ( tDist.m_eHaStrategy );
 
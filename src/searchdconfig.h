@@ -65,6 +65,7 @@ struct IndexDescDistr_t
 	int				m_iAgentConnectTimeout = 0;
 	int				m_iAgentQueryTimeout = 0;
 	int				m_iAgentRetryCount = 0;
+	int				m_iHedgeRate = 0;
 	bool			m_bDivideRemoteRanges = false;
 	CSphString		m_sHaStrategy;
 
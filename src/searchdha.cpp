@@ -18,9 +18,11 @@
 #include "coroutine.h"
 #include "pollable_event.h"
 #include "netpoll.h"
+#include "compressed_api.h"
 
 #include <utility>
 #include <atomic>
+#include <algorithm>
 #include <errno.h>
 
 #if !_WIN32
@@ -151,6 +153,30 @@ void HostDashboard_t::GetCollectedMetrics ( HostMetricsSnapshot_t& dResult, int
 		dResult[i+eMaxAgentStat] = tAccum.m_dMetrics[i];
 }
 
+// collect the answer time; p95 is recalculated every few answers once the window is warm enough to be meaningful
+void HostDashboard_t::AddLatency ( int64_t iLatencyUS )
+{
+	constexpr int MIN_SAMPLES = 32;
+	constexpr int RECALC_EACH = 8;
+
+	int64_t dWindow[LATENCY_WINDOW];
+	int iSamples;
+	{
+		ScWL_t tWguard ( m_dMetricsLock );
+		m_dLatenciesUS[m_iLatencies % LATENCY_WINDOW] = iLatencyUS;
+		++m_iLatencies;
+		if ( m_iLatencies<MIN_SAMPLES || m_iLatencies % RECALC_EACH )
+			return;
+
+		iSamples = (int)Min ( m_iLatencies, (int64_t)LATENCY_WINDOW );
+		memcpy ( dWindow, m_dLatenciesUS, iSamples*sizeof(dWindow[0]) );
+	}
+
+	auto * pP95 = dWindow + iSamples*95/100;
+	std::nth_element ( dWindow, pP95, dWindow+iSamples );
+	m_iP95LatencyUS.store ( *pP95, std::memory_order_relaxed );
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // PersistentConnectionsPool_c
 //
@@ -585,12 +611,13 @@ CSphString MultiAgentDesc_c::GetKey ( const CSphVector<AgentDesc_t *> &dTemplate
 	StringBuilder_c sKey;
 	for ( const auto* dHost : dTemplateHosts )
 		sKey << dHost->GetMyUrl () << ":" << dHost->m_sIndexes << "|";
-	sKey.Sprintf("[%d,%d,%d,%d,%d]",
+	sKey.Sprintf("[%d,%d,%d,%d,%d,%d]",
 		tOpt.m_bBlackhole?1:0,
 		tOpt.m_bPersistent?1:0,
 		(int)tOpt.m_eStrategy,
 		tOpt.m_iRetryCount,
-		tOpt.m_iRetryCountMultiplier);
+		tOpt.m_iRetryCountMultiplier,
+		tOpt.m_iHedgeRate);
 	return sKey.cstr();
 }
 
@@ -622,6 +649,7 @@ bool MultiAgentDesc_c::Init ( const CSphVector<AgentDesc_t *> &dHosts,
 	// initialize options
 	m_eStrategy = tOpt.m_eStrategy;
 	m_iMultiRetryCount = tOpt.m_iRetryCount * tOpt.m_iRetryCountMultiplier;
+	m_iHedgeRate = tOpt.m_iHedgeRate;
 	m_sConfigStr = tWarn.m_szAgent;
 
 	// initialize hosts & weights
@@ -950,6 +978,51 @@ const AgentDesc_t &MultiAgentDesc_c::ChooseAgent ()
 	}
 }
 
+// the mirror chosen by the strategy, but never the host which is already slow
+const AgentDesc_t * MultiAgentDesc_c::ChooseHedgeAgent ( const AgentDesc_t & tBusy )
+{
+	if ( !IsHA() )
+		return nullptr;
+
+	const AgentDesc_t & tChosen = ChooseAgent();
+	if ( tChosen.m_pDash!=tBusy.m_pDash )
+		return &tChosen;
+
+	int iStart = int ( &tChosen - m_pData );
+	for ( int i = 1; i<GetLength(); ++i )
+	{
+		const AgentDesc_t & tNext = m_pData[( iStart+i ) % GetLength()];
+		if ( tNext.m_pDash!=tBusy.m_pDash )
+			return &tNext;
+	}
+	return nullptr;
+}
+
+// hedges are paid from a budget which queries refill; burst is limited to HEDGE_BURST hedges in a row
+static constexpr int HEDGE_COST = 100;
+static constexpr int HEDGE_BURST = 10;
+
+void MultiAgentDesc_c::EarnHedge ()
+{
+	auto iBudget = m_iHedgeBudget.load ( std::memory_order_relaxed );
+	do
+	{
+		if ( iBudget>=HEDGE_COST*HEDGE_BURST )
+			return;
+	} while ( !m_iHedgeBudget.compare_exchange_weak ( iBudget, Min ( iBudget+m_iHedgeRate, HEDGE_COST*HEDGE_BURST ), std::memory_order_relaxed ) );
+}
+
+bool MultiAgentDesc_c::SpendHedge ()
+{
+	auto iBudget = m_iHedgeBudget.load ( std::memory_order_relaxed );
+	do
+	{
+		if ( iBudget<HEDGE_COST )
+			return false;
+	} while ( !m_iHedgeBudget.compare_exchange_weak ( iBudget, iBudget-HEDGE_COST, std::memory_order_relaxed ) );
+	return true;
+}
+
 const char * Agent_e_Name ( Agent_e eState )
 {
 	switch ( eState )
@@ -1673,6 +1746,9 @@ void AgentConn_t::Finish ( bool bFail )
 	sphLogDebugA ( "%d Abort all callbacks ref=%d", m_iStoreTag, ( int ) GetRefcount () );
 	LazyDeleteOrChange (); // remove timer and all callbacks, if any
 	m_pPollerTask = nullptr;
+	m_iHedgeUS = 0;
+	if ( m_pHedge )
+		CancelHedge ();
 
 	if ( m_iSock>=0 && ( bFail || !IsPersistent() ) )
 	{
@@ -1775,7 +1851,107 @@ bool AgentConn_t::SwitchBlackhole ()
 // initialize read/write task
 void AgentConn_t::ScheduleCallbacks ()
 {
-	LazyTask ( m_iPoolerTimeoutUS, m_iPoolerTimeoutPeriodUS, true, BYTE ( m_dIOVec.HasUnsent () ? 1 : 2 ) );
+	BYTE uIO = m_dIOVec.HasUnsent () ? 1 : 2;
+	if ( m_iHedgeUS )
+		LazyTask ( m_iHedgeUS, Max ( m_iHedgeUS-MonoMicroTimer(), (int64_t)1 ), TIMEOUT_HEDGE, uIO );
+	else
+		LazyTask ( m_iPoolerTimeoutUS, m_iPoolerTimeoutPeriodUS, TIMEOUT_HARD, uIO );
+}
+
+/// the request is sent; if the mirror is slower than its usual p95, we'll send a copy to another mirror
+void AgentConn_t::ArmHedge ()
+{
+#if !_WIN32 // overlapped recv is bound to the poller task, which is dropped when the hedge timer fires
+	if ( !m_bHedge || m_bHedged || !m_pMultiAgent || !m_pMultiAgent->CanHedge() || !m_pReporter )
+		return;
+
+	m_pMultiAgent->EarnHedge ();
+	int64_t iP95 = m_tDesc.m_pDash->GetP95LatencyUS ();
+	if ( !iP95 || !m_iStartQuery )
+		return;
+
+	int64_t iDelayUS = Max ( iP95 - ( sphMicroTimer () - m_iStartQuery ), (int64_t)1 );
+	int64_t iHedgeUS = MonoMicroTimer () + iDelayUS;
+	if ( iHedgeUS>=m_iPoolerTimeoutUS )
+		return;
+
+	sphLogDebugA ( "%d hedge armed in " INT64_FMT " us", m_iStoreTag, iDelayUS );
+	m_iHedgeUS = iHedgeUS;
+	if ( m_pPollerTask )
+	{
+		m_eTimeoutKind = TIMEOUT_HEDGE;
+		LazyDeleteOrChange ( m_iHedgeUS, iDelayUS );
+	}
+#endif
+}
+
+/// send a copy of the request to another mirror; whoever answers first wins
+void AgentConn_t::StartHedge ()
+{
+	const AgentDesc_t * pMirror = m_pMultiAgent->ChooseHedgeAgent ( m_tDesc );
+	if ( !pMirror || !m_pMultiAgent->SpendHedge () )
+		return;
+
+	m_bHedged = true;
+	m_tDesc.m_pDash->m_iHedged.fetch_add ( 1, std::memory_order_relaxed );
+
+	m_pHedge = new AgentConn_t;
+	m_pHedge->m_tDesc.CloneFrom ( *pMirror );
+	m_pHedge->m_iMyConnectTimeoutMs = m_iMyConnectTimeoutMs;
+	m_pHedge->m_iMyQueryTimeoutMs = m_iMyQueryTimeoutMs;
+	m_pHedge->m_iStoreTag = m_iStoreTag;
+	m_pHedge->m_iWeight = m_iWeight;
+	m_pHedge->m_bHedge = true;
+	m_pHedge->m_bReplyLimitSize = m_bReplyLimitSize;
+	m_pHedge->m_pBuilder = m_pBuilder;
+	m_pHedge->m_iRetries = 0; // one try, no mirror switching
+	m_pHedge->m_pHedgeOf = this;
+	AddRef ();
+
+	sphLogDebugA ( "%d hedged to %s", m_iStoreTag, pMirror->GetMyUrl ().cstr () );
+	m_pHedge->SetNetLoop ();
+	m_pHedge->StartRemoteLoopTry ();
+}
+
+/// we're done (answered or failed); drop the copy
+void AgentConn_t::CancelHedge ()
+{
+	CSphRefcountedPtr<AgentConn_t> pHedge { std::move ( m_pHedge ) };
+	pHedge->m_pHedgeOf = nullptr;
+	if ( pHedge->m_iSock>=0 || pHedge->m_pPollerTask )
+		pHedge->Finish ( true );
+}
+
+/// the copy answered first: finish the primary's slow attempt and commit our reply in its place
+bool AgentConn_t::CommitHedge ()
+{
+	CSphRefcountedPtr<AgentConn_t> pPrimary { std::move ( m_pHedgeOf ) };
+	CSphRefcountedPtr<AgentConn_t> pKeepMe { std::move ( pPrimary->m_pHedge ) };
+	assert ( pKeepMe==this );
+	Finish ();
+	m_tDesc.m_pDash->m_iHedgeWins.fetch_add ( 1, std::memory_order_relaxed );
+
+	// primary's wall time runs until we started, ours continues it
+	auto iPrimaryStart = std::exchange ( pPrimary->m_iStartQuery, 0 );
+	pPrimary->Finish ( true );
+	if ( iPrimaryStart )
+	{
+		pPrimary->m_tDesc.m_pDash->AddLatency ( sphMicroTimer () - iPrimaryStart ); // lower bound, but still better than nothing
+		pPrimary->m_iWall += m_iStartQuery - iPrimaryStart;
+	}
+
+	pPrimary->m_tDesc.CloneFrom ( m_tDesc );
+	pPrimary->m_tDesc.m_bPersistent = false; // our socket is already back in the pool
+	pPrimary->m_iStartQuery = m_iStartQuery;
+	pPrimary->m_dReplyBuf.SwapData ( m_dReplyBuf );
+	pPrimary->m_iReplySize = m_iReplySize;
+	pPrimary->m_eReplyStatus = m_eReplyStatus;
+
+	if ( pPrimary->CommitResult () )
+		pPrimary->ReportFinish ( true );
+	else
+		pPrimary->StartRemoteLoopTry ();
+	return true;
 }
 
 void FirePoller (); // forward definition
@@ -1808,6 +1984,12 @@ void AgentConn_t::TimeoutCallback ()
 			StartRemoteLoopTry ();
 			sphLogDebugA ( "%d <- hard timeout (ref=%d)", m_iStoreTag, ( int ) GetRefcount () );
 			break;
+		case TIMEOUT_HEDGE:
+			m_iHedgeUS = 0;
+			StartHedge ();
+			ScheduleCallbacks (); // fired timer took the poller task away; keep waiting for the answer until the hard timeout
+			sphLogDebugA ( "%d <- hedge timeout (ref=%d)", m_iStoreTag, ( int ) GetRefcount () );
+			break;
 		case TIMEOUT_UNKNOWN:
 		default:
 			sphLogDebugA ("%d Unknown kind of timeout invoked. No action", m_iStoreTag );
@@ -1884,12 +2066,77 @@ void AgentConn_t::BuildData ()
 	{
 		sphLogDebugA ( "%d BuildData for this=%p, m_pBuilder=%p", m_iStoreTag, this, m_pBuilder );
 		// prepare our data to send.
+		auto iStart = m_tOutput.GetSentCount ();
 		m_pBuilder->BuildRequest ( *this, m_tOutput );
+		CompressRequest ( iStart );
 		m_dIOVec.BuildFrom ( m_tOutput );
 	} else
 		sphLogDebugA ( "%d BuildData, already done", m_iStoreTag );
 }
 
+/// compress the request just built, if the host is known to understand compressed frames
+void AgentConn_t::CompressRequest ( int iStart )
+{
+	if ( g_eAgentCompression==Compression_e::NONE || !m_tDesc.m_pDash )
+		return;
+
+	auto& tDash = *m_tDesc.m_pDash;
+	auto eCodec = tDash.m_eApiCodec.load ( std::memory_order_relaxed );
+	if ( eCodec==Compression_e::NONE )
+		return;
+
+	ApiCompressionStats_t tStats;
+	if ( !ApiCompressPacket ( m_tOutput, iStart, false, eCodec, false, tStats ) )
+		return;
+
+	sphLogDebugA ( "%d request compressed " INT64_FMT " -> " INT64_FMT " bytes", m_iStoreTag, tStats.m_iRawBytes, tStats.m_iWireBytes );
+	tDash.m_iFramedRawBytes.fetch_add ( tStats.m_iRawBytes, std::memory_order_relaxed );
+	tDash.m_iFramedWireBytes.fetch_add ( tStats.m_iWireBytes, std::memory_order_relaxed );
+	tDash.m_iFramedTimeUS.fetch_add ( tStats.m_iTimeUS, std::memory_order_relaxed );
+}
+
+/// host answered without a frame or with a broken one (restarted without compression, older version, etc.)
+/// so stop compressing requests to it, until it answers with a good frame again
+void AgentConn_t::ResetApiCodec ()
+{
+	if ( !m_tDesc.m_pDash )
+		return;
+
+	if ( m_tDesc.m_pDash->m_eApiCodec.exchange ( Compression_e::NONE, std::memory_order_relaxed )!=Compression_e::NONE )
+		sphLogDebugA ( "%d host stopped answering with compressed frames, requests are sent as is", m_iStoreTag );
+}
+
+/// replace compressed frame in reply buf with the reply itself
+bool AgentConn_t::DecompressReply ()
+{
+	ApiCompressionStats_t tStats;
+	CSphFixedVector<BYTE> dRaw { 0 };
+	Compression_e eCodec;
+	CSphString sError;
+	int iMaxSize = m_bReplyLimitSize ? g_iMaxPacketSize : INT_MAX;
+	if ( !ApiDecompressFrame ( { m_dReplyBuf.Begin(), m_iReplySize }, iMaxSize, dRaw, eCodec, sError, tStats ) )
+	{
+		ResetApiCodec();
+		return Fatal ( eWrongReplies, "%s", sError.cstr () );
+	}
+
+	m_dReplyBuf.SwapData ( dRaw );
+	m_iReplySize = (int) m_dReplyBuf.GetLength ();
+	m_pReplyCur = m_dReplyBuf.begin () + m_iReplySize;
+
+	// the host handles frames; it always accepts lz4, which replies below the threshold don't tell
+	auto& tDash = *m_tDesc.m_pDash;
+	if ( eCodec!=Compression_e::NONE )
+		tDash.m_eApiCodec.store ( eCodec, std::memory_order_relaxed );
+	else if ( tDash.m_eApiCodec.load ( std::memory_order_relaxed )==Compression_e::NONE )
+		tDash.m_eApiCodec.store ( Compression_e::LZ4, std::memory_order_relaxed );
+
+	tDash.m_iFramedRawBytes.fetch_add ( tStats.m_iRawBytes, std::memory_order_relaxed );
+	tDash.m_iFramedWireBytes.fetch_add ( tStats.m_iWireBytes, std::memory_order_relaxed );
+	tDash.m_iFramedTimeUS.fetch_add ( tStats.m_iTimeUS, std::memory_order_relaxed );
+	return true;
+}
+
 //! How many bytes we can read to m_pReplyCur (in bytes)
 size_t AgentConn_t::ReplyBufPlace () const
 {
@@ -2318,7 +2565,7 @@ void AgentConn_t::StartRemoteLoopTry ()
 			{
 				// can't start right now; need to postpone until timeout
 				sphLogDebugA ( "%d postpone DoQuery() for %d msecs", m_iStoreTag, m_iDelay );
-				LazyTask ( MonoMicroTimer () + 1000 * m_iDelay, 1000*m_iDelay, false );
+				LazyTask ( MonoMicroTimer () + 1000 * m_iDelay, 1000*m_iDelay, TIMEOUT_RETRY );
 				return;
 			}
 		}
@@ -2350,10 +2597,14 @@ bool AgentConn_t::DoQuery()
 	// fill initial chunks
 	m_tOutput.SendDword ( SPHINX_CLIENT_VERSION );
 	m_tOutput.StartNewChunk ();
-	if ( IsPersistent() && m_iSock==-1 )
+
+	// compression is offered in the version word of 'persist', so a new connection starts with it anyway;
+	// agent waits for the next command then, until we close the connection
+	WORD uCompressionOffer = ApiCompressionOffer ();
+	if ( ( IsPersistent() || uCompressionOffer ) && m_iSock==-1 )
 	{
 		{
-			auto tHdr = APIHeader ( m_tOutput, SEARCHD_COMMAND_PERSIST );
+			auto tHdr = APIHeader ( m_tOutput, SEARCHD_COMMAND_PERSIST, uCompressionOffer );
 			m_tOutput.SendInt ( 1 ); // set persistent to 1.
 		}
 		m_tOutput.StartNewChunk ();
@@ -2483,6 +2734,7 @@ bool AgentConn_t::SendQuery ( DWORD uSent )
 	{
 		sphLogDebugA ( "%d sending finished", m_iStoreTag );
 		DisableWrite();
+		ArmHedge ();
 		return ReceiveAnswer ();
 	}
 
@@ -2532,8 +2784,11 @@ bool AgentConn_t::ReceiveAnswer ( DWORD uRecv )
 			if ( !iRest ) // not only handshake, but whole header is here
 			{
 				auto uStat = dBuf.GetWord ();
-				auto VARIABLE_IS_NOT_USED uVer = dBuf.GetWord (); // there is version here. But it is not used.
+				auto uVer = dBuf.GetWord (); // there is version here. Only compressed frame flag is used.
 				auto iReplySize = dBuf.GetInt ();
+				m_bReplyFramed = ( uVer & API_COMPRESSED_FRAME )!=0;
+				if ( !m_bReplyFramed )
+					ResetApiCodec();
 
 				sphLogDebugA ( "%d Header (Status=%d, Version=%d, answer need %d bytes)", m_iStoreTag, uStat, uVer, iReplySize );
 
@@ -2549,6 +2804,12 @@ bool AgentConn_t::ReceiveAnswer ( DWORD uRecv )
 
 	if ( !ReplyBufPlace () ) // we've received full reply
 	{
+		if ( m_bHedge && m_iStartQuery )
+			m_tDesc.m_pDash->AddLatency ( sphMicroTimer () - m_iStartQuery );
+
+		if ( m_bReplyFramed && !DecompressReply () )
+			return false;
+
 		auto bRes = CommitResult ();
 		if ( bRes )
 			ReportFinish ( true );
@@ -2578,6 +2839,9 @@ void AgentConn_t::SetNoLimitReplySize()
 bool AgentConn_t::CommitResult ()
 {
 	sphLogDebugA ( "%d CommitResult() ref=%d, parser %p", m_iStoreTag, ( int ) GetRefcount (), m_pParser );
+	if ( m_pHedgeOf )
+		return CommitHedge ();
+
 	if ( !m_pParser )
 	{
 		Finish();
@@ -3749,12 +4013,12 @@ LazyNetEvents_c & LazyPoller ()
 }
 
 //! Add or change task for poller.
-void AgentConn_t::LazyTask ( int64_t iTimeoutUS, int64_t iTimeoutPeriodUS, bool bHardTimeout, BYTE uActivateIO )
+void AgentConn_t::LazyTask ( int64_t iTimeoutUS, int64_t iTimeoutPeriodUS, ETimeoutKind eKind, BYTE uActivateIO )
 {
 	assert ( iTimeoutUS>0 );
 
 	m_bNeedKick = !InNetLoop();
-	m_eTimeoutKind = bHardTimeout ? TIMEOUT_HARD : TIMEOUT_RETRY;
+	m_eTimeoutKind = eKind;
 	LazyPoller ().EnqueueNewTask ( this, iTimeoutUS, iTimeoutPeriodUS, uActivateIO );
 }
 
@@ -215,6 +215,7 @@ struct AgentOptions_t
 	HAStrategies_e m_eStrategy;
 	int m_iRetryCount;
 	int m_iRetryCountMultiplier;
+	int m_iHedgeRate;	///< max % of queries which may be hedged to a second mirror, 0 = no hedging
 };
 
 using HostMetricsSnapshot_t = uint64_t[(int)eMaxAgentStat + (int)ehMaxStat];
@@ -231,6 +232,12 @@ struct HostDashboard_t : public ISphRefcountedMT
 	int64_t m_iLastQueryTime GUARDED_BY ( m_dMetricsLock ) = sphMicroTimer();    // updated when we send a query to a host
 	int64_t m_iErrorsARow GUARDED_BY ( m_dMetricsLock ) = 0;        // num of errors a row, updated when we update the general statistic.
 	DWORD m_uPingTripUS = 0;		// round-trip in uS. We send ping with current time, on receive answer compare with current time and fix that difference
+	std::atomic<int64_t> m_iHedged { 0 };		// queries to this host which were hedged to another mirror
+	std::atomic<int64_t> m_iHedgeWins { 0 };	// hedged queries this host answered first
+	std::atomic<Compression_e> m_eApiCodec { Compression_e::NONE };	// set while the host answers with compressed frames; requests are compressed with it
+	std::atomic<int64_t> m_iFramedRawBytes { 0 };	// uncompressed bytes of compressed frames both ways
+	std::atomic<int64_t> m_iFramedWireBytes { 0 };	// same frames as sent over the wire
+	std::atomic<int64_t> m_iFramedTimeUS { 0 };		// time spent compressing requests and decompressing replies
 
 public:
 	explicit HostDashboard_t ( const HostDesc_t &tAgent = {});
@@ -238,6 +245,9 @@ public:
 	MetricsAndCounters_t &GetCurrentMetrics () REQUIRES ( m_dMetricsLock );
 	void GetCollectedMetrics ( HostMetricsSnapshot_t &dResult, int iPeriods = 1 ) const REQUIRES ( !m_dMetricsLock );
 
+	void AddLatency ( int64_t iLatencyUS ) REQUIRES ( !m_dMetricsLock );
+	int64_t GetP95LatencyUS () const { return m_iP95LatencyUS.load ( std::memory_order_relaxed ); } // 0 until enough answers collected
+
 	static DWORD GetCurSeconds ();
 	static bool IsHalfPeriodChanged ( DWORD * pLast );
 
@@ -248,6 +258,12 @@ private:
 		DWORD m_uPeriod = 0xFFFFFFFF;
 	} m_dPeriodicMetrics[STATS_DASH_PERIODS] GUARDED_BY ( m_dMetricsLock );
 
+	// running p95 of the answer time over the last LATENCY_WINDOW answers
+	static constexpr int LATENCY_WINDOW = 128;
+	int64_t m_dLatenciesUS[LATENCY_WINDOW] GUARDED_BY ( m_dMetricsLock ) {};
+	int64_t m_iLatencies GUARDED_BY ( m_dMetricsLock ) = 0;
+	std::atomic<int64_t> m_iP95LatencyUS { 0 };
+
 	~HostDashboard_t() override;
 };
 
@@ -295,6 +311,8 @@ class MultiAgentDesc_c final : public ISphRefcountedMT, public CSphFixedVector<A
 	DWORD				m_uTimestamp { HostDashboard_t::GetCurSeconds () };    /// timestamp of last weight's actualization
 	HAStrategies_e		m_eStrategy { HA_DEFAULT };
 	int					m_iMultiRetryCount = 0;
+	int					m_iHedgeRate = 0;		/// % of queries allowed to be hedged
+	std::atomic<int>	m_iHedgeBudget {0};		/// in 1/100 of hedge; every query earns m_iHedgeRate, every hedge costs 100
 	bool 				m_bNeedPing = false;	/// ping need to hosts if we're HA and NOT bl.
 	CSphString			m_sConfigStr;	/// agent configuration string, straight from .conf
 
@@ -313,6 +331,16 @@ public:
 
 	const AgentDesc_t & ChooseAgent() REQUIRES ( !m_dWeightLock );
 
+	// hedging: another mirror for a query stuck on tBusy, or nullptr
+	const AgentDesc_t * ChooseHedgeAgent ( const AgentDesc_t & tBusy ) REQUIRES ( !m_dWeightLock );
+	void EarnHedge ();
+	bool SpendHedge ();
+
+	inline bool CanHedge () const
+	{
+		return m_iHedgeRate>0 && IsHA();
+	}
+
 	inline bool IsHA () const
 	{
 		return GetLength ()>1;
@@ -470,7 +498,7 @@ struct DefaultQueryResult_t : public iQueryResult
 /// remote agent connection (local per-query state)
 struct AgentConn_t : public ISphRefcountedMT
 {
-	enum ETimeoutKind { TIMEOUT_UNKNOWN, TIMEOUT_RETRY, TIMEOUT_HARD, };
+	enum ETimeoutKind { TIMEOUT_UNKNOWN, TIMEOUT_RETRY, TIMEOUT_HARD, TIMEOUT_HEDGE, };
 public:
 	AgentDesc_t		m_tDesc;			///< desc of my host // fixme! turn to ref to MultiAgent mirror?
 	int				m_iSock = -1;
@@ -488,6 +516,7 @@ public:
 	CSphString		m_sFailure;				///< failure message (both network and logical)
 	mutable int		m_iStoreTag = -1;	///< cookie, m.b. used to 'glue' to concrete connection
 	int				m_iWeight = -1;		///< weight of the index, will be send with query to remote host
+	bool			m_bHedge = false;	///< request is idempotent and may be hedged to another mirror
 
 	CSphRefcountedPtr<Reporter_i>	m_pReporter { nullptr };	///< used to report back when we're finished
 	LPKEY			m_pPollerTask = nullptr; ///< internal for poller. fixme! privatize?
@@ -534,6 +563,12 @@ private:
 	int			m_iMirrorsCount = 1;
 	int			m_iDelay { g_iAgentRetryDelayMs };	///< delay between retries
 
+	// hedging: a copy of the request sent to another mirror when this one is slow
+	int64_t		m_iHedgeUS = 0;						///< when to hedge (mono time), 0 if not armed
+	bool		m_bHedged = false;					///< already hedged once in this query
+	CSphRefcountedPtr<AgentConn_t> m_pHedge;		///< the copy in flight (on the primary)
+	CSphRefcountedPtr<AgentConn_t> m_pHedgeOf;		///< the primary (on the copy)
+
 	// active timeout (directly used by poller)
 	int64_t			m_iPoolerTimeoutPeriodUS = -1;
 	int64_t			m_iPoolerTimeoutUS = -1;	///< m.b. query, or connect+query when TCP_FASTOPEN
@@ -546,6 +581,7 @@ private:
 	CSphFixedVector<BYTE>	m_dReplyHeader { REPLY_HEADER_SIZE };
 	BYTE *					m_pReplyCur = nullptr;
 	bool					m_bReplyLimitSize = true;
+	bool					m_bReplyFramed = false;	///< reply is compressed frame (see compressed_api.h)
 
 	// sending buffer stuff
 	SmartOutputBuffer_t m_tOutput;		///< chain of blobs we're sending to a host
@@ -579,12 +615,15 @@ private:
 
 	bool StartNextRetry ();
 
-	void LazyTask ( int64_t iTimeoutMS, int64_t iTimeoutPeriodUS, bool bHardTimeout = false, BYTE ActivateIO = 0 ); // 1=RW, 2=RO.
+	void LazyTask ( int64_t iTimeoutMS, int64_t iTimeoutPeriodUS, ETimeoutKind eKind, BYTE ActivateIO = 0 ); // 1=RW, 2=RO.
 	void LazyDeleteOrChange ( int64_t iTimeoutMS = -1, int64_t iTimeoutPeriodUS = -1 );
 	void ScheduleCallbacks ();
 	void DisableWrite();
 
 	void BuildData ();
+	void CompressRequest ( int iStart );
+	bool DecompressReply ();
+	void ResetApiCodec ();
 	size_t ReplyBufPlace () const;
 	void InitReplyBuf ( int iSize = 0 );
 	inline bool IsReplyHeader() const { return m_iReplySize<0; }
@@ -600,6 +639,11 @@ private:
 	bool ReceiveAnswer (DWORD uReceived = 0);
 	bool CommitResult ();
 	bool SwitchBlackhole ();
+
+	void ArmHedge ();
+	void StartHedge ();
+	void CancelHedge ();
+	bool CommitHedge ();
 };
 
 using VectorAgentConn_t = CSphVector<AgentConn_t *>;
@@ -647,6 +691,7 @@ struct DistributedIndex_t : public ISphRefcountedMT
 	CSphVector<MultiAgentDescRefPtr_c> m_dAgents;	///< remote agents
 	StrVec_t m_dLocal;								///< local indexes
 	int m_iAgentRetryCount			= 0;			///< overrides global one
+	int m_iHedgeRate				= 0;			///< max % of queries hedged to a second mirror
 	bool m_bDivideRemoteRanges		= false;		///< whether we divide big range onto agents or not
 	HAStrategies_e m_eHaStrategy	= HA_DEFAULT;	///< how to select the best of my agents
 	mutable ServedStats_c			m_tStats;
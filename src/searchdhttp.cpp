@@ -139,6 +139,24 @@ void HttpBuildReplyHead ( CSphVector<BYTE> & dData, EHTTP_STATUS eCode, const ch
 	HttpBuildReply ( tReply, dData );
 }
 
+// head of the reply with chunked transfer coding, i.e. the one which is sent in parts and has no content length
+static void HttpBuildChunkedHead ( CSphVector<BYTE> & dData, EHTTP_STATUS eCode )
+{
+	CSphString sHttp;
+	sHttp.SetSprintf ( "HTTP/1.1 %s\r\nServer: %s\r\nContent-Type: application/json; charset=UTF-8\r\nTransfer-Encoding: chunked\r\n\r\n", HttpGetStatusName ( eCode ), g_sStatusVersion.cstr() );
+	dData.Append ( FromStr ( sHttp ) );
+}
+
+// empty chunk is the last one; it terminates the reply
+static void HttpAppendChunk ( CSphVector<BYTE> & dData, Str_t sChunk )
+{
+	CSphString sSize;
+	sSize.SetSprintf ( "%x\r\n", sChunk.second );
+	dData.Append ( FromStr ( sSize ) );
+	dData.Append ( sChunk );
+	dData.Append ( Str_t { "\r\n", 2 } );
+}
+
 void HttpErrorReply ( CSphVector<BYTE> & dData, EHTTP_STATUS eCode, const char * szError )
 {
 	JsonObj_c tErr;
@@ -1034,6 +1052,11 @@ void HttpHandler_c::SetErrorFormat ( bool bNeedHttpResponse )
 	m_bNeedHttpResponse = bNeedHttpResponse;
 }
 
+void HttpHandler_c::SetOutput ( GenericOutputBuffer_c * pOut )
+{
+	m_pOut = pOut;
+}
+
 CSphVector<BYTE> & HttpHandler_c::GetResult()
 {
 	return m_dData;
@@ -1388,7 +1411,9 @@ const StrBlock_t dJsonObjCustom { { ",\n", 2 }, { "[", 1 }, { "]", 1 } }; // jso
 class JsonRowBuffer_c final : public RowBuffer_i
 {
 public:
-	JsonRowBuffer_c()
+	// with pChunkOut the rows flushed by a streamed select are sent right away, as parts of a chunked reply
+	explicit JsonRowBuffer_c ( GenericOutputBuffer_c * pChunkOut = nullptr )
+		: m_pChunkOut ( pChunkOut )
 	{
 		m_dBuf.StartBlock ( dJsonObjCustom );
 	}
@@ -1501,8 +1526,18 @@ public:
 
 	void Error ( const char * szError, EMYSQL_ERR ) override
 	{
-		auto _ = m_dBuf.Object ( false );
-		DataFinish ( 0, szError, nullptr );
+		// rows are already sent; the error terminates the result set instead of replacing it
+		if ( m_bChunked )
+		{
+			m_dBuf.FinishBlock ( true ); // last doc, allow empty
+			m_dBuf.FinishBlock ( false ); // docs section
+			DataFinish ( m_iTotalRows, szError, nullptr );
+			m_dBuf.FinishBlock ( false ); // root object
+		} else
+		{
+			auto _ = m_dBuf.Object ( false );
+			DataFinish ( 0, szError, nullptr );
+		}
 		m_bError = true;
 		m_sError = szError;
 	}
@@ -1554,6 +1589,27 @@ public:
 
 	void Add ( BYTE ) override {}
 
+	bool FlushRows() override
+	{
+		if ( !m_pChunkOut || m_bError || m_dBuf.IsEmpty() )
+			return true;
+
+		CSphVector<BYTE> dChunk;
+		if ( !m_bChunked )
+			HttpBuildChunkedHead ( dChunk, EHTTP_STATUS::_200 );
+		m_bChunked = true;
+
+		// blocks keep their state, so the rest of the reply continues right after the sent part
+		HttpAppendChunk ( dChunk, (Str_t)m_dBuf );
+		m_dBuf.Rewind();
+
+		m_pChunkOut->SendBytes ( dChunk );
+		return m_pChunkOut->Flush();
+	}
+
+	// head and some rows were sent in chunks; Finish() returns only the rest of the reply
+	bool IsChunked() const { return m_bChunked; }
+
 	const JsonEscapedBuilder & Finish()
 	{
 		m_dBuf.FinishBlocks();
@@ -1562,6 +1618,8 @@ public:
 
 private:
 	JsonEscapedBuilder m_dBuf;
+	GenericOutputBuffer_c * m_pChunkOut = nullptr;
+	bool m_bChunked = false;
 	StrVec_t m_dColumns;
 	int m_iTotalRows = 0;
 	int m_iCol = 0;
@@ -1714,8 +1772,17 @@ public:
 		if ( IsBuddyQuery ( m_tOptions ) )
 			session::SetQueryDisableLog();
 
-		JsonRowBuffer_c tOut;
+		JsonRowBuffer_c tOut ( m_pOut );
 		session::Execute ( m_sQuery, tOut );
+		if ( tOut.IsChunked() )
+		{
+			// streamed select already sent the head and leading rows; the rest goes with the last chunk
+			m_dData.Resize ( 0 );
+			HttpAppendChunk ( m_dData, (Str_t)tOut.Finish() );
+			HttpAppendChunk ( m_dData, dEmptyStr );
+			return true;
+		}
+
 		if ( tOut.IsError() )
 		{
 			ReportError ( tOut.GetError().scstr(), EHTTP_STATUS::_500 );
@@ -2465,7 +2532,7 @@ static std::unique_ptr<HttpHandler_c> CreateHttpHandler ( EHTTP_ENDPOINT eEndpoi
 	return nullptr;
 }
 
-HttpProcessResult_t ProcessHttpQuery ( CharStream_c & tSource, Str_t & sSrcQuery, OptionsHash_t & hOptions, CSphVector<BYTE> & dResult, bool bNeedHttpResponse, http_method eRequestType )
+HttpProcessResult_t ProcessHttpQuery ( CharStream_c & tSource, Str_t & sSrcQuery, OptionsHash_t & hOptions, CSphVector<BYTE> & dResult, bool bNeedHttpResponse, http_method eRequestType, GenericOutputBuffer_c * pOut )
 {
 	TRACE_CONN ( "conn", "ProcessHttpQuery" );
 
@@ -2502,6 +2569,9 @@ HttpProcessResult_t ProcessHttpQuery ( CharStream_c & tSource, Str_t & sSrcQuery
 		return tRes;
 
 	pHandler->SetErrorFormat ( bNeedHttpResponse );
+	// /cli replies might be replaced by the buddy afterwards, so only /sql may send its reply in parts
+	if ( tRes.m_eEndpoint==EHTTP_ENDPOINT::SQL )
+		pHandler->SetOutput ( pOut );
 	tRes.m_bOk = pHandler->Process();
 	tRes.m_sError = pHandler->GetError();
 	tRes.m_eReplyHttpCode = pHandler->GetStatusCode();
@@ -2529,7 +2599,7 @@ static bool IsCompressed ( const OptionsHash_t & hOptions )
 	return ( *pEncoding=="gzip" );
 }
 
-bool HttpRequestParser_c::ProcessClientHttp ( AsyncNetInputBuffer_c& tIn, CSphVector<BYTE>& dResult )
+bool HttpRequestParser_c::ProcessClientHttp ( AsyncNetInputBuffer_c& tIn, GenericOutputBuffer_c& tOut, CSphVector<BYTE>& dResult )
 {
 	assert ( !m_szError );
 	std::unique_ptr<CharStream_c> pSource;
@@ -2571,7 +2641,7 @@ bool HttpRequestParser_c::ProcessClientHttp ( AsyncNetInputBuffer_c& tIn, CSphVe
 
 	} else
 	{
-		tRes = ProcessHttpQuery ( *pSource, sSrcQuery, m_hOptions, dResult, true, m_eType );
+		tRes = ProcessHttpQuery ( *pSource, sSrcQuery, m_hOptions, dResult, true, m_eType, &tOut );
 	}
 
 	return ProcessHttpQueryBuddy ( tRes, sSrcQuery, m_hOptions, dResult, true, m_eType );
@@ -24,7 +24,7 @@ public:
 	HttpRequestParser_c();
 	void Reinit();
 	bool ParseHeader ( ByteBlob_t tData );
-	bool ProcessClientHttp ( AsyncNetInputBuffer_c& tIn, CSphVector<BYTE>& dResult );
+	bool ProcessClientHttp ( AsyncNetInputBuffer_c& tIn, GenericOutputBuffer_c& tOut, CSphVector<BYTE>& dResult );
 
 	int ParsedBodyLength() const;
 	bool Expect100() const;
@@ -115,7 +115,7 @@ struct HttpProcessResult_t
 	CSphString m_sError;
 };
 
-HttpProcessResult_t ProcessHttpQuery ( CharStream_c & tSource, Str_t & sSrcQuery, OptionsHash_t & hOptions, CSphVector<BYTE> & dResult, bool bNeedHttpResponse, http_method eRequestType );
+HttpProcessResult_t ProcessHttpQuery ( CharStream_c & tSource, Str_t & sSrcQuery, OptionsHash_t & hOptions, CSphVector<BYTE> & dResult, bool bNeedHttpResponse, http_method eRequestType, GenericOutputBuffer_c * pOut=nullptr );
 
 namespace bson {
 class Bson_c;
@@ -137,12 +137,14 @@ public:
 	virtual ~HttpHandler_c() = default;
 	virtual bool Process () = 0;
 	void SetErrorFormat ( bool bNeedHttpResponse );
+	void SetOutput ( GenericOutputBuffer_c * pOut );
 	CSphVector<BYTE> & GetResult();
 	const CSphString & GetError () const;
 	EHTTP_STATUS GetStatusCode () const;
 
 protected:
 	bool				m_bNeedHttpResponse {false};
+	GenericOutputBuffer_c *	m_pOut = nullptr;	// client connection, for the replies sent in parts
 	CSphVector<BYTE>	m_dData;
 	CSphString			m_sError;
 	EHTTP_STATUS		m_eHttpCode = EHTTP_STATUS::_200;
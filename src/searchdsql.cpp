@@ -646,6 +646,8 @@ enum class Option_e : BYTE
 	RANK_CONSTANT,
 	WINDOW_SIZE,
 	FUSION_WEIGHTS,
+	STREAM,
+	TOP_K_PRUNING,
 
 	INVALID_OPTION
 };
@@ -661,7 +663,7 @@ void InitParserOption()
 		"retry_delay", "reverse_scan", "sort_method", "strict", "sync", "threads", "token_filter", "token_filter_options",
 		"not_terms_only_allowed", "store", "accurate_aggregation", "max_matches_increase_threshold", "distinct_precision_threshold",
 		"threads_ex", "switchover", "expansion_limit", "jieba_mode", "scroll", "join_batch_size", "force", "output_words", "expand_blended",
-		"fusion_method", "rank_constant", "window_size", "fusion_weights" };
+		"fusion_method", "rank_constant", "window_size", "fusion_weights", "stream", "top_k_pruning" };
 
 	for ( BYTE i = 0u; i<(BYTE) Option_e::INVALID_OPTION; ++i )
 		g_hParseOption.Add ( (Option_e) i, dOptions[i] );
@@ -696,7 +698,7 @@ static bool CheckOption ( SqlStmt_e eStmt, Option_e eOption )
 			Option_e::THREADS, Option_e::TOKEN_FILTER, Option_e::NOT_ONLY_ALLOWED, Option_e::ACCURATE_AGG,
 			Option_e::MAXMATCH_THRESH, Option_e::DISTINCT_THRESH, Option_e::THREADS_EX, Option_e::EXPANSION_LIMIT,
 			Option_e::JIEBA_MODE, Option_e::SCROLL, Option_e::JOIN_BATCH_SIZE, Option_e::EXPAND_BLENDED,
-			Option_e::FUSION_METHOD, Option_e::RANK_CONSTANT, Option_e::WINDOW_SIZE, Option_e::FUSION_WEIGHTS };
+			Option_e::FUSION_METHOD, Option_e::RANK_CONSTANT, Option_e::WINDOW_SIZE, Option_e::FUSION_WEIGHTS, Option_e::STREAM, Option_e::TOP_K_PRUNING };
 
 	static Option_e dInsertOptions[] = { Option_e::TOKEN_FILTER_OPTIONS };
 
@@ -809,7 +811,7 @@ AddOption_e AddOption ( CSphQuery & tQuery, const CSphString & sOpt, const CSphS
 		Option_e::THREADS, Option_e::NOT_ONLY_ALLOWED, Option_e::LOW_PRIORITY, Option_e::DEBUG_NO_PAYLOAD,
 		Option_e::ACCURATE_AGG, Option_e::MAXMATCH_THRESH, Option_e::DISTINCT_THRESH, Option_e::SWITCHOVER,
 		Option_e::EXPANSION_LIMIT, Option_e::SCROLL, Option_e::JOIN_BATCH_SIZE,
-		Option_e::RANK_CONSTANT, Option_e::WINDOW_SIZE
+		Option_e::RANK_CONSTANT, Option_e::WINDOW_SIZE, Option_e::STREAM, Option_e::TOP_K_PRUNING
 	};
 
 	bool bFound = ::any_of ( dIntegerOptions, [eOpt] ( auto i ) { return i == eOpt; } );
@@ -860,6 +862,8 @@ AddOption_e AddOption ( CSphQuery & tQuery, const CSphString & sOpt, const CSphS
 	case Option_e::EXPANSION_LIMIT:				tQuery.m_iExpansionLimit = (int)iValue; break;
 	case Option_e::SCROLL:						tQuery.m_tScrollSettings.m_bRequested = !!iValue; break;
 	case Option_e::JOIN_BATCH_SIZE:				tQuery.m_iJoinBatchSize = (int)iValue; break;
+	case Option_e::STREAM:						tQuery.m_bStream = iValue!=0; break;
+	case Option_e::TOP_K_PRUNING:				tQuery.m_bTopKPruning = iValue!=0; break;
 	case Option_e::RANK_CONSTANT:
 		if ( iValue < 0 )
 			return FAILED ( "rank_constant must be non-negative" );
@@ -2346,6 +2350,7 @@ void SqlParser_c::SetLimit ( int iOffset, int iLimit )
 {
 	m_pQuery->m_iOffset = iOffset;
 	m_pQuery->m_iLimit = iLimit;
+	m_pQuery->m_bExplicitLimit = true;
 }
 
 CSphVector<CSphNamedVariant> & SqlParser_c::GetNamedVec ( [[maybe_unused]] int iIndex )
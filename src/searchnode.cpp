@@ -254,6 +254,7 @@ public:
 	void				SetCollectHits() override { m_bCollectHits = true; }
 	NodeEstimate_t		Estimate ( int64_t iTotalDocs ) const override { return { float(m_pQword->m_iDocs)*COST_SCALE*60.0f, m_pQword->m_iDocs, 1 }; }
 	void				SetRowidBoundaries ( const RowIdBoundaries_t & tBoundaries ) override;
+	void				SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone ) override;
 
 	void				DebugDump ( int iLevel ) override;
 
@@ -273,8 +274,12 @@ protected:
 	CSphQueryStats *	m_pStats = nullptr;
 	bool				m_bCollectHits = false;
 	RowIdBoundaries_t	m_tBoundaries;
+	BlockSkip_i *		m_pBlockSkip = nullptr;		///< set when whole doclist blocks below the top-k floor can be skipped
+	bool				m_bBlockSkipAlone = false;	///< whether this term is the only one to weight the docs
 
 	CSphVector<StoredHit_t> m_dStoredHits;
+
+	inline void			SkipBlocksBelowFloor();
 };
 
 
@@ -411,6 +416,7 @@ public:
 	void				SetCollectHits() override;
 	NodeEstimate_t		Estimate ( int64_t iTotalDocs ) const override;
 	void				SetRowidBoundaries ( const RowIdBoundaries_t & tBoundaries ) override;
+	void				SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone ) override;
 
 	void				SetNodePos ( WORD uPosLeft, WORD uPosRight );
 
@@ -636,6 +642,7 @@ public:
 	void				CollectHits ( const ExtDoc_t * pDocs ) override;
 	void				Reset ( const ISphQwordSetup & tSetup ) override;
 	void				SetCollectHits() override;
+	void				SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone ) override;
 	void				DebugDump ( int iLevel ) override;
 
 protected:
@@ -939,6 +946,7 @@ public:
 	const ExtDoc_t *	GetDocsChunk() override;
 	void				CollectHits ( const ExtDoc_t * pDocs ) override;
 	void				Reset ( const ISphQwordSetup & tSetup ) override;
+	void				SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone ) override { m_pLeft->SetBlockSkip ( pSkip, bAlone ); }	// skipping the 'not' side would let its docs through
 	void				DebugDump ( int iLevel ) override;
 
 private:
@@ -2145,6 +2153,12 @@ const ExtDoc_t * ExtTerm_T<USE_BM25,ROWID_LIMITS,STATS>::GetDocsChunk()
 	int iDoc = 0;
 	while ( iDoc<MAX_BLOCK_DOCS-1 )
 	{
+		if_const ( USE_BM25 )
+		{
+			if ( m_pBlockSkip )
+				SkipBlocksBelowFloor();
+		}
+
 		const CSphMatch & tMatch = m_pQword->GetNextDoc();
 		if constexpr ( ROWID_LIMITS )
 		{
@@ -2209,6 +2223,43 @@ const ExtDoc_t * ExtTerm_T<USE_BM25,ROWID_LIMITS,STATS>::GetDocsChunk()
 	return ReturnDocsChunk ( iDoc, "term", m_pQword->m_sDictWord.cstr() );
 }
 
+template<bool USE_BM25, bool ROWID_LIMITS, bool STATS>
+void ExtTerm_T<USE_BM25,ROWID_LIMITS,STATS>::SkipBlocksBelowFloor()
+{
+	// other terms can add at most their idf each (tf part of bm25 is below 1)
+	float fOthersTFIDF = m_bBlockSkipAlone ? 0.0f : m_pBlockSkip->GetQueryTFIDF() - Max ( m_fIDF, 0.0f );
+
+	DWORD uMaxHits = 0;
+	DWORD uFields = 0;
+	while ( m_pQword->GetBlockMax ( uMaxHits, uFields ) )
+	{
+		ExtDoc_t tBound;
+		tBound.m_tRowID = INVALID_ROWID;
+		tBound.m_fTFIDF = fOthersTFIDF + Max ( float(uMaxHits) / float(uMaxHits+SPH_BM25_K1) * m_fIDF, 0.0f );
+		tBound.m_uDocFields = m_bBlockSkipAlone ? ( uFields & m_dQueriedFields.GetMask32() ) : 0xFFFFFFFFUL;
+
+		// zero mask means "unknown" to the ranker bound, so give it all the fields instead
+		if ( m_bBlockSkipAlone && !tBound.m_uDocFields )
+			tBound.m_uDocFields = 0xFFFFFFFFUL;
+
+		if ( !m_pBlockSkip->IsBelowFloor ( tBound ) )
+			return;
+
+		m_pBlockSkip->AddSkippedBlock ( m_pQword->SkipBlock() );
+	}
+}
+
+template<bool USE_BM25, bool ROWID_LIMITS, bool STATS>
+void ExtTerm_T<USE_BM25,ROWID_LIMITS,STATS>::SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone )
+{
+	// fields 32+ are not in the block-max; words with no weight have nothing to bound
+	if ( m_bHasWideFields || m_bNotWeighted || m_pQword->m_bExcluded )
+		return;
+
+	m_pBlockSkip = pSkip;
+	m_bBlockSkipAlone = bAlone;
+}
+
 template<bool USE_BM25, bool ROWID_LIMITS, bool STATS>
 void ExtTerm_T<USE_BM25,ROWID_LIMITS,STATS>::CollectHits ( const ExtDoc_t * pMatched )
 {
@@ -2831,6 +2882,12 @@ void ExtTwofer_c::SetRowidBoundaries ( const RowIdBoundaries_t & tBoundaries )
 	if ( m_pRight ) m_pRight->SetRowidBoundaries(tBoundaries);
 }
 
+void ExtTwofer_c::SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone )
+{
+	if ( m_pLeft ) m_pLeft->SetBlockSkip ( pSkip, false );
+	if ( m_pRight ) m_pRight->SetBlockSkip ( pSkip, false );
+}
+
 //////////////////////////////////////////////////////////////////////////
 ExtAnd_c::ExtAnd_c ( ExtNode_i * pLeft, ExtNode_i * pRight )
 	: ExtTwofer_c ( pLeft, pRight )
@@ -4052,6 +4109,12 @@ void ExtAndNot_c::SetCollectHits()
 	// m_pRight always ignores hits
 }
 
+void ExtAndNot_c::SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone )
+{
+	// skipping excluded docs would let them through
+	m_pLeft->SetBlockSkip ( pSkip, bAlone );
+}
+
 void ExtAndNot_c::DebugDump ( int iLevel )
 {
 	DebugDumpT ( "ExtAndNot", iLevel );
@@ -60,6 +60,17 @@ struct ExtHit_t;
 struct ExtDoc_t;
 struct RowIdBoundaries_t;
 
+/// lets term nodes skip whole doclist blocks which can't get into the top-k
+class BlockSkip_i
+{
+public:
+	virtual			~BlockSkip_i() {}
+
+	virtual bool	IsBelowFloor ( const ExtDoc_t & tBound ) const = 0;	///< whether a doc with (at most) that tf-idf and fields can't get into the top-k
+	virtual void	AddSkippedBlock ( int iDocs ) = 0;
+	virtual float	GetQueryTFIDF() const = 0;							///< upper bound of the whole query tf-idf
+};
+
 /// generic match streamer
 class ExtNode_i
 {
@@ -88,6 +99,7 @@ public:
 	virtual void				SetCollectHits() {}				// call this if ranker needs hits
 	virtual NodeEstimate_t		Estimate ( int64_t iTotalDocs ) const = 0;
 	virtual void				SetRowidBoundaries ( const RowIdBoundaries_t & tBoundaries ) = 0;
+	virtual void				SetBlockSkip ( BlockSkip_i * pSkip, bool bAlone ) {}	///< bAlone means the node is the only source of the doc weight
 
 	virtual void				DebugDump ( int iLevel ) = 0;
 	virtual bool				TimeExceeded() const = 0;
@@ -492,6 +492,85 @@ void RowidIterator_Union_T<RowidIterator_i,false>::AddDesc ( CSphVector<Iterator
 
 /////////////////////////////////////////////////////////////////////
 
+/// iterates a rowid bitmap built from (or cached for) dense filters
+class RowidIterator_Bitmap_c : public SecondaryIndexIterator_c
+{
+public:
+				RowidIterator_Bitmap_c ( std::shared_ptr<const RoaringBitmap_c> pBitmap, const IteratorDesc_t & tDesc, int64_t iProcessed );
+
+	bool		HintRowID ( RowID_t tRowID ) override;
+	bool		GetNextRowIdBlock ( RowIdBlock_t & dRowIdBlock ) override;
+	int64_t		GetNumProcessed() const override { return m_iProcessed; }
+	void		SetCutoff ( int iCutoff ) override { m_iRowsLeft = iCutoff; }
+	bool		WasCutoffHit() const override { return !m_iRowsLeft; }
+	void		AddDesc ( CSphVector<IteratorDesc_t> & dDesc ) const override;
+
+	const RoaringBitmap_c & GetBitmap() const { return *m_pBitmap; }
+	bool		Intersect ( const RowidIterator_Bitmap_c & tRhs );
+
+private:
+	std::shared_ptr<const RoaringBitmap_c>	m_pBitmap;
+	CSphVector<IteratorDesc_t>	m_dDescs;
+	int64_t		m_iProcessed = 0;
+	int64_t		m_iNext = 0;
+	int			m_iRowsLeft = INT_MAX;
+};
+
+
+RowidIterator_Bitmap_c::RowidIterator_Bitmap_c ( std::shared_ptr<const RoaringBitmap_c> pBitmap, const IteratorDesc_t & tDesc, int64_t iProcessed )
+	: m_pBitmap ( std::move(pBitmap) )
+	, m_iProcessed ( iProcessed )
+{
+	m_dDescs.Add(tDesc);
+}
+
+
+bool RowidIterator_Bitmap_c::HintRowID ( RowID_t tRowID )
+{
+	m_iNext = Max ( m_iNext, (int64_t)tRowID );
+	return m_iNext<=UINT32_MAX;
+}
+
+
+bool RowidIterator_Bitmap_c::GetNextRowIdBlock ( RowIdBlock_t & dRowIdBlock )
+{
+	RowID_t * pRowIdStart = m_dCollected.Begin();
+	int iFetched = m_pBitmap->Fetch ( m_iNext, pRowIdStart, Min ( m_dCollected.GetLength()-1, m_iRowsLeft ) );
+
+	if ( m_iRowsLeft!=INT_MAX )
+	{
+		m_iRowsLeft -= iFetched;
+		assert ( m_iRowsLeft>=0 );
+	}
+
+	return ReturnIteratorResult ( pRowIdStart+iFetched, pRowIdStart, dRowIdBlock );
+}
+
+
+void RowidIterator_Bitmap_c::AddDesc ( CSphVector<IteratorDesc_t> & dDesc ) const
+{
+	for ( const auto & i : m_dDescs )
+		dDesc.Add(i);
+}
+
+/// AND another bitmap into ours; the shared (maybe cached) bitmap is never modified
+bool RowidIterator_Bitmap_c::Intersect ( const RowidIterator_Bitmap_c & tRhs )
+{
+	if ( m_iNext || tRhs.m_iNext || m_iRowsLeft!=INT_MAX || tRhs.m_iRowsLeft!=INT_MAX )
+		return false;
+
+	auto pResult = std::make_shared<RoaringBitmap_c> ( *m_pBitmap );
+	pResult->And ( *tRhs.m_pBitmap );
+	m_pBitmap = std::move(pResult);
+	m_iProcessed += tRhs.m_iProcessed;
+	for ( const auto & i : tRhs.m_dDescs )
+		m_dDescs.Add(i);
+
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////
+
 template <bool ROWID_LIMITS>
 class RowidIterator_Wrapper_T : public RowidIterator_i
 {
@@ -1090,8 +1169,43 @@ const CSphFilterSettings * GetRowIdFilter ( const CSphVector<CSphFilterSettings>
 }
 
 
+// bitmaps of dense filters are ANDed word-parallel up front, the rest goes through the regular intersection
+static void IntersectBitmapIterators ( CSphVector<RowidIterator_i*> & dIterators )
+{
+	RowidIterator_Bitmap_c * pFirst = nullptr;
+	int iOut = 0;
+	for ( auto * pIterator : dIterators )
+	{
+		auto * pBitmap = dynamic_cast<RowidIterator_Bitmap_c *>(pIterator);
+		if ( !pBitmap )
+		{
+			dIterators[iOut++] = pIterator;
+			continue;
+		}
+
+		if ( !pFirst )
+		{
+			pFirst = pBitmap;
+			dIterators[iOut++] = pIterator;
+			continue;
+		}
+
+		if ( pFirst->Intersect(*pBitmap) )
+			SafeDelete(pBitmap);
+		else
+			dIterators[iOut++] = pIterator;
+	}
+
+	dIterators.Resize(iOut);
+}
+
+
 RowidIterator_i * CreateIteratorIntersect ( CSphVector<RowidIterator_i*> & dIterators, const RowIdBoundaries_t * pBoundaries )
 {
+	IntersectBitmapIterators ( dIterators );
+	if ( dIterators.GetLength()==1 )
+		return dIterators[0];
+
 	if ( pBoundaries )
 		return new RowidIterator_Intersect_T<RowidIterator_i,true> ( dIterators.Begin(), dIterators.GetLength(), pBoundaries );
 	else
@@ -1148,7 +1262,11 @@ private:
 	const CSphFilterSettings *				m_pRowIdFilter = nullptr;
 
 	bool				CreateSIIterators ( std::vector<common::BlockIterator_i *> & dFilterIt, const CSphFilterSettings & tFilter, int64_t iRsetSize, CSphString & sWarning );
-	RowidIterator_i *	CreateRowIdIteratorFromSI ( std::vector<common::BlockIterator_i *> & dFilterIt, const CSphFilterSettings & tFilter );
+	RowidIterator_i *	CreateRowIdIteratorFromSI ( std::vector<common::BlockIterator_i *> & dFilterIt, const CSphFilterSettings & tFilter, int64_t iRsetSize );
+	RowidIterator_i *	CreateBitmapIterator ( std::vector<common::BlockIterator_i *> & dFilterIt, const CSphFilterSettings & tFilter );
+	RowidIterator_i *	CreateCachedBitmapIterator ( const CSphFilterSettings & tFilter ) const;
+	bool				IsBitmapCacheable() const { return m_bUseSICache && m_iCutoff<0; }
+	SIBitmapKey_t		GetBitmapKey ( const CSphFilterSettings & tFilter ) const;
 };
 
 
@@ -1198,11 +1316,76 @@ bool SIIteratorCreator_c::CreateSIIterators ( std::vector<common::BlockIterator_
 }
 
 
-RowidIterator_i * SIIteratorCreator_c::CreateRowIdIteratorFromSI ( std::vector<common::BlockIterator_i *> & dFilterIt, const CSphFilterSettings & tFilter )
+SIBitmapKey_t SIIteratorCreator_c::GetBitmapKey ( const CSphFilterSettings & tFilter ) const
+{
+	return { tFilter, m_eCollation, m_tRowidBounds.m_tMinRowID, m_tRowidBounds.m_tMaxRowID };
+}
+
+
+RowidIterator_i * SIIteratorCreator_c::CreateCachedBitmapIterator ( const CSphFilterSettings & tFilter ) const
 {
+	if ( !IsBitmapCacheable() )
+		return nullptr;
+
+	IteratorDesc_t tDesc;
+	auto pBitmap = m_tSI.GetCachedBitmap ( GetBitmapKey(tFilter), tDesc );
+	if ( !pBitmap )
+		return nullptr;
+
+	return new RowidIterator_Bitmap_c ( std::move(pBitmap), tDesc, 0 );
+}
+
+
+RowidIterator_i * SIIteratorCreator_c::CreateBitmapIterator ( std::vector<common::BlockIterator_i *> & dFilterIt, const CSphFilterSettings & tFilter )
+{
+	IteratorDesc_t tDesc { tFilter.m_sAttrName, "SecondaryIndex" };
+	std::vector<common::IteratorDesc_t> dIteratorDesc;
+	dFilterIt[0]->AddDesc(dIteratorDesc);
+	if ( !dIteratorDesc.empty() )
+		tDesc = { dIteratorDesc[0].m_sAttr.c_str(), dIteratorDesc[0].m_sType.c_str() };
+
+	// OR all the value iterators into the bitmap instead of heap-merging them
+	auto pBitmap = std::make_shared<RoaringBitmap_c>();
+	int64_t iProcessed = 0;
+	for ( auto * pIterator : dFilterIt )
+	{
+		std::unique_ptr<common::BlockIterator_i> pIt ( pIterator );
+		util::Span_T<uint32_t> dSpan;
+		while ( pIt->GetNextRowIdBlock(dSpan) )
+		{
+			if ( !m_pRowIdFilter )
+			{
+				pBitmap->Add ( dSpan.begin(), (int)dSpan.size() );
+				continue;
+			}
+
+			for ( auto tRowID : dSpan )
+				if ( tRowID>=m_tRowidBounds.m_tMinRowID && tRowID<=m_tRowidBounds.m_tMaxRowID )
+					pBitmap->Add(tRowID);
+		}
+
+		iProcessed += pIt->GetNumProcessed();
+	}
+
+	dFilterIt.resize(0);
+
+	if ( IsBitmapCacheable() )
+		m_tSI.CacheBitmap ( GetBitmapKey(tFilter), pBitmap, tDesc );
+
+	return new RowidIterator_Bitmap_c ( std::move(pBitmap), tDesc, iProcessed );
+}
+
+
+RowidIterator_i * SIIteratorCreator_c::CreateRowIdIteratorFromSI ( std::vector<common::BlockIterator_i *> & dFilterIt, const CSphFilterSettings & tFilter, int64_t iRsetSize )
+{
+	// bitmap takes a bit per row, rowid list takes 32; once the union is denser than that, bitmap wins
+	const int BITMAP_DENSITY_DIV = 32;
+
 	RowidIterator_i * pIt = nullptr;
 	if ( !dFilterIt.size() )
 		pIt = new RowidEmptyIterator_c ( tFilter.m_sAttrName );
+	else if ( dFilterIt.size()>1 && m_iCutoff<0 && iRsetSize*BITMAP_DENSITY_DIV>=(int64_t)m_uRowsCount )
+		pIt = CreateBitmapIterator ( dFilterIt, tFilter );
 	else if ( dFilterIt.size()==1 )
 	{
 		if ( m_pRowIdFilter )
@@ -1234,11 +1417,16 @@ RowIteratorsWithEstimates_t SIIteratorCreator_c::Create ( CSphString & sWarning
 
 		int64_t iRsetSize = tSIInfo.m_iRsetEstimate;
 		const CSphFilterSettings & tFilter = m_dFilters[i];
-		std::vector<common::BlockIterator_i *> dFilterIt;
-		if ( !CreateSIIterators ( dFilterIt, tFilter, iRsetSize, sWarning ) )
-			continue;
-		
-		RowidIterator_i * pIt = CreateRowIdIteratorFromSI ( dFilterIt, tFilter );
+		RowidIterator_i * pIt = CreateCachedBitmapIterator ( tFilter );
+		if ( !pIt )
+		{
+			std::vector<common::BlockIterator_i *> dFilterIt;
+			if ( !CreateSIIterators ( dFilterIt, tFilter, iRsetSize, sWarning ) )
+				continue;
+
+			pIt = CreateRowIdIteratorFromSI ( dFilterIt, tFilter, iRsetSize );
+		}
+
 		dRes.Add ( { pIt, iRsetSize } );
 		tSIInfo.m_bCreated = true;
 	}
@@ -1248,12 +1436,21 @@ RowIteratorsWithEstimates_t SIIteratorCreator_c::Create ( CSphString & sWarning
 
 /////////////////////////////////////////////////////////////////////
 
+void SIContainer_c::Reset()
+{
+	m_dIndexes.Reset();
+	ResetBitmaps();
+}
+
+
 bool SIContainer_c::Load ( const CSphString & sFile, CSphString & sError )
 {
 	SI::Index_i * pIndex = CreateSecondaryIndex ( sFile.cstr(), sError );
 	if ( !pIndex )
 		return false;
 
+	ResetBitmaps();
+
 	m_dIndexes.Add ( { std::unique_ptr<SI::Index_i>(pIndex) } );
 	return true;
 }
@@ -1265,6 +1462,7 @@ bool SIContainer_c::Drop ( const CSphString & sFile, CSphString & sError )
 		if ( sFile==m_dIndexes[i].m_pIndex->GetFilename().c_str() )
 		{
 			m_dIndexes.Remove(i);
+			ResetBitmaps();
 			return true;
 		}
 
@@ -1293,6 +1491,9 @@ bool SIContainer_c::ColumnUpdated ( const CSphString & sAttr )
 		}
 	}
 
+	if ( bUpdated )
+		ResetBitmaps();
+
 	return bUpdated;
 }
 
@@ -1384,6 +1585,125 @@ void SIContainer_c::ClearCache()
 {
 	for ( auto & i : m_dIndexes )
 		i.m_pIndex->ClearCache();
+
+	ResetBitmaps();
+}
+
+
+SIBitmapKey_t::SIBitmapKey_t ( const CSphFilterSettings & tFilter, ESphCollation eCollation, RowID_t tMinRowID, RowID_t tMaxRowID )
+	: m_sAttrName ( tFilter.m_sAttrName )
+	, m_tSettings ( tFilter )
+	, m_eMvaFunc ( tFilter.m_eMvaFunc )
+	, m_bIsNull ( tFilter.m_bIsNull )
+	, m_eCollation ( eCollation )
+	, m_tMinRowID ( tMinRowID )
+	, m_tMaxRowID ( tMaxRowID )
+{
+	m_dValues.Append ( tFilter.GetValues() );
+	for ( const auto & sString : tFilter.m_dStrings )
+		m_dStrings.Add ( sString );
+
+	// field by field; the raw struct has padding and unused parts of the min/max unions
+	const CommonFilterSettings_t & tS = m_tSettings;
+	uint64_t uHash = sphFNV64cont ( m_sAttrName.cstr(), SPH_FNV64_SEED );
+	uHash = sphFNV64 ( (int)tS.m_eType, uHash );
+	if ( tS.m_eType==SPH_FILTER_FLOATRANGE )
+		uHash = sphFNV64 ( sphF2DW ( tS.m_fMaxValue ), sphFNV64 ( sphF2DW ( tS.m_fMinValue ), uHash ) );
+	else
+		uHash = sphFNV64 ( tS.m_iMaxValue, sphFNV64 ( tS.m_iMinValue, uHash ) );
+
+	uHash = sphFNV64 ( (int)tS.m_bHasEqualMin | (int)tS.m_bHasEqualMax<<1 | (int)tS.m_bOpenLeft<<2 | (int)tS.m_bOpenRight<<3 | (int)tS.m_bExclude<<4 | (int)m_bIsNull<<5, uHash );
+	uHash = sphFNV64 ( (int)tS.m_eStrCmpDir, uHash );
+	uHash = sphFNV64 ( (int)m_eMvaFunc, uHash );
+	uHash = sphFNV64 ( (int)m_eCollation, uHash );
+	uHash = sphFNV64 ( m_dValues.GetLength(), uHash );
+	for ( auto tValue : m_dValues )
+		uHash = sphFNV64 ( tValue, uHash );
+
+	uHash = sphFNV64 ( m_dStrings.GetLength(), uHash );
+	for ( const auto & sString : m_dStrings )
+		uHash = sphFNV64cont ( sString.scstr(), uHash );
+
+	m_uHash = sphFNV64 ( m_tMaxRowID, sphFNV64 ( m_tMinRowID, uHash ) );
+}
+
+
+bool SIBitmapKey_t::operator== ( const SIBitmapKey_t & tRhs ) const
+{
+	const CommonFilterSettings_t & tA = m_tSettings;
+	const CommonFilterSettings_t & tB = tRhs.m_tSettings;
+	if ( m_uHash!=tRhs.m_uHash || tA.m_eType!=tB.m_eType || m_sAttrName!=tRhs.m_sAttrName )
+		return false;
+
+	bool bSameRange = tA.m_eType==SPH_FILTER_FLOATRANGE
+		? ( tA.m_fMinValue==tB.m_fMinValue && tA.m_fMaxValue==tB.m_fMaxValue )
+		: ( tA.m_iMinValue==tB.m_iMinValue && tA.m_iMaxValue==tB.m_iMaxValue );
+
+	if ( !bSameRange || tA.m_bHasEqualMin!=tB.m_bHasEqualMin || tA.m_bHasEqualMax!=tB.m_bHasEqualMax || tA.m_bOpenLeft!=tB.m_bOpenLeft
+		|| tA.m_bOpenRight!=tB.m_bOpenRight || tA.m_bExclude!=tB.m_bExclude || tA.m_eStrCmpDir!=tB.m_eStrCmpDir )
+		return false;
+
+	if ( m_eMvaFunc!=tRhs.m_eMvaFunc || m_bIsNull!=tRhs.m_bIsNull || m_eCollation!=tRhs.m_eCollation || m_tMinRowID!=tRhs.m_tMinRowID || m_tMaxRowID!=tRhs.m_tMaxRowID )
+		return false;
+
+	if ( m_dValues.GetLength()!=tRhs.m_dValues.GetLength() || m_dStrings.GetLength()!=tRhs.m_dStrings.GetLength() )
+		return false;
+
+	if ( !m_dValues.IsEmpty() && memcmp ( m_dValues.Begin(), tRhs.m_dValues.Begin(), m_dValues.GetLengthBytes() ) )
+		return false;
+
+	ARRAY_FOREACH ( i, m_dStrings )
+		if ( m_dStrings[i]!=tRhs.m_dStrings[i] )
+			return false;
+
+	return true;
+}
+
+
+std::shared_ptr<const RoaringBitmap_c> SIContainer_c::GetCachedBitmap ( const SIBitmapKey_t & tKey, IteratorDesc_t & tDesc ) const
+{
+	ScopedMutex_t tLock ( m_tBitmapsLock );
+	ARRAY_FOREACH ( i, m_dBitmaps )
+		if ( m_dBitmaps[i].m_tKey==tKey )
+		{
+			CachedBitmap_t tFound = m_dBitmaps[i];
+			m_dBitmaps.Remove(i);
+			m_dBitmaps.Add(tFound);
+			tDesc = tFound.m_tDesc;
+			return tFound.m_pBitmap;
+		}
+
+	return nullptr;
+}
+
+
+void SIContainer_c::CacheBitmap ( SIBitmapKey_t tKey, std::shared_ptr<const RoaringBitmap_c> pBitmap, const IteratorDesc_t & tDesc ) const
+{
+	int64_t iBytes = pBitmap->GetSizeBytes();
+	if ( iBytes>MAX_CACHED_BITMAP_BYTES )
+		return;
+
+	ScopedMutex_t tLock ( m_tBitmapsLock );
+	if ( m_dBitmaps.any_of ( [&tKey]( const auto & tCached ){ return tCached.m_tKey==tKey; } ) )
+		return;
+
+	// evict least recently used ones
+	while ( !m_dBitmaps.IsEmpty() && m_iBitmapBytes+iBytes>MAX_CACHED_BITMAP_BYTES )
+	{
+		m_iBitmapBytes -= m_dBitmaps[0].m_pBitmap->GetSizeBytes();
+		m_dBitmaps.Remove(0);
+	}
+
+	m_dBitmaps.Add ( { std::move(tKey), std::move(pBitmap), tDesc } );
+	m_iBitmapBytes += iBytes;
+}
+
+
+void SIContainer_c::ResetBitmaps()
+{
+	ScopedMutex_t tLock ( m_tBitmapsLock );
+	m_dBitmaps.Reset();
+	m_iBitmapBytes = 0;
 }
 
 RowIteratorsWithEstimates_t SIContainer_c::CreateSecondaryIndexIterator ( CSphVector<SecondaryIndexInfo_t> & dSIInfo, const CSphVector<CSphFilterSettings> & dFilters, ESphCollation eCollation, const ISphSchema & tSchema, RowID_t uRowsCount, int iCutoff, bool bUseSICache, CSphString & sWarning ) const
@@ -16,6 +16,7 @@
 #include "columnarmisc.h"
 #include "costestimate.h"
 #include "secondary/secondary.h"
+#include "std/roaring.h"
 
 #include <math.h>
 #include <vector>
@@ -38,6 +39,26 @@ public:
 
 using RowIteratorsWithEstimates_t = CSphVector<std::pair<RowidIterator_i *,int64_t>>;
 
+/// everything a cached filter bitmap depends on. The hash only rejects quickly, a hit is confirmed by comparing the whole key
+struct SIBitmapKey_t
+{
+	CSphString				m_sAttrName;
+	CommonFilterSettings_t	m_tSettings;
+	CSphVector<SphAttr_t>	m_dValues;
+	StrVec_t				m_dStrings;
+	ESphMvaFunc				m_eMvaFunc = SPH_MVAFUNC_NONE;
+	bool					m_bIsNull = false;
+	ESphCollation			m_eCollation = SPH_COLLATION_DEFAULT;
+	RowID_t					m_tMinRowID = 0;
+	RowID_t					m_tMaxRowID = 0;
+	uint64_t				m_uHash = 0;
+
+				SIBitmapKey_t() = default;
+				SIBitmapKey_t ( const CSphFilterSettings & tFilter, ESphCollation eCollation, RowID_t tMinRowID, RowID_t tMaxRowID );
+
+	bool		operator== ( const SIBitmapKey_t & tRhs ) const;
+};
+
 class SIContainer_c
 {
 	friend void operator << ( JsonEscapedBuilder & tOut, const SIContainer_c & tSI );
@@ -47,7 +68,7 @@ public:
 	bool		Drop ( const CSphString & sFile, CSphString & sError );
 	void		UpdateFilename ( const CSphString & sOldFile, const CSphString & sNewFile );
 	bool		IsEmpty() const { return m_dIndexes.IsEmpty(); }
-	void		Reset() { m_dIndexes.Reset(); }
+	void		Reset();
 
 	bool		ColumnUpdated ( const CSphString & sAttr );
 	bool		SaveMeta ( CSphString & sError ) const;
@@ -61,13 +82,32 @@ public:
 
 	RowIteratorsWithEstimates_t CreateSecondaryIndexIterator ( CSphVector<SecondaryIndexInfo_t> & dSIInfo, const CSphVector<CSphFilterSettings> & dFilters, ESphCollation eCollation, const ISphSchema & tSchema, RowID_t uRowsCount, int iCutoff, bool bUseSICache, CSphString & sWarning ) const;
 
+	// rowid bitmaps of dense filters, kept for repeated queries
+	std::shared_ptr<const RoaringBitmap_c> GetCachedBitmap ( const SIBitmapKey_t & tKey, IteratorDesc_t & tDesc ) const;
+	void		CacheBitmap ( SIBitmapKey_t tKey, std::shared_ptr<const RoaringBitmap_c> pBitmap, const IteratorDesc_t & tDesc ) const;
+
 private:
 	struct IndexInfo_t
 	{
 		std::unique_ptr<SI::Index_i>	m_pIndex;
 	};
 
+	struct CachedBitmap_t
+	{
+		SIBitmapKey_t							m_tKey;
+		std::shared_ptr<const RoaringBitmap_c>	m_pBitmap;
+		IteratorDesc_t							m_tDesc;
+	};
+
+	static const int64_t MAX_CACHED_BITMAP_BYTES = 16*1024*1024;
+
 	CSphVector<IndexInfo_t> m_dIndexes;
+
+	mutable CSphMutex					m_tBitmapsLock;
+	mutable CSphVector<CachedBitmap_t>	m_dBitmaps GUARDED_BY ( m_tBitmapsLock );	///< most recently used last
+	mutable int64_t						m_iBitmapBytes GUARDED_BY ( m_tBitmapsLock ) = 0;
+
+	void		ResetBitmaps();
 };
 
 struct RowIdBoundaries_t;
@@ -75,6 +75,23 @@ public:
 	}
 };
 
+/// serialize the group's distinct values into the sketch attr (replacing the previous one)
+template <typename UNIQ>
+static void SetDistinctSketch ( CSphMatch & tMatch, const CSphAttrLocator & tLoc, const UNIQ & tUniq, SphGroupKey_t uGroup, CSphVector<BYTE> & dSketch )
+{
+	tUniq.SaveSketch ( uGroup, dSketch );
+	sphDeallocatePacked ( (const BYTE *)tMatch.GetAttr ( tLoc ) );
+	tMatch.SetAttr ( tLoc, (SphAttr_t)sphPackPtrAttr ( { dSketch.Begin(), dSketch.GetLength() } ) );
+}
+
+/// merge the sketch that came with a grouped match; false if there's none (e.g. from an older agent) or it doesn't fit
+template <typename UNIQ>
+static bool MergeDistinctSketch ( const CSphMatch & tEntry, const CSphAttrLocator & tLoc, UNIQ & tUniq, SphGroupKey_t uGroup )
+{
+	ByteBlob_t tSketch = tEntry.FetchAttrData ( tLoc, nullptr );
+	return tSketch.second && tUniq.MergeSketch ( uGroup, tSketch );
+}
+
 /// match sorter with k-buffering and group-by - common part
 template<typename COMPGROUP, typename UNIQ, int DISTINCT, bool NOTIFICATIONS>
 class KBufferGroupSorter_T : public CSphMatchQueueTraits, protected BaseGroupSorter_c
@@ -82,6 +99,7 @@ class KBufferGroupSorter_T : public CSphMatchQueueTraits, protected BaseGroupSor
 	using MYTYPE = KBufferGroupSorter_T<COMPGROUP,UNIQ,DISTINCT,NOTIFICATIONS>;
 	using BASE = CSphMatchQueueTraits;
 	using BaseGroupSorter_c::AggrDiscard;
+	static constexpr bool IS_HLL = std::is_base_of_v<UniqHLLTraits_c,UNIQ>;
 
 public:
 	KBufferGroupSorter_T ( const ISphMatchComparator * pComp, const CSphQuery * pQuery, const CSphGroupSorterSettings & tSettings )
@@ -194,6 +212,7 @@ protected:
 	CSphVector<AggrFunc_i *>	m_dAvgs;
 	bool						m_bAvgFinal = false;
 	CSphVector<SphAttr_t>		m_dDistinctKeys;
+	CSphVector<BYTE>			m_dSketch;
 	static const int			GROUPBY_FACTOR = 4;	///< allocate this times more storage when doing group-by (k, as in k-buffer)
 
 	/// finalize distinct counters
@@ -205,8 +224,13 @@ protected:
 		for ( int iCount = m_tUniq.CountStart ( uGroup ); iCount; iCount = m_tUniq.CountNext ( uGroup ) )
 		{
 			CSphMatch * pMatch = fnFind ( uGroup );
-			if ( pMatch )
-				pMatch->SetAttr ( m_tLocDistinct, iCount );
+			if ( !pMatch )
+				continue;
+
+			pMatch->SetAttr ( m_tLocDistinct, iCount );
+			if constexpr ( IS_HLL )
+				if ( m_bEmitDistinctSketch )
+					SetDistinctSketch ( *pMatch, m_tLocDistinctSketch, m_tUniq, uGroup, m_dSketch );
 		}
 	}
 
@@ -283,6 +307,16 @@ protected:
 	template <bool GROUPED>
 	FORCE_INLINE void UpdateDistinct ( const CSphMatch & tEntry, const SphGroupKey_t uGroupKey )
 	{
+		if constexpr ( GROUPED && IS_HLL )
+			if ( m_tLocDistinctSketch.m_iBitOffset>=0 )
+			{
+				// a row without a usable sketch (older agent, less accurate registers) has only its group's count; add it up
+				if ( !MergeDistinctSketch ( tEntry, m_tLocDistinctSketch, m_tUniq, uGroupKey ) )
+					m_tUniq.AddCount ( uGroupKey, (int)tEntry.GetAttr ( m_tLocDistinct ) );
+
+				return;
+			}
+
 		int iCount = 1;
 		if constexpr ( GROUPED )
 			iCount = (int)tEntry.GetAttr ( m_tLocDistinct );
@@ -1724,6 +1758,7 @@ class CSphImplicitGroupSorter final : public MatchSorter_c, ISphNoncopyable, pro
 	using MYTYPE = CSphImplicitGroupSorter<COMPGROUP, UNIQ, DISTINCT, NOTIFICATIONS, HAS_AGGREGATES>;
 	using BASE = MatchSorter_c;
 	using BaseGroupSorter_c::AggrDiscard;
+	static constexpr bool IS_HLL = std::is_base_of_v<UniqHLLTraits_c,UNIQ>;
 
 public:
 	CSphImplicitGroupSorter ( const ISphMatchComparator * DEBUGARG(pComp), const CSphQuery *, const CSphGroupSorterSettings & tSettings )
@@ -1882,6 +1917,7 @@ protected:
 
 private:
 	CSphVector<SphAttr_t> m_dDistinctKeys;
+	CSphVector<BYTE>	m_dSketch;
 	CSphRefcountedPtr<DistinctFetcher_i> m_pDistinctFetcher;
 
 	inline void SetupBaseGrouperWrp ( ISphSchema * pSchema )	{ SetupBaseGrouper ( pSchema, DISTINCT ); }
@@ -1892,6 +1928,15 @@ private:
 	template <bool GROUPED = true>
 	void UpdateDistinct ( const CSphMatch & tEntry )
 	{
+		if constexpr ( GROUPED && IS_HLL )
+			if ( m_tLocDistinctSketch.m_iBitOffset>=0 )
+			{
+				if ( !MergeDistinctSketch ( tEntry, m_tLocDistinctSketch, m_tUniq, 0 ) )
+					m_tUniq.AddCount ( 0, (int)tEntry.GetAttr ( m_tLocDistinct ) );
+
+				return;
+			}
+
 		int iCount = 1;
 		if constexpr ( GROUPED )
 			iCount = (int) tEntry.GetAttr ( m_tLocDistinct );
@@ -1980,6 +2025,9 @@ private:
 
 		assert ( m_bDataInitialized );
 		m_tData.SetAttr ( m_tLocDistinct, m_tUniq.CountDistinct() );
+		if constexpr ( IS_HLL )
+			if ( m_bEmitDistinctSketch )
+				SetDistinctSketch ( m_tData, m_tLocDistinctSketch, m_tUniq, 0, m_dSketch );
 	}
 };
 
@@ -2026,7 +2074,10 @@ static ISphMatchSorter * CreateGroupSorter ( const ISphMatchComparator * pComp,
 	using UniqCount_c		= UniqGrouped_T<ValueWithGroupCount_t>;
 	using UniqCountSingle_c = UniqSingle_T<ValueWithCount_t>;
 
-	BYTE uSelector3rd = 32*( bUseHLL ? 1 : 0 ) + 16*( tSettings.m_bGrouped ? 1:0 ) + 8*( tSettings.m_bJson ? 1:0 ) + 4*( pQuery->m_iGroupbyLimit>1 ? 1:0 ) + 2*( tSettings.m_bImplicit ? 1:0 ) + ( ( tSettings.m_pGrouper && tSettings.m_pGrouper->IsMultiValue() ) ? 1:0 );
+	// grouped matches with HLL sketches are merged as sketches, the others carry a single value along with its count
+	bool bGroupedCounts = tSettings.m_bGrouped && !( bUseHLL && tSettings.m_tLocDistinctSketch.m_iBitOffset>=0 );
+
+	BYTE uSelector3rd = 32*( bUseHLL ? 1 : 0 ) + 16*( bGroupedCounts ? 1:0 ) + 8*( tSettings.m_bJson ? 1:0 ) + 4*( pQuery->m_iGroupbyLimit>1 ? 1:0 ) + 2*( tSettings.m_bImplicit ? 1:0 ) + ( ( tSettings.m_pGrouper && tSettings.m_pGrouper->IsMultiValue() ) ? 1:0 );
 	switch ( uSelector3rd )
 	{
 	case 0:	CREATE_SORTER_4TH ( CSphKBufferGroupSorter,		COMPGROUP, Uniq_c,		pComp, pQuery, tSettings, bHasPackedFactors, bHasAggregates );
@@ -131,9 +131,13 @@ static const int	MIN_READ_BUFFER			= 8192;
 static const int	MIN_READ_UNHINTED		= 1024;
 
 static int 			g_iReadUnhinted 		= DEFAULT_READ_UNHINTED;
+static bool			g_bReadPrefetch			= false;
+
+static int			g_iSortThreads			= 1;
 
 static bool			g_bPseudoSharding		= true;
 static int			g_iPseudoShardingThresh	= 8192;
+static bool			g_bMinMaxPruning		= true;
 
 static BuildBufferSettings_t g_tMergeSettings;
 
@@ -196,11 +200,12 @@ const char * sphGetRankerName ( ESphRankMode eRanker )
 class DiskIndexQwordSetup_c final : public ISphQwordSetup
 {
 public:
-	DiskIndexQwordSetup_c ( DataReaderFactoryPtr_c pDoclist, DataReaderFactoryPtr_c pHitlist, const BYTE * pSkips, int iSkiplistBlockSize, bool bSetupReaders, RowID_t iRowsCount )
+	DiskIndexQwordSetup_c ( DataReaderFactoryPtr_c pDoclist, DataReaderFactoryPtr_c pHitlist, const BYTE * pSkips, int iSkiplistBlockSize, bool bBlockMax, bool bSetupReaders, RowID_t iRowsCount )
 		: m_pDoclist ( std::move ( pDoclist ) )
 		, m_pHitlist ( std::move ( pHitlist ) )
 		, m_pSkips ( pSkips )
 		, m_iSkiplistBlockSize ( iSkiplistBlockSize )
+		, m_bBlockMax ( bBlockMax )
 		, m_bSetupReaders ( bSetupReaders )
 		, m_iRowsCount ( iRowsCount )
 	{}
@@ -215,6 +220,7 @@ private:
 	DataReaderFactoryPtr_c		m_pHitlist;
 	const BYTE *				m_pSkips;
 	int							m_iSkiplistBlockSize = 0;
+	bool						m_bBlockMax = false;		///< whether skiplists carry block-max
 	bool						m_bSetupReaders = false;
 	RowID_t						m_iRowsCount = INVALID_ROWID;
 
@@ -250,12 +256,22 @@ public:
 		if ( m_rdHitlist )
 			m_rdHitlist->Reset ();
 		ResetDecoderState();
+		m_bHitlistPrefetched = false;
+		m_iSkipListBlock = -1;
+		m_iBlockMaxEntry = 0;
 	}
 
 	void GetHitlistEntry ()
 	{
 		assert ( !m_bHitlistOver );
-		DWORD iDelta = m_rdHitlist->UnzipInt ();
+		if ( m_iHitDelta>=m_iHitDeltas )
+		{
+			// block decoding stops right after the end-of-hitlist marker, so the reader is never ahead of the hitlist
+			m_iHitDeltas = m_rdHitlist->UnzipInts ( m_dHitDeltas, HIT_BLOCK_LEN );
+			m_iHitDelta = 0;
+		}
+
+		DWORD iDelta = m_dHitDeltas[m_iHitDelta++];
 		if ( iDelta )
 		{
 			m_iHitPos += iDelta;
@@ -332,12 +348,50 @@ public:
 			return false;
 
 		m_rdDoclist->SeekTo ( t.m_iOffset, -1 );
+		ResetDoclistBlock();
 		m_tDoc.m_tRowID = t.m_tBaseRowIDPlus1-1;
 		m_uHitPosition = m_iHitlistPos = t.m_iBaseHitlistPos;
+		m_bHitlistPrefetched = false;	// hits of the new block are far from what was prefetched before
+
+		return true;
+	}
+
+	bool GetBlockMax ( DWORD & uMaxHits, DWORD & uFields ) final
+	{
+		if ( !m_pSkipData || !m_pSkipData->m_bBlockMax )
+			return false;
+
+		const auto & dSkiplist = m_pSkipData->m_dSkiplist;
+		SphOffset_t iPos = m_rdDoclist->GetPos();
+		while ( m_iBlockMaxEntry<dSkiplist.GetLength()-1 && dSkiplist[m_iBlockMaxEntry+1].m_iOffset<=iPos )
+			m_iBlockMaxEntry++;
+
+		// the last block ends with the doclist, and we can't skip to its end
+		if ( m_iBlockMaxEntry>=dSkiplist.GetLength()-1 || dSkiplist[m_iBlockMaxEntry].m_iOffset!=iPos )
+			return false;
 
+		uMaxHits = dSkiplist[m_iBlockMaxEntry].m_uMaxHits;
+		uFields = dSkiplist[m_iBlockMaxEntry].m_uFields;
 		return true;
 	}
 
+	int SkipBlock() final
+	{
+		assert ( m_pSkipData && m_iBlockMaxEntry<m_pSkipData->m_dSkiplist.GetLength()-1 );
+		assert ( m_pSkipData->m_dSkiplist[m_iBlockMaxEntry].m_iOffset==m_rdDoclist->GetPos() );
+
+		// same as HintRowID() does, with the next block start
+		m_iSkipListBlock = ++m_iBlockMaxEntry;
+		const SkiplistEntry_t & t = m_pSkipData->m_dSkiplist[m_iSkipListBlock];
+		m_rdDoclist->SeekTo ( t.m_iOffset, -1 );
+		ResetDoclistBlock();
+		m_tDoc.m_tRowID = t.m_tBaseRowIDPlus1-1;
+		m_uHitPosition = m_iHitlistPos = t.m_iBaseHitlistPos;
+		m_bHitlistPrefetched = false;
+
+		return m_pSkipData->m_iBlockDocs;
+	}
+
 	const CSphMatch & GetNextDoc() override
 	{
 		ReadNext();
@@ -346,6 +400,7 @@ public:
 
 	void SeekHitlist ( SphOffset_t uOff ) final
 	{
+		m_iHitDelta = m_iHitDeltas = 0;
 		if ( uOff >> 63 )
 		{
 			m_uHitState = 1;
@@ -397,10 +452,11 @@ public:
 
 private:
 	int m_iSkipListBlock = -1;
+	int m_iBlockMaxEntry = 0;	///< skiplist entry of the block we're in, for block-max lookups
 
 	inline void ReadNext()
 	{
-		RowID_t uDelta = m_rdDoclist->UnzipRowid();
+		RowID_t uDelta = m_bBlockDoclist ? UnzipBlockRowid() : m_rdDoclist->UnzipRowid();
 		if ( uDelta )
 		{
 			m_bAllFieldsKnown = false;
@@ -423,6 +479,7 @@ private:
 					m_dQwordFields.Assign32 ( uFirst );
 					m_uHitPosition += m_rdDoclist->UnzipOffset();
 					m_iHitlistPos = m_uHitPosition;
+					PrefetchHitlist();
 				}
 			} else
 			{
@@ -430,6 +487,7 @@ private:
 				assert ( iDeltaPos>=0 );
 
 				m_iHitlistPos += iDeltaPos;
+				PrefetchHitlist();
 
 				m_dQwordFields.Assign32 ( m_rdDoclist->UnzipInt() );
 				m_uMatchHits = m_rdDoclist->UnzipInt();
@@ -438,17 +496,33 @@ private:
 			m_tDoc.m_tRowID = INVALID_ROWID;
 	}
 
+	// hits are read much later than the doclist entry that points to them
+	// so start reading the beginning of the hitlist once its offset is known
+	inline void PrefetchHitlist()
+	{
+		if ( m_bHitlistPrefetched || !m_bHasHitlist || !m_rdHitlist )
+			return;
+
+		m_rdHitlist->Prefetch ( m_iHitlistPos, READ_NO_SIZE_HINT );
+		m_bHitlistPrefetched = true;
+	}
+
 private:
 	int64_t m_iIndexId = 0;
+	bool	m_bHitlistPrefetched = false;
 };
 
 
-DiskIndexQwordTraits_c * sphCreateDiskIndexQword ( bool bInlineHits )
+DiskIndexQwordTraits_c * sphCreateDiskIndexQword ( bool bInlineHits, bool bBlockDoclist )
 {
+	DiskIndexQwordTraits_c * pQword;
 	if ( bInlineHits )
-		return new DiskIndexQword_c<true,false> ( false, false, 0 );
+		pQword = new DiskIndexQword_c<true,false> ( false, false, 0 );
+	else
+		pQword = new DiskIndexQword_c<false,false> ( false, false, 0 );
 
-	return new DiskIndexQword_c<false,false> ( false, false, 0 );
+	pQword->m_bBlockDoclist = bBlockDoclist;
+	return pQword;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -485,9 +559,10 @@ class DiskPayloadQword_c : public DiskIndexQword_c<INLINE_HITS, false>
 	typedef DiskIndexQword_c<INLINE_HITS, false> BASE;
 
 public:
-	DiskPayloadQword_c ( const DiskSubstringPayload_t * pPayload, bool bExcluded, DataReaderFactory_c * pDoclist, DataReaderFactory_c * pHitlist, int64_t iIndexId )
+	DiskPayloadQword_c ( const DiskSubstringPayload_t * pPayload, bool bExcluded, DataReaderFactory_c * pDoclist, DataReaderFactory_c * pHitlist, int64_t iIndexId, bool bBlockDoclist )
 		: BASE ( true, bExcluded, iIndexId )
 	{
+		this->m_bBlockDoclist = bBlockDoclist;
 		m_pPayload = pPayload;
 		this->m_iDocs = m_pPayload->m_iTotalDocs;
 		this->m_iHits = m_pPayload->m_iTotalHits;
@@ -529,6 +604,7 @@ private:
 		m_iDoclist++;
 
 		this->m_rdDoclist->SeekTo ( uDocOff, iHint );
+		this->ResetDoclistBlock();
 	}
 
 	const DiskSubstringPayload_t *	m_pPayload;
@@ -1255,6 +1331,7 @@ public:
 	int					KillDupes() final;
 	int					CheckThenKillMulti ( const VecTraits_T<DocID_t>& dKlist, BlockerFn&& fnWatcher ) final;
 	bool				IsAlive ( DocID_t tDocID ) const final;
+	VecTraits_T<DocID_t> ClipKillList ( const VecTraits_T<DocID_t> & dKlist ) const;
 
 	const CSphSourceStats &		GetStats () const final { return m_tStats; }
 	int64_t *			GetFieldLens() const final { return m_tSettings.m_bIndexFieldLens ? m_dFieldLens.begin() : nullptr; }
@@ -1288,6 +1365,8 @@ public:
 	const SIContainer_c * GetSI() const override { return &m_tSI; }
 
 	bool				CheckEarlyReject ( const CSphVector<CSphFilterSettings> & dFilters, const ISphFilter * pFilter, ESphCollation eCollation, const ISphSchema & tSchema ) const;
+	bool				IsRejectedByMinMax ( const CSphQuery & tQuery ) const;
+	bool				NarrowRowIdBoundaries ( const CSphQueryContext & tCtx, const CSphQuery & tQuery, RowIdBoundaries_t & tBoundaries, int64_t & iPrunedBlocks ) const;
 	std::pair<int64_t,int> GetPseudoShardingMetric ( const VecTraits_T<const CSphQuery> & dQueries, const VecTraits_T<int64_t> & dMaxCountDistinct, int iThreads, bool & bForceSingleThread ) const override;
 	int64_t				GetCountDistinct ( const CSphString & sAttr, CSphString & sModifiedAttr ) const override;
 	int64_t				GetCountFilter ( const CSphFilterSettings & tFilter, CSphString & sModifiedAttr ) const override;
@@ -1321,6 +1400,8 @@ private:
 
 	CSphMappedBuffer<BYTE>		m_tDocidLookup;		///< speeds up docid-rowid lookups + used for applying killlist on startup
 	LookupReader_c				m_tLookupReader;	///< used by getrowidbydocid
+	DocidLookupFilter_c			m_tLookupFilter;	///< built on preread; lets lookups skip docids this index surely doesn't have
+	std::atomic<bool>			m_bLookupFilterReady {false};
 
 	std::unique_ptr<Docstore_i>	m_pDocstore;
 	std::unique_ptr<columnar::Columnar_i> m_pColumnar;
@@ -1355,7 +1436,7 @@ private:
 	bool						MultiScan ( CSphQueryResult& tResult, const CSphQuery& tQuery, const VecTraits_T<ISphMatchSorter*>& dSorters, const CSphMultiQueryArgs& tArgs, int64_t tmMaxTimer ) const;
 
 	template<bool USE_KLIST, bool RANDOMIZE, bool USE_FACTORS, bool HAS_SORT_CALC, bool HAS_WEIGHT_FILTER, bool HAS_FILTER_CALC, bool HAS_CUTOFF>
-	void						MatchExtended ( CSphQueryContext & tCtx, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *>& dSorters, ISphRanker * pRanker, int iTag, int iIndexWeight, int iCutoff ) const;
+	void						MatchExtended ( CSphQueryContext & tCtx, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *>& dSorters, ISphRanker * pRanker, int iTag, int iIndexWeight, int iCutoff, ISphMatchSorter * pPruneSorter, std::atomic<int64_t> * pSharedFloor ) const;
 
 	const CSphRowitem *			FindDocinfo ( DocID_t tDocID ) const;
 
@@ -1467,6 +1548,18 @@ int GetUnhintedBuffer()
 }
 
 
+void SetReadPrefetch ( bool bPrefetch )
+{
+	g_bReadPrefetch = bPrefetch;
+}
+
+
+bool GetReadPrefetch()
+{
+	return g_bReadPrefetch;
+}
+
+
 // returns correct size even if iBuf is 0
 int GetReadBuffer ( int iBuf )
 {
@@ -3168,10 +3261,21 @@ void CSphIndex_VLN::KillExistingDocids ( CSphIndex * pTarget ) const
 }
 
 
+VecTraits_T<DocID_t> CSphIndex_VLN::ClipKillList ( const VecTraits_T<DocID_t> & dKlist ) const
+{
+	bool bFilter = m_bLookupFilterReady.load ( std::memory_order_acquire );
+	return ::ClipKillList ( dKlist, m_tLookupReader, bFilter ? &m_tLookupFilter : nullptr );
+}
+
+
 int CSphIndex_VLN::KillMulti ( const VecTraits_T<DocID_t> & dKlist )
 {
+	auto dClipped = ClipKillList ( dKlist );
+	if ( dClipped.IsEmpty() )
+		return 0;
+
 	LookupReaderIterator_c tTargetReader ( m_tDocidLookup.GetReadPtr() );
-	DocidListReader_c tKillerReader ( dKlist );
+	DocidListReader_c tKillerReader ( dClipped );
 
 	int iTotalKilled;
 	if ( !HasKillHook() )
@@ -3218,8 +3322,12 @@ int CSphIndex_VLN::KillDupes()
 
 int CSphIndex_VLN::CheckThenKillMulti ( const VecTraits_T<DocID_t>& dKlist, BlockerFn&& fnWatcher )
 {
+	auto dClipped = ClipKillList ( dKlist );
+	if ( dClipped.IsEmpty() )
+		return 0;
+
 	LookupReaderIterator_c tTargetReader ( m_tDocidLookup.GetReadPtr() );
-	DocidListReader_c tKillerReader ( dKlist );
+	DocidListReader_c tKillerReader ( dClipped );
 
 	int iTotalKilled = ProcessIntersected ( tTargetReader, tKillerReader, [this,fnWatcher=std::move(fnWatcher)] ( RowID_t tRow, DocID_t tDoc )
 	{
@@ -3427,6 +3535,95 @@ struct CmpHit_fn
 	}
 };
 
+/// helper threads which live as long as the sorter, so every block and pass hands out jobs instead of spawning threads
+class HitBlockSorter_c::Workers_c
+{
+public:
+	explicit Workers_c ( int iThreads )
+		: m_pPool ( Threads::MakeThreadPool ( iThreads, "sort_hits" ) )
+	{}
+
+	/// runs fnJob(0)..fnJob(iJobs-1) and waits for all of them; job 0 goes on the calling thread
+	template<typename FN>
+	void Run ( int iJobs, FN && fnJob )
+	{
+		for ( int i=1; i<iJobs; ++i )
+			m_pPool->Schedule ( [this, &fnJob, i] { fnJob(i); m_tDone.SetEvent(); }, false );
+
+		fnJob(0);
+		for ( int i=1; i<iJobs; ++i )
+			m_tDone.WaitEvent();
+	}
+
+private:
+	Threads::WorkerSharedPtr_t	m_pPool;
+	CSphAutoEvent				m_tDone;
+};
+
+
+HitBlockSorter_c::HitBlockSorter_c ( int iThreads )
+	: m_iThreads ( Max ( iThreads, 1 ) )
+{
+	if ( m_iThreads>1 )
+		m_pWorkers = std::make_unique<Workers_c> ( m_iThreads-1 );
+}
+
+
+HitBlockSorter_c::~HitBlockSorter_c() = default;
+
+
+void HitBlockSorter_c::Sort ( CSphWordHit * pHits, int iHits )
+{
+	if ( m_iThreads<=1 || iHits<MIN_PARALLEL_HITS*2 )
+	{
+		sphSort ( pHits, iHits, CmpHit_fn() );
+		return;
+	}
+
+	// pick the run splitters from a sorted sample of the block
+	int iRuns = Min ( m_iThreads, iHits/MIN_PARALLEL_HITS );
+	const int SAMPLES_PER_RUN = 64;
+	CSphFixedVector<CSphWordHit> dSample ( iRuns*SAMPLES_PER_RUN );
+	ARRAY_FOREACH ( i, dSample )
+		dSample[i] = pHits[(int64_t)iHits*i/dSample.GetLength()];
+	sphSort ( dSample.Begin(), dSample.GetLength(), CmpHit_fn() );
+
+	// cut the block into runs in place, so no scratch buffer is needed; every pass splits each
+	// range of runs at its middle splitter, partitioning all the ranges concurrently
+	CSphFixedVector<int> dBounds ( iRuns+1 );
+	dBounds[0] = 0;
+	dBounds[iRuns] = iHits;
+
+	CSphVector<std::pair<int,int>> dRanges; // first and last+1 run of every range still to split
+	dRanges.Add ( { 0, iRuns } );
+	while ( !dRanges.IsEmpty() )
+	{
+		m_pWorkers->Run ( dRanges.GetLength(), [pHits, &dRanges, &dBounds, &dSample] ( int iRange ) {
+			auto [iFirst, iLast] = dRanges[iRange];
+			int iMid = ( iFirst+iLast )/2;
+			const CSphWordHit & tSplit = dSample[iMid*SAMPLES_PER_RUN];
+			CSphWordHit * pMid = std::partition ( pHits+dBounds[iFirst], pHits+dBounds[iLast], [&tSplit] ( const CSphWordHit & tHit ) { return CmpHit_fn::IsLess ( tHit, tSplit ); } );
+			dBounds[iMid] = int ( pMid-pHits );
+		});
+
+		CSphVector<std::pair<int,int>> dSplit;
+		for ( auto [iFirst, iLast] : dRanges )
+		{
+			int iMid = ( iFirst+iLast )/2;
+			if ( iMid-iFirst>1 )
+				dSplit.Add ( { iFirst, iMid } );
+			if ( iLast-iMid>1 )
+				dSplit.Add ( { iMid, iLast } );
+		}
+		dRanges.SwapData ( dSplit );
+	}
+
+	// every run holds hits between its splitters, so sorted runs make the sorted block
+	m_pWorkers->Run ( iRuns, [pHits, &dBounds] ( int iRun ) {
+		sphSort ( pHits+dBounds[iRun], dBounds[iRun+1]-dBounds[iRun], CmpHit_fn() );
+	});
+}
+
 void CSphIndex_VLN::GetIndexFiles ( StrVec_t& dFiles, StrVec_t& dExt, const FilenameBuilder_i* pParentFilenameBuilder ) const
 {
 	if ( !m_pDict )
@@ -3525,6 +3722,7 @@ private:
 	CSphWriter					m_wrDoclist;			///< wordlist writer
 	CSphWriter					m_wrHitlist;			///< hitlist writer
 	CSphWriter					m_wrSkiplist;			///< skiplist writer
+	DoclistWriter_c				m_tDoclist;				///< doclist entries writer (over m_wrDoclist)
 	CSphFixedVector<BYTE>		m_dWriteBuffer;			///< my write buffer (for temp files)
 
 	AggregateHit_t				m_tLastHit;				///< hitlist entry
@@ -3546,6 +3744,7 @@ private:
 
 	ESphHitFormat				m_eHitFormat;
 	ESphHitless					m_eHitless;
+	DoclistFormat_e				m_eDoclistFormat;
 
 	CSphVector<SkiplistEntry_t>	m_dSkiplist;
 	StrVec_t *					m_pCreatedFiles { nullptr };
@@ -3556,13 +3755,15 @@ private:
 
 
 CSphHitBuilder::CSphHitBuilder ( const CSphIndexSettings & tSettings, const CSphVector<SphWordID_t> & dHitless, bool bMerging, int iBufSize, DictRefPtr_c pDict, CSphString * sError, StrVec_t * pCreatedFiles )
-	: m_dWriteBuffer ( iBufSize )
+	: m_tDoclist ( m_wrDoclist, tSettings.m_eDoclistFormat )
+	, m_dWriteBuffer ( iBufSize )
 	, m_dHitlessWords ( dHitless )
 	, m_pDict ( std::move ( pDict ) )
 	, m_pLastError ( sError )
 	, m_iSkiplistBlockSize ( tSettings.m_iSkiplistBlockSize )
 	, m_eHitFormat ( tSettings.m_eHitFormat )
 	, m_eHitless ( tSettings.m_eHitless )
+	, m_eDoclistFormat ( tSettings.m_eDoclistFormat )
 	, m_pCreatedFiles ( pCreatedFiles )
 #ifndef NDEBUG
 	, m_bMerging ( bMerging )
@@ -3659,10 +3860,11 @@ void CSphHitBuilder::DoclistBeginEntry ( RowID_t tRowid )
 		tBlock.m_tBaseRowIDPlus1 = m_tLastHit.m_tRowID+1;
 		tBlock.m_iOffset = m_wrDoclist.GetPos();
 		tBlock.m_iBaseHitlistPos = m_iLastHitlistPos;
+		tBlock.m_uMaxHits = tBlock.m_uFields = 0;
 	}
 
 	// begin doclist entry
-	m_wrDoclist.ZipInt ( tRowid - m_tLastHit.m_tRowID );
+	m_tDoclist.BeginEntry ( tRowid - m_tLastHit.m_tRowID );
 }
 
 
@@ -3677,27 +3879,34 @@ void CSphHitBuilder::DoclistEndEntry ( Hitpos_t uLastPos )
 
 		// inline the only hit into doclist (unless it is completely discarded)
 		// and finish doclist entry
-		m_wrDoclist.ZipInt ( m_uLastDocHits );
+		m_tDoclist.ZipInt ( m_uLastDocHits );
 		if ( m_uLastDocHits==1 && !bIgnoreHits )
 		{
 			m_wrHitlist.SeekTo ( m_iLastHitlistPos );
-			m_wrDoclist.ZipInt ( uLastPos & 0x7FFFFF );
-			m_wrDoclist.ZipInt ( uLastPos >> 23 );
+			m_tDoclist.ZipInt ( uLastPos & 0x7FFFFF );
+			m_tDoclist.ZipInt ( uLastPos >> 23 );
 			m_iLastHitlistPos -= m_iLastHitlistDelta;
 			assert ( m_iLastHitlistPos>=0 );
 
 		} else
 		{
-			m_wrDoclist.ZipInt ( m_dLastDocFields.GetMask32() );
-			m_wrDoclist.ZipOffset ( m_iLastHitlistDelta );
+			m_tDoclist.ZipInt ( m_dLastDocFields.GetMask32() );
+			m_tDoclist.ZipOffset ( m_iLastHitlistDelta );
 		}
 	} else // plain format - finish doclist entry
 	{
 		assert ( m_eHitFormat==SPH_HIT_FORMAT_PLAIN );
-		m_wrDoclist.ZipOffset ( m_iLastHitlistDelta );
-		m_wrDoclist.ZipInt ( m_dLastDocFields.GetMask32() );
-		m_wrDoclist.ZipInt ( m_uLastDocHits );
+		m_tDoclist.ZipOffset ( m_iLastHitlistDelta );
+		m_tDoclist.ZipInt ( m_dLastDocFields.GetMask32() );
+		m_tDoclist.ZipInt ( m_uLastDocHits );
 	}
+	m_tDoclist.EndEntry();
+
+	// update block-max of the current skiplist block
+	SkiplistEntry_t & tBlock = m_dSkiplist.Last();
+	tBlock.m_uMaxHits = Max ( tBlock.m_uMaxHits, m_uLastDocHits );
+	tBlock.m_uFields |= m_dLastDocFields.GetMask32();
+
 	m_dLastDocFields.UnsetAll();
 	m_uLastDocHits = 0;
 
@@ -3710,40 +3919,18 @@ void CSphHitBuilder::DoclistEndList ()
 {
 	assert ( m_iSkiplistBlockSize>0 );
 
-	// emit eof marker
-	m_wrDoclist.ZipInt ( 0 );
+	// emit the rest of the entries and eof marker
+	m_tDoclist.EndList();
 
 	// emit skiplist
 	// OPTIMIZE? placing it after doclist means an extra seek on searching
 	// however placing it before means some (longer) doclist data moves while indexing
 	if ( ( m_tWord.m_iDocs & HITLESS_DOC_MASK )>m_iSkiplistBlockSize )
 	{
-		assert ( m_dSkiplist.GetLength() );
 		assert ( m_dSkiplist[0].m_iOffset==m_tWord.m_iDoclistOffset );
-		assert ( m_dSkiplist[0].m_tBaseRowIDPlus1==0 );
-		assert ( m_dSkiplist[0].m_iBaseHitlistPos==0 );
 
 		m_tWord.m_iSkiplistOffset = m_wrSkiplist.GetPos();
-
-		// delta coding, but with a couple of skiplist specific tricks
-		// 1) first entry is omitted, it gets reconstructed from dict itself
-		// both base values are zero, and offset equals doclist offset
-		// 2) docids are at least SKIPLIST_BLOCK apart
-		// doclist entries are at least 4*SKIPLIST_BLOCK bytes apart
-		// so we additionally subtract that to improve delta coding
-		// 3) zero deltas are allowed and *not* used as any markers,
-		// as we know the exact skiplist entry count anyway
-		SkiplistEntry_t tLast = m_dSkiplist[0];
-		for ( int i=1; i<m_dSkiplist.GetLength(); i++ )
-		{
-			const SkiplistEntry_t & t = m_dSkiplist[i];
-			assert ( t.m_tBaseRowIDPlus1 - tLast.m_tBaseRowIDPlus1>=(DWORD)m_iSkiplistBlockSize );
-			assert ( t.m_iOffset - tLast.m_iOffset>=4*m_iSkiplistBlockSize );
-			m_wrSkiplist.ZipInt ( t.m_tBaseRowIDPlus1 - tLast.m_tBaseRowIDPlus1 - m_iSkiplistBlockSize );
-			m_wrSkiplist.ZipOffset ( t.m_iOffset - tLast.m_iOffset - 4*m_iSkiplistBlockSize );
-			m_wrSkiplist.ZipOffset ( t.m_iBaseHitlistPos - tLast.m_iBaseHitlistPos );
-			tLast = t;
-		}
+		ZipSkiplist ( m_wrSkiplist, m_dSkiplist, m_tWord.m_iDocs & HITLESS_DOC_MASK, m_iSkiplistBlockSize, m_eDoclistFormat==DoclistFormat_e::BLOCK );
 	}
 
 	// in any event, reset skiplist
@@ -5628,6 +5815,10 @@ int CSphIndex_VLN::Build ( const CSphVector<CSphSource*> & dSources, int iMemory
 	} else
 		iHitsMax = iMemoryLimit / sizeof(CSphWordHit);
 
+	// only the sort of each collected block runs on several threads (sort_threads); fetching, tokenizing,
+	// the final merge and writing of the table files stay on this one
+	HitBlockSorter_c tHitSorter ( g_iSortThreads );
+
 	// allocate raw hits block
 	CSphFixedVector<CSphWordHit> dHits ( iHitsMax + MAX_SOURCE_HITS );
 	CSphWordHit * pHits = dHits.Begin();
@@ -5810,7 +6001,7 @@ int CSphIndex_VLN::Build ( const CSphVector<CSphSource*> & dSources, int iMemory
 				// sort hits
 				int iHits = int ( pHits - dHits.Begin() );
 				{
-					sphSort ( dHits.Begin(), iHits, CmpHit_fn() );
+					tHitSorter.Sort ( dHits.Begin(), iHits );
 					m_pDict->HitblockPatch ( dHits.Begin(), iHits );
 				}
 				pHits = dHits.Begin();
@@ -5884,7 +6075,7 @@ int CSphIndex_VLN::Build ( const CSphVector<CSphSource*> & dSources, int iMemory
 			int iHits = int ( pHits - dHits.Begin() );
 			if ( iDictSize && m_pDict->HitblockGetMemUse() && iHits )
 			{
-				sphSort ( dHits.Begin(), iHits, CmpHit_fn() );
+				tHitSorter.Sort ( dHits.Begin(), iHits );
 				m_pDict->HitblockPatch ( dHits.Begin(), iHits );
 				pHits = dHits.Begin();
 				iHitsTotal += iHits;
@@ -5917,7 +6108,7 @@ int CSphIndex_VLN::Build ( const CSphVector<CSphSource*> & dSources, int iMemory
 
 				// store hits
 				int iStoredHits = int ( pHits - dHits.Begin() );
-				sphSort ( dHits.Begin(), iStoredHits, CmpHit_fn() );
+				tHitSorter.Sort ( dHits.Begin(), iStoredHits );
 				m_pDict->HitblockPatch ( dHits.Begin(), iStoredHits );
 
 				pHits = dHits.Begin();
@@ -5948,7 +6139,7 @@ int CSphIndex_VLN::Build ( const CSphVector<CSphSource*> & dSources, int iMemory
 	{
 		int iHits = int ( pHits - dHits.Begin() );
 		{
-			sphSort ( dHits.Begin(), iHits, CmpHit_fn() );
+			tHitSorter.Sort ( dHits.Begin(), iHits );
 			m_pDict->HitblockPatch ( dHits.Begin(), iHits );
 		}
 		iHitsTotal += iHits;
@@ -6470,6 +6661,7 @@ namespace QwordIteration
 
 		tQword.m_uHitPosition = 0;
 		tQword.m_iHitlistPos = 0;
+		tQword.ResetDoclistBlock();
 
 		if_const ( QWORD::is_worddict::value )
 			tQword.m_rdDoclist->SeekTo ( tReader.m_iDoclistOffset, tReader.m_iHint );
@@ -6516,8 +6708,10 @@ namespace QwordIteration
 	}
 
 	template<typename QWORD>
-	inline void ConfigureQword ( QWORD & tQword, DataReaderFactory_c * pHits, DataReaderFactory_c * pDocs, int iDynamic )
+	inline void ConfigureQword ( QWORD & tQword, DataReaderFactory_c * pHits, DataReaderFactory_c * pDocs, int iDynamic, const CSphIndexSettings & tSettings )
 	{
+		tQword.m_bBlockDoclist = tSettings.m_eDoclistFormat==DoclistFormat_e::BLOCK;
+
 		tQword.SetHitReader ( pHits );
 		tQword.m_rdHitlist->SeekTo ( 1, READ_NO_SIZE_HINT );
 
@@ -6642,8 +6836,8 @@ bool CSphIndex_VLN::MergeWords ( const CSphIndex_VLN * pDstIndex, const CSphInde
 
 	CSphMerger tMerger(pHitBuilder);
 
-	QwordIteration::ConfigureQword<QWORDDST> ( tDstQword, tDstHits, tDstDocs, pDstIndex->m_tSchema.GetDynamicSize() );
-	QwordIteration::ConfigureQword<QWORDSRC> ( tSrcQword, tSrcHits, tSrcDocs, pSrcIndex->m_tSchema.GetDynamicSize() );
+	QwordIteration::ConfigureQword<QWORDDST> ( tDstQword, tDstHits, tDstDocs, pDstIndex->m_tSchema.GetDynamicSize(), pDstIndex->m_tSettings );
+	QwordIteration::ConfigureQword<QWORDSRC> ( tSrcQword, tSrcHits, tSrcDocs, pSrcIndex->m_tSchema.GetDynamicSize(), pSrcIndex->m_tSettings );
 
 	/// merge
 
@@ -6812,7 +7006,7 @@ bool CSphIndex_VLN::MergeWordsN ( VecTraits_T<const CSphIndex_VLN *> dIndexes, c
 		if ( !sError.IsEmpty () || tMonitor.NeedStop () )
 			return false;
 
-		QwordIteration::ConfigureQword<QWORD> ( pSrc->m_tQword, pSrc->m_tHits, pSrc->m_tDocs, pIndex->m_tSchema.GetDynamicSize() );
+		QwordIteration::ConfigureQword<QWORD> ( pSrc->m_tQword, pSrc->m_tHits, pSrc->m_tDocs, pIndex->m_tSchema.GetDynamicSize(), pIndex->m_tSettings );
 		pSrc->m_bHasWord = pSrc->m_tReader.Read();
 	}
 
@@ -7417,7 +7611,7 @@ bool CSphIndex_VLN::DeleteField ( const CSphIndex_VLN * pIndex, CSphHitBuilder *
 	if ( !sError.IsEmpty () || sphInterrupted () )
 		return false;
 
-	QwordIteration::ConfigureQword ( tQword, tHits, tDocs, pIndex->m_tSchema.GetDynamicSize() );
+	QwordIteration::ConfigureQword ( tQword, tHits, tDocs, pIndex->m_tSchema.GetDynamicSize(), pIndex->m_tSettings );
 
 	/// process
 	while ( tWordsReader.Read () )
@@ -7820,6 +8014,9 @@ CSphVector<SphAttr_t> CSphIndex_VLN::BuildDocList () const
 
 RowID_t CSphIndex_VLN::GetRowidByDocid ( DocID_t tDocID ) const
 {
+	if ( m_bLookupFilterReady.load ( std::memory_order_acquire ) && !m_tLookupFilter.MayContain(tDocID) )
+		return INVALID_ROWID;
+
 	return m_tLookupReader.Find ( tDocID );
 }
 
@@ -7867,7 +8064,7 @@ inline RowID_t CSphIndex_VLN::GetRowIDByDocinfo ( const CSphRowitem * pDocinfo )
 }
 
 template<bool USE_KLIST, bool RANDOMIZE, bool USE_FACTORS, bool HAS_SORT_CALC, bool HAS_WEIGHT_FILTER, bool HAS_FILTER_CALC, bool HAS_CUTOFF>
-void CSphIndex_VLN::MatchExtended ( CSphQueryContext& tCtx, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dSorters, ISphRanker * pRanker, int iTag, int iIndexWeight, int iCutoff ) const
+void CSphIndex_VLN::MatchExtended ( CSphQueryContext& tCtx, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dSorters, ISphRanker * pRanker, int iTag, int iIndexWeight, int iCutoff, ISphMatchSorter * pPruneSorter, std::atomic<int64_t> * pSharedFloor ) const
 {
 	if ( !iCutoff )
 		return;
@@ -7880,6 +8077,7 @@ void CSphIndex_VLN::MatchExtended ( CSphQueryContext& tCtx, const CSphQuery & tQ
 
 	// do searching
 	CSphMatch * pMatch = pRanker->GetMatchesBuffer();
+	CSphMatch * dAlive[MAX_BLOCK_DOCS];
 	while (true)
 	{
 		// ranker does profile switches internally in GetMatches()
@@ -7889,6 +8087,8 @@ void CSphIndex_VLN::MatchExtended ( CSphQueryContext& tCtx, const CSphQuery & tQ
 
 		SwitchProfile ( pProfile, SPH_QSTATE_SORT );
 
+		assert ( iMatches<=MAX_BLOCK_DOCS );
+		int iAlive = 0;
 		for ( int i=0; i<iMatches; i++ )
 		{
 			CSphMatch & tMatch = pMatch[i];
@@ -7899,9 +8099,16 @@ void CSphIndex_VLN::MatchExtended ( CSphQueryContext& tCtx, const CSphQuery & tQ
 			}
 
 			tMatch.m_iWeight *= iIndexWeight;
+			dAlive[iAlive++] = &tMatch;
+		}
 
-			if constexpr ( HAS_SORT_CALC )
-				tCtx.CalcSort ( tMatch );
+		// sort-stage expressions are evaluated with batch calls over the whole block
+		if constexpr ( HAS_SORT_CALC )
+			tCtx.CalcSortBatch ( { dAlive, iAlive } );
+
+		for ( int i=0; i<iAlive; i++ )
+		{
+			CSphMatch & tMatch = *dAlive[i];
 
 			if constexpr ( HAS_WEIGHT_FILTER )
 			{
@@ -7957,7 +8164,14 @@ void CSphIndex_VLN::MatchExtended ( CSphQueryContext& tCtx, const CSphQuery & tQ
 			if constexpr ( HAS_CUTOFF )
 			{
 				if ( bNewMatch && --iCutoff==0 )
+				{
+					// the rest of the block had its sort-stage data computed, but won't be pushed
+					if constexpr ( HAS_SORT_CALC )
+						for ( int j=i+1; j<iAlive; j++ )
+							tCtx.FreeDataSort ( *dAlive[j] );
+
 					break;
+				}
 			}
 		}
 
@@ -7966,6 +8180,9 @@ void CSphIndex_VLN::MatchExtended ( CSphQueryContext& tCtx, const CSphQuery & tQ
 			if ( !iCutoff )
 				break;
 		}
+
+		if ( pPruneSorter )
+			UpdateTopKFloor ( pRanker, pPruneSorter, iIndexWeight, pSharedFloor );
 	}
 }
 
@@ -8016,35 +8233,28 @@ struct SphFinalMatchCalc_t final : MatchProcessor_i, ISphNoncopyable
 			else
 				dRowWise.Add(&i);
 
-		for ( const auto & pItem : dColumnWise )
-			for ( auto & pMatch : dMatches )
-			{
-				assert(pMatch);
-				if ( pMatch->m_iTag>=0 )
-					continue;
+		m_dPending.Resize(0);
+		for ( auto & pMatch : dMatches )
+		{
+			assert(pMatch);
+			if ( pMatch->m_iTag<0 )
+				m_dPending.Add(pMatch);
+		}
 
-				m_tCtx.CalcItem ( *pMatch, *pItem );
-			}
+		// columnar items are evaluated in batches, so that expressions can fetch values in blocks
+		for ( const auto & pItem : dColumnWise )
+			m_tCtx.CalcItemBatch ( m_dPending, *pItem );
 
-		for ( auto & pMatch : dMatches )
+		for ( auto & pMatch : m_dPending )
 			for ( const auto & pItem : dRowWise )
-			{
-				assert(pMatch);
-				if ( pMatch->m_iTag>=0 )
-					continue;
-
 				m_tCtx.CalcItem ( *pMatch, *pItem );
-			}
-
-		for ( auto & pMatch : dMatches )
-		{
-			assert(pMatch);
-			if ( pMatch->m_iTag>=0 )
-				continue;
 
+		for ( auto & pMatch : m_dPending )
 			pMatch->m_iTag = m_iTag;
-		}
 	}
+
+private:
+	CSphVector<CSphMatch *>		m_dPending;
 };
 
 
@@ -8175,6 +8385,33 @@ private:
 
 //////////////////////////////////////////////////////////////////////////
 
+// evaluate the filter over the rows of a block FILTER_BLOCK_ROWS at a time, and leave only the rowids that pass
+template <typename TO_STATIC>
+static RowIdBlock_t FilterRowIdBlock ( const ISphFilter & tFilter, const RowIdBlock_t & dRowIDs, TO_STATIC && fnToStatic, CSphVector<RowID_t> & dPassed )
+{
+	dPassed.Resize ( dRowIDs.GetLength() );
+	RowID_t * pOut = dPassed.Begin();
+
+	const CSphRowitem * dRows[FILTER_BLOCK_ROWS];
+	uint64_t dMask[FILTER_MASK_WORDS];
+	for ( int iStart = 0; iStart < dRowIDs.GetLength(); iStart += FILTER_BLOCK_ROWS )
+	{
+		const RowID_t * pRowIDs = dRowIDs.Begin() + iStart;
+		int iRows = Min ( dRowIDs.GetLength()-iStart, FILTER_BLOCK_ROWS );
+		for ( int i = 0; i < iRows; ++i )
+			dRows[i] = fnToStatic ( pRowIDs[i] );
+
+		tFilter.EvalRows ( dRows, iRows, dMask );
+
+		for ( int iWord = 0; iWord < FILTER_MASK_WORDS; ++iWord )
+			for ( uint64_t uWord = dMask[iWord]; uWord; uWord &= uWord-1 )
+				*pOut++ = pRowIDs[iWord*64 + sphLog2 ( uWord & ( ~uWord+1 ) ) - 1];
+	}
+
+	return { dPassed.Begin(), pOut-dPassed.Begin() };
+}
+
+
 template <bool SINGLE_SORTER, bool HAS_FILTER_CALC, bool HAS_SORT_CALC, bool HAS_FILTER, bool HAS_RANDOMIZE, bool HAS_MAX_TIMER, bool HAS_CUTOFF, typename ITERATOR, typename TO_STATIC>
 bool Fullscan ( ITERATOR & tIterator, TO_STATIC && fnToStatic, const CSphQueryContext & tCtx, CSphQueryResultMeta & tMeta, const VecTraits_T<ISphMatchSorter *> & dSorters, CSphMatch & tMatch, int iCutoff, int iIndexWeight, int64_t tmMaxTimer )
 {
@@ -8184,8 +8421,21 @@ bool Fullscan ( ITERATOR & tIterator, TO_STATIC && fnToStatic, const CSphQueryCo
 	Threads::Coro::HighFreqChecker_c fnHeavyCheck;
 	const int64_t& iCheckTimePoint { Threads::Coro::GetNextTimePointUS() };
 
+	// filters over plain row attrs are evaluated for the whole block, and only the rows that pass get into tMatch
+	bool bFilterRows = false;
+	if constexpr ( HAS_FILTER && !HAS_FILTER_CALC )
+		bFilterRows = tCtx.m_pFilter->CanEvalRows();
+
+	CSphVector<RowID_t> dPassed;
+
 	while ( tIterator.GetNextRowIdBlock(dRowIDs) )
 	{
+		if constexpr ( HAS_FILTER && !HAS_FILTER_CALC )
+		{
+			if ( bFilterRows )
+				dRowIDs = FilterRowIdBlock ( *tCtx.m_pFilter, dRowIDs, fnToStatic, dPassed );
+		}
+
 		for ( auto i : dRowIDs )
 		{
 			tMatch.m_tRowID = i;
@@ -8197,7 +8447,7 @@ bool Fullscan ( ITERATOR & tIterator, TO_STATIC && fnToStatic, const CSphQueryCo
 
 			if constexpr ( HAS_FILTER )
 			{
-				if ( !tCtx.m_pFilter->Eval(tMatch) )
+				if ( !bFilterRows && !tCtx.m_pFilter->Eval(tMatch) )
 				{
 					if_const ( HAS_FILTER_CALC )
 						tCtx.FreeDataFilter ( tMatch );
@@ -8340,7 +8590,10 @@ bool CSphIndex_VLN::ScanByBlocks ( const CSphQueryContext & tCtx, CSphQueryResul
 		const DWORD * pMin = &m_pDocinfoIndex[ iIndexEntry*iStride*2 ];
 		const DWORD * pMax = pMin + iStride;
 		if ( tCtx.m_pFilter && !tCtx.m_pFilter->EvalBlock ( pMin, pMax ) )
+		{
+			tMeta.m_tIteratorStats.m_iPrunedBlocks++;
 			continue;
+		}
 
 		RowIdBoundaries_t tBlockBoundaries;
 		tBlockBoundaries.m_tMinRowID = RowID_t ( iIndexEntry*DOCINFO_INDEX_FREQ );
@@ -8858,6 +9111,9 @@ bool CSphIndex_VLN::MultiScan ( CSphQueryResult & tResult, const CSphQuery & tQu
 
 	if ( CheckEarlyReject ( dTransformedFilters, tCtx.m_pFilter.get(), tQuery.m_eCollation, tMaxSorterSchema ) )
 	{
+		if ( tArgs.m_bCountPrunedChunk )
+			tMeta.m_tIteratorStats.m_iPrunedChunks++;
+
 		PooledAttrsToPtrAttrs ( dSorters, m_tBlobAttrs.GetReadPtr(), m_pColumnar.get(), tArgs.m_bFinalizeSorters, tMeta.m_pProfile, tArgs.m_bModifySorterSchemas );
 
 		tMeta.AddQueryTimeUs ( sphMicroTimer() - tmQueryStart );
@@ -9007,9 +9263,9 @@ ISphQword * DiskIndexQwordSetup_c::QwordSpawn ( const XQKeyword_t & tWord ) cons
 	} else
 	{
 		if ( m_pIndex->GetSettings().m_eHitFormat==SPH_HIT_FORMAT_INLINE )
-			return new DiskPayloadQword_c<true> ( (const DiskSubstringPayload_t *)tWord.m_pPayload, tWord.m_bExcluded, m_pDoclist, m_pHitlist, m_pIndex->GetIndexId() );
+			return new DiskPayloadQword_c<true> ( (const DiskSubstringPayload_t *)tWord.m_pPayload, tWord.m_bExcluded, m_pDoclist, m_pHitlist, m_pIndex->GetIndexId(), m_pIndex->GetSettings().m_eDoclistFormat==DoclistFormat_e::BLOCK );
 		else
-			return new DiskPayloadQword_c<false> ( (const DiskSubstringPayload_t *)tWord.m_pPayload, tWord.m_bExcluded, m_pDoclist, m_pHitlist, m_pIndex->GetIndexId() );
+			return new DiskPayloadQword_c<false> ( (const DiskSubstringPayload_t *)tWord.m_pPayload, tWord.m_bExcluded, m_pDoclist, m_pHitlist, m_pIndex->GetIndexId(), m_pIndex->GetSettings().m_eDoclistFormat==DoclistFormat_e::BLOCK );
 	}
 	return NULL;
 }
@@ -9137,6 +9393,7 @@ bool DiskIndexQwordSetup_c::Setup ( ISphQword * pWord ) const
 	tWord.m_bHasHitlist =
 		( eMode==SPH_HITLESS_NONE ) ||
 		( eMode==SPH_HITLESS_SOME && !( tRes.m_iDocs & HITLESS_DOC_FLAG ) );
+	tWord.m_bBlockDoclist = pIndex->m_tSettings.m_eDoclistFormat==DoclistFormat_e::BLOCK;
 
 	if ( m_bSetupReaders )
 	{
@@ -9156,12 +9413,15 @@ bool DiskIndexQwordSetup_c::Setup ( ISphQword * pWord ) const
 			if ( !bFromCache )
 			{
 				tWord.m_pSkipData = new SkipData_t;
-				tWord.m_pSkipData->Read ( m_pSkips, tRes, tWord.m_iDocs, m_iSkiplistBlockSize );
+				tWord.m_pSkipData->Read ( m_pSkips, tRes, tWord.m_iDocs, m_iSkiplistBlockSize, m_bBlockMax, tWord.m_bBlockDoclist );
 				bFromCache = bNeedCache && SkipCache::Add ( { m_pIndex->GetIndexId(), tWord.m_uWordID }, tWord.m_pSkipData );
 			}
 		}
 
+		// all the terms are set up before evaluation starts, so their first doclist reads go to disk in parallel
 		tWord.m_rdDoclist->SeekTo ( tRes.m_iDoclistOffset, tRes.m_iDoclistHint );
+		tWord.ResetDoclistBlock();
+		tWord.m_rdDoclist->Prefetch ( tRes.m_iDoclistOffset, tRes.m_iDoclistHint );
 		tWord.SetHitReader ( m_pHitlist );
 	}
 
@@ -9272,6 +9532,8 @@ void CSphIndex_VLN::Dealloc ()
 	m_tSkiplists.Reset ();
 	m_tWordlist.Reset ();
 	m_tDeadRowMap.Dealloc();
+	m_bLookupFilterReady = false;
+	m_tLookupFilter = DocidLookupFilter_c();
 	m_tDocidLookup.Reset();
 	m_pDocstore.reset();
 
@@ -9767,7 +10029,7 @@ void CSphIndex_VLN::DumpHitlist ( FILE * fp, const char * sKeyword, bool bID )
 
 
 	// aim
-	DiskIndexQwordSetup_c tTermSetup ( pDoclist, pHitlist, m_tSkiplists.GetReadPtr(), m_tSettings.m_iSkiplistBlockSize, true, RowID_t(m_iDocinfo) );
+	DiskIndexQwordSetup_c tTermSetup ( pDoclist, pHitlist, m_tSkiplists.GetReadPtr(), m_tSettings.m_iSkiplistBlockSize, m_uVersion>=70, true, RowID_t(m_iDocinfo) );
 	tTermSetup.SetDict ( m_pDict );
 	tTermSetup.m_pIndex = this;
 
@@ -10169,6 +10431,13 @@ void CSphIndex_VLN::Preread()
 	PrereadMapping ( GetName(), "docid-lookup", IsMlock ( m_tMutableSettings.m_tFileAccess.m_eAttr ), false, m_tDocidLookup );
 	if ( sphInterrupted() ) return;
 
+	// the lookup is in memory now, so building its filter is just one more pass over it
+	if ( !m_bIsEmpty && !m_bDebugCheck && !m_tDocidLookup.IsEmpty() && !m_bLookupFilterReady )
+	{
+		m_tLookupFilter.Build ( m_tDocidLookup.GetReadPtr() );
+		m_bLookupFilterReady.store ( !m_tLookupFilter.IsEmpty(), std::memory_order_release );
+	}
+
 	m_tDeadRowMap.Preread ( GetName(), "kill-list", IsMlock ( m_tMutableSettings.m_tFileAccess.m_eAttr ) );
 	if ( sphInterrupted() ) return;
 
@@ -10309,7 +10578,7 @@ bool CSphIndex_VLN::DoGetKeywords ( CSphVector <CSphKeywordInfo> & dKeywords, co
 	// FIXME!!! missed bigram, add flags to fold blended parts, show expanded terms
 
 	// prepare for setup
-	DiskIndexQwordSetup_c tTermSetup ( DataReaderFactoryPtr_c{}, DataReaderFactoryPtr_c{}, m_tSkiplists.GetReadPtr(), m_tSettings.m_iSkiplistBlockSize, false, RowID_t(m_iDocinfo) );
+	DiskIndexQwordSetup_c tTermSetup ( DataReaderFactoryPtr_c{}, DataReaderFactoryPtr_c{}, m_tSkiplists.GetReadPtr(), m_tSettings.m_iSkiplistBlockSize, m_uVersion>=70, false, RowID_t(m_iDocinfo) );
 	tTermSetup.SetDict ( pDict );
 	tTermSetup.m_pIndex = this;
 
@@ -11299,6 +11568,10 @@ static bool RunSplitQuery ( RUN && tRun, const CSphQuery & tQuery, CSphQueryResu
 	std::atomic<bool> bInterrupt {false};
 	auto CheckInterrupt = [&bInterrupt]() { return bInterrupt.load ( std::memory_order_relaxed ); };
 
+	// all the shards search the same index with the same queue size, so they share the top-k pruning floor
+	std::atomic<int64_t> iTopKFloor {0};
+	std::atomic<int64_t> * pTopKFloor = tArgs.m_pTopKFloor ? tArgs.m_pTopKFloor : &iTopKFloor;
+
 	int iConcurrency = tClonableCtx.Concurrency(iJobs);
 	Threads::Coro::ExecuteN ( iConcurrency, [&]
 	{
@@ -11339,6 +11612,8 @@ static bool RunSplitQuery ( RUN && tRun, const CSphQuery & tQuery, CSphQueryResu
 			tMultiArgs.m_iTotalDocs = iTotalDocs;
 			tMultiArgs.m_bModifySorterSchemas = false;
 			tMultiArgs.m_iTotalThreads = iConcurrency;
+			tMultiArgs.m_pTopKFloor = pTopKFloor;
+			tMultiArgs.m_bCountPrunedChunk = !iJob;
 
 			CSphQuery tQueryWithExtraFilter = tQuery;
 			SetupSplitFilter ( tQueryWithExtraFilter.m_dFilters.Add(), iJob, iJobs );
@@ -11356,6 +11631,7 @@ static bool RunSplitQuery ( RUN && tRun, const CSphQuery & tQuery, CSphQueryResu
 
 			tThMeta.m_bTotalMatchesApprox |= tChunkMeta.m_bTotalMatchesApprox;
 			tThMeta.m_tIteratorStats.Merge ( tChunkMeta.m_tIteratorStats );
+			tThMeta.m_tIOStats.Add ( tChunkMeta.m_tIOStats );
 
 			if ( CheckInterrupt() && !tChunkMeta.m_sError.IsEmpty() )
 				// FIXME? maybe handle this more gracefully (convert to a warning)?
@@ -11478,6 +11754,14 @@ bool CSphIndex_VLN::MultiQuery ( CSphQueryResult & tResult, const CSphQuery & tQ
 	// fast path for scans
 	if ( pQueryParser->IsFullscan ( tQuery ) )
 	{
+		// no keyword stats to collect, so the chunk can be dropped before any setup (or splitting) is done
+		if ( IsRejectedByMinMax ( tQuery ) )
+		{
+			tMeta.m_tIteratorStats.m_iPrunedChunks++;
+			PooledAttrsToPtrAttrs ( dSorters, m_tBlobAttrs.GetReadPtr(), m_pColumnar.get(), tArgs.m_bFinalizeSorters, pProfile, tArgs.m_bModifySorterSchemas );
+			return true;
+		}
+
 		if ( tArgs.m_iThreads>1 )
 			return SplitQuery (
 				[this, &tmMaxTimer]
@@ -11769,21 +12053,158 @@ bool CSphIndex_VLN::CheckEarlyReject ( const CSphVector<CSphFilterSettings> & dF
 }
 
 
-static void SetupRowIdBoundaries ( const CSphVector<CSphFilterSettings> & dFilters, RowID_t uTotalDocs, ISphRanker & tRanker )
+static bool IsMinMaxFilter ( const CSphFilterSettings & tFilter, const CSphColumnInfo * pAttr, const CSphQuery & tQuery )
 {
-	const CSphFilterSettings * pRowIdFilter = nullptr;
-	for ( auto & i : dFilters )
-		if ( i.m_sAttrName=="@rowid" )
-		{
-			pRowIdFilter = &i;
-			break;
-		}
+	if ( !pAttr || tFilter.m_bExclude )
+		return false;
 
-	if ( !pRowIdFilter )
-		return;
+	if ( tFilter.m_eType!=SPH_FILTER_VALUES && tFilter.m_eType!=SPH_FILTER_RANGE && tFilter.m_eType!=SPH_FILTER_FLOATRANGE )
+		return false;
 
-	RowIdBoundaries_t tBoundaries = GetFilterRowIdBoundaries ( *pRowIdFilter, uTotalDocs );
-	tRanker.ExtraData ( EXTRA_SET_BOUNDARIES, (void**)&tBoundaries );
+	switch ( pAttr->m_eAttrType )
+	{
+	case SPH_ATTR_INTEGER:
+	case SPH_ATTR_BIGINT:
+	case SPH_ATTR_TIMESTAMP:
+	case SPH_ATTR_BOOL:
+	case SPH_ATTR_FLOAT:
+		break;
+	default:
+		return false;
+	}
+
+	// 'select b as a ... where a>1' filters the alias, not the attribute
+	return !tQuery.m_dItems.any_of ( [&tFilter]( const CSphQueryItem & tItem ){ return tItem.m_sAlias==tFilter.m_sAttrName && tItem.m_sExpr!=tFilter.m_sAttrName; } );
+}
+
+static bool CanPruneByMinMax ( const CSphQuery & tQuery )
+{
+	return g_bMinMaxPruning && !tQuery.m_dFilters.IsEmpty() && tQuery.m_dFilterTree.IsEmpty() && tQuery.m_sJoinIdx.IsEmpty();
+}
+
+
+static std::unique_ptr<ISphFilter> CreateJoinedFilter ( const CSphVector<CSphFilterSettings> & dFilters, const CreateFilterContext_t & tFlx )
+{
+	CSphString sError, sWarning;
+	std::unique_ptr<ISphFilter> pFilter;
+	for ( const auto & tFilter : dFilters )
+	{
+		auto pNew = sphCreateFilter ( tFilter, tFlx, sError, sWarning );
+		if ( !pNew )
+			return nullptr;
+
+		pFilter = sphJoinFilters ( std::move ( pFilter ), std::move ( pNew ) );
+	}
+
+	return pFilter;
+}
+
+
+std::unique_ptr<ISphFilter> CreateMinMaxFilter ( const CSphQuery & tQuery, const ISphSchema & tSchema )
+{
+	if ( !CanPruneByMinMax ( tQuery ) )
+		return nullptr;
+
+	CSphVector<CSphFilterSettings> dRowwise;
+	for ( const auto & tFilter : tQuery.m_dFilters )
+	{
+		const CSphColumnInfo * pAttr = tSchema.GetAttr ( tFilter.m_sAttrName.cstr() );
+		if ( IsMinMaxFilter ( tFilter, pAttr, tQuery ) && !pAttr->IsColumnar() )
+			dRowwise.Add ( tFilter );
+	}
+
+	if ( dRowwise.IsEmpty() )
+		return nullptr;
+
+	CreateFilterContext_t tFlx;
+	tFlx.m_pMatchSchema = &tSchema;
+	tFlx.m_pIndexSchema = &tSchema;
+	tFlx.m_eCollation = tQuery.m_eCollation;
+	return CreateJoinedFilter ( dRowwise, tFlx );
+}
+
+// checks plain attribute filters against the index-wide min/max before any filter/sorter setup is done
+// the same check as CheckEarlyReject, but it doesn't need a query context, so the chunk is skipped without creating one
+bool CSphIndex_VLN::IsRejectedByMinMax ( const CSphQuery & tQuery ) const
+{
+	if ( m_bIsEmpty || !CanPruneByMinMax ( tQuery ) )
+		return false;
+
+	if ( m_iDocinfoIndex )
+	{
+		auto pFilter = CreateMinMaxFilter ( tQuery, m_tSchema );
+		DWORD uStride = m_tSchema.GetRowSize();
+		const DWORD * pMinEntry = &m_pDocinfoIndex [ m_iDocinfoIndex*uStride*2 ];
+		const DWORD * pMaxEntry = pMinEntry + uStride;
+		if ( pFilter && !pFilter->EvalBlock ( pMinEntry, pMaxEntry ) )
+			return true;
+	}
+
+	if ( !m_pColumnar )
+		return false;
+
+	CSphVector<CSphFilterSettings> dColumnar;
+	for ( const auto & tFilter : tQuery.m_dFilters )
+	{
+		const CSphColumnInfo * pAttr = m_tSchema.GetAttr ( tFilter.m_sAttrName.cstr() );
+		if ( IsMinMaxFilter ( tFilter, pAttr, tQuery ) && pAttr->IsColumnar() )
+			dColumnar.Add ( tFilter );
+	}
+
+	if ( dColumnar.IsEmpty() )
+		return false;
+
+	CSphString sWarning;
+	std::vector<common::Filter_t> dColumnarFilters;
+	for ( const auto & tFilter : dColumnar )
+		AddColumnarFilter ( dColumnarFilters, tFilter, tQuery.m_eCollation, m_tSchema, sWarning );
+
+	CreateFilterContext_t tFlx;
+	tFlx.m_pMatchSchema = &m_tSchema;
+	tFlx.m_pIndexSchema = &m_tSchema;
+	tFlx.m_pBlobPool = m_tBlobAttrs.GetReadPtr();
+	tFlx.m_pColumnar = m_pColumnar.get();
+	tFlx.m_eCollation = tQuery.m_eCollation;
+	tFlx.m_iTotalDocs = m_iDocinfo;
+
+	auto pFilter = CreateJoinedFilter ( dColumnar, tFlx );
+	return pFilter && !dColumnarFilters.empty() && m_pColumnar->EarlyReject ( dColumnarFilters, *pFilter );
+}
+
+// full-text matching only needs to look at rowids in the range of blocks whose min/max pass the filters
+// doclists are then skipped to the first such rowid and cut after the last one
+// returns false if no block passes at all
+bool CSphIndex_VLN::NarrowRowIdBoundaries ( const CSphQueryContext & tCtx, const CSphQuery & tQuery, RowIdBoundaries_t & tBoundaries, int64_t & iPrunedBlocks ) const
+{
+	tBoundaries = { 0, RowID_t(m_iDocinfo-1) };
+	GetRowIdFilter ( tQuery.m_dFilters, RowID_t(m_iDocinfo), tBoundaries );
+
+	if ( !g_bMinMaxPruning || !tCtx.m_pFilter || !m_iDocinfoIndex || !m_pDocinfoIndex )
+		return true;
+
+	int iStride = m_tSchema.GetRowSize();
+	int64_t iFirst = tBoundaries.m_tMinRowID / DOCINFO_INDEX_FREQ;
+	int64_t iLast = Min ( tBoundaries.m_tMaxRowID / DOCINFO_INDEX_FREQ, m_iDocinfoIndex-1 );
+	auto fnPass = [this, iStride, &tCtx]( int64_t iBlock )
+	{
+		const DWORD * pMin = &m_pDocinfoIndex[ iBlock*iStride*2 ];
+		return tCtx.m_pFilter->EvalBlock ( pMin, pMin+iStride );
+	};
+
+	int64_t iBlocks = iLast-iFirst+1;
+	while ( iFirst<=iLast && !fnPass(iFirst) )
+		++iFirst;
+
+	while ( iLast>=iFirst && !fnPass(iLast) )
+		--iLast;
+
+	iPrunedBlocks += iBlocks - Max ( iLast-iFirst+1, 0 );
+	if ( iFirst>iLast )
+		return false;
+
+	tBoundaries.m_tMinRowID = Max ( tBoundaries.m_tMinRowID, RowID_t ( iFirst*DOCINFO_INDEX_FREQ ) );
+	tBoundaries.m_tMaxRowID = Min ( tBoundaries.m_tMaxRowID, RowID_t ( ( iLast+1 )*DOCINFO_INDEX_FREQ-1 ) );
+	return true;
 }
 
 
@@ -11863,7 +12284,7 @@ bool CSphIndex_VLN::ParsedMultiQuery ( const CSphQuery & tQuery, CSphQueryResult
 	SwitchProfile ( pProfile, SPH_QSTATE_INIT );
 
 	// setup search terms
-	DiskIndexQwordSetup_c tTermSetup ( pDoclist, pHitlist, m_tSkiplists.GetReadPtr(), m_tSettings.m_iSkiplistBlockSize, true, RowID_t(m_iDocinfo) );
+	DiskIndexQwordSetup_c tTermSetup ( pDoclist, pHitlist, m_tSkiplists.GetReadPtr(), m_tSettings.m_iSkiplistBlockSize, m_uVersion>=70, true, RowID_t(m_iDocinfo) );
 
 	tTermSetup.SetDict ( std::move ( pDict ) );
 	tTermSetup.m_pIndex = this;
@@ -11881,6 +12302,17 @@ bool CSphIndex_VLN::ParsedMultiQuery ( const CSphQuery & tQuery, CSphQueryResult
 	// bind weights
 	tCtx.BindWeights ( tQuery, m_tSchema, tMeta.m_sWarning );
 
+	// rowid range the ranker has to look at; @rowid filter narrowed by block min/max
+	RowIdBoundaries_t tBoundaries;
+	bool bAnyBlock = true;
+	if ( !m_bIsEmpty )
+	{
+		bAnyBlock = NarrowRowIdBoundaries ( tCtx, tQuery, tBoundaries, tMeta.m_tIteratorStats.m_iPrunedBlocks );
+		bool bRowIdFilter = tQuery.m_dFilters.any_of ( []( auto & tFilter ){ return tFilter.m_sAttrName=="@rowid"; } );
+		if ( bAnyBlock && ( bRowIdFilter || tBoundaries.m_tMinRowID>0 || tBoundaries.m_tMaxRowID<RowID_t(m_iDocinfo-1) ) )
+			tCtx.m_pRowIdBoundaries = &tBoundaries;
+	}
+
 	// setup query
 	// must happen before index-level reject, in order to build proper keyword stats
 	std::unique_ptr<ISphRanker> pRanker = sphCreateRanker ( tXQ, tQuery, tMeta, tTermSetup, tCtx, tMaxSorterSchema );
@@ -11914,9 +12346,14 @@ bool CSphIndex_VLN::ParsedMultiQuery ( const CSphQuery & tQuery, CSphQueryResult
 	if ( m_bIsEmpty )
 		return true;
 
-	SetupRowIdBoundaries ( tQuery.m_dFilters, RowID_t(m_iDocinfo), *pRanker );
+	if ( tCtx.m_pRowIdBoundaries )
+		pRanker->ExtraData ( EXTRA_SET_BOUNDARIES, (void**)&tBoundaries );
 
-	if ( CheckEarlyReject ( dTransformedFilters, tCtx.m_pFilter.get(), tQuery.m_eCollation, tMaxSorterSchema ) )
+	bool bRejected = CheckEarlyReject ( dTransformedFilters, tCtx.m_pFilter.get(), tQuery.m_eCollation, tMaxSorterSchema );
+	if ( bRejected && tArgs.m_bCountPrunedChunk )
+		tMeta.m_tIteratorStats.m_iPrunedChunks++;
+
+	if ( bRejected || !bAnyBlock )
 	{
 		tMeta.AddQueryTimeUs ( sphMicroTimer() - tmQueryStart );
 		tMeta.m_iCpuTime += sphTaskCpuTimer ()-tmCpuQueryStart;
@@ -11982,17 +12419,29 @@ bool CSphIndex_VLN::ParsedMultiQuery ( const CSphQuery & tQuery, CSphQueryResult
 	bool bHasCutoff = iCutoff!=-1;
 
 	int iIndex = bUseKlist*64 + bHaveRandom*32 + bUseFactors*16 + bHasSortCalc*8 + bHasWeightFilter*4 + bHasFilterCalc*2 + bHasCutoff;
+	ISphMatchSorter * pPruneSorter = SetupTopKPruning ( pRanker.get(), tQuery, dSorters, tArgs.m_iIndexWeight, iCutoff );
+
+	// sibling pseudo-shards may have raised the floor already
+	if ( pPruneSorter )
+		UpdateTopKFloor ( pRanker.get(), pPruneSorter, tArgs.m_iIndexWeight, tArgs.m_pTopKFloor );
 
 	switch ( iIndex )
 	{
 #define DECL_FNSCAN( _, n, params ) case n: MatchExtended<!!(n&64), !!(n&32), !!(n&16), !!(n&8), !!(n&4), !!(n&2), !!(n&1)> params; break;
-	BOOST_PP_REPEAT ( 128, DECL_FNSCAN, ( tCtx, tQuery, dSorters, pRanker.get(), iMyTag, tArgs.m_iIndexWeight, iCutoff ) )
+	BOOST_PP_REPEAT ( 128, DECL_FNSCAN, ( tCtx, tQuery, dSorters, pRanker.get(), iMyTag, tArgs.m_iIndexWeight, iCutoff, pPruneSorter, tArgs.m_pTopKFloor ) )
 #undef DECL_FNSCAN
 		default:
 			assert ( 0 && "Internal error" );
 			break;
 	}
 
+	// pruned docs are not counted
+	if ( pPruneSorter && GetTopKPrunedDocs ( pRanker.get() ) )
+		tMeta.m_bTotalMatchesApprox = true;
+
+	if ( pPruneSorter )
+		tMeta.m_tIteratorStats.m_iPrunedDoclistBlocks += GetTopKPrunedBlocks ( pRanker.get() );
+
 	////////////////////
 	// cook result sets
 	////////////////////
@@ -12133,7 +12582,7 @@ void CSphIndex_VLN::GetStatus ( CSphIndexStatus* pRes ) const
 		pRes->m_iMappedResident += pRes->m_iMappedResidentHits;
 	}
 
-	pRes->m_iRamUse = sizeof(CSphIndex_VLN) + m_dFieldLens.GetLengthBytes() + pRes->m_iMappedResident;
+	pRes->m_iRamUse = sizeof(CSphIndex_VLN) + m_dFieldLens.GetLengthBytes() + m_tLookupFilter.GetLengthBytes() + pRes->m_iMappedResident;
 	pRes->m_iDiskUse = 0;
 
 	CSphVector<IndexFileExt_t> dExts = sphGetExts();
@@ -12920,6 +13369,12 @@ void sphSetJsonOptions ( bool bStrict, bool bAutoconvNumbers, bool bKeynamesToLo
 }
 
 
+void SetIndexerSortThreads ( int iThreads )
+{
+	g_iSortThreads = iThreads>0 ? iThreads : GetNumLogicalCPUs();
+}
+
+
 void SetPseudoSharding ( bool bSet )
 {
 	g_bPseudoSharding = bSet;
@@ -12938,6 +13393,24 @@ void SetPseudoShardingThresh ( int iThresh )
 }
 
 
+int GetPseudoShardingThresh()
+{
+	return g_iPseudoShardingThresh;
+}
+
+
+void SetMinMaxPruning ( bool bSet )
+{
+	g_bMinMaxPruning = bSet;
+}
+
+
+bool GetMinMaxPruning()
+{
+	return g_bMinMaxPruning;
+}
+
+
 void SetMergeSettings ( const BuildBufferSettings_t & tSettings )
 {
 	g_tMergeSettings = tSettings;
@@ -13577,6 +14050,9 @@ void sphGetSuggest ( const ISphWordlistSuggest * pWordlist, int iInfixCodepointB
 void IteratorStats_t::Merge ( const IteratorStats_t & tSrc )
 {
 	m_iTotal += tSrc.m_iTotal;
+	m_iPrunedChunks += tSrc.m_iPrunedChunks;
+	m_iPrunedBlocks += tSrc.m_iPrunedBlocks;
+	m_iPrunedDoclistBlocks += tSrc.m_iPrunedDoclistBlocks;
 
 	for ( const auto & i : tSrc.m_dIterators )
 	{
@@ -553,6 +553,7 @@ struct CSphQuery
 
 	int				m_iOffset=0;		///< offset into result set (as X in MySQL LIMIT X,Y clause)
 	int				m_iLimit=20;		///< limit into result set (as Y in MySQL LIMIT X,Y clause)
+	bool			m_bExplicitLimit = false;	///< did the query have LIMIT clause?
 	CSphVector<DWORD>	m_dWeights;		///< user-supplied per-field weights. may be NULL. default is NULL
 	ESphMatchMode	m_eMode = SPH_MATCH_EXTENDED;		///< match mode. default is "match all"
 	ESphRankMode	m_eRanker = SPH_RANK_DEFAULT;		///< ranking mode, default is proximity+BM25
@@ -572,6 +573,7 @@ struct CSphQuery
 	JiebaMode_e		m_eJiebaMode = JiebaMode_e::NONE;	///< separate optional jieba mode for searches
 
 	ScrollSettings_t m_tScrollSettings;
+	bool			m_bStream = false;	///< deliver the whole result set in id-ordered batches as they are found (sphinxql only)
 
 	bool			m_bSortKbuffer = false;		///< whether to use PQ or K-buffer sorting algorithm
 	bool			m_bZSlist = false;			///< whether the ranker has to fetch the zonespanlist with this query
@@ -582,6 +584,8 @@ struct CSphQuery
 	bool			m_bNormalizedTFIDF = true;	///< whether to scale IDFs by query word count, so that TF*IDF is normalized
 	std::optional<bool> m_bLocalDF;				///< whether to use calculate DF among local indexes
 	bool			m_bLowPriority = false;		///< set low thread priority for this query
+	bool			m_bTopKPruning = false;		///< skip docs whose weight can't get into the current top-k (total_found becomes approximate)
+	int64_t			m_iTopKFloor = 0;			///< final weight a doc has to reach to get into the top-k, known in advance (from the agents which already replied)
 	DWORD			m_uDebugFlags = 0;
 	QueryOption_e	m_eExpandKeywords = QUERY_OPT_DEFAULT;	///< control automatic query-time keyword expansion
 	int				m_iExpansionLimit = DEFAULT_QUERY_EXPANSION_LIMIT;	///< whether to limit wildcard expansion, default use index settings
@@ -658,6 +662,7 @@ struct CSphQuery
 	CSphVector<CSphQueryItem>	m_dRefItems;	///< select-list prior replacing by facet
 	ESphCollation				m_eCollation = SPH_COLLATION_DEFAULT;	///< ORDER BY collation
 	bool						m_bAgent = false;	///< agent mode (may need extra cols on output)
+	bool						m_bDistinctSketch = false;	///< return HLL sketches of group distinct values along with @distinct, for merging on master
 
 	CSphString		m_sQueryTokenFilterLib;		///< token filter library name
 	CSphString		m_sQueryTokenFilterName;	///< token filter name
@@ -716,6 +721,9 @@ struct IteratorStats_t
 {
 	CSphVector<IteratorDesc_t> m_dIterators;
 	int		m_iTotal = 0;
+	int64_t	m_iPrunedChunks = 0;	///< disk chunks (indexes) and RT RAM segments skipped by their attribute min/max
+	int64_t	m_iPrunedBlocks = 0;	///< attribute blocks skipped by their min/max
+	int64_t	m_iPrunedDoclistBlocks = 0;	///< doclist (skiplist) blocks skipped as below the top-k floor
 
 	void	Merge ( const IteratorStats_t & tSrc );
 };
@@ -1042,6 +1050,10 @@ struct CSphIndexStatus
 	double			m_fSaveRateLimit {0.0};	 // not used for plain. Part of m_iMemLimit to be achieved before flushing
 	int 			m_iLockCount = 0;		// not used for plain. N of active locks (i.e. - if N>0, saving is prohibited)
 	int 			m_iOptimizesCount = 0;	// not used for plain. N of currently run optimizes.
+	double			m_fRamWriteAmplification {0.0};	// not used for plain. Bytes written by RAM segment merges and commits vs bytes committed
+	int64_t			m_iRamSegmentMerges = 0;		// not used for plain
+	int64_t			m_iRamSegmentMergeTimeUs = 0;	// not used for plain
+	int64_t			m_iRamSegmentMergesDeferred = 0;	// not used for plain. N of merges postponed because of busy search pool
 };
 
 
@@ -1058,6 +1070,8 @@ struct CSphMultiQueryArgs : public ISphNoncopyable
 	int										m_iThreads = 1;
 	int										m_iTotalThreads = 1;
 	bool									m_bUseSICache = false;
+	std::atomic<int64_t> *					m_pTopKFloor = nullptr;	///< top-k pruning floor shared by pseudo-shards of the same index
+	bool									m_bCountPrunedChunk = true;	///< only one pseudo-shard of a chunk reports it as pruned
 
 	CSphMultiQueryArgs ( int iIndexWeight );
 };
@@ -1201,7 +1215,7 @@ void SetupDocstoreFields ( DocstoreAddField_i & tFields, const CSphSchema & tSch
 bool CheckStoredFields ( const CSphSchema & tSchema, const CSphIndexSettings & tSettings, CSphString & sError );
 
 class DiskIndexQwordTraits_c;
-DiskIndexQwordTraits_c * sphCreateDiskIndexQword ( bool bInlineHits );
+DiskIndexQwordTraits_c * sphCreateDiskIndexQword ( bool bInlineHits, bool bBlockDoclist );
 
 /// returns ranker name as string
 const char * sphGetRankerName ( ESphRankMode eRanker );
@@ -1581,13 +1595,25 @@ std::unique_ptr<CSphIndex>		sphCreateIndexTemplate ( CSphString sIndexName );
 /// bKeynamesToLowercase is whether to convert all key names to lowercase
 void				sphSetJsonOptions ( bool bStrict, bool bAutoconvNumbers, bool bKeynamesToLowercase );
 
+/// set how many threads sort collected hit blocks when building plain indexes (0 means one per logical CPU)
+void				SetIndexerSortThreads ( int iThreads );
+
 /// setup per-keyword read buffer sizes
 void				SetUnhintedBuffer ( int iReadUnhinted );
 int					GetUnhintedBuffer();
 
+/// async readahead of doclists/hitlists for access_doclists/access_hitlists=file
+void				SetReadPrefetch ( bool bPrefetch );
+bool				GetReadPrefetch();
+
 void				SetPseudoSharding ( bool bSet );
 bool				GetPseudoSharding();
 void				SetPseudoShardingThresh ( int iThresh );
+int					GetPseudoShardingThresh();
+
+/// skip disk chunks, RAM segments and attribute blocks by their min/max before searching them; searchd.minmax_pruning
+void				SetMinMaxPruning ( bool bSet );
+bool				GetMinMaxPruning();
 
 struct BuildBufferSettings_t;
 void				SetMergeSettings ( const BuildBufferSettings_t & tSettings );
@@ -35,6 +35,7 @@
 #include "datetime.h"
 #include "exprdatetime.h"
 #include "exprdocstore.h"
+#include "exprsimd.h"
 
 #if WITH_RE2
 #include <re2/re2.h>
@@ -146,6 +147,52 @@ const BYTE * ISphExpr::StringEvalPacked ( const CSphMatch & tMatch ) const
 	return pRes;
 }
 
+void ISphExpr::EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const
+{
+	ARRAY_CONSTFOREACH ( i, dMatches )
+		pOut[i] = Eval ( *dMatches[i] );
+}
+
+void ISphExpr::IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const
+{
+	ARRAY_CONSTFOREACH ( i, dMatches )
+		pOut[i] = IntEval ( *dMatches[i] );
+}
+
+void ISphExpr::Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const
+{
+	ARRAY_CONSTFOREACH ( i, dMatches )
+		pOut[i] = Int64Eval ( *dMatches[i] );
+}
+
+// typed dispatch, so that batch nodes may be written once for all evaluation types
+static inline void EvalExprBatch ( const ISphExpr * pExpr, const VecTraits_T<const CSphMatch *> & dMatches, float * pOut )		{ pExpr->EvalBatch ( dMatches, pOut ); }
+static inline void EvalExprBatch ( const ISphExpr * pExpr, const VecTraits_T<const CSphMatch *> & dMatches, int * pOut )		{ pExpr->IntEvalBatch ( dMatches, pOut ); }
+static inline void EvalExprBatch ( const ISphExpr * pExpr, const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut )	{ pExpr->Int64EvalBatch ( dMatches, pOut ); }
+
+// evaluates both args column-wise and then applies the op over plain arrays
+// the SIMD kernel (if the op has one) takes the leading values, the scalar op does the rest
+template<typename T, typename OP>
+static void EvalBinaryBatch ( const ISphExpr * pFirst, const ISphExpr * pSecond, const VecTraits_T<const CSphMatch *> & dMatches, T * pOut, ExprSimdOp_e eSimd, OP && fnOp )
+{
+	assert ( dMatches.GetLength()<=MAX_EXPR_BATCH );
+	T dSecond[MAX_EXPR_BATCH];
+	EvalExprBatch ( pFirst, dMatches, pOut );
+	EvalExprBatch ( pSecond, dMatches, dSecond );
+	int iLen = dMatches.GetLength();
+	for ( int i = ExprSimdApply ( eSimd, pOut, dSecond, iLen ); i<iLen; ++i )
+		pOut[i] = fnOp ( pOut[i], dSecond[i] );
+}
+
+template<typename T, typename OP>
+static void EvalUnaryBatch ( const ISphExpr * pFirst, const VecTraits_T<const CSphMatch *> & dMatches, T * pOut, ExprSimdOp_e eSimd, OP && fnOp )
+{
+	EvalExprBatch ( pFirst, dMatches, pOut );
+	int iLen = dMatches.GetLength();
+	for ( int i = ExprSimdApply ( eSimd, pOut, nullptr, iLen ); i<iLen; ++i )
+		pOut[i] = fnOp ( pOut[i] );
+}
+
 template<class BaseExpr_T>
 class Expr_WithLocator_T : public BaseExpr_T, public ExprLocatorTraits_t
 {
@@ -273,6 +320,10 @@ public:
 	int IntEval ( const CSphMatch & tMatch ) const final { return (int)tMatch.GetAttr ( m_tLocator ); }
 	int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return (int64_t)tMatch.GetAttr ( m_tLocator ); }
 
+	void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final				{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (float)dMatches[i]->GetAttr ( m_tLocator ); }
+	void IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const final				{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (int)dMatches[i]->GetAttr ( m_tLocator ); }
+	void Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const final		{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (int64_t)dMatches[i]->GetAttr ( m_tLocator ); }
+
 	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final
 	{
 		EXPR_CLASS_NAME("Expr_GetInt_c");
@@ -297,6 +348,10 @@ public:
 	int IntEval ( const CSphMatch & tMatch ) const final { return (int)tMatch.GetAttr ( m_tLocator ); }
 	int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return (int64_t)tMatch.GetAttr ( m_tLocator ); }
 
+	void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final				{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (float)dMatches[i]->GetAttr ( m_tLocator ); }
+	void IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const final				{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (int)dMatches[i]->GetAttr ( m_tLocator ); }
+	void Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const final		{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (int64_t)dMatches[i]->GetAttr ( m_tLocator ); }
+
 	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final
 	{
 		EXPR_CLASS_NAME("Expr_GetBits_c");
@@ -321,6 +376,10 @@ public:
 	int IntEval ( const CSphMatch & tMatch ) const final { return (int)tMatch.GetAttr ( m_tLocator ); }
 	int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return (int)tMatch.GetAttr ( m_tLocator ); }
 
+	void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final				{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (float)(int)dMatches[i]->GetAttr ( m_tLocator ); }
+	void IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const final				{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (int)dMatches[i]->GetAttr ( m_tLocator ); }
+	void Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const final		{ ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = (int64_t)(int)dMatches[i]->GetAttr ( m_tLocator ); }
+
 	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final
 	{
 		EXPR_CLASS_NAME("Expr_GetSint_c");
@@ -342,6 +401,7 @@ class Expr_GetFloat_c : public Expr_WithLocator_c
 public:
 	Expr_GetFloat_c ( const CSphAttrLocator & tLocator, const CSphString & sAttr ) : Expr_WithLocator_c ( tLocator, sAttr ) {}
 	float Eval ( const CSphMatch & tMatch ) const final { return tMatch.GetAttrFloat ( m_tLocator ); }
+	void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final { ARRAY_CONSTFOREACH ( i, dMatches ) pOut[i] = dMatches[i]->GetAttrFloat ( m_tLocator ); }
 
 	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final
 	{
@@ -491,6 +551,7 @@ public:
 	float Eval ( const CSphMatch & ) const final { return m_fValue; }
 	int IntEval ( const CSphMatch & ) const final { return (int)m_fValue; }
 	int64_t Int64Eval ( const CSphMatch & ) const final { return (int64_t)m_fValue; }
+	void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final { std::fill ( pOut, pOut+dMatches.GetLength(), m_fValue ); }
 	bool IsConst () const final { return true; }
 
 	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final
@@ -522,6 +583,9 @@ public:
 	float Eval ( const CSphMatch & ) const final { return (float) m_iValue; } // no assert() here cause generic float Eval() needs to work even on int-evaluator tree
 	int IntEval ( const CSphMatch & ) const final { return m_iValue; }
 	int64_t Int64Eval ( const CSphMatch & ) const final { return m_iValue; }
+	void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final { std::fill ( pOut, pOut+dMatches.GetLength(), (float)m_iValue ); }
+	void IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const final { std::fill ( pOut, pOut+dMatches.GetLength(), m_iValue ); }
+	void Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const final { std::fill ( pOut, pOut+dMatches.GetLength(), (int64_t)m_iValue ); }
 	bool IsConst () const final { return true; }
 	
 	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final
@@ -553,6 +617,8 @@ public:
 	float Eval ( const CSphMatch & ) const final { return (float) m_iValue; } // no assert() here cause generic float Eval() needs to work even on int-evaluator tree
 	int IntEval ( const CSphMatch & ) const final { assert ( 0 ); return (int)m_iValue; }
 	int64_t Int64Eval ( const CSphMatch & ) const final { return m_iValue; }
+	void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const final { std::fill ( pOut, pOut+dMatches.GetLength(), (float)m_iValue ); }
+	void Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const final { std::fill ( pOut, pOut+dMatches.GetLength(), m_iValue ); }
 	bool IsConst () const final { return true; }
 	
 	uint64_t GetHash ( const ISphSchema & tSorterSchema, uint64_t uPrevHash, bool & bDisable ) final
@@ -3274,16 +3340,42 @@ private:
 		int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return _expr3; } \
 	};
 
+// batch flavours; ops are written in terms of plain args 'a' (and 'b' for binary ones)
+// _simd names the native kernel that does the same op (NONE if there's none), scalar _op handles the rest
+#define BATCH_UNARY(_type,_method,_simd,_op) \
+		void _method ( const VecTraits_T<const CSphMatch *> & dMatches, _type * pOut ) const final \
+		{ EvalUnaryBatch ( m_pFirst, dMatches, pOut, ExprSimdOp_e::_simd, [] ( _type a ) -> _type { return _op; } ); }
+
+#define BATCH_BINARY(_type,_method,_simd,_op) \
+		void _method ( const VecTraits_T<const CSphMatch *> & dMatches, _type * pOut ) const final \
+		{ EvalBinaryBatch ( m_pFirst, m_pSecond, dMatches, pOut, ExprSimdOp_e::_simd, [] ( _type a, _type b ) -> _type { return _op; } ); }
+
+#define DECLARE_UNARY_FLT_BATCH(_classname,_expr,_simd,_op) \
+		DECLARE_UNARY_TRAITS ( _classname ) \
+		float Eval ( const CSphMatch & tMatch ) const final { return _expr; } \
+		BATCH_UNARY ( float, EvalBatch, _simd, _op ) \
+	};
+
+#define DECLARE_UNARY_INT_BATCH(_classname,_expr,_expr2,_expr3,_simd,_op,_op2,_op3) \
+		DECLARE_UNARY_TRAITS ( _classname ) \
+		float Eval ( const CSphMatch & tMatch ) const final { return (float)_expr; } \
+		int IntEval ( const CSphMatch & tMatch ) const final { return _expr2; } \
+		int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return _expr3; } \
+		BATCH_UNARY ( float, EvalBatch, _simd, _op ) \
+		BATCH_UNARY ( int, IntEvalBatch, _simd, _op2 ) \
+		BATCH_UNARY ( int64_t, Int64EvalBatch, _simd, _op3 ) \
+	};
+
 #define IABS(_arg) ( (_arg)>0 ? (_arg) : (-_arg) )
 
-DECLARE_UNARY_INT ( Expr_Neg_c,		-EVALFIRST,					-INTFIRST,			-INT64FIRST )
-DECLARE_UNARY_INT ( Expr_Abs_c,		fabs(EVALFIRST),			IABS(INTFIRST),		IABS(INT64FIRST) )
+DECLARE_UNARY_INT_BATCH ( Expr_Neg_c,	-EVALFIRST,			-INTFIRST,			-INT64FIRST,		NEG,	-a,			-a,			-a )
+DECLARE_UNARY_INT_BATCH ( Expr_Abs_c,	fabs(EVALFIRST),	IABS(INTFIRST),		IABS(INT64FIRST),	ABS,	fabsf(a),	IABS(a),	IABS(a) )
 DECLARE_UNARY_INT ( Expr_Ceil_c,	float(ceil(EVALFIRST)),		int(ceil(EVALFIRST)),	int64_t(ceil(EVALFIRST)) )
 DECLARE_UNARY_INT ( Expr_Floor_c,	float(floor(EVALFIRST)),	int(floor(EVALFIRST)),	int64_t(floor(EVALFIRST)) )
 
-DECLARE_UNARY_FLT ( Expr_Sin_c,		float(sin(EVALFIRST)) )
-DECLARE_UNARY_FLT ( Expr_Cos_c,		float(cos(EVALFIRST)) )
-DECLARE_UNARY_FLT ( Expr_Exp_c,		float(exp(EVALFIRST)) )
+DECLARE_UNARY_FLT_BATCH ( Expr_Sin_c,		float(sin(EVALFIRST)),	NONE,	float(sin(a)) )
+DECLARE_UNARY_FLT_BATCH ( Expr_Cos_c,		float(cos(EVALFIRST)),	NONE,	float(cos(a)) )
+DECLARE_UNARY_FLT_BATCH ( Expr_Exp_c,		float(exp(EVALFIRST)),	NONE,	float(exp(a)) )
 
 DECLARE_UNARY_INT ( Expr_NotInt_c,		(float)(INTFIRST?0:1),		INTFIRST?0:1,	INTFIRST?0:1 )
 DECLARE_UNARY_INT ( Expr_NotInt64_c,	(float)(INT64FIRST?0:1),	INT64FIRST?0:1,	INT64FIRST?0:1 )
@@ -3296,6 +3388,8 @@ DECLARE_UNARY_TRAITS ( Expr_Ln_c )
 			   // ideally this would be SQLNULL instead of plain 0.0f
 			   return fFirst>0.0f ? (float)log ( fFirst ) : 0.0f;
 	   }
+
+	   BATCH_UNARY ( float, EvalBatch, NONE, a>0.0f ? (float)log ( a ) : 0.0f )
 DECLARE_END()
 
 DECLARE_UNARY_TRAITS ( Expr_Log2_c )
@@ -3305,6 +3399,8 @@ DECLARE_UNARY_TRAITS ( Expr_Log2_c )
 			   // ideally this would be SQLNULL instead of plain 0.0f
 			   return fFirst>0.0f ? (float)( log ( fFirst )*M_LOG2E ) : 0.0f;
 	   }
+
+	   BATCH_UNARY ( float, EvalBatch, NONE, a>0.0f ? (float)( log ( a )*M_LOG2E ) : 0.0f )
 DECLARE_END()
 
 DECLARE_UNARY_TRAITS ( Expr_Log10_c )
@@ -3314,6 +3410,8 @@ DECLARE_UNARY_TRAITS ( Expr_Log10_c )
 			   // ideally this would be SQLNULL instead of plain 0.0f
 			   return fFirst>0.0f ? (float)( log ( fFirst )*M_LOG10E ) : 0.0f;
 	   }
+
+	   BATCH_UNARY ( float, EvalBatch, NONE, a>0.0f ? (float)( log ( a )*M_LOG10E ) : 0.0f )
 DECLARE_END()
 
 DECLARE_UNARY_TRAITS ( Expr_Sqrt_c )
@@ -3324,6 +3422,8 @@ DECLARE_UNARY_TRAITS ( Expr_Sqrt_c )
 			   // MEGA optimization: do not call sqrt for 0.0f
 			   return fFirst>0.0f ? (float)sqrt ( fFirst ) : 0.0f;
 	   }
+
+	   BATCH_UNARY ( float, EvalBatch, SQRT, a>0.0f ? (float)sqrt ( a ) : 0.0f )
 DECLARE_END()
 
 //////////////////////////////////////////////////////////////////////////
@@ -3349,6 +3449,16 @@ DECLARE_END()
 		int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return _expr3; } \
 	};
 
+#define DECLARE_BINARY_INT_BATCH(_classname,_expr,_expr2,_expr3,_simd,_op,_op2,_op3) \
+		DECLARE_BINARY_TRAITS ( _classname, Expr_Binary_c ) \
+		float Eval ( const CSphMatch & tMatch ) const final { return _expr; } \
+		int IntEval ( const CSphMatch & tMatch ) const final { return _expr2; } \
+		int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return _expr3; } \
+		BATCH_BINARY ( float, EvalBatch, _simd, _op ) \
+		BATCH_BINARY ( int, IntEvalBatch, _simd, _op2 ) \
+		BATCH_BINARY ( int64_t, Int64EvalBatch, _simd, _op3 ) \
+	};
+
 #define DECLARE_BINARY_INT_EXPR(_classname,_expr,_expr2,_expr3,_expr4) \
 		DECLARE_BINARY_TRAITS ( _classname, Expr_BinaryFilter_c ) \
 		float Eval ( const CSphMatch & tMatch ) const final { return _expr; } \
@@ -3366,12 +3476,31 @@ DECLARE_END()
 	DECLARE_BINARY_INT_EXPR ( _classname##Int_c,	(float)IntEval(tMatch),		_expr2,					(int64_t)IntEval(tMatch),	_expr4 ) \
 	DECLARE_BINARY_INT_EXPR ( _classname##Int64_c,	(float)Int64Eval(tMatch),	(int)Int64Eval(tMatch),	_expr3,						_expr4 )
 
+// same as above, but each flavour also batches its native evaluation type
+#define DECLARE_BINARY_INT_EXPR_BATCH(_classname,_expr,_expr2,_expr3,_expr4,_type,_method,_simd,_op) \
+		DECLARE_BINARY_TRAITS ( _classname, Expr_BinaryFilter_c ) \
+		float Eval ( const CSphMatch & tMatch ) const final { return _expr; } \
+		int IntEval ( const CSphMatch & tMatch ) const final { return _expr2; } \
+		int64_t Int64Eval ( const CSphMatch & tMatch ) const final { return _expr3; } \
+		BATCH_BINARY ( _type, _method, _simd, _op ) \
+		void Command ( ESphExprCommand eCmd, void * pArg ) final \
+		{ \
+			Expr_Binary_c::Command ( eCmd, pArg ); \
+			_expr4 ( eCmd, pArg ); \
+		} \
+	};
+
+#define DECLARE_BINARY_POLY_BATCH(_classname,_expr,_expr2,_expr3,_expr4,_simd,_op,_op2,_op3) \
+	DECLARE_BINARY_INT_EXPR_BATCH ( _classname##Float_c,	_expr,						(int)Eval(tMatch),		(int64_t)Eval(tMatch ),		_expr4, float, EvalBatch, _simd, _op ) \
+	DECLARE_BINARY_INT_EXPR_BATCH ( _classname##Int_c,		(float)IntEval(tMatch),		_expr2,					(int64_t)IntEval(tMatch),	_expr4, int, IntEvalBatch, _simd, _op2 ) \
+	DECLARE_BINARY_INT_EXPR_BATCH ( _classname##Int64_c,	(float)Int64Eval(tMatch),	(int)Int64Eval(tMatch),	_expr3,						_expr4, int64_t, Int64EvalBatch, _simd, _op3 )
+
 #define IFFLT(_expr)	( (_expr) ? 1.0f : 0.0f )
 #define IFINT(_expr)	( (_expr) ? 1 : 0 )
 
-DECLARE_BINARY_INT ( Expr_Add_c,	EVALFIRST + EVALSECOND,						(DWORD)INTFIRST + (DWORD)INTSECOND,				(uint64_t)INT64FIRST + (uint64_t)INT64SECOND )
-DECLARE_BINARY_INT ( Expr_Sub_c,	EVALFIRST - EVALSECOND,						(DWORD)INTFIRST - (DWORD)INTSECOND,				(uint64_t)INT64FIRST - (uint64_t)INT64SECOND )
-DECLARE_BINARY_INT ( Expr_Mul_c,	EVALFIRST * EVALSECOND,						(DWORD)INTFIRST * (DWORD)INTSECOND,				(uint64_t)INT64FIRST * (uint64_t)INT64SECOND )
+DECLARE_BINARY_INT_BATCH ( Expr_Add_c,	EVALFIRST + EVALSECOND,		(DWORD)INTFIRST + (DWORD)INTSECOND,		(uint64_t)INT64FIRST + (uint64_t)INT64SECOND,	ADD,	a+b,	int ( (DWORD)a+(DWORD)b ),	int64_t ( (uint64_t)a+(uint64_t)b ) )
+DECLARE_BINARY_INT_BATCH ( Expr_Sub_c,	EVALFIRST - EVALSECOND,		(DWORD)INTFIRST - (DWORD)INTSECOND,		(uint64_t)INT64FIRST - (uint64_t)INT64SECOND,	SUB,	a-b,	int ( (DWORD)a-(DWORD)b ),	int64_t ( (uint64_t)a-(uint64_t)b ) )
+DECLARE_BINARY_INT_BATCH ( Expr_Mul_c,	EVALFIRST * EVALSECOND,		(DWORD)INTFIRST * (DWORD)INTSECOND,		(uint64_t)INT64FIRST * (uint64_t)INT64SECOND,	MUL,	a*b,	int ( (DWORD)a*(DWORD)b ),	int64_t ( (uint64_t)a*(uint64_t)b ) )
 DECLARE_BINARY_INT ( Expr_BitAnd_c,	(float)(int(EVALFIRST)&int(EVALSECOND)),	INTFIRST & INTSECOND,				INT64FIRST & INT64SECOND )
 DECLARE_BINARY_INT ( Expr_BitOr_c,	(float)(int(EVALFIRST)|int(EVALSECOND)),	INTFIRST | INTSECOND,				INT64FIRST | INT64SECOND )
 DECLARE_BINARY_INT ( Expr_Mod_c,	(float)(int(EVALFIRST)%int(EVALSECOND)),	INTFIRST % INTSECOND,				INT64FIRST % INT64SECOND )
@@ -3383,6 +3512,8 @@ DECLARE_BINARY_TRAITS ( Expr_Div_c, Expr_Binary_c )
 			   // ideally this would be SQLNULL instead of plain 0.0f
 			   return fSecond!=0.0f ? m_pFirst->Eval ( tMatch )/fSecond : 0.0f;
 	   }
+
+	   BATCH_BINARY ( float, EvalBatch, DIV, b!=0.0f ? a/b : 0.0f )
 DECLARE_END()
 
 DECLARE_BINARY_TRAITS ( Expr_Idiv_c, Expr_Binary_c )
@@ -3408,15 +3539,21 @@ DECLARE_BINARY_TRAITS ( Expr_Idiv_c, Expr_Binary_c )
 	}
 DECLARE_END()
 
-DECLARE_BINARY_POLY ( Expr_Lt,		IFFLT ( EVALFIRST<EVALSECOND ),					IFINT ( INTFIRST<INTSECOND ),		IFINT ( INT64FIRST<INT64SECOND  ), PopulateConstArgsLtInt )
-DECLARE_BINARY_POLY ( Expr_Gt,		IFFLT ( EVALFIRST>EVALSECOND ),					IFINT ( INTFIRST>INTSECOND ),		IFINT ( INT64FIRST>INT64SECOND  ), PopulateConstArgsGtInt )
-DECLARE_BINARY_POLY ( Expr_Lte,		IFFLT ( EVALFIRST<=EVALSECOND ),				IFINT ( INTFIRST<=INTSECOND ),		IFINT ( INT64FIRST<=INT64SECOND ), PopulateConstArgsLteInt )
-DECLARE_BINARY_POLY ( Expr_Gte,		IFFLT ( EVALFIRST>=EVALSECOND ),				IFINT ( INTFIRST>=INTSECOND ),		IFINT ( INT64FIRST>=INT64SECOND ), PopulateConstArgsGteInt )
-DECLARE_BINARY_POLY ( Expr_Eq,		IFFLT ( fabs ( EVALFIRST-EVALSECOND )<=1e-6 ),	IFINT ( INTFIRST==INTSECOND ),		IFINT ( INT64FIRST==INT64SECOND ), PopulateConstArgsEqInt )
-DECLARE_BINARY_POLY ( Expr_Ne,		IFFLT ( fabs ( EVALFIRST-EVALSECOND )>1e-6 ),	IFINT ( INTFIRST!=INTSECOND ),		IFINT ( INT64FIRST!=INT64SECOND ), PopulateConstArgsNeInt )
-
-DECLARE_BINARY_INT ( Expr_Min_c,	Min ( EVALFIRST, EVALSECOND ),					Min ( INTFIRST, INTSECOND ),		Min ( INT64FIRST, INT64SECOND ) )
-DECLARE_BINARY_INT ( Expr_Max_c,	Max ( EVALFIRST, EVALSECOND ),					Max ( INTFIRST, INTSECOND ),		Max ( INT64FIRST, INT64SECOND ) )
+DECLARE_BINARY_POLY_BATCH ( Expr_Lt,		IFFLT ( EVALFIRST<EVALSECOND ),					IFINT ( INTFIRST<INTSECOND ),		IFINT ( INT64FIRST<INT64SECOND  ), PopulateConstArgsLtInt,
+	LT,		IFFLT ( a<b ),	IFINT ( a<b ),	IFINT ( a<b ) )
+DECLARE_BINARY_POLY_BATCH ( Expr_Gt,		IFFLT ( EVALFIRST>EVALSECOND ),					IFINT ( INTFIRST>INTSECOND ),		IFINT ( INT64FIRST>INT64SECOND  ), PopulateConstArgsGtInt,
+	GT,		IFFLT ( a>b ),	IFINT ( a>b ),	IFINT ( a>b ) )
+DECLARE_BINARY_POLY_BATCH ( Expr_Lte,		IFFLT ( EVALFIRST<=EVALSECOND ),				IFINT ( INTFIRST<=INTSECOND ),		IFINT ( INT64FIRST<=INT64SECOND ), PopulateConstArgsLteInt,
+	LTE,	IFFLT ( a<=b ),	IFINT ( a<=b ),	IFINT ( a<=b ) )
+DECLARE_BINARY_POLY_BATCH ( Expr_Gte,		IFFLT ( EVALFIRST>=EVALSECOND ),				IFINT ( INTFIRST>=INTSECOND ),		IFINT ( INT64FIRST>=INT64SECOND ), PopulateConstArgsGteInt,
+	GTE,	IFFLT ( a>=b ),	IFINT ( a>=b ),	IFINT ( a>=b ) )
+DECLARE_BINARY_POLY_BATCH ( Expr_Eq,		IFFLT ( fabs ( EVALFIRST-EVALSECOND )<=1e-6 ),	IFINT ( INTFIRST==INTSECOND ),		IFINT ( INT64FIRST==INT64SECOND ), PopulateConstArgsEqInt,
+	EQ,		IFFLT ( fabs ( a-b )<=1e-6 ),	IFINT ( a==b ),	IFINT ( a==b ) )
+DECLARE_BINARY_POLY_BATCH ( Expr_Ne,		IFFLT ( fabs ( EVALFIRST-EVALSECOND )>1e-6 ),	IFINT ( INTFIRST!=INTSECOND ),		IFINT ( INT64FIRST!=INT64SECOND ), PopulateConstArgsNeInt,
+	NE,		IFFLT ( fabs ( a-b )>1e-6 ),	IFINT ( a!=b ),	IFINT ( a!=b ) )
+
+DECLARE_BINARY_INT_BATCH ( Expr_Min_c,	Min ( EVALFIRST, EVALSECOND ),	Min ( INTFIRST, INTSECOND ),	Min ( INT64FIRST, INT64SECOND ),	MIN,	Min ( a, b ),	Min ( a, b ),	Min ( a, b ) )
+DECLARE_BINARY_INT_BATCH ( Expr_Max_c,	Max ( EVALFIRST, EVALSECOND ),	Max ( INTFIRST, INTSECOND ),	Max ( INT64FIRST, INT64SECOND ),	MAX,	Max ( a, b ),	Max ( a, b ),	Max ( a, b ) )
 DECLARE_BINARY_FLT ( Expr_Pow_c,	float ( pow ( EVALFIRST, EVALSECOND ) ) )
 
 DECLARE_BINARY_POLY ( Expr_And,		EVALFIRST!=0.0f && EVALSECOND!=0.0f,		IFINT ( INTFIRST && INTSECOND ),	IFINT ( INT64FIRST && INT64SECOND ), SetFlagAnd )
@@ -18,6 +18,7 @@
 #include "std/string.h"
 #include "std/sharedptr.h"
 #include "std/stringhash.h"
+#include "std/vectraits.h"
 
 /// forward decls
 class CSphMatch;
@@ -105,6 +106,10 @@ enum ESphExprCommand
 class CSphFilterSettings;
 class SIContainer_c;
 
+/// max number of matches evaluated by a single batch call
+/// batch evaluators keep their intermediate results on stack, so callers must split larger sets
+const int MAX_EXPR_BATCH = 128;
+
 /// expression evaluator
 /// can always be evaluated in floats using Eval()
 /// can sometimes be evaluated in integers using IntEval(), depending on type as returned from sphExprParse()
@@ -120,6 +125,12 @@ public:
 	/// evaluate this expression for that match, using int64 math
 	virtual int64_t Int64Eval ( const CSphMatch & tMatch ) const { assert ( 0 ); return (int64_t) Eval ( tMatch ); }
 
+	/// evaluate this expression for a batch of matches (up to MAX_EXPR_BATCH) into a contiguous array
+	/// defaults loop over the matches; arithmetic, comparison, math and attribute nodes override them
+	virtual void EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, float * pOut ) const;
+	virtual void IntEvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int * pOut ) const;
+	virtual void Int64EvalBatch ( const VecTraits_T<const CSphMatch *> & dMatches, int64_t * pOut ) const;
+
 	/// Evaluate string attr.
 	/// Note, that sometimes this method returns pointer to a static buffer
 	/// and sometimes it allocates a new buffer, so aware of memory leaks.
@@ -31,6 +31,75 @@
 #pragma warning(disable:4250) // inheritance via dominance is our intent
 #endif
 
+/// block evaluation helpers
+/// values of a block are gathered first, so that the compare loops below stay branch-free and the compiler can vectorize them
+
+static FORCE_INLINE void GatherRowAttrs ( const CSphRowitem * const * ppRows, int iRows, const CSphAttrLocator & tLoc, SphAttr_t * pValues )
+{
+	if ( tLoc.m_iBitCount==ROWITEM_BITS )
+	{
+		int iItem = tLoc.m_iBitOffset >> ROWITEM_SHIFT;
+		for ( int i = 0; i < iRows; ++i )
+			pValues[i] = SphAttr_t ( ppRows[i][iItem] );
+		return;
+	}
+
+	for ( int i = 0; i < iRows; ++i )
+		pValues[i] = sphGetRowAttr ( ppRows[i], tLoc );
+}
+
+
+template <typename T, typename TEST>
+static FORCE_INLINE void MakeRowMask ( const T * pValues, int iRows, uint64_t * pMask, TEST && fnTest )
+{
+	for ( int iWord = 0; iWord < FILTER_MASK_WORDS; ++iWord )
+	{
+		const T * pWordValues = pValues + iWord*64;
+		int iWordRows = Min ( Max ( iRows-iWord*64, 0 ), 64 );
+		uint64_t uWord = 0;
+		for ( int i = 0; i < iWordRows; ++i )
+			uWord |= uint64_t ( fnTest ( pWordValues[i] ) ) << i;
+
+		pMask[iWord] = uWord;
+	}
+}
+
+
+static FORCE_INLINE bool IsRowMaskEmpty ( const uint64_t * pMask )
+{
+	uint64_t uAny = 0;
+	for ( int i = 0; i < FILTER_MASK_WORDS; ++i )
+		uAny |= pMask[i];
+
+	return !uAny;
+}
+
+
+static FORCE_INLINE void AndRowMask ( uint64_t * pMask, const uint64_t * pRhs )
+{
+	for ( int i = 0; i < FILTER_MASK_WORDS; ++i )
+		pMask[i] &= pRhs[i];
+}
+
+
+static FORCE_INLINE void OrRowMask ( uint64_t * pMask, const uint64_t * pRhs )
+{
+	for ( int i = 0; i < FILTER_MASK_WORDS; ++i )
+		pMask[i] |= pRhs[i];
+}
+
+
+static FORCE_INLINE void NotRowMask ( uint64_t * pMask, int iRows )
+{
+	for ( int iWord = 0; iWord < FILTER_MASK_WORDS; ++iWord )
+	{
+		int iWordRows = Min ( Max ( iRows-iWord*64, 0 ), 64 );
+		uint64_t uValid = iWordRows==64 ? ~0ULL : ( 1ULL << iWordRows ) - 1;
+		pMask[iWord] = ~pMask[iWord] & uValid;
+	}
+}
+
+
 /// attribute-based
 struct IFilter_Attr: virtual ISphFilter
 {
@@ -40,6 +109,12 @@ struct IFilter_Attr: virtual ISphFilter
 	{
 		m_tLocator = tLocator;
 	}
+
+	// block evaluation only handles attributes stored in the static part of plain rows
+	inline bool IsPlainRowAttr() const
+	{
+		return !m_tLocator.m_bDynamic && !m_tLocator.IsBlobAttr() && m_tLocator.m_iBitOffset>=0 && m_tLocator.m_iBitCount>0;
+	}
 };
 
 /// values
@@ -126,6 +201,21 @@ public:
 		return EvalValues ( tMatch.GetAttr ( m_tLocator ) );
 	}
 
+	bool CanEvalRows() const final { return IsPlainRowAttr(); }
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		SphAttr_t dValues[FILTER_BLOCK_ROWS];
+		GatherRowAttrs ( ppRows, iRows, m_tLocator, dValues );
+
+		// short lists are cheaper to compare against in full than to bisect
+		const int SHORT_LIST = 8;
+		if ( !m_tValues.IsEmpty() && m_tValues.GetLength()<=SHORT_LIST )
+			MakeRowMask ( dValues, iRows, pMask, [this] ( SphAttr_t tValue ) { return m_tValues.any_of ( [tValue] ( SphAttr_t tRef ) { return tRef==tValue; } ); } );
+		else
+			MakeRowMask ( dValues, iRows, pMask, [this] ( SphAttr_t tValue ) { return EvalValues(tValue); } );
+	}
+
 	bool EvalBlock ( const DWORD * pMinDocinfo, const DWORD * pMaxDocinfo ) const final
 	{
 		if ( m_tLocator.m_bDynamic )
@@ -153,6 +243,15 @@ public:
 		return tMatch.GetAttr ( m_tLocator )==m_RefValue;
 	}
 
+	bool CanEvalRows() const final { return IsPlainRowAttr(); }
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		SphAttr_t dValues[FILTER_BLOCK_ROWS];
+		GatherRowAttrs ( ppRows, iRows, m_tLocator, dValues );
+		MakeRowMask ( dValues, iRows, pMask, [tRef = m_RefValue] ( SphAttr_t tValue ) { return tValue==tRef; } );
+	}
+
 	bool EvalBlock ( const DWORD * pMinDocinfo, const DWORD * pMaxDocinfo ) const final
 	{
 		if ( m_tLocator.m_bDynamic )
@@ -200,6 +299,15 @@ struct Filter_Range : public IFilter_Attr, public IFilter_Range
 		return EvalRange<HAS_EQUAL_MIN,HAS_EQUAL_MAX,OPEN_LEFT,OPEN_RIGHT> ( tMatch.GetAttr ( m_tLocator ), m_iMinValue, m_iMaxValue );
 	}
 
+	bool CanEvalRows() const final { return IsPlainRowAttr(); }
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		SphAttr_t dValues[FILTER_BLOCK_ROWS];
+		GatherRowAttrs ( ppRows, iRows, m_tLocator, dValues );
+		MakeRowMask ( dValues, iRows, pMask, [tMin = m_iMinValue, tMax = m_iMaxValue] ( SphAttr_t tValue ) { return EvalRange<HAS_EQUAL_MIN,HAS_EQUAL_MAX,OPEN_LEFT,OPEN_RIGHT> ( tValue, tMin, tMax ); } );
+	}
+
 	bool EvalBlock ( const DWORD * pMinDocinfo, const DWORD * pMaxDocinfo ) const final
 	{
 		if ( m_tLocator.m_bDynamic )
@@ -566,6 +674,22 @@ struct Filter_And2 final : public ISphFilter
 		return m_pArg1->Eval ( tMatch ) && m_pArg2->Eval ( tMatch );
 	}
 
+	bool CanEvalRows() const final
+	{
+		return m_pArg1->CanEvalRows() && m_pArg2->CanEvalRows();
+	}
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		m_pArg1->EvalRows ( ppRows, iRows, pMask );
+		if ( IsRowMaskEmpty(pMask) )
+			return;
+
+		uint64_t dMask[FILTER_MASK_WORDS];
+		m_pArg2->EvalRows ( ppRows, iRows, dMask );
+		AndRowMask ( pMask, dMask );
+	}
+
 	bool EvalBlock ( const DWORD * pMin, const DWORD * pMax ) const final
 	{
 		return m_pArg1->EvalBlock ( pMin, pMax ) && m_pArg2->EvalBlock ( pMin, pMax );
@@ -613,6 +737,27 @@ struct Filter_And3 final : public ISphFilter
 		return m_pArg1->Eval ( tMatch ) && m_pArg2->Eval ( tMatch ) && m_pArg3->Eval ( tMatch );
 	}
 
+	bool CanEvalRows() const final
+	{
+		return m_pArg1->CanEvalRows() && m_pArg2->CanEvalRows() && m_pArg3->CanEvalRows();
+	}
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		m_pArg1->EvalRows ( ppRows, iRows, pMask );
+		if ( IsRowMaskEmpty(pMask) )
+			return;
+
+		uint64_t dMask[FILTER_MASK_WORDS];
+		m_pArg2->EvalRows ( ppRows, iRows, dMask );
+		AndRowMask ( pMask, dMask );
+		if ( IsRowMaskEmpty(pMask) )
+			return;
+
+		m_pArg3->EvalRows ( ppRows, iRows, dMask );
+		AndRowMask ( pMask, dMask );
+	}
+
 	bool EvalBlock ( const DWORD * pMin, const DWORD * pMax ) const final
 	{
 		return m_pArg1->EvalBlock ( pMin, pMax ) && m_pArg2->EvalBlock ( pMin, pMax ) && m_pArg3->EvalBlock ( pMin, pMax );
@@ -662,6 +807,24 @@ struct Filter_And final : public ISphFilter
 		return true;
 	}
 
+	bool CanEvalRows() const final
+	{
+		return m_dFilters.all_of ( [] ( auto & pFilter ) { return pFilter->CanEvalRows(); } );
+	}
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		assert ( !m_dFilters.IsEmpty() );
+		m_dFilters[0]->EvalRows ( ppRows, iRows, pMask );
+
+		uint64_t dMask[FILTER_MASK_WORDS];
+		for ( int i = 1; i < m_dFilters.GetLength() && !IsRowMaskEmpty(pMask); ++i )
+		{
+			m_dFilters[i]->EvalRows ( ppRows, iRows, dMask );
+			AndRowMask ( pMask, dMask );
+		}
+	}
+
 	bool EvalBlock ( const DWORD * pMinDocinfo, const DWORD * pMaxDocinfo ) const final
 	{
 		for ( auto& pFilter : m_dFilters )
@@ -721,6 +884,19 @@ struct Filter_Or final : public ISphFilter
 		return ( m_pLeft->Eval ( tMatch ) || m_pRight->Eval ( tMatch ) );
 	}
 
+	bool CanEvalRows() const final
+	{
+		return m_pLeft->CanEvalRows() && m_pRight->CanEvalRows();
+	}
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		uint64_t dMask[FILTER_MASK_WORDS];
+		m_pLeft->EvalRows ( ppRows, iRows, pMask );
+		m_pRight->EvalRows ( ppRows, iRows, dMask );
+		OrRowMask ( pMask, dMask );
+	}
+
 	bool EvalBlock ( const DWORD * pMinDocinfo, const DWORD * pMaxDocinfo ) const final
 	{
 		return ( m_pLeft->EvalBlock ( pMinDocinfo, pMaxDocinfo ) || m_pRight->EvalBlock ( pMinDocinfo, pMaxDocinfo ) );
@@ -769,6 +945,17 @@ struct Filter_Not final : public ISphFilter
 		return !m_pFilter->Eval ( tMatch );
 	}
 
+	bool CanEvalRows() const final
+	{
+		return m_pFilter->CanEvalRows();
+	}
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		m_pFilter->EvalRows ( ppRows, iRows, pMask );
+		NotRowMask ( pMask, iRows );
+	}
+
 	bool EvalBlock ( const DWORD *, const DWORD * ) const final
 	{
 		// if block passes through the filter we can't just negate the
@@ -807,6 +994,16 @@ public:
 		return m_pFilter->Eval ( tMatch );
 	}
 
+	bool CanEvalRows() const final
+	{
+		return m_pFilter->CanEvalRows();
+	}
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		m_pFilter->EvalRows ( ppRows, iRows, pMask );
+	}
+
 	bool EvalBlock ( const DWORD * uVal1, const DWORD * uVal2 ) const final
 	{
 		return m_pFilter->EvalBlock ( uVal1, uVal2 );
@@ -944,20 +1141,20 @@ static inline std::unique_ptr<ISphFilter> ReportError ( CSphString & sError, con
 }
 
 
-#define CREATE_EXPR_RANGE_FILTER(FILTER,EXPR,bHasEqualMin,bHasEqualMax) \
+#define CREATE_EXPR_RANGE_FILTER(FILTER,bHasEqualMin,bHasEqualMax,...) \
 { \
 	if ( bHasEqualMin ) \
 	{ \
 		if ( bHasEqualMax ) \
-			return std::make_unique<FILTER<true,true>>(EXPR); \
+			return std::make_unique<FILTER<true,true>>(__VA_ARGS__); \
 		else \
-			return std::make_unique<FILTER<true,false>>(EXPR); \
+			return std::make_unique<FILTER<true,false>>(__VA_ARGS__); \
 	} else \
 	{ \
 		if ( bHasEqualMax ) \
-			return std::make_unique<FILTER<false,true>>(EXPR); \
+			return std::make_unique<FILTER<false,true>>(__VA_ARGS__); \
 		else \
-			return std::make_unique<FILTER<false,false>>(EXPR); \
+			return std::make_unique<FILTER<false,false>>(__VA_ARGS__); \
 	} \
 }
 
@@ -1064,8 +1261,9 @@ template<typename BASE>
 class ExprFilter_c : public BASE
 {
 public:
-	explicit ExprFilter_c ( ISphExpr * pExpr )
+	explicit ExprFilter_c ( ISphExpr * pExpr, bool bRowExpr = false )
 		: m_pExpr ( pExpr )
+		, m_bRowExpr ( bRowExpr )
 	{
 		SafeAddRef ( pExpr );
 	}
@@ -1088,6 +1286,31 @@ public:
 protected:
 	const BYTE *				m_pBlobPool {nullptr};
 	CSphRefcountedPtr<ISphExpr>	m_pExpr;
+	bool						m_bRowExpr = false;	///< expression reads nothing but static row attrs, so it can be evaluated over bare rows
+
+	/// evaluates the expression over a block of rows with a single batch call
+	template<typename T>
+	void EvalRowValues ( const CSphRowitem * const * ppRows, int iRows, T * pValues ) const
+	{
+		static_assert ( FILTER_BLOCK_ROWS<=MAX_EXPR_BATCH, "filter block must fit into an expression batch" );
+		assert ( m_bRowExpr );
+
+		CSphMatch dMatches[FILTER_BLOCK_ROWS];
+		const CSphMatch * dMatchPtrs[FILTER_BLOCK_ROWS];
+		for ( int i = 0; i < iRows; ++i )
+		{
+			dMatches[i].m_pStatic = ppRows[i];
+			dMatchPtrs[i] = &dMatches[i];
+		}
+
+		VecTraits_T<const CSphMatch *> dBatch ( dMatchPtrs, iRows );
+		if constexpr ( std::is_same_v<T, float> )
+			m_pExpr->EvalBatch ( dBatch, pValues );
+		else if constexpr ( std::is_same_v<T, int> )
+			m_pExpr->IntEvalBatch ( dBatch, pValues );
+		else
+			m_pExpr->Int64EvalBatch ( dBatch, pValues );
+	}
 };
 
 
@@ -1095,8 +1318,8 @@ template < bool HAS_EQUAL_MIN, bool HAS_EQUAL_MAX >
 class ExprFilterFloatRange_c : public ExprFilter_c<IFilter_Range>
 {
 public:
-	explicit ExprFilterFloatRange_c ( ISphExpr * pExpr )
-		: ExprFilter_c<IFilter_Range> ( pExpr )
+	explicit ExprFilterFloatRange_c ( ISphExpr * pExpr, bool bRowExpr )
+		: ExprFilter_c<IFilter_Range> ( pExpr, bRowExpr )
 	{}
 
 	float m_fMinValue = 0.0f;
@@ -1112,6 +1335,15 @@ public:
 	{
 		return EvalRange<HAS_EQUAL_MIN, HAS_EQUAL_MAX,false,false,float> ( m_pExpr->Eval ( tMatch ), m_fMinValue, m_fMaxValue );
 	}
+
+	bool CanEvalRows() const final { return m_bRowExpr; }
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		float dValues[FILTER_BLOCK_ROWS];
+		EvalRowValues ( ppRows, iRows, dValues );
+		MakeRowMask ( dValues, iRows, pMask, [fMin = m_fMinValue, fMax = m_fMaxValue] ( float fValue ) { return EvalRange<HAS_EQUAL_MIN,HAS_EQUAL_MAX,false,false,float> ( fValue, fMin, fMax ); } );
+	}
 };
 
 
@@ -1119,22 +1351,31 @@ template < bool HAS_EQUAL_MIN, bool HAS_EQUAL_MAX >
 class ExprFilterRange_c : public ExprFilter_c<IFilter_Range>
 {
 public:
-	explicit ExprFilterRange_c ( ISphExpr * pExpr )
-		: ExprFilter_c<IFilter_Range> ( pExpr )
+	explicit ExprFilterRange_c ( ISphExpr * pExpr, bool bRowExpr )
+		: ExprFilter_c<IFilter_Range> ( pExpr, bRowExpr )
 	{}
 
 	bool Eval ( const CSphMatch & tMatch ) const final
 	{
 		return EvalRange<HAS_EQUAL_MIN, HAS_EQUAL_MAX> ( m_pExpr->Int64Eval(tMatch), m_iMinValue, m_iMaxValue );
 	}
+
+	bool CanEvalRows() const final { return m_bRowExpr; }
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		int64_t dValues[FILTER_BLOCK_ROWS];
+		EvalRowValues ( ppRows, iRows, dValues );
+		MakeRowMask ( dValues, iRows, pMask, [tMin = m_iMinValue, tMax = m_iMaxValue] ( int64_t iValue ) { return EvalRange<HAS_EQUAL_MIN,HAS_EQUAL_MAX> ( iValue, tMin, tMax ); } );
+	}
 };
 
 
 class ExprFilterValues_c : public ExprFilter_c<IFilter_Values>
 {
 public:
-	explicit ExprFilterValues_c ( ISphExpr * pExpr )
-		: ExprFilter_c<IFilter_Values> ( pExpr )
+	explicit ExprFilterValues_c ( ISphExpr * pExpr, bool bRowExpr )
+		: ExprFilter_c<IFilter_Values> ( pExpr, bRowExpr )
 	{}
 
 	bool Eval ( const CSphMatch & tMatch ) const final
@@ -1142,6 +1383,15 @@ public:
 		assert ( this->m_pExpr );
 		return EvalValues ( m_pExpr->Int64Eval ( tMatch ) );
 	}
+
+	bool CanEvalRows() const final { return m_bRowExpr; }
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		int64_t dValues[FILTER_BLOCK_ROWS];
+		EvalRowValues ( ppRows, iRows, dValues );
+		MakeRowMask ( dValues, iRows, pMask, [this] ( int64_t iValue ) { return EvalValues(iValue); } );
+	}
 };
 
 
@@ -1270,8 +1520,8 @@ protected:
 	ESphAttr m_eAttrType = SPH_ATTR_NONE;
 
 public:
-	ExprFilterProxy_c ( ISphExpr * pExpr, ESphAttr eAttrType )
-		: ExprFilter_c<ISphFilter> ( pExpr )
+	ExprFilterProxy_c ( ISphExpr * pExpr, ESphAttr eAttrType, bool bRowExpr = false )
+		: ExprFilter_c<ISphFilter> ( pExpr, bRowExpr )
 		, m_eAttrType ( eAttrType )
 	{}
 
@@ -1294,6 +1544,38 @@ public:
 				return ( m_pExpr->Eval ( tMatch )>0.0f );
 		}
 	}
+
+	bool CanEvalRows() const final { return m_bRowExpr; }
+
+	void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const final
+	{
+		switch ( m_eAttrType )
+		{
+			case SPH_ATTR_INTEGER:
+			case SPH_ATTR_INT64SET:
+			case SPH_ATTR_UINT32SET:
+				EvalRowsPositive<int> ( ppRows, iRows, pMask );
+				break;
+
+			case SPH_ATTR_BIGINT:
+			case SPH_ATTR_JSON_FIELD:
+				EvalRowsPositive<int64_t> ( ppRows, iRows, pMask );
+				break;
+
+			default:
+				EvalRowsPositive<float> ( ppRows, iRows, pMask );
+				break;
+		}
+	}
+
+private:
+	template<typename T>
+	void EvalRowsPositive ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const
+	{
+		T dValues[FILTER_BLOCK_ROWS];
+		EvalRowValues ( ppRows, iRows, dValues );
+		MakeRowMask ( dValues, iRows, pMask, [] ( T tValue ) { return tValue>0; } );
+	}
 };
 
 
@@ -1337,7 +1619,7 @@ static std::unique_ptr<ISphFilter> SetupJsonExpr ( CSphRefcountedPtr<ISphExpr> &
 }
 
 
-static std::unique_ptr<ISphFilter> CreateFilterExpr ( ISphExpr * _pExpr, const CSphFilterSettings & tSettings, const CommonFilterSettings_t & tFixedSettings, CSphString & sError, ESphCollation eCollation, ESphAttr eAttrType )
+static std::unique_ptr<ISphFilter> CreateFilterExpr ( ISphExpr * _pExpr, const CSphFilterSettings & tSettings, const CommonFilterSettings_t & tFixedSettings, CSphString & sError, ESphCollation eCollation, ESphAttr eAttrType, bool bRowExpr = false )
 {
 	CSphRefcountedPtr<ISphExpr> pExpr { _pExpr };
 	SafeAddRef ( _pExpr );
@@ -1348,9 +1630,9 @@ static std::unique_ptr<ISphFilter> CreateFilterExpr ( ISphExpr * _pExpr, const C
 
 	switch ( tFixedSettings.m_eType )
 	{
-		case SPH_FILTER_VALUES:			return std::make_unique<ExprFilterValues_c> ( pExpr );
-		case SPH_FILTER_FLOATRANGE:		CREATE_EXPR_RANGE_FILTER ( ExprFilterFloatRange_c, pExpr, tSettings.m_bHasEqualMin, tSettings.m_bHasEqualMax );
-		case SPH_FILTER_RANGE:			CREATE_EXPR_RANGE_FILTER ( ExprFilterRange_c, pExpr, tSettings.m_bHasEqualMin, tSettings.m_bHasEqualMax );
+		case SPH_FILTER_VALUES:			return std::make_unique<ExprFilterValues_c> ( pExpr, bRowExpr );
+		case SPH_FILTER_FLOATRANGE:		CREATE_EXPR_RANGE_FILTER ( ExprFilterFloatRange_c, tSettings.m_bHasEqualMin, tSettings.m_bHasEqualMax, pExpr, bRowExpr );
+		case SPH_FILTER_RANGE:			CREATE_EXPR_RANGE_FILTER ( ExprFilterRange_c, tSettings.m_bHasEqualMin, tSettings.m_bHasEqualMax, pExpr, bRowExpr );
 		case SPH_FILTER_STRING:			return std::make_unique<ExprFilterString_c> ( pExpr, eCollation, tSettings.m_bHasEqualMin || tSettings.m_bHasEqualMax );
 		case SPH_FILTER_STRING_LIST:	return std::make_unique<ExprFilterStringValues_c> ( pExpr, eCollation, tSettings.m_bHasEqualMin || tSettings.m_bHasEqualMax );
 		case SPH_FILTER_NULL:			return std::make_unique<ExprFilterNull_c> ( pExpr, tSettings.m_bIsNull, false );
@@ -1363,7 +1645,7 @@ static std::unique_ptr<ISphFilter> CreateFilterExpr ( ISphExpr * _pExpr, const C
 				return nullptr;
 			} else
 			{
-				return std::make_unique<ExprFilterProxy_c> ( pExpr, eAttrType );
+				return std::make_unique<ExprFilterProxy_c> ( pExpr, eAttrType, bRowExpr );
 			}
 		}
 		default:
@@ -1373,6 +1655,27 @@ static std::unique_ptr<ISphFilter> CreateFilterExpr ( ISphExpr * _pExpr, const C
 }
 
 
+// an expression that reads only static row attrs can be evaluated over bare rows (see ISphFilter::EvalRows)
+static bool IsRowOnlyExpr ( ISphExpr * pExpr, const ISphSchema & tSchema )
+{
+	if ( pExpr->IsColumnar() || pExpr->UsesDocstore() )
+		return false;
+
+	StrVec_t dCols;
+	pExpr->Command ( SPH_EXPR_GET_DEPENDENT_COLS, &dCols );
+
+	// no attrs at all might mean that it depends on rowids (e.g. precalculated KNN distances)
+	if ( dCols.IsEmpty() )
+		return false;
+
+	return dCols.all_of ( [&tSchema]( const CSphString & sCol )
+	{
+		const CSphColumnInfo * pAttr = tSchema.GetAttr ( sCol.cstr() );
+		return pAttr && !pAttr->m_pExpr && !pAttr->IsColumnar() && !pAttr->m_tLocator.m_bDynamic;
+	} );
+}
+
+
 static std::unique_ptr<ISphFilter> TryToCreateExpressionFilter ( CSphRefcountedPtr<ISphExpr> & pExpr, const CSphString & sAttrName, const ISphSchema & tSchema, const CSphFilterSettings & tSettings, const CommonFilterSettings_t & tFixedSettings, ExprParseArgs_t & tExprArgs, CSphString & sError )
 {
 	pExpr = sphExprParse ( sAttrName.cstr(), tSchema, sError, tExprArgs );
@@ -1384,7 +1687,7 @@ static std::unique_ptr<ISphFilter> TryToCreateExpressionFilter ( CSphRefcountedP
 	}
 
 	if ( pExpr )
-		return CreateFilterExpr ( pExpr, tSettings, tFixedSettings, sError, tExprArgs.m_eCollation, *tExprArgs.m_pAttrType );
+		return CreateFilterExpr ( pExpr, tSettings, tFixedSettings, sError, tExprArgs.m_eCollation, *tExprArgs.m_pAttrType, IsRowOnlyExpr ( pExpr, tSchema ) );
 
 	if ( sError.IsEmpty() )
 		sError.SetSprintf ( "no such filter attribute '%s'", sAttrName.cstr() );
@@ -16,6 +16,11 @@
 #include "columnarlib.h"
 #include "sphinx.h"
 
+/// rows per ISphFilter::EvalRows() call (same as the .spa attr block size)
+/// the result of a call is a selection bitmask of FILTER_MASK_WORDS words
+constexpr int FILTER_BLOCK_ROWS = 128;
+constexpr int FILTER_MASK_WORDS = FILTER_BLOCK_ROWS/64;
+
 class ISphFilter : public columnar::BlockTester_i
 {
 public:
@@ -53,6 +58,16 @@ public:
 		return true;
 	}
 
+	/// returns true if the filter only needs plain row attributes and can be evaluated with EvalRows()
+	virtual bool CanEvalRows() const { return false; }
+
+	/// evaluate filter for a block of up to FILTER_BLOCK_ROWS rows; ppRows[i] is the i-th row in plain row storage
+	/// sets bit i of pMask if i-th row satisfies the filter, clears it otherwise; bits past iRows are left zero
+	virtual void EvalRows ( const CSphRowitem * const * ppRows, int iRows, uint64_t * pMask ) const
+	{
+		assert ( 0 && "EvalRows() called for a filter that can't do it" );
+	}
+
 	/// returns true if the filter can handle exclude flag in settings
 	/// otherwise a NOT filter will be spawned on top of this filter
 	virtual bool CanExclude() const { return false; }
@@ -97,6 +112,9 @@ std::unique_ptr<ISphFilter> sphJoinFilters ( std::unique_ptr<ISphFilter>, std::u
 
 bool sphCreateFilters ( CreateFilterContext_t & tCtx, CSphString & sError, CSphString & sWarning );
 
+/// joined filter over the plain (row-wise) attribute filters that can be checked against a block min/max; null if pruning is off or nothing to check
+std::unique_ptr<ISphFilter> CreateMinMaxFilter ( const CSphQuery & tQuery, const ISphSchema & tSchema );
+
 void FormatFilterQL ( const CSphFilterSettings & tFilter, StringBuilder_c & tBuf, int iCompactIN );
 void FormatFiltersQL ( const VecTraits_T<CSphFilterSettings> & dFilters, const VecTraits_T<FilterTreeItem_t> & dFilterTree, StringBuilder_c & tBuf, int iCompactIN=5 );
 void FixupFilterSettings ( const CSphFilterSettings & tSettings, ESphAttr eAttrType, CommonFilterSettings_t & tFixedSettings );
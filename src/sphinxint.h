@@ -35,7 +35,7 @@
 //////////////////////////////////////////////////////////////////////////
 
 const DWORD		INDEX_MAGIC_HEADER			= 0x58485053;		///< my magic 'SPHX' header
-const DWORD		INDEX_FORMAT_VERSION		= 69;				///< hitless dict layout versioning
+const DWORD		INDEX_FORMAT_VERSION		= 71;				///< doclist_format=block
 
 const char		MAGIC_CODE_SENTENCE			= '\x02';				// emitted from tokenizer on sentence boundary
 const char		MAGIC_CODE_PARAGRAPH		= '\x03';				// emitted from stripper (and passed via tokenizer) on paragraph boundary
@@ -115,6 +115,9 @@ enum ExtraData_e
 	EXTRA_SET_BOUNDARIES,
 	EXTRA_SET_ITERATOR,
 	EXTRA_SET_COLUMNAR,
+	EXTRA_SET_WEIGHT_FLOOR,
+	EXTRA_GET_PRUNED_DOCS,
+	EXTRA_GET_PRUNED_BLOCKS,
 };
 
 /// generic COM-like interface
@@ -861,6 +864,25 @@ void operator<< ( JsonEscapedBuilder& tOut, const CSphSchema& tSchema );
 
 void			RebalanceWeights ( const CSphFixedVector<int64_t> & dTimers, CSphFixedVector<float>& pWeights );
 
+/// sorts raw hit blocks before they are flushed to the temporary hits file
+/// with several threads, the block is partitioned in place into runs of disjoint key ranges, which are sorted concurrently
+class HitBlockSorter_c
+{
+public:
+	static const int MIN_PARALLEL_HITS = 65536;	///< smaller runs are not worth a thread
+
+	explicit		HitBlockSorter_c ( int iThreads );
+					~HitBlockSorter_c();
+
+	void			Sort ( CSphWordHit * pHits, int iHits );
+
+private:
+	class Workers_c;
+
+	int							m_iThreads;
+	std::unique_ptr<Workers_c>	m_pWorkers;
+};
+
 // FIXME!!! remove with converter
 const char * CheckFmtMagic ( DWORD uHeader );
 bool WriteKillList ( const CSphString & sFilename, const DocID_t * pKlist, int nEntries, const KillListTargets_c & tTargets, CSphString & sError );
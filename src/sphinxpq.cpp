@@ -125,6 +125,8 @@ public:
 	void				ProhibitSave() final;
 	void				EnableSave() final;
 	void				LockFileState ( CSphVector<CSphString> & dFiles ) final;
+	void				ReleaseTableLock() final;
+	bool				RetakeTableLock ( CSphString & sError ) final;
 
 	const CSphSchema &GetMatchSchema () const override { return m_tMatchSchema; }
 	virtual uint64_t GetSchemaHash () const final { return 0; }
@@ -3087,6 +3089,20 @@ void PercolateIndex_c::LockFileState ( StrVec_t & dFiles )
 	GetIndexFiles ( dFiles, dFiles );
 }
 
+void PercolateIndex_c::ReleaseTableLock()
+{
+	assert ( IsSaveDisabled() );
+	SafeClose ( m_iLockFD );
+}
+
+bool PercolateIndex_c::RetakeTableLock ( CSphString & sError )
+{
+	if ( m_iLockFD>=0 )
+		return true;
+
+	return RawFileLock ( GetFilename ( "lock" ), m_iLockFD, sError );
+}
+
 
 PercolateQueryArgs_t::PercolateQueryArgs_t ( const VecTraits_T<CSphFilterSettings> & dFilters, const VecTraits_T<FilterTreeItem_t> & dFilterTree )
 	: m_dFilters ( dFilters )
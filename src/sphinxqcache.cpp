@@ -13,6 +13,7 @@
 #include "sphinxqcache.h"
 #include "exprtraits.h"
 #include "mini_timer.h"
+#include "hazard_pointer.h"
 
 //////////////////////////////////////////////////////////////////////////
 // QUERY CACHE
@@ -26,31 +27,82 @@
 #define QCACHE_NO_ENTRY			(NULL)
 #define QCACHE_DEAD_ENTRY		((QcacheEntry_c*)-1)
 
+/// one shard of the query cache
+/// lookups are lock-free (table and entries are protected by hazard pointers), modifications are serialized by shard lock
+/// eviction is CLOCK: a hit marks an entry as recent, and the clock hand gives recent entries a second chance
+class QcacheShard_c
+{
+public:
+								QcacheShard_c();
+								~QcacheShard_c();
+
+	template<typename FILTER_MATCH>
+	QcacheEntry_c *				Find ( uint64_t uKey, int64_t tmMin, FILTER_MATCH && fnFiltersMatch );
+	int64_t						Add ( QcacheEntry_c * pEntry, int64_t tmMin ) EXCLUDES ( m_tLock );
+	int64_t						EvictOne ( int64_t tmMin ) EXCLUDES ( m_tLock );
+
+	template<typename PRED>
+	void						DeleteIf ( PRED && fnPred ) EXCLUDES ( m_tLock );
+
+	void						GetStatus ( QcacheShardStatus_t & tStatus ) const;
+
+private:
+	using Slot_t = std::atomic<QcacheEntry_c*>;
+	struct Table_t
+	{
+		CSphFixedVector<Slot_t>	m_dSlots { 0 };
+		int						m_iUsedSlots = 0;	///< alive and dead entries; dead ones are only dropped on rehash
+
+		explicit Table_t ( int iSize );
+		int						Mask() const { return m_dSlots.GetLength()-1; }
+	};
+
+	static const int			INITIAL_SLOTS = 64;
+
+	CSphMutex					m_tLock;
+	std::atomic<Table_t*>		m_pTable;
+	int							m_iClockHand GUARDED_BY ( m_tLock ) = 0;
+
+	std::atomic<int>			m_iCachedQueries {0};
+	std::atomic<int64_t>		m_iUsedBytes {0};
+	std::atomic<int64_t>		m_iHits {0};
+	std::atomic<int64_t>		m_iMisses {0};
+	std::atomic<int64_t>		m_iEvictions {0};
+
+	static bool					IsValidEntry ( const QcacheEntry_c * pEntry ) { return pEntry!=QCACHE_NO_ENTRY && pEntry!=QCACHE_DEAD_ENTRY; }
+	void						Rehash() REQUIRES ( m_tLock );
+	void						DeleteEntry ( Table_t & tTable, int iSlot ) REQUIRES ( m_tLock );
+};
+
 /// query cache
-class Qcache_c : public QcacheStatus_t
+class Qcache_c
 {
 private:
-	CSphMutex					m_tLock;			///< hash lock
-	CSphVector<QcacheEntry_c*>	m_hData;			///< our little queries hash
-	int							m_iMaxQueries;		///< max load
-	int							m_iMruHead;			///< most recently used entry
+	QcacheShard_c				m_dShards[QCACHE_SHARDS];
+	std::atomic<int64_t>		m_iMaxBytes;		///< max RAM bytes
+	std::atomic<int>			m_iThreshMs;		///< minimum wall time to cache, in msec
+	std::atomic<int>			m_iTtlS;			///< cached query TTL, in sec
+	std::atomic<int64_t>		m_iUsedBytes {0};	///< sum over shards; checked on every add
+	std::atomic<int>			m_iEvictShard {0};	///< round-robin shard to evict from
 
 public:
 								Qcache_c();
-								~Qcache_c();
 
 	void						Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec );
 	void						Add ( const CSphQuery & q, QcacheEntry_c * pResult, const ISphSchema & tSorterSchema );
 	QcacheEntry_c *				Find ( int64_t iIndexId, const CSphQuery & q, const ISphSchema & tSorterSchema );
-	void						ClearByIndexId ( int64_t iIndexId ) EXCLUDES ( m_tLock );
-	void						ClearAll() EXCLUDES ( m_tLock );
+	void						ClearByIndexId ( int64_t iIndexId );
+	void						ClearAll();
+	QcacheStatus_t				GetStatus() const;
+	int64_t						GetMaxBytes() const { return m_iMaxBytes.load ( std::memory_order_relaxed ); }
 
 private:
 	static uint64_t				GetKey ( int64_t iIndexId, const CSphQuery & q );
-	bool						IsValidEntry ( int i ) { return m_hData[i]!=QCACHE_NO_ENTRY && m_hData[i]!=QCACHE_DEAD_ENTRY; }
-	void						EnforceLimits ( bool bSizeOnly ) EXCLUDES ( m_tLock );
-	void						MruToHead ( int iRes );
-	void						DeleteEntry ( int iEntry );
+	static int					GetShard ( uint64_t uKey ) { return (int)( ( uKey>>32 ) % QCACHE_SHARDS ); }
+	int64_t						GetMinStartTime() const { return sphMicroTimer() - int64_t ( m_iTtlS.load ( std::memory_order_relaxed ) )*1000000; }
+	void						EnforceLimits ( bool bSizeOnly );
+	template<typename PRED>
+	void						ClearIf ( PRED && fnPred );
 	bool						CanCacheQuery ( const CSphQuery & q ) const;
 };
 
@@ -249,67 +301,239 @@ void QcacheEntry_c::Finish()
 
 //////////////////////////////////////////////////////////////////////////
 
-Qcache_c::Qcache_c()
+static void ReleaseQcacheEntry ( void * pEntry )
 {
-	// defaults are here
-	m_iMaxBytes = 16777216;
-#ifndef NDEBUG
-	m_iMaxBytes = 0; // disable qcache in debug builds
-#endif
+	( (QcacheEntry_c *)pEntry )->Release();
+}
+
+
+QcacheShard_c::Table_t::Table_t ( int iSize )
+{
+	assert ( !( iSize & ( iSize-1 ) ) );
+	m_dSlots.Reset(iSize);
+	for ( auto & tSlot : m_dSlots )
+		tSlot.store ( QCACHE_NO_ENTRY, std::memory_order_relaxed );
+}
 
-	m_iThreshMs = 3000;
-	m_iTtlS = 60;
 
-	m_iCachedQueries = 0;
-	m_iUsedBytes = 0;
-	m_iHits = 0;
-	m_iMruHead = -1;
+QcacheShard_c::QcacheShard_c()
+	: m_pTable { new Table_t ( INITIAL_SLOTS ) }
+{}
+
+
+QcacheShard_c::~QcacheShard_c()
+{
+	// nobody else can access the cache at this point, so no hazards here
+	Table_t * pTable = m_pTable.load ( std::memory_order_relaxed );
+	for ( auto & tSlot : pTable->m_dSlots )
+	{
+		QcacheEntry_c * pEntry = tSlot.load ( std::memory_order_relaxed );
+		if ( IsValidEntry(pEntry) )
+			pEntry->Release();
+	}
 
-	m_hData.Resize ( 256 );
-	m_hData.Fill ( QCACHE_NO_ENTRY );
-	m_iMaxQueries = (int)( m_hData.GetLength()*0.7f );
+	SafeDelete(pTable);
 }
 
-Qcache_c::~Qcache_c()
+
+template<typename FILTER_MATCH>
+QcacheEntry_c * QcacheShard_c::Find ( uint64_t uKey, int64_t tmMin, FILTER_MATCH && fnFiltersMatch )
 {
-	ScopedMutex_t dLock ( m_tLock );
-	ARRAY_FOREACH ( i, m_hData )
-		if ( IsValidEntry(i) )
-			SafeRelease ( m_hData[i] );
+	hazard::Guard_c tTableGuard;
+	hazard::Guard_c tEntryGuard;
+	const Table_t * pTable = tTableGuard.Protect ( m_pTable );
+
+	int iLenMask = pTable->Mask();
+	int iLoop = pTable->m_dSlots.GetLength();
+	for ( int i = uKey & iLenMask; iLoop--!=0; i = ( i+1 ) & iLenMask )
+	{
+		QcacheEntry_c * e = tEntryGuard.Protect ( pTable->m_dSlots[i] );
+		if ( e==QCACHE_NO_ENTRY )
+			break;
+
+		// expired entries are not deleted here (that needs the lock); they are evicted first on the next add
+		if ( e==QCACHE_DEAD_ENTRY || e->m_Key!=uKey || e->m_tmStarted<tmMin )
+			continue;
+
+		if ( !fnFiltersMatch(e) )
+			continue;
+
+		e->m_bRecent.store ( true, std::memory_order_relaxed );
+		e->AddRef();
+		m_iHits.fetch_add ( 1, std::memory_order_relaxed );
+		return e;
+	}
+
+	m_iMisses.fetch_add ( 1, std::memory_order_relaxed );
+	return nullptr;
 }
 
-void Qcache_c::Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
+
+void QcacheShard_c::Rehash()
 {
-	m_iMaxBytes = Max ( iMaxBytes, 0 );
-	m_iThreshMs = Max ( iThreshMsec, 0 );
-	m_iTtlS = Max ( iTtlSec, 1 );
-	EnforceLimits ( false );
+	// alive entries occupy less than a third of the new table; tombstones are dropped
+	Table_t * pOld = m_pTable.load ( std::memory_order_relaxed );
+	int iNewSize = INITIAL_SLOTS;
+	while ( iNewSize < 3*( m_iCachedQueries.load ( std::memory_order_relaxed )+1 ) )
+		iNewSize *= 2;
+
+	auto * pNew = new Table_t ( iNewSize );
+	int iLenMask = pNew->Mask();
+	for ( auto & tSlot : pOld->m_dSlots )
+	{
+		QcacheEntry_c * pEntry = tSlot.load ( std::memory_order_relaxed );
+		if ( !IsValidEntry(pEntry) )
+			continue;
+
+		int j = pEntry->m_Key & iLenMask;
+		while ( pNew->m_dSlots[j].load ( std::memory_order_relaxed )!=QCACHE_NO_ENTRY )
+			j = ( j+1 ) & iLenMask;
+
+		pNew->m_dSlots[j].store ( pEntry, std::memory_order_relaxed );
+		pNew->m_iUsedSlots++;
+	}
+
+	m_pTable.store ( pNew, std::memory_order_release );
+	m_iClockHand = 0;
+
+	// entries moved to the new table might be deleted from it later, while a reader still walks the old one;
+	// so the old table must not hand them out anymore
+	for ( auto & tSlot : pOld->m_dSlots )
+		if ( IsValidEntry ( tSlot.load ( std::memory_order_relaxed ) ) )
+			tSlot.store ( QCACHE_DEAD_ENTRY, std::memory_order_release );
+
+	hazard::Retire(pOld);
 }
 
-void Qcache_c::MruToHead ( int iRes )
+
+void QcacheShard_c::DeleteEntry ( Table_t & tTable, int iSlot )
 {
-	// already the head? nothing to do
-	if ( iRes==m_iMruHead )
-		return;
+	QcacheEntry_c * pEntry = tTable.m_dSlots[iSlot].load ( std::memory_order_relaxed );
+	assert ( IsValidEntry(pEntry) );
+
+	tTable.m_dSlots[iSlot].store ( QCACHE_DEAD_ENTRY, std::memory_order_release );
+	m_iCachedQueries.fetch_sub ( 1, std::memory_order_relaxed );
+	m_iUsedBytes.fetch_sub ( pEntry->GetSize(), std::memory_order_relaxed );
+
+	// concurrent lookup might still be looking at it
+	hazard::Retire ( (hazard::Pointer_t)pEntry, ReleaseQcacheEntry );
+}
+
+
+/// returns bytes freed by dropping an expired entry, if its slot was reused
+int64_t QcacheShard_c::Add ( QcacheEntry_c * pEntry, int64_t tmMin )
+{
+	ScopedMutex_t dLock ( m_tLock );
+
+	Table_t * pTable = m_pTable.load ( std::memory_order_relaxed );
+	if ( pTable->m_iUsedSlots+1 > pTable->m_dSlots.GetLength()*7/10 )
+	{
+		Rehash();
+		pTable = m_pTable.load ( std::memory_order_relaxed );
+	}
+
+	// add entry into the first free, dead or expired slot
+	int64_t iFreed = 0;
+	int iLenMask = pTable->Mask();
+	int j = pEntry->m_Key & iLenMask;
+	while (true)
+	{
+		QcacheEntry_c * pCur = pTable->m_dSlots[j].load ( std::memory_order_relaxed );
+		if ( IsValidEntry(pCur) && pCur->m_tmStarted<tmMin )
+		{
+			iFreed += pCur->GetSize();
+			DeleteEntry ( *pTable, j );
+		} else if ( IsValidEntry(pCur) )
+		{
+			j = ( j+1 ) & iLenMask;
+			continue;
+		}
+
+		if ( pCur==QCACHE_NO_ENTRY )
+			pTable->m_iUsedSlots++;
+		break;
+	}
+
+	pTable->m_dSlots[j].store ( pEntry, std::memory_order_release );
+	m_iCachedQueries.fetch_add ( 1, std::memory_order_relaxed );
+	m_iUsedBytes.fetch_add ( pEntry->GetSize(), std::memory_order_relaxed );
+	return iFreed;
+}
+
+
+int64_t QcacheShard_c::EvictOne ( int64_t tmMin )
+{
+	ScopedMutex_t dLock ( m_tLock );
+
+	Table_t * pTable = m_pTable.load ( std::memory_order_relaxed );
+	int iLenMask = pTable->Mask();
+
+	// two full turns are enough to find a victim: the first one clears all the 'recent' marks
+	for ( int iStep = 0; iStep < 2*pTable->m_dSlots.GetLength(); ++iStep )
+	{
+		int i = m_iClockHand;
+		m_iClockHand = ( m_iClockHand+1 ) & iLenMask;
 
-	// detach from previous node, prev.next = my.next
-	QcacheEntry_c * p = m_hData[iRes];
-	if ( p->m_iMruPrev>=0 )
-		m_hData [ p->m_iMruPrev ]->m_iMruNext = p->m_iMruNext;
+		QcacheEntry_c * pEntry = pTable->m_dSlots[i].load ( std::memory_order_relaxed );
+		if ( !IsValidEntry(pEntry) )
+			continue;
+
+		if ( pEntry->m_tmStarted>=tmMin && pEntry->m_bRecent.exchange ( false, std::memory_order_relaxed ) )
+			continue;
 
-	// detach from next node, next.prev = my.prev
-	if ( p->m_iMruNext>=0 )
-		m_hData [ p->m_iMruNext ]->m_iMruPrev = p->m_iMruPrev;
+		int64_t iSize = pEntry->GetSize();
+		DeleteEntry ( *pTable, i );
+		m_iEvictions.fetch_add ( 1, std::memory_order_relaxed );
+		return iSize;
+	}
+
+	return 0;
+}
 
-	// become the new head
-	p->m_iMruPrev = -1;
-	p->m_iMruNext = m_iMruHead;
-	if ( p->m_iMruNext>=0 )
+
+template<typename PRED>
+void QcacheShard_c::DeleteIf ( PRED && fnPred )
+{
+	ScopedMutex_t dLock ( m_tLock );
+	Table_t * pTable = m_pTable.load ( std::memory_order_relaxed );
+	ARRAY_FOREACH ( i, pTable->m_dSlots )
 	{
-		assert ( m_hData [ p->m_iMruNext ]->m_iMruPrev<0 );
-		m_hData [ p->m_iMruNext ]->m_iMruPrev = iRes;
+		QcacheEntry_c * pEntry = pTable->m_dSlots[i].load ( std::memory_order_relaxed );
+		if ( IsValidEntry(pEntry) && fnPred(pEntry) )
+			DeleteEntry ( *pTable, i );
 	}
-	m_iMruHead = iRes;
+}
+
+
+void QcacheShard_c::GetStatus ( QcacheShardStatus_t & tStatus ) const
+{
+	tStatus.m_iCachedQueries = m_iCachedQueries.load ( std::memory_order_relaxed );
+	tStatus.m_iUsedBytes = m_iUsedBytes.load ( std::memory_order_relaxed );
+	tStatus.m_iHits = m_iHits.load ( std::memory_order_relaxed );
+	tStatus.m_iMisses = m_iMisses.load ( std::memory_order_relaxed );
+	tStatus.m_iEvictions = m_iEvictions.load ( std::memory_order_relaxed );
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+Qcache_c::Qcache_c()
+{
+	// defaults are here
+	m_iMaxBytes = 16777216;
+#ifndef NDEBUG
+	m_iMaxBytes = 0; // disable qcache in debug builds
+#endif
+
+	m_iThreshMs = 3000;
+	m_iTtlS = 60;
+}
+
+void Qcache_c::Setup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
+{
+	m_iMaxBytes = Max ( iMaxBytes, 0 );
+	m_iThreshMs = Max ( iThreshMsec, 0 );
+	m_iTtlS = Max ( iTtlSec, 1 );
+	EnforceLimits ( false );
 }
 
 
@@ -366,56 +590,9 @@ void Qcache_c::Add ( const CSphQuery & q, QcacheEntry_c * pResult, const ISphSch
 	pResult->AddRef();
 	pResult->m_Key = GetKey ( pResult->m_iIndexId, q );
 
-	ScopedMutex_t dLock (m_tLock);
-
-	// rehash if needed
-	if ( m_iCachedQueries>=m_iMaxQueries )
-	{
-		CSphVector<QcacheEntry_c*> hNew ( 2*m_hData.GetLength() );
-		hNew.Fill ( QCACHE_NO_ENTRY );
-
-		CSphVector<int> dRemap ( m_hData.GetLength() );
-		dRemap.Fill ( -1 );
-
-		int iLenMask = hNew.GetLength() - 1;
-		ARRAY_FOREACH ( i, m_hData )
-			if ( IsValidEntry(i) )
-		{
-			int j = m_hData[i]->m_Key & iLenMask;
-			while ( hNew[j]!=NULL )
-				j = ( j+1 ) & iLenMask;
-			hNew[j] = m_hData[i];
-			dRemap[i] = j;
-		}
-
-		ARRAY_FOREACH ( i, m_hData )
-			if ( IsValidEntry(i) )
-		{
-			QcacheEntry_c * p = hNew [ dRemap[i] ];
-			if ( p->m_iMruNext>=0 )
-				p->m_iMruNext = dRemap [ p->m_iMruNext ];
-			if ( p->m_iMruPrev>=0 )
-				p->m_iMruPrev = dRemap [ p->m_iMruPrev ];
-		}
-
-		m_hData.SwapData ( hNew );
-		m_iMruHead = dRemap [ m_iMruHead ];
-
-		m_iMaxQueries *= 2;
-	}
-
-	// add entry
-	int iLenMask = m_hData.GetLength() - 1;
-	int j = pResult->m_Key & iLenMask;
-	while ( IsValidEntry(j) )
-		j = ( j+1 ) & iLenMask;
-	m_hData[j] = pResult;
-
-	m_iCachedQueries++;
-	m_iUsedBytes += pResult->GetSize();
-	MruToHead(j);
+	int64_t iFreed = m_dShards[GetShard ( pResult->m_Key )].Add ( pResult, GetMinStartTime() );
+	m_iUsedBytes.fetch_add ( pResult->GetSize()-iFreed, std::memory_order_relaxed );
 
-	dLock.Unlock();
 	EnforceLimits ( true );
 }
 
@@ -430,64 +607,26 @@ QcacheEntry_c * Qcache_c::Find ( int64_t iIndexId, const CSphQuery & q, const IS
 	uint64_t k = GetKey ( iIndexId, q );
 
 	bool bFilterHashesCalculated = false;
+	bool bCanCache = true;
 	CSphVector<uint64_t> dFilters;
-	
-	ScopedMutex_t dLock (m_tLock);
-
-	int64_t tmMin = sphMicroTimer() - int64_t( m_iTtlS)*1000000;
-	int iLenMask = m_hData.GetLength() - 1;
-	int iLoop = m_hData.GetLength();
-	int iRes = -1;
-	for ( int i = k & iLenMask; m_hData[i]!=QCACHE_NO_ENTRY && iLoop--!=0; i = ( i+1 ) & iLenMask )
-	{
-		// check that entry is alive
-		QcacheEntry_c * e = m_hData[i]; // shortcut
-		if ( e==QCACHE_DEAD_ENTRY )
-			continue;
-
-		// check if we need to evict this one based on ttl
-		if ( e->m_tmStarted < tmMin )
-		{
-			DeleteEntry(i);
-			continue;
-		}
 
-		// check that key matches
-		if ( e->m_Key!=k )
-			continue;
-
-		// check that filters are compatible (ie. that entry filters are a subset of query filters)
+	// check that filters are compatible (ie. that entry filters are a subset of query filters)
+	auto fnFiltersMatch = [&] ( const QcacheEntry_c * e )
+	{
 		if ( !bFilterHashesCalculated )
 		{
 			bFilterHashesCalculated = true;
-
-			if ( !CalcFilterHashes ( dFilters, q, tSorterSchema ) )
-				return nullptr;	// this query can't be cached because of the nature of expressions in filters
+			bCanCache = CalcFilterHashes ( dFilters, q, tSorterSchema );
 		}
 
-		int j = 0;
-		for ( ; j < e->m_dFilters.GetLength(); j++ )
-			if ( !dFilters.BinarySearch ( e->m_dFilters[j] ) )
-				break;
+		// this query can't be cached because of the nature of expressions in filters
+		if ( !bCanCache )
+			return false;
 
-		// filters are good, return it
-		if ( j==e->m_dFilters.GetLength() )
-		{
-			iRes = i;
-			m_iHits++;
-			break;
-		}
-	}
-
-	QcacheEntry_c * p = nullptr;
-	if ( iRes>=0 )
-	{
-		p = m_hData[iRes];
-		p->AddRef();
-		MruToHead(iRes);
-	}
+		return e->m_dFilters.all_of ( [&dFilters] ( uint64_t uHash ) { return dFilters.BinarySearch(uHash)!=nullptr; } );
+	};
 
-	return p;
+	return m_dShards[GetShard(k)].Find ( k, GetMinStartTime(), fnFiltersMatch );
 }
 
 uint64_t Qcache_c::GetKey ( int64_t iIndexId, const CSphQuery & q )
@@ -509,30 +648,6 @@ uint64_t Qcache_c::GetKey ( int64_t iIndexId, const CSphQuery & q )
 	return k;
 }
 
-void Qcache_c::DeleteEntry ( int i )
-{
-	assert ( IsValidEntry(i) );
-	QcacheEntry_c * p = m_hData[i];
-
-	// adjust MRU list
-	if ( p->m_iMruNext>=0 )
-		m_hData[p->m_iMruNext]->m_iMruPrev = p->m_iMruPrev;
-
-	assert ( p->m_iMruPrev>=0 || m_iMruHead==i );
-	if ( p->m_iMruPrev>=0 )
-		m_hData[p->m_iMruPrev]->m_iMruNext = p->m_iMruNext;
-	else
-		m_iMruHead = p->m_iMruNext;
-
-	// adjust stats
-	m_iCachedQueries--;
-	m_iUsedBytes -= p->GetSize();
-
-	// release entry
-	p->Release();
-	m_hData[i] = QCACHE_DEAD_ENTRY;
-}
-
 
 bool Qcache_c::CanCacheQuery ( const CSphQuery & q ) const
 {
@@ -541,52 +656,78 @@ bool Qcache_c::CanCacheQuery ( const CSphQuery & q ) const
 
 void Qcache_c::EnforceLimits ( bool bSizeOnly )
 {
-	if ( bSizeOnly && m_iUsedBytes<=m_iMaxBytes )
+	int64_t iMaxBytes = m_iMaxBytes;
+	if ( bSizeOnly && m_iUsedBytes<=iMaxBytes )
 		return;
 
-	ScopedMutex_t dLock ( m_tLock );
+	int64_t tmMin = GetMinStartTime();
 
-	// first, enforce size limits
-	int iCur = m_iMruHead;
-	int64_t iBytes = 0;
-	while ( iCur>=0 && m_iUsedBytes>m_iMaxBytes )
+	// first, enforce size limits; take victims from all the shards in turn
+	int iIdleShards = 0;
+	while ( m_iUsedBytes>iMaxBytes && iIdleShards<QCACHE_SHARDS )
 	{
-		assert ( IsValidEntry(iCur) );
-		int iNext = m_hData[iCur]->m_iMruNext;
-		if ( iBytes + m_hData[iCur]->GetSize() > m_iMaxBytes )
-			DeleteEntry ( iCur );
-		else
-			iBytes += m_hData[iCur]->GetSize();
-		iCur = iNext;
+		int iShard = ( m_iEvictShard.fetch_add ( 1, std::memory_order_relaxed ) & INT_MAX ) % QCACHE_SHARDS;
+		int64_t iFreed = m_dShards[iShard].EvictOne(tmMin);
+		m_iUsedBytes.fetch_sub ( iFreed, std::memory_order_relaxed );
+		iIdleShards = iFreed ? 0 : iIdleShards+1;
 	}
 
 	if ( bSizeOnly )
 		return;
 
 	// if requested, do a full sweep, and recheck ttl and thresh limits
-	int64_t tmMin = sphMicroTimer() - int64_t( m_iTtlS)*1000000;
-	ARRAY_FOREACH ( i, m_hData )
-		if ( IsValidEntry(i) && ( m_hData[i]->m_tmStarted < tmMin || m_hData[i]->m_iElapsedMsec < m_iThreshMs ) )
-			DeleteEntry(i);
+	int iThreshMs = m_iThreshMs;
+	ClearIf ( [tmMin, iThreshMs] ( const QcacheEntry_c * e ) { return e->m_tmStarted < tmMin || e->m_iElapsedMsec < iThreshMs; } );
+}
+
+template<typename PRED>
+void Qcache_c::ClearIf ( PRED && fnPred )
+{
+	for ( auto & tShard : m_dShards )
+		tShard.DeleteIf ( [this, &fnPred] ( const QcacheEntry_c * e )
+		{
+			if ( !fnPred(e) )
+				return false;
 
+			m_iUsedBytes.fetch_sub ( e->GetSize(), std::memory_order_relaxed );
+			return true;
+		});
 }
 
 void Qcache_c::ClearByIndexId ( int64_t iIndexId )
 {
-	ScopedMutex_t dLock ( m_tLock );
-	ARRAY_FOREACH ( i, m_hData )
-		if ( IsValidEntry(i) && m_hData[i]->m_iIndexId==iIndexId )
-			DeleteEntry(i);
+	ClearIf ( [iIndexId] ( const QcacheEntry_c * e ) { return e->m_iIndexId==iIndexId; } );
 }
 
 void Qcache_c::ClearAll()
 {
-	ScopedMutex_t dLock ( m_tLock );
-	ARRAY_FOREACH ( i, m_hData )
-		if ( IsValidEntry(i) )
-			DeleteEntry(i);
+	ClearIf ( [] ( const QcacheEntry_c * ) { return true; } );
+}
 
-	m_iMruHead = -1;
+QcacheStatus_t Qcache_c::GetStatus() const
+{
+	QcacheStatus_t tStatus;
+	tStatus.m_iMaxBytes = m_iMaxBytes;
+	tStatus.m_iThreshMs = m_iThreshMs;
+	tStatus.m_iTtlS = m_iTtlS;
+	tStatus.m_iCachedQueries = 0;
+	tStatus.m_iUsedBytes = 0;
+	tStatus.m_iHits = 0;
+	tStatus.m_iMisses = 0;
+	tStatus.m_iEvictions = 0;
+
+	for ( int i = 0; i < QCACHE_SHARDS; ++i )
+	{
+		auto & tShard = tStatus.m_dShards[i];
+		m_dShards[i].GetStatus(tShard);
+		tStatus.m_iCachedQueries += tShard.m_iCachedQueries;
+		tStatus.m_iUsedBytes += tShard.m_iUsedBytes;
+		tStatus.m_iHits += tShard.m_iHits;
+		tStatus.m_iMisses += tShard.m_iMisses;
+		tStatus.m_iEvictions += tShard.m_iEvictions;
+	}
+
+	return tStatus;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -696,9 +837,14 @@ std::unique_ptr<ISphRanker> QcacheRanker ( QcacheEntry_c * pEntry, const ISphQwo
 	return std::make_unique<QcacheRanker_c> ( pEntry, tSetup );
 }
 
-const QcacheStatus_t & QcacheGetStatus()
+QcacheStatus_t QcacheGetStatus()
+{
+	return g_Qcache.GetStatus();
+}
+
+int64_t QcacheGetMaxBytes()
 {
-	return g_Qcache;
+	return g_Qcache.GetMaxBytes();
 }
 
 void QcacheSetup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec )
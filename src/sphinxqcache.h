@@ -36,8 +36,7 @@ public:
 	int							m_iElapsedMsec = 0;
 	CSphVector<uint64_t>		m_dFilters;			///< hashes of the filters that were applied to cached query
 	uint64_t					m_Key = 0;
-	int							m_iMruPrev = -1;
-	int							m_iMruNext = -1;
+	std::atomic<bool>			m_bRecent { false };	///< CLOCK reference bit; set on every hit
 
 private:
 	static const int			MAX_FRAME_SIZE = 32;
@@ -65,6 +64,18 @@ private:
 
 using QcacheEntryRefPtr_t = CSphRefcountedPtr<QcacheEntry_c>;
 
+static const int QCACHE_SHARDS = 16;
+
+/// per-shard query cache statistics
+struct QcacheShardStatus_t
+{
+	int			m_iCachedQueries = 0;
+	int64_t		m_iUsedBytes = 0;
+	int64_t		m_iHits = 0;
+	int64_t		m_iMisses = 0;
+	int64_t		m_iEvictions = 0;
+};
+
 /// query cache status
 struct QcacheStatus_t
 {
@@ -77,13 +88,18 @@ struct QcacheStatus_t
 	int			m_iCachedQueries;	///< cached queries counts
 	int64_t		m_iUsedBytes;		///< used RAM bytes
 	int64_t		m_iHits;			///< cache hits
+	int64_t		m_iMisses;			///< cache misses
+	int64_t		m_iEvictions;		///< entries evicted to fit into max RAM
+
+	QcacheShardStatus_t	m_dShards[QCACHE_SHARDS];
 };
 
 
 void					QcacheAdd ( const CSphQuery & q, QcacheEntry_c * pResult, const ISphSchema & tSorterSchema );
 QcacheEntry_c *			QcacheFind ( int64_t iIndexId, const CSphQuery & q, const ISphSchema & tSorterSchema );
 std::unique_ptr<ISphRanker>			QcacheRanker ( QcacheEntry_c * pEntry, const ISphQwordSetup & tSetup );
-const QcacheStatus_t &	QcacheGetStatus();
+QcacheStatus_t			QcacheGetStatus();
+int64_t					QcacheGetMaxBytes();
 void					QcacheSetup ( int64_t iMaxBytes, int iThreshMsec, int iTtlSec );
 void					QcacheClearByIndexId ( int64_t iIndexId );
 void					QcacheClearAll();
@@ -14,6 +14,7 @@
 #include "sphinxrt.h"
 #include "sphinxpq.h"
 #include "sphinxsearch.h"
+#include "searchnode.h"
 #include "sphinxsort.h"
 #include "sphinxutils.h"
 #include "sphinxquery/sphinxquery.h"
@@ -187,6 +188,25 @@ void SetRtFlushDiskPeriod ( int iFlushWrite, int iFlushSearch )
 	g_iFlushSearchUs = 1'000'000LL * iFlushSearch;
 }
 
+static RtMergePolicy_e g_eRtMergePolicy = RtMergePolicy_e::PROGRESSION;
+
+void SetRtMergePolicy ( RtMergePolicy_e ePolicy )
+{
+	g_eRtMergePolicy = ePolicy;
+}
+
+bool ParseRtMergePolicy ( const CSphString & sPolicy, RtMergePolicy_e & ePolicy )
+{
+	if ( sPolicy=="progression" )
+		ePolicy = RtMergePolicy_e::PROGRESSION;
+	else if ( sPolicy=="tiered" )
+		ePolicy = RtMergePolicy_e::TIERED;
+	else
+		return false;
+
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 // Variable Length Byte (VLB) encoding
@@ -495,6 +515,36 @@ void RtSegment_t::BuildDocID2RowIDMap ( const CSphSchema & tSchema )
 	}
 }
 
+
+void RtSegment_t::BuildMinMax ( const ISphSchema & tSchema )
+{
+	FakeWL_t _ {m_tLock}; // no need true lock as the func is in game during build/merge/load when segment is not yet published
+	m_dMinMax.Reset();
+
+	int iStride = GetStride();
+	if ( !m_uRows || !iStride )
+		return;
+
+	AttrIndexBuilder_c tBuilder ( tSchema );
+	for ( int64_t i = 0; i<m_dRows.GetLength64(); i+=iStride )
+		tBuilder.Collect ( &m_dRows[i] );
+
+	tBuilder.FinishCollect();
+
+	// killed rows are accounted too, so it is a superset of the alive values; only the segment-wide entry (the last one) is kept
+	const auto & dCollected = tBuilder.GetCollected();
+	m_dMinMax.Append ( dCollected.Slice ( dCollected.GetLength64()-iStride*2 ) );
+}
+
+
+bool RtSegment_t::IsRejectedByMinMax ( const ISphFilter & tFilter ) const
+{
+	if ( m_dMinMax.IsEmpty() )
+		return false;
+
+	return !tFilter.EvalBlock ( m_dMinMax.Begin(), m_dMinMax.Begin()+GetStride() );
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 class RtDocWriter_c
@@ -1495,6 +1545,8 @@ public:
 	void				ProhibitSave() final;
 	void				EnableSave() final;
 	void				LockFileState ( CSphVector<CSphString> & dFiles ) final;
+	void				ReleaseTableLock() final;
+	bool				RetakeTableLock ( CSphString & sError ) final;
 
 	void				WaitLockEnabledState () noexcept final;
 	void				UnlockEnabledState () noexcept final;
@@ -1532,6 +1584,13 @@ private:
 
 	int64_t						m_iRtMemLimit;
 	int64_t						m_iSoftRamLimit;
+
+	// RAM segments merge stats (write amplification is (ingested+merged)/ingested)
+	std::atomic<int64_t>		m_iSegBytesIngested { 0 };	// bytes of new segments coming from commits
+	std::atomic<int64_t>		m_iSegBytesMerged { 0 };	// bytes written by segment merges
+	std::atomic<int64_t>		m_iSegMerges { 0 };
+	std::atomic<int64_t>		m_iSegMergeTimeUs { 0 };
+	std::atomic<int64_t>		m_iSegMergesDeferred { 0 };	// merges postponed because of busy search pool
 	double						m_fSaveRateLimit { INITIAL_SAVE_RATE_LIMIT };
 	bool						m_bPathStripped = false;
 	int							m_iLockFD = -1;
@@ -1546,6 +1605,7 @@ private:
 	Coro::Waitable_T<int>		m_tNSavesNow { 0 };			// N of merge segment routines running right now
 	CSphVector<int>				m_dSavingTickets GUARDED_BY ( m_tWorkers.SerialChunkAccess() );			// segments which are currently in saving to disk chunk(s)
 	mutable MiniTimer_c			m_dSavingTimer;
+	MiniTimer_c					m_dMergeRetryTimer { "rt-merge-retry" };	// re-checks merges deferred because of busy search pool
 
 	Coro::Waitable_T<int>		m_tBackgroundRoutines { 0 };
 
@@ -1739,6 +1799,13 @@ RtIndex_c::RtIndex_c ( CSphString sIndexName, CSphString sPath, CSphSchema tSche
 	}
 
 	m_dSavingTimer.SetHandler ( [this]() { ConditionalDiskChunk(); } );
+	m_dMergeRetryTimer.SetHandler ( [this]() {
+		Coro::Go ( [this]() REQUIRES ( m_tWorkers.SerialChunkAccess() ) {
+			StartRoutine();
+			auto tResetSegMergeWorking = AtScopeExit ( [this] { StopRoutine(); } );
+			StartMergeSegments ( MergeSeg_e::NEWSEG );
+		}, m_tWorkers.SerialChunkAccess() );
+	} );
 }
 
 class OptimizeGuard_c final
@@ -1769,6 +1836,7 @@ RtIndex_c::~RtIndex_c ()
 		TRACE_SCHED ( "rt", "~RtIndex_c" );
 
 		m_dSavingTimer.UnEngage();
+		m_dMergeRetryTimer.UnEngage();
 
 		m_tSaving.SetShutdownFlag();
 		StopMergeSegmentsWorker();
@@ -2471,6 +2539,7 @@ RtSegment_t * CreateSegment ( RtAccum_t* pAcc, int iWordsCheckpoint, ESphHitless
 	}
 
 	pSeg->BuildDocID2RowIDMap ( pAcc->m_pIndex->GetInternalSchema() );
+	pSeg->BuildMinMax ( pAcc->m_pIndex->GetInternalSchema() );
 	pAcc->m_tNextRowID = 0;
 
 	return pSeg;
@@ -2961,6 +3030,7 @@ RtSegment_t* RtIndex_c::MergeTwoSegments ( const RtSegment_t* pA, const RtSegmen
 
 	assert ( pSeg->GetStride() == m_iStride );
 	pSeg->BuildDocID2RowIDMap ( m_tSchema );
+	pSeg->BuildMinMax ( m_tSchema );
 	MergeKeywords ( *pSeg, *pA, *pB, dRowMapA, dRowMapB );
 
 	if ( m_bKeywordDict )
@@ -3079,6 +3149,9 @@ void RtSegment_t::UpdateAttributesOffline ( VecTraits_T<PostponedUpdate_t>& dPos
 		tCtx.m_pBlobPool = m_dBlobs.begin();
 		Update_UpdateAttributes ( tPostUpdate.m_dRowsToUpdate, tCtx, bCritical, sError );
 	}
+
+	// updated values might be out of the collected min/max
+	BuildMinMax ( m_tSchema );
 }
 
 static void CleanupHitDuplicates ( CSphTightVector<CSphWordHit> & dHits )
@@ -3293,6 +3366,71 @@ inline std::pair<int,int> Find2Minimums ( const VecTraits_T<ConstRtSegmentRefPtf
 	return { a, b };
 }
 
+// tiered policy: segments with the same log2(rows)>>TIER_SHIFT (i.e. within 16x of each other) belong to the same tier,
+// and only segments of the same tier are merged. That way a row is rewritten at most 4 times per tier (each merge doubles the size),
+// i.e. write amplification is bounded by log(total/smallest) instead of being proportional to N of segments.
+constexpr int TIER_SHIFT = 2;
+
+static int GetSegmentTier ( const RtSegment_t * pSeg )
+{
+	return sphLog2 ( pSeg->GetMergeFactor() ) >> TIER_SHIFT;
+}
+
+// find 2 smallest segments within the lowest tier having at least 2 of them
+bool FindTieredPair ( std::pair<int, int> & tPair, const VecTraits_T<ConstRtSegmentRefPtf_t> & dSegments ) NO_THREAD_SAFETY_ANALYSIS
+{
+	CSphVector<std::pair<int,int>> dTiers; // tier, segment
+	dTiers.Reserve ( dSegments.GetLength() );
+	ARRAY_CONSTFOREACH ( i, dSegments )
+		dTiers.Add ( { GetSegmentTier ( dSegments[i] ), i } );
+
+	dTiers.Sort ( Lesser ( [&dSegments] ( const auto & a, const auto & b )
+	{
+		if ( a.first!=b.first )
+			return a.first < b.first;
+		return dSegments[a.second]->GetMergeFactor() < dSegments[b.second]->GetMergeFactor();
+	} ) );
+
+	for ( int i = 1; i < dTiers.GetLength(); ++i )
+		if ( dTiers[i].first==dTiers[i-1].first )
+		{
+			tPair = { dTiers[i-1].second, dTiers[i].second };
+			return true;
+		}
+
+	return false;
+}
+
+static std::atomic<int> g_iBusySearchWorkers { 0 };
+
+int GetBusySearchWorkers()
+{
+	return g_iBusySearchWorkers.load ( std::memory_order_relaxed );
+}
+
+ScopedSearchWorker_c::ScopedSearchWorker_c ( bool bCount )
+	: m_bCounted ( bCount )
+{
+	if ( m_bCounted )
+		g_iBusySearchWorkers.fetch_add ( 1, std::memory_order_relaxed );
+}
+
+ScopedSearchWorker_c::~ScopedSearchWorker_c()
+{
+	if ( m_bCounted )
+		g_iBusySearchWorkers.fetch_sub ( 1, std::memory_order_relaxed );
+}
+
+// only searches count here; merges, saves and optimize of other tables are background work as well as this merge
+static bool IsSearchPoolSaturated()
+{
+	auto * pPool = GlobalWorkPool();
+	return pPool && GetBusySearchWorkers()>=pPool->WorkingThreads();
+}
+
+// how soon a merge deferred because of busy search pool is checked again, if no commit triggers it earlier
+static const int64_t DEFERRED_MERGE_RETRY_MS = 100;
+
 enum class CheckMerge_e { MERGE, NOMERGE, FLUSH, FLUSH_EM };
 inline CheckMerge_e CheckSegmentsPair ( std::pair<const RtSegment_t*, const RtSegment_t*> tPair, int64_t iRamLeft=INT64_MAX ) NO_THREAD_SAFETY_ANALYSIS
 {
@@ -3350,16 +3488,32 @@ inline CheckMerge_e CheckWeCanMerge ( std::pair<int, int>& tSmallest, const VecT
 	if ( iSegs < ( MAX_SEGMENTS - MAX_PROGRESSION_SEGMENT ) )
 		return CheckMerge_e::NOMERGE;
 
-	// take 2 smallest segments
 	assert ( iSegs > 1 );
-	tSmallest = Find2Minimums ( dSegments );
+	if ( g_eRtMergePolicy==RtMergePolicy_e::TIERED )
+	{
+		// no pair of the same tier - wait for more segments, unless we've hit the limit
+		if ( !FindTieredPair ( tSmallest, dSegments ) )
+		{
+			if ( iSegs<MAX_SEGMENTS )
+				return CheckMerge_e::NOMERGE;
+
+			tSmallest = Find2Minimums ( dSegments );
+		}
+	} else
+	{
+		// take 2 smallest segments
+		tSmallest = Find2Minimums ( dSegments );
+		ConstRtSegmentRefPtf_t & pA = dSegments[tSmallest.first];
+		ConstRtSegmentRefPtf_t & pB = dSegments[tSmallest.second];
+
+		// exit if progression is kept AND lesser MAX_SEGMENTS limit
+		if ( pB->GetMergeFactor() > pA->GetMergeFactor() * 2 && iSegs<MAX_SEGMENTS )
+			return CheckMerge_e::NOMERGE;
+	}
+
 	ConstRtSegmentRefPtf_t & pA = dSegments[tSmallest.first];
 	ConstRtSegmentRefPtf_t & pB = dSegments[tSmallest.second];
 
-	// exit if progression is kept AND lesser MAX_SEGMENTS limit
-	if ( pB->GetMergeFactor() > pA->GetMergeFactor() * 2 && iSegs<MAX_SEGMENTS )
-		return CheckMerge_e::NOMERGE;
-
 	auto eDecision = CheckSegmentsPair ( {pA, pB}, iSoftRamLeft );
 	switch ( eDecision )
 	{
@@ -3459,6 +3613,15 @@ bool RtIndex_c::MergeSegmentsStep ( MergeSeg_e eVal ) REQUIRES ( m_tWorkers.Seri
 
 	RtSegmentRefPtf_t pMerged { nullptr };
 
+	// merge is not urgent, so let queries have the threads; check again a bit later (or on next commit, whichever comes first)
+	if ( eMergeAction == CheckMerge_e::MERGE && g_eRtMergePolicy==RtMergePolicy_e::TIERED && dSegments.GetLength()<MAX_SEGMENTS && IsSearchPoolSaturated() )
+	{
+		RTLOGV << "Merge deferred due to busy search pool";
+		m_iSegMergesDeferred.fetch_add ( 1, std::memory_order_relaxed );
+		m_dMergeRetryTimer.Engage ( DEFERRED_MERGE_RETRY_MS );
+		eMergeAction = CheckMerge_e::NOMERGE;
+	}
+
 	if ( eMergeAction == CheckMerge_e::MERGE )
 	{
 		assert ( dSegments.GetLength() >= 2 );
@@ -3468,7 +3631,12 @@ bool RtIndex_c::MergeSegmentsStep ( MergeSeg_e eVal ) REQUIRES ( m_tWorkers.Seri
 		iMergeOp = m_tWorkers.GetNextOpTicket();
 		pA->m_iLocked = pB->m_iLocked = iMergeOp; // mark them as retiring.
 
+		int64_t tmMergeStart = sphMicroTimer();
 		pMerged = MergeTwoSegments ( pA, pB );
+		m_iSegMergeTimeUs.fetch_add ( sphMicroTimer() - tmMergeStart, std::memory_order_relaxed );
+		m_iSegMerges.fetch_add ( 1, std::memory_order_relaxed );
+		if ( pMerged )
+			m_iSegBytesMerged.fetch_add ( pMerged->GetUsedRam(), std::memory_order_relaxed );
 
 		if ( pMerged && pMerged->m_tAliveRows.load ( std::memory_order_relaxed ) )
 		{
@@ -3619,6 +3787,7 @@ bool RtIndex_c::CommitReplayable ( RtSegment_t * pNewSeg, const VecTraits_T<DocI
 	// 2. Add new RAM-segment (if any). As we 1-st kill, then add - whole change is *not* atomic, ACID is broken here.
 	if ( pNewSeg )
 	{
+		m_iSegBytesIngested.fetch_add ( pNewSeg->GetUsedRam(), std::memory_order_relaxed );
 		auto tNewState = RtWriter();
 		tNewState.InitRamSegs ( RtWriter_c::copy );
 		tNewState.m_pNewRamSegs->Add ( AdoptSegment ( pNewSeg ) );
@@ -4094,6 +4263,8 @@ bool RtIndex_c::WriteDocs ( SaveDiskDataContext_t & tCtx, CSphWriter & tWriterDi
 	bool bHasMorphology = m_pDict->HasMorphology();
 	int iSkiplistBlockSize = m_tSettings.m_iSkiplistBlockSize;
 	assert ( iSkiplistBlockSize>0 );
+	const bool bBlockDoclist = m_tSettings.m_eDoclistFormat==DoclistFormat_e::BLOCK;
+	DoclistWriter_c tDoclist ( tWriterDocs, m_tSettings.m_eDoclistFormat );
 
 	while (true)
 	{
@@ -4139,23 +4310,29 @@ bool RtIndex_c::WriteDocs ( SaveDiskDataContext_t & tCtx, CSphWriter & tWriterDi
 					t.m_tBaseRowIDPlus1 = tSkiplistRowID+1;
 					t.m_iOffset = tWriterDocs.GetPos();
 					t.m_iBaseHitlistPos = uLastHitpos;
+					t.m_uMaxHits = t.m_uFields = 0;
 				}
 
+				SkiplistEntry_t & tBlock = dSkiplist.Last();
+				tBlock.m_uMaxHits = Max ( tBlock.m_uMaxHits, pDoc->m_uHits );
+				tBlock.m_uFields |= pDoc->m_uDocFields;
+
 				++iDocs;
 				iHits += pDoc->m_uHits;
 				tSkiplistRowID = tRowID;
 
-				tWriterDocs.ZipOffset ( tRowID - std::exchange ( tLastRowID, tRowID ) );
-				tWriterDocs.ZipInt ( pDoc->m_uHits );
+				tDoclist.BeginEntry ( tRowID - std::exchange ( tLastRowID, tRowID ) );
+				tDoclist.ZipInt ( pDoc->m_uHits );
 				if ( pDoc->m_uHits==1 && pWord->m_bHasHitlist )
 				{
-					tWriterDocs.ZipInt ( pDoc->m_uHit & 0x7FFFFFUL );
-					tWriterDocs.ZipInt ( pDoc->m_uHit >> 23 );
+					tDoclist.ZipInt ( pDoc->m_uHit & 0x7FFFFFUL );
+					tDoclist.ZipInt ( pDoc->m_uHit >> 23 );
 				} else
 				{
-					tWriterDocs.ZipInt ( pDoc->m_uDocFields );
-					tWriterDocs.ZipOffset ( tWriterHits.GetPos() - std::exchange ( uLastHitpos, tWriterHits.GetPos() ) );
+					tDoclist.ZipInt ( pDoc->m_uDocFields );
+					tDoclist.ZipOffset ( tWriterHits.GetPos() - std::exchange ( uLastHitpos, tWriterHits.GetPos() ) );
 				}
+				tDoclist.EndEntry();
 
 				// loop hits from current segment
 				if ( pDoc->m_uHits>1 )
@@ -4171,21 +4348,13 @@ bool RtIndex_c::WriteDocs ( SaveDiskDataContext_t & tCtx, CSphWriter & tWriterDi
 
 		// write skiplist
 		int64_t iSkiplistOff = tWriterSkips.GetPos();
-		for ( int i=1; i<dSkiplist.GetLength(); ++i )
-		{
-			const SkiplistEntry_t & tPrev = dSkiplist[i-1];
-			const SkiplistEntry_t & tCur = dSkiplist[i];
-			assert ( tCur.m_tBaseRowIDPlus1 - tPrev.m_tBaseRowIDPlus1>=(DWORD)iSkiplistBlockSize );
-			assert ( tCur.m_iOffset - tPrev.m_iOffset>=4*iSkiplistBlockSize );
-			tWriterSkips.ZipInt ( tCur.m_tBaseRowIDPlus1 - tPrev.m_tBaseRowIDPlus1 - iSkiplistBlockSize );
-			tWriterSkips.ZipOffset ( tCur.m_iOffset - tPrev.m_iOffset - 4*iSkiplistBlockSize );
-			tWriterSkips.ZipOffset ( tCur.m_iBaseHitlistPos - tPrev.m_iBaseHitlistPos );
-		}
+		if ( iDocs>iSkiplistBlockSize )
+			ZipSkiplist ( tWriterSkips, dSkiplist, iDocs, iSkiplistBlockSize, bBlockDoclist );
 
 		// write dict entry if necessary
-		if ( tWriterDocs.GetPos()!=uDocpos )
+		if ( iDocs )
 		{
-			tWriterDocs.ZipInt ( 0 ); // docs over
+			tDoclist.EndList(); // rest of the entries, docs over
 
 			if ( ( iWords%SPH_WORDLIST_CHECKPOINT )==0 )
 			{
@@ -5607,6 +5776,7 @@ bool RtIndex_c::LoadRamChunk ( DWORD uVersion, bool bRebuildInfixes, bool bFixup
 			BuildSegmentInfixes ( pSeg, bHasMorphology, m_bKeywordDict, m_tSettings.m_iMinInfixLen, m_iWordsCheckpoint, ( m_iMaxCodepointLength>1 ), m_tSettings.m_eHitless );
 
 		pSeg->BuildDocID2RowIDMap(m_tSchema);
+		pSeg->BuildMinMax(m_tSchema);
 
 		CheckSegmentConsistency ( pSeg );
 
@@ -7514,7 +7684,7 @@ public:
 
 	bool HasSegments () const							{ return ( m_iSeg==0 || m_dSegments.BitCount()>0 );	}
 	void Process ( CSphMatch * pMatch ) final			{ ProcessMatch ( pMatch ); }
-	void Process ( VecTraits_T<CSphMatch *> & dMatches ) final { dMatches.for_each ( [this]( CSphMatch * pMatch ){ ProcessMatch ( pMatch ); } ); }
+	void Process ( VecTraits_T<CSphMatch *> & dMatches ) final;
 	bool ProcessInRowIdOrder() const final				{ return m_tCtx.m_dCalcFinal.any_of ( []( const ContextCalcItem_t & i ){ return i.m_pExpr && ( i.m_pExpr->IsColumnar() || i.m_pExpr->PrefersRowIdOrder() ); } );	}
 
 private:
@@ -7524,6 +7694,7 @@ private:
 	// count per segments matches
 	// to skip iteration of matches at sorter and pool setup for segment without matches at sorter
 	CSphBitvec					m_dSegments;
+	CSphVector<CSphMatch *>		m_dPending;
 
 	inline void ProcessMatch ( CSphMatch * pMatch )
 	{
@@ -7531,6 +7702,11 @@ private:
 		if ( iMatchSegment==m_iSeg )
 			m_tCtx.CalcFinal ( *pMatch );
 
+		CountSegment ( iMatchSegment );
+	}
+
+	inline void CountSegment ( int iMatchSegment )
+	{
 		// count all used segments at 0 pass
 		if ( m_iSeg==0 && iMatchSegment<m_iSegments )
 			m_dSegments.BitSet ( iMatchSegment );
@@ -7538,6 +7714,24 @@ private:
 };
 
 
+void SphRtFinalMatchCalc_c::Process ( VecTraits_T<CSphMatch *> & dMatches )
+{
+	m_dPending.Resize(0);
+	for ( auto * pMatch : dMatches )
+	{
+		int iMatchSegment = pMatch->m_iTag-1;
+		if ( iMatchSegment==m_iSeg )
+			m_dPending.Add(pMatch);
+
+		CountSegment ( iMatchSegment );
+	}
+
+	// items go one by one over the whole set, so that numeric expressions run in batches
+	for ( const auto & tItem : m_tCtx.m_dCalcFinal )
+		m_tCtx.CalcItemBatch ( m_dPending, tItem );
+}
+
+
 class SorterSchemaTransform_c
 {
 public:
@@ -7701,10 +7895,17 @@ static bool QueryDiskChunks ( const CSphQuery & tQuery, CSphQueryResultMeta & tR
 
 	std::atomic<bool> bInterrupt { false };
 	std::atomic<int> bSucceed { 1 };
+
+	// chunks never share alive docs, so the top-k pruning floor of one applies to all the others
+	std::atomic<int64_t> iTopKFloor {0};
+	std::atomic<int64_t> * pTopKFloor = tArgs.m_pTopKFloor ? tArgs.m_pTopKFloor : &iTopKFloor;
 	auto CheckInterrupt = [&bInterrupt]() { return bInterrupt.load ( std::memory_order_relaxed ); };
 
+	// calling worker runs one of the jobs itself, and it is already counted by whoever started the search
+	auto * pCaller = Coro::CurrentWorker();
 	Coro::ExecuteN ( tClonableCtx.Concurrency ( iJobs ), [&]
 	{
+		ScopedSearchWorker_c tBusy ( Coro::CurrentWorker()!=pCaller );
 		auto pSource = pDispatcher->MakeSource();
 		int iJob = -1; // make it consumed
 
@@ -7748,6 +7949,7 @@ static bool QueryDiskChunks ( const CSphQuery & tQuery, CSphQueryResultMeta & tR
 			tMultiArgs.m_iThreads = dSplits[iChunk];
 			tMultiArgs.m_iTotalThreads = iThreads;
 			tMultiArgs.m_bUseSICache = tArgs.m_bUseSICache;
+			tMultiArgs.m_pTopKFloor = pTopKFloor;
 
 			// we use sorters in both disk chunks and ram chunks,
 			// that's why we don't want to move to a new schema before we searched ram chunks
@@ -7770,6 +7972,7 @@ static bool QueryDiskChunks ( const CSphQuery & tQuery, CSphQueryResultMeta & tR
 
 			tThMeta.m_bTotalMatchesApprox |= tChunkMeta.m_bTotalMatchesApprox;
 			tThMeta.m_tIteratorStats.Merge ( tChunkMeta.m_tIteratorStats );
+			tThMeta.m_tIOStats.Add ( tChunkMeta.m_tIOStats );
 
 			if ( CheckInterrupt() && !tChunkMeta.m_sError.IsEmpty() )
 				// FIXME? maybe handle this more gracefully (convert to a warning)?
@@ -7906,7 +8109,7 @@ static bool SetupFilters ( const CSphQuery & tQuery, const ISphSchema & tMatchSc
 }
 
 
-static bool PerformFullscan ( const VecTraits_T<RtSegmentRefPtf_t> & dRamChunks, int iMaxDynamicSize, int iIndexWeight, int iStride, int iCutoff, int64_t tmMaxTimer, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters, CSphString & sWarning )
+static bool PerformFullscan ( const VecTraits_T<RtSegmentRefPtf_t> & dRamChunks, int iMaxDynamicSize, int iIndexWeight, int iStride, int iCutoff, int64_t tmMaxTimer, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters, const ISphFilter * pMinMaxFilter, CSphQueryResultMeta & tMeta )
 {
 	if ( !iCutoff )
 		return true;
@@ -7925,6 +8128,12 @@ static bool PerformFullscan ( const VecTraits_T<RtSegmentRefPtf_t> & dRamChunks,
 	{
 		RtSegment_t & tSeg = *dRamChunks[iSeg];
 		SccRL_t rLock ( tSeg.m_tLock );
+		if ( pMinMaxFilter && tSeg.IsRejectedByMinMax ( *pMinMaxFilter ) )
+		{
+			tMeta.m_tIteratorStats.m_iPrunedChunks++;
+			continue;
+		}
+
 		auto pBlobs = tSeg.m_dBlobs.Begin();
 		tCtx.SetBlobPool(pBlobs);
 		for ( auto * pSorter : dSorters )
@@ -7976,7 +8185,7 @@ static bool PerformFullscan ( const VecTraits_T<RtSegmentRefPtf_t> & dRamChunks,
 			// handle timer
 			if ( sph::TimeExceeded ( tmMaxTimer ) )
 			{
-				sWarning = "query time exceeded max_query_time";
+				tMeta.m_sWarning = "query time exceeded max_query_time";
 				return true;
 			}
 
@@ -7984,7 +8193,7 @@ static bool PerformFullscan ( const VecTraits_T<RtSegmentRefPtf_t> & dRamChunks,
 			{
 				if ( session::GetKilled() )
 				{
-					sWarning = "query was killed";
+					tMeta.m_sWarning = "query was killed";
 					return true;
 				}
 				Threads::Coro::RescheduleAndKeepCrashQuery();
@@ -7996,7 +8205,7 @@ static bool PerformFullscan ( const VecTraits_T<RtSegmentRefPtf_t> & dRamChunks,
 }
 
 
-static bool DoFullScanQuery ( const RtSegVec_c & dRamChunks, const ISphSchema & tMaxSorterSchema, const CSphQuery & tQuery, const CSphMultiQueryArgs & tArgs, int iStride, int64_t tmMaxTimer, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters, CSphQueryResultMeta & tMeta )
+static bool DoFullScanQuery ( const RtSegVec_c & dRamChunks, const ISphSchema & tMaxSorterSchema, const CSphQuery & tQuery, const CSphMultiQueryArgs & tArgs, int iStride, int64_t tmMaxTimer, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters, const ISphFilter * pMinMaxFilter, CSphQueryResultMeta & tMeta )
 {
 	// probably redundant, but just in case
 	SwitchProfile ( pProfiler, SPH_QSTATE_INIT );
@@ -8005,17 +8214,15 @@ static bool DoFullScanQuery ( const RtSegVec_c & dRamChunks, const ISphSchema &
 	// FIXME!!! move searching at segments before disk chunks as result set is safe with kill-lists
 	if ( !dRamChunks.IsEmpty () )
 	{
-		// FIXME! OPTIMIZE! check if we can early reject the whole index
-
 		int iCutoff = ApplyImplicitCutoff ( tQuery, dSorters, false );
-		tMeta.m_bTotalMatchesApprox |= PerformFullscan ( dRamChunks, tMaxSorterSchema.GetDynamicSize(), tArgs.m_iIndexWeight, iStride, iCutoff, tmMaxTimer, pProfiler, tCtx, dSorters, tMeta.m_sWarning );
+		tMeta.m_bTotalMatchesApprox |= PerformFullscan ( dRamChunks, tMaxSorterSchema.GetDynamicSize(), tArgs.m_iIndexWeight, iStride, iCutoff, tmMaxTimer, pProfiler, tCtx, dSorters, pMinMaxFilter, tMeta );
 	}
 
 	return FinalExpressionCalculation ( tCtx, dRamChunks, dSorters, tArgs.m_bFinalizeSorters, tMeta );
 }
 
 
-static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_t & tTermSetup, ISphRanker * pRanker, int iIndexWeight, int iCutoff, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters )
+static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_t & tTermSetup, ISphRanker * pRanker, int iIndexWeight, int iCutoff, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters, ISphMatchSorter * pPruneSorter, std::atomic<int64_t> * pSharedFloor, const ISphFilter * pMinMaxFilter, IteratorStats_t & tStats )
 {
 	if ( !iCutoff )
 		return;
@@ -8026,6 +8233,12 @@ static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_
 	{
 		const RtSegment_t * pSeg = dRamChunks[iSeg];
 		SccRL_t rLock ( pSeg->m_tLock );
+		if ( pMinMaxFilter && pSeg->IsRejectedByMinMax ( *pMinMaxFilter ) )
+		{
+			tStats.m_iPrunedChunks++;
+			continue;
+		}
+
 		SwitchProfile ( pProfiler, SPH_QSTATE_INIT_SEGMENT );
 
 		tTermSetup.SetSegment ( iSeg );
@@ -8057,6 +8270,7 @@ static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_
 		pRanker->ExtraData ( EXTRA_SET_COLUMNAR, (void**)&pColumnar );
 
 		CSphMatch * pMatch = pRanker->GetMatchesBuffer();
+		CSphMatch * dBlock[MAX_BLOCK_DOCS];
 		while (true)
 		{
 			// ranker does profile switches internally in GetMatches()
@@ -8066,6 +8280,7 @@ static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_
 
 			SwitchProfile ( pProfiler, SPH_QSTATE_SORT );
 
+			assert ( iMatches<=MAX_BLOCK_DOCS );
 			for ( int i=0; i<iMatches; i++ )
 			{
 				CSphMatch & tMatch = pMatch[i];
@@ -8075,7 +8290,15 @@ static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_
 				if ( bRandomize )
 					tMatch.m_iWeight = ( sphRand() & 0xffff ) * iIndexWeight;
 
-				tCtx.CalcSort ( tMatch );
+				dBlock[i] = &tMatch;
+			}
+
+			// sort-stage expressions are evaluated with batch calls over the whole block
+			tCtx.CalcSortBatch ( { dBlock, iMatches } );
+
+			for ( int i=0; i<iMatches; i++ )
+			{
+				CSphMatch & tMatch = pMatch[i];
 
 				if ( tCtx.m_pWeightFilter && !tCtx.m_pWeightFilter->Eval ( tMatch ) )
 				{
@@ -8104,9 +8327,14 @@ static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_
 				tCtx.FreeDataFilter ( tMatch );
 				tCtx.FreeDataSort ( tMatch );
 
-				if ( bNewMatch )
-					if ( --iCutoff==0 )
-						break;
+				if ( bNewMatch && --iCutoff==0 )
+				{
+					// the rest of the block had its sort-stage data computed, but won't be pushed
+					for ( int j=i+1; j<iMatches; j++ )
+						tCtx.FreeDataSort ( pMatch[j] );
+
+					break;
+				}
 			}
 
 			if ( iCutoff==0 )
@@ -8114,11 +8342,14 @@ static void PerformFullTextSearch ( const RtSegVec_c & dRamChunks, RtQwordSetup_
 				iSeg = dRamChunks.GetLength();
 				break;
 			}
+
+			if ( pPruneSorter )
+				UpdateTopKFloor ( pRanker, pPruneSorter, iIndexWeight, pSharedFloor );
 		}
 	}
 }
 
-static bool DoFullTextSearch ( const RtSegVec_c & dRamChunks, const ISphSchema & tMaxSorterSchema, const CSphQuery & tQuery, const CSphMultiQueryArgs & tArgs, int iMatchPoolSize, int iStackNeed, RtQwordSetup_t & tTermSetup, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters, XQQuery_t & tParsed, CSphQueryResultMeta & tMeta, ISphMatchSorter * pSorter )
+static bool DoFullTextSearch ( const RtSegVec_c & dRamChunks, const ISphSchema & tMaxSorterSchema, const CSphQuery & tQuery, const CSphMultiQueryArgs & tArgs, int iMatchPoolSize, int iStackNeed, RtQwordSetup_t & tTermSetup, QueryProfile_c * pProfiler, CSphQueryContext & tCtx, VecTraits_T<ISphMatchSorter*> & dSorters, XQQuery_t & tParsed, const ISphFilter * pMinMaxFilter, CSphQueryResultMeta & tMeta, ISphMatchSorter * pSorter )
 {
 	// set zonespanlist settings
 	tParsed.m_bNeedSZlist = tQuery.m_bZSlist;
@@ -8153,11 +8384,17 @@ static bool DoFullTextSearch ( const RtSegVec_c & dRamChunks, const ISphSchema &
 	// FIXME!!! move searching at segments before disk chunks as result set is safe with kill-lists
 	if ( !dRamChunks.IsEmpty () )
 	{
-		// FIXME! OPTIMIZE! check if we can early reject the whole index
-
 		// do searching
 		int iCutoff = ApplyImplicitCutoff ( tQuery, dSorters, true );
-		PerformFullTextSearch ( dRamChunks, tTermSetup, pRanker.get (), tArgs.m_iIndexWeight, iCutoff, pProfiler, tCtx, dSorters );
+		ISphMatchSorter * pPruneSorter = SetupTopKPruning ( pRanker.get(), tQuery, dSorters, tArgs.m_iIndexWeight, iCutoff );
+		if ( pPruneSorter )
+			UpdateTopKFloor ( pRanker.get(), pPruneSorter, tArgs.m_iIndexWeight, tArgs.m_pTopKFloor );
+
+		PerformFullTextSearch ( dRamChunks, tTermSetup, pRanker.get (), tArgs.m_iIndexWeight, iCutoff, pProfiler, tCtx, dSorters, pPruneSorter, tArgs.m_pTopKFloor, pMinMaxFilter, tMeta.m_tIteratorStats );
+
+		// pruned docs are not counted
+		if ( pPruneSorter && GetTopKPrunedDocs ( pRanker.get() ) )
+			tMeta.m_bTotalMatchesApprox = true;
 	}
 
 	if ( !FinalExpressionCalculation ( tCtx, dRamChunks, dSorters, tArgs.m_bFinalizeSorters, tMeta ) )
@@ -8508,16 +8745,20 @@ bool RtIndex_c::MultiQuery ( CSphQueryResult & tResult, const CSphQuery & tQuery
 	if ( !SetupFilters ( tQueryToRun, tMaxSorterSchema, m_tSchema, bParsedFullscan, tCtx, dTransformedFilters, dTransformedFilterTree, dSorterSchemas, tMeta ) )
 		return false;
 
+	// RAM segments whose min/max don't pass the filters are skipped as a whole
+	auto pMinMaxFilter = CreateMinMaxFilter ( tQueryToRun, m_tSchema );
+
 	bool bResult;
 	if ( bParsedFullscan )
-		bResult = DoFullScanQuery ( tGuard.m_dRamSegs, tMaxSorterSchema, tQueryToRun, tArgs, m_iStride, tmMaxTimer, pProfiler, tCtx, dSorters, tMeta );
+		bResult = DoFullScanQuery ( tGuard.m_dRamSegs, tMaxSorterSchema, tQueryToRun, tArgs, m_iStride, tmMaxTimer, pProfiler, tCtx, dSorters, pMinMaxFilter.get(), tMeta );
 	else
 	{
 		CSphMultiQueryArgs tFTArgs ( tArgs.m_iIndexWeight );
 		tFTArgs.m_bFinalizeSorters = tArgs.m_bFinalizeSorters;
+		tFTArgs.m_pTopKFloor = tArgs.m_pTopKFloor;
 		tMeta.m_bBigram = ( m_tSettings.m_eBigramIndex!=SPH_BIGRAM_NONE );
 
-		bResult = DoFullTextSearch ( tGuard.m_dRamSegs, tMaxSorterSchema, tQueryToRun, tFTArgs, iMatchPoolSize, iStackNeed, tTermSetup, pProfiler, tCtx, dSorters, tParsed, tMeta, dSorters.GetLength()==1 ? dSorters[0] : nullptr );
+		bResult = DoFullTextSearch ( tGuard.m_dRamSegs, tMaxSorterSchema, tQueryToRun, tFTArgs, iMatchPoolSize, iStackNeed, tTermSetup, pProfiler, tCtx, dSorters, tParsed, pMinMaxFilter.get(), tMeta, dSorters.GetLength()==1 ? dSorters[0] : nullptr );
 	}
 
 	if (!bResult)
@@ -8920,6 +9161,9 @@ int RtIndex_c::CheckThenUpdateAttributes ( AttrUpdateInc_t& tUpd, bool& bCritica
 		if ( !pSeg->Update_UpdateAttributes ( dRamUpdateSet, tCtx, bCritical, sError ) )
 			return -1;
 
+		// updated values might be out of the collected min/max; the segment is just not pruned until it gets merged
+		pSeg->m_dMinMax.Reset();
+
 		pSeg->MaybeAddPostponedUpdate( dRamUpdateSet, tCtx );
 
 		if ( tUpd.AllApplied () )
@@ -9018,6 +9262,7 @@ void RtIndex_c::AddRemoveRowwiseAttr ( RtGuard_t & tGuard, bool bAdd, const CSph
 		if ( !Alter_AddRemoveRowwiseAttr ( tOldSchema, tNewSchema, pDocinfo, pRSeg->m_uRows, pWSeg->m_dBlobs.begin(), *pSPAWriteWrapper, *pSPBWriteWrapper, bAdd, sAttrName ) )
 			sphWarning ( "%s attribute to %s: %s", bAdd ? "adding" : "removing", GetFilebase(), sError.cstr() );
 		pWSeg->m_dRows.SwapData(dSPA);
+		pWSeg->m_dMinMax.Reset();
 		if ( bBlob || bBlobsModified )
 			pWSeg->m_dBlobs.SwapData(dSPB);
 
@@ -10107,6 +10352,7 @@ Binlog::CheckTnxResult_t RtIndex_c::ReplayCommit ( CSphReader & tReader, CSphStr
 		}
 
 		pSeg->BuildDocID2RowIDMap ( GetInternalSchema() );
+		pSeg->BuildMinMax ( GetInternalSchema() );
 	}
 
 	if ( !Binlog::LoadVector ( tReader, dKlist ) ) return Warn ( sError, tReader );
@@ -10976,6 +11222,12 @@ void RtIndex_c::GetStatus ( CSphIndexStatus * pRes ) const
 	pRes->m_iSavedTID = m_iSavedTID;
 	pRes->m_iLockCount = GetNumOfLocks();
 	pRes->m_iOptimizesCount = OptimizesRunning();
+
+	int64_t iIngested = m_iSegBytesIngested.load ( std::memory_order_relaxed );
+	pRes->m_fRamWriteAmplification = iIngested ? double ( iIngested + m_iSegBytesMerged.load ( std::memory_order_relaxed ) ) / iIngested : 0.0;
+	pRes->m_iRamSegmentMerges = m_iSegMerges.load ( std::memory_order_relaxed );
+	pRes->m_iRamSegmentMergeTimeUs = m_iSegMergeTimeUs.load ( std::memory_order_relaxed );
+	pRes->m_iRamSegmentMergesDeferred = m_iSegMergesDeferred.load ( std::memory_order_relaxed );
 //	sphWarning ( "Chunks: %d, RAM: %d, DISK: %d", pRes->m_iNumChunks, (int) pRes->m_iRamUse, (int) pRes->m_iDiskUse );
 }
 
@@ -11209,6 +11461,7 @@ uint64_t sphGetSettingsFNV ( const CSphIndexSettings & tSettings )
 	int iMinPrefixLen = tSettings.RawMinPrefixLen();
 
 	uHash = sphFNV64 ( &tSettings.m_eHitFormat, sizeof(tSettings.m_eHitFormat), uHash );
+	uHash = sphFNV64 ( &tSettings.m_eDoclistFormat, sizeof(tSettings.m_eDoclistFormat), uHash );
 	uHash = sphFNV64 ( tSettings.m_sHtmlIndexAttrs.cstr(), tSettings.m_sHtmlIndexAttrs.Length(), uHash );
 	uHash = sphFNV64 ( tSettings.m_sHtmlRemoveElements.cstr(), tSettings.m_sHtmlRemoveElements.Length(), uHash );
 	uHash = sphFNV64 ( tSettings.m_sZones.cstr(), tSettings.m_sZones.Length(), uHash );
@@ -11292,6 +11545,21 @@ void RtIndex_c::LockFileState ( CSphVector<CSphString>& dFiles )
 	GetIndexFiles ( dFiles, dFiles );
 }
 
+// meta is not saved without the lock, so it is only released while saving is disabled by LockFileState
+void RtIndex_c::ReleaseTableLock()
+{
+	assert ( !m_tSaving.ActiveStateIs ( SaveState_c::ENABLED ) );
+	SafeClose ( m_iLockFD );
+}
+
+bool RtIndex_c::RetakeTableLock ( CSphString & sError )
+{
+	if ( m_iLockFD>=0 )
+		return true;
+
+	return RawFileLock ( GetFilename ( "lock" ), m_iLockFD, sError );
+}
+
 void RtIndex_c::WaitLockEnabledState () noexcept
 {
 	ScopedScheduler_c tSerialFiber ( m_tWorkers.SerialChunkAccess () );
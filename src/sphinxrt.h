@@ -208,6 +208,10 @@ public:
 	virtual void EnableSave() = 0;
 	virtual void LockFileState ( CSphVector<CSphString> & dFiles ) = 0;
 
+	// hot restart: let another process lock (and load) the frozen table, and take the lock back if it didn't
+	virtual void ReleaseTableLock() = 0;
+	virtual bool RetakeTableLock ( CSphString & sError ) = 0;
+
 	virtual void WaitLockEnabledState() noexcept {};
 	virtual void UnlockEnabledState () noexcept {};
 	
@@ -293,6 +297,7 @@ public:
 	std::atomic<int64_t>			m_tAliveRows { 0 };		///< number of alive (non-killed) rows
 	CSphTightVector<CSphRowitem>	m_dRows GUARDED_BY ( m_tLock );				///< row data storage
 	CSphTightVector<BYTE>			m_dBlobs GUARDED_BY ( m_tLock );            ///< storage for blob attrs
+	CSphTightVector<CSphRowitem>	m_dMinMax GUARDED_BY ( m_tLock );			///< segment-wide min and max rows of plain attrs; empty if unknown
 	CSphVector<BYTE>				m_dKeywordCheckpoints;
 	std::atomic<int64_t> *			m_pRAMCounter = nullptr;///< external RAM counter
 	OpenHashTable_T<DocID_t, RowID_t>	m_tDocIDtoRowID;		///< speeds up docid-rowid lookups
@@ -320,6 +325,8 @@ public:
 
 	void					SetupDocstore ( const CSphSchema * pSchema );
 	void					BuildDocID2RowIDMap ( const CSphSchema & tSchema );
+	void					BuildMinMax ( const ISphSchema & tSchema );
+	bool					IsRejectedByMinMax ( const ISphFilter & tFilter ) const REQUIRES_SHARED ( m_tLock );
 
 	void					MaybeAddPostponedUpdate ( const RowsToUpdate_t& dRows, const UpdateContext_t& tCtx );
 	void					UpdateAttributesOffline ( VecTraits_T<PostponedUpdate_t>& dPostUpdates ) final;
@@ -336,6 +343,9 @@ private:
 using RtSegmentRefPtf_t = CSphRefcountedPtr<RtSegment_t>;
 using ConstRtSegmentRefPtf_t = CSphRefcountedPtr<const RtSegment_t>;
 
+/// tiered merge policy: 2 smallest segments within the lowest size tier having at least 2 of them
+bool FindTieredPair ( std::pair<int, int> & tPair, const VecTraits_T<ConstRtSegmentRefPtf_t> & dSegments );
+
 class RtWordReader_c
 {
 	BYTE m_tPackedWord[SPH_MAX_KEYWORD_LEN + 1];
@@ -494,4 +504,27 @@ volatile int AutoOptimizeCutoffKNN() noexcept;
 
 void SetRtFlushDiskPeriod ( int iFlushWrite, int iFlushSearch );
 
+/// how RAM segments are picked for merging
+enum class RtMergePolicy_e
+{
+	PROGRESSION,	///< merge 2 smallest segments once the size progression breaks (default)
+	TIERED			///< merge only segments of the same size tier, yield to busy search pool
+};
+
+void SetRtMergePolicy ( RtMergePolicy_e ePolicy );
+bool ParseRtMergePolicy ( const CSphString & sPolicy, RtMergePolicy_e & ePolicy );
+
+/// N of pool workers busy with searches; tiered merge yields to them, while other background jobs don't count
+int GetBusySearchWorkers();
+
+/// counts current worker as busy with search while in scope
+class ScopedSearchWorker_c : public ISphNoncopyable
+{
+	bool m_bCounted;
+
+public:
+	explicit ScopedSearchWorker_c ( bool bCount = true );
+	~ScopedSearchWorker_c();
+};
+
 #endif // _sphinxrt_
@@ -15,6 +15,7 @@
 #include "querycontext.h"
 #include "sphinxplugin.h"
 #include "sphinxqcache.h"
+#include "sphinxsort.h"
 #include "attribute.h"
 #include "conversion.h"
 #include "secondaryindex.h"
@@ -28,22 +29,79 @@ bool operator == ( const SkiplistEntry_t & a, RowID_t b )	{ return a.m_tBaseRowI
 bool operator < ( RowID_t a, const SkiplistEntry_t & b )	{ return a<b.m_tBaseRowIDPlus1; }
 
 
-void SkipData_t::Read ( const BYTE * pSkips, const DictEntry_t & tRes, int iDocs, int iSkipBlockSize )
+void SkipData_t::Read ( const BYTE * pSkips, const DictEntry_t & tRes, int iDocs, int iSkipBlockSize, bool bBlockMax, bool bBlockDoclist )
 {
+	const int iMinBlockBytes = SkiplistMinBlockBytes ( iSkipBlockSize, bBlockDoclist );
 	const BYTE * pSkip = pSkips + tRes.m_iSkiplistOffset;
+	m_iBlockDocs = iSkipBlockSize;
+	m_bBlockMax = bBlockMax;
 
 	m_dSkiplist.Add();
 	m_dSkiplist.Last().m_tBaseRowIDPlus1 = 0;
 	m_dSkiplist.Last().m_iOffset = tRes.m_iDoclistOffset;
 	m_dSkiplist.Last().m_iBaseHitlistPos = 0;
+	m_dSkiplist.Last().m_uMaxHits = bBlockMax ? UnzipIntBE(pSkip) : 0;
+	m_dSkiplist.Last().m_uFields = bBlockMax ? UnzipIntBE(pSkip) : 0;
 
 	for ( int i=1; i < iDocs/iSkipBlockSize; i++ )
 	{
 		SkiplistEntry_t & t = m_dSkiplist.Add();
 		SkiplistEntry_t & p = m_dSkiplist [ m_dSkiplist.GetLength()-2 ];
 		t.m_tBaseRowIDPlus1 = p.m_tBaseRowIDPlus1 + iSkipBlockSize + UnzipIntBE(pSkip);
-		t.m_iOffset = p.m_iOffset + 4*iSkipBlockSize + UnzipOffsetBE(pSkip);
+		t.m_iOffset = p.m_iOffset + iMinBlockBytes + UnzipOffsetBE(pSkip);
 		t.m_iBaseHitlistPos = p.m_iBaseHitlistPos + UnzipOffsetBE(pSkip);
+		t.m_uMaxHits = bBlockMax ? UnzipIntBE(pSkip) : 0;
+		t.m_uFields = bBlockMax ? UnzipIntBE(pSkip) : 0;
+	}
+}
+
+
+void FoldSkiplistTail ( VecTraits_T<SkiplistEntry_t> dSkiplist, int iDocs, int iSkipBlockSize )
+{
+	int iKnown = iDocs/iSkipBlockSize;
+	if ( iKnown<1 || iKnown>=dSkiplist.GetLength() )
+		return;
+
+	SkiplistEntry_t & tLast = dSkiplist[iKnown-1];
+	for ( int i=iKnown; i<dSkiplist.GetLength(); i++ )
+	{
+		tLast.m_uMaxHits = Max ( tLast.m_uMaxHits, dSkiplist[i].m_uMaxHits );
+		tLast.m_uFields |= dSkiplist[i].m_uFields;
+	}
+}
+
+
+void ZipSkiplist ( CSphWriter & tWriter, VecTraits_T<SkiplistEntry_t> dSkiplist, int iDocs, int iSkipBlockSize, bool bBlockDoclist )
+{
+	assert ( dSkiplist.GetLength() );
+	assert ( dSkiplist[0].m_tBaseRowIDPlus1==0 );
+	assert ( dSkiplist[0].m_iBaseHitlistPos==0 );
+
+	FoldSkiplistTail ( dSkiplist, iDocs, iSkipBlockSize );
+	const int iMinBlockBytes = SkiplistMinBlockBytes ( iSkipBlockSize, bBlockDoclist );
+
+	// delta coding, but with a couple of skiplist specific tricks
+	// 1) first entry is omitted (but its block-max), it gets reconstructed from dict itself
+	// both base values are zero, and offset equals doclist offset
+	// 2) docids are at least SKIPLIST_BLOCK apart
+	// doclist entries are at least 4*SKIPLIST_BLOCK bytes apart (3*SKIPLIST_BLOCK with doclist_format=block)
+	// so we additionally subtract that to improve delta coding
+	// 3) zero deltas are allowed and *not* used as any markers,
+	// as we know the exact skiplist entry count anyway
+	// 4) block-max (max hits per doc, fields mask) is stored as is, it is not monotonic
+	tWriter.ZipInt ( dSkiplist[0].m_uMaxHits );
+	tWriter.ZipInt ( dSkiplist[0].m_uFields );
+	for ( int i=1; i<dSkiplist.GetLength(); i++ )
+	{
+		const SkiplistEntry_t & tPrev = dSkiplist[i-1];
+		const SkiplistEntry_t & t = dSkiplist[i];
+		assert ( t.m_tBaseRowIDPlus1 - tPrev.m_tBaseRowIDPlus1>=(DWORD)iSkipBlockSize );
+		assert ( t.m_iOffset - tPrev.m_iOffset>=iMinBlockBytes );
+		tWriter.ZipInt ( t.m_tBaseRowIDPlus1 - tPrev.m_tBaseRowIDPlus1 - iSkipBlockSize );
+		tWriter.ZipOffset ( t.m_iOffset - tPrev.m_iOffset - iMinBlockBytes );
+		tWriter.ZipOffset ( t.m_iBaseHitlistPos - tPrev.m_iBaseHitlistPos );
+		tWriter.ZipInt ( t.m_uMaxHits );
+		tWriter.ZipInt ( t.m_uFields );
 	}
 }
 
@@ -133,9 +191,34 @@ struct RankerSettings_t
 	RowIdBoundaries_t m_tBoundaries;
 };
 
+/// upper bound of a bm25-family weight that only needs the doclist entry
+/// weight is (tfidf+0.5)*SCALE plus SCALE times the sum of field weights multiplied by per-field lcs,
+/// and that lcs can't exceed m_iMaxLCS (1 for plain bm25, the query length for proximity_bm25)
+struct WeightBound_t
+{
+	const int *	m_pWeights = nullptr;
+	int			m_iWeights = 0;
+	int			m_iMaxLCS = 0;			///< 0 means the ranker can't bound its weights
+	DWORD		m_uNoFieldsRank = 0;	///< rank to assume for docs that have no field mask
+
+	inline int64_t Calc ( const ExtDoc_t & tDoc ) const
+	{
+		DWORD uRank = m_uNoFieldsRank;
+		if ( tDoc.m_uDocFields )
+		{
+			uRank = 0;
+			for ( int i=0; i<m_iWeights; i++ )
+				if ( tDoc.m_uDocFields & (1<<i) )
+					uRank += m_pWeights[i];
+		}
+
+		return int64_t ( ( tDoc.m_fTFIDF+0.5f )*SPH_BM25_SCALE ) + int64_t(uRank)*m_iMaxLCS*SPH_BM25_SCALE;
+	}
+};
+
 /// ranker interface
 /// ranker folds incoming hitstream into simple match chunks, and computes relevance rank
-class ExtRanker_c : public ISphRanker, public ISphZoneCheck
+class ExtRanker_c : public ISphRanker, public ISphZoneCheck, public BlockSkip_i
 {
 public:
 								ExtRanker_c ( const XQQuery_t & tXQ, const ISphQwordSetup & tSetup, const RankerSettings_t & tSettings, bool bUseBM25 );
@@ -157,6 +240,10 @@ public:
 public:
 	// FIXME? hide and friend?
 	SphZoneHit_e				IsInZone ( int iZone, const ExtHit_t * pHit, int * pLastSpan ) override;
+
+	bool						IsBelowFloor ( const ExtDoc_t & tBound ) const override;
+	void						AddSkippedBlock ( int iDocs ) override;
+	float						GetQueryTFIDF() const override { return m_fQueryTFIDF; }
 	virtual const CSphIndex *	GetIndex() { return m_pIndex; }
 	const CSphQueryContext *	GetCtx() const { return m_pCtx; }
 
@@ -179,6 +266,13 @@ protected:
 
 	QcacheEntry_c *				m_pQcacheEntry = nullptr;			///< data to cache if we decide that the current query is worth caching
 
+	WeightBound_t				m_tWeightBound;
+	int							m_iWeightFloor = 0;					///< docs whose weight bound is below that can't get into the top-k; 0 means no pruning
+	int64_t						m_iPrunedDocs = 0;
+	int64_t						m_iPrunedBlocks = 0;				///< whole doclist blocks skipped by the terms
+	float						m_fQueryTFIDF = 0.0f;				///< sum of (positive) keyword idfs, an upper bound of any doc tf-idf
+	bool						m_bBlockSkip = false;				///< whether terms were told to skip blocks below the floor
+
 	StrVec_t					m_dZones;
 	CSphVector<std::unique_ptr<ExtNode_i>>		m_dZoneStartTerm;
 	CSphVector<std::unique_ptr<ExtNode_i>>		m_dZoneEndTerm;
@@ -193,6 +287,7 @@ protected:
 
 	void						CleanupZones ( RowID_t tMaxRowID );
 	void						UpdateQcache ( int iMatches );
+	void						SetupWeightBound ( const CSphQueryContext & tCtx, int iMaxLCS, bool bAllFields );
 
 	virtual float				CalcRankCost ( int64_t iDocs ) const = 0;
 
@@ -214,6 +309,31 @@ protected:
 		case EXTRA_SET_BOUNDARIES:
 			m_pRoot->SetRowidBoundaries ( *(const RowIdBoundaries_t*)ppResult );
 			return true;
+
+		case EXTRA_SET_WEIGHT_FLOOR:
+			if ( !m_tWeightBound.m_iMaxLCS )
+				return false;
+
+			// pruned docs never reach the ranker, so the result is not cacheable; zero floor (a mere probe) prunes nothing
+			m_iWeightFloor = *(int*)ppResult;
+			if ( m_iWeightFloor>0 )
+			{
+				DisableCaching();
+				if ( !m_bBlockSkip )
+					m_pRoot->SetBlockSkip ( this, true );
+
+				m_bBlockSkip = true;
+			}
+
+			return true;
+
+		case EXTRA_GET_PRUNED_DOCS:
+			*(int64_t*)ppResult = m_iPrunedDocs;
+			return true;
+
+		case EXTRA_GET_PRUNED_BLOCKS:
+			*(int64_t*)ppResult = m_iPrunedBlocks;
+			return true;
 		
 		default:
 			return false;
@@ -256,6 +376,9 @@ public:
 	{
 		m_iWeights = tCtx.m_iWeights;
 		m_pWeights = tCtx.m_dWeights;
+		if_const ( USE_BM25 )
+			this->SetupWeightBound ( tCtx, 1, false );
+
 		return true;
 	}
 };
@@ -275,6 +398,14 @@ public:
 };
 
 
+/// whether ranker state weight is bm25 plus field weights times per-field lcs (so WeightBound_t applies)
+template < typename STATE >
+struct RankerStateLCSBound_T
+{
+	static constexpr bool value = false;
+};
+
+
 template < typename STATE, bool USE_BM25 >
 class ExtRanker_State_T : public ExtRanker_T<USE_BM25>
 {
@@ -286,6 +417,9 @@ public:
 
 	bool InitState ( const CSphQueryContext & tCtx, CSphString & sError ) override
 	{
+		if constexpr ( RankerStateLCSBound_T<STATE>::value )
+			this->SetupWeightBound ( tCtx, Min ( Max ( this->m_iQwords, this->m_iMaxQpos ), UCHAR_MAX ), true );
+
 		return m_tState.Init ( tCtx.m_iWeights, &tCtx.m_dWeights[0], this, sError, tCtx.GetPackedFactor() );
 	}
 
@@ -704,7 +838,7 @@ ExtRanker_c::ExtRanker_c ( const XQQuery_t & tXQ, const ISphQwordSetup & tSetup,
 		m_dZoneEnd[i] = nullptr;
 	}
 
-	if ( QcacheGetStatus().m_iMaxBytes>0 && !tSettings.m_bSkipQCache )
+	if ( QcacheGetMaxBytes()>0 && !tSettings.m_bSkipQCache )
 	{
 		m_pQcacheEntry = new QcacheEntry_c();
 		m_pQcacheEntry->m_iIndexId = m_pIndex->GetIndexId();
@@ -837,9 +971,51 @@ void ExtRanker_c::CleanupZones ( RowID_t tMaxRowID )
 }
 
 
+void ExtRanker_c::SetupWeightBound ( const CSphQueryContext & tCtx, int iMaxLCS, bool bAllFields )
+{
+	// field mask only covers the first 32 fields; negative weights would break the bound
+	if ( bAllFields && tCtx.m_iWeights>32 )
+		return;
+
+	for ( int i=0; i<tCtx.m_iWeights; i++ )
+		if ( tCtx.m_dWeights[i]<0 )
+			return;
+
+	m_tWeightBound.m_pWeights = tCtx.m_dWeights;
+	m_tWeightBound.m_iWeights = Min ( tCtx.m_iWeights, 32 );
+	m_tWeightBound.m_iMaxLCS = iMaxLCS;
+	m_tWeightBound.m_uNoFieldsRank = 1;
+	if ( bAllFields )
+	{
+		m_tWeightBound.m_uNoFieldsRank = 0;
+		for ( int i=0; i<tCtx.m_iWeights; i++ )
+			m_tWeightBound.m_uNoFieldsRank += tCtx.m_dWeights[i];
+	}
+}
+
+
+bool ExtRanker_c::IsBelowFloor ( const ExtDoc_t & tBound ) const
+{
+	// one point of margin, as the bound tf-idf gets summed in a different order than the real one
+	return m_iWeightFloor>0 && m_tWeightBound.Calc ( tBound )+1<m_iWeightFloor;
+}
+
+
+void ExtRanker_c::AddSkippedBlock ( int iDocs )
+{
+	m_iPrunedBlocks++;
+	m_iPrunedDocs += iDocs;
+}
+
+
 void ExtRanker_c::SetQwordsIDF ( const ExtQwordsHash_t & hQwords )
 {
 	m_iQwords = hQwords.GetLength ();
+
+	m_fQueryTFIDF = 0.0f;
+	for ( const auto & tQword : hQwords )
+		m_fQueryTFIDF += Max ( tQword.second.m_fIDF, 0.0f );
+
 	if ( m_pRoot )
 		m_pRoot->SetQwordsIDF ( hQwords );
 }
@@ -1177,6 +1353,16 @@ const ExtDoc_t * ExtRanker_T<USE_BM25>::GetFilteredDocs ()
 		RowID_t tMaxRowID = 0;
 		while ( pCand->m_tRowID!=INVALID_ROWID )
 		{
+			if_const ( USE_BM25 )
+			{
+				if ( m_iWeightFloor && m_tWeightBound.Calc ( *pCand )<m_iWeightFloor )
+				{
+					m_iPrunedDocs++;
+					pCand++;
+					continue;
+				}
+			}
+
 			m_tTestMatch.m_tRowID = pCand->m_tRowID;
 			m_tTestMatch.m_pStatic = nullptr;
 
@@ -1555,6 +1741,12 @@ struct RankerState_Proximity_fn : public ISphExtra
 	}
 };
 
+template < bool HANDLE_DUPES >
+struct RankerStateLCSBound_T<RankerState_Proximity_fn<true,HANDLE_DUPES>>
+{
+	static constexpr bool value = true;
+};
+
 //////////////////////////////////////////////////////////////////////////
 
 // sph04, proximity + exact boost
@@ -4551,9 +4743,16 @@ std::unique_ptr<ISphRanker> sphCreateRanker ( const XQQuery_t & tXQ, const CSphQ
 		return QcacheRanker ( pCached, tTermSetup );
 
 	// we need this for rankers that populate nodes with docs immediately after creation (e.g. payload nodes)
-	tRankerSettings.m_bRowidLimits = tQuery.m_dFilters.any_of ( []( auto & tFilter ){ return tFilter.m_sAttrName=="@rowid"; } );
-	if ( tRankerSettings.m_bRowidLimits ) 
-		GetRowIdFilter ( tQuery.m_dFilters, tCtx.m_iIndexTotalDocs, tRankerSettings.m_tBoundaries );
+	if ( tCtx.m_pRowIdBoundaries )
+	{
+		tRankerSettings.m_bRowidLimits = true;
+		tRankerSettings.m_tBoundaries = *tCtx.m_pRowIdBoundaries;
+	} else
+	{
+		tRankerSettings.m_bRowidLimits = tQuery.m_dFilters.any_of ( []( auto & tFilter ){ return tFilter.m_sAttrName=="@rowid"; } );
+		if ( tRankerSettings.m_bRowidLimits )
+			GetRowIdFilter ( tQuery.m_dFilters, tCtx.m_iIndexTotalDocs, tRankerSettings.m_tBoundaries );
+	}
 
 	// setup eval-tree
 	std::unique_ptr<ExtRanker_c> pRanker;
@@ -4765,6 +4964,79 @@ std::unique_ptr<ISphRanker> sphCreateRanker ( const XQQuery_t & tXQ, const CSphQ
 	return pRanker;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// TOP-K PRUNING
+//////////////////////////////////////////////////////////////////////////
+
+ISphMatchSorter * SetupTopKPruning ( ISphRanker * pRanker, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dSorters, int iIndexWeight, int iCutoff )
+{
+	if ( !tQuery.m_bTopKPruning || dSorters.GetLength()!=1 || iIndexWeight<=0 || iCutoff!=-1 || !tQuery.m_sJoinIdx.IsEmpty() )
+		return nullptr;
+
+	ISphMatchSorter * pSorter = dSorters[0];
+	if ( pSorter->IsGroupby() || pSorter->IsRandom() )
+		return nullptr;
+
+	// weight has to be the primary sort key, in descending order
+	const CSphMatchComparatorState & tState = pSorter->GetState();
+	bool bByWeight = tQuery.m_eSort==SPH_SORT_RELEVANCE
+		|| ( tQuery.m_eSort==SPH_SORT_EXTENDED && tState.m_eKeypart[0]==SPH_KEYPART_WEIGHT && ( tState.m_uAttrDesc & 1 ) );
+	if ( !bByWeight )
+		return nullptr;
+
+	// rankers that can't bound their weights refuse the floor; zero one doesn't prune (or disable qcache) yet
+	int iFloor = 0;
+	if ( !pRanker->ExtraData ( EXTRA_SET_WEIGHT_FLOOR, (void**)&iFloor ) )
+		return nullptr;
+
+	return pSorter;
+}
+
+
+void UpdateTopKFloor ( ISphRanker * pRanker, ISphMatchSorter * pSorter, int iIndexWeight, std::atomic<int64_t> * pSharedFloor )
+{
+	int64_t iWeight = pSharedFloor ? pSharedFloor->load ( std::memory_order_relaxed ) : 0;
+
+	// until the queue is full, any match gets in
+	const CSphMatch * pWorst = pSorter->GetLength()<pSorter->GetMatchCapacity() ? nullptr : pSorter->GetWorst();
+	if ( pWorst && pWorst->m_iWeight>iWeight )
+	{
+		iWeight = pWorst->m_iWeight;
+
+		// every sibling keeps its own queue of the same size, and the merged top-k can't be worse than any of them
+		if ( pSharedFloor )
+		{
+			int64_t iShared = pSharedFloor->load ( std::memory_order_relaxed );
+			while ( iShared<iWeight && !pSharedFloor->compare_exchange_weak ( iShared, iWeight, std::memory_order_relaxed ) )
+				;
+		}
+	}
+
+	if ( iWeight<=0 )
+		return;
+
+	// ranker weights get multiplied by index weight before the push; a doc whose bound is below the floor
+	// compares less than the worst match and would be rejected by the queue anyway
+	auto iFloor = int ( ( iWeight + iIndexWeight - 1 ) / iIndexWeight );
+	pRanker->ExtraData ( EXTRA_SET_WEIGHT_FLOOR, (void**)&iFloor );
+}
+
+
+int64_t GetTopKPrunedDocs ( ISphRanker * pRanker )
+{
+	int64_t iPruned = 0;
+	pRanker->ExtraData ( EXTRA_GET_PRUNED_DOCS, (void**)&iPruned );
+	return iPruned;
+}
+
+
+int64_t GetTopKPrunedBlocks ( ISphRanker * pRanker )
+{
+	int64_t iPruned = 0;
+	pRanker->ExtraData ( EXTRA_GET_PRUNED_BLOCKS, (void**)&iPruned );
+	return iPruned;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// HIT MARKER
 //////////////////////////////////////////////////////////////////////////
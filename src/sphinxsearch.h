@@ -36,18 +36,32 @@ struct SkiplistEntry_t
 	RowID_t		m_tBaseRowIDPlus1;	///< delta decoder rowid base (stored as base rowid + 1)
 	int64_t		m_iOffset;			///< offset in the doclist file (relative to the doclist start)
 	int64_t		m_iBaseHitlistPos;	///< delta decoder hitlist offset base
+	DWORD		m_uMaxHits = 0;		///< block-max: most hits a doc of this block has
+	DWORD		m_uFields = 0;		///< block-max: fields (first 32) any doc of this block has hits in
 };
 
 bool operator < ( const SkiplistEntry_t & a, RowID_t b );
 bool operator == ( const SkiplistEntry_t & a, RowID_t b );
 bool operator < ( RowID_t a, const SkiplistEntry_t & b );
 
+/// readers only know of iDocs/iSkipBlockSize entries, so the block-max of the last one has to cover the rest of the docs
+void FoldSkiplistTail ( VecTraits_T<SkiplistEntry_t> dSkiplist, int iDocs, int iSkipBlockSize );
+
+/// min bytes a skiplist block of doclist entries takes; skiplist offset deltas are stored minus that
+/// (doclist_format=block moves rowid deltas out of the entries into a bit-packed block header, so its entries are a byte shorter)
+inline int SkiplistMinBlockBytes ( int iSkipBlockSize, bool bBlockDoclist ) { return ( bBlockDoclist ? 3 : 4 )*iSkipBlockSize; }
+
+/// write skiplist of a doclist with iDocs docs (first entry is not written, it is known from the dict entry)
+void ZipSkiplist ( CSphWriter & tWriter, VecTraits_T<SkiplistEntry_t> dSkiplist, int iDocs, int iSkipBlockSize, bool bBlockDoclist );
+
 struct DictEntry_t;
 struct SkipData_t
 {
 	CSphVector<SkiplistEntry_t> m_dSkiplist;
+	int		m_iBlockDocs = 0;		///< docs per skiplist block
+	bool	m_bBlockMax = false;	///< whether entries have block-max (index format v.70+)
 
-	void Read ( const BYTE * pSkips, const DictEntry_t & tRes, int iDocs, int iSkipBlockSize );
+	void Read ( const BYTE * pSkips, const DictEntry_t & tRes, int iDocs, int iSkipBlockSize, bool bBlockMax, bool bBlockDoclist );
 };
 
 class RtIndex_c;
@@ -97,6 +111,13 @@ public:
 
 	virtual RowID_t				AdvanceTo ( RowID_t tRowID );
 	virtual bool				HintRowID ( RowID_t ) { return false; }
+
+	/// block-max of the doclist block which starts with the next doc; false if the next doc doesn't start a block
+	/// (or the doclist has no block-max), and for the last block which ends with the doclist
+	virtual bool				GetBlockMax ( DWORD & uMaxHits, DWORD & uFields ) { return false; }
+
+	/// skip to the next doclist block; returns the number of docs skipped
+	virtual int					SkipBlock() { return 0; }
 	virtual const CSphMatch &	GetNextDoc() = 0;
 	virtual void				SeekHitlist ( SphOffset_t uOff ) = 0;
 	virtual Hitpos_t			GetNextHit () = 0;
@@ -157,6 +178,20 @@ public:
 /// factory
 std::unique_ptr<ISphRanker> sphCreateRanker ( const XQQuery_t & tXQ, const CSphQuery & tQuery, CSphQueryResultMeta & tMeta, const ISphQwordSetup & tTermSetup, const CSphQueryContext & tCtx, const ISphSchema & tSorterSchema );
 
+/// top-k pruning (OPTION top_k_pruning=1)
+/// returns the sorter whose worst kept match gives the ranker its weight floor, or nullptr if pruning does not apply
+ISphMatchSorter *	SetupTopKPruning ( ISphRanker * pRanker, const CSphQuery & tQuery, const VecTraits_T<ISphMatchSorter *> & dSorters, int iIndexWeight, int iCutoff );
+
+/// pass the weight of the worst match of a full sorter to the ranker; called between GetMatches() batches.
+/// pSharedFloor (if any) is shared by the sibling pseudo-shards of the same index; the best floor of them all applies to each
+void				UpdateTopKFloor ( ISphRanker * pRanker, ISphMatchSorter * pSorter, int iIndexWeight, std::atomic<int64_t> * pSharedFloor );
+
+/// number of docs the ranker skipped as not being able to get into the top-k
+int64_t				GetTopKPrunedDocs ( ISphRanker * pRanker );
+
+/// number of whole doclist blocks skipped as not being able to get into the top-k
+int64_t				GetTopKPrunedBlocks ( ISphRanker * pRanker );
+
 class QwordScan_c : public ISphQword
 {
 public:
@@ -859,6 +859,7 @@ static KeyDesc_t g_dKeysIndex[] =
 	{ "agent_connect_timeout",	0, NULL },
 	{ "ha_strategy",			0, NULL	},
 	{ "agent_query_timeout",	0, NULL },
+	{ "agent_hedge_rate",		0, NULL },
 	{ "html_strip",				0, NULL },
 	{ "html_index_attrs",		0, NULL },
 	{ "html_remove_elements",	0, NULL },
@@ -876,6 +877,7 @@ static KeyDesc_t g_dKeysIndex[] =
 	{ "expand_keywords",		0, NULL },
 	{ "hitless_words",			0, NULL },
 	{ "hit_format",				KEY_HIDDEN | KEY_DEPRECATED, "default value" },
+	{ "doclist_format",			0, NULL },
 	{ "rt_field",				KEY_LIST, NULL },
 	{ "rt_attr_uint",			KEY_LIST, NULL },
 	{ "rt_attr_bigint",			KEY_LIST, NULL },
@@ -954,6 +956,7 @@ static KeyDesc_t g_dKeysIndexer[] =
 	{ "json_autoconv_keynames",	KEY_DEPRECATED, "json_autoconv_keynames in common{..} section" },
 	{ "lemmatizer_cache",		0, NULL },
 	{ "ignore_non_plain",		0, NULL },
+	{ "sort_threads",			0, NULL },
 	{ NULL,						0, NULL }
 };
 
@@ -989,6 +992,7 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "read_buffer_hits",		0, NULL },
 	{ "read_buffer_columnar",	0, NULL },
 	{ "read_unhinted",			0, NULL },
+	{ "read_prefetch",			0, NULL },
 	{ "max_batch_queries",		0, NULL },
 	{ "subtree_docs_cache",		0, NULL },
 	{ "subtree_hits_cache",		0, NULL },
@@ -1001,6 +1005,7 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "binlog_max_log_size",	0, NULL },
 	{ "binlog_filename_digits",	0, NULL },
 	{ "binlog_common",			0, NULL },
+	{ "binlog_group_commit",	0, NULL },
 	{ "thread_stack",			0, NULL },
 	{ "expansion_limit",		0, NULL },
 	{ "rt_flush_period",		0, NULL },
@@ -1015,6 +1020,7 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "sphinxql_state",			0, NULL },
 	{ "rt_merge_iops",			0, NULL },
 	{ "rt_merge_maxiosize",		0, NULL },
+	{ "rt_merge_policy",		0, NULL },
 	{ "ha_ping_interval",		0, NULL },
 	{ "ha_period_karma",		0, NULL },
 	{ "predicted_time_costs",	0, NULL },
@@ -1026,6 +1032,8 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "agent_query_timeout",	0, NULL },
 	{ "agent_retry_delay",		0, NULL },
 	{ "agent_retry_count",		0, NULL },
+	{ "agent_compression",		0, NULL },
+	{ "agent_compression_threshold",	0, NULL },
 	{ "net_wait_tm",			0, NULL },
 	{ "net_throttle_action",	0, NULL },
 	{ "net_throttle_accept",	0, NULL },
@@ -1057,12 +1065,14 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "ssl_ca",					0, nullptr },
 	{ "max_connections",		0, nullptr },
 	{ "threads",				0, nullptr },
+	{ "work_stealing",			0, nullptr },
 	{ "jobs_queue_size",		0, nullptr },
 	{ "not_terms_only_allowed",	0, nullptr },
 	{ "boolean_simplify",		0, nullptr },
 	{ "query_log_commands",		0, nullptr },
 	{ "auto_optimize",			0, nullptr },
 	{ "pseudo_sharding",		0, nullptr },
+	{ "minmax_pruning",			0, nullptr },
 	{ "optimize_cutoff",		0, nullptr },
 	{ "secondary_indexes",		0, nullptr },
 	{ "accurate_aggregation",	0, nullptr },
@@ -1087,6 +1097,7 @@ static KeyDesc_t g_dKeysSearchd[] =
 	{ "merge_si_memlimit",		0, NULL },
 	{ "log_http",				0, NULL },
 	{ "join_batch_size",		0, NULL },
+	{ "join_hash_threshold",	0, NULL },
 	{ "diskchunk_flush_write_timeout",		0, nullptr },
 	{ "diskchunk_flush_search_timeout",		0, nullptr },
 	{ "kibana_version_string",		0, NULL },
@@ -0,0 +1,291 @@
+//
+// Copyright (c) 2017-2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org
+//
+
+#include "roaring.h"
+
+#include "bitcount.h"
+#include "log2.h"
+#include <algorithm>
+
+static inline int LowestBit ( uint64_t uWord )
+{
+	return sphLog2 ( uWord & ( ~uWord+1 ) )-1;
+}
+
+
+void RoaringBitmap_c::Container_t::ToBitmap()
+{
+	assert ( !IsBitmap() );
+	m_dBits.Resize ( BITMAP_WORDS );
+	m_dBits.ZeroVec();
+	for ( auto uLow : m_dArray )
+		m_dBits[uLow>>6] |= 1ULL << ( uLow & 63 );
+
+	m_dArray.Reset();
+}
+
+
+void RoaringBitmap_c::Container_t::ToArray()
+{
+	assert ( IsBitmap() );
+	m_dArray.Resize(0);
+	m_dArray.Reserve ( m_iCount );
+	for ( int i = 0; i < BITMAP_WORDS; ++i )
+		for ( uint64_t uWord = m_dBits[i]; uWord; uWord &= uWord-1 )
+			m_dArray.Add ( WORD ( ( i<<6 ) + LowestBit ( uWord ) ) );
+
+	m_dBits.Reset();
+}
+
+
+void RoaringBitmap_c::Container_t::And ( const Container_t & tRhs )
+{
+	if ( IsBitmap() && tRhs.IsBitmap() )
+	{
+		m_iCount = 0;
+		for ( int i = 0; i < BITMAP_WORDS; ++i )
+		{
+			m_dBits[i] &= tRhs.m_dBits[i];
+			m_iCount += sphBitCount ( m_dBits[i] );
+		}
+
+		if ( m_iCount<=ARRAY_MAX )
+			ToArray();
+
+		return;
+	}
+
+	if ( IsBitmap() )
+	{
+		// the result can't be larger than the array on the right
+		CSphVector<WORD> dRes;
+		for ( auto uLow : tRhs.m_dArray )
+			if ( m_dBits[uLow>>6] & ( 1ULL << ( uLow & 63 ) ) )
+				dRes.Add(uLow);
+
+		m_dBits.Reset();
+		m_dArray.SwapData(dRes);
+		m_iCount = m_dArray.GetLength();
+		return;
+	}
+
+	int iOut = 0;
+	if ( tRhs.IsBitmap() )
+	{
+		for ( auto uLow : m_dArray )
+			if ( tRhs.m_dBits[uLow>>6] & ( 1ULL << ( uLow & 63 ) ) )
+				m_dArray[iOut++] = uLow;
+	} else
+	{
+		const WORD * pRhs = tRhs.m_dArray.Begin();
+		const WORD * pRhsEnd = tRhs.m_dArray.End();
+		for ( auto uLow : m_dArray )
+		{
+			while ( pRhs<pRhsEnd && *pRhs<uLow )
+				++pRhs;
+
+			if ( pRhs==pRhsEnd )
+				break;
+
+			if ( *pRhs==uLow )
+				m_dArray[iOut++] = uLow;
+		}
+	}
+
+	m_dArray.Resize(iOut);
+	m_iCount = iOut;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+RoaringBitmap_c::RoaringBitmap_c ( const RoaringBitmap_c & tRhs )
+{
+	m_dContainers.Reserve ( tRhs.m_dContainers.GetLength() );
+	for ( const auto * pContainer : tRhs.m_dContainers )
+		m_dContainers.Add ( new Container_t ( *pContainer ) );
+}
+
+
+RoaringBitmap_c::~RoaringBitmap_c()
+{
+	for ( auto & pContainer : m_dContainers )
+		SafeDelete ( pContainer );
+}
+
+
+int RoaringBitmap_c::FindContainer ( DWORD uKey ) const
+{
+	int iLeft = 0;
+	int iRight = m_dContainers.GetLength();
+	while ( iLeft<iRight )
+	{
+		int iMid = ( iLeft+iRight ) / 2;
+		if ( m_dContainers[iMid]->m_uKey<uKey )
+			iLeft = iMid+1;
+		else
+			iRight = iMid;
+	}
+
+	return iLeft;
+}
+
+
+RoaringBitmap_c::Container_t & RoaringBitmap_c::GetContainer ( DWORD uKey )
+{
+	if ( m_iLast>=0 && m_dContainers[m_iLast]->m_uKey==uKey )
+		return *m_dContainers[m_iLast];
+
+	int iContainer = FindContainer(uKey);
+	if ( iContainer==m_dContainers.GetLength() || m_dContainers[iContainer]->m_uKey!=uKey )
+	{
+		auto * pContainer = new Container_t;
+		pContainer->m_uKey = uKey;
+		m_dContainers.Insert ( iContainer, pContainer );
+	}
+
+	m_iLast = iContainer;
+	return *m_dContainers[iContainer];
+}
+
+
+void RoaringBitmap_c::Add ( DWORD uValue )
+{
+	Container_t & tContainer = GetContainer ( uValue>>16 );
+	auto uLow = WORD ( uValue & 0xFFFF );
+
+	if ( tContainer.IsBitmap() )
+	{
+		uint64_t & uWord = tContainer.m_dBits[uLow>>6];
+		uint64_t uBit = 1ULL << ( uLow & 63 );
+		tContainer.m_iCount += ( uWord & uBit ) ? 0 : 1;
+		uWord |= uBit;
+		return;
+	}
+
+	auto & dArray = tContainer.m_dArray;
+	if ( dArray.IsEmpty() || dArray.Last()<uLow )
+		dArray.Add(uLow);
+	else
+	{
+		const WORD * pFound = std::lower_bound ( dArray.Begin(), dArray.End(), uLow );
+		if ( *pFound==uLow )
+			return;
+
+		dArray.Insert ( pFound-dArray.Begin(), uLow );
+	}
+
+	if ( ++tContainer.m_iCount>ARRAY_MAX )
+		tContainer.ToBitmap();
+}
+
+
+void RoaringBitmap_c::Add ( const DWORD * pValues, int iValues )
+{
+	for ( int i = 0; i < iValues; ++i )
+		Add ( pValues[i] );
+}
+
+
+void RoaringBitmap_c::And ( const RoaringBitmap_c & tRhs )
+{
+	int iOut = 0;
+	for ( auto * pContainer : m_dContainers )
+	{
+		int iRhs = tRhs.FindContainer ( pContainer->m_uKey );
+		if ( iRhs<tRhs.m_dContainers.GetLength() && tRhs.m_dContainers[iRhs]->m_uKey==pContainer->m_uKey )
+			pContainer->And ( *tRhs.m_dContainers[iRhs] );
+		else
+			pContainer->m_iCount = 0;
+
+		if ( pContainer->m_iCount )
+			m_dContainers[iOut++] = pContainer;
+		else
+			SafeDelete ( pContainer );
+	}
+
+	m_dContainers.Resize(iOut);
+	m_iLast = -1;
+}
+
+
+bool RoaringBitmap_c::Contains ( DWORD uValue ) const
+{
+	int iContainer = FindContainer ( uValue>>16 );
+	if ( iContainer==m_dContainers.GetLength() || m_dContainers[iContainer]->m_uKey!=( uValue>>16 ) )
+		return false;
+
+	const Container_t & tContainer = *m_dContainers[iContainer];
+	auto uLow = WORD ( uValue & 0xFFFF );
+	if ( tContainer.IsBitmap() )
+		return !!( tContainer.m_dBits[uLow>>6] & ( 1ULL << ( uLow & 63 ) ) );
+
+	return std::binary_search ( tContainer.m_dArray.Begin(), tContainer.m_dArray.End(), uLow );
+}
+
+
+int64_t RoaringBitmap_c::GetCount() const
+{
+	int64_t iCount = 0;
+	for ( const auto * pContainer : m_dContainers )
+		iCount += pContainer->m_iCount;
+
+	return iCount;
+}
+
+
+int64_t RoaringBitmap_c::GetSizeBytes() const
+{
+	int64_t iBytes = sizeof(*this) + m_dContainers.GetLengthBytes64();
+	for ( const auto * pContainer : m_dContainers )
+		iBytes += sizeof(Container_t) + pContainer->m_dArray.GetLengthBytes64() + pContainer->m_dBits.GetLengthBytes64();
+
+	return iBytes;
+}
+
+
+int RoaringBitmap_c::Fetch ( int64_t & iFrom, DWORD * pOut, int iMax ) const
+{
+	if ( iFrom>UINT32_MAX )
+		return 0;
+
+	auto uFrom = (DWORD)iFrom;
+	int iOut = 0;
+	for ( int i = FindContainer ( uFrom>>16 ); i < m_dContainers.GetLength() && iOut<iMax; ++i )
+	{
+		const Container_t & tContainer = *m_dContainers[i];
+		DWORD uHigh = tContainer.m_uKey<<16;
+		DWORD uLowFrom = tContainer.m_uKey==( uFrom>>16 ) ? ( uFrom & 0xFFFF ) : 0;
+
+		if ( tContainer.IsBitmap() )
+		{
+			int iWord = uLowFrom>>6;
+			uint64_t uWord = tContainer.m_dBits[iWord] & ( ~0ULL << ( uLowFrom & 63 ) );
+			while ( true )
+			{
+				for ( ; uWord && iOut<iMax; uWord &= uWord-1 )
+					pOut[iOut++] = uHigh | ( iWord<<6 ) | LowestBit ( uWord );
+
+				if ( iOut==iMax || ++iWord==BITMAP_WORDS )
+					break;
+
+				uWord = tContainer.m_dBits[iWord];
+			}
+		} else
+		{
+			const WORD * pLow = std::lower_bound ( tContainer.m_dArray.Begin(), tContainer.m_dArray.End(), (WORD)uLowFrom );
+			const WORD * pEnd = tContainer.m_dArray.End();
+			while ( pLow<pEnd && iOut<iMax )
+				pOut[iOut++] = uHigh | *pLow++;
+		}
+	}
+
+	iFrom = iOut ? (int64_t)pOut[iOut-1]+1 : (int64_t)UINT32_MAX+1;
+	return iOut;
+}
@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2017-2026, Manticore Software LTD (https://manticoresearch.com)
+// All rights reserved
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License. You should have
+// received a copy of the GPL license along with this program; if you
+// did not, you can find it at http://www.gnu.org
+//
+
+#pragma once
+
+#include "ints.h"
+#include "vector.h"
+
+/// roaring-style compressed set of 32-bit values (row ids)
+/// values are split by their high 16 bits into containers; a container stores the low 16 bits
+/// as a sorted array while it is sparse, and turns into a 64k-bit bitmap once that is smaller
+class RoaringBitmap_c
+{
+public:
+				RoaringBitmap_c() = default;
+				RoaringBitmap_c ( const RoaringBitmap_c & tRhs );
+				RoaringBitmap_c & operator= ( const RoaringBitmap_c & ) = delete;
+				~RoaringBitmap_c();
+
+	void		Add ( DWORD uValue );
+	void		Add ( const DWORD * pValues, int iValues );
+	void		And ( const RoaringBitmap_c & tRhs );	///< word-parallel for bitmap containers
+	bool		Contains ( DWORD uValue ) const;
+	int64_t		GetCount() const;
+	int64_t		GetSizeBytes() const;
+	bool		IsEmpty() const { return m_dContainers.IsEmpty(); }
+
+	/// fetch up to iMax values >= iFrom in ascending order; iFrom is moved past the last fetched value
+	int			Fetch ( int64_t & iFrom, DWORD * pOut, int iMax ) const;
+
+private:
+	static constexpr int ARRAY_MAX = 4096;		///< sorted array of WORDs is smaller than a bitmap up to that
+	static constexpr int BITMAP_WORDS = 1024;	///< 64k bits
+
+	struct Container_t
+	{
+		DWORD					m_uKey = 0;		///< high 16 bits
+		int						m_iCount = 0;
+		CSphVector<WORD>		m_dArray;		///< sorted low bits, while sparse
+		CSphVector<uint64_t>	m_dBits;		///< BITMAP_WORDS words, once dense
+
+		bool	IsBitmap() const { return !m_dBits.IsEmpty(); }
+		void	ToBitmap();
+		void	ToArray();
+		void	And ( const Container_t & tRhs );
+	};
+
+	CSphVector<Container_t *>	m_dContainers;	///< sorted by key
+	int							m_iLast = -1;	///< last touched container; adds are mostly ascending
+
+	int				FindContainer ( DWORD uKey ) const;
+	Container_t &	GetContainer ( DWORD uKey );
+};
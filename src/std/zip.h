@@ -39,6 +39,11 @@ DWORD UnzipIntBE ( const BYTE*& pBuf );
 // big-endian (most significant septets first)
 SphOffset_t UnzipOffsetBE ( const BYTE*& pBuf );
 
+// big-endian (most significant septets first)
+// bulk decode up to iMax values from [pBuf,pEnd) into pOut; stops right after a zero value (which is stored too)
+// only complete values are decoded, pBuf is moved past them; returns the number of decoded values
+int UnzipIntsBE ( const BYTE*& pBuf, const BYTE* pEnd, DWORD* pOut, int iMax );
+
 // little-endian (least significant septets first)
 template<typename T, typename WRITER>
 int ZipValueLE ( WRITER fnPut, T tValue );
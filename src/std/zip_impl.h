@@ -11,6 +11,14 @@
 //
 
 #include <type_traits>
+#include "log2.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+	#include <emmintrin.h>
+	#define ZIP_SSE2 1
+#else
+	#define ZIP_SSE2 0
+#endif
 
 // N of bytes need to store value
 template<typename T>
@@ -134,6 +142,79 @@ inline SphOffset_t UnzipOffsetBE ( const BYTE*& pBuf )
 	return UnzipValueBE<SphOffset_t> ( [&pBuf]() mutable { return *pBuf++; } );
 }
 
+#if ZIP_SSE2
+// widen 16 single-byte values to dwords
+inline void WidenBytes16 ( __m128i tBytes, DWORD* pOut )
+{
+	const __m128i tZero = _mm_setzero_si128();
+	__m128i tLo = _mm_unpacklo_epi8 ( tBytes, tZero );
+	__m128i tHi = _mm_unpackhi_epi8 ( tBytes, tZero );
+	_mm_storeu_si128 ( (__m128i*)pOut, _mm_unpacklo_epi16 ( tLo, tZero ) );
+	_mm_storeu_si128 ( (__m128i*)( pOut+4 ), _mm_unpackhi_epi16 ( tLo, tZero ) );
+	_mm_storeu_si128 ( (__m128i*)( pOut+8 ), _mm_unpacklo_epi16 ( tHi, tZero ) );
+	_mm_storeu_si128 ( (__m128i*)( pOut+12 ), _mm_unpackhi_epi16 ( tHi, tZero ) );
+}
+#endif
+
+inline int UnzipIntsBE ( const BYTE*& pBuf, const BYTE* pEnd, DWORD* pOut, int iMax )
+{
+	const BYTE* p = pBuf;
+	int iOut = 0;
+	while ( iOut<iMax )
+	{
+#if ZIP_SSE2
+		// runs of values below 128 (the common case for deltas of frequent terms) are widened 16 at a time
+		if ( pEnd-p>=16 )
+		{
+			__m128i tBytes = _mm_loadu_si128 ( (const __m128i*)p );
+			auto uLong = (DWORD)_mm_movemask_epi8 ( tBytes );
+			auto uZero = (DWORD)_mm_movemask_epi8 ( _mm_cmpeq_epi8 ( tBytes, _mm_setzero_si128() ) );
+
+			// index of the first multi-byte value, and of the first zero
+			int iRun = uLong ? sphLog2 ( uLong & ( ~uLong+1 ) )-1 : 16;
+			int iFirstZero = uZero ? sphLog2 ( uZero & ( ~uZero+1 ) )-1 : 16;
+			bool bStop = iFirstZero<iRun;
+			if ( bStop )
+				iRun = iFirstZero+1;
+
+			if ( iRun>iMax-iOut )
+				iRun = iMax-iOut;
+			if ( iRun )
+			{
+				if ( iMax-iOut>=16 )
+					WidenBytes16 ( tBytes, pOut+iOut );
+				else
+					for ( int i = 0; i<iRun; ++i )
+						pOut[iOut+i] = p[i];
+
+				p += iRun;
+				iOut += iRun;
+				if ( bStop && p[-1]==0 )
+					break;
+
+				continue;
+			}
+		}
+#endif
+		// scalar path; only decode a value that is completely inside the buffer
+		int iAvail = pEnd-p<5 ? int ( pEnd-p ) : 5;
+		int iLen = 0;
+		while ( iLen<iAvail && ( p[iLen] & 0x80 ) )
+			++iLen;
+
+		if ( iLen>=iAvail )
+			break;
+
+		DWORD uValue = UnzipIntBE(p);
+		pOut[iOut++] = uValue;
+		if ( !uValue )
+			break;
+	}
+
+	pBuf = p;
+	return iOut;
+}
+
 
 template<typename T, typename WRITER>
 inline int ZipValueLE ( WRITER fnPut, T tValue )
@@ -873,6 +873,400 @@ public:
 	}
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// thread pool where each worker has its own queue, and idle workers steal from busy ones.
+/// Continuation posted from a worker goes into its 'lifo slot' and runs next on the same thread, so that resumed
+/// coroutine finds its data still hot in that core's cache. Tasks posted from outside go to the shared injection queue.
+class StealingPool_c final : public Worker_i
+{
+	static constexpr int MAX_LIFO_RUNS = 3;				// consecutive runs from lifo slot before it yields to the queue
+	static constexpr int INJECTION_CHECK_INTERVAL = 61;	// busy worker looks into the injection queue at least that often
+
+	struct alignas ( 64 ) Thd_t
+	{
+		std::atomic<bool> m_bBusy { false };
+		SphThread_t m_tThread;
+		LowThreadDesc_t* m_pChild = nullptr;
+
+		CSphMutex m_dQueueLock;
+		OpSchedule_t m_dQueue GUARDED_BY ( m_dQueueLock );
+		std::atomic<int> m_iQueued { 0 };					// length of m_dQueue, to skip empty victims without locking
+		std::atomic<Operation_t*> m_pLifoSlot { nullptr };	// filled only by owner; taken by owner or by thief when owner is busy
+		DWORD m_uRand = 1;
+	};
+
+	using ThreadCallStack_c = CallStack_c<StealingPool_c, Thd_t>;
+
+	const char * m_szName = nullptr;
+	std::atomic<bool> m_bStop { false };
+	std::atomic<bool> m_bAbort { false };
+	std::atomic<long> m_iOutstandingWork { 1 };	// pool keeps itself alive until StopAll()
+	std::atomic<int> m_iQueued { 0 };			// ops waiting anywhere (injection, local queues, lifo slots)
+	std::atomic<int> m_iSleepers { 0 };
+
+	mutable CSphMutex m_dInjectionLock;
+	OpSchedule_t m_dInjectionVip GUARDED_BY ( m_dInjectionLock );
+	OpSchedule_t m_dInjection GUARDED_BY ( m_dInjectionLock );
+	int m_iInjectionVip GUARDED_BY ( m_dInjectionLock ) = 0;
+
+	CSphMutex m_dSleepLock;
+	sph::Event_c m_tWakeupEvent;
+
+	// support iteration over children for show threads and hazards
+	mutable RwLock_t m_dChildGuard;
+	CSphFixedVector<Thd_t> m_dThreads { 0 };
+
+	void work_started() noexcept
+	{
+		m_iOutstandingWork.fetch_add ( 1, std::memory_order_relaxed );
+	}
+
+	void work_finished() noexcept
+	{
+		if ( m_iOutstandingWork.fetch_sub ( 1, std::memory_order_acq_rel )==1 )
+			WakeAll();
+	}
+
+	void WakeOne() noexcept
+	{
+		// pairs with Park(): either we see the sleeper, or it sees our m_iQueued increment
+		if ( !m_iSleepers.load() )
+			return;
+
+		ScopedMutex_t dLock ( m_dSleepLock );
+		if ( !m_tWakeupEvent.MaybeUnlockAndSignalOne ( dLock ) )
+			dLock.Unlock();
+	}
+
+	void WakeAll() noexcept
+	{
+		ScopedMutex_t dLock ( m_dSleepLock );
+		m_tWakeupEvent.SignalAll ( dLock );
+	}
+
+	void PushLocal ( Thd_t & tThd, Operation_t * pOp, bool bVip ) NO_THREAD_SAFETY_ANALYSIS
+	{
+		ScopedMutex_t dLock ( tThd.m_dQueueLock );
+		if ( bVip )
+			tThd.m_dQueue.Push_front ( pOp );
+		else
+			tThd.m_dQueue.Push ( pOp );
+		tThd.m_iQueued.fetch_add ( 1, std::memory_order_relaxed );
+	}
+
+	Operation_t * PopLocal ( Thd_t & tThd ) NO_THREAD_SAFETY_ANALYSIS
+	{
+		if ( !tThd.m_iQueued.load ( std::memory_order_relaxed ) )
+			return nullptr;
+
+		ScopedMutex_t dLock ( tThd.m_dQueueLock );
+		auto * pOp = tThd.m_dQueue.Front();
+		if ( pOp )
+		{
+			tThd.m_dQueue.Pop();
+			tThd.m_iQueued.fetch_sub ( 1, std::memory_order_relaxed );
+		}
+		return pOp;
+	}
+
+	Operation_t * PopInjected() NO_THREAD_SAFETY_ANALYSIS
+	{
+		ScopedMutex_t dLock ( m_dInjectionLock );
+		if ( !m_dInjectionVip.Empty() )
+		{
+			auto * pOp = m_dInjectionVip.Front();
+			m_dInjectionVip.Pop();
+			--m_iInjectionVip;
+			return pOp;
+		}
+
+		auto * pOp = m_dInjection.Front();
+		if ( pOp )
+			m_dInjection.Pop();
+		return pOp;
+	}
+
+	// take half of the victim's queue (starting from the oldest); return one op and put the rest into own queue
+	Operation_t * StealFrom ( Thd_t & tVictim, Thd_t & tMe ) NO_THREAD_SAFETY_ANALYSIS
+	{
+		OpSchedule_t dStolen;
+		int iStolen = 0;
+		{
+			ScopedMutex_t dLock ( tVictim.m_dQueueLock );
+			int iToSteal = ( tVictim.m_iQueued.load ( std::memory_order_relaxed )+1 ) / 2;
+			for ( ; iStolen<iToSteal && !tVictim.m_dQueue.Empty(); ++iStolen )
+			{
+				dStolen.Push ( tVictim.m_dQueue.Front() );
+				tVictim.m_dQueue.Pop();
+			}
+			tVictim.m_iQueued.fetch_sub ( iStolen, std::memory_order_relaxed );
+		}
+
+		auto * pOp = dStolen.Front();
+		if ( !pOp )
+			return nullptr;
+
+		dStolen.Pop();
+		if ( iStolen>1 )
+		{
+			ScopedMutex_t dLock ( tMe.m_dQueueLock );
+			tMe.m_dQueue.Push ( dStolen );
+			tMe.m_iQueued.fetch_add ( iStolen-1, std::memory_order_relaxed );
+		}
+		return pOp;
+	}
+
+	Operation_t * Steal ( int iMe )
+	{
+		auto & tMe = m_dThreads[iMe];
+		int iThreads = m_dThreads.GetLength();
+
+		// xorshift; we only need a different starting victim for each attempt
+		tMe.m_uRand ^= tMe.m_uRand << 13;
+		tMe.m_uRand ^= tMe.m_uRand >> 17;
+		tMe.m_uRand ^= tMe.m_uRand << 5;
+		int iStart = int ( tMe.m_uRand % iThreads );
+
+		for ( int i = 0; i<iThreads; ++i )
+		{
+			int iVictim = ( iStart+i ) % iThreads;
+			if ( iVictim==iMe )
+				continue;
+
+			auto & tVictim = m_dThreads[iVictim];
+			if ( tVictim.m_iQueued.load ( std::memory_order_relaxed ) )
+				if ( auto * pOp = StealFrom ( tVictim, tMe ) )
+					return pOp;
+
+			// continuation of a busy worker would wait until it finishes the current task; better run it here
+			if ( tVictim.m_bBusy.load ( std::memory_order_relaxed ) && tVictim.m_pLifoSlot.load ( std::memory_order_relaxed ) )
+				if ( auto * pOp = tVictim.m_pLifoSlot.exchange ( nullptr, std::memory_order_acquire ) )
+					return pOp;
+		}
+		return nullptr;
+	}
+
+	Operation_t * NextOp ( int iMe, int & iTick, int & iLifoRuns )
+	{
+		auto & tMe = m_dThreads[iMe];
+		++iTick;
+
+		if ( tMe.m_pLifoSlot.load ( std::memory_order_relaxed ) )
+		{
+			auto * pOp = tMe.m_pLifoSlot.exchange ( nullptr, std::memory_order_acquire );
+			if ( pOp && iLifoRuns<MAX_LIFO_RUNS )
+			{
+				++iLifoRuns;
+				return pOp;
+			}
+
+			// ping-ponging continuations would starve the queue; put it behind the others
+			if ( pOp )
+				PushLocal ( tMe, pOp, false );
+		}
+		iLifoRuns = 0;
+
+		Operation_t * pOp = nullptr;
+		if ( iTick % INJECTION_CHECK_INTERVAL==0 )
+			pOp = PopInjected();
+
+		if ( !pOp )
+			pOp = PopLocal ( tMe );
+
+		if ( !pOp )
+			pOp = PopInjected();
+
+		if ( !pOp && m_dThreads.GetLength()>1 )
+			pOp = Steal ( iMe );
+
+		return pOp;
+	}
+
+	// returns false when it's time to finish
+	bool Park() NO_THREAD_SAFETY_ANALYSIS
+	{
+		ScopedMutex_t dLock ( m_dSleepLock );
+		if ( m_bAbort || ( m_bStop && !m_iOutstandingWork.load() ) )
+			return false;
+
+		m_iSleepers.fetch_add ( 1 );
+		if ( !m_iQueued.load() )
+		{
+			m_tWakeupEvent.Clear ( dLock );
+			m_tWakeupEvent.Wait ( dLock );
+		}
+		m_iSleepers.fetch_sub ( 1 );
+		return true;
+	}
+
+	void loop ( int iChild ) NO_THREAD_SAFETY_ANALYSIS
+	{
+		{
+			ScWL_t _ ( m_dChildGuard );
+			m_dThreads[iChild].m_pChild = &MyThd ();
+		}
+
+		auto & tMe = m_dThreads[iChild];
+		ThreadCallStack_c::Context_c dCtx ( this, tMe );
+		int iTick = 0;
+		int iLifoRuns = 0;
+		while ( !m_bAbort )
+		{
+			auto * pOp = NextOp ( iChild, iTick, iLifoRuns );
+			if ( !pOp )
+			{
+				if ( !Park() )
+					break;
+				continue;
+			}
+
+			m_iQueued.fetch_sub ( 1, std::memory_order_relaxed );
+			tMe.m_bBusy.store ( true, std::memory_order_relaxed );
+			boost::context::detail::prefetch_range ( pOp, sizeof ( Operation_t ) );
+			pOp->Complete ( this );
+			tMe.m_bBusy.store ( false, std::memory_order_relaxed );
+			work_finished();
+		}
+
+		ScWL_t _ ( m_dChildGuard );
+		m_dThreads[iChild].m_pChild = nullptr;
+	}
+
+	void Post ( Operation_t * pOp, bool bVip ) NO_THREAD_SAFETY_ANALYSIS
+	{
+		work_started();
+		auto * pThisThread = ThreadCallStack_c::Contains ( this );
+		if ( pThisThread )
+			PushLocal ( *pThisThread, pOp, bVip );
+		else
+		{
+			ScopedMutex_t dLock ( m_dInjectionLock );
+			if ( bVip )
+			{
+				m_dInjectionVip.Push ( pOp );
+				++m_iInjectionVip;
+			} else
+				m_dInjection.Push ( pOp );
+		}
+
+		m_iQueued.fetch_add ( 1 );
+		WakeOne();
+	}
+
+	void PostContinuation ( Operation_t * pOp )
+	{
+		auto * pThisThread = ThreadCallStack_c::Contains ( this );
+		if ( !pThisThread )
+		{
+			Post ( pOp, true );
+			return;
+		}
+
+		// the owner will pick it up right after the current task; wake somebody only if previous one was displaced
+		work_started();
+		auto * pPrev = pThisThread->m_pLifoSlot.exchange ( pOp, std::memory_order_acq_rel );
+		if ( pPrev )
+			PushLocal ( *pThisThread, pPrev, true );
+
+		m_iQueued.fetch_add ( 1 );
+		if ( pPrev )
+			WakeOne();
+	}
+
+public:
+	StealingPool_c ( size_t iThreadCount, const char * szName )
+		: m_szName { szName }
+	{
+		m_dThreads.Reset ( (int) iThreadCount );
+		ARRAY_FOREACH ( i, m_dThreads )
+			m_dThreads[i].m_uRand = (DWORD)i*2654435761U + 1;
+
+		ARRAY_FOREACH ( i, m_dThreads )
+			Threads::CreateQ ( &m_dThreads[i].m_tThread, [this,i] { loop (i); }, false, m_szName, i );
+		LOG ( DEBUG, TP ) << "work-stealing thread pool created with threads: " << iThreadCount;
+		LOGINFO ( TPLIFE, TP ) << "work-stealing thread pool created with threads: " << iThreadCount;
+	}
+
+	~StealingPool_c () final
+	{
+		LOGINFO ( TPLIFE, TP ) << "work-stealing thread pool destroying";
+		StopAll();
+		ScWL_t _ ( m_dChildGuard ); // that will keep children list if smbody still iterates over it
+	}
+
+	void DiscardOnFork () final
+	{
+		ScWL_t _ ( m_dChildGuard );
+		m_dThreads.Reset ( 0 );
+	}
+
+	void ScheduleOp ( Threads::details::SchedulerOperation_t* pOp, bool bVip ) noexcept final
+	{
+		Post ( pOp, bVip );
+	}
+
+	void ScheduleContinuationOp ( Threads::details::SchedulerOperation_t* pOp ) noexcept final
+	{
+		PostContinuation ( pOp );
+	}
+
+	Keeper_t KeepWorking() noexcept final
+	{
+		work_started();
+		return { nullptr, [this] ( void* ) { work_finished(); } };
+	}
+
+	int WorkingThreads () const noexcept final NO_THREAD_SAFETY_ANALYSIS
+	{
+		return m_dThreads.GetLength ();
+	}
+
+	int Works () const noexcept final
+	{
+		return (int)m_iOutstandingWork.load ( std::memory_order_relaxed );
+	}
+
+	NTasks_t Tasks() const noexcept final NO_THREAD_SAFETY_ANALYSIS
+	{
+		int iVip;
+		{
+			ScopedMutex_t dLock ( m_dInjectionLock );
+			iVip = m_iInjectionVip;
+		}
+		return { iVip, Max ( 0, m_iQueued.load ( std::memory_order_relaxed )-iVip ) };
+	}
+
+	int CurTasks() const noexcept final NO_THREAD_SAFETY_ANALYSIS
+	{
+		return (int)m_dThreads.count_of ( [] ( auto& i ) { return i.m_bBusy.load ( std::memory_order_relaxed ); } );
+	}
+
+	void IterateChildren ( ThreadFN& fnHandler ) noexcept final
+	{
+		ScRL_t _ ( m_dChildGuard );
+		for ( const auto& tThd : m_dThreads )
+			fnHandler ( tThd.m_pChild );
+	}
+
+	void StopAll () final NO_THREAD_SAFETY_ANALYSIS
+	{
+		if ( m_bStop.exchange ( true ) )
+			return;
+
+		if ( sphIsDied() )
+			m_bAbort = true;
+
+		work_finished(); // release the pool's own work; threads finish when all the posted tasks are done
+		WakeAll();
+		LOG ( DEBUG, TP ) << "stopping work-stealing thread pool";
+		for ( auto & dThread : m_dThreads )
+			Threads::Join ( &dThread.m_tThread );
+		LOG ( DEBUG, TP ) << "work-stealing thread pool stopped";
+		LOGINFO ( TPLIFE, TP ) << "work-stealing thread pool stopped";
+		m_dThreads.Reset ( 0 );
+	}
+};
+
 class AloneThread_c final : public Worker_i
 {
 	CSphString m_sName;
@@ -1026,6 +1420,11 @@ WorkerSharedPtr_t MakeThreadPool ( size_t iThreadCount, const char* szName )
 	return WorkerSharedPtr_t { new ThreadPool_c ( iThreadCount, szName ) };
 }
 
+WorkerSharedPtr_t MakeStealingThreadPool ( size_t iThreadCount, const char* szName )
+{
+	return WorkerSharedPtr_t { new StealingPool_c ( iThreadCount, szName ) };
+}
+
 WorkerSharedPtr_t MakeAloneThread ( size_t iOrderNum, const char* szName )
 {
 	return WorkerSharedPtr_t { new AloneThread_c ( (int)iOrderNum, szName ) };
@@ -1112,6 +1511,7 @@ void searchd::CleanAfterFork () NO_THREAD_SAFETY_ANALYSIS
 }
 
 static int g_iMaxChildrenThreads = 1;
+static bool g_bWorkStealing = false;
 
 
 namespace {
@@ -1130,7 +1530,12 @@ void StartGlobalWorkPool ()
 #if !_WIN32
 	if ( !pPool )
 #endif
-		pPool = new ThreadPool_c ( g_iMaxChildrenThreads, "work" );
+	{
+		if ( g_bWorkStealing )
+			pPool = new StealingPool_c ( g_iMaxChildrenThreads, "work" );
+		else
+			pPool = new ThreadPool_c ( g_iMaxChildrenThreads, "work" );
+	}
 }
 
 void StopGlobalWorkPool()
@@ -1152,6 +1557,12 @@ int MaxChildrenThreads() noexcept
 	return g_iMaxChildrenThreads;
 }
 
+void SetWorkStealing ( bool bStealing )
+{
+	sphLogDebug ( "SetWorkStealing to %d", (int)bStealing );
+	g_bWorkStealing = bStealing;
+}
+
 Worker_i * GlobalWorkPool ()
 {
 	WorkerSharedPtr_t& pPool = GlobalPoolSingletone ();
@@ -184,6 +184,9 @@ using WorkerSharedPtr_t = SharedPtr_t<Worker_i>;
 WorkerSharedPtr_t MakeThreadPool ( size_t iThreadCount, const char* szName = "" );
 WorkerSharedPtr_t MakeAloneThread ( size_t iOrderNum, const char* szName = "" );
 
+// pool with per-worker queues, work stealing and lifo slot for continuations
+WorkerSharedPtr_t MakeStealingThreadPool ( size_t iThreadCount, const char* szName = "" );
+
 // Alone scheduler works on top of another scheduler and provides sequental execution of the tasks (each time only one
 // task may be performed, no concurrent execution). It also gives FIFO ordering of the tasks.
 SchedulerSharedPtr_t MakeAloneScheduler ( Scheduler_i* pBase, const char* szName = nullptr );
@@ -256,6 +259,7 @@ extern ThreadRole MainThread;
 Threads::Worker_i* GlobalWorkPool ();
 void SetMaxChildrenThreads ( int iThreads );
 int MaxChildrenThreads() noexcept;
+void SetWorkStealing ( bool bStealing ); // must be called before StartGlobalWorkPool()
 void StartGlobalWorkPool ();
 void StopGlobalWorkPool();
 
@@ -14,6 +14,7 @@
 
 #include "std/stringbuilder.h"
 #include "std/format.h"
+#include "std/log2.h"
 
 inline static bool operator<( const EnqueuedTimeout_t& dLeft, const EnqueuedTimeout_t& dRight )
 {
@@ -139,4 +140,231 @@ void TimeoutQueue_c::DebugDump ( const std::function<void ( EnqueuedTimeout_t* )
 {
 	for ( auto* cTask : m_dQueue )
 		fcb ( cTask );
-}
\ No newline at end of file
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+static inline int64_t TickOf ( int64_t iTimeUS )
+{
+	return iTimeUS >> TimeoutWheel_c::TICK_SHIFT;
+}
+
+TimeoutWheel_c::TimeoutWheel_c()
+{
+	for ( int & iHead : m_dHeads )
+		iHead = -1;
+
+	memset ( m_dOccupied, 0, sizeof ( m_dOccupied ) );
+}
+
+// put the node to the lowest level where its tick shares all the higher digits with the current tick
+// so on any level but 0 the tick's own digit is always ahead of the current one
+void TimeoutWheel_c::Link ( int iNode, int64_t iTick )
+{
+	iTick = Max ( iTick, m_iCurTick );
+	auto uDiff = uint64_t ( iTick ^ m_iCurTick );
+
+	int iSlot = OVERFLOW_SLOT;
+	if ( !( uDiff >> ( LEVELS*SLOT_BITS ) ) )
+	{
+		int iLevel = uDiff ? ( sphLog2 ( uDiff )-1 ) / SLOT_BITS : 0;
+		int iIdx = int ( iTick >> ( iLevel*SLOT_BITS ) ) & ( SLOTS-1 );
+		m_dOccupied[iLevel][iIdx>>6] |= 1ULL << ( iIdx & 63 );
+		iSlot = iLevel*SLOTS + iIdx;
+	}
+
+	Node_t & tNode = m_dNodes[iNode];
+	tNode.m_iSlot = iSlot;
+	tNode.m_iPrev = -1;
+	tNode.m_iNext = m_dHeads[iSlot];
+	if ( tNode.m_iNext>=0 )
+		m_dNodes[tNode.m_iNext].m_iPrev = iNode;
+
+	m_dHeads[iSlot] = iNode;
+}
+
+void TimeoutWheel_c::Unlink ( int iNode )
+{
+	Node_t & tNode = m_dNodes[iNode];
+	if ( tNode.m_iPrev>=0 )
+		m_dNodes[tNode.m_iPrev].m_iNext = tNode.m_iNext;
+	else
+		m_dHeads[tNode.m_iSlot] = tNode.m_iNext;
+
+	if ( tNode.m_iNext>=0 )
+		m_dNodes[tNode.m_iNext].m_iPrev = tNode.m_iPrev;
+
+	if ( m_dHeads[tNode.m_iSlot]<0 && tNode.m_iSlot!=OVERFLOW_SLOT )
+	{
+		int iIdx = tNode.m_iSlot % SLOTS;
+		m_dOccupied[tNode.m_iSlot / SLOTS][iIdx>>6] &= ~( 1ULL << ( iIdx & 63 ) );
+	}
+
+	tNode.m_iSlot = -1;
+}
+
+// first occupied slot of the level at or after iFrom; -1 if none
+int TimeoutWheel_c::FindNextSlot ( int iLevel, int iFrom ) const
+{
+	for ( int iWord = iFrom>>6; iWord < SLOTS/64; ++iWord )
+	{
+		uint64_t uWord = m_dOccupied[iLevel][iWord];
+		if ( iWord==( iFrom>>6 ) )
+			uWord &= ~0ULL << ( iFrom & 63 );
+
+		if ( uWord )
+			return ( iWord<<6 ) + sphLog2 ( uWord & ( ~uWord+1 ) ) - 1;
+	}
+
+	return -1;
+}
+
+// re-link all the nodes of the slot against the (moved) current tick
+void TimeoutWheel_c::Cascade ( int iSlot )
+{
+	int iNode = m_dHeads[iSlot];
+	m_dHeads[iSlot] = -1;
+	if ( iSlot!=OVERFLOW_SLOT )
+	{
+		int iIdx = iSlot % SLOTS;
+		m_dOccupied[iSlot / SLOTS][iIdx>>6] &= ~( 1ULL << ( iIdx & 63 ) );
+	}
+
+	while ( iNode>=0 )
+	{
+		int iNext = m_dNodes[iNode].m_iNext;
+		Link ( iNode, TickOf ( m_dNodes[iNode].m_pTask->m_iTimeoutTimeUS ) );
+		iNode = iNext;
+	}
+}
+
+// turn the wheel to the first occupied slot of level 0
+bool TimeoutWheel_c::Advance()
+{
+	while ( true )
+	{
+		int iIdx = FindNextSlot ( 0, int ( m_iCurTick & ( SLOTS-1 ) ) );
+		if ( iIdx>=0 )
+		{
+			m_iCurTick = ( m_iCurTick & ~int64_t ( SLOTS-1 ) ) | iIdx;
+			return true;
+		}
+
+		// lower levels are empty; jump to the start of the next occupied slot of the lowest possible level
+		bool bCascaded = false;
+		for ( int iLevel = 1; iLevel < LEVELS && !bCascaded; ++iLevel )
+		{
+			int iShift = iLevel*SLOT_BITS;
+			iIdx = FindNextSlot ( iLevel, ( int ( m_iCurTick >> iShift ) & ( SLOTS-1 ) ) + 1 );
+			if ( iIdx<0 )
+				continue;
+
+			m_iCurTick = ( ( m_iCurTick >> ( iShift+SLOT_BITS ) ) << ( iShift+SLOT_BITS ) ) | ( int64_t ( iIdx ) << iShift );
+			Cascade ( iLevel*SLOTS + iIdx );
+			bCascaded = true;
+		}
+
+		if ( bCascaded )
+			continue;
+
+		if ( m_dHeads[OVERFLOW_SLOT]<0 )
+			return false;
+
+		// all the rest is beyond the wheel span; restart it from the earliest one
+		int64_t iMinTick = INT64_MAX;
+		for ( int iNode = m_dHeads[OVERFLOW_SLOT]; iNode>=0; iNode = m_dNodes[iNode].m_iNext )
+			iMinTick = Min ( iMinTick, TickOf ( m_dNodes[iNode].m_pTask->m_iTimeoutTimeUS ) );
+
+		m_iCurTick = iMinTick;
+		Cascade ( OVERFLOW_SLOT );
+	}
+}
+
+void TimeoutWheel_c::Pop()
+{
+	Remove ( Root() );
+}
+
+void TimeoutWheel_c::Change ( EnqueuedTimeout_t * pTask )
+{
+	if ( !pTask )
+		return;
+
+	int iNode = pTask->m_iTimeoutIdx;
+	if ( iNode<0 )
+	{
+		if ( m_iFreeNode>=0 )
+		{
+			iNode = m_iFreeNode;
+			m_iFreeNode = m_dNodes[iNode].m_iNext;
+		} else
+		{
+			iNode = m_dNodes.GetLength();
+			m_dNodes.Add();
+		}
+
+		m_dNodes[iNode].m_pTask = pTask;
+		pTask->m_iTimeoutIdx = iNode;
+		++m_iCount;
+	} else
+		Unlink ( iNode );
+
+	Link ( iNode, TickOf ( pTask->m_iTimeoutTimeUS ) );
+	m_iRoot = -1;
+}
+
+void TimeoutWheel_c::Remove ( EnqueuedTimeout_t * pTask )
+{
+	if ( !pTask )
+		return;
+
+	int iNode = pTask->m_iTimeoutIdx;
+	if ( iNode<0 || iNode>=m_dNodes.GetLength() || m_dNodes[iNode].m_pTask!=pTask )
+		return;
+
+	Unlink ( iNode );
+	m_dNodes[iNode].m_pTask = nullptr;
+	m_dNodes[iNode].m_iNext = m_iFreeNode;
+	m_iFreeNode = iNode;
+
+	pTask->m_iTimeoutIdx = -1;
+	--m_iCount;
+	m_iRoot = -1;
+}
+
+EnqueuedTimeout_t * TimeoutWheel_c::Root()
+{
+	if ( m_iRoot>=0 )
+		return m_dNodes[m_iRoot].m_pTask;
+
+	if ( !m_iCount || !Advance() )
+		return nullptr;
+
+	// the slot may also hold entries linked with ticks behind the wheel; pick the exact minimum
+	m_iRoot = m_dHeads[m_iCurTick & ( SLOTS-1 )];
+	for ( int iNode = m_dNodes[m_iRoot].m_iNext; iNode>=0; iNode = m_dNodes[iNode].m_iNext )
+		if ( *m_dNodes[iNode].m_pTask < *m_dNodes[m_iRoot].m_pTask )
+			m_iRoot = iNode;
+
+	return m_dNodes[m_iRoot].m_pTask;
+}
+
+CSphString TimeoutWheel_c::DebugDump ( const char * sPrefix ) const
+{
+	StringBuilder_c tBuild;
+	DebugDump ( [&tBuild] ( EnqueuedTimeout_t * pTask ) { tBuild.Sprintf ( tBuild.IsEmpty() ? "%p (%l)" : ", %p(%l)", pTask, pTask->m_iTimeoutTimeUS ); } );
+
+	CSphString sRes;
+	if ( m_iCount )
+		sRes.SetSprintf ( "%s%d:%s", sPrefix, m_iCount, tBuild.cstr() );
+	else
+		sRes.SetSprintf ( "%sWheel empty.", sPrefix );
+	return sRes;
+}
+
+void TimeoutWheel_c::DebugDump ( const std::function<void ( EnqueuedTimeout_t * )> & fcb ) const
+{
+	for ( int iHead : m_dHeads )
+		for ( int iNode = iHead; iNode>=0; iNode = m_dNodes[iNode].m_iNext )
+			fcb ( m_dNodes[iNode].m_pTask );
+}
@@ -56,3 +56,69 @@ public:
 	CSphString DebugDump ( const char* sPrefix ) const;
 	void DebugDump ( const std::function<void ( EnqueuedTimeout_t* )>& fcb ) const;
 };
+
+/// hierarchical timing wheel with the same interface as TimeoutQueue_c
+/// timeouts are hashed into 4 levels of 256 slots by their tick (TICK_US), so add/change/remove are O(1),
+/// where the bin heap pays O(log n). Finding the root skips empty slots by occupancy bitmaps and cascades
+/// higher levels down as the wheel turns; the root is still the exact minimum.
+/// Good for many long-living timeouts which are rescheduled on every I/O (as in netloop)
+class TimeoutWheel_c final
+{
+public:
+	static constexpr int TICK_SHIFT = 10;	///< ~1ms ticks
+	static constexpr int SLOT_BITS = 8;
+	static constexpr int SLOTS = 1 << SLOT_BITS;
+	static constexpr int LEVELS = 4;		///< 2^32 ticks, ~50 days; further timeouts wait in the overflow list
+	static constexpr int OVERFLOW_SLOT = LEVELS*SLOTS;
+
+				TimeoutWheel_c();
+
+	/// remove root (ie. top priority) entry
+	void		Pop();
+
+	/// add new, or change already added entry
+	void		Change ( EnqueuedTimeout_t * pTask );
+
+	/// erase elem (uses stored m_iTimeoutIdx)
+	void		Remove ( EnqueuedTimeout_t * pTask );
+
+	inline bool IsEmpty() const
+	{
+		return !m_iCount;
+	}
+
+	inline int	GetLength() const
+	{
+		return m_iCount;
+	}
+
+	/// get minimal (root) elem; turns the wheel up to it
+	EnqueuedTimeout_t * Root();
+
+	CSphString	DebugDump ( const char * sPrefix ) const;
+	void		DebugDump ( const std::function<void ( EnqueuedTimeout_t * )> & fcb ) const;
+
+private:
+	struct Node_t
+	{
+		EnqueuedTimeout_t *	m_pTask = nullptr;
+		int					m_iPrev = -1;
+		int					m_iNext = -1;	///< also links free nodes
+		int					m_iSlot = -1;
+	};
+
+	CSphTightVector<Node_t>	m_dNodes;		///< m_iTimeoutIdx of enqueued task points here
+	int						m_iFreeNode = -1;
+	int						m_dHeads[OVERFLOW_SLOT+1];
+	uint64_t				m_dOccupied[LEVELS][SLOTS/64];
+	int64_t					m_iCurTick = 0;
+	int						m_iCount = 0;
+	int						m_iRoot = -1;	///< cached root node, reset on any change
+
+	void	Link ( int iNode, int64_t iTick );
+	void	Unlink ( int iNode );
+	int		FindNextSlot ( int iLevel, int iFrom ) const;
+	void	Cascade ( int iSlot );
+	bool	Advance();
+};
+
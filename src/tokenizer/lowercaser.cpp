@@ -24,6 +24,7 @@ void CSphLowercaser::Reset()
 	m_pChunk[0] = m_dData.begin(); // chunk 0 must always be allocated, for utf-8 tokenizer shortcut to work
 	for ( int i = 1; i < CHUNK_COUNT; ++i )
 		m_pChunk[i] = nullptr;
+	UpdateAsciiFold();
 	InvalidateStoredClones();
 }
 
@@ -38,6 +39,7 @@ void CSphLowercaser::SetRemap ( const CSphLowercaser* pLC )
 
 	for ( int i = 0; i < CHUNK_COUNT; ++i )
 		m_pChunk[i] = pLC->m_pChunk[i] ? pLC->m_pChunk[i] - pLC->m_dData.begin() + m_dData.begin() : nullptr;
+	UpdateAsciiFold();
 	InvalidateStoredClones();
 }
 
@@ -154,7 +156,10 @@ void CSphLowercaser::AddRemaps ( const VecTraits_T<CSphRemapRange>& dRemaps, DWO
 		}
 	}
 	if ( bChanged )
+	{
+		UpdateAsciiFold();
 		InvalidateStoredClones();
+	}
 }
 
 
@@ -181,6 +186,20 @@ uint64_t CSphLowercaser::GetFNV() const noexcept
 	return sphFNV64 ( m_dData );
 }
 
+// ascii codes which fold into plain ascii letters with no flags, so that tokenizer may take runs of them in bulk.
+// sentence punctuation and the escape char are left out, as tokenizer arbitrates them by value
+void CSphLowercaser::UpdateAsciiFold() noexcept
+{
+	m_dAsciiFold[0] = 0;
+	for ( int i = 1; i < 128; ++i )
+	{
+		auto uCode = (DWORD)ToLower ( i );
+		bool bPlain = uCode && uCode < 128 && i != '\\'; // flagged codes are never below 128
+		bPlain &= uCode != '.' && uCode != '?' && uCode != '!';
+		m_dAsciiFold[i] = bPlain ? (BYTE)uCode : 0;
+	}
+}
+
 void CSphLowercaser::InvalidateStoredClones() noexcept
 {
 	++m_iGeneration;
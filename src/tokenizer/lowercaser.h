@@ -33,6 +33,7 @@ class CSphLowercaser final: public ISphRefcountedMT
 	CSphFixedVector<DWORD> m_dData {0};			///< chunks themselves. 1Kb per chunk (256 DWORDs)
 	DWORD* m_pChunk[CHUNK_COUNT] { nullptr };	///< pointers to non-empty chunks. That is 6kB per table
 	volatile int m_iGeneration = 0;				///< my generation. Each change increases generation
+	BYTE m_dAsciiFold[128] { 0 };				///< folded ascii letters without flags, 0 for anything else; see UpdateAsciiFold()
 	mutable CSphMutex	m_tLock;				///< protects moment of cache creation from concurrency
 
 	// with 32-bits pointers:
@@ -46,6 +47,7 @@ class CSphLowercaser final: public ISphRefcountedMT
 	// seems that for 64-bits using 9 bits per chunk is better with typical configurations; need to test!
 
 	void InvalidateStoredClones() noexcept;
+	void UpdateAsciiFold() noexcept;
 
 protected:
 	~CSphLowercaser() final = default;
@@ -66,6 +68,7 @@ public:
 
 	// runtime use (const, noexcept, thread-safe)
 	int ToLower ( int iCode ) const noexcept;
+	const BYTE* GetAsciiFold() const noexcept { return m_dAsciiFold; }
 	int GetMaxCodepointLength() const noexcept;
 	uint64_t GetFNV() const noexcept;
 
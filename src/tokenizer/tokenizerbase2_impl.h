@@ -19,6 +19,14 @@
 
 #include "lowercaser_impl.h"
 #include "exceptions_trie.h"
+#include "std/log2.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+	#include <emmintrin.h>
+	#define TOKENIZER_SSE2 1
+#else
+	#define TOKENIZER_SSE2 0
+#endif
 
 
 inline bool IsWhitespace ( int c )
@@ -86,6 +94,52 @@ protected:
 		}
 	}
 
+	/// accum the run of plain ascii letters starting at m_pCur, see CSphLowercaser::UpdateAsciiFold()
+	/// such letters can't change any tokenizer state except the accumulator, so they are folded in bulk
+	/// returns number of consumed bytes
+	inline int AccumAsciiRun()
+	{
+		const BYTE* pFold = GetLowercaser().GetAsciiFold();
+		const BYTE* pStart = m_pCur;
+		int iRoom = Min ( SPH_MAX_WORD_LEN - m_iAccum, int ( m_sAccum + sizeof ( m_sAccum ) - SPH_MAX_UTF8_BYTES - m_pAccum ) + 1 );
+
+#if TOKENIZER_SSE2
+		BYTE dFolded[16];
+		while ( m_pBufferMax - m_pCur >= 16 )
+		{
+			__m128i tBytes = _mm_loadu_si128 ( (const __m128i*)m_pCur );
+			if ( _mm_movemask_epi8 ( tBytes ) ) // got non-ascii, leave it to the generic path
+				break;
+
+			for ( int i = 0; i < 16; ++i )
+				dFolded[i] = pFold[m_pCur[i]];
+
+			auto uStops = (DWORD)_mm_movemask_epi8 ( _mm_cmpeq_epi8 ( _mm_loadu_si128 ( (const __m128i*)dFolded ), _mm_setzero_si128() ) );
+			int iRun = uStops ? sphLog2 ( uStops & ( ~uStops+1 ) )-1 : 16;
+			int iTake = Max ( Min ( iRun, iRoom ), 0 );
+			memcpy ( m_pAccum, dFolded, iTake );
+			m_pAccum += iTake;
+			m_iAccum += iTake;
+			iRoom -= iTake;
+			m_pCur += iRun;
+			if ( iRun < 16 )
+				return int ( m_pCur - pStart );
+		}
+#endif
+
+		while ( m_pCur < m_pBufferMax && *m_pCur < 128 && pFold[*m_pCur] )
+		{
+			if ( iRoom > 0 )
+			{
+				*m_pAccum++ = pFold[*m_pCur];
+				++m_iAccum;
+				--iRoom;
+			}
+			++m_pCur;
+		}
+		return int ( m_pCur - pStart );
+	}
+
 protected:
 	BYTE* GetBlendedVariant();
 	bool CheckException ( const BYTE* pStart, const BYTE* pCur, bool bQueryMode );
@@ -307,6 +361,11 @@ protected:
 				m_iAccum++;
 				SPH_UTF8_ENCODE ( m_pAccum, iCode );
 			}
+
+			// plain ascii letters that follow only extend the accumulator; take them in one go
+			if ( m_pCur < m_pBufferMax && *m_pCur < 128 && AccumAsciiRun() )
+				if constexpr ( IS_BLEND )
+					m_bNonBlended = true;
 		}
 	}
 